@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Example native library using the v2 C ABI. Build it and copy libstats.so into
+ * .o2l/lib/native next to a program, then:
+ *
+ *     import native.stats
+ *     io.print("%s", stats.hypot(3.0, 4.0))
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "NativeAbi.h"
+
+#if defined(_WIN32)
+#define STATS_EXPORT __declspec(dllexport)
+#else
+#define STATS_EXPORT __attribute__((visibility("default")))
+#endif
+
+static o2l_native_status fail(o2l_native_value* result, const char* message) {
+    result->type = O2L_NATIVE_TEXT;
+    result->as_text.data = message;
+    result->as_text.size = strlen(message);
+    return O2L_NATIVE_ERROR;
+}
+
+static double number(const o2l_native_value* value) {
+    return value->type == O2L_NATIVE_INT ? (double)value->as_int : value->as_double;
+}
+
+static int is_number(const o2l_native_value* value) {
+    return value->type == O2L_NATIVE_INT || value->type == O2L_NATIVE_DOUBLE;
+}
+
+static o2l_native_status stats_hypot(const o2l_native_value* args, size_t count,
+                                     o2l_native_value* result) {
+    (void)count;
+    if (!is_number(&args[0]) || !is_number(&args[1])) {
+        return fail(result, "hypot() takes numbers");
+    }
+    result->type = O2L_NATIVE_DOUBLE;
+    result->as_double = hypot(number(&args[0]), number(&args[1]));
+    return O2L_NATIVE_OK;
+}
+
+static o2l_native_status stats_mean(const o2l_native_value* args, size_t count,
+                                    o2l_native_value* result) {
+    double total = 0;
+    size_t i;
+    if (count == 0) {
+        return fail(result, "mean() needs at least one value");
+    }
+    for (i = 0; i < count; ++i) {
+        if (!is_number(&args[i])) {
+            return fail(result, "mean() takes numbers");
+        }
+        total += number(&args[i]);
+    }
+    result->type = O2L_NATIVE_DOUBLE;
+    result->as_double = total / (double)count;
+    return O2L_NATIVE_OK;
+}
+
+static const o2l_native_method methods[] = {
+    {"hypot", 2, stats_hypot, O2L_NATIVE_PURE},
+    {"mean", -1, stats_mean, O2L_NATIVE_PURE},
+};
+
+static const o2l_native_library library = {
+    O2L_NATIVE_ABI_VERSION, "stats", "1.0.0", methods, sizeof(methods) / sizeof(methods[0])};
+
+STATS_EXPORT const o2l_native_library* o2l_native_library_v2(void) {
+    return &library;
+}
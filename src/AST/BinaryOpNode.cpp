@@ -29,12 +29,69 @@ BinaryOpNode::BinaryOpNode(ASTNodePtr left, BinaryOperator op, ASTNodePtr right,
     : ASTNode(location), left_(std::move(left)), operator_(op), right_(std::move(right)) {}
 
 Value BinaryOpNode::evaluate(Context& context) {
+    if (static_type_ == StaticType::Int || static_type_ == StaticType::Double) {
+        return evaluateChecked(context);
+    }
+
     // Add stack frame for this binary operation
     STACK_FRAME_GUARD(context, "binary_operation", "expression", *this);
 
+    // Operands are only read, so variables are borrowed rather than copied
+    Value left_storage;
+    Value right_storage;
+    const Value& left_val = left_->evaluateBorrowed(context, left_storage);
+    const Value& right_val = right_->evaluateBorrowed(context, right_storage);
+    return applyOperator(left_val, right_val, context);
+}
+
+Value BinaryOpNode::evaluateChecked(Context& context) {
     Value left_val = left_->evaluate(context);
     Value right_val = right_->evaluate(context);
 
+    // Operands the type checker found to be Int or Double are computed without a stack frame
+    // or the dispatch below; anything else, including division by zero, takes the full path
+    if (auto left_int = std::get_if<Int>(&left_val)) {
+        if (auto right_int = std::get_if<Int>(&right_val)) {
+            switch (operator_) {
+                case BinaryOperator::PLUS:
+                    return Int(*left_int + *right_int);
+                case BinaryOperator::MINUS:
+                    return Int(*left_int - *right_int);
+                case BinaryOperator::MULTIPLY:
+                    return Int(*left_int * *right_int);
+                case BinaryOperator::DIVIDE:
+                    if (*right_int != 0) return Int(*left_int / *right_int);
+                    break;
+                case BinaryOperator::MODULO:
+                    if (*right_int != 0) return Int(*left_int % *right_int);
+                    break;
+            }
+        }
+    } else if (auto left_double = std::get_if<Double>(&left_val)) {
+        if (auto right_double = std::get_if<Double>(&right_val)) {
+            switch (operator_) {
+                case BinaryOperator::PLUS:
+                    return Double(*left_double + *right_double);
+                case BinaryOperator::MINUS:
+                    return Double(*left_double - *right_double);
+                case BinaryOperator::MULTIPLY:
+                    return Double(*left_double * *right_double);
+                case BinaryOperator::DIVIDE:
+                    if (*right_double != 0.0) return Double(*left_double / *right_double);
+                    break;
+                case BinaryOperator::MODULO:
+                    if (*right_double != 0.0) return Double(std::fmod(*left_double, *right_double));
+                    break;
+            }
+        }
+    }
+
+    STACK_FRAME_GUARD(context, "binary_operation", "expression", *this);
+    return applyOperator(left_val, right_val, context);
+}
+
+Value BinaryOpNode::applyOperator(const Value& left_val, const Value& right_val,
+                                  Context& context) const {
     // Handle integer operations
     if (std::holds_alternative<Int>(left_val) && std::holds_alternative<Int>(right_val)) {
         Int left_int = std::get<Int>(left_val);
@@ -263,8 +320,9 @@ Value BinaryOpNode::evaluate(Context& context) {
     // Handle string concatenation
     if (std::holds_alternative<Text>(left_val) && std::holds_alternative<Text>(right_val) &&
         operator_ == BinaryOperator::PLUS) {
-        Text left_text = std::get<Text>(left_val);
-        Text right_text = std::get<Text>(right_val);
+        const Text& left_text = std::get<Text>(left_val);
+        const Text& right_text = std::get<Text>(right_val);
+        ExecutionBudget::chargeAllocation(left_text.size() + right_text.size());
         return Text(left_text + right_text);
     }
 
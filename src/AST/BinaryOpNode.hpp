@@ -46,6 +46,11 @@ class BinaryOpNode : public ASTNode {
     BinaryOperator getOperator() const {
         return operator_;
     }
+
+   private:
+    // Evaluation when the type checker recorded an Int or Double result
+    Value evaluateChecked(Context& context);
+    Value applyOperator(const Value& left_val, const Value& right_val, Context& context) const;
 };
 
 }  // namespace o2l
\ No newline at end of file
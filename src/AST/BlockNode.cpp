@@ -18,6 +18,8 @@
 
 #include "../Common/Exceptions.hpp"
 #include "../Runtime/Context.hpp"
+#include "../Runtime/Coverage.hpp"
+#include "../Runtime/HeapProfiler.hpp"
 
 namespace o2l {
 
@@ -25,9 +27,12 @@ BlockNode::BlockNode(std::vector<ASTNodePtr> statements) : statements_(std::move
 
 Value BlockNode::evaluate(Context& context) {
     Value result = Int(0);  // Default return value
+    HeapProfiler::BlockScope heap_site(context);
 
     // Execute all statements in sequence
     for (const auto& statement : statements_) {
+        Coverage::count(*statement);
+        heap_site.enter(*statement);
         try {
             result = statement->evaluate(context);
         } catch (const ReturnException& e) {
@@ -27,11 +27,34 @@ ComparisonNode::ComparisonNode(ASTNodePtr left, ComparisonOperator op, ASTNodePt
     : ASTNode(location), left_(std::move(left)), operator_(op), right_(std::move(right)) {}
 
 Value ComparisonNode::evaluate(Context& context) {
+    // Int and Double operands known to the type checker are compared without a stack frame
+    // or the type dispatch of compareValues(), once the values are confirmed
+    StaticType operand_type = left_->getStaticType();
+    if ((operand_type == StaticType::Int || operand_type == StaticType::Double) &&
+        right_->getStaticType() == operand_type) {
+        Value left_val = left_->evaluate(context);
+        Value right_val = right_->evaluate(context);
+        if (auto l = std::get_if<Int>(&left_val)) {
+            if (auto r = std::get_if<Int>(&right_val)) {
+                return Bool(compareOrdered(*l, *r, operator_));
+            }
+        } else if (auto l = std::get_if<Double>(&left_val)) {
+            if (auto r = std::get_if<Double>(&right_val)) {
+                return Bool(compareOrdered(*l, *r, operator_));
+            }
+        }
+        STACK_FRAME_GUARD(context, "comparison", "expression", *this);
+        return Bool(compareValues(left_val, right_val, operator_, context));
+    }
+
     // Add stack frame for this comparison operation
     STACK_FRAME_GUARD(context, "comparison", "expression", *this);
 
-    Value left_val = left_->evaluate(context);
-    Value right_val = right_->evaluate(context);
+    // Operands are only read, so variables are borrowed rather than copied
+    Value left_storage;
+    Value right_storage;
+    const Value& left_val = left_->evaluateBorrowed(context, left_storage);
+    const Value& right_val = right_->evaluateBorrowed(context, right_storage);
 
     bool result = compareValues(left_val, right_val, operator_, context);
     return Bool(result);
@@ -119,8 +142,8 @@ bool ComparisonNode::compareValues(const Value& left, const Value& right, Compar
                 break;
             }
             case 4: {  // Text
-                Text l = std::get<Text>(left);
-                Text r = std::get<Text>(right);
+                const Text& l = std::get<Text>(left);
+                const Text& r = std::get<Text>(right);
                 switch (op) {
                     case ComparisonOperator::EQUAL:
                         return l == r;
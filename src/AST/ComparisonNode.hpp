@@ -55,6 +55,25 @@ class ComparisonNode : public ASTNode {
     }
 
    private:
+    template <typename T>
+    static bool compareOrdered(T left, T right, ComparisonOperator op) {
+        switch (op) {
+            case ComparisonOperator::EQUAL:
+                return left == right;
+            case ComparisonOperator::NOT_EQUAL:
+                return left != right;
+            case ComparisonOperator::LESS_THAN:
+                return left < right;
+            case ComparisonOperator::GREATER_THAN:
+                return left > right;
+            case ComparisonOperator::LESS_EQUAL:
+                return left <= right;
+            case ComparisonOperator::GREATER_EQUAL:
+                return left >= right;
+        }
+        return false;
+    }
+
     bool compareValues(const Value& left, const Value& right, ComparisonOperator op,
                        Context& context);
     std::string operatorToString(ComparisonOperator op) const;
@@ -16,11 +16,15 @@
 
 #include "ConstructorDeclarationNode.hpp"
 
+#include "LastUseAnalysis.hpp"
+
 namespace o2l {
 
 ConstructorDeclarationNode::ConstructorDeclarationNode(std::vector<Parameter> parameters,
                                                        ASTNodePtr body)
-    : parameters_(std::move(parameters)), body_(std::move(body)) {}
+    : parameters_(std::move(parameters)), body_(std::move(body)) {
+    markLastUses(parameters_, body_.get());
+}
 
 Value ConstructorDeclarationNode::evaluate(Context& context) {
     // Constructor declarations don't evaluate to values directly
@@ -21,9 +21,16 @@
 namespace o2l {
 
 Value IdentifierNode::evaluate(Context& context) {
+    if (moves_value_) {
+        return context.takeVariable(name_);
+    }
     return context.getVariable(name_);
 }
 
+const Value& IdentifierNode::evaluateBorrowed(Context& context, Value&) {
+    return context.lookupVariable(name_);
+}
+
 std::string IdentifierNode::toString() const {
     return "Identifier(" + name_ + ")";
 }
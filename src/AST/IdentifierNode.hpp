@@ -25,16 +25,26 @@ namespace o2l {
 class IdentifierNode : public ASTNode {
    private:
     std::string name_;
+    // Set by the last-use analysis: this read is the variable's last, so it may be moved
+    bool moves_value_ = false;
 
    public:
     explicit IdentifierNode(std::string name) : name_(std::move(name)) {}
 
     Value evaluate(Context& context) override;
+    const Value& evaluateBorrowed(Context& context, Value& storage) override;
     std::string toString() const override;
 
     const std::string& getName() const {
         return name_;
     }
+
+    bool movesValue() const {
+        return moves_value_;
+    }
+    void setMovesValue() {
+        moves_value_ = true;
+    }
 };
 
 }  // namespace o2l
\ No newline at end of file
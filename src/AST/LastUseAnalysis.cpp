@@ -0,0 +1,269 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LastUseAnalysis.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+
+#include "BinaryOpNode.hpp"
+#include "BlockNode.hpp"
+#include "BreakNode.hpp"
+#include "ComparisonNode.hpp"
+#include "ConstDeclarationNode.hpp"
+#include "ContinueNode.hpp"
+#include "EnumAccessNode.hpp"
+#include "IdentifierNode.hpp"
+#include "IfStatementNode.hpp"
+#include "ListLiteralNode.hpp"
+#include "LiteralNode.hpp"
+#include "LogicalNode.hpp"
+#include "MapLiteralNode.hpp"
+#include "MemberAccessNode.hpp"
+#include "MethodCallNode.hpp"
+#include "NewExpressionNode.hpp"
+#include "PropertyAssignmentNode.hpp"
+#include "QualifiedIdentifierNode.hpp"
+#include "RecordFieldAccessNode.hpp"
+#include "RecordInstantiationNode.hpp"
+#include "ReturnNode.hpp"
+#include "SetLiteralNode.hpp"
+#include "ThisNode.hpp"
+#include "ThrowNode.hpp"
+#include "TryCatchFinallyNode.hpp"
+#include "UnaryNode.hpp"
+#include "VariableAssignmentNode.hpp"
+#include "VariableDeclarationNode.hpp"
+#include "WhileStatementNode.hpp"
+
+namespace o2l {
+
+namespace {
+
+class LastUseAnalyzer {
+   public:
+    void run(const std::vector<Parameter>& parameters, ASTNode* body) {
+        for (const auto& parameter : parameters) {
+            declare(parameter.name);
+        }
+        visit(body);
+        if (!supported_) {
+            return;
+        }
+        for (auto* statement : discarded_declarations_) {
+            statement->setValueDiscarded();
+        }
+        for (auto* statement : discarded_assignments_) {
+            statement->setValueDiscarded();
+        }
+        for (const auto& [name, uses] : uses_) {
+            const Use& last = uses.back();
+            if (!last.node || excluded_.count(name) || (!last.loops.empty() &&
+                                                        !declaredAfresh(name, uses))) {
+                continue;
+            }
+            last.node->setMovesValue();
+        }
+    }
+
+   private:
+    struct Use {
+        IdentifierNode* node;  // null for reads that must not move
+        size_t order;
+        std::vector<const ASTNode*> loops;
+        std::vector<const ASTNode*> branches;
+    };
+    struct Declaration {
+        size_t order;
+        std::vector<const ASTNode*> loops;
+        std::vector<const ASTNode*> branches;
+        int count = 0;
+    };
+
+    // A variable read inside a loop may only move if every iteration that reaches the read
+    // declares it again first: one declaration, in the same loop, on the read's path and
+    // before any use
+    bool declaredAfresh(const std::string& name, const std::vector<Use>& uses) const {
+        auto found = declarations_.find(name);
+        if (found == declarations_.end()) {
+            return false;
+        }
+        const Declaration& declaration = found->second;
+        const Use& last = uses.back();
+        return declaration.count == 1 && declaration.loops == last.loops &&
+               declaration.branches.size() <= last.branches.size() &&
+               std::equal(declaration.branches.begin(), declaration.branches.end(),
+                          last.branches.begin()) &&
+               uses.front().order > declaration.order;
+    }
+
+    void declare(const std::string& name) {
+        Declaration& declaration = declarations_[name];
+        declaration.order = order_++;
+        declaration.loops = loops_;
+        declaration.branches = branches_;
+        ++declaration.count;
+    }
+
+    void use(const std::string& name, IdentifierNode* movable) {
+        uses_[name].push_back(Use{movable, order_++, loops_, branches_});
+    }
+
+    // Code that runs conditionally, or repeatedly for loops
+    void visitBranch(ASTNode* node) {
+        branches_.push_back(node);
+        visit(node);
+        branches_.pop_back();
+    }
+
+    // Reads of a node whose value the parent borrows: a variable is read in place, so it
+    // stays in use until the parent is done
+    void visitBorrowed(ASTNode* node, const std::vector<ASTNode*>& evaluated_after) {
+        if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            for (auto* later : evaluated_after) {
+                visit(later);
+            }
+            use(identifier->getName(), nullptr);
+            return;
+        }
+        visit(node);
+        for (auto* later : evaluated_after) {
+            visit(later);
+        }
+    }
+
+    void visitAll(const std::vector<ASTNodePtr>& nodes) {
+        for (const auto& node : nodes) {
+            visit(node.get());
+        }
+    }
+
+    void visit(ASTNode* node) {
+        if (!node || !supported_) {
+            return;
+        }
+        if (auto block = dynamic_cast<BlockNode*>(node)) {
+            const auto& statements = block->getStatements();
+            for (size_t i = 0; i < statements.size(); ++i) {
+                // The last statement's value is the block's value
+                if (i + 1 < statements.size()) {
+                    if (auto declaration =
+                            dynamic_cast<VariableDeclarationNode*>(statements[i].get())) {
+                        discarded_declarations_.push_back(declaration);
+                    } else if (auto assignment =
+                                   dynamic_cast<VariableAssignmentNode*>(statements[i].get())) {
+                        discarded_assignments_.push_back(assignment);
+                    }
+                }
+                visit(statements[i].get());
+            }
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(node)) {
+            use(identifier->getName(), identifier);
+        } else if (auto declaration = dynamic_cast<VariableDeclarationNode*>(node)) {
+            visit(declaration->getInitializer().get());
+            declare(declaration->getVariableName());
+        } else if (auto assignment = dynamic_cast<VariableAssignmentNode*>(node)) {
+            visit(assignment->getValueExpressionPtr().get());
+        } else if (auto constant = dynamic_cast<ConstDeclarationNode*>(node)) {
+            visit(constant->getInitializer().get());
+            excluded_.insert(constant->getConstName());
+        } else if (auto property = dynamic_cast<PropertyAssignmentNode*>(node)) {
+            visit(property->getValueExpression().get());
+        } else if (auto return_node = dynamic_cast<ReturnNode*>(node)) {
+            visit(return_node->getExpression().get());
+        } else if (auto throw_node = dynamic_cast<ThrowNode*>(node)) {
+            visit(throw_node->getExpression().get());
+        } else if (auto if_node = dynamic_cast<IfStatementNode*>(node)) {
+            visit(if_node->getCondition().get());
+            visitBranch(if_node->getThenBranch().get());
+            visitBranch(if_node->getElseBranch().get());
+        } else if (auto while_node = dynamic_cast<WhileStatementNode*>(node)) {
+            loops_.push_back(while_node);
+            visit(while_node->getCondition().get());
+            visitBranch(while_node->getBody().get());
+            loops_.pop_back();
+        } else if (auto try_node = dynamic_cast<TryCatchFinallyNode*>(node)) {
+            visitBranch(try_node->getTryBlock().get());
+            excluded_.insert(try_node->getCatchVariable());
+            visitBranch(try_node->getCatchBlock().get());
+            visitBranch(try_node->getFinallyBlock().get());
+        } else if (auto call = dynamic_cast<MethodCallNode*>(node)) {
+            std::vector<ASTNode*> arguments;
+            for (const auto& argument : call->getArguments()) {
+                arguments.push_back(argument.get());
+            }
+            visitBorrowed(call->getObject().get(), arguments);
+        } else if (auto binary = dynamic_cast<BinaryOpNode*>(node)) {
+            visitBorrowed(binary->getLeft().get(), {binary->getRight().get()});
+        } else if (auto comparison = dynamic_cast<ComparisonNode*>(node)) {
+            visitBorrowed(comparison->getLeft().get(), {comparison->getRight().get()});
+        } else if (auto logical = dynamic_cast<LogicalNode*>(node)) {
+            visit(logical->getLeft().get());
+            visit(logical->getRight().get());
+        } else if (auto unary = dynamic_cast<UnaryNode*>(node)) {
+            visit(unary->getOperand().get());
+        } else if (auto member = dynamic_cast<MemberAccessNode*>(node)) {
+            visit(member->getObjectExpression().get());
+        } else if (auto field = dynamic_cast<RecordFieldAccessNode*>(node)) {
+            visit(field->getRecordExpression().get());
+        } else if (auto record = dynamic_cast<RecordInstantiationNode*>(node)) {
+            for (const auto& assignment : record->getFieldAssignments()) {
+                visit(assignment.value_expr.get());
+            }
+        } else if (auto creation = dynamic_cast<NewExpressionNode*>(node)) {
+            visitAll(creation->getConstructorArgs());
+        } else if (auto list = dynamic_cast<ListLiteralNode*>(node)) {
+            visitAll(list->getElements());
+        } else if (auto set = dynamic_cast<SetLiteralNode*>(node)) {
+            visitAll(set->getElements());
+        } else if (auto map = dynamic_cast<MapLiteralNode*>(node)) {
+            for (const auto& [key, value] : map->getEntries()) {
+                visit(key.get());
+                visit(value.get());
+            }
+        } else if (auto qualified = dynamic_cast<QualifiedIdentifierNode*>(node)) {
+            for (const auto& part : qualified->getParts()) {
+                use(part, nullptr);
+            }
+            use(qualified->getFullQualifiedName(), nullptr);
+        } else if (auto enum_access = dynamic_cast<EnumAccessNode*>(node)) {
+            use(enum_access->getEnumName(), nullptr);
+        } else if (!dynamic_cast<LiteralNode*>(node) && !dynamic_cast<ThisNode*>(node) &&
+                   !dynamic_cast<BreakNode*>(node) && !dynamic_cast<ContinueNode*>(node)) {
+            supported_ = false;
+        }
+    }
+
+    bool supported_ = true;
+    size_t order_ = 0;
+    std::vector<const ASTNode*> loops_;
+    std::vector<const ASTNode*> branches_;
+    std::map<std::string, std::vector<Use>> uses_;
+    std::map<std::string, Declaration> declarations_;
+    std::set<std::string> excluded_;
+    std::vector<VariableDeclarationNode*> discarded_declarations_;
+    std::vector<VariableAssignmentNode*> discarded_assignments_;
+};
+
+}  // namespace
+
+void markLastUses(const std::vector<Parameter>& parameters, ASTNode* body) {
+    LastUseAnalyzer().run(parameters, body);
+}
+
+}  // namespace o2l
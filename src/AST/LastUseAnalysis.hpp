@@ -0,0 +1,39 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "MethodDeclarationNode.hpp"
+#include "Node.hpp"
+
+namespace o2l {
+
+/**
+ * Liveness over a method or constructor body, run once when the declaration is built.
+ *
+ * A read of a variable that is certainly its last in the body is marked so the interpreter
+ * moves the value out instead of copying it, and declarations and assignments whose
+ * statement value is discarded move their value into the variable. Reads the interpreter
+ * borrows (method receivers, operands) are never moved and count as uses until the
+ * expression is done with them. Reads inside a loop only move a variable declared afresh in
+ * that loop's body before any use. A body containing a node the analysis does not know is
+ * left unmarked.
+ */
+void markLastUses(const std::vector<Parameter>& parameters, ASTNode* body);
+
+}  // namespace o2l
@@ -76,6 +76,8 @@ Value LogicalNode::evaluate(Context& context) {
         } else {
             throw;  // Re-throw as-is if it already has stack trace
         }
+    } catch (const ExecutionCancelledError&) {
+        throw;  // cancellation unwinds the whole evaluation unchanged
     } catch (const std::exception& e) {
         // Convert standard exceptions to our exception type with stack trace
         throw EvaluationError(std::string("Standard exception in logical expression: ") + e.what(),
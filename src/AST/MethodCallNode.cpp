@@ -30,12 +30,15 @@
 #include "../Runtime/MapInstance.hpp"
 #include "../Runtime/MapIterator.hpp"
 #include "../Runtime/MapObject.hpp"
+#include "../Runtime/NativeModuleObject.hpp"
+#include "../Runtime/NumberConversion.hpp"
 #include "../Runtime/ObjectInstance.hpp"
 #include "../Runtime/RepeatIterator.hpp"
 #include "../Runtime/ResultInstance.hpp"
 #include "../Runtime/SetInstance.hpp"
 #include "../Runtime/SetIterator.hpp"
 #include "../Runtime/FFI/FFITypes.hpp"
+#include "LiteralNode.hpp"
 
 namespace o2l {
 
@@ -44,12 +47,60 @@ MethodCallNode::MethodCallNode(ASTNodePtr object, std::string method_name,
     : ASTNode(location),
       object_(std::move(object)),
       method_name_(std::move(method_name)),
-      arguments_(std::move(arguments)) {}
+      arguments_(std::move(arguments)),
+      constant_arguments_(std::all_of(arguments_.begin(), arguments_.end(), [](const auto& arg) {
+          return dynamic_cast<const LiteralNode*>(arg.get()) != nullptr;
+      })) {}
+
+MethodCallNode::~MethodCallNode() {
+    delete folded_.load(std::memory_order_relaxed);
+}
 
 Value MethodCallNode::evaluate(Context& context) {
     try {
-        // Evaluate the object expression first to get the actual object name
-        Value object_value = object_->evaluate(context);
+        // Evaluate the object expression first to get the actual object name; a receiver held
+        // in a variable is only inspected, so it is borrowed rather than copied
+        Value receiver;
+        const Value& object_value = object_->evaluateBorrowed(context, receiver);
+        std::vector<Value> arg_values;
+
+        // get() and size() on a receiver the type checker found to be a List skip the stack
+        // frame and the dispatch below; an index that does not fit takes the full path
+        if (object_->getStaticType() == StaticType::List) {
+            if (auto list = std::get_if<std::shared_ptr<ListInstance>>(&object_value)) {
+                if (method_name_ == "size" && arguments_.empty()) {
+                    return Int(static_cast<Int>((*list)->size()));
+                }
+                if (method_name_ == "get" && arguments_.size() == 1) {
+                    Value index = arguments_[0]->evaluate(context);
+                    auto position = std::get_if<Int>(&index);
+                    if (position && *position >= 0 &&
+                        static_cast<size_t>(*position) < (*list)->size()) {
+                        return (*list)->get(static_cast<size_t>(*position));
+                    }
+                    arg_values.push_back(std::move(index));
+                }
+            }
+        }
+
+        // A pure native method with literal arguments returns what it returned the first time
+        const o2l_native_method* pure_native = nullptr;
+        NativeModuleObject* native_module = nullptr;
+        if (constant_arguments_) {
+            if (auto object = std::get_if<std::shared_ptr<ObjectInstance>>(&object_value)) {
+                native_module = dynamic_cast<NativeModuleObject*>(object->get());
+            }
+            if (native_module) {
+                pure_native = native_module->getModule().findMethod(method_name_);
+                if (pure_native && !(pure_native->flags & O2L_NATIVE_PURE)) {
+                    pure_native = nullptr;
+                }
+            }
+            FoldedCall* folded = folded_.load(std::memory_order_acquire);
+            if (pure_native && folded && folded->method == pure_native) {
+                return folded->result;
+            }
+        }
 
         // Determine the actual object name for stack trace
         std::string actual_object_name = "object";  // Default fallback
@@ -81,12 +132,22 @@ Value MethodCallNode::evaluate(Context& context) {
         // Create stack frame for this method call with actual object name
         STACK_FRAME_GUARD(context, method_name_, actual_object_name, *this);
 
-        // Evaluate arguments
-        std::vector<Value> arg_values;
-        arg_values.reserve(arguments_.size());
+        // Evaluate arguments, unless the List fast path above already did
+        if (arg_values.empty()) {
+            arg_values.reserve(arguments_.size());
+            for (const auto& arg : arguments_) {
+                arg_values.push_back(arg->evaluate(context));
+            }
+        }
 
-        for (const auto& arg : arguments_) {
-            arg_values.push_back(arg->evaluate(context));
+        if (pure_native) {
+            Value result = native_module->invoke(*pure_native, arg_values, context);
+            auto folded = new FoldedCall{pure_native, result};
+            FoldedCall* expected = nullptr;
+            if (!folded_.compare_exchange_strong(expected, folded, std::memory_order_acq_rel)) {
+                delete folded;
+            }
+            return result;
         }
 
         // Check if it's a ListInstance
@@ -706,7 +767,7 @@ Value MethodCallNode::evaluate(Context& context) {
 
         // Check if it's a Text (string)
         if (std::holds_alternative<Text>(object_value)) {
-            auto text_value = std::get<Text>(object_value);
+            const auto& text_value = std::get<Text>(object_value);
 
             // Handle Text methods
             if (method_name_ == "capitalize") {
@@ -1258,9 +1319,9 @@ Value MethodCallNode::evaluate(Context& context) {
                     if (std::holds_alternative<Text>(elements[i])) {
                         result += std::get<Text>(elements[i]);
                     } else if (std::holds_alternative<Int>(elements[i])) {
-                        result += std::to_string(std::get<Int>(elements[i]));
+                        numeric::appendInt(result, std::get<Int>(elements[i]));
                     } else if (std::holds_alternative<Float>(elements[i])) {
-                        result += std::to_string(std::get<Float>(elements[i]));
+                        numeric::appendFloat(result, std::get<Float>(elements[i]));
                     } else if (std::holds_alternative<Bool>(elements[i])) {
                         result += std::get<Bool>(elements[i]) ? "true" : "false";
                     } else {
@@ -1326,9 +1387,9 @@ Value MethodCallNode::evaluate(Context& context) {
                     if (std::holds_alternative<Text>(arg_values[i])) {
                         replacement = std::get<Text>(arg_values[i]);
                     } else if (std::holds_alternative<Int>(arg_values[i])) {
-                        replacement = std::to_string(std::get<Int>(arg_values[i]));
+                        replacement = numeric::formatInt(std::get<Int>(arg_values[i]));
                     } else if (std::holds_alternative<Float>(arg_values[i])) {
-                        replacement = std::to_string(std::get<Float>(arg_values[i]));
+                        replacement = numeric::formatFloat(std::get<Float>(arg_values[i]));
                     } else if (std::holds_alternative<Bool>(arg_values[i])) {
                         replacement = std::get<Bool>(arg_values[i]) ? "true" : "false";
                     } else {
@@ -1363,9 +1424,9 @@ Value MethodCallNode::evaluate(Context& context) {
                         if (std::holds_alternative<Text>(value)) {
                             replacement = std::get<Text>(value);
                         } else if (std::holds_alternative<Int>(value)) {
-                            replacement = std::to_string(std::get<Int>(value));
+                            replacement = numeric::formatInt(std::get<Int>(value));
                         } else if (std::holds_alternative<Float>(value)) {
-                            replacement = std::to_string(std::get<Float>(value));
+                            replacement = numeric::formatFloat(std::get<Float>(value));
                         } else if (std::holds_alternative<Bool>(value)) {
                             replacement = std::get<Bool>(value) ? "true" : "false";
                         } else {
@@ -1431,75 +1492,40 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Text.toInt() takes no arguments", context);
                 }
-                try {
-                    // Remove whitespace and convert to integer
-                    std::string trimmed = text_value;
-                    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-                    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-
-                    if (trimmed.empty()) {
-                        throw std::invalid_argument("Empty string");
-                    }
-
-                    int result = std::stoi(trimmed);
-                    return Int(result);
-                } catch (const std::exception&) {
+                // Like stoi, conversions read the number the text starts with: "12abc" is 12
+                auto number = numeric::parseIntPrefix(numeric::trim(text_value));
+                if (!number || *number > std::numeric_limits<int>::max() ||
+                    *number < std::numeric_limits<int>::min()) {
                     throw EvaluationError("Cannot convert '" + text_value + "' to Int", context);
                 }
+                return Int(*number);
             } else if (method_name_ == "toLong") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Text.toLong() takes no arguments", context);
                 }
-                try {
-                    std::string trimmed = text_value;
-                    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-                    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-
-                    if (trimmed.empty()) {
-                        throw std::invalid_argument("Empty string");
-                    }
-
-                    long result = std::stol(trimmed);
-                    return Long(result);
-                } catch (const std::exception&) {
+                auto number = numeric::parseLongPrefix(numeric::trim(text_value));
+                if (!number) {
                     throw EvaluationError("Cannot convert '" + text_value + "' to Long", context);
                 }
+                return Long(*number);
             } else if (method_name_ == "toDouble") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Text.toDouble() takes no arguments", context);
                 }
-                try {
-                    std::string trimmed = text_value;
-                    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-                    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-
-                    if (trimmed.empty()) {
-                        throw std::invalid_argument("Empty string");
-                    }
-
-                    double result = std::stod(trimmed);
-                    return Float(result);
-                } catch (const std::exception&) {
+                auto number = numeric::parseDoublePrefix(numeric::trim(text_value));
+                if (!number) {
                     throw EvaluationError("Cannot convert '" + text_value + "' to Double", context);
                 }
+                return Float(*number);
             } else if (method_name_ == "toFloat") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Text.toFloat() takes no arguments", context);
                 }
-                try {
-                    std::string trimmed = text_value;
-                    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-                    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-
-                    if (trimmed.empty()) {
-                        throw std::invalid_argument("Empty string");
-                    }
-
-                    float result = std::stof(trimmed);
-                    return Float(result);
-                } catch (const std::exception&) {
+                auto number = numeric::parseFloatPrefix(numeric::trim(text_value));
+                if (!number) {
                     throw EvaluationError("Cannot convert '" + text_value + "' to Float", context);
                 }
+                return Float(*number);
             } else if (method_name_ == "toBool") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Text.toBool() takes no arguments", context);
@@ -1537,7 +1563,7 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Int.toString() takes no arguments", context);
                 }
-                return Text(std::to_string(int_value));
+                return Text(numeric::formatInt(int_value));
             } else if (method_name_ == "toDouble") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Int.toDouble() takes no arguments", context);
@@ -1571,17 +1597,16 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Long.toString() takes no arguments", context);
                 }
-                return Text(std::to_string(static_cast<long long>(long_value)));
+                return Text(numeric::formatLong(long_value));
             } else if (method_name_ == "toInt") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Long.toInt() takes no arguments", context);
                 }
                 if (long_value > std::numeric_limits<int>::max() ||
                     long_value < std::numeric_limits<int>::min()) {
-                    throw EvaluationError("Long value " +
-                                              std::to_string(static_cast<long long>(long_value)) +
-                                              " out of Int range",
-                                          context);
+                    throw EvaluationError(
+                        "Long value " + numeric::formatLong(long_value) + " out of Int range",
+                        context);
                 }
                 return Int(static_cast<int>(long_value));
             } else if (method_name_ == "toDouble") {
@@ -1613,7 +1638,7 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Float.toString() takes no arguments", context);
                 }
-                return Text(std::to_string(float_value));
+                return Text(numeric::formatFloat(float_value));
             } else if (method_name_ == "toInt") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Float.toInt() takes no arguments", context);
@@ -1624,7 +1649,7 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (float_value > std::numeric_limits<int>::max() ||
                     float_value < std::numeric_limits<int>::min()) {
                     throw EvaluationError(
-                        "Float value " + std::to_string(float_value) + " out of Int range",
+                        "Float value " + numeric::formatFloat(float_value) + " out of Int range",
                         context);
                 }
                 return Int(static_cast<int>(float_value));
@@ -1638,7 +1663,7 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (float_value > std::numeric_limits<long>::max() ||
                     float_value < std::numeric_limits<long>::min()) {
                     throw EvaluationError(
-                        "Float value " + std::to_string(float_value) + " out of Long range",
+                        "Float value " + numeric::formatFloat(float_value) + " out of Long range",
                         context);
                 }
                 return Long(static_cast<long>(float_value));
@@ -1676,7 +1701,7 @@ Value MethodCallNode::evaluate(Context& context) {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Double.toString() takes no arguments", context);
                 }
-                return Text(std::to_string(double_value));
+                return Text(numeric::formatDouble(double_value));
             } else if (method_name_ == "toInt") {
                 if (!arg_values.empty()) {
                     throw EvaluationError("Double.toInt() takes no arguments", context);
@@ -1686,9 +1711,9 @@ Value MethodCallNode::evaluate(Context& context) {
                 }
                 if (double_value > std::numeric_limits<int>::max() ||
                     double_value < std::numeric_limits<int>::min()) {
-                    throw EvaluationError(
-                        "Double value " + std::to_string(double_value) + " out of Int range",
-                        context);
+                    throw EvaluationError("Double value " + numeric::formatDouble(double_value) +
+                                              " out of Int range",
+                                          context);
                 }
                 return Int(static_cast<int>(double_value));
             } else if (method_name_ == "toLong") {
@@ -1700,9 +1725,9 @@ Value MethodCallNode::evaluate(Context& context) {
                 }
                 if (double_value > std::numeric_limits<long>::max() ||
                     double_value < std::numeric_limits<long>::min()) {
-                    throw EvaluationError(
-                        "Double value " + std::to_string(double_value) + " out of Long range",
-                        context);
+                    throw EvaluationError("Double value " + numeric::formatDouble(double_value) +
+                                              " out of Long range",
+                                          context);
                 }
                 return Long(static_cast<long>(double_value));
             } else if (method_name_ == "toFloat") {
@@ -1790,6 +1815,9 @@ Value MethodCallNode::evaluate(Context& context) {
             }
         }
 
+        // Nothing reads the arguments after the call, so the method may move them into its
+        // parameters
+        Context::ArgumentHandoff handoff(arg_values);
         return object_instance->callMethod(method_name_, arg_values, context, is_external_call);
 
     } catch (const o2lException& e) {
@@ -1799,6 +1827,8 @@ Value MethodCallNode::evaluate(Context& context) {
         } else {
             throw;  // Re-throw as-is if it already has stack trace
         }
+    } catch (const ExecutionCancelledError&) {
+        throw;  // cancellation unwinds the whole evaluation unchanged
     } catch (const std::exception& e) {
         // Convert standard exceptions to our exception type with stack trace
         throw EvaluationError(std::string("Standard exception in method call: ") + e.what(),
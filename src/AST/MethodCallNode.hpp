@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -29,9 +30,19 @@ class MethodCallNode : public ASTNode {
     std::string method_name_;
     std::vector<ASTNodePtr> arguments_;
 
+    // Result of a pure native method called with literal arguments, computed on first use.
+    // Published once and shared by threads running the same code.
+    struct FoldedCall {
+        const void* method;
+        Value result;
+    };
+    bool constant_arguments_;
+    std::atomic<FoldedCall*> folded_{nullptr};
+
    public:
     MethodCallNode(ASTNodePtr object, std::string method_name, std::vector<ASTNodePtr> arguments,
                    const SourceLocation& location = SourceLocation());
+    ~MethodCallNode() override;
 
     Value evaluate(Context& context) override;
     std::string toString() const override;
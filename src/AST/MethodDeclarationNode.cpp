@@ -16,6 +16,8 @@
 
 #include "MethodDeclarationNode.hpp"
 
+#include "LastUseAnalysis.hpp"
+
 namespace o2l {
 
 MethodDeclarationNode::MethodDeclarationNode(std::string name, std::vector<Parameter> parameters,
@@ -26,7 +28,9 @@ MethodDeclarationNode::MethodDeclarationNode(std::string name, std::vector<Param
       parameters_(std::move(parameters)),
       return_type_(std::move(return_type)),
       body_(std::move(body)),
-      is_external_(is_external) {}
+      is_external_(is_external) {
+    markLastUses(parameters_, body_.get());
+}
 
 Value MethodDeclarationNode::evaluate(Context& context) {
     // Method declarations don't evaluate to values directly
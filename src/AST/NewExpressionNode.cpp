@@ -59,6 +59,7 @@ Value NewExpressionNode::evaluate(Context& context) {
     auto class_instance = std::get<std::shared_ptr<ObjectInstance>>(object_class);
 
     // Create a new instance by copying the class template
+    ExecutionBudget::chargeAllocation(sizeof(ObjectInstance));
     auto new_instance = std::make_shared<ObjectInstance>(*class_instance);
 
     // Evaluate constructor arguments
@@ -71,6 +72,7 @@ Value NewExpressionNode::evaluate(Context& context) {
 
     // Call constructor if it exists - this is an internal call (during object creation)
     if (new_instance->hasMethod("constructor")) {
+        Context::ArgumentHandoff handoff(arg_values);
         new_instance->callMethod("constructor", arg_values, context, false);
     } else if (!arg_values.empty()) {
         throw EvaluationError(
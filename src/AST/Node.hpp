@@ -16,11 +16,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include "../Common/SourceLocation.hpp"
 #include "../Runtime/Value.hpp"
+#include "StaticType.hpp"
 
 // Forward declaration to avoid circular dependency
 namespace o2l {
@@ -33,6 +36,11 @@ namespace o2l {
 class ASTNode {
    protected:
     SourceLocation source_location_;
+    StaticType static_type_ = StaticType::Unknown;
+#if O2L_ENABLE_COVERAGE
+    // This statement's execution counter, set only when the program was parsed for --coverage
+    std::atomic<uint64_t>* coverage_counter_ = nullptr;
+#endif
 
    public:
     ASTNode(const SourceLocation& location = SourceLocation()) : source_location_(location) {}
@@ -42,6 +50,14 @@ class ASTNode {
     // Every node can be evaluated to produce a Value
     virtual Value evaluate(Context& context) = 0;
 
+    // For callers that only inspect the result: nodes naming a stored value (variables)
+    // return it in place, others evaluate into `storage`. The reference must be used before
+    // anything else is evaluated that could assign the variable
+    virtual const Value& evaluateBorrowed(Context& context, Value& storage) {
+        storage = evaluate(context);
+        return storage;
+    }
+
     // For debugging and error reporting
     virtual std::string toString() const = 0;
 
@@ -52,6 +68,23 @@ class ASTNode {
     void setSourceLocation(const SourceLocation& location) {
         source_location_ = location;
     }
+
+    // Type recorded by the static type checker, Unknown unless --typecheck ran
+    StaticType getStaticType() const {
+        return static_type_;
+    }
+    void setStaticType(StaticType type) {
+        static_type_ = type;
+    }
+
+#if O2L_ENABLE_COVERAGE
+    std::atomic<uint64_t>* getCoverageCounter() const {
+        return coverage_counter_;
+    }
+    void setCoverageCounter(std::atomic<uint64_t>* counter) {
+        coverage_counter_ = counter;
+    }
+#endif
 };
 
 using ASTNodePtr = std::unique_ptr<ASTNode>;
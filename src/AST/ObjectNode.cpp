@@ -19,6 +19,8 @@
 #include <iostream>
 
 #include "../Common/Exceptions.hpp"
+#include "../Runtime/AotRuntime.hpp"
+#include "../Runtime/BaselineJit.hpp"
 #include "../Runtime/Context.hpp"
 #include "../Runtime/ObjectInstance.hpp"
 #include "../Runtime/ProtocolInstance.hpp"
@@ -27,6 +29,24 @@
 
 namespace o2l {
 
+namespace {
+
+// Arguments the caller handed off are moved into the parameters; others are copied
+void bindParameters(const std::vector<Parameter>& params, const std::vector<Value>& args,
+                    Context& ctx) {
+    if (std::vector<Value>* owned = Context::ArgumentHandoff::claim(args)) {
+        for (size_t i = 0; i < params.size(); ++i) {
+            ctx.defineVariable(params[i].name, std::move((*owned)[i]));
+        }
+        return;
+    }
+    for (size_t i = 0; i < params.size(); ++i) {
+        ctx.defineVariable(params[i].name, args[i]);
+    }
+}
+
+}  // namespace
+
 ObjectNode::ObjectNode(std::string name, std::vector<ASTNodePtr> methods,
                        std::vector<ASTNodePtr> properties, ASTNodePtr constructor,
                        const std::string& protocol_name)
@@ -59,9 +79,7 @@ Value ObjectNode::evaluate(Context& context) {
                                           ctx);
                 }
 
-                for (size_t i = 0; i < params.size(); ++i) {
-                    ctx.defineVariable(params[i].name, args[i]);
-                }
+                bindParameters(params, args, ctx);
 
                 // Execute constructor body
                 Value result = constructor_decl->getBody()->evaluate(ctx);
@@ -74,6 +92,9 @@ Value ObjectNode::evaluate(Context& context) {
         }
     }
 
+    // Methods run through the baseline JIT once they get hot, when it is enabled
+    std::shared_ptr<JitObject> jit_object = BaselineJit::prepare(*this);
+
     // Process methods and add them to the object instance
     for (const auto& method_node : methods_) {
         // Cast to MethodDeclarationNode to access method details
@@ -93,8 +114,17 @@ Value ObjectNode::evaluate(Context& context) {
                 module_variables[var_name] = context.getVariable(var_name);
             }
 
-            Method method_impl = [method_decl, module_variables](const std::vector<Value>& args,
-                                                                 Context& ctx) -> Value {
+            JitMethod* jit_method = jit_object ? jit_object->method(method_decl) : nullptr;
+            Method method_impl = [method_decl, module_variables, jit_object, jit_method](
+                                     const std::vector<Value>& args, Context& ctx) -> Value {
+                if (jit_method) {
+                    Value native_result;
+                    if (jit_object->invoke(*jit_method, args, ctx, native_result)) {
+                        return native_result;
+                    }
+                }
+                BaselineJit::ProfileScope profile(jit_method);
+
                 // Create new scope for method execution
                 ctx.pushScope();
 
@@ -115,24 +145,31 @@ Value ObjectNode::evaluate(Context& context) {
                                           ctx);
                 }
 
-                for (size_t i = 0; i < params.size(); ++i) {
-                    ctx.defineVariable(params[i].name, args[i]);
-                }
+                bindParameters(params, args, ctx);
 
                 // Execute method body
                 Value result;
                 try {
                     result = method_decl->getBody()->evaluate(ctx);
-                } catch (const ReturnException& e) {
+                } catch (ReturnException& e) {
                     // Return statement encountered - use its value
                     ctx.popScope();
-                    return e.getValue();
+                    return e.takeValue();
                 }
 
                 ctx.popScope();
                 return result;
             };
 
+            // A method compiled ahead of time runs natively, falling back to the closure above
+            // for arguments it was not compiled for
+            if (AotEntry native = AotMethods::find(method_decl)) {
+                method_impl = [native, interpreted = std::move(method_impl)](
+                                  const std::vector<Value>& args, Context& ctx) -> Value {
+                    return native(args, ctx, interpreted);
+                };
+            }
+
             object_instance->addMethod(method_name, method_impl, method_decl->isExternal());
         }
     }
@@ -16,33 +16,48 @@
 
 #include "QualifiedIdentifierNode.hpp"
 
+#include <atomic>
+
 #include "../Common/Exceptions.hpp"
 #include "../Runtime/Context.hpp"
 
 namespace o2l {
 
-Value QualifiedIdentifierNode::evaluate(Context& context) {
-    std::string full_name = getFullQualifiedName();
+namespace {
+std::atomic<size_t> g_next_link_site{0};
+}
 
-    // First try to resolve the full qualified name
-    if (context.hasVariable(full_name)) {
-        return context.getVariable(full_name);
+QualifiedIdentifierNode::QualifiedIdentifierNode(std::vector<std::string> parts)
+    : parts_(std::move(parts)), link_site_(g_next_link_site++) {
+    for (size_t i = 0; i < parts_.size(); ++i) {
+        if (i > 0) full_name_ += ".";
+        full_name_ += parts_[i];
     }
+}
 
-    // If not found, try to resolve step by step
-    // Start with the first part and see if it exists
+Value QualifiedIdentifierNode::evaluate(Context& context) {
+    Value storage;
+    return evaluateBorrowed(context, storage);
+}
+
+const Value& QualifiedIdentifierNode::evaluateBorrowed(Context& context, Value&) {
     if (parts_.empty()) {
         throw EvaluationError("Empty qualified identifier");
     }
 
+    // The full qualified name, as namespaces register their members; resolved once per
+    // context and reused until a global binding changes
+    if (const Value* bound = context.lookupQualified(link_site_, full_name_)) {
+        return *bound;
+    }
+
     // Try just the last part (for simple access within same namespace)
-    std::string last_part = getLastPart();
-    if (context.hasVariable(last_part)) {
-        return context.getVariable(last_part);
+    if (const Value* bound = context.findVariable(parts_.back())) {
+        return *bound;
     }
 
     // If neither worked, throw an error
-    throw UnresolvedReferenceError("Qualified identifier '" + full_name +
+    throw UnresolvedReferenceError("Qualified identifier '" + full_name_ +
                                    "' not found in current context");
 }
 
@@ -26,11 +26,15 @@ namespace o2l {
 class QualifiedIdentifierNode : public ASTNode {
    private:
     std::vector<std::string> parts_;  // e.g., ["mylib", "collections", "List"]
+    std::string full_name_;           // parts_ joined with dots, built once
+    // Identifies this reference in each Context's cache of resolved qualified names
+    size_t link_site_;
 
    public:
-    explicit QualifiedIdentifierNode(std::vector<std::string> parts) : parts_(std::move(parts)) {}
+    explicit QualifiedIdentifierNode(std::vector<std::string> parts);
 
     Value evaluate(Context& context) override;
+    const Value& evaluateBorrowed(Context& context, Value& storage) override;
     std::string toString() const override;
 
     const std::vector<std::string>& getParts() const {
@@ -38,12 +42,7 @@ class QualifiedIdentifierNode : public ASTNode {
     }
 
     std::string getFullQualifiedName() const {
-        std::string result;
-        for (size_t i = 0; i < parts_.size(); ++i) {
-            if (i > 0) result += ".";
-            result += parts_[i];
-        }
-        return result;
+        return full_name_;
     }
 
     std::string getLastPart() const {
@@ -51,4 +50,4 @@ class QualifiedIdentifierNode : public ASTNode {
     }
 };
 
-}  // namespace o2l
\ No newline at end of file
+}  // namespace o2l
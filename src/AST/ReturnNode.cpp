@@ -33,7 +33,7 @@ Value ReturnNode::evaluate(Context& context) {
     }
 
     // Throw ReturnException to cause early exit from method execution
-    throw ReturnException(return_value);
+    throw ReturnException(std::move(return_value));
 }
 
 std::string ReturnNode::toString() const {
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../Runtime/Value.hpp"
+
+namespace o2l {
+
+// Type of an expression as established by the static type checker (o2l run --typecheck).
+// Unknown means "not established" and is what every node has when the checker did not run.
+enum class StaticType : uint8_t {
+    Unknown,
+    Int,
+    Long,
+    Float,
+    Double,
+    Text,
+    Bool,
+    Char,
+    List,
+    Map,
+    Set
+};
+
+// Maps a type annotation to a static type; annotations the checker does not model (objects,
+// enums, records, protocols, Optional, ...) map to Unknown
+inline StaticType staticTypeFromName(const std::string& name) {
+    if (name == "Int") return StaticType::Int;
+    if (name == "Long") return StaticType::Long;
+    if (name == "Float") return StaticType::Float;
+    if (name == "Double") return StaticType::Double;
+    if (name == "Text") return StaticType::Text;
+    if (name == "Bool") return StaticType::Bool;
+    if (name == "Char") return StaticType::Char;
+    if (name.rfind("List<", 0) == 0) return StaticType::List;
+    if (name.rfind("Map<", 0) == 0) return StaticType::Map;
+    if (name.rfind("Set<", 0) == 0) return StaticType::Set;
+    return StaticType::Unknown;
+}
+
+inline const char* staticTypeName(StaticType type) {
+    switch (type) {
+        case StaticType::Int:
+            return "Int";
+        case StaticType::Long:
+            return "Long";
+        case StaticType::Float:
+            return "Float";
+        case StaticType::Double:
+            return "Double";
+        case StaticType::Text:
+            return "Text";
+        case StaticType::Bool:
+            return "Bool";
+        case StaticType::Char:
+            return "Char";
+        case StaticType::List:
+            return "List";
+        case StaticType::Map:
+            return "Map";
+        case StaticType::Set:
+            return "Set";
+        case StaticType::Unknown:
+            break;
+    }
+    return "Unknown";
+}
+
+inline bool isNumericStaticType(StaticType type) {
+    return type == StaticType::Int || type == StaticType::Long || type == StaticType::Float ||
+           type == StaticType::Double;
+}
+
+// Whether a value of type `actual` may be stored under the annotation `declared`: the same
+// widenings VariableDeclarationNode accepts at runtime (Int to Long, Float or Double, and
+// Float to Double). Unknown on either side is accepted.
+inline bool isAssignableStaticType(StaticType declared, StaticType actual) {
+    if (declared == StaticType::Unknown || actual == StaticType::Unknown || declared == actual) {
+        return true;
+    }
+    switch (declared) {
+        case StaticType::Long:
+        case StaticType::Float:
+            return actual == StaticType::Int;
+        case StaticType::Double:
+            return actual == StaticType::Int || actual == StaticType::Float;
+        default:
+            return false;
+    }
+}
+
+// Checked types are annotations, not guarantees (arguments are not converted or checked at
+// runtime), so fast paths confirm the value with this single variant test before using it
+inline bool holdsStaticType(const Value& value, StaticType type) {
+    switch (type) {
+        case StaticType::Int:
+            return std::holds_alternative<Int>(value);
+        case StaticType::Long:
+            return std::holds_alternative<Long>(value);
+        case StaticType::Float:
+            return std::holds_alternative<Float>(value);
+        case StaticType::Double:
+            return std::holds_alternative<Double>(value);
+        case StaticType::Text:
+            return std::holds_alternative<Text>(value);
+        case StaticType::Bool:
+            return std::holds_alternative<Bool>(value);
+        case StaticType::Char:
+            return std::holds_alternative<Char>(value);
+        case StaticType::List:
+            return std::holds_alternative<std::shared_ptr<ListInstance>>(value);
+        case StaticType::Map:
+            return std::holds_alternative<std::shared_ptr<MapInstance>>(value);
+        case StaticType::Set:
+            return std::holds_alternative<std::shared_ptr<SetInstance>>(value);
+        case StaticType::Unknown:
+            break;
+    }
+    return false;
+}
+
+}  // namespace o2l
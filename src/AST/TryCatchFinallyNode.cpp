@@ -54,6 +54,17 @@ Value TryCatchFinallyNode::evaluate(Context& context) {
             finally_block_->evaluate(context);
         }
         throw;
+    } catch (const ExecutionCancelledError&) {
+        // Cancellation and exhausted budgets cannot be caught, but cleanup still runs; the
+        // finally block itself stops at its first poll while the token or budget stays spent
+        if (finally_block_) {
+            try {
+                finally_block_->evaluate(context);
+            } catch (...) {
+                // Suppress finally exceptions when re-throwing the cancellation
+            }
+        }
+        throw;
     }
 
     // Execute catch block if exception was thrown and catch block exists
@@ -66,6 +66,8 @@ Value UnaryNode::evaluate(Context& context) {
         } else {
             throw;  // Re-throw as-is if it already has stack trace
         }
+    } catch (const ExecutionCancelledError&) {
+        throw;  // cancellation unwinds the whole evaluation unchanged
     } catch (const std::exception& e) {
         // Convert standard exceptions to our exception type with stack trace
         throw EvaluationError(std::string("Standard exception in unary expression: ") + e.what(),
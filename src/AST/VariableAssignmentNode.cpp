@@ -26,6 +26,10 @@ Value VariableAssignmentNode::evaluate(Context& context) {
     Value new_value = value_expr_->evaluate(context);
 
     // Use the new reassignVariable method which handles all validation
+    if (value_discarded_) {
+        context.reassignVariable(variable_name_, std::move(new_value));
+        return Value{};
+    }
     context.reassignVariable(variable_name_, new_value);
 
     return new_value;
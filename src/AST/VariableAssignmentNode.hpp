@@ -26,6 +26,8 @@ class VariableAssignmentNode : public ASTNode {
    private:
     std::string variable_name_;
     ASTNodePtr value_expr_;
+    // Set by the last-use analysis when the statement's value is never used
+    bool value_discarded_ = false;
 
    public:
     VariableAssignmentNode(const std::string& variable_name, ASTNodePtr value_expr)
@@ -43,6 +45,9 @@ class VariableAssignmentNode : public ASTNode {
     const ASTNodePtr& getValueExpressionPtr() const {
         return value_expr_;
     }
+    void setValueDiscarded() {
+        value_discarded_ = true;
+    }
 };
 
 }  // namespace o2l
\ No newline at end of file
@@ -33,6 +33,32 @@ Value VariableDeclarationNode::evaluate(Context& context) {
     // Evaluate the initializer expression
     Value value = initializer_->evaluate(context);
 
+    // An initializer the type checker found to have the declared type needs no name-based
+    // checks once the value is confirmed (lists still have their elements checked below)
+    if (static_type_ != StaticType::Unknown && static_type_ != StaticType::List &&
+        initializer_->getStaticType() == static_type_ && holdsStaticType(value, static_type_)) {
+        if (value_discarded_) {
+            context.defineVariable(variable_name_, std::move(value));
+            return Value{};
+        }
+        context.defineVariable(variable_name_, value);
+        return value;
+    }
+
+    checkDeclaredType(value, context);
+
+    // Define the variable in the current scope
+    if (value_discarded_) {
+        context.defineVariable(variable_name_, std::move(value));
+        return Value{};
+    }
+    context.defineVariable(variable_name_, value);
+
+    // Return the assigned value
+    return value;
+}
+
+void VariableDeclarationNode::checkDeclaredType(const Value& value, Context& context) const {
     // Add type checking for List types
     if (type_name_.find("List<") == 0) {
         // Extract the element type from List<ElementType>
@@ -90,12 +116,6 @@ Value VariableDeclarationNode::evaluate(Context& context) {
             }
         }
     }
-
-    // Define the variable in the current scope
-    context.defineVariable(variable_name_, value);
-
-    // Return the assigned value
-    return value;
 }
 
 std::string VariableDeclarationNode::toString() const {
@@ -28,6 +28,9 @@ class VariableDeclarationNode : public ASTNode {
     std::string variable_name_;
     std::string type_name_;
     ASTNodePtr initializer_;
+    // Set by the last-use analysis when the statement's value is never used, so the value can
+    // be moved into the variable
+    bool value_discarded_ = false;
 
    public:
     VariableDeclarationNode(std::string variable_name, std::string type_name,
@@ -36,6 +39,9 @@ class VariableDeclarationNode : public ASTNode {
     Value evaluate(Context& context) override;
     std::string toString() const override;
 
+    // Throws unless `value` may be stored in a variable of the declared type
+    void checkDeclaredType(const Value& value, Context& context) const;
+
     const std::string& getVariableName() const {
         return variable_name_;
     }
@@ -45,6 +51,9 @@ class VariableDeclarationNode : public ASTNode {
     const ASTNodePtr& getInitializer() const {
         return initializer_;
     }
+    void setValueDiscarded() {
+        value_discarded_ = true;
+    }
 };
 
 }  // namespace o2l
\ No newline at end of file
@@ -17,6 +17,8 @@
 #include "WhileStatementNode.hpp"
 
 #include "../Common/Exceptions.hpp"
+#include "../Runtime/BaselineJit.hpp"
+#include "../Runtime/Context.hpp"
 
 namespace o2l {
 
@@ -27,6 +29,10 @@ Value WhileStatementNode::evaluate(Context& context) {
     Value result = Value{};  // Default empty value
 
     while (true) {
+        // Back-edge: a runaway loop must still honour the request deadline
+        context.checkCancellation();
+        BaselineJit::noteBackEdge();
+
         // Evaluate the condition
         Value condition_value = condition_->evaluate(context);
 
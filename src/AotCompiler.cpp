@@ -0,0 +1,1225 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AotCompiler.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "AST/BinaryOpNode.hpp"
+#include "AST/BlockNode.hpp"
+#include "AST/BreakNode.hpp"
+#include "AST/ComparisonNode.hpp"
+#include "AST/ConstDeclarationNode.hpp"
+#include "AST/ContinueNode.hpp"
+#include "AST/IdentifierNode.hpp"
+#include "AST/IfStatementNode.hpp"
+#include "AST/LiteralNode.hpp"
+#include "AST/LogicalNode.hpp"
+#include "AST/MethodCallNode.hpp"
+#include "AST/MethodDeclarationNode.hpp"
+#include "AST/NewExpressionNode.hpp"
+#include "AST/ObjectNode.hpp"
+#include "AST/PropertyAssignmentNode.hpp"
+#include "AST/ReturnNode.hpp"
+#include "AST/ThisNode.hpp"
+#include "AST/TryCatchFinallyNode.hpp"
+#include "AST/UnaryNode.hpp"
+#include "AST/VariableAssignmentNode.hpp"
+#include "AST/VariableDeclarationNode.hpp"
+#include "AST/WhileStatementNode.hpp"
+#include "Runtime/AotRuntime.hpp"
+
+namespace o2l {
+
+namespace {
+
+// How a compiled expression or local is represented in C++
+enum class Kind { Value, Int, Long, Float, Double, Bool, Text };
+
+// The C++ type of a kind, which is also the name of the O²L type
+const char* kindName(Kind kind) {
+    switch (kind) {
+        case Kind::Int:
+            return "Int";
+        case Kind::Long:
+            return "Long";
+        case Kind::Float:
+            return "Float";
+        case Kind::Double:
+            return "Double";
+        case Kind::Bool:
+            return "Bool";
+        case Kind::Text:
+            return "Text";
+        case Kind::Value:
+            break;
+    }
+    return "Value";
+}
+
+Kind kindFromType(const std::string& type) {
+    for (Kind kind : {Kind::Int, Kind::Long, Kind::Float, Kind::Double, Kind::Bool, Kind::Text}) {
+        if (type == kindName(kind)) {
+            return kind;
+        }
+    }
+    return Kind::Value;
+}
+
+bool isNumeric(Kind kind) {
+    return kind == Kind::Int || kind == Kind::Long || kind == Kind::Float || kind == Kind::Double;
+}
+
+// Names are used in C++ identifiers
+bool isPlainName(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    for (unsigned char c : name) {
+        if (!std::isalnum(c) && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A C++ string literal with the bytes of `text`
+std::string cppString(const std::string& text) {
+    std::string literal = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += static_cast<char>(c);
+        } else if (c >= 0x20 && c < 0x7F && c != '?') {
+            literal += static_cast<char>(c);
+        } else {
+            char escaped[5];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+            literal += escaped;
+        }
+    }
+    return literal + "\"";
+}
+
+std::string hexFloat(double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    return buffer;
+}
+
+bool fitsInt(Long value) {
+    return value >= std::numeric_limits<Int>::min() && value <= std::numeric_limits<Int>::max();
+}
+
+// Literals with a typed C++ form
+Kind literalKind(const Value& value) {
+    if (std::holds_alternative<Int>(value)) return Kind::Int;
+    if (std::holds_alternative<Float>(value)) return Kind::Float;
+    if (std::holds_alternative<Double>(value)) return Kind::Double;
+    if (std::holds_alternative<Bool>(value)) return Kind::Bool;
+    if (std::holds_alternative<Text>(value)) return Kind::Text;
+    if (auto number = std::get_if<Long>(&value); number && fitsInt(*number)) return Kind::Long;
+    return Kind::Value;
+}
+
+struct MethodPlan {
+    std::string object;
+    size_t object_index = 0;
+    const MethodDeclarationNode* declaration = nullptr;
+    std::string suffix;  // <index>_<Object>_<method>, unique in the program
+
+    bool compiled = false;
+    std::string reason;
+
+    std::vector<ASTNode*> nodes;  // AotProgram::flatten order
+    std::unordered_map<const ASTNode*, size_t> ids;
+    std::set<std::string> locals;  // parameters and declared variables
+    std::map<std::string, std::set<std::string>> declared_types;
+    std::vector<const VariableDeclarationNode*> declarations;
+    std::vector<const VariableAssignmentNode*> assignments;  // to locals
+    std::vector<const ReturnNode*> returns;
+    bool ends_with_return = false;
+    bool needs_scope = false;
+
+    std::map<std::string, Kind> kinds;
+    Kind return_kind = Kind::Value;
+};
+
+// The methods of one object, by name
+using ObjectPlans = std::map<std::string, MethodPlan*>;
+
+// Checks that a method body can be translated and collects its locals
+class MethodAnalyzer {
+   public:
+    explicit MethodAnalyzer(MethodPlan& plan) : plan_(plan) {}
+
+    bool run() {
+        const MethodDeclarationNode& method = *plan_.declaration;
+        for (const auto& parameter : method.getParameters()) {
+            if (!isPlainName(parameter.name)) {
+                return reject("parameter name '" + parameter.name + "'");
+            }
+            plan_.locals.insert(parameter.name);
+            plan_.declared_types[parameter.name].insert(parameter.type);
+            visible_.insert(parameter.name);
+        }
+        const ASTNode* body = method.getBody().get();
+        if (!body) {
+            return reject("has no body");
+        }
+        if (!collectLocals(body) || !statement(body)) {
+            return false;
+        }
+
+        const ASTNode* last = body;
+        if (auto block = dynamic_cast<const BlockNode*>(body)) {
+            last = block->getStatements().empty() ? nullptr : block->getStatements().back().get();
+        }
+        if (dynamic_cast<const IfStatementNode*>(last) ||
+            dynamic_cast<const WhileStatementNode*>(last)) {
+            return reject("may end without a return after its last if or while");
+        }
+        plan_.ends_with_return = dynamic_cast<const ReturnNode*>(last) != nullptr;
+        return true;
+    }
+
+   private:
+    bool reject(const std::string& reason) {
+        if (plan_.reason.empty()) {
+            plan_.reason = reason;
+        }
+        return false;
+    }
+
+    // Variables declared by the statements that are compiled (not by interpreted ones)
+    bool collectLocals(const ASTNode* node) {
+        if (auto block = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& statement : block->getStatements()) {
+                if (!collectLocals(statement.get())) {
+                    return false;
+                }
+            }
+        } else if (auto if_node = dynamic_cast<const IfStatementNode*>(node)) {
+            return collectLocals(if_node->getThenBranch().get()) &&
+                   (!if_node->getElseBranch() || collectLocals(if_node->getElseBranch().get()));
+        } else if (auto while_node = dynamic_cast<const WhileStatementNode*>(node)) {
+            return collectLocals(while_node->getBody().get());
+        } else if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(node)) {
+            if (!isPlainName(declaration->getVariableName())) {
+                return reject("variable name '" + declaration->getVariableName() + "'");
+            }
+            plan_.locals.insert(declaration->getVariableName());
+            plan_.declared_types[declaration->getVariableName()].insert(
+                declaration->getTypeName());
+        }
+        return true;
+    }
+
+    // Declarations in a branch or loop body are only known to be visible inside it
+    template <typename Body>
+    bool scoped(Body body) {
+        std::set<std::string> saved = visible_;
+        bool ok = body();
+        visible_ = std::move(saved);
+        return ok;
+    }
+
+    bool statement(const ASTNode* node) {
+        if (!node) {
+            return true;
+        }
+        if (auto block = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& child : block->getStatements()) {
+                if (!statement(child.get())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(node)) {
+            if (!expression(declaration->getInitializer().get())) {
+                return false;
+            }
+            plan_.declarations.push_back(declaration);
+            visible_.insert(declaration->getVariableName());
+            return true;
+        }
+        if (auto assignment = dynamic_cast<const VariableAssignmentNode*>(node)) {
+            const std::string& name = assignment->getVariableName();
+            if (!plan_.locals.count(name)) {
+                return interpreted(node);
+            }
+            if (!visible_.count(name)) {
+                return reject("assigns '" + name + "' before declaring it");
+            }
+            plan_.assignments.push_back(assignment);
+            return expression(assignment->getValueExpressionPtr().get());
+        }
+        if (auto if_node = dynamic_cast<const IfStatementNode*>(node)) {
+            return expression(if_node->getCondition().get()) &&
+                   scoped([&]() { return statement(if_node->getThenBranch().get()); }) &&
+                   scoped([&]() { return statement(if_node->getElseBranch().get()); });
+        }
+        if (auto while_node = dynamic_cast<const WhileStatementNode*>(node)) {
+            if (!expression(while_node->getCondition().get())) {
+                return false;
+            }
+            ++loop_depth_;
+            bool ok = scoped([&]() { return statement(while_node->getBody().get()); });
+            --loop_depth_;
+            return ok;
+        }
+        if (dynamic_cast<const BreakNode*>(node) || dynamic_cast<const ContinueNode*>(node)) {
+            return loop_depth_ > 0 || reject("break or continue outside a loop");
+        }
+        if (auto return_node = dynamic_cast<const ReturnNode*>(node)) {
+            plan_.returns.push_back(return_node);
+            return !return_node->getExpression() ||
+                   expression(return_node->getExpression().get());
+        }
+        return expression(node);
+    }
+
+    bool expression(const ASTNode* node) {
+        if (!node) {
+            return reject("has an empty expression");
+        }
+        if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+            const std::string& name = identifier->getName();
+            if (plan_.locals.count(name) && !visible_.count(name)) {
+                return reject("reads '" + name + "' before declaring it");
+            }
+            return true;
+        }
+        if (dynamic_cast<const LiteralNode*>(node) || dynamic_cast<const ThisNode*>(node)) {
+            return true;
+        }
+        if (dynamic_cast<const BinaryOpNode*>(node) || dynamic_cast<const ComparisonNode*>(node) ||
+            dynamic_cast<const LogicalNode*>(node) || dynamic_cast<const UnaryNode*>(node) ||
+            dynamic_cast<const MethodCallNode*>(node) ||
+            dynamic_cast<const PropertyAssignmentNode*>(node) ||
+            dynamic_cast<const NewExpressionNode*>(node)) {
+            std::vector<ASTNode*> operands;
+            AotProgram::children(node, operands);
+            for (const ASTNode* operand : operands) {
+                if (!expression(operand)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return interpreted(node);
+    }
+
+    // Anything else is left to the interpreter, which must not need the compiled locals
+    bool interpreted(const ASTNode* node) {
+        std::vector<const ASTNode*> pending{node};
+        while (!pending.empty()) {
+            const ASTNode* current = pending.back();
+            pending.pop_back();
+
+            std::string name;
+            bool defines = false;
+            if (auto identifier = dynamic_cast<const IdentifierNode*>(current)) {
+                name = identifier->getName();
+            } else if (auto assignment = dynamic_cast<const VariableAssignmentNode*>(current)) {
+                name = assignment->getVariableName();
+            } else if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(current)) {
+                name = declaration->getVariableName();
+                defines = true;
+            } else if (auto constant = dynamic_cast<const ConstDeclarationNode*>(current)) {
+                name = constant->getConstName();
+                defines = true;
+            } else if (auto try_node = dynamic_cast<const TryCatchFinallyNode*>(current)) {
+                name = try_node->getCatchVariable();
+                defines = true;
+            } else if (dynamic_cast<const ReturnNode*>(current) ||
+                       dynamic_cast<const BreakNode*>(current) ||
+                       dynamic_cast<const ContinueNode*>(current)) {
+                return reject("returns, breaks or continues from " + describe(node));
+            }
+            if (plan_.locals.count(name)) {
+                return reject("uses '" + name + "' in " + describe(node));
+            }
+            plan_.needs_scope = plan_.needs_scope || defines;
+
+            std::vector<ASTNode*> operands;
+            if (!AotProgram::children(current, operands)) {
+                return reject("uses " + describe(current));
+            }
+            pending.insert(pending.end(), operands.begin(), operands.end());
+        }
+        return true;
+    }
+
+    static std::string describe(const ASTNode* node) {
+        std::string text = node->toString();
+        return text.size() > 40 ? text.substr(0, 37) + "..." : text;
+    }
+
+    MethodPlan& plan_;
+    std::set<std::string> visible_;
+    int loop_depth_ = 0;
+};
+
+// Expression kinds, given the kinds of locals and of the object's compiled methods
+class KindInference {
+   public:
+    KindInference(const MethodPlan& plan, const ObjectPlans& methods)
+        : plan_(plan), methods_(methods) {}
+
+    Kind of(const ASTNode* node) const {
+        if (auto literal = dynamic_cast<const LiteralNode*>(node)) {
+            return literalKind(literal->getValue());
+        }
+        if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+            auto local = plan_.kinds.find(identifier->getName());
+            return local == plan_.kinds.end() ? Kind::Value : local->second;
+        }
+        if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+            Kind left = of(binary->getLeft().get());
+            Kind right = of(binary->getRight().get());
+            if (left == right && isNumeric(left)) {
+                return left;
+            }
+            bool concatenation = binary->getOperator() == BinaryOperator::PLUS;
+            return left == Kind::Text && right == Kind::Text && concatenation ? Kind::Text
+                                                                              : Kind::Value;
+        }
+        if (auto comparison = dynamic_cast<const ComparisonNode*>(node)) {
+            Kind left = of(comparison->getLeft().get());
+            Kind right = of(comparison->getRight().get());
+            bool equality = comparison->getOperator() == ComparisonOperator::EQUAL ||
+                            comparison->getOperator() == ComparisonOperator::NOT_EQUAL;
+            if (left == right && (isNumeric(left) || (left == Kind::Bool && equality))) {
+                return Kind::Bool;
+            }
+            return Kind::Value;
+        }
+        if (dynamic_cast<const LogicalNode*>(node)) {
+            return Kind::Bool;
+        }
+        if (auto unary = dynamic_cast<const UnaryNode*>(node)) {
+            Kind operand = of(unary->getOperand().get());
+            if (unary->getOperator() == UnaryOperator::NOT) {
+                return operand == Kind::Bool ? Kind::Bool : Kind::Value;
+            }
+            return isNumeric(operand) ? operand : Kind::Value;
+        }
+        if (auto call = dynamic_cast<const MethodCallNode*>(node)) {
+            const MethodPlan* callee = directCallee(call);
+            return callee ? callee->return_kind : Kind::Value;
+        }
+        return Kind::Value;
+    }
+
+    // The compiled method a `this.method()` call can call directly
+    const MethodPlan* directCallee(const MethodCallNode* call) const {
+        if (!dynamic_cast<const ThisNode*>(call->getObject().get())) {
+            return nullptr;
+        }
+        auto found = methods_.find(call->getMethodName());
+        if (found == methods_.end() || !found->second->compiled) {
+            return nullptr;
+        }
+        const MethodPlan& callee = *found->second;
+        const auto& parameters = callee.declaration->getParameters();
+        if (parameters.size() != call->getArguments().size()) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            Kind expected = callee.kinds.at(parameters[i].name);
+            if (expected != Kind::Value && of(call->getArguments()[i].get()) != expected) {
+                return nullptr;
+            }
+        }
+        return &callee;
+    }
+
+   private:
+    const MethodPlan& plan_;
+    const ObjectPlans& methods_;
+};
+
+// Settles the kinds of the locals and returns of an object's compiled methods: a local keeps
+// its declared type only if everything stored in it statically has that type
+void inferKinds(const ObjectPlans& methods) {
+    for (const auto& [name, plan] : methods) {
+        if (!plan->compiled) {
+            continue;
+        }
+        for (const auto& [local, types] : plan->declared_types) {
+            plan->kinds[local] = types.size() == 1 ? kindFromType(*types.begin()) : Kind::Value;
+        }
+        plan->return_kind = plan->ends_with_return
+                                ? kindFromType(plan->declaration->getReturnType())
+                                : Kind::Value;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        auto demote = [&](Kind& kind) {
+            kind = Kind::Value;
+            changed = true;
+        };
+        for (const auto& [name, plan] : methods) {
+            if (!plan->compiled) {
+                continue;
+            }
+            KindInference kinds(*plan, methods);
+            for (const VariableDeclarationNode* declaration : plan->declarations) {
+                Kind& declared = plan->kinds[declaration->getVariableName()];
+                Kind actual = kinds.of(declaration->getInitializer().get());
+                // Dynamically typed Int, Bool and Text values are checked on declaration;
+                // the runtime stores the other types unconverted, so those stay Values
+                bool checked = actual == Kind::Value && (declared == Kind::Int ||
+                                                         declared == Kind::Bool ||
+                                                         declared == Kind::Text);
+                if (declared != Kind::Value && actual != declared && !checked) {
+                    demote(declared);
+                }
+            }
+            for (const VariableAssignmentNode* assignment : plan->assignments) {
+                Kind& declared = plan->kinds[assignment->getVariableName()];
+                if (declared != Kind::Value &&
+                    kinds.of(assignment->getValueExpressionPtr().get()) != declared) {
+                    demote(declared);
+                }
+            }
+            for (const ReturnNode* return_node : plan->returns) {
+                Kind actual = return_node->getExpression()
+                                  ? kinds.of(return_node->getExpression().get())
+                                  : Kind::Int;
+                if (plan->return_kind != Kind::Value && actual != plan->return_kind) {
+                    demote(plan->return_kind);
+                }
+            }
+        }
+    }
+}
+
+// Writes the C++ function of one compiled method
+class MethodEmitter {
+   public:
+    MethodEmitter(const MethodPlan& plan, const ObjectPlans& methods)
+        : plan_(plan), kinds_(plan, methods) {}
+
+    static std::string functionName(const MethodPlan& plan) {
+        return "m" + plan.suffix;
+    }
+    static std::string nodesName(const MethodPlan& plan) {
+        return "nodes" + plan.suffix;
+    }
+
+    static std::string signature(const MethodPlan& plan) {
+        std::string text = std::string(kindName(plan.return_kind)) + " " + functionName(plan) +
+                           "(Context& ctx";
+        for (const auto& parameter : plan.declaration->getParameters()) {
+            text += std::string(", ") + kindName(plan.kinds.at(parameter.name)) + " v_" +
+                    parameter.name;
+        }
+        return text + ")";
+    }
+
+    std::string emit() {
+        indent_ = 1;
+        const ASTNode* body = plan_.declaration->getBody().get();
+        std::vector<const ASTNode*> statements;
+        if (auto block = dynamic_cast<const BlockNode*>(body)) {
+            for (const auto& statement : block->getStatements()) {
+                statements.push_back(statement.get());
+            }
+        } else {
+            statements.push_back(body);
+        }
+        for (size_t i = 0; i < statements.size(); ++i) {
+            if (i + 1 == statements.size() && !plan_.ends_with_return) {
+                completion(statements[i]);
+            } else {
+                statement(statements[i]);
+            }
+        }
+        if (statements.empty()) {
+            line("return Value(Int(0));");
+        }
+
+        std::string header;
+        auto add = [&](const std::string& text) { header += "    " + text + "\n"; };
+        add("ctx.checkCancellation();");
+        if (plan_.needs_scope) {
+            add("AotScope scope(ctx);");
+        }
+        if (uses_nodes_) {
+            add("const std::vector<ASTNode*>& n = *" + nodesName(plan_) + ";");
+        }
+        for (size_t id : sites_) {
+            add("static thread_local AotSite s" + std::to_string(id) + "(n[" +
+                std::to_string(id) + "]);");
+        }
+        std::set<std::string> parameters;
+        for (const auto& parameter : plan_.declaration->getParameters()) {
+            parameters.insert(parameter.name);
+        }
+        for (const auto& [name, kind] : plan_.kinds) {
+            if (!parameters.count(name)) {
+                add(std::string(kindName(kind)) + " v_" + name + "{};");
+            }
+        }
+        return signature(plan_) + " {\n" + header + body_ + "}\n";
+    }
+
+   private:
+    void line(const std::string& text) {
+        body_ += std::string(indent_ * 4, ' ') + text + "\n";
+    }
+
+    // Evaluates `code` once, here, so later side effects cannot reorder it
+    std::string temp(Kind kind, const std::string& code) {
+        std::string name = "t" + std::to_string(temps_++);
+        line(std::string("const ") + kindName(kind) + " " + name + " = " + code + ";");
+        return name;
+    }
+
+    std::string node(const ASTNode* node) {
+        uses_nodes_ = true;
+        return "n[" + std::to_string(plan_.ids.at(node)) + "]";
+    }
+
+    std::string site(const ASTNode* node) {
+        uses_nodes_ = true;
+        size_t id = plan_.ids.at(node);
+        sites_.insert(id);
+        return "s" + std::to_string(id);
+    }
+
+    std::string interpreted(const ASTNode* original) {
+        return temp(Kind::Value, node(original) + "->evaluate(ctx)");
+    }
+
+    static std::string box(const std::string& code, Kind kind) {
+        return kind == Kind::Value ? code : "Value(" + code + ")";
+    }
+
+    // Applies the operation of `original` to its operands through an AotSite; operands that
+    // need statements of their own become named lambdas
+    std::string dynamic(const ASTNode* original) {
+        std::vector<ASTNode*> operands;
+        AotProgram::children(original, operands);
+        std::string values;
+        for (const ASTNode* operand : operands) {
+            std::string outer = std::move(body_);
+            body_.clear();
+            ++indent_;
+            Kind kind;
+            std::string code = box(expression(operand, kind), kind);
+            --indent_;
+            std::string prelude = std::move(body_);
+            body_ = std::move(outer);
+
+            std::string value;
+            if (prelude.empty()) {
+                value = "[&]() -> Value { return " + code + "; }";
+            } else {
+                value = "o" + std::to_string(temps_++);
+                line("auto " + value + " = [&]() -> Value {");
+                body_ += prelude;
+                line("    return " + code + ";");
+                line("};");
+            }
+            values += (values.empty() ? "" : ", ") + value;
+        }
+        return temp(Kind::Value, site(original) + ".evaluate(ctx, {" + values + "})");
+    }
+
+    std::string literal(const LiteralNode* literal, Kind kind) {
+        const Value& value = literal->getValue();
+        switch (kind) {
+            case Kind::Int: {
+                Int number = std::get<Int>(value);
+                if (number == std::numeric_limits<Int>::min()) {
+                    return "Int(-9223372036854775807LL - 1)";
+                }
+                return "Int(" + std::to_string(number) + "LL)";
+            }
+            case Kind::Long: {
+                Int number = static_cast<Int>(std::get<Long>(value));
+                if (number == std::numeric_limits<Int>::min()) {
+                    return "Long(-9223372036854775807LL - 1)";
+                }
+                return "Long(" + std::to_string(number) + "LL)";
+            }
+            case Kind::Float:
+                return "Float(" + hexFloat(std::get<Float>(value)) + "f)";
+            case Kind::Double:
+                return "Double(" + hexFloat(std::get<Double>(value)) + ")";
+            case Kind::Bool:
+                return std::get<Bool>(value) ? "true" : "false";
+            case Kind::Text: {
+                const Text& text = std::get<Text>(value);
+                return "Text(" + cppString(text) + ", " + std::to_string(text.size()) + ")";
+            }
+            case Kind::Value:
+                break;
+        }
+        return node(literal) + "->evaluate(ctx)";
+    }
+
+    std::string expression(const ASTNode* original, Kind& kind) {
+        kind = kinds_.of(original);
+        if (auto literal_node = dynamic_cast<const LiteralNode*>(original)) {
+            return literal(literal_node, kind);
+        }
+        if (auto identifier = dynamic_cast<const IdentifierNode*>(original)) {
+            if (plan_.kinds.count(identifier->getName())) {
+                return "v_" + identifier->getName();
+            }
+            return interpreted(original);
+        }
+        if (auto binary = dynamic_cast<const BinaryOpNode*>(original)) {
+            if (kind == Kind::Value) {
+                return dynamic(original);
+            }
+            Kind operand;
+            std::string left = expression(binary->getLeft().get(), operand);
+            std::string right = expression(binary->getRight().get(), operand);
+            switch (binary->getOperator()) {
+                case BinaryOperator::PLUS:
+                    return "(" + left + " + " + right + ")";
+                case BinaryOperator::MINUS:
+                    return "(" + left + " - " + right + ")";
+                case BinaryOperator::MULTIPLY:
+                    return "(" + left + " * " + right + ")";
+                case BinaryOperator::DIVIDE:
+                    return temp(kind, "aotDivide(" + left + ", " + right + ", " + node(original) +
+                                          ", ctx)");
+                case BinaryOperator::MODULO:
+                    return temp(kind, "aotModulo(" + left + ", " + right + ", " + node(original) +
+                                          ", ctx)");
+            }
+        }
+        if (auto comparison = dynamic_cast<const ComparisonNode*>(original)) {
+            if (kind == Kind::Value) {
+                return dynamic(original);
+            }
+            Kind operand;
+            std::string left = expression(comparison->getLeft().get(), operand);
+            std::string right = expression(comparison->getRight().get(), operand);
+            return "(" + left + " " + comparisonOperator(comparison->getOperator()) + " " +
+                   right + ")";
+        }
+        if (auto logical = dynamic_cast<const LogicalNode*>(original)) {
+            return logicalExpression(logical);
+        }
+        if (auto unary = dynamic_cast<const UnaryNode*>(original)) {
+            if (kind == Kind::Value) {
+                return dynamic(original);
+            }
+            Kind operand;
+            std::string code = expression(unary->getOperand().get(), operand);
+            return std::string(unary->getOperator() == UnaryOperator::NOT ? "(!" : "(-") + code +
+                   ")";
+        }
+        if (auto call = dynamic_cast<const MethodCallNode*>(original)) {
+            const MethodPlan* callee = kinds_.directCallee(call);
+            if (!callee) {
+                return dynamic(original);
+            }
+            // The call keeps the interpreter's stack frame, around its arguments too
+            std::string result = "t" + std::to_string(temps_++);
+            line(std::string(kindName(kind)) + " " + result + ";");
+            line("{");
+            ++indent_;
+            line("StackFrameGuard frame(ctx, " + cppString(call->getMethodName()) + ", " +
+                 cppString(plan_.object) + ", *" + node(original) + ");");
+            std::string arguments;
+            const auto& parameters = callee->declaration->getParameters();
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                Kind argument;
+                std::string code = expression(call->getArguments()[i].get(), argument);
+                if (callee->kinds.at(parameters[i].name) == Kind::Value) {
+                    code = box(code, argument);
+                }
+                arguments += ", " + code;
+            }
+            line(result + " = " + functionName(*callee) + "(ctx" + arguments + ");");
+            --indent_;
+            line("}");
+            return result;
+        }
+        if (dynamic_cast<const PropertyAssignmentNode*>(original) ||
+            dynamic_cast<const NewExpressionNode*>(original)) {
+            return dynamic(original);
+        }
+        return interpreted(original);
+    }
+
+    static const char* comparisonOperator(ComparisonOperator op) {
+        switch (op) {
+            case ComparisonOperator::EQUAL:
+                return "==";
+            case ComparisonOperator::NOT_EQUAL:
+                return "!=";
+            case ComparisonOperator::LESS_THAN:
+                return "<";
+            case ComparisonOperator::LESS_EQUAL:
+                return "<=";
+            case ComparisonOperator::GREATER_THAN:
+                return ">";
+            case ComparisonOperator::GREATER_EQUAL:
+                break;
+        }
+        return ">=";
+    }
+
+    std::string boolOperand(const std::string& code, Kind kind, const std::string& message) {
+        if (kind == Kind::Bool) {
+            return code;
+        }
+        return "aotLogicalOperand(" + box(code, kind) + ", " + cppString(message) + ", ctx)";
+    }
+
+    // Short-circuits like the interpreter, evaluating the right operand only when needed
+    std::string logicalExpression(const LogicalNode* logical) {
+        bool is_and = logical->getOperator() == LogicalOperator::AND;
+        Kind kind;
+        std::string left = expression(logical->getLeft().get(), kind);
+        left = boolOperand(left, kind, "Left operand of logical operator must be a Bool");
+
+        std::string outer = std::move(body_);
+        body_.clear();
+        ++indent_;
+        std::string right = expression(logical->getRight().get(), kind);
+        right = boolOperand(right, kind,
+                            is_and ? "Right operand of logical AND must be a Bool"
+                                   : "Right operand of logical OR must be a Bool");
+        --indent_;
+        std::string right_prelude = std::move(body_);
+        body_ = std::move(outer);
+
+        if (right_prelude.empty()) {
+            return "(" + left + (is_and ? " && " : " || ") + right + ")";
+        }
+        std::string name = "t" + std::to_string(temps_++);
+        line("Bool " + name + " = " + left + ";");
+        line(std::string("if (") + (is_and ? "" : "!") + name + ") {");
+        body_ += right_prelude;
+        line("    " + name + " = " + right + ";");
+        line("}");
+        return name;
+    }
+
+    static std::string condition(const std::string& code, Kind kind) {
+        return kind == Kind::Bool ? code : "aotTruthy(" + box(code, kind) + ")";
+    }
+
+    void statement(const ASTNode* original) {
+        if (auto block = dynamic_cast<const BlockNode*>(original)) {
+            for (const auto& child : block->getStatements()) {
+                statement(child.get());
+            }
+            return;
+        }
+        if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(original)) {
+            declare(declaration);
+            return;
+        }
+        if (auto assignment = dynamic_cast<const VariableAssignmentNode*>(original)) {
+            auto local = plan_.kinds.find(assignment->getVariableName());
+            if (local == plan_.kinds.end()) {
+                line(node(original) + "->evaluate(ctx);");
+                return;
+            }
+            Kind kind;
+            std::string code = expression(assignment->getValueExpressionPtr().get(), kind);
+            line("v_" + local->first + " = " +
+                 (local->second == Kind::Value ? box(code, kind) : code) + ";");
+            return;
+        }
+        if (auto if_node = dynamic_cast<const IfStatementNode*>(original)) {
+            Kind kind;
+            std::string code = expression(if_node->getCondition().get(), kind);
+            line("if (" + condition(code, kind) + ") {");
+            nested(if_node->getThenBranch().get());
+            if (if_node->getElseBranch()) {
+                line("} else {");
+                nested(if_node->getElseBranch().get());
+            }
+            line("}");
+            return;
+        }
+        if (auto while_node = dynamic_cast<const WhileStatementNode*>(original)) {
+            line("while (true) {");
+            ++indent_;
+            line("ctx.checkCancellation();");
+            Kind kind;
+            std::string code = expression(while_node->getCondition().get(), kind);
+            line("if (!" +
+                 (kind == Kind::Bool ? code : "aotLoopCondition(" + box(code, kind) + ")") +
+                 ") {");
+            line("    break;");
+            line("}");
+            statement(while_node->getBody().get());
+            --indent_;
+            line("}");
+            return;
+        }
+        if (dynamic_cast<const BreakNode*>(original)) {
+            line("break;");
+            return;
+        }
+        if (dynamic_cast<const ContinueNode*>(original)) {
+            line("continue;");
+            return;
+        }
+        if (auto return_node = dynamic_cast<const ReturnNode*>(original)) {
+            Kind kind = Kind::Int;
+            std::string code = "Int(0)";
+            if (return_node->getExpression()) {
+                code = expression(return_node->getExpression().get(), kind);
+            }
+            line("return " + (plan_.return_kind == Kind::Value ? box(code, kind) : code) + ";");
+            return;
+        }
+        Kind kind;
+        expression(original, kind);
+    }
+
+    void nested(const ASTNode* original) {
+        ++indent_;
+        statement(original);
+        --indent_;
+    }
+
+    void declare(const VariableDeclarationNode* declaration) {
+        const std::string& name = declaration->getVariableName();
+        const std::string& type = declaration->getTypeName();
+        Kind declared = plan_.kinds.at(name);
+        Kind kind;
+        std::string code = expression(declaration->getInitializer().get(), kind);
+        if (declared != Kind::Value) {
+            if (kind == Kind::Value) {
+                code = std::string("aotUnbox<") + kindName(declared) + ">(" + code + ", " +
+                       cppString(name) + ", " + cppString(type) + ", ctx)";
+            }
+            line("v_" + name + " = " + code + ";");
+            return;
+        }
+        line("v_" + name + " = " + box(code, kind) + ";");
+        // The runtime checks primitive and List declarations; a typed initializer of exactly
+        // the declared type needs no check
+        bool checked = kindFromType(type) != Kind::Value || type == "Char" ||
+                       type.rfind("List<", 0) == 0;
+        if (checked && !(kind != Kind::Value && type == kindName(kind))) {
+            line("aotCheckDeclaration(" + node(declaration) + ", v_" + name + ", ctx);");
+        }
+    }
+
+    // The last statement of a method that does not end with return gives its result
+    void completion(const ASTNode* original) {
+        if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(original)) {
+            declare(declaration);
+            line("return " + box("v_" + declaration->getVariableName(),
+                                 plan_.kinds.at(declaration->getVariableName())) +
+                 ";");
+            return;
+        }
+        if (auto assignment = dynamic_cast<const VariableAssignmentNode*>(original)) {
+            auto local = plan_.kinds.find(assignment->getVariableName());
+            if (local != plan_.kinds.end()) {
+                statement(original);
+                line("return " + box("v_" + local->first, local->second) + ";");
+                return;
+            }
+            line("return " + node(original) + "->evaluate(ctx);");
+            return;
+        }
+        if (dynamic_cast<const BlockNode*>(original) || dynamic_cast<const BreakNode*>(original) ||
+            dynamic_cast<const ContinueNode*>(original)) {
+            statement(original);
+            line("return Value(Int(0));");
+            return;
+        }
+        Kind kind;
+        std::string code = expression(original, kind);
+        line("return " + box(code, kind) + ";");
+    }
+
+    const MethodPlan& plan_;
+    KindInference kinds_;
+    std::string body_;
+    int indent_ = 1;
+    size_t temps_ = 0;
+    bool uses_nodes_ = false;
+    std::set<size_t> sites_;
+};
+
+// The native entry point: type guards on the arguments, then the compiled function
+std::string entryFunction(const MethodPlan& plan) {
+    const auto& parameters = plan.declaration->getParameters();
+    std::string guard = "args.size() != " + std::to_string(parameters.size());
+    std::string arguments;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        Kind kind = plan.kinds.at(parameters[i].name);
+        std::string arg = "args[" + std::to_string(i) + "]";
+        if (kind == Kind::Value) {
+            arguments += ", " + arg;
+        } else {
+            guard += std::string(" || !std::holds_alternative<") + kindName(kind) + ">(" + arg +
+                     ")";
+            arguments += std::string(", std::get<") + kindName(kind) + ">(" + arg + ")";
+        }
+    }
+    std::string call = MethodEmitter::functionName(plan) + "(ctx" + arguments + ")";
+    return "Value e" + plan.suffix +
+           "(const std::vector<Value>& args, Context& ctx, const Method& interpreted) {\n"
+           "    if (" +
+           guard +
+           ") {\n"
+           "        return interpreted(args, ctx);\n"
+           "    }\n"
+           "    return " +
+           (plan.return_kind == Kind::Value ? call : "Value(" + call + ")") + ";\n}\n";
+}
+
+std::string methodTitle(const MethodPlan& plan) {
+    std::string title = plan.object + "." + plan.declaration->getName() + "(";
+    const auto& parameters = plan.declaration->getParameters();
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        title += (i ? ", " : "") + parameters[i].name + ": " + parameters[i].type;
+    }
+    return title + "): " + plan.declaration->getReturnType();
+}
+
+std::string cmakeString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\' || c == '$') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string shellQuote(const std::string& text) {
+#ifdef _WIN32
+    return "\"" + text + "\"";
+#else
+    std::string quoted = "'";
+    for (char c : text) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+#endif
+}
+
+// Where this build of o2l keeps what generated programs link against
+std::string aotSetting(const char* environment, const char* built_in) {
+    const char* value = std::getenv(environment);
+    return value && *value ? value : built_in;
+}
+
+#ifndef O2L_AOT_CONFIG
+#define O2L_AOT_CONFIG ""
+#endif
+#ifndef O2L_AOT_CMAKE
+#define O2L_AOT_CMAKE "cmake"
+#endif
+#ifndef O2L_AOT_CXX_COMPILER
+#define O2L_AOT_CXX_COMPILER ""
+#endif
+
+}  // namespace
+
+std::string AotCompiler::generate(const std::vector<ASTNodePtr>& nodes,
+                                  const std::string& filename, const std::string& source) {
+    report_.clear();
+
+    std::map<std::string, int> object_counts;
+    for (const auto& node : nodes) {
+        if (auto object = dynamic_cast<const ObjectNode*>(node.get())) {
+            ++object_counts[object->getName()];
+        }
+    }
+
+    std::vector<std::unique_ptr<MethodPlan>> plans;
+    std::vector<ObjectPlans> objects;
+    for (const auto& node : nodes) {
+        auto object = dynamic_cast<const ObjectNode*>(node.get());
+        if (!object) {
+            continue;
+        }
+        std::map<std::string, int> method_counts;
+        for (const auto& method : object->getMethods()) {
+            if (auto declaration = dynamic_cast<const MethodDeclarationNode*>(method.get())) {
+                ++method_counts[declaration->getName()];
+            }
+        }
+
+        ObjectPlans methods;
+        for (const auto& method : object->getMethods()) {
+            auto declaration = dynamic_cast<const MethodDeclarationNode*>(method.get());
+            if (!declaration) {
+                continue;
+            }
+            auto plan = std::make_unique<MethodPlan>();
+            plan->object = object->getName();
+            plan->object_index = objects.size();
+            plan->declaration = declaration;
+            plan->suffix = std::to_string(plans.size()) + "_" + object->getName() + "_" +
+                           declaration->getName();
+            if (object_counts[object->getName()] > 1) {
+                plan->reason = "its object is declared more than once";
+            } else if (method_counts[declaration->getName()] > 1) {
+                plan->reason = "it is declared more than once";
+            } else if (!isPlainName(object->getName()) || !isPlainName(declaration->getName())) {
+                plan->reason = "its name cannot be used in C++";
+            } else {
+                plan->compiled = MethodAnalyzer(*plan).run();
+            }
+            if (plan->compiled) {
+                methods[declaration->getName()] = plan.get();
+                plan->nodes = AotProgram::flatten(declaration->getBody().get());
+                for (size_t i = 0; i < plan->nodes.size(); ++i) {
+                    plan->ids.emplace(plan->nodes[i], i);
+                }
+            }
+            plans.push_back(std::move(plan));
+        }
+        inferKinds(methods);
+        objects.push_back(std::move(methods));
+    }
+
+    std::ostringstream out;
+    size_t compiled = 0;
+    for (const auto& plan : plans) {
+        report_.push_back(MethodReport{plan->object, plan->declaration->getName(),
+                                       plan->compiled, plan->reason});
+        compiled += plan->compiled ? 1 : 0;
+    }
+
+    std::filesystem::path source_path = std::filesystem::absolute(filename);
+    out << "// Generated by `o2l build --aot` from " << filename << "; do not edit.\n";
+    out << "// " << compiled << " of " << plans.size()
+        << " methods are compiled; the others run in the embedded interpreter.\n\n";
+    out << "#include <string>\n#include <vector>\n\n#include \"Runtime/AotRuntime.hpp\"\n\n";
+    out << "using namespace o2l;\n\nnamespace {\n\n";
+
+    out << "const char kSource[] =";
+    std::istringstream lines(source);
+    std::string source_line;
+    bool any_line = false;
+    while (std::getline(lines, source_line)) {
+        out << "\n    " << cppString(source_line + "\n");
+        any_line = true;
+    }
+    out << (any_line ? ";\n\n" : " \"\";\n\n");
+
+    for (const auto& plan : plans) {
+        if (plan->compiled) {
+            out << "const std::vector<ASTNode*>* " << MethodEmitter::nodesName(*plan)
+                << " = nullptr;\n";
+        }
+    }
+    out << "\n";
+    for (const auto& plan : plans) {
+        if (plan->compiled) {
+            out << MethodEmitter::signature(*plan) << ";\n";
+        }
+    }
+
+    for (const auto& plan : plans) {
+        if (plan->compiled) {
+            const ObjectPlans& methods = objects[plan->object_index];
+            out << "\n// " << methodTitle(*plan) << "\n";
+            out << MethodEmitter(*plan, methods).emit();
+            out << "\n" << entryFunction(*plan);
+        }
+    }
+
+    out << "\n}  // namespace\n\nint main(int argc, char* argv[]) {\n";
+    out << "    AotProgram program(" << cppString(filename)
+        << ", std::string(kSource, sizeof(kSource) - 1),\n                       "
+        << cppString(source_path.parent_path().string()) << ");\n";
+    for (const auto& plan : plans) {
+        if (plan->compiled) {
+            out << "    program.method(" << cppString(plan->object) << ", "
+                << cppString(plan->declaration->getName()) << ", &"
+                << MethodEmitter::nodesName(*plan) << ", e" << plan->suffix << ");\n";
+        }
+    }
+    out << "    return program.run(argc, argv);\n}\n";
+    return out.str();
+}
+
+void AotCompiler::build(const std::vector<ASTNodePtr>& nodes, const std::string& filename,
+                        const std::string& source, const std::filesystem::path& output) {
+    std::string config = aotSetting("O2L_AOT_CONFIG", O2L_AOT_CONFIG);
+    if (config.empty() || !std::filesystem::exists(config)) {
+        throw std::runtime_error(
+            "AOT builds need the o2l build tree's o2l-aot.cmake; set O2L_AOT_CONFIG to it");
+    }
+
+    std::filesystem::path target = std::filesystem::absolute(output);
+    std::filesystem::path project = target;
+    project += ".aot";
+    std::filesystem::create_directories(project);
+
+    std::ofstream(project / "main.cpp") << generate(nodes, filename, source);
+    std::ofstream cmake(project / "CMakeLists.txt");
+    cmake << "# Generated by `o2l build --aot`; do not edit.\n"
+          << "cmake_minimum_required(VERSION 3.20)\n"
+          << "project(o2l_program LANGUAGES CXX)\n\n"
+          << "set(CMAKE_CXX_STANDARD 23)\n"
+          << "set(CMAKE_CXX_STANDARD_REQUIRED ON)\n\n"
+          << "include(${O2L_AOT_CONFIG})\n\n"
+          << "add_executable(program main.cpp)\n"
+          << "target_link_libraries(program PRIVATE o2l::runtime)\n"
+          << "set_target_properties(program PROPERTIES\n"
+          << "    OUTPUT_NAME " << cmakeString(target.filename().string()) << "\n"
+          << "    RUNTIME_OUTPUT_DIRECTORY " << cmakeString(target.parent_path().generic_string())
+          << "\n)\n";
+    cmake.close();
+
+    std::string cmake_command = shellQuote(aotSetting("O2L_AOT_CMAKE", O2L_AOT_CMAKE));
+    std::string log = (project / "build.log").string();
+    std::string configure = cmake_command + " -S " + shellQuote(project.string()) + " -B " +
+                            shellQuote((project / "build").string()) +
+                            " -DCMAKE_BUILD_TYPE=Release -DO2L_AOT_CONFIG=" +
+                            shellQuote(std::filesystem::path(config).generic_string());
+    std::string compiler = aotSetting("O2L_AOT_CXX_COMPILER", O2L_AOT_CXX_COMPILER);
+    if (!compiler.empty()) {
+        configure += " -DCMAKE_CXX_COMPILER=" + shellQuote(compiler);
+    }
+    std::string compile = cmake_command + " --build " + shellQuote((project / "build").string());
+
+    if (std::system((configure + " > " + shellQuote(log) + " 2>&1").c_str()) != 0 ||
+        std::system((compile + " >> " + shellQuote(log) + " 2>&1").c_str()) != 0) {
+        throw std::runtime_error("Building the generated C++ failed; see " + log);
+    }
+}
+
+}  // namespace o2l
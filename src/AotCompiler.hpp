@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "AST/Node.hpp"
+
+namespace o2l {
+
+/**
+ * Ahead-of-time compiler behind `o2l build --aot`.
+ *
+ * Translates a program into a C++ translation unit that links against libo2l. The program's
+ * source is embedded and declared by the interpreter at startup as usual; each method of a
+ * top-level object becomes a C++ function when its body can be translated, and is bound in
+ * place of the interpreted method:
+ *
+ * - parameters, locals and returns annotated Int, Long, Float, Double, Bool or Text are C++
+ *   variables of that type, as long as every value stored in them has that type statically;
+ *   other locals hold a Value
+ * - operators on typed operands, if/while/break/continue/return and `this.method()` calls
+ *   to other compiled methods are plain C++ (direct calls, no dispatch)
+ * - everything else - calls on other values, property access, `new`, operators on Values -
+ *   is evaluated by the interpreter on operands computed natively (see AotSite)
+ *
+ * A method stays interpreted when it uses a construct that references its locals but has no
+ * compiled form (try/catch, list literals, ...), reads a local before declaring it, or may run
+ * off its end after an if or while. Constructors and imported modules are interpreted.
+ */
+class AotCompiler {
+   public:
+    struct MethodReport {
+        std::string object;
+        std::string method;
+        bool compiled = false;
+        std::string reason;  // why the method stays interpreted
+    };
+
+    // The C++ program for `nodes`, parsed from `source`, the text of `filename`
+    std::string generate(const std::vector<ASTNodePtr>& nodes, const std::string& filename,
+                         const std::string& source);
+
+    // Generates the program and builds it with CMake into the executable `output`, keeping
+    // the generated project in `output`.aot; throws std::runtime_error if the build fails
+    void build(const std::vector<ASTNodePtr>& nodes, const std::string& filename,
+               const std::string& source, const std::filesystem::path& output);
+
+    // What generate() did with each method
+    const std::vector<MethodReport>& getReport() const {
+        return report_;
+    }
+
+   private:
+    std::vector<MethodReport> report_;
+};
+
+}  // namespace o2l
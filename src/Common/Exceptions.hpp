@@ -139,9 +139,11 @@ private:
     Value return_value_;
 
 public:
-    explicit ReturnException(const Value& value) : return_value_(value) {}
+    explicit ReturnException(Value value) : return_value_(std::move(value)) {}
     
     const Value& getValue() const { return return_value_; }
+    // Moves the value out, for the method call that ends the return
+    Value takeValue() { return std::move(return_value_); }
     
     const char* what() const noexcept override {
         return "Return statement executed (not an error)";
@@ -168,6 +170,43 @@ public:
     }
 };
 
+// Raised when a cancellation token ends (deadline passed or cancelled). Like the control
+// flow exceptions it is not an o2lException, so O²L try/catch cannot swallow it and the
+// whole evaluation unwinds to whoever owns the token.
+class ExecutionCancelledError : public std::exception {
+private:
+    bool deadline_exceeded_;
+
+public:
+    explicit ExecutionCancelledError(bool deadline_exceeded)
+        : deadline_exceeded_(deadline_exceeded) {}
+
+    bool isDeadlineExceeded() const { return deadline_exceeded_; }
+
+    const char* what() const noexcept override {
+        return deadline_exceeded_ ? "Execution deadline exceeded" : "Execution cancelled";
+    }
+};
+
+// Thrown when an evaluation runs out of its ExecutionBudget; unwinds like cancellation
+class ExecutionBudgetExceededError : public ExecutionCancelledError {
+private:
+    std::string resource_;
+    std::string message_;
+
+public:
+    ExecutionBudgetExceededError(const std::string& resource, const std::string& limit,
+                                 bool wall_time)
+        : ExecutionCancelledError(wall_time),
+          resource_(resource),
+          message_("Execution budget exceeded: " + resource + " limit of " + limit) {}
+
+    // "step", "wall time", "allocation" or "call depth"
+    const std::string& getResource() const { return resource_; }
+
+    const char* what() const noexcept override { return message_.c_str(); }
+};
+
 // Exception for user-thrown errors via throw statements
 class UserException : public o2lException {
 private:
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Common/Exceptions.hpp"
+#include "../Runtime/ListInstance.hpp"
+#include "Engine.hpp"
+#include "o2l.h"
+
+struct o2l_interpreter {
+    std::unique_ptr<o2l::Engine> engine;
+    std::string last_error;
+};
+
+struct o2l_value {
+    o2l::Value value;
+    std::string text;  // backs the strings handed out for this value
+};
+
+namespace {
+
+o2l_value* wrap(o2l::Value value) {
+    return new o2l_value{std::move(value), std::string()};
+}
+
+// Runs `body`, turning exceptions into O2L_ERROR with the message kept on the interpreter
+template <typename Body>
+o2l_status guarded(o2l_interpreter* interpreter, Body&& body) {
+    if (!interpreter) {
+        return O2L_ERROR;
+    }
+    try {
+        body();
+        interpreter->last_error.clear();
+        return O2L_OK;
+    } catch (const o2l::o2lException& e) {
+        interpreter->last_error = e.getFormattedMessage();
+    } catch (const std::exception& e) {
+        interpreter->last_error = e.what();
+    } catch (...) {
+        interpreter->last_error = "Unknown error";
+    }
+    return O2L_ERROR;
+}
+
+}  // namespace
+
+extern "C" {
+
+o2l_interpreter* o2l_create(void) {
+    try {
+        return new o2l_interpreter{std::make_unique<o2l::Engine>(), std::string()};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void o2l_destroy(o2l_interpreter* interpreter) {
+    delete interpreter;
+}
+
+o2l_status o2l_add_search_path(o2l_interpreter* interpreter, const char* path) {
+    return guarded(interpreter, [&]() { interpreter->engine->addSearchPath(path); });
+}
+
+o2l_status o2l_load_source(o2l_interpreter* interpreter, const char* source,
+                           const char* filename) {
+    return guarded(interpreter, [&]() {
+        interpreter->engine->load(source, filename ? filename : "embedded.obq");
+    });
+}
+
+o2l_status o2l_load_file(o2l_interpreter* interpreter, const char* path) {
+    return guarded(interpreter, [&]() { interpreter->engine->loadFile(path); });
+}
+
+o2l_status o2l_call(o2l_interpreter* interpreter, const char* object, const char* method,
+                    o2l_value* const* args, size_t arg_count, o2l_value** result) {
+    return guarded(interpreter, [&]() {
+        std::vector<o2l::Value> values;
+        values.reserve(arg_count);
+        for (size_t i = 0; i < arg_count; ++i) {
+            values.push_back(args[i]->value);
+        }
+        o2l::Value returned = interpreter->engine->call(object, method, values);
+        if (result) {
+            *result = wrap(std::move(returned));
+        }
+    });
+}
+
+o2l_interpreter* o2l_clone(o2l_interpreter* interpreter) {
+    std::unique_ptr<o2l::Engine> isolate;
+    if (guarded(interpreter, [&]() { isolate = interpreter->engine->clone(); }) != O2L_OK) {
+        return nullptr;
+    }
+    return new o2l_interpreter{std::move(isolate), std::string()};
+}
+
+o2l_status o2l_set_limits(o2l_interpreter* interpreter, const o2l_limits* limits) {
+    return guarded(interpreter, [&]() {
+        if (!limits) {
+            throw std::runtime_error("No limits given");
+        }
+        o2l::ExecutionLimits converted;
+        converted.max_steps = limits->max_steps;
+        converted.max_wall_time = std::chrono::milliseconds(limits->max_wall_time_ms);
+        converted.max_allocated_bytes = limits->max_allocated_bytes;
+        converted.max_call_depth = static_cast<size_t>(limits->max_call_depth);
+        interpreter->engine->setExecutionLimits(converted);
+    });
+}
+
+o2l_status o2l_last_usage(const o2l_interpreter* interpreter, o2l_usage* usage) {
+    if (!interpreter || !usage) {
+        return O2L_ERROR;
+    }
+    const o2l::ExecutionUsage& used = interpreter->engine->lastCallUsage();
+    usage->steps = used.steps;
+    usage->wall_time_us = static_cast<uint64_t>(used.wall_time.count());
+    usage->allocated_bytes = used.allocated_bytes;
+    usage->max_call_depth = used.max_call_depth;
+    return O2L_OK;
+}
+
+const char* o2l_last_error(const o2l_interpreter* interpreter) {
+    return interpreter ? interpreter->last_error.c_str() : "No interpreter";
+}
+
+o2l_value* o2l_value_int(int64_t value) {
+    return wrap(o2l::Int(value));
+}
+
+o2l_value* o2l_value_double(double value) {
+    return wrap(o2l::Double(value));
+}
+
+o2l_value* o2l_value_text(const char* value) {
+    return wrap(o2l::Text(value ? value : ""));
+}
+
+o2l_value* o2l_value_bool(int value) {
+    return wrap(o2l::Bool(value != 0));
+}
+
+o2l_value* o2l_value_list(void) {
+    return wrap(std::make_shared<o2l::ListInstance>("Value"));
+}
+
+o2l_status o2l_value_list_append(o2l_value* list, const o2l_value* element) {
+    auto instance = list ? std::get_if<std::shared_ptr<o2l::ListInstance>>(&list->value) : nullptr;
+    if (!instance || !element) {
+        return O2L_ERROR;
+    }
+    (*instance)->add(element->value);
+    return O2L_OK;
+}
+
+void o2l_value_free(o2l_value* value) {
+    delete value;
+}
+
+o2l_type o2l_value_type(const o2l_value* value) {
+    if (!value) {
+        return O2L_TYPE_OTHER;
+    }
+    const o2l::Value& v = value->value;
+    if (std::holds_alternative<o2l::Int>(v) || std::holds_alternative<o2l::Long>(v)) {
+        return O2L_TYPE_INT;
+    }
+    if (std::holds_alternative<o2l::Double>(v) || std::holds_alternative<o2l::Float>(v)) {
+        return O2L_TYPE_DOUBLE;
+    }
+    if (std::holds_alternative<o2l::Text>(v)) {
+        return O2L_TYPE_TEXT;
+    }
+    if (std::holds_alternative<o2l::Bool>(v)) {
+        return O2L_TYPE_BOOL;
+    }
+    if (std::holds_alternative<std::shared_ptr<o2l::ListInstance>>(v)) {
+        return O2L_TYPE_LIST;
+    }
+    return O2L_TYPE_OTHER;
+}
+
+int64_t o2l_value_as_int(const o2l_value* value) {
+    if (!value) {
+        return 0;
+    }
+    if (auto v = std::get_if<o2l::Int>(&value->value)) {
+        return *v;
+    }
+    if (auto v = std::get_if<o2l::Long>(&value->value)) {
+        return static_cast<int64_t>(*v);
+    }
+    return 0;
+}
+
+double o2l_value_as_double(const o2l_value* value) {
+    if (!value) {
+        return 0;
+    }
+    if (auto v = std::get_if<o2l::Double>(&value->value)) {
+        return *v;
+    }
+    if (auto v = std::get_if<o2l::Float>(&value->value)) {
+        return *v;
+    }
+    return static_cast<double>(o2l_value_as_int(value));
+}
+
+int o2l_value_as_bool(const o2l_value* value) {
+    auto v = value ? std::get_if<o2l::Bool>(&value->value) : nullptr;
+    return v && *v ? 1 : 0;
+}
+
+const char* o2l_value_as_text(const o2l_value* value) {
+    auto v = value ? std::get_if<o2l::Text>(&value->value) : nullptr;
+    return v ? v->c_str() : nullptr;
+}
+
+size_t o2l_value_list_size(const o2l_value* value) {
+    auto v = value ? std::get_if<std::shared_ptr<o2l::ListInstance>>(&value->value) : nullptr;
+    return v ? (*v)->size() : 0;
+}
+
+o2l_value* o2l_value_list_get(const o2l_value* value, size_t index) {
+    if (index >= o2l_value_list_size(value)) {
+        return nullptr;
+    }
+    return wrap(std::get<std::shared_ptr<o2l::ListInstance>>(value->value)->get(index));
+}
+
+const char* o2l_value_to_string(o2l_value* value) {
+    if (!value) {
+        return "";
+    }
+    value->text = o2l::valueToString(value->value);
+    return value->text.c_str();
+}
+
+}  // extern "C"
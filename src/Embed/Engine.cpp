@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Engine.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "../Common/Exceptions.hpp"
+#include "../Interpreter.hpp"
+#include "../Lexer.hpp"
+#include "../Parser.hpp"
+#include "../Runtime/ListInstance.hpp"
+#include "../Runtime/MapInstance.hpp"
+#include "../Runtime/ObjectInstance.hpp"
+#include "../Runtime/RecordInstance.hpp"
+#include "../Runtime/SetInstance.hpp"
+
+namespace o2l {
+
+struct Engine::Program {
+    // Methods point into these nodes, so they live as long as any engine using the program
+    std::vector<std::vector<ASTNodePtr>> sources;
+    Interpreter interpreter;
+};
+
+namespace {
+
+// Copies the mutable heap reachable from a value, once per node so aliasing and cycles are
+// kept. Objects share their method tables with the originals; enums, record types,
+// protocols and native objects are immutable or process-wide and are shared as they are.
+class HeapCopier {
+   public:
+    Value copy(const Value& value) {
+        if (auto object = std::get_if<std::shared_ptr<ObjectInstance>>(&value)) {
+            // Native-backed objects keep their state outside properties and are shared
+            if (typeid(**object) != typeid(ObjectInstance)) {
+                return value;
+            }
+            return copyNode(*object, [&]() { return std::make_shared<ObjectInstance>(**object); },
+                            [&](const std::shared_ptr<ObjectInstance>& copied) {
+                                for (const auto& [name, property] : (*object)->getProperties()) {
+                                    copied->setProperty(name, copy(property));
+                                }
+                            });
+        }
+        if (auto list = std::get_if<std::shared_ptr<ListInstance>>(&value)) {
+            return copyNode(
+                *list, [&]() { return std::make_shared<ListInstance>(**list); },
+                [&](const std::shared_ptr<ListInstance>& copied) {
+                    for (auto& element : copied->getElements()) {
+                        element = copy(element);
+                    }
+                });
+        }
+        if (auto map = std::get_if<std::shared_ptr<MapInstance>>(&value)) {
+            return copyNode(
+                *map,
+                [&]() {
+                    return std::make_shared<MapInstance>((*map)->getKeyTypeName(),
+                                                         (*map)->getValueTypeName());
+                },
+                [&](const std::shared_ptr<MapInstance>& copied) {
+                    for (const auto& [key, element] : (*map)->getEntries()) {
+                        copied->put(copy(key), copy(element));
+                    }
+                });
+        }
+        if (auto set = std::get_if<std::shared_ptr<SetInstance>>(&value)) {
+            return copyNode(
+                *set, [&]() { return std::make_shared<SetInstance>((*set)->getElementTypeName()); },
+                [&](const std::shared_ptr<SetInstance>& copied) {
+                    for (const auto& element : (*set)->getElements()) {
+                        copied->add(copy(element));
+                    }
+                });
+        }
+        if (auto record = std::get_if<std::shared_ptr<RecordInstance>>(&value)) {
+            return copyNode(
+                *record, [&]() { return std::make_shared<RecordInstance>(**record); },
+                [&](const std::shared_ptr<RecordInstance>& copied) {
+                    std::unordered_map<std::string, Value> fields;
+                    for (const auto& field : (*record)->getFieldNames()) {
+                        fields.emplace(field, copy((*record)->getFieldValue(field)));
+                    }
+                    *copied = RecordInstance((*record)->getTypeName(), std::move(fields));
+                });
+        }
+        return value;
+    }
+
+   private:
+    // Registers the new node before filling it, so references back to it resolve to the copy
+    template <typename T, typename Allocate, typename Fill>
+    Value copyNode(const std::shared_ptr<T>& original, Allocate allocate, Fill fill) {
+        auto found = copies_.find(original.get());
+        if (found != copies_.end()) {
+            return found->second;
+        }
+        std::shared_ptr<T> copied = allocate();
+        copies_.emplace(original.get(), Value(copied));
+        fill(copied);
+        return copied;
+    }
+
+    std::unordered_map<const void*, Value> copies_;
+};
+
+// Installs a budget for one call and records what the call used when it ends
+class MeteredCall {
+   public:
+    MeteredCall(Context& context, const ExecutionLimits& limits, ExecutionUsage& usage)
+        : context_(context),
+          budget_(std::make_shared<ExecutionBudget>(limits)),
+          scope_(*budget_),
+          usage_(usage) {
+        context_.setExecutionBudget(budget_);
+    }
+    ~MeteredCall() {
+        context_.setExecutionBudget(nullptr);
+        usage_ = budget_->usage();
+    }
+
+    MeteredCall(const MeteredCall&) = delete;
+    MeteredCall& operator=(const MeteredCall&) = delete;
+
+   private:
+    Context& context_;
+    std::shared_ptr<ExecutionBudget> budget_;
+    ExecutionBudget::Scope scope_;
+    ExecutionUsage& usage_;
+};
+
+}  // namespace
+
+Engine::Engine() : program_(std::make_shared<Program>()) {}
+
+Engine::Engine(std::shared_ptr<Program> program) : program_(std::move(program)) {}
+
+Engine::~Engine() = default;
+
+Context& Engine::globals() const {
+    return globals_ ? *globals_ : program_->interpreter.getGlobalContext();
+}
+
+void Engine::addSearchPath(const std::filesystem::path& path) {
+    program_->interpreter.getModuleLoader().addSearchPath(path);
+}
+
+void Engine::registerNativeLibrary(const o2l_native_library& library) {
+    program_->interpreter.getModuleLoader().getNativeLibraries().registerLibrary(library);
+}
+
+void Engine::load(const std::string& source, const std::string& filename) {
+    if (globals_) {
+        throw std::runtime_error("Cannot load programs into a cloned engine");
+    }
+    Lexer lexer(source);
+    Parser parser(lexer.tokenizeAll(), filename);
+    auto nodes = parser.parse();
+    program_->interpreter.declare(nodes);
+    program_->sources.push_back(std::move(nodes));
+}
+
+void Engine::loadFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file '" + path.string() + "'");
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (path.has_parent_path()) {
+        addSearchPath(path.parent_path());
+    }
+    load(source, path.string());
+}
+
+bool Engine::hasObject(const std::string& name) const {
+    const Context& context = globals();
+    return context.hasVariable(name) &&
+           std::holds_alternative<std::shared_ptr<ObjectInstance>>(context.getVariable(name));
+}
+
+Value Engine::call(const std::string& object, const std::string& method,
+                   const std::vector<Value>& args) {
+    if (!limits_) {
+        return invoke(object, method, args);
+    }
+    MeteredCall metered(globals(), *limits_, last_usage_);
+    return invoke(object, method, args);
+}
+
+Value Engine::invoke(const std::string& object, const std::string& method,
+                     const std::vector<Value>& args) {
+    if (!globals_) {
+        return program_->interpreter.call(object, method, args);
+    }
+    if (!hasObject(object)) {
+        throw UnresolvedReferenceError("Object '" + object + "' not found");
+    }
+    auto instance = std::get<std::shared_ptr<ObjectInstance>>(globals_->getVariable(object));
+    return instance->callMethod(method, args, *globals_);
+}
+
+std::unique_ptr<Engine> Engine::clone() const {
+    std::unique_ptr<Engine> isolate(new Engine(program_));
+    isolate->globals_ = std::make_unique<Context>();
+    isolate->limits_ = limits_;
+
+    const Context& source = globals();
+    HeapCopier copier;
+    for (const auto& name : source.getVariableNames()) {
+        isolate->globals_->defineVariable(name, copier.copy(source.getVariable(name)));
+    }
+    return isolate;
+}
+
+void Engine::setExecutionLimits(const ExecutionLimits& limits) {
+    limits_ = limits;
+}
+
+}  // namespace o2l
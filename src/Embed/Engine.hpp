@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../Runtime/Context.hpp"
+#include "../Runtime/ExecutionBudget.hpp"
+#include "../Runtime/NativeAbi.h"
+#include "../Runtime/Value.hpp"
+
+namespace o2l {
+
+/**
+ * An O²L interpreter embedded in a host program (the C++ side of libo2l).
+ *
+ * Programs are loaded once - parsed, imports resolved and objects declared - and their
+ * objects' methods are then called directly with native Values; Main is not required and
+ * nothing runs until call(). A loaded engine can be cloned into an isolate that shares the
+ * parsed code, module state and object method tables with it, and gets its own copy of the
+ * objects' properties and the collections they hold, so a request can start from a
+ * warmed-up state without reloading and without seeing other requests' changes.
+ *
+ * An engine is not thread-safe, and clone() reads the source engine's heap, so it must not
+ * run while that engine is executing a call. Clones are independent of each other and of
+ * their source once created.
+ *
+ * Calls can be metered with setExecutionLimits(): each call() then counts its steps (loop
+ * iterations and method calls), wall time, estimated allocated bytes and deepest call
+ * nesting, reports them through lastCallUsage(), and is aborted at whichever limit it
+ * reaches first.
+ *
+ * Errors are reported by exception, as in the interpreter: o2lException subclasses for
+ * program errors, std::runtime_error for misuse of the engine, and
+ * ExecutionBudgetExceededError for a call that ran out of budget, which the program itself
+ * cannot catch.
+ */
+class Engine {
+   public:
+    Engine();
+    ~Engine();
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Directory searched for user modules imported by loaded programs
+    void addSearchPath(const std::filesystem::path& path);
+    // Makes a native library linked into the host available to `import native.<name>`
+    void registerNativeLibrary(const o2l_native_library& library);
+
+    // Parses `source` and declares its objects; may be called several times before cloning
+    void load(const std::string& source, const std::string& filename = "embedded.obq");
+    // Loads a program file, also searching its directory for the modules it imports
+    void loadFile(const std::filesystem::path& path);
+
+    bool hasObject(const std::string& name) const;
+
+    // Calls `method` on the top-level object `object`
+    Value call(const std::string& object, const std::string& method,
+               const std::vector<Value>& args = {});
+
+    // A fresh isolate of this engine's current state; clones cannot load further programs
+    std::unique_ptr<Engine> clone() const;
+
+    // Meters every later call(); zero fields leave that resource unlimited. Clones inherit
+    // the limits
+    void setExecutionLimits(const ExecutionLimits& limits);
+    // What the latest metered call() consumed, whether it returned or threw
+    const ExecutionUsage& lastCallUsage() const {
+        return last_usage_;
+    }
+
+   private:
+    struct Program;
+
+    explicit Engine(std::shared_ptr<Program> program);
+
+    Context& globals() const;
+    Value invoke(const std::string& object, const std::string& method,
+                 const std::vector<Value>& args);
+
+    // Code and module state, shared by an engine and its clones
+    std::shared_ptr<Program> program_;
+    // A clone's own globals; null for the engine that loaded the program, which uses the
+    // interpreter's
+    std::unique_ptr<Context> globals_;
+
+    std::optional<ExecutionLimits> limits_;
+    ExecutionUsage last_usage_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * C API of libo2l, for embedding the O²L interpreter in other programs.
+ *
+ * Every function returning o2l_status reports failures as O2L_ERROR and leaves the message in
+ * o2l_last_error() of the interpreter involved. Handles are not thread-safe; use one
+ * interpreter (or clone) per thread. Strings returned by the library stay valid until the
+ * next call on the same handle, or until it is freed.
+ */
+
+#ifndef O2L_H
+#define O2L_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define O2L_API_VERSION 2
+
+typedef struct o2l_interpreter o2l_interpreter;
+typedef struct o2l_value o2l_value;
+
+typedef enum { O2L_OK = 0, O2L_ERROR = 1 } o2l_status;
+
+typedef enum {
+    O2L_TYPE_INT,
+    O2L_TYPE_DOUBLE, /* Float and Double */
+    O2L_TYPE_TEXT,
+    O2L_TYPE_BOOL,
+    O2L_TYPE_LIST,
+    O2L_TYPE_OTHER /* objects, maps, records, ...: use o2l_value_to_string */
+} o2l_type;
+
+/* Per-call limits; 0 leaves a resource unlimited */
+typedef struct {
+    uint64_t max_steps; /* loop iterations plus method calls */
+    uint64_t max_wall_time_ms;
+    uint64_t max_allocated_bytes; /* estimated */
+    uint64_t max_call_depth;
+} o2l_limits;
+
+/* What one call consumed */
+typedef struct {
+    uint64_t steps;
+    uint64_t wall_time_us;
+    uint64_t allocated_bytes;
+    uint64_t max_call_depth;
+} o2l_usage;
+
+/* Interpreters */
+
+o2l_interpreter* o2l_create(void);
+void o2l_destroy(o2l_interpreter* interpreter);
+
+o2l_status o2l_add_search_path(o2l_interpreter* interpreter, const char* path);
+/* Parses and declares a program; nothing runs until o2l_call */
+o2l_status o2l_load_source(o2l_interpreter* interpreter, const char* source,
+                           const char* filename);
+o2l_status o2l_load_file(o2l_interpreter* interpreter, const char* path);
+
+/* Calls object.method(args...); on success *result receives a value to o2l_value_free */
+o2l_status o2l_call(o2l_interpreter* interpreter, const char* object, const char* method,
+                    o2l_value* const* args, size_t arg_count, o2l_value** result);
+
+/* A fresh isolate sharing the loaded code and a copy of the current state; NULL on failure */
+o2l_interpreter* o2l_clone(o2l_interpreter* interpreter);
+
+/* Meters every later o2l_call; a call over a limit fails with an "Execution budget exceeded"
+ * error. Clones made afterwards inherit the limits (API version 2) */
+o2l_status o2l_set_limits(o2l_interpreter* interpreter, const o2l_limits* limits);
+/* What the latest metered o2l_call consumed, whether it succeeded or not (API version 2) */
+o2l_status o2l_last_usage(const o2l_interpreter* interpreter, o2l_usage* usage);
+
+const char* o2l_last_error(const o2l_interpreter* interpreter);
+
+/* Values */
+
+o2l_value* o2l_value_int(int64_t value);
+o2l_value* o2l_value_double(double value);
+o2l_value* o2l_value_text(const char* value);
+o2l_value* o2l_value_bool(int value);
+o2l_value* o2l_value_list(void);
+/* Appends a copy of `element` to a list value; O2L_ERROR if `list` is not a list */
+o2l_status o2l_value_list_append(o2l_value* list, const o2l_value* element);
+void o2l_value_free(o2l_value* value);
+
+o2l_type o2l_value_type(const o2l_value* value);
+int64_t o2l_value_as_int(const o2l_value* value);
+double o2l_value_as_double(const o2l_value* value);
+int o2l_value_as_bool(const o2l_value* value);
+/* The text of a Text value, NULL for other types */
+const char* o2l_value_as_text(const o2l_value* value);
+size_t o2l_value_list_size(const o2l_value* value);
+/* A new value holding element `index` of a list, NULL if out of range */
+o2l_value* o2l_value_list_get(const o2l_value* value, size_t index);
+/* The value as O²L would print it */
+const char* o2l_value_to_string(o2l_value* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* O2L_H */
@@ -16,8 +16,11 @@
 
 #include "Interpreter.hpp"
 
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 #include "AST/EnumDeclarationNode.hpp"
 #include "AST/ImportNode.hpp"
@@ -26,9 +29,11 @@
 #include "AST/ProtocolDeclarationNode.hpp"
 #include "AST/RecordDeclarationNode.hpp"
 #include "Common/Exceptions.hpp"
+#include "Runtime/HeapSnapshot.hpp"
 #include "Runtime/ListInstance.hpp"
 #include "Runtime/ObjectInstance.hpp"
 #include "Runtime/FFILibrary.hpp"
+#include "TypeChecker.hpp"
 
 namespace o2l {
 
@@ -40,10 +45,7 @@ Interpreter::Interpreter(const std::string& filename) : source_filename_(filenam
     // Initialize global context with built-in objects/methods if needed
 }
 
-Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
-    // First pass: Register all objects
-    bool has_main = false;
-
+void Interpreter::declare(const std::vector<ASTNodePtr>& nodes) {
     for (const auto& node : nodes) {
         auto object_node = dynamic_cast<ObjectNode*>(node.get());
         auto import_node = dynamic_cast<ImportNode*>(node.get());
@@ -58,10 +60,6 @@ Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
         } else if (object_node) {
             Value object_value = node->evaluate(global_context_);
             global_context_.defineVariable(object_node->getName(), object_value);
-
-            if (object_node->getName() == "Main") {
-                has_main = true;
-            }
         } else if (import_node) {
             // Process import
             const auto& import_path = import_node->getImportPath();
@@ -105,6 +103,18 @@ Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
                 "top level.");
         }
     }
+}
+
+Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
+    // First pass: Register all objects
+    declare(nodes);
+    if (type_check_) {
+        typeCheck(nodes);
+    }
+    bool has_main = std::any_of(nodes.begin(), nodes.end(), [](const ASTNodePtr& node) {
+        auto object_node = dynamic_cast<ObjectNode*>(node.get());
+        return object_node && object_node->getName() == "Main";
+    });
 
     if (!has_main) {
         throw EvaluationError("Program must contain a 'Main' object as entry point");
@@ -124,6 +134,8 @@ Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
             throw EvaluationError("Main object must have a 'main()' method");
         }
 
+        runSetup(main_instance);
+
         // Call Main.main() with no arguments
         std::vector<Value> no_args;
         return main_instance->callMethod("main", no_args, global_context_);
@@ -134,6 +146,72 @@ Value Interpreter::execute(const std::vector<ASTNodePtr>& nodes) {
     }
 }
 
+void Interpreter::typeCheck(const std::vector<ASTNodePtr>& nodes) {
+    TypeChecker checker;
+    checker.addProgram(nodes);
+    for (const auto& [module_key, module_nodes] : module_loader_.getLoadedModuleASTs()) {
+        checker.addProgram(module_nodes);
+    }
+
+    const auto& diagnostics = checker.check();
+    if (diagnostics.empty()) {
+        return;
+    }
+    std::string message = std::to_string(diagnostics.size()) +
+                          (diagnostics.size() == 1 ? " type error:" : " type errors:");
+    for (const auto& diagnostic : diagnostics) {
+        message += "\n  " + diagnostic.location.toString() + ": " + diagnostic.message;
+    }
+    throw TypeMismatchError(message);
+}
+
+void Interpreter::runSetup(const std::shared_ptr<ObjectInstance>& main_instance) {
+    std::vector<Value> no_args;
+    if (snapshot_path_.empty()) {
+        if (main_instance->hasMethod("setup")) {
+            main_instance->callMethod("setup", no_args, global_context_);
+        }
+        return;
+    }
+
+    // The snapshot is only valid for the code that produced it, imported modules included
+    uint64_t fingerprint = snapshot_fingerprint_;
+    for (const auto& module_file : module_loader_.getLoadedModuleFiles()) {
+        std::ifstream module(module_file, std::ios::binary);
+        std::string module_source((std::istreambuf_iterator<char>(module)),
+                                  std::istreambuf_iterator<char>());
+        fingerprint = HeapSnapshot::fingerprint(module_file, fingerprint);
+        fingerprint = HeapSnapshot::fingerprint(module_source, fingerprint);
+    }
+
+    try {
+        if (HeapSnapshot::load(snapshot_path_, fingerprint, global_context_)) {
+            snapshot_restored_ = true;
+            return;
+        }
+    } catch (const std::runtime_error&) {
+        // An unreadable snapshot is treated like a stale one: nothing was restored, rebuild it
+    }
+
+    if (main_instance->hasMethod("setup")) {
+        main_instance->callMethod("setup", no_args, global_context_);
+    }
+    HeapSnapshot::save(snapshot_path_, HeapSnapshot::capture(global_context_, fingerprint));
+}
+
+Value Interpreter::call(const std::string& object_name, const std::string& method_name,
+                        const std::vector<Value>& args) {
+    if (!global_context_.hasVariable(object_name)) {
+        throw UnresolvedReferenceError("Object '" + object_name + "' not found");
+    }
+    Value object = global_context_.getVariable(object_name);
+    if (!std::holds_alternative<std::shared_ptr<ObjectInstance>>(object)) {
+        throw EvaluationError("'" + object_name + "' is not an object instance");
+    }
+    return std::get<std::shared_ptr<ObjectInstance>>(object)->callMethod(method_name, args,
+                                                                          global_context_);
+}
+
 Value Interpreter::execute(const ASTNodePtr& node) {
     return node->evaluate(global_context_);
 }
@@ -182,4 +260,13 @@ void Interpreter::setFFIEnabled(bool enabled) {
     FFILibrary::setFFIEnabled(enabled);
 }
 
+void Interpreter::setJitMode(JitMode mode) {
+    BaselineJit::setMode(mode);
+}
+
+void Interpreter::setSnapshot(const std::string& path, const std::string& source) {
+    snapshot_path_ = path;
+    snapshot_fingerprint_ = HeapSnapshot::fingerprint(source);
+}
+
 }  // namespace o2l
@@ -16,9 +16,13 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "AST/Node.hpp"
+#include "Runtime/BaselineJit.hpp"
 #include "Runtime/Context.hpp"
 #include "Runtime/ModuleLoader.hpp"
 
@@ -29,14 +33,26 @@ class Interpreter {
     Context global_context_;
     ModuleLoader module_loader_;
     std::string source_filename_;
+    std::string snapshot_path_;
+    uint64_t snapshot_fingerprint_ = 0;
+    bool snapshot_restored_ = false;
+    bool type_check_ = false;
 
    public:
     Interpreter();
     explicit Interpreter(const std::string& filename);
 
-    // Execute a list of AST nodes
+    // Execute a list of AST nodes: declare them, then run Main.setup() and Main.main()
     Value execute(const std::vector<ASTNodePtr>& nodes);
 
+    // Register top-level declarations (objects, enums, records, protocols, namespaces and
+    // imports) without running anything; `nodes` must outlive the interpreter
+    void declare(const std::vector<ASTNodePtr>& nodes);
+
+    // Call `method_name` on the top-level object `object_name`
+    Value call(const std::string& object_name, const std::string& method_name,
+               const std::vector<Value>& args);
+
     // Execute a single node
     Value execute(const ASTNodePtr& node);
 
@@ -59,7 +75,28 @@ class Interpreter {
     // Enable/disable FFI
     void setFFIEnabled(bool enabled);
 
+    // Select the baseline JIT mode (process-wide, like FFI); objects declared afterwards use it
+    void setJitMode(JitMode mode);
+
+    // Keep the heap left by Main.setup() in a snapshot file at `path`: restored instead of
+    // running setup() while `source` and the imported modules are unchanged, rewritten when not
+    void setSnapshot(const std::string& path, const std::string& source);
+    bool wasSnapshotRestored() const {
+        return snapshot_restored_;
+    }
+
+    // Check the program and its modules with the static type checker before running it;
+    // type errors are reported together as a TypeMismatchError
+    void setTypeCheck(bool enabled) {
+        type_check_ = enabled;
+    }
+
    private:
+    void typeCheck(const std::vector<ASTNodePtr>& nodes);
+
+    // Runs Main.setup(), or restores what it left behind from the snapshot
+    void runSetup(const std::shared_ptr<ObjectInstance>& main_instance);
+
     // Generate main namespace from filename
     std::string generateMainNamespace() const;
 };
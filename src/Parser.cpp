@@ -56,6 +56,7 @@
 #include "AST/SetLiteralNode.hpp"
 #include "AST/NamespaceNode.hpp"
 #include "AST/QualifiedIdentifierNode.hpp"
+#include "Runtime/Coverage.hpp"
 
 namespace o2l {
 
@@ -996,6 +997,18 @@ ASTNodePtr Parser::parseStatement() {
         // Skip newlines
     }
     
+    // Statements without a location of their own get the line they start on, which coverage
+    // and heap profiles report them at
+    SourceLocation location(filename_, currentToken().line, currentToken().column);
+    ASTNodePtr statement = parseStatementByKind();
+    if (statement->getSourceLocation().line_number == 0) {
+        statement->setSourceLocation(location);
+    }
+    Coverage::instrument(*statement, location);
+    return statement;
+}
+
+ASTNodePtr Parser::parseStatementByKind() {
     const Token& token = currentToken();
     
     // Check for return statements
@@ -61,6 +61,7 @@ class Parser {
     ASTNodePtr parseThisAssignment();
     ASTNodePtr parseReturnStatement();
     ASTNodePtr parseStatement();
+    ASTNodePtr parseStatementByKind();
     ASTNodePtr parseVariableDeclaration();
     ASTNodePtr parseVariableAssignment();
     ASTNodePtr parsePropertyDeclaration();
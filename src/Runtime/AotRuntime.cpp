@@ -0,0 +1,379 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AotRuntime.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../AST/BinaryOpNode.hpp"
+#include "../AST/BlockNode.hpp"
+#include "../AST/BreakNode.hpp"
+#include "../AST/ComparisonNode.hpp"
+#include "../AST/ConstDeclarationNode.hpp"
+#include "../AST/ContinueNode.hpp"
+#include "../AST/EnumAccessNode.hpp"
+#include "../AST/FunctionCallNode.hpp"
+#include "../AST/IdentifierNode.hpp"
+#include "../AST/IfStatementNode.hpp"
+#include "../AST/ListLiteralNode.hpp"
+#include "../AST/LiteralNode.hpp"
+#include "../AST/LogicalNode.hpp"
+#include "../AST/MapLiteralNode.hpp"
+#include "../AST/MemberAccessNode.hpp"
+#include "../AST/MethodCallNode.hpp"
+#include "../AST/MethodDeclarationNode.hpp"
+#include "../AST/NewExpressionNode.hpp"
+#include "../AST/ObjectNode.hpp"
+#include "../AST/PropertyAccessNode.hpp"
+#include "../AST/PropertyAssignmentNode.hpp"
+#include "../AST/QualifiedIdentifierNode.hpp"
+#include "../AST/RecordFieldAccessNode.hpp"
+#include "../AST/RecordInstantiationNode.hpp"
+#include "../AST/ReturnNode.hpp"
+#include "../AST/SetLiteralNode.hpp"
+#include "../AST/ThisNode.hpp"
+#include "../AST/ThrowNode.hpp"
+#include "../AST/TryCatchFinallyNode.hpp"
+#include "../AST/UnaryNode.hpp"
+#include "../AST/VariableAssignmentNode.hpp"
+#include "../AST/VariableDeclarationNode.hpp"
+#include "../AST/WhileStatementNode.hpp"
+#include "../Interpreter.hpp"
+#include "../Lexer.hpp"
+#include "../Parser.hpp"
+
+namespace o2l {
+
+namespace {
+
+std::mutex g_methods_mutex;
+std::unordered_map<const MethodDeclarationNode*, AotEntry>& boundMethods() {
+    static std::unordered_map<const MethodDeclarationNode*, AotEntry> methods;
+    return methods;
+}
+
+// Nodes without operands
+bool isAotLeaf(const ASTNode* node) {
+    return dynamic_cast<const LiteralNode*>(node) || dynamic_cast<const IdentifierNode*>(node) ||
+           dynamic_cast<const ThisNode*>(node) || dynamic_cast<const BreakNode*>(node) ||
+           dynamic_cast<const ContinueNode*>(node) || dynamic_cast<const EnumAccessNode*>(node) ||
+           dynamic_cast<const QualifiedIdentifierNode*>(node) ||
+           dynamic_cast<const PropertyAccessNode*>(node);
+}
+
+}  // namespace
+
+void AotMethods::bind(const MethodDeclarationNode* declaration, AotEntry entry) {
+    std::lock_guard<std::mutex> lock(g_methods_mutex);
+    boundMethods()[declaration] = entry;
+}
+
+AotEntry AotMethods::find(const MethodDeclarationNode* declaration) {
+    std::lock_guard<std::mutex> lock(g_methods_mutex);
+    auto& methods = boundMethods();
+    auto found = methods.find(declaration);
+    return found == methods.end() ? nullptr : found->second;
+}
+
+// An operand of a site, holding a value set by compiled code until the node reads it
+class AotSite::Slot : public ASTNode {
+   public:
+    Value evaluate(Context&) override {
+        return (*operand)();
+    }
+    std::string toString() const override {
+        return "AotSlot";
+    }
+
+    const AotOperand* operand = nullptr;
+};
+
+AotSite::AotSite(const ASTNode* node) {
+    auto slot = [this]() {
+        auto operand = std::make_unique<Slot>();
+        slots_.push_back(operand.get());
+        return operand;
+    };
+    auto slots = [&](size_t count) {
+        std::vector<ASTNodePtr> operands;
+        for (size_t i = 0; i < count; ++i) {
+            operands.push_back(slot());
+        }
+        return operands;
+    };
+
+    const SourceLocation& location = node->getSourceLocation();
+    if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        ASTNodePtr left = slot();
+        node_ = std::make_unique<BinaryOpNode>(std::move(left), binary->getOperator(), slot(),
+                                               location);
+    } else if (auto comparison = dynamic_cast<const ComparisonNode*>(node)) {
+        ASTNodePtr left = slot();
+        node_ = std::make_unique<ComparisonNode>(std::move(left), comparison->getOperator(),
+                                                 slot(), location);
+    } else if (auto unary = dynamic_cast<const UnaryNode*>(node)) {
+        node_ = std::make_unique<UnaryNode>(unary->getOperator(), slot(), location);
+    } else if (auto call = dynamic_cast<const MethodCallNode*>(node)) {
+        ASTNodePtr receiver = slot();
+        node_ = std::make_unique<MethodCallNode>(std::move(receiver), call->getMethodName(),
+                                                 slots(call->getArguments().size()), location);
+    } else if (auto assignment = dynamic_cast<const PropertyAssignmentNode*>(node)) {
+        node_ = std::make_unique<PropertyAssignmentNode>(assignment->getPropertyName(), slot());
+    } else if (auto creation = dynamic_cast<const NewExpressionNode*>(node)) {
+        node_ = std::make_unique<NewExpressionNode>(
+            creation->getObjectTypeName(), slots(creation->getConstructorArgs().size()));
+    } else {
+        throw std::runtime_error("No compiled form for " + node->toString());
+    }
+    node_->setSourceLocation(location);
+}
+
+AotSite::~AotSite() = default;
+
+Value AotSite::evaluate(Context& context, std::initializer_list<AotOperand> operands) {
+    // An operand that re-enters the site (recursion) replaces the slots; the outer evaluation
+    // gets its own back when the inner one returns
+    std::vector<const AotOperand*> outer;
+    if (depth_ > 0) {
+        for (const Slot* slot : slots_) {
+            outer.push_back(slot->operand);
+        }
+    }
+    auto slot = slots_.begin();
+    for (const auto& operand : operands) {
+        (*slot++)->operand = &operand;
+    }
+
+    struct Restore {
+        AotSite& site;
+        const std::vector<const AotOperand*>& outer;
+        ~Restore() {
+            --site.depth_;
+            for (size_t i = 0; i < outer.size(); ++i) {
+                site.slots_[i]->operand = outer[i];
+            }
+        }
+    } restore{*this, outer};
+    ++depth_;
+    return node_->evaluate(context);
+}
+
+bool aotTruthy(const Value& value) {
+    if (auto flag = std::get_if<Bool>(&value)) {
+        return *flag;
+    }
+    if (auto number = std::get_if<Int>(&value)) {
+        return *number != 0;
+    }
+    if (auto text = std::get_if<Text>(&value)) {
+        return !text->empty();
+    }
+    return true;
+}
+
+bool aotLoopCondition(const Value& value) {
+    if (auto flag = std::get_if<Bool>(&value)) {
+        return *flag;
+    }
+    throw TypeMismatchError("While condition must evaluate to Bool, got " + getTypeName(value));
+}
+
+bool aotLogicalOperand(const Value& value, const char* message, Context& context) {
+    if (auto flag = std::get_if<Bool>(&value)) {
+        return *flag;
+    }
+    throw EvaluationError(message, context);
+}
+
+void aotCheckDeclaration(const ASTNode* node, const Value& value, Context& context) {
+    static_cast<const VariableDeclarationNode*>(node)->checkDeclaredType(value, context);
+}
+
+AotProgram::AotProgram(std::string filename, std::string source, std::string source_dir)
+    : filename_(std::move(filename)),
+      source_(std::move(source)),
+      source_dir_(std::move(source_dir)) {}
+
+void AotProgram::method(const std::string& object, const std::string& method,
+                        const std::vector<ASTNode*>** nodes, AotEntry entry) {
+    bindings_.push_back(Binding{object, method, nodes, entry});
+}
+
+void AotProgram::bind(const std::vector<ASTNodePtr>& program) {
+    // Filled before any pointer into it is handed out
+    method_nodes_.reserve(bindings_.size());
+    for (const auto& binding : bindings_) {
+        const MethodDeclarationNode* declaration = nullptr;
+        for (const auto& node : program) {
+            auto object = dynamic_cast<const ObjectNode*>(node.get());
+            if (!object || object->getName() != binding.object) {
+                continue;
+            }
+            for (const auto& method : object->getMethods()) {
+                auto candidate = dynamic_cast<const MethodDeclarationNode*>(method.get());
+                if (candidate && candidate->getName() == binding.method) {
+                    declaration = candidate;
+                }
+            }
+        }
+        if (!declaration) {
+            throw std::runtime_error("Compiled method " + binding.object + "." + binding.method +
+                                     " is missing from the embedded program");
+        }
+        method_nodes_.push_back(flatten(declaration->getBody().get()));
+        *binding.nodes = &method_nodes_.back();
+        AotMethods::bind(declaration, binding.entry);
+    }
+}
+
+int AotProgram::run(int argc, char* argv[]) {
+    std::vector<std::string> program_args{filename_};
+    for (int i = 1; i < argc; ++i) {
+        program_args.emplace_back(argv[i]);
+    }
+
+    try {
+        Lexer lexer(source_);
+        Parser parser(lexer.tokenizeAll(), filename_);
+        auto nodes = parser.parse();
+        bind(nodes);
+
+        Interpreter interpreter(filename_);
+        interpreter.setProgramArguments(program_args);
+        // User modules are still loaded at runtime, from where the program was compiled
+        if (!source_dir_.empty() && std::filesystem::is_directory(source_dir_)) {
+            interpreter.getModuleLoader().addSearchPath(source_dir_);
+        }
+
+        Value result = interpreter.execute(nodes);
+        if (auto exit_code = std::get_if<Int>(&result)) {
+            return static_cast<int>(*exit_code);
+        }
+        std::cout << valueToString(result) << "\n";
+        return 0;
+    } catch (const o2lException& e) {
+        std::cerr << "Error: " << e.getMessage() << "\n";
+        auto stack_trace = e.getStackTrace();
+        if (!stack_trace.empty()) {
+            std::cerr << "Stack trace:\n";
+            for (const auto& frame : stack_trace) {
+                std::cerr << "  " << frame << "\n";
+            }
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Unexpected error: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+std::vector<ASTNode*> AotProgram::flatten(const ASTNode* body) {
+    std::vector<ASTNode*> nodes;
+    std::vector<ASTNode*> pending{const_cast<ASTNode*>(body)};
+    while (!pending.empty()) {
+        ASTNode* node = pending.back();
+        pending.pop_back();
+        nodes.push_back(node);
+        std::vector<ASTNode*> operands;
+        children(node, operands);
+        pending.insert(pending.end(), operands.rbegin(), operands.rend());
+    }
+    return nodes;
+}
+
+bool AotProgram::children(const ASTNode* node, std::vector<ASTNode*>& out) {
+    auto add = [&](const ASTNodePtr& child) {
+        if (child) {
+            out.push_back(child.get());
+        }
+    };
+    auto addAll = [&](const std::vector<ASTNodePtr>& nodes) {
+        for (const auto& child : nodes) {
+            add(child);
+        }
+    };
+
+    if (auto block = dynamic_cast<const BlockNode*>(node)) {
+        addAll(block->getStatements());
+    } else if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(node)) {
+        add(declaration->getInitializer());
+    } else if (auto assignment = dynamic_cast<const VariableAssignmentNode*>(node)) {
+        add(assignment->getValueExpressionPtr());
+    } else if (auto constant = dynamic_cast<const ConstDeclarationNode*>(node)) {
+        add(constant->getInitializer());
+    } else if (auto if_node = dynamic_cast<const IfStatementNode*>(node)) {
+        add(if_node->getCondition());
+        add(if_node->getThenBranch());
+        add(if_node->getElseBranch());
+    } else if (auto while_node = dynamic_cast<const WhileStatementNode*>(node)) {
+        add(while_node->getCondition());
+        add(while_node->getBody());
+    } else if (auto return_node = dynamic_cast<const ReturnNode*>(node)) {
+        add(return_node->getExpression());
+    } else if (auto throw_node = dynamic_cast<const ThrowNode*>(node)) {
+        add(throw_node->getExpression());
+    } else if (auto try_node = dynamic_cast<const TryCatchFinallyNode*>(node)) {
+        add(try_node->getTryBlock());
+        add(try_node->getCatchBlock());
+        add(try_node->getFinallyBlock());
+    } else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        add(binary->getLeft());
+        add(binary->getRight());
+    } else if (auto comparison = dynamic_cast<const ComparisonNode*>(node)) {
+        add(comparison->getLeft());
+        add(comparison->getRight());
+    } else if (auto logical = dynamic_cast<const LogicalNode*>(node)) {
+        add(logical->getLeft());
+        add(logical->getRight());
+    } else if (auto unary = dynamic_cast<const UnaryNode*>(node)) {
+        add(unary->getOperand());
+    } else if (auto call = dynamic_cast<const MethodCallNode*>(node)) {
+        add(call->getObject());
+        addAll(call->getArguments());
+    } else if (auto function_call = dynamic_cast<const FunctionCallNode*>(node)) {
+        addAll(function_call->getArguments());
+    } else if (auto member = dynamic_cast<const MemberAccessNode*>(node)) {
+        add(member->getObjectExpression());
+    } else if (auto field = dynamic_cast<const RecordFieldAccessNode*>(node)) {
+        add(field->getRecordExpression());
+    } else if (auto property = dynamic_cast<const PropertyAssignmentNode*>(node)) {
+        add(property->getValueExpression());
+    } else if (auto creation = dynamic_cast<const NewExpressionNode*>(node)) {
+        addAll(creation->getConstructorArgs());
+    } else if (auto list = dynamic_cast<const ListLiteralNode*>(node)) {
+        addAll(list->getElements());
+    } else if (auto set = dynamic_cast<const SetLiteralNode*>(node)) {
+        addAll(set->getElements());
+    } else if (auto map = dynamic_cast<const MapLiteralNode*>(node)) {
+        for (const auto& [key, value] : map->getEntries()) {
+            add(key);
+            add(value);
+        }
+    } else if (auto record = dynamic_cast<const RecordInstantiationNode*>(node)) {
+        for (const auto& assignment : record->getFieldAssignments()) {
+            add(assignment.value_expr);
+        }
+    } else {
+        return isAotLeaf(node);
+    }
+    return true;
+}
+
+}  // namespace o2l
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../AST/Node.hpp"
+#include "../Common/Exceptions.hpp"
+#include "../Common/StackFrameGuard.hpp"
+#include "Context.hpp"
+#include "ObjectInstance.hpp"
+#include "Value.hpp"
+
+namespace o2l {
+
+class MethodDeclarationNode;
+
+/*
+ * Runtime support for programs compiled ahead of time by `o2l build --aot`.
+ *
+ * The generated C++ embeds the program's source and runs it through the interpreter, with
+ * the methods the compiler could translate registered as native entry points. Those keep
+ * typed locals in C++ variables and call each other directly; anything else they contain -
+ * calls on other values, property access, operators on dynamically typed values - is
+ * evaluated by the interpreter, either through the original AST node or through an AotSite
+ * that applies the node's operation to values computed natively.
+ */
+
+// Native entry point of a compiled method; runs `interpreted` for arguments it was not
+// compiled for
+using AotEntry = Value (*)(const std::vector<Value>& args, Context& context,
+                           const Method& interpreted);
+
+// Compiled methods by declaration, consulted when an object declaration is evaluated
+class AotMethods {
+   public:
+    static void bind(const MethodDeclarationNode* declaration, AotEntry entry);
+    static AotEntry find(const MethodDeclarationNode* declaration);
+};
+
+// A compiled operand of an AotSite: a callable returning a Value, referenced, not copied
+class AotOperand {
+   public:
+    template <typename Function>
+    AotOperand(const Function& function)  // NOLINT(google-explicit-constructor)
+        : function_(&function), call_([](const void* function) -> Value {
+              return (*static_cast<const Function*>(function))();
+          }) {}
+
+    Value operator()() const {
+        return call_(function_);
+    }
+
+   private:
+    const void* function_;
+    Value (*call_)(const void*);
+};
+
+/**
+ * The operation of one AST node applied to operands computed by compiled code.
+ *
+ * Built from a binary, comparison, unary, method call, property assignment or new expression
+ * node: a copy of it whose operands are slots, evaluated with the interpreter's semantics
+ * and error messages. Operands are passed in source order (the receiver first for calls)
+ * and run when the node evaluates them, so they see the same stack frames and error
+ * wrapping as interpreted operands. A site is used by one thread at a time; it may be
+ * re-entered from its own operands.
+ */
+class AotSite {
+   public:
+    explicit AotSite(const ASTNode* node);
+    ~AotSite();
+
+    AotSite(const AotSite&) = delete;
+    AotSite& operator=(const AotSite&) = delete;
+
+    Value evaluate(Context& context, std::initializer_list<AotOperand> operands);
+
+   private:
+    class Slot;
+
+    ASTNodePtr node_;
+    std::vector<Slot*> slots_;
+    int depth_ = 0;
+};
+
+// Keeps a scope for the variables the interpreter defines on behalf of a compiled method
+class AotScope {
+   public:
+    explicit AotScope(Context& context) : context_(context) {
+        context_.pushScope();
+    }
+    ~AotScope() {
+        context_.popScope();
+    }
+
+    AotScope(const AotScope&) = delete;
+    AotScope& operator=(const AotScope&) = delete;
+
+   private:
+    Context& context_;
+};
+
+// Typed arithmetic with the interpreter's division checks
+template <typename T>
+T aotDivide(T left, T right, const ASTNode* node, Context& context) {
+    if (right == T(0)) {
+        StackFrameGuard frame(context, "binary_operation", "expression", *node);
+        throw EvaluationError("Division by zero", context);
+    }
+    return left / right;
+}
+
+template <typename T>
+T aotModulo(T left, T right, const ASTNode* node, Context& context) {
+    if (right == T(0)) {
+        StackFrameGuard frame(context, "binary_operation", "expression", *node);
+        throw EvaluationError("Modulo by zero", context);
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::fmod(left, right);
+    } else {
+        return left % right;
+    }
+}
+
+// A dynamically typed value stored in a local declared with a primitive type
+template <typename T>
+T aotUnbox(const Value& value, const char* variable, const char* type, Context& context) {
+    if (auto typed = std::get_if<T>(&value)) {
+        return *typed;
+    }
+    throw EvaluationError(std::string("Type mismatch: ") + variable + " declared as " + type +
+                              " but assigned " + getTypeName(value),
+                          context);
+}
+
+// Conditions, as if, while and the logical operators read them
+bool aotTruthy(const Value& value);
+bool aotLoopCondition(const Value& value);
+bool aotLogicalOperand(const Value& value, const char* message, Context& context);
+
+// Checks a value against a local's declared type as the declaration `node` would
+void aotCheckDeclaration(const ASTNode* node, const Value& value, Context& context);
+
+/**
+ * The main() of a compiled program: parses the embedded source, binds the compiled methods
+ * registered with method() and runs Main like `o2l run`.
+ */
+class AotProgram {
+   public:
+    AotProgram(std::string filename, std::string source, std::string source_dir);
+
+    // Registers a compiled method; `nodes` receives the method's nodes in AotProgram::flatten
+    // order once the program is parsed
+    void method(const std::string& object, const std::string& method,
+                const std::vector<ASTNode*>** nodes, AotEntry entry);
+
+    int run(int argc, char* argv[]);
+
+    // The nodes of a method body in pre-order, the numbering shared with the compiler
+    static std::vector<ASTNode*> flatten(const ASTNode* body);
+    // The operand and statement nodes of `node` in evaluation order; false for node types
+    // whose children are not known
+    static bool children(const ASTNode* node, std::vector<ASTNode*>& out);
+
+   private:
+    struct Binding {
+        std::string object;
+        std::string method;
+        const std::vector<ASTNode*>** nodes;
+        AotEntry entry;
+    };
+
+    void bind(const std::vector<ASTNodePtr>& program);
+
+    std::string filename_;
+    std::string source_;
+    std::string source_dir_;
+    std::vector<Binding> bindings_;
+    std::vector<std::vector<ASTNode*>> method_nodes_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,981 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BaselineJit.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define O2L_JIT_X86_64 1
+#endif
+
+#include "../AST/BinaryOpNode.hpp"
+#include "../AST/BlockNode.hpp"
+#include "../AST/BreakNode.hpp"
+#include "../AST/ComparisonNode.hpp"
+#include "../AST/ContinueNode.hpp"
+#include "../AST/IdentifierNode.hpp"
+#include "../AST/IfStatementNode.hpp"
+#include "../AST/LiteralNode.hpp"
+#include "../AST/LogicalNode.hpp"
+#include "../AST/MethodCallNode.hpp"
+#include "../AST/MethodDeclarationNode.hpp"
+#include "../AST/ObjectNode.hpp"
+#include "../AST/ReturnNode.hpp"
+#include "../AST/ThisNode.hpp"
+#include "../AST/UnaryNode.hpp"
+#include "../AST/VariableAssignmentNode.hpp"
+#include "../AST/VariableDeclarationNode.hpp"
+#include "../AST/WhileStatementNode.hpp"
+#include "../Common/Exceptions.hpp"
+#include "CancellationToken.hpp"
+#include "Context.hpp"
+
+namespace o2l {
+
+namespace {
+
+constexpr size_t kMaxParameters = 16;
+constexpr int32_t kMaxNativeDepth = 20000;
+constexpr int64_t kPollInterval = 1024;
+// A method that keeps bailing out is left to the interpreter
+constexpr uint32_t kMaxDeopts = 16;
+
+enum DeoptReason : int32_t {
+    kDeoptDivision = 1,
+    kDeoptNoReturn = 2,
+    kDeoptDepth = 3,
+    kDeoptCancelled = 4,
+};
+
+const char* deoptReasonName(int64_t reason) {
+    switch (reason) {
+        case kDeoptDivision:
+            return "division by zero";
+        case kDeoptNoReturn:
+            return "reached the end without return";
+        case kDeoptDepth:
+            return "native recursion limit";
+        case kDeoptCancelled:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+JitMode modeFromEnvironment() {
+    JitMode mode = JitMode::Off;
+    if (const char* value = std::getenv("O2L_JIT")) {
+        BaselineJit::parseMode(value, mode);
+    }
+    return mode;
+}
+
+uint32_t thresholdFromEnvironment() {
+    if (const char* value = std::getenv("O2L_JIT_THRESHOLD")) {
+        long threshold = std::strtol(value, nullptr, 10);
+        if (threshold > 0) {
+            return static_cast<uint32_t>(threshold);
+        }
+    }
+    return 1000;
+}
+
+std::atomic<JitMode> g_mode{modeFromEnvironment()};
+std::atomic<uint32_t> g_threshold{thresholdFromEnvironment()};
+
+bool tracing() {
+    return g_mode.load(std::memory_order_relaxed) == JitMode::Trace;
+}
+
+// Called from native loops and calls every kPollInterval back-edges
+int64_t pollCancellation(JitState* state) {
+    state->poll_budget = kPollInterval;
+    if (!state->context) {
+        return 0;
+    }
+    const auto& token = state->context->getCancellationToken();
+    if (token && token->isCancelled()) {
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef O2L_JIT_X86_64
+
+enum class JitType { Int, Bool };
+
+struct Label {
+    std::ptrdiff_t position = -1;
+    std::vector<size_t> fixups;
+};
+
+// x86-64 code under construction, one fixed template per operation
+class CodeBuffer {
+   public:
+    void emit(std::initializer_list<uint8_t> bytes) {
+        code_.insert(code_.end(), bytes);
+    }
+    void emit32(int32_t value) {
+        uint8_t raw[4];
+        std::memcpy(raw, &value, sizeof(raw));
+        code_.insert(code_.end(), raw, raw + sizeof(raw));
+    }
+    void emit64(uint64_t value) {
+        uint8_t raw[8];
+        std::memcpy(raw, &value, sizeof(raw));
+        code_.insert(code_.end(), raw, raw + sizeof(raw));
+    }
+
+    // opcode rel32 to `label`
+    void jump(std::initializer_list<uint8_t> opcode, Label& label) {
+        emit(opcode);
+        if (label.position >= 0) {
+            emit32(static_cast<int32_t>(label.position - static_cast<std::ptrdiff_t>(size() + 4)));
+        } else {
+            label.fixups.push_back(size());
+            emit32(0);
+        }
+    }
+    void bind(Label& label) {
+        label.position = static_cast<std::ptrdiff_t>(size());
+        for (size_t fixup : label.fixups) {
+            int32_t relative = static_cast<int32_t>(label.position - (fixup + 4));
+            std::memcpy(&code_[fixup], &relative, sizeof(relative));
+        }
+        label.fixups.clear();
+    }
+
+    // rax = imm64
+    void loadImmediate(uint64_t value) {
+        emit({0x48, 0xB8});
+        emit64(value);
+    }
+    // rax = [rbp + disp] / [rbp + disp] = rax
+    void loadSlot(int32_t displacement) {
+        emit({0x48, 0x8B, 0x85});
+        emit32(displacement);
+    }
+    void storeSlot(int32_t displacement) {
+        emit({0x48, 0x89, 0x85});
+        emit32(displacement);
+    }
+    // if (rax == 0) goto label / if (rax != 0) goto label
+    void jumpIfZero(Label& label) {
+        emit({0x48, 0x85, 0xC0});
+        jump({0x0F, 0x84}, label);
+    }
+    void jumpIfNotZero(Label& label) {
+        emit({0x48, 0x85, 0xC0});
+        jump({0x0F, 0x85}, label);
+    }
+
+    size_t size() const {
+        return code_.size();
+    }
+    const std::vector<uint8_t>& bytes() const {
+        return code_;
+    }
+
+   private:
+    std::vector<uint8_t> code_;
+};
+
+// Checks that a method stays within what the templates cover and types its expressions
+class MethodAnalyzer {
+   public:
+    struct Local {
+        int32_t slot;
+        JitType type;
+    };
+
+    MethodAnalyzer(const MethodDeclarationNode& method,
+                   const std::map<std::string, const MethodDeclarationNode*>& eligible)
+        : method_(method), eligible_(eligible) {}
+
+    bool run() {
+        for (const auto& parameter : method_.getParameters()) {
+            JitType type;
+            if (!typeFromName(parameter.type, type)) {
+                return reject("parameter '" + parameter.name + "' is " + parameter.type);
+            }
+            declare(parameter.name, type);
+        }
+        if (!typeFromName(method_.getReturnType(), return_type_)) {
+            return reject("returns " + method_.getReturnType());
+        }
+        return statement(method_.getBody());
+    }
+
+    static bool typeFromName(const std::string& name, JitType& type) {
+        if (name == "Int") {
+            type = JitType::Int;
+            return true;
+        }
+        if (name == "Bool") {
+            type = JitType::Bool;
+            return true;
+        }
+        return false;
+    }
+
+    const std::string& reason() const {
+        return reason_;
+    }
+    int32_t slotCount() const {
+        return static_cast<int32_t>(locals_.size());
+    }
+    const Local& local(const std::string& name) const {
+        return locals_.at(name);
+    }
+    JitType typeOf(const ASTNode* node) const {
+        return types_.at(node);
+    }
+
+   private:
+    bool reject(const std::string& reason) {
+        if (reason_.empty()) {
+            reason_ = reason;
+        }
+        return false;
+    }
+
+    bool declare(const std::string& name, JitType type) {
+        auto found = locals_.find(name);
+        if (found == locals_.end()) {
+            locals_.emplace(name, Local{static_cast<int32_t>(locals_.size()), type});
+        } else if (found->second.type != type) {
+            return reject("'" + name + "' is declared with two types");
+        }
+        visible_.insert(name);
+        return true;
+    }
+
+    // Declarations in a branch or loop body are only visible inside it
+    template <typename Body>
+    bool scoped(Body body) {
+        std::set<std::string> saved = visible_;
+        bool ok = body();
+        visible_ = std::move(saved);
+        return ok;
+    }
+
+    bool statement(const ASTNodePtr& node) {
+        if (!node) {
+            return true;
+        }
+        ASTNode* raw = node.get();
+        if (auto block = dynamic_cast<BlockNode*>(raw)) {
+            for (const auto& child : block->getStatements()) {
+                if (!statement(child)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (auto declaration = dynamic_cast<VariableDeclarationNode*>(raw)) {
+            JitType declared;
+            if (!typeFromName(declaration->getTypeName(), declared)) {
+                return reject("local '" + declaration->getVariableName() + "' is " +
+                              declaration->getTypeName());
+            }
+            JitType actual;
+            if (!expression(declaration->getInitializer(), actual)) {
+                return false;
+            }
+            if (actual != declared) {
+                return reject("'" + declaration->getVariableName() + "' initializer type");
+            }
+            return declare(declaration->getVariableName(), declared);
+        }
+        if (auto assignment = dynamic_cast<VariableAssignmentNode*>(raw)) {
+            const std::string& name = assignment->getVariableName();
+            JitType actual;
+            if (!expression(assignment->getValueExpressionPtr(), actual)) {
+                return false;
+            }
+            if (!visible_.count(name)) {
+                return reject("assigns to '" + name + "', which is not a local");
+            }
+            if (locals_.at(name).type != actual) {
+                return reject("assigns another type to '" + name + "'");
+            }
+            return true;
+        }
+        if (auto if_node = dynamic_cast<IfStatementNode*>(raw)) {
+            if (!condition(if_node->getCondition())) {
+                return false;
+            }
+            return scoped([&]() { return statement(if_node->getThenBranch()); }) &&
+                   scoped([&]() { return statement(if_node->getElseBranch()); });
+        }
+        if (auto while_node = dynamic_cast<WhileStatementNode*>(raw)) {
+            if (!condition(while_node->getCondition())) {
+                return false;
+            }
+            ++loop_depth_;
+            bool ok = scoped([&]() { return statement(while_node->getBody()); });
+            --loop_depth_;
+            return ok;
+        }
+        if (dynamic_cast<BreakNode*>(raw) || dynamic_cast<ContinueNode*>(raw)) {
+            return loop_depth_ > 0 || reject("break or continue outside a loop");
+        }
+        if (auto return_node = dynamic_cast<ReturnNode*>(raw)) {
+            JitType actual;
+            if (!return_node->getExpression()) {
+                return reject("returns without a value");
+            }
+            if (!expression(return_node->getExpression(), actual)) {
+                return false;
+            }
+            return actual == return_type_ || reject("return value type");
+        }
+        JitType ignored;
+        return expression(node, ignored);
+    }
+
+    bool condition(const ASTNodePtr& node) {
+        JitType type;
+        if (!expression(node, type)) {
+            return false;
+        }
+        return type == JitType::Bool || reject("condition is not Bool");
+    }
+
+    bool expression(const ASTNodePtr& node, JitType& type) {
+        if (!node) {
+            return reject("missing expression");
+        }
+        if (!classify(node.get(), type)) {
+            return false;
+        }
+        types_[node.get()] = type;
+        return true;
+    }
+
+    bool classify(ASTNode* raw, JitType& type) {
+        if (auto literal = dynamic_cast<LiteralNode*>(raw)) {
+            if (std::holds_alternative<Int>(literal->getValue())) {
+                type = JitType::Int;
+                return true;
+            }
+            if (std::holds_alternative<Bool>(literal->getValue())) {
+                type = JitType::Bool;
+                return true;
+            }
+            return reject("literal " + literal->toString());
+        }
+        if (auto identifier = dynamic_cast<IdentifierNode*>(raw)) {
+            if (!visible_.count(identifier->getName())) {
+                return reject("reads '" + identifier->getName() + "', which is not a local");
+            }
+            type = locals_.at(identifier->getName()).type;
+            return true;
+        }
+        if (auto binary = dynamic_cast<BinaryOpNode*>(raw)) {
+            JitType left, right;
+            if (!expression(binary->getLeft(), left) || !expression(binary->getRight(), right)) {
+                return false;
+            }
+            if (left != JitType::Int || right != JitType::Int) {
+                return reject("arithmetic on Bool");
+            }
+            type = JitType::Int;
+            return true;
+        }
+        if (auto comparison = dynamic_cast<ComparisonNode*>(raw)) {
+            JitType left, right;
+            if (!expression(comparison->getLeft(), left) ||
+                !expression(comparison->getRight(), right)) {
+                return false;
+            }
+            bool equality = comparison->getOperator() == ComparisonOperator::EQUAL ||
+                            comparison->getOperator() == ComparisonOperator::NOT_EQUAL;
+            if (left != right || (left == JitType::Bool && !equality)) {
+                return reject("comparison of mixed or unordered types");
+            }
+            type = JitType::Bool;
+            return true;
+        }
+        if (auto logical = dynamic_cast<LogicalNode*>(raw)) {
+            JitType left, right;
+            if (!expression(logical->getLeft(), left) || !expression(logical->getRight(), right)) {
+                return false;
+            }
+            if (left != JitType::Bool || right != JitType::Bool) {
+                return reject("logical operator on Int");
+            }
+            type = JitType::Bool;
+            return true;
+        }
+        if (auto unary = dynamic_cast<UnaryNode*>(raw)) {
+            JitType operand;
+            if (!expression(unary->getOperand(), operand)) {
+                return false;
+            }
+            JitType expected =
+                unary->getOperator() == UnaryOperator::NOT ? JitType::Bool : JitType::Int;
+            if (operand != expected) {
+                return reject("unary operator type");
+            }
+            type = operand;
+            return true;
+        }
+        if (auto call = dynamic_cast<MethodCallNode*>(raw)) {
+            if (!dynamic_cast<ThisNode*>(call->getObject().get())) {
+                return reject("calls a method on another object");
+            }
+            auto callee = eligible_.find(call->getMethodName());
+            if (callee == eligible_.end()) {
+                return reject("calls this." + call->getMethodName() + "(), which is not compiled");
+            }
+            const auto& parameters = callee->second->getParameters();
+            if (parameters.size() != call->getArguments().size()) {
+                return reject("calls this." + call->getMethodName() + "() with wrong arity");
+            }
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                JitType argument, expected;
+                typeFromName(parameters[i].type, expected);
+                if (!expression(call->getArguments()[i], argument)) {
+                    return false;
+                }
+                if (argument != expected) {
+                    return reject("argument type of this." + call->getMethodName() + "()");
+                }
+            }
+            typeFromName(callee->second->getReturnType(), type);
+            return true;
+        }
+        return reject("uses " + raw->toString());
+    }
+
+    const MethodDeclarationNode& method_;
+    const std::map<std::string, const MethodDeclarationNode*>& eligible_;
+    JitType return_type_ = JitType::Int;
+    std::map<std::string, Local> locals_;
+    std::set<std::string> visible_;
+    std::unordered_map<const ASTNode*, JitType> types_;
+    int loop_depth_ = 0;
+    std::string reason_;
+};
+
+// Emits one analyzed method:
+//   rbp frame, rbx = JitState*, locals in [rbp - 16 - 8 * slot], expression results in rax
+//   and intermediate operands on the machine stack
+class MethodEmitter {
+   public:
+    MethodEmitter(CodeBuffer& code, const MethodAnalyzer& analysis,
+                  const std::map<std::string, std::atomic<JitEntry>*>& entries)
+        : code_(code), analysis_(analysis), entries_(entries) {}
+
+    void emit(const MethodDeclarationNode& method) {
+        code_.emit({0x55});              // push rbp
+        code_.emit({0x48, 0x89, 0xE5});  // mov rbp, rsp
+        code_.emit({0x53});              // push rbx
+        if (analysis_.slotCount() > 0) {
+            code_.emit({0x48, 0x81, 0xEC});  // sub rsp, imm32
+            code_.emit32(8 * analysis_.slotCount());
+        }
+        code_.emit({0x48, 0x89, 0xF3});  // mov rbx, rsi
+        const auto& parameters = method.getParameters();
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            code_.emit({0x48, 0x8B, 0x87});  // mov rax, [rdi + 8 * i]
+            code_.emit32(static_cast<int32_t>(8 * i));
+            code_.storeSlot(slotOffset(parameters[i].name));
+        }
+        code_.emit({0x48, 0xFF, 0x43, 0x08});  // inc qword [rbx + depth]
+        code_.emit({0x48, 0x81, 0x7B, 0x08});  // cmp qword [rbx + depth], imm32
+        code_.emit32(kMaxNativeDepth);
+        code_.jump({0x0F, 0x8F}, deopt_depth_);  // jg
+        poll();
+
+        statement(method.getBody());
+        code_.jump({0xE9}, deopt_no_return_);
+
+        code_.bind(return_);
+        code_.emit({0x48, 0xFF, 0x4B, 0x08});  // dec qword [rbx + depth]
+        code_.bind(exit_);
+        code_.emit({0x48, 0x8B, 0x5D, 0xF8});  // mov rbx, [rbp - 8]
+        code_.emit({0xC9, 0xC3});              // leave; ret
+
+        deoptStub(deopt_division_, kDeoptDivision);
+        deoptStub(deopt_no_return_, kDeoptNoReturn);
+        deoptStub(deopt_depth_, kDeoptDepth);
+        deoptStub(deopt_cancelled_, kDeoptCancelled);
+    }
+
+   private:
+    int32_t slotOffset(const std::string& name) const {
+        return -16 - 8 * analysis_.local(name).slot;
+    }
+
+    void deoptStub(Label& label, DeoptReason reason) {
+        code_.bind(label);
+        code_.emit({0x48, 0xC7, 0x03});  // mov qword [rbx + deopt], imm32
+        code_.emit32(reason);
+        code_.jump({0xE9}, exit_);
+    }
+
+    // Every kPollInterval back-edges and calls, ask pollCancellation() on an aligned stack
+    void poll() {
+        Label skip;
+        code_.emit({0x48, 0xFF, 0x4B, 0x10});  // dec qword [rbx + poll_budget]
+        code_.jump({0x0F, 0x85}, skip);        // jnz
+        code_.emit({0x48, 0x89, 0xE1});        // mov rcx, rsp
+        code_.emit({0x48, 0x83, 0xE4, 0xF0});  // and rsp, -16
+        code_.emit({0x48, 0x83, 0xEC, 0x10});  // sub rsp, 16
+        code_.emit({0x48, 0x89, 0x0C, 0x24});  // mov [rsp], rcx
+        code_.emit({0x48, 0x89, 0xDF});        // mov rdi, rbx
+        code_.loadImmediate(reinterpret_cast<uint64_t>(&pollCancellation));
+        code_.emit({0xFF, 0xD0});              // call rax
+        code_.emit({0x48, 0x8B, 0x24, 0x24});  // mov rsp, [rsp]
+        code_.jumpIfNotZero(deopt_cancelled_);
+        code_.bind(skip);
+    }
+
+    void statement(const ASTNodePtr& node) {
+        if (!node) {
+            return;
+        }
+        ASTNode* raw = node.get();
+        if (auto block = dynamic_cast<BlockNode*>(raw)) {
+            for (const auto& child : block->getStatements()) {
+                statement(child);
+            }
+        } else if (auto declaration = dynamic_cast<VariableDeclarationNode*>(raw)) {
+            expression(declaration->getInitializer());
+            code_.storeSlot(slotOffset(declaration->getVariableName()));
+        } else if (auto assignment = dynamic_cast<VariableAssignmentNode*>(raw)) {
+            expression(assignment->getValueExpressionPtr());
+            code_.storeSlot(slotOffset(assignment->getVariableName()));
+        } else if (auto if_node = dynamic_cast<IfStatementNode*>(raw)) {
+            Label otherwise, done;
+            expression(if_node->getCondition());
+            code_.jumpIfZero(otherwise);
+            statement(if_node->getThenBranch());
+            code_.jump({0xE9}, done);
+            code_.bind(otherwise);
+            statement(if_node->getElseBranch());
+            code_.bind(done);
+        } else if (auto while_node = dynamic_cast<WhileStatementNode*>(raw)) {
+            Label top, done;
+            code_.bind(top);
+            poll();
+            expression(while_node->getCondition());
+            code_.jumpIfZero(done);
+            loops_.push_back({&top, &done});
+            statement(while_node->getBody());
+            loops_.pop_back();
+            code_.jump({0xE9}, top);
+            code_.bind(done);
+        } else if (dynamic_cast<BreakNode*>(raw)) {
+            code_.jump({0xE9}, *loops_.back().second);
+        } else if (dynamic_cast<ContinueNode*>(raw)) {
+            code_.jump({0xE9}, *loops_.back().first);
+        } else if (auto return_node = dynamic_cast<ReturnNode*>(raw)) {
+            expression(return_node->getExpression());
+            code_.jump({0xE9}, return_);
+        } else {
+            expression(node);
+        }
+    }
+
+    void expression(const ASTNodePtr& node) {
+        ASTNode* raw = node.get();
+        if (auto literal = dynamic_cast<LiteralNode*>(raw)) {
+            const Value& value = literal->getValue();
+            int64_t immediate = std::holds_alternative<Bool>(value)
+                                    ? (std::get<Bool>(value) ? 1 : 0)
+                                    : static_cast<int64_t>(std::get<Int>(value));
+            code_.loadImmediate(static_cast<uint64_t>(immediate));
+        } else if (auto identifier = dynamic_cast<IdentifierNode*>(raw)) {
+            code_.loadSlot(slotOffset(identifier->getName()));
+        } else if (auto binary = dynamic_cast<BinaryOpNode*>(raw)) {
+            operands(binary->getLeft(), binary->getRight());
+            switch (binary->getOperator()) {
+                case BinaryOperator::PLUS:
+                    code_.emit({0x48, 0x01, 0xC8});  // add rax, rcx
+                    break;
+                case BinaryOperator::MINUS:
+                    code_.emit({0x48, 0x29, 0xC8});  // sub rax, rcx
+                    break;
+                case BinaryOperator::MULTIPLY:
+                    code_.emit({0x48, 0x0F, 0xAF, 0xC1});  // imul rax, rcx
+                    break;
+                case BinaryOperator::DIVIDE:
+                case BinaryOperator::MODULO:
+                    code_.emit({0x48, 0x85, 0xC9});  // test rcx, rcx
+                    code_.jump({0x0F, 0x84}, deopt_division_);
+                    code_.emit({0x48, 0x99});        // cqo
+                    code_.emit({0x48, 0xF7, 0xF9});  // idiv rcx
+                    if (binary->getOperator() == BinaryOperator::MODULO) {
+                        code_.emit({0x48, 0x89, 0xD0});  // mov rax, rdx
+                    }
+                    break;
+            }
+        } else if (auto comparison = dynamic_cast<ComparisonNode*>(raw)) {
+            operands(comparison->getLeft(), comparison->getRight());
+            code_.emit({0x48, 0x39, 0xC8});  // cmp rax, rcx
+            uint8_t condition = 0x94;        // sete
+            switch (comparison->getOperator()) {
+                case ComparisonOperator::EQUAL:
+                    condition = 0x94;
+                    break;
+                case ComparisonOperator::NOT_EQUAL:
+                    condition = 0x95;
+                    break;
+                case ComparisonOperator::LESS_THAN:
+                    condition = 0x9C;
+                    break;
+                case ComparisonOperator::GREATER_THAN:
+                    condition = 0x9F;
+                    break;
+                case ComparisonOperator::LESS_EQUAL:
+                    condition = 0x9E;
+                    break;
+                case ComparisonOperator::GREATER_EQUAL:
+                    condition = 0x9D;
+                    break;
+            }
+            code_.emit({0x0F, condition, 0xC0});  // setcc al
+            code_.emit({0x0F, 0xB6, 0xC0});       // movzx eax, al
+        } else if (auto logical = dynamic_cast<LogicalNode*>(raw)) {
+            // Short-circuits like LogicalNode: the left value is the result when it decides
+            Label done;
+            expression(logical->getLeft());
+            if (logical->getOperator() == LogicalOperator::AND) {
+                code_.jumpIfZero(done);
+            } else {
+                code_.jumpIfNotZero(done);
+            }
+            expression(logical->getRight());
+            code_.bind(done);
+        } else if (auto unary = dynamic_cast<UnaryNode*>(raw)) {
+            expression(unary->getOperand());
+            if (unary->getOperator() == UnaryOperator::NOT) {
+                code_.emit({0x48, 0x83, 0xF0, 0x01});  // xor rax, 1
+            } else {
+                code_.emit({0x48, 0xF7, 0xD8});  // neg rax
+            }
+        } else if (auto call = dynamic_cast<MethodCallNode*>(raw)) {
+            // Arguments go on the stack with the first one on top, the array the callee reads
+            const auto& arguments = call->getArguments();
+            for (auto it = arguments.rbegin(); it != arguments.rend(); ++it) {
+                expression(*it);
+                code_.emit({0x50});  // push rax
+            }
+            code_.emit({0x48, 0x89, 0xE7});  // mov rdi, rsp
+            code_.emit({0x48, 0x89, 0xDE});  // mov rsi, rbx
+            code_.loadImmediate(reinterpret_cast<uint64_t>(entries_.at(call->getMethodName())));
+            code_.emit({0xFF, 0x10});  // call [rax]
+            if (!arguments.empty()) {
+                code_.emit({0x48, 0x81, 0xC4});  // add rsp, imm32
+                code_.emit32(static_cast<int32_t>(8 * arguments.size()));
+            }
+            code_.emit({0x48, 0x83, 0x3B, 0x00});  // cmp qword [rbx + deopt], 0
+            code_.jump({0x0F, 0x85}, exit_);       // jne: the callee bailed out
+        }
+    }
+
+    // rax = left, rcx = right
+    void operands(const ASTNodePtr& left, const ASTNodePtr& right) {
+        expression(left);
+        code_.emit({0x50});  // push rax
+        expression(right);
+        code_.emit({0x48, 0x89, 0xC1});  // mov rcx, rax
+        code_.emit({0x58});              // pop rax
+    }
+
+    CodeBuffer& code_;
+    const MethodAnalyzer& analysis_;
+    const std::map<std::string, std::atomic<JitEntry>*>& entries_;
+    Label return_, exit_;
+    Label deopt_division_, deopt_no_return_, deopt_depth_, deopt_cancelled_;
+    std::vector<std::pair<Label*, Label*>> loops_;  // continue and break targets
+};
+
+#endif  // O2L_JIT_X86_64
+
+}  // namespace
+
+thread_local std::atomic<uint32_t>* BaselineJit::current_profile_ = nullptr;
+
+bool BaselineJit::isSupported() {
+#ifdef O2L_JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BaselineJit::setMode(JitMode mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+JitMode BaselineJit::getMode() {
+    return g_mode.load(std::memory_order_relaxed);
+}
+
+bool BaselineJit::parseMode(const std::string& text, JitMode& mode) {
+    if (text == "off") {
+        mode = JitMode::Off;
+    } else if (text == "on") {
+        mode = JitMode::On;
+    } else if (text == "trace") {
+        mode = JitMode::Trace;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void BaselineJit::setThreshold(uint32_t threshold) {
+    g_threshold.store(threshold > 0 ? threshold : 1, std::memory_order_relaxed);
+}
+
+uint32_t BaselineJit::getThreshold() {
+    return g_threshold.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<JitObject> BaselineJit::prepare(const ObjectNode& object) {
+    if (getMode() == JitMode::Off || !isSupported()) {
+        return nullptr;
+    }
+    return std::make_shared<JitObject>(object);
+}
+
+BaselineJit::ProfileScope::ProfileScope(JitMethod* method) : previous_(current_profile_) {
+    bool profiling = method && method->status.load(std::memory_order_relaxed) ==
+                                   JitMethod::Status::Interpreted;
+    current_profile_ = profiling ? &method->hotness : nullptr;
+}
+
+BaselineJit::ProfileScope::~ProfileScope() {
+    current_profile_ = previous_;
+}
+
+JitObject::JitObject(const ObjectNode& object) : object_name_(object.getName()) {
+    for (const auto& node : object.getMethods()) {
+        if (auto declaration = dynamic_cast<MethodDeclarationNode*>(node.get())) {
+            auto method = std::make_unique<JitMethod>();
+            method->declaration = declaration;
+            methods_.push_back(std::move(method));
+        }
+    }
+}
+
+JitObject::~JitObject() {
+#ifdef O2L_JIT_X86_64
+    if (code_) {
+        munmap(code_, code_size_);
+    }
+#endif
+}
+
+JitMethod* JitObject::method(const MethodDeclarationNode* declaration) {
+    for (auto& method : methods_) {
+        if (method->declaration == declaration) {
+            return method.get();
+        }
+    }
+    return nullptr;
+}
+
+bool JitObject::invoke(JitMethod& method, const std::vector<Value>& args, Context& context,
+                       Value& result) {
+    JitEntry entry = method.entry.load(std::memory_order_acquire);
+    if (!entry) {
+        if (method.status.load(std::memory_order_relaxed) != JitMethod::Status::Interpreted) {
+            return false;
+        }
+        uint32_t hotness = method.hotness.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (hotness < BaselineJit::getThreshold()) {
+            return false;
+        }
+        compile();
+        entry = method.entry.load(std::memory_order_acquire);
+        if (!entry) {
+            return false;
+        }
+    }
+    if (method.status.load(std::memory_order_relaxed) != JitMethod::Status::Compiled) {
+        return false;
+    }
+
+    // Metered calls stay interpreted: native loops only poll every kPollInterval back-edges
+    // and native calls never reach Context::pushCall, so neither the step count nor the
+    // call depth limit would hold
+    if (context.getExecutionBudget()) {
+        return false;
+    }
+
+    // Type guards: the native code only handles the declared Int and Bool arguments
+    if (args.size() != method.bool_parameters.size()) {
+        return false;
+    }
+    std::array<int64_t, kMaxParameters> raw{};
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (method.bool_parameters[i]) {
+            auto value = std::get_if<Bool>(&args[i]);
+            if (!value) {
+                return false;
+            }
+            raw[i] = *value ? 1 : 0;
+        } else {
+            auto value = std::get_if<Int>(&args[i]);
+            if (!value) {
+                return false;
+            }
+            raw[i] = *value;
+        }
+    }
+
+    JitState state;
+    state.poll_budget = kPollInterval;
+    state.context = &context;
+    int64_t returned = entry(raw.data(), &state);
+    if (state.deopt != 0) {
+        uint32_t deopts = method.deopts.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (tracing()) {
+            std::cerr << "[jit] deopt " << object_name_ << "." << method.declaration->getName()
+                      << ": " << deoptReasonName(state.deopt) << "\n";
+        }
+        if (deopts >= kMaxDeopts) {
+            // Native callers keep using the code; only direct entry goes back to interpreting
+            method.status.store(JitMethod::Status::Abandoned, std::memory_order_relaxed);
+            if (tracing()) {
+                std::cerr << "[jit] " << object_name_ << "." << method.declaration->getName()
+                          << " returned to the interpreter after " << deopts << " deopts\n";
+            }
+        }
+        return false;
+    }
+    result = method.returns_bool ? Value(Bool(returned != 0)) : Value(Int(returned));
+    return true;
+}
+
+void JitObject::compile() {
+    std::lock_guard<std::mutex> lock(compile_mutex_);
+    if (compiled_) {
+        return;
+    }
+    compiled_ = true;
+
+#ifdef O2L_JIT_X86_64
+    // Narrow the candidates until every remaining method only calls remaining methods
+    std::map<std::string, const MethodDeclarationNode*> eligible;
+    std::map<std::string, std::string> rejected;
+    for (const auto& method : methods_) {
+        const auto* declaration = method->declaration;
+        if (declaration->getParameters().size() > kMaxParameters) {
+            rejected[declaration->getName()] = "too many parameters";
+        } else {
+            eligible[declaration->getName()] = declaration;
+        }
+    }
+    std::map<std::string, std::unique_ptr<MethodAnalyzer>> analyses;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        analyses.clear();
+        for (auto it = eligible.begin(); it != eligible.end();) {
+            auto analyzer = std::make_unique<MethodAnalyzer>(*it->second, eligible);
+            if (analyzer->run()) {
+                analyses[it->first] = std::move(analyzer);
+                ++it;
+            } else {
+                rejected[it->first] = analyzer->reason();
+                it = eligible.erase(it);
+                changed = true;
+            }
+        }
+    }
+
+    std::map<std::string, std::atomic<JitEntry>*> entries;
+    for (auto& method : methods_) {
+        if (eligible.count(method->declaration->getName())) {
+            entries[method->declaration->getName()] = &method->entry;
+        }
+    }
+
+    CodeBuffer code;
+    std::map<JitMethod*, size_t> offsets;
+    for (auto& method : methods_) {
+        auto analysis = analyses.find(method->declaration->getName());
+        if (analysis == analyses.end()) {
+            continue;
+        }
+        offsets[method.get()] = code.size();
+        MethodEmitter(code, *analysis->second, entries).emit(*method->declaration);
+    }
+
+    if (!offsets.empty()) {
+        code_size_ = code.size();
+        void* memory = mmap(nullptr, code_size_, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            offsets.clear();
+        } else {
+            std::memcpy(memory, code.bytes().data(), code_size_);
+            if (mprotect(memory, code_size_, PROT_READ | PROT_EXEC) != 0) {
+                munmap(memory, code_size_);
+                offsets.clear();
+            } else {
+                code_ = memory;
+            }
+        }
+    }
+
+    for (auto& method : methods_) {
+        auto offset = offsets.find(method.get());
+        const std::string& name = method->declaration->getName();
+        if (offset == offsets.end()) {
+            method->status.store(JitMethod::Status::Rejected, std::memory_order_relaxed);
+            if (tracing()) {
+                auto reason = rejected.find(name);
+                std::cerr << "[jit] " << object_name_ << "." << name << " stays interpreted: "
+                          << (reason != rejected.end() ? reason->second : "no executable memory")
+                          << "\n";
+            }
+            continue;
+        }
+        for (const auto& parameter : method->declaration->getParameters()) {
+            method->bool_parameters.push_back(parameter.type == "Bool");
+        }
+        method->returns_bool = method->declaration->getReturnType() == "Bool";
+        method->status.store(JitMethod::Status::Compiled, std::memory_order_relaxed);
+        method->entry.store(
+            reinterpret_cast<JitEntry>(static_cast<uint8_t*>(code_) + offset->second),
+            std::memory_order_release);
+        if (tracing()) {
+            std::cerr << "[jit] compiled " << object_name_ << "." << name << "\n";
+        }
+    }
+#else
+    for (auto& method : methods_) {
+        method->status.store(JitMethod::Status::Rejected, std::memory_order_relaxed);
+    }
+#endif
+}
+
+}  // namespace o2l
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Value.hpp"
+
+namespace o2l {
+
+class Context;
+class MethodDeclarationNode;
+class ObjectNode;
+
+enum class JitMode { Off, On, Trace };
+
+// Frame shared by the native code of one top-level call; the layout is used by generated code
+struct JitState {
+    int64_t deopt = 0;        // non-zero: bail out to the interpreter, with the reason
+    int64_t depth = 0;        // native call depth
+    int64_t poll_budget = 0;  // back-edges and calls left until the next cancellation poll
+    const Context* context = nullptr;
+};
+
+using JitEntry = int64_t (*)(const int64_t* args, JitState* state);
+
+// One method of a JitObject and its profile
+struct JitMethod {
+    enum class Status { Interpreted, Compiled, Rejected, Abandoned };
+
+    const MethodDeclarationNode* declaration = nullptr;
+    std::vector<bool> bool_parameters;
+    bool returns_bool = false;
+    std::atomic<uint32_t> hotness{0};  // calls plus loop back-edges while interpreted
+    std::atomic<uint32_t> deopts{0};
+    std::atomic<Status> status{Status::Interpreted};
+    std::atomic<JitEntry> entry{nullptr};
+};
+
+/**
+ * The methods of one object declaration as seen by the baseline JIT.
+ *
+ * Methods are interpreted and profiled until one gets hot; the object's methods are then
+ * compiled together, so `this.method()` calls between them become direct native calls. The
+ * JIT handles methods over Int and Bool locals - arithmetic, comparisons, logic, if/while,
+ * break/continue, return and calls to other compiled methods - by stitching a fixed x86-64
+ * template per operation, with type guards on the arguments. Such methods have no side
+ * effects, so deoptimizing (division by zero, running off the end, deep recursion,
+ * cancellation) simply discards the native run and lets the interpreter execute the call.
+ */
+class JitObject {
+   public:
+    explicit JitObject(const ObjectNode& object);
+    ~JitObject();
+
+    JitObject(const JitObject&) = delete;
+    JitObject& operator=(const JitObject&) = delete;
+
+    JitMethod* method(const MethodDeclarationNode* declaration);
+
+    // Runs `method` natively when it is compiled and the arguments pass its guards; false means
+    // the interpreter has to run the call
+    bool invoke(JitMethod& method, const std::vector<Value>& args, Context& context,
+                Value& result);
+
+   private:
+    void compile();
+
+    std::string object_name_;
+    std::vector<std::unique_ptr<JitMethod>> methods_;
+    std::mutex compile_mutex_;
+    bool compiled_ = false;
+    void* code_ = nullptr;
+    size_t code_size_ = 0;
+};
+
+class BaselineJit {
+   public:
+    // Whether native code can be generated on this platform (x86-64 Linux)
+    static bool isSupported();
+
+    static void setMode(JitMode mode);
+    static JitMode getMode();
+    // Parses "off", "on" or "trace"
+    static bool parseMode(const std::string& text, JitMode& mode);
+
+    // Calls plus loop iterations after which a method is compiled
+    static void setThreshold(uint32_t threshold);
+    static uint32_t getThreshold();
+
+    // The JIT view of an object declaration, or null when the JIT is off or unsupported
+    static std::shared_ptr<JitObject> prepare(const ObjectNode& object);
+
+    // Attributes the loop back-edges of an interpreted call to its method's hotness
+    class ProfileScope {
+       public:
+        explicit ProfileScope(JitMethod* method);
+        ~ProfileScope();
+
+       private:
+        std::atomic<uint32_t>* previous_;
+    };
+
+    static void noteBackEdge() {
+        if (current_profile_) {
+            current_profile_->fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+   private:
+    static thread_local std::atomic<uint32_t>* current_profile_;
+};
+
+}  // namespace o2l
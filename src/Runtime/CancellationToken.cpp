@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CancellationToken.hpp"
+
+#include "../Common/Exceptions.hpp"
+
+namespace o2l {
+
+std::shared_ptr<CancellationToken> CancellationToken::withTimeout(
+    std::chrono::milliseconds timeout, Clock::time_point start) {
+    return std::make_shared<CancellationToken>(start + timeout);
+}
+
+std::chrono::milliseconds CancellationToken::remaining() const {
+    if (cancelled_.load(std::memory_order_acquire)) {
+        return std::chrono::milliseconds(0);
+    }
+    if (!hasDeadline()) {
+        return std::chrono::milliseconds::max();
+    }
+    auto now = Clock::now();
+    if (now >= deadline_) {
+        return std::chrono::milliseconds(0);
+    }
+    // Round up so a wait bounded by this never ends just short of the deadline
+    return std::chrono::ceil<std::chrono::milliseconds>(deadline_ - now);
+}
+
+void CancellationToken::check() const {
+    if (cancelled_.load(std::memory_order_acquire)) {
+        throw ExecutionCancelledError(false);
+    }
+    if (hasDeadline() && Clock::now() >= deadline_) {
+        throw ExecutionCancelledError(true);
+    }
+}
+
+}  // namespace o2l
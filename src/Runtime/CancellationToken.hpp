@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace o2l {
+
+/**
+ * Cooperative cancellation for one unit of work, such as an HTTP request.
+ *
+ * A token ends at its deadline or when cancel() is called from any thread. The interpreter
+ * polls it through the Context at loop back-edges and method calls and unwinds with
+ * ExecutionCancelledError; natives that block (outbound HTTP) bound their waits by
+ * remaining().
+ */
+class CancellationToken {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CancellationToken(Clock::time_point deadline = Clock::time_point::max())
+        : deadline_(deadline) {}
+
+    static std::shared_ptr<CancellationToken> withTimeout(std::chrono::milliseconds timeout,
+                                                          Clock::time_point start = Clock::now());
+
+    void cancel() {
+        cancelled_.store(true, std::memory_order_release);
+    }
+
+    // Cancelled explicitly, or the deadline has passed
+    bool isCancelled() const {
+        return cancelled_.load(std::memory_order_acquire) ||
+               (hasDeadline() && Clock::now() >= deadline_);
+    }
+    bool isDeadlineExceeded() const {
+        return hasDeadline() && Clock::now() >= deadline_;
+    }
+    bool hasDeadline() const {
+        return deadline_ != Clock::time_point::max();
+    }
+    Clock::time_point getDeadline() const {
+        return deadline_;
+    }
+
+    // Time left before the deadline: zero once it has passed or the token was cancelled,
+    // milliseconds::max() without a deadline
+    std::chrono::milliseconds remaining() const;
+
+    // Throws ExecutionCancelledError once the token has ended
+    void check() const;
+
+   private:
+    Clock::time_point deadline_;
+    std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace o2l
@@ -21,6 +21,8 @@
 
 namespace o2l {
 
+thread_local std::vector<Value>* Context::ArgumentHandoff::offered_ = nullptr;
+
 Context::Context() {
     // Start with global scope
     pushScope();
@@ -35,11 +37,14 @@ void Context::popScope() {
     if (scopes_.empty()) {
         throw EvaluationError("Cannot pop scope: no scopes available");
     }
+    if (scopes_.size() == 1) {
+        ++qualified_links_.generation;  // the global scope's slots go with it
+    }
     scopes_.pop_back();
     const_scopes_.pop_back();
 }
 
-void Context::defineVariable(const std::string& name, const Value& value) {
+void Context::defineVariable(const std::string& name, Value value) {
     if (scopes_.empty()) {
         throw EvaluationError("Cannot define variable: no active scope");
     }
@@ -49,7 +54,10 @@ void Context::defineVariable(const std::string& name, const Value& value) {
         throw EvaluationError("Cannot redefine constant '" + name + "'");
     }
 
-    scopes_.back()[name] = value;
+    if (scopes_.size() == 1 || name.find('.') != std::string::npos) {
+        ++qualified_links_.generation;
+    }
+    scopes_.back()[name] = std::move(value);
 }
 
 void Context::defineConstant(const std::string& name, const Value& value) {
@@ -62,11 +70,14 @@ void Context::defineConstant(const std::string& name, const Value& value) {
         throw EvaluationError("Cannot define constant '" + name + "': name already exists");
     }
 
+    if (scopes_.size() == 1 || name.find('.') != std::string::npos) {
+        ++qualified_links_.generation;
+    }
     scopes_.back()[name] = value;
     const_scopes_.back().insert(name);
 }
 
-void Context::reassignVariable(const std::string& name, const Value& value) {
+void Context::reassignVariable(const std::string& name, Value value) {
     // Check if variable exists
     if (!hasVariable(name)) {
         throw UnresolvedReferenceError("Cannot reassign undefined variable '" + name + "'");
@@ -82,7 +93,7 @@ void Context::reassignVariable(const std::string& name, const Value& value) {
     for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
         auto var_it = it->find(name);
         if (var_it != it->end()) {
-            var_it->second = value;
+            var_it->second = std::move(value);
             return;
         }
     }
@@ -92,27 +103,68 @@ void Context::reassignVariable(const std::string& name, const Value& value) {
 }
 
 Value Context::getVariable(const std::string& name) const {
+    return lookupVariable(name);
+}
+
+const Value& Context::lookupVariable(const std::string& name) const {
+    if (const Value* value = findVariable(name)) {
+        return *value;
+    }
+    throw UnresolvedReferenceError("Variable '" + name + "' not found");
+}
+
+const Value* Context::findVariable(const std::string& name) const {
     // Search from innermost to outermost scope
     for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
         auto var_it = it->find(name);
         if (var_it != it->end()) {
-            return var_it->second;
+            return &var_it->second;
         }
     }
+    return nullptr;
+}
 
-    throw UnresolvedReferenceError("Variable '" + name + "' not found");
+const Value* Context::lookupQualified(size_t site, const std::string& name) {
+    auto& entries = qualified_links_.entries;
+    auto cached = entries.find(site);
+    if (cached != entries.end() && cached->second.generation == qualified_links_.generation) {
+        return cached->second.slot;
+    }
+
+    const Value* slot = findVariable(name);
+    if (slot && !scopes_.empty()) {
+        auto global = scopes_.front().find(name);
+        if (global == scopes_.front().end() || &global->second != slot) {
+            return slot;  // bound in an inner scope, which may be popped
+        }
+    }
+    if (cached != entries.end()) {
+        cached->second = {qualified_links_.generation, slot};
+    } else {
+        entries.emplace(site, QualifiedLinks::Entry{qualified_links_.generation, slot});
+    }
+    return slot;
 }
 
-bool Context::hasVariable(const std::string& name) const {
-    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
-        if (it->find(name) != it->end()) {
-            return true;
+Value Context::takeVariable(const std::string& name) {
+    if (!scopes_.empty()) {
+        auto var_it = scopes_.back().find(name);
+        if (var_it != scopes_.back().end() && !const_scopes_.back().count(name)) {
+            return std::move(var_it->second);
         }
     }
-    return false;
+    return lookupVariable(name);
+}
+
+bool Context::hasVariable(const std::string& name) const {
+    return findVariable(name) != nullptr;
 }
 
 void Context::pushCall(const std::string& call_description) {
+    // Checked before pushing, so a call refused for depth leaves the stack balanced
+    if (budget_) {
+        budget_->enterCall(call_stack_.size() + 1);
+    }
     call_stack_.push_back(call_description);
 }
 
@@ -16,12 +16,16 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "CancellationToken.hpp"
+#include "ExecutionBudget.hpp"
 #include "Value.hpp"
 
 // Forward declarations
@@ -72,6 +76,34 @@ class Context {
     // Stack of 'this' objects for property access
     std::vector<std::shared_ptr<ObjectInstance>> this_stack_;
 
+    // Deadline/cancellation for the current evaluation; shared by copies of this context
+    std::shared_ptr<CancellationToken> cancellation_;
+    // Step/time/depth metering for the current evaluation; shared like cancellation_
+    std::shared_ptr<ExecutionBudget> budget_;
+
+    // Per-site resolutions of qualified names into global-scope slots. Map slots are never
+    // erased from the global scope, so an entry stays valid until a global or dotted name is
+    // (re)defined, which moves the generation on. Copies start empty: their slots are elsewhere.
+    // Site ids are process-wide, so entries are keyed by id and only the sites this context
+    // evaluates take room
+    struct QualifiedLinks {
+        struct Entry {
+            uint64_t generation = 0;  // 0: never resolved
+            const Value* slot = nullptr;
+        };
+        std::unordered_map<size_t, Entry> entries;
+        uint64_t generation = 1;
+
+        QualifiedLinks() = default;
+        QualifiedLinks(const QualifiedLinks&) {}
+        QualifiedLinks& operator=(const QualifiedLinks&) {
+            entries.clear();
+            ++generation;
+            return *this;
+        }
+    };
+    QualifiedLinks qualified_links_;
+
    public:
     Context();
 
@@ -79,11 +111,23 @@ class Context {
     void pushScope();
     void popScope();
 
-    // Variable operations
-    void defineVariable(const std::string& name, const Value& value);
+    // Variable operations; values passed as temporaries are moved into their slots
+    void defineVariable(const std::string& name, Value value);
     void defineConstant(const std::string& name, const Value& value);
-    void reassignVariable(const std::string& name, const Value& value);
+    void reassignVariable(const std::string& name, Value value);
     Value getVariable(const std::string& name) const;
+    // The variable's value in place, valid until its scope is popped; assignments to the
+    // variable change what it refers to
+    const Value& lookupVariable(const std::string& name) const;
+    // As lookupVariable, but null when no scope binds the name
+    const Value* findVariable(const std::string& name) const;
+    // Moves the value out for a read that is the variable's last use. Only variables of the
+    // innermost scope are moved from; anything further out is copied
+    Value takeVariable(const std::string& name);
+    // The global binding of a dotted name as resolved for call site `site` (a
+    // QualifiedIdentifierNode), or null when no scope binds it; bindings in inner scopes
+    // are returned without being cached
+    const Value* lookupQualified(size_t site, const std::string& name);
     bool hasVariable(const std::string& name) const;
     bool isConstant(const std::string& name) const;
     std::vector<std::string> getVariableNames() const;
@@ -92,6 +136,9 @@ class Context {
     void pushCall(const std::string& call_description);
     void popCall();
     std::vector<std::string> getCallStack() const;
+    size_t getCallDepth() const {
+        return call_stack_.size();
+    }
 
     // Enhanced stack frame management with source locations
     void pushStackFrame(const std::string& function_name, const std::string& object_name,
@@ -110,6 +157,63 @@ class Context {
     void popThisObject();
     std::shared_ptr<ObjectInstance> getThisObject() const;
     bool hasThisObject() const;
+
+    // Cooperative cancellation, polled at loop back-edges and method calls
+    void setCancellationToken(std::shared_ptr<CancellationToken> token) {
+        cancellation_ = std::move(token);
+    }
+    const std::shared_ptr<CancellationToken>& getCancellationToken() const {
+        return cancellation_;
+    }
+    // Throws ExecutionCancelledError once the token's deadline has passed or it was cancelled.
+    // Each poll is also one step of the execution budget, which throws
+    // ExecutionBudgetExceededError when spent
+    void checkCancellation() const {
+        if (cancellation_) {
+            cancellation_->check();
+        }
+        if (budget_) {
+            budget_->step();
+        }
+    }
+
+    void setExecutionBudget(std::shared_ptr<ExecutionBudget> budget) {
+        budget_ = std::move(budget);
+    }
+    const std::shared_ptr<ExecutionBudget>& getExecutionBudget() const {
+        return budget_;
+    }
+
+    /**
+     * Hands a caller's argument vector to the method it calls, so the method can move its
+     * parameters out of it instead of copying them. The caller must not read the vector
+     * again while the handoff is alive; a method claims it only by the vector's address, so
+     * calls the arguments were not offered to never see it. Per thread, and nests.
+     */
+    class ArgumentHandoff {
+       public:
+        explicit ArgumentHandoff(std::vector<Value>& args) : previous_(offered_) {
+            offered_ = &args;
+        }
+        ~ArgumentHandoff() {
+            offered_ = previous_;
+        }
+        ArgumentHandoff(const ArgumentHandoff&) = delete;
+        ArgumentHandoff& operator=(const ArgumentHandoff&) = delete;
+
+        // The vector behind `args` if it was offered and not claimed yet
+        static std::vector<Value>* claim(const std::vector<Value>& args) {
+            if (offered_ != &args) {
+                return nullptr;
+            }
+            offered_ = nullptr;
+            return const_cast<std::vector<Value>*>(&args);
+        }
+
+       private:
+        std::vector<Value>* previous_;
+        static thread_local std::vector<Value>* offered_;
+    };
 };
 
 }  // namespace o2l
\ No newline at end of file
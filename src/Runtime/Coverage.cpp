@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Coverage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace o2l {
+
+namespace {
+
+struct Site {
+    std::string file;
+    int line;
+};
+
+// Counters never move once created: statements point at them, so the table only appends
+struct CounterTable {
+    std::mutex mutex;
+    std::deque<std::atomic<uint64_t>> counters;
+    std::vector<Site> sites;  // parallel to counters
+};
+
+CounterTable& table() {
+    static CounterTable instance;
+    return instance;
+}
+
+std::atomic<bool> g_enabled{false};
+
+// Counts grouped by file, in line order
+std::map<std::string, std::vector<Coverage::LineCount>> byFile() {
+    std::map<std::string, std::vector<Coverage::LineCount>> files;
+    for (auto& line : Coverage::lineCounts()) {
+        files[line.file].push_back(std::move(line));
+    }
+    return files;
+}
+
+// File names as JSON string contents
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+size_t linesHit(const std::vector<Coverage::LineCount>& lines) {
+    return static_cast<size_t>(std::count_if(
+        lines.begin(), lines.end(), [](const Coverage::LineCount& line) { return line.count; }));
+}
+
+}  // namespace
+
+void Coverage::enable() {
+#if O2L_ENABLE_COVERAGE
+    g_enabled = true;
+#endif
+}
+
+void Coverage::disable() {
+    g_enabled = false;
+}
+
+bool Coverage::isEnabled() {
+    return g_enabled;
+}
+
+void Coverage::instrument(ASTNode& statement, const SourceLocation& location) {
+#if O2L_ENABLE_COVERAGE
+    if (!g_enabled || location.line_number <= 0) {
+        return;
+    }
+    CounterTable& counters = table();
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    counters.counters.emplace_back(0);
+    counters.sites.push_back({location.filename, location.line_number});
+    statement.setCoverageCounter(&counters.counters.back());
+#else
+    (void)statement;
+    (void)location;
+#endif
+}
+
+std::vector<Coverage::LineCount> Coverage::lineCounts() {
+    // Statements sharing a line report the line once, with the count of the most run one
+    std::map<std::pair<std::string, int>, uint64_t> lines;
+    {
+        CounterTable& counters = table();
+        std::lock_guard<std::mutex> lock(counters.mutex);
+        for (size_t i = 0; i < counters.sites.size(); ++i) {
+            uint64_t& count = lines[{counters.sites[i].file, counters.sites[i].line}];
+            count = std::max(count, counters.counters[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    std::vector<LineCount> result;
+    result.reserve(lines.size());
+    for (const auto& [site, count] : lines) {
+        result.push_back({site.first, site.second, count});
+    }
+    return result;
+}
+
+std::vector<Coverage::LineCount> Coverage::hottestLines(size_t limit) {
+    std::vector<LineCount> lines = lineCounts();
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const LineCount& a, const LineCount& b) { return a.count > b.count; });
+    if (lines.size() > limit) {
+        lines.resize(limit);
+    }
+    return lines;
+}
+
+void Coverage::writeLcov(std::ostream& out) {
+    for (const auto& [file, lines] : byFile()) {
+        out << "TN:\nSF:" << file << "\n";
+        for (const auto& line : lines) {
+            out << "DA:" << line.line << "," << line.count << "\n";
+        }
+        out << "LF:" << lines.size() << "\nLH:" << linesHit(lines) << "\nend_of_record\n";
+    }
+}
+
+void Coverage::writeJson(std::ostream& out) {
+    out << "{\n  \"files\": [";
+    bool first_file = true;
+    for (const auto& [file, lines] : byFile()) {
+        out << (first_file ? "\n" : ",\n");
+        first_file = false;
+        out << "    {\n      \"file\": \"" << jsonEscape(file) << "\",\n"
+            << "      \"lines_found\": " << lines.size() << ",\n"
+            << "      \"lines_hit\": " << linesHit(lines) << ",\n"
+            << "      \"lines\": [";
+        for (size_t i = 0; i < lines.size(); ++i) {
+            out << (i ? ", " : "") << "{\"line\": " << lines[i].line
+                << ", \"count\": " << lines[i].count << "}";
+        }
+        out << "]\n    }";
+    }
+    out << (first_file ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+void Coverage::writeReport(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot write coverage report '" + path + "'");
+    }
+    if (path.ends_with(".json")) {
+        writeJson(file);
+    } else {
+        writeLcov(file);
+    }
+    if (!file) {
+        throw std::runtime_error("Cannot write coverage report '" + path + "'");
+    }
+}
+
+}  // namespace o2l
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "../AST/Node.hpp"
+
+namespace o2l {
+
+/**
+ * Line coverage and execution counts for `o2l run --coverage`.
+ *
+ * Once enabled, the parser gives every statement it builds a counter in one flat, append-only
+ * table, and BlockNode bumps a statement's counter each time it runs it. Statements parsed
+ * while coverage is off have no counter and cost a null check; builds configured with
+ * ENABLE_LINE_COVERAGE=OFF have neither the counters nor the check.
+ *
+ * Counts are relaxed atomic increments, so every thread running the program counts, and
+ * lineCounts() may be read while it runs (to sample hot lines, say). Methods the JIT compiled
+ * are not counted, so coverage runs are interpreted.
+ */
+class Coverage {
+   public:
+    struct LineCount {
+        std::string file;
+        int line;
+        uint64_t count;  // runs of the line's most executed statement
+    };
+
+    // Statements parsed from now on get a counter, or after disable() none; statements that
+    // already have one keep counting
+    static void enable();
+    static void disable();
+    static bool isEnabled();
+
+    // Gives a parsed statement a counter for the line `location` names; does nothing while
+    // coverage is off
+    static void instrument(ASTNode& statement, const SourceLocation& location);
+
+    // Called each time a statement is executed
+    static void count(const ASTNode& statement) {
+#if O2L_ENABLE_COVERAGE
+        if (auto* counter = statement.getCoverageCounter()) {
+            counter->fetch_add(1, std::memory_order_relaxed);
+        }
+#else
+        (void)statement;
+#endif
+    }
+
+    // Every instrumented line, run or not, by file and then line
+    static std::vector<LineCount> lineCounts();
+    // The `limit` most executed lines, most executed first
+    static std::vector<LineCount> hottestLines(size_t limit);
+
+    // An lcov tracefile (SF/DA/LF/LH records per file), or the same counts as JSON
+    static void writeLcov(std::ostream& out);
+    static void writeJson(std::ostream& out);
+    // JSON when `path` ends in ".json", lcov otherwise; throws std::runtime_error when the
+    // file cannot be written
+    static void writeReport(const std::string& path);
+};
+
+}  // namespace o2l
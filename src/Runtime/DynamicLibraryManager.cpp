@@ -30,6 +30,18 @@
 
 namespace o2l {
 
+namespace {
+
+void closeLibraryHandle(void* handle) {
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(handle));
+#else
+    dlclose(handle);
+#endif
+}
+
+}  // namespace
+
 DynamicLibraryManager::DynamicLibraryManager() {
     // Add default search paths
     namespace fs = std::filesystem;
@@ -121,11 +133,7 @@ void* DynamicLibraryManager::loadDynamicLibrary(const std::filesystem::path& lib
 void DynamicLibraryManager::unloadDynamicLibrary(void* handle) {
     if (!handle) return;
 
-#ifdef _WIN32
-    FreeLibrary(static_cast<HMODULE>(handle));
-#else
-    dlclose(handle);
-#endif
+    closeLibraryHandle(handle);
 }
 
 void* DynamicLibraryManager::getSymbol(void* handle, const std::string& symbol_name) {
@@ -184,6 +192,18 @@ bool DynamicLibraryManager::loadLibraryFromPath(const std::string& library_name,
         // Load the dynamic library
         void* handle = loadDynamicLibrary(library_path);
 
+        // v2 libraries export a method table instead of a NativeLibrary object
+        if (auto entry = reinterpret_cast<o2l_native_entry>(
+                getSymbol(handle, O2L_NATIVE_ENTRY_SYMBOL))) {
+            std::shared_ptr<void> owner(handle, closeLibraryHandle);
+            const o2l_native_library* library = entry();
+            if (!library) {
+                throw EvaluationError("Library '" + library_name + "' returned no method table");
+            }
+            native_modules_[library_name] = std::make_shared<NativeModule>(*library, owner);
+            return true;
+        }
+
         // Validate ABI compatibility
         if (!validateABI(handle)) {
             unloadDynamicLibrary(handle);
@@ -229,10 +249,19 @@ bool DynamicLibraryManager::loadLibraryFromPath(const std::string& library_name,
     }
 }
 
+void DynamicLibraryManager::registerLibrary(const o2l_native_library& library) {
+    auto module = std::make_shared<NativeModule>(library);
+    native_modules_[module->getName()] = std::move(module);
+}
+
 void DynamicLibraryManager::unloadLibrary(const std::string& library_name) {
     if (!isLibraryLoaded(library_name)) {
         return;
     }
+    // Objects created from a v2 library keep it loaded until they are gone
+    if (native_modules_.erase(library_name) > 0) {
+        return;
+    }
 
     // Cleanup library instance
     if (library_instances_[library_name]) {
@@ -261,7 +290,8 @@ void DynamicLibraryManager::unloadLibrary(const std::string& library_name) {
 }
 
 bool DynamicLibraryManager::isLibraryLoaded(const std::string& library_name) const {
-    return library_instances_.find(library_name) != library_instances_.end();
+    return library_instances_.find(library_name) != library_instances_.end() ||
+           native_modules_.find(library_name) != native_modules_.end();
 }
 
 NativeLibrary* DynamicLibraryManager::getLibrary(const std::string& library_name) {
@@ -271,6 +301,11 @@ NativeLibrary* DynamicLibraryManager::getLibrary(const std::string& library_name
 
 std::shared_ptr<ObjectInstance> DynamicLibraryManager::createNativeObject(
     const std::string& library_name) {
+    auto module = native_modules_.find(library_name);
+    if (module != native_modules_.end()) {
+        return std::make_shared<NativeModuleObject>(module->second);
+    }
+
     auto* library = getLibrary(library_name);
     if (!library) {
         throw EvaluationError("Native library '" + library_name + "' not loaded");
@@ -287,15 +322,25 @@ std::shared_ptr<ObjectInstance> DynamicLibraryManager::createNativeObject(
 
 std::vector<std::string> DynamicLibraryManager::getLoadedLibraries() const {
     std::vector<std::string> libraries;
-    libraries.reserve(library_instances_.size());
+    libraries.reserve(library_instances_.size() + native_modules_.size());
     for (const auto& [name, instance] : library_instances_) {
         libraries.push_back(name);
     }
+    for (const auto& [name, module] : native_modules_) {
+        libraries.push_back(name);
+    }
     return libraries;
 }
 
 std::map<std::string, std::string> DynamicLibraryManager::getLibraryInfo(
     const std::string& library_name) {
+    auto module = native_modules_.find(library_name);
+    if (module != native_modules_.end()) {
+        return {{"name", module->second->getName()},
+                {"version", module->second->getVersion()},
+                {"abi", std::to_string(O2L_NATIVE_ABI_VERSION)}};
+    }
+
     auto* library = getLibrary(library_name);
     if (!library) {
         return {};
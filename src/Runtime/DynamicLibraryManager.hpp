@@ -22,6 +22,7 @@
 #include <string>
 
 #include "NativeLibrary.hpp"
+#include "NativeModuleObject.hpp"
 #include "ObjectInstance.hpp"
 #include "Value.hpp"
 
@@ -42,6 +43,9 @@ class DynamicLibraryManager {
     // Map from library name to creation/destruction functions
     std::map<std::string, std::pair<void*, void*>> entry_functions_;
 
+    // Libraries built against the v2 C ABI, by name; they own their dlopen handles
+    std::map<std::string, std::shared_ptr<const NativeModule>> native_modules_;
+
     // Search paths for native libraries
     std::vector<std::filesystem::path> library_search_paths_;
 
@@ -91,6 +95,12 @@ class DynamicLibraryManager {
     bool loadLibraryFromPath(const std::string& library_name,
                              const std::filesystem::path& library_path);
 
+    /**
+     * Register a v2 library linked into the host, all its methods at once
+     * @param library - Static method table; must outlive every object created from it
+     */
+    void registerLibrary(const o2l_native_library& library);
+
     /**
      * Unload a previously loaded library
      * @param library_name - Name of the library to unload
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ExecutionBudget.hpp"
+
+#include <limits>
+#include <string>
+
+#include "../Common/Exceptions.hpp"
+
+namespace o2l {
+
+namespace {
+
+template <typename T>
+T limitOrMax(T limit) {
+    return limit == 0 ? std::numeric_limits<T>::max() : limit;
+}
+
+}  // namespace
+
+thread_local ExecutionBudget* ExecutionBudget::active_ = nullptr;
+
+ExecutionBudget::ExecutionBudget(const ExecutionLimits& limits)
+    : limits_(limits),
+      step_limit_(limitOrMax(limits.max_steps)),
+      byte_limit_(limitOrMax(limits.max_allocated_bytes)),
+      depth_limit_(limitOrMax(limits.max_call_depth)),
+      start_(Clock::now()),
+      deadline_(limits.max_wall_time.count() > 0 ? start_ + limits.max_wall_time
+                                                 : Clock::time_point::max()) {}
+
+ExecutionUsage ExecutionBudget::usage() const {
+    ExecutionUsage usage;
+    usage.steps = steps_;
+    usage.wall_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_);
+    usage.allocated_bytes = allocated_;
+    usage.max_call_depth = max_depth_;
+    return usage;
+}
+
+const char* ExecutionBudget::resourceName(Resource resource) {
+    switch (resource) {
+        case Resource::Steps:
+            return "step";
+        case Resource::WallTime:
+            return "wall time";
+        case Resource::AllocatedBytes:
+            return "allocation";
+        case Resource::CallDepth:
+            return "call depth";
+    }
+    return "unknown";
+}
+
+void ExecutionBudget::checkClock() {
+    next_clock_check_ = steps_ + kClockInterval;
+    if (deadline_ != Clock::time_point::max() && Clock::now() >= deadline_) {
+        exceeded(Resource::WallTime);
+    }
+}
+
+void ExecutionBudget::exceeded(Resource resource) const {
+    std::string limit;
+    switch (resource) {
+        case Resource::Steps:
+            limit = std::to_string(limits_.max_steps) + " steps";
+            break;
+        case Resource::WallTime:
+            limit = std::to_string(limits_.max_wall_time.count()) + " ms";
+            break;
+        case Resource::AllocatedBytes:
+            limit = std::to_string(limits_.max_allocated_bytes) + " bytes";
+            break;
+        case Resource::CallDepth:
+            limit = std::to_string(limits_.max_call_depth) + " nested calls";
+            break;
+    }
+    throw ExecutionBudgetExceededError(resourceName(resource), limit,
+                                       resource == Resource::WallTime);
+}
+
+}  // namespace o2l
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "Value.hpp"
+
+namespace o2l {
+
+// Limits for one top-level call; zero leaves a resource unlimited
+struct ExecutionLimits {
+    uint64_t max_steps = 0;  // loop iterations plus method calls
+    std::chrono::milliseconds max_wall_time{0};
+    uint64_t max_allocated_bytes = 0;
+    size_t max_call_depth = 0;
+};
+
+// What a call consumed, reported whether it returned, threw or ran out of budget
+struct ExecutionUsage {
+    uint64_t steps = 0;
+    std::chrono::microseconds wall_time{0};
+    uint64_t allocated_bytes = 0;
+    size_t max_call_depth = 0;
+};
+
+/**
+ * Metering and limits for one evaluation, such as a call into an embedded engine.
+ *
+ * The interpreter charges it through the Context at the same points it polls for
+ * cancellation: one step per loop test and per method call, with the call depth checked
+ * as calls are pushed. The clock is read every kClockInterval steps, so wall time is bounded
+ * by the time between polls. Allocated bytes are an estimate charged by collection growth,
+ * Text concatenation and object creation on the thread that installed the budget with a
+ * Scope. Running out throws ExecutionBudgetExceededError, which like cancellation unwinds
+ * past O²L try/catch to the host. The JIT does not run metered calls, so counts and limits
+ * are the same with it on.
+ *
+ * A budget is not thread-safe; each evaluation gets its own.
+ */
+class ExecutionBudget {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Resource { Steps, WallTime, AllocatedBytes, CallDepth };
+
+    static constexpr uint64_t kClockInterval = 256;
+
+    explicit ExecutionBudget(const ExecutionLimits& limits);
+
+    // A loop back-edge or call; native code charges its steps in batches
+    void step(uint64_t count = 1) {
+        steps_ += count;
+        if (steps_ > step_limit_) {
+            exceeded(Resource::Steps);
+        }
+        if (steps_ >= next_clock_check_) {
+            checkClock();
+        }
+    }
+
+    // A call was pushed, leaving `depth` calls on the stack
+    void enterCall(size_t depth) {
+        if (depth > depth_limit_) {
+            exceeded(Resource::CallDepth);
+        }
+        if (depth > max_depth_) {
+            max_depth_ = depth;
+        }
+    }
+
+    void allocate(uint64_t bytes) {
+        allocated_ += bytes;
+        if (allocated_ > byte_limit_) {
+            exceeded(Resource::AllocatedBytes);
+        }
+    }
+
+    ExecutionUsage usage() const;
+    const ExecutionLimits& limits() const {
+        return limits_;
+    }
+
+    static const char* resourceName(Resource resource);
+
+    // Charges the budget installed on this thread, if any
+    static void chargeAllocation(uint64_t bytes) {
+        if (active_) {
+            active_->allocate(bytes);
+        }
+    }
+    // A value stored in a collection: its slot plus the characters of a Text
+    static void chargeStoredValue(const Value& value) {
+        if (active_) {
+            auto text = std::get_if<Text>(&value);
+            active_->allocate(sizeof(Value) + (text ? text->size() : 0));
+        }
+    }
+
+    // Installs a budget as this thread's allocation meter until destroyed
+    class Scope {
+       public:
+        explicit Scope(ExecutionBudget& budget) : previous_(active_) {
+            active_ = &budget;
+        }
+        ~Scope() {
+            active_ = previous_;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        ExecutionBudget* previous_;
+    };
+
+   private:
+    [[noreturn]] void exceeded(Resource resource) const;
+    void checkClock();
+
+    ExecutionLimits limits_;
+    uint64_t step_limit_;
+    uint64_t byte_limit_;
+    size_t depth_limit_;
+    Clock::time_point start_;
+    Clock::time_point deadline_;
+
+    uint64_t steps_ = 0;
+    uint64_t next_clock_check_ = kClockInterval;
+    uint64_t allocated_ = 0;
+    size_t max_depth_ = 0;
+
+    static thread_local ExecutionBudget* active_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,533 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HeapProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "../AST/Node.hpp"
+#include "Context.hpp"
+#include "HeapSnapshot.hpp"
+#include "ListInstance.hpp"
+#include "MapInstance.hpp"
+#include "ObjectInstance.hpp"
+#include "RecordInstance.hpp"
+#include "SetInstance.hpp"
+
+namespace o2l {
+
+// One sampled allocation, chained on the object it was charged to. Holds the scaled-up
+// estimate it added to its site, so freeing it takes back exactly that
+struct HeapSample {
+    struct HeapSiteTotals* site;
+    double objects;
+    double bytes;
+    HeapSample* next;
+};
+
+struct HeapSiteTotals {
+    HeapProfiler::Site site;
+    double alloc_objects = 0;
+    double alloc_bytes = 0;
+    double live_objects = 0;
+    double live_bytes = 0;
+};
+
+std::atomic<bool> HeapProfiler::enabled_{false};
+thread_local int64_t HeapProfiler::bytes_until_sample_ = 0;
+thread_local HeapProfiler::BlockScope* HeapProfiler::top_ = nullptr;
+
+namespace {
+
+struct ProfilerState {
+    std::mutex mutex;
+    std::atomic<uint64_t> sampling_rate{HeapProfiler::kDefaultSamplingRate};
+    // Keyed by type, class and frames; entries are never removed, samples point at them
+    std::unordered_map<std::string, std::unique_ptr<HeapSiteTotals>> sites;
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_wakeup;
+    std::thread writer;
+    std::string writer_path;
+    bool writer_stopping = false;
+};
+
+// Never destroyed: objects freed during static destruction still release their samples
+ProfilerState& state() {
+    static ProfilerState* instance = new ProfilerState();
+    return *instance;
+}
+
+// Bytes until the next sample, exponentially distributed around the sampling rate
+int64_t nextSampleGap() {
+    thread_local std::mt19937_64 generator(
+        std::random_device{}() ^ std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    double rate = static_cast<double>(state().sampling_rate.load(std::memory_order_relaxed));
+    std::exponential_distribution<double> gap(1.0 / rate);
+    return static_cast<int64_t>(gap(generator)) + 1;
+}
+
+std::string siteKey(const HeapProfiler::Site& site) {
+    std::string key = site.type + '\0' + site.class_name;
+    for (const auto& frame : site.stack) {
+        key += '\0' + frame.function + '\0' + frame.file + '\0' + std::to_string(frame.line);
+    }
+    return key;
+}
+
+uint64_t rounded(double value) {
+    return value > 0 ? static_cast<uint64_t>(std::llround(value)) : 0;
+}
+
+// Just enough of the protobuf wire format for profile.proto
+class ProtoWriter {
+   public:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            out_ += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out_ += static_cast<char>(value);
+    }
+    void integer(int field, uint64_t value) {
+        varint(static_cast<uint64_t>(field) << 3);
+        varint(value);
+    }
+    void bytes(int field, const std::string& data) {
+        varint((static_cast<uint64_t>(field) << 3) | 2);
+        varint(data.size());
+        out_ += data;
+    }
+    void packed(int field, const std::vector<uint64_t>& values) {
+        ProtoWriter body;
+        for (uint64_t value : values) {
+            body.varint(value);
+        }
+        bytes(field, body.out_);
+    }
+    const std::string& str() const {
+        return out_;
+    }
+
+   private:
+    std::string out_;
+};
+
+// Builds the string, function and location tables of a profile as samples refer to them
+class ProfileTables {
+   public:
+    ProfileTables() {
+        index("");
+    }
+
+    uint64_t index(const std::string& text) {
+        auto [found, inserted] = strings_.emplace(text, strings_.size());
+        if (inserted) {
+            order_.push_back(text);
+        }
+        return found->second;
+    }
+
+    uint64_t location(const HeapProfiler::Frame& frame) {
+        uint64_t function = functionId(frame);
+        auto key = std::make_pair(function, frame.line);
+        auto [found, inserted] = locations_.emplace(key, locations_.size() + 1);
+        if (inserted) {
+            ProtoWriter line;
+            line.integer(1, function);
+            line.integer(2, static_cast<uint64_t>(frame.line));
+            ProtoWriter location;
+            location.integer(1, found->second);
+            location.bytes(4, line.str());
+            location_messages_.push_back(location.str());
+        }
+        return found->second;
+    }
+
+    void write(ProtoWriter& profile) const {
+        for (const auto& location : location_messages_) {
+            profile.bytes(4, location);
+        }
+        for (const auto& function : function_messages_) {
+            profile.bytes(5, function);
+        }
+        for (const auto& text : order_) {
+            profile.bytes(6, text);
+        }
+    }
+
+   private:
+    uint64_t functionId(const HeapProfiler::Frame& frame) {
+        auto key = std::make_pair(frame.function, frame.file);
+        auto [found, inserted] = functions_.emplace(key, functions_.size() + 1);
+        if (inserted) {
+            ProtoWriter function;
+            function.integer(1, found->second);
+            function.integer(2, index(frame.function));
+            function.integer(3, index(frame.function));
+            function.integer(4, index(frame.file));
+            function_messages_.push_back(function.str());
+        }
+        return found->second;
+    }
+
+    std::unordered_map<std::string, uint64_t> strings_;
+    std::vector<std::string> order_;
+    std::map<std::pair<std::string, std::string>, uint64_t> functions_;
+    std::vector<std::string> function_messages_;
+    std::map<std::pair<uint64_t, int>, uint64_t> locations_;
+    std::vector<std::string> location_messages_;
+};
+
+// Census of everything reachable from a set of roots, each node counted once
+class CensusWalker {
+   public:
+    void visit(const Value& value) {
+        if (auto object = std::get_if<std::shared_ptr<ObjectInstance>>(&value)) {
+            if (!*object || !seen_.insert(object->get()).second) {
+                return;
+            }
+            uint64_t bytes = sizeof(ObjectInstance);
+            for (const auto& [name, property] : (*object)->getProperties()) {
+                bytes += name.size() + slotBytes(property);
+            }
+            count("Object", (*object)->getName(), bytes);
+            for (const auto& [name, property] : (*object)->getProperties()) {
+                visit(property);
+            }
+        } else if (auto list = std::get_if<std::shared_ptr<ListInstance>>(&value)) {
+            if (!*list || !seen_.insert(list->get()).second) {
+                return;
+            }
+            uint64_t bytes = sizeof(ListInstance);
+            for (const auto& element : (*list)->getElements()) {
+                bytes += slotBytes(element);
+            }
+            count("List", "", bytes);
+            for (const auto& element : (*list)->getElements()) {
+                visit(element);
+            }
+        } else if (auto map = std::get_if<std::shared_ptr<MapInstance>>(&value)) {
+            if (!*map || !seen_.insert(map->get()).second) {
+                return;
+            }
+            uint64_t bytes = sizeof(MapInstance);
+            for (const auto& [key, element] : (*map)->getEntries()) {
+                bytes += slotBytes(key) + slotBytes(element);
+            }
+            count("Map", "", bytes);
+            for (const auto& [key, element] : (*map)->getEntries()) {
+                visit(key);
+                visit(element);
+            }
+        } else if (auto set = std::get_if<std::shared_ptr<SetInstance>>(&value)) {
+            if (!*set || !seen_.insert(set->get()).second) {
+                return;
+            }
+            uint64_t bytes = sizeof(SetInstance);
+            for (const auto& element : (*set)->getElements()) {
+                bytes += slotBytes(element);
+            }
+            count("Set", "", bytes);
+            for (const auto& element : (*set)->getElements()) {
+                visit(element);
+            }
+        } else if (auto record = std::get_if<std::shared_ptr<RecordInstance>>(&value)) {
+            if (!*record || !seen_.insert(record->get()).second) {
+                return;
+            }
+            std::vector<Value> fields;
+            uint64_t bytes = sizeof(RecordInstance);
+            for (const auto& name : (*record)->getFieldNames()) {
+                fields.push_back((*record)->getFieldValue(name));
+                bytes += name.size() + slotBytes(fields.back());
+            }
+            count("Record", (*record)->getTypeName(), bytes);
+            for (const auto& field : fields) {
+                visit(field);
+            }
+        }
+    }
+
+    HeapProfiler::Census result() const {
+        HeapProfiler::Census census;
+        for (const auto& [type, entry] : by_type_) {
+            census.by_type.push_back(entry);
+        }
+        for (const auto& [key, entry] : by_class_) {
+            census.by_class.push_back(entry);
+        }
+        auto larger = [](const HeapProfiler::CensusEntry& a, const HeapProfiler::CensusEntry& b) {
+            return a.bytes != b.bytes ? a.bytes > b.bytes : a.count > b.count;
+        };
+        std::stable_sort(census.by_type.begin(), census.by_type.end(), larger);
+        std::stable_sort(census.by_class.begin(), census.by_class.end(), larger);
+        return census;
+    }
+
+   private:
+    static uint64_t slotBytes(const Value& value) {
+        auto text = std::get_if<Text>(&value);
+        return sizeof(Value) + (text ? text->size() : 0);
+    }
+
+    void count(const std::string& type, const std::string& class_name, uint64_t bytes) {
+        add(by_type_[type], type, "", bytes);
+        if (!class_name.empty()) {
+            add(by_class_[{type, class_name}], type, class_name, bytes);
+        }
+    }
+
+    static void add(HeapProfiler::CensusEntry& entry, const std::string& type,
+                    const std::string& class_name, uint64_t bytes) {
+        entry.type = type;
+        entry.class_name = class_name;
+        entry.count++;
+        entry.bytes += bytes;
+    }
+
+    std::unordered_set<const void*> seen_;
+    std::map<std::string, HeapProfiler::CensusEntry> by_type_;
+    std::map<std::pair<std::string, std::string>, HeapProfiler::CensusEntry> by_class_;
+};
+
+}  // namespace
+
+void HeapProfiler::start(uint64_t sampling_rate) {
+    state().sampling_rate.store(std::max<uint64_t>(sampling_rate, 1),
+                                std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void HeapProfiler::stop() {
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void HeapProfiler::BlockScope::link(const Context& context) {
+    context_ = &context;
+    depth_ = context.getCallDepth();
+    previous_ = top_;
+    top_ = this;
+}
+
+void HeapProfiler::sample(HeapSamples& owner, uint64_t bytes, std::string_view type,
+                          std::string_view class_name) {
+    bool first_on_thread = bytes_until_sample_ + static_cast<int64_t>(bytes) == 0;
+    bytes_until_sample_ = nextSampleGap();
+    if (first_on_thread) {
+        // The thread's first allocation only draws its gap, so it is not always sampled
+        recordAllocation(owner, bytes, type, class_name);
+        return;
+    }
+
+    Site site;
+    site.type = type;
+    site.class_name = class_name;
+    // Innermost block of each call only; blocks nested in one method share its frame
+    const BlockScope* last = nullptr;
+    for (const BlockScope* scope = top_; scope; scope = scope->previous_) {
+        if (last && last->context_ == scope->context_ && last->depth_ == scope->depth_) {
+            continue;
+        }
+        last = scope;
+        Frame frame;
+        if (scope->depth_ == 0) {
+            frame.function = "(top level)";
+        } else {
+            std::vector<std::string> calls = scope->context_->getCallStack();
+            frame.function = scope->depth_ <= calls.size() ? calls[scope->depth_ - 1] : "?";
+        }
+        if (scope->statement_) {
+            const SourceLocation& location = scope->statement_->getSourceLocation();
+            frame.file = location.filename;
+            frame.line = location.line_number;
+        }
+        site.stack.push_back(std::move(frame));
+    }
+    if (site.stack.empty()) {
+        site.stack.push_back({"(runtime)", "", 0});
+    }
+
+    // The chance that an allocation of this size is sampled is 1 - e^(-bytes/rate); dividing
+    // by it makes the expected totals match the unsampled ones
+    double rate = static_cast<double>(state().sampling_rate.load(std::memory_order_relaxed));
+    double scale = 1.0 / -std::expm1(-static_cast<double>(bytes) / rate);
+    double objects = scale;
+    double scaled_bytes = static_cast<double>(bytes) * scale;
+
+    ProfilerState& profiler = state();
+    std::lock_guard<std::mutex> lock(profiler.mutex);
+    std::string key = siteKey(site);
+    auto& totals = profiler.sites[key];
+    if (!totals) {
+        totals = std::make_unique<HeapSiteTotals>();
+        totals->site = std::move(site);
+    }
+    totals->alloc_objects += objects;
+    totals->alloc_bytes += scaled_bytes;
+    totals->live_objects += objects;
+    totals->live_bytes += scaled_bytes;
+    owner.first_ = new HeapSample{totals.get(), objects, scaled_bytes, owner.first_};
+}
+
+void HeapProfiler::release(HeapSamples& owner) {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    HeapSample* sample = owner.first_;
+    while (sample) {
+        sample->site->live_objects -= sample->objects;
+        sample->site->live_bytes -= sample->bytes;
+        HeapSample* next = sample->next;
+        delete sample;
+        sample = next;
+    }
+    owner.first_ = nullptr;
+}
+
+std::vector<HeapProfiler::Site> HeapProfiler::sites() {
+    std::vector<Site> result;
+    {
+        std::lock_guard<std::mutex> lock(state().mutex);
+        for (const auto& [key, totals] : state().sites) {
+            Site site = totals->site;
+            site.alloc_objects = rounded(totals->alloc_objects);
+            site.alloc_bytes = rounded(totals->alloc_bytes);
+            site.live_objects = rounded(totals->live_objects);
+            site.live_bytes = rounded(totals->live_bytes);
+            result.push_back(std::move(site));
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Site& a, const Site& b) {
+        return a.live_bytes != b.live_bytes ? a.live_bytes > b.live_bytes
+                                            : a.alloc_bytes > b.alloc_bytes;
+    });
+    return result;
+}
+
+std::string HeapProfiler::encodeProfile() {
+    ProfileTables tables;
+    ProtoWriter profile;
+
+    auto valueType = [&](const std::string& type, const std::string& unit) {
+        ProtoWriter message;
+        message.integer(1, tables.index(type));
+        message.integer(2, tables.index(unit));
+        return message.str();
+    };
+    profile.bytes(1, valueType("alloc_objects", "count"));
+    profile.bytes(1, valueType("alloc_space", "bytes"));
+    profile.bytes(1, valueType("inuse_objects", "count"));
+    profile.bytes(1, valueType("inuse_space", "bytes"));
+
+    for (const auto& site : sites()) {
+        ProtoWriter sample;
+        std::vector<uint64_t> locations;
+        for (const auto& frame : site.stack) {
+            locations.push_back(tables.location(frame));
+        }
+        sample.packed(1, locations);
+        sample.packed(2, {site.alloc_objects, site.alloc_bytes, site.live_objects,
+                          site.live_bytes});
+        auto label = [&](const std::string& key, const std::string& text) {
+            ProtoWriter message;
+            message.integer(1, tables.index(key));
+            message.integer(2, tables.index(text));
+            sample.bytes(3, message.str());
+        };
+        label("type", site.type);
+        if (!site.class_name.empty()) {
+            label("class", site.class_name);
+        }
+        profile.bytes(2, sample.str());
+    }
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    profile.integer(9, static_cast<uint64_t>(
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()));
+    profile.bytes(11, valueType("space", "bytes"));
+    profile.integer(12, state().sampling_rate.load(std::memory_order_relaxed));
+    profile.integer(14, tables.index("inuse_space"));
+    // The string table goes last: every index above has been assigned by now
+    tables.write(profile);
+    return profile.str();
+}
+
+void HeapProfiler::writeProfile(const std::string& path) {
+    HeapSnapshot::save(path, encodeProfile());
+}
+
+void HeapProfiler::startPeriodicWrites(const std::string& path, std::chrono::seconds interval) {
+    stopPeriodicWrites();
+    ProfilerState& profiler = state();
+    std::lock_guard<std::mutex> lock(profiler.writer_mutex);
+    profiler.writer_path = path;
+    profiler.writer_stopping = false;
+    if (interval.count() <= 0) {
+        return;
+    }
+    profiler.writer = std::thread([&profiler, path, interval]() {
+        std::unique_lock<std::mutex> lock(profiler.writer_mutex);
+        while (!profiler.writer_wakeup.wait_for(lock, interval,
+                                                [&]() { return profiler.writer_stopping; })) {
+            try {
+                writeProfile(path);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << "\n";
+            }
+        }
+    });
+}
+
+void HeapProfiler::stopPeriodicWrites() {
+    ProfilerState& profiler = state();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(profiler.writer_mutex);
+        profiler.writer_stopping = true;
+        path = std::move(profiler.writer_path);
+        profiler.writer_path.clear();
+    }
+    profiler.writer_wakeup.notify_all();
+    if (profiler.writer.joinable()) {
+        profiler.writer.join();
+    }
+    if (!path.empty()) {
+        writeProfile(path);
+    }
+}
+
+HeapProfiler::Census HeapProfiler::census(const Context& context) {
+    CensusWalker walker;
+    for (const auto& name : context.getVariableNames()) {
+        walker.visit(context.lookupVariable(name));
+    }
+    if (context.hasThisObject()) {
+        walker.visit(context.getThisObject());
+    }
+    return walker.result();
+}
+
+}  // namespace o2l
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Value.hpp"
+
+namespace o2l {
+
+class ASTNode;
+class Context;
+
+/**
+ * The allocation samples charged to one runtime object (list, map, set, record or object),
+ * kept as a member of it. Samples stay live until the object is destroyed; a copy is a new
+ * object and starts with none.
+ */
+class HeapSamples {
+   public:
+    HeapSamples() = default;
+    HeapSamples(const HeapSamples&) {}
+    HeapSamples& operator=(const HeapSamples&) {
+        return *this;
+    }
+    ~HeapSamples();
+
+   private:
+    friend class HeapProfiler;
+    struct HeapSample* first_ = nullptr;
+};
+
+/**
+ * Sampling allocation profiler for `o2l run --heap-profile`.
+ *
+ * While started, runtime objects report what they allocate: their own creation and every
+ * value stored into a collection. About one allocation per `sampling_rate` bytes is sampled
+ * (the gaps are drawn from an exponential distribution, so every byte is equally likely to be
+ * picked) and charged to its O²L stack - the `Object.method` calls on the Context and the
+ * source line each of them is running - together with the object's type and class. Sampled
+ * bytes count as live until the object holding them is destroyed. Site totals are scaled up
+ * by the sampling probability, so they estimate all allocations, not just the sampled ones.
+ *
+ * BlockNode keeps the per-thread record of the running statements that stacks are read from;
+ * while the profiler is stopped, every hook costs one relaxed load. Profiles are written in
+ * the pprof format (uncompressed profile.proto) with alloc_objects, alloc_space,
+ * inuse_objects and inuse_space per site, and can be rewritten periodically by a background
+ * thread for long-running programs.
+ *
+ * census() is independent of sampling: it walks everything reachable from a Context and
+ * counts it by type and by class name.
+ */
+class HeapProfiler {
+   public:
+    static constexpr uint64_t kDefaultSamplingRate = 512 * 1024;
+
+    struct Frame {
+        std::string function;  // "Object.method", "(top level)" or "(runtime)"
+        std::string file;
+        int line = 0;
+    };
+
+    // Estimated totals for one allocation site
+    struct Site {
+        std::vector<Frame> stack;  // innermost call first
+        std::string type;          // "Object", "List", "Map", "Set" or "Record"
+        std::string class_name;    // object class or record type; empty for collections
+        uint64_t alloc_objects = 0;
+        uint64_t alloc_bytes = 0;
+        uint64_t live_objects = 0;
+        uint64_t live_bytes = 0;
+    };
+
+    struct CensusEntry {
+        std::string type;
+        std::string class_name;  // empty in by_type
+        uint64_t count = 0;
+        uint64_t bytes = 0;  // estimated shallow size
+    };
+
+    // Largest first
+    struct Census {
+        std::vector<CensusEntry> by_type;
+        std::vector<CensusEntry> by_class;  // objects by class, records by record type
+    };
+
+    // Starts sampling about one allocation per `sampling_rate` bytes (1 samples everything).
+    // Sites recorded earlier are kept
+    static void start(uint64_t sampling_rate = kDefaultSamplingRate);
+    static void stop();
+    static bool isEnabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Called by runtime objects as they allocate, with their own samples as the owner
+    static void recordAllocation(HeapSamples& owner, uint64_t bytes, std::string_view type,
+                                 std::string_view class_name = {}) {
+        if (!isEnabled()) {
+            return;
+        }
+        bytes_until_sample_ -= static_cast<int64_t>(bytes);
+        if (bytes_until_sample_ <= 0) {
+            sample(owner, bytes, type, class_name);
+        }
+    }
+    // A value stored in a collection: its slot plus the characters of a Text
+    static void recordStoredValue(HeapSamples& owner, const Value& value,
+                                  std::string_view type) {
+        if (isEnabled()) {
+            auto text = std::get_if<Text>(&value);
+            recordAllocation(owner, sizeof(Value) + (text ? text->size() : 0), type);
+        }
+    }
+
+    // Every site sampled so far, most live bytes first
+    static std::vector<Site> sites();
+
+    // The sites as a pprof profile
+    static std::string encodeProfile();
+    // Writes the profile to `path` through a temporary file; throws std::runtime_error when
+    // it cannot be written
+    static void writeProfile(const std::string& path);
+    // Rewrites the profile at `path` every `interval` from a background thread until
+    // stopPeriodicWrites(), which writes it a last time
+    static void startPeriodicWrites(const std::string& path, std::chrono::seconds interval);
+    static void stopPeriodicWrites();
+
+    // Counts the objects, lists, maps, sets and records reachable from the variables and
+    // `this` objects of `context`
+    static Census census(const Context& context);
+
+    /**
+     * Marks a block being evaluated on this thread, so samples taken inside it see the
+     * statement it is running. Linked into the thread's chain only while the profiler runs.
+     */
+    class BlockScope {
+       public:
+        explicit BlockScope(const Context& context) {
+            if (isEnabled()) {
+                link(context);
+            }
+        }
+        ~BlockScope() {
+            if (context_) {
+                top_ = previous_;
+            }
+        }
+        BlockScope(const BlockScope&) = delete;
+        BlockScope& operator=(const BlockScope&) = delete;
+
+        void enter(const ASTNode& statement) {
+            statement_ = &statement;
+        }
+
+       private:
+        friend class HeapProfiler;
+        void link(const Context& context);
+
+        const Context* context_ = nullptr;
+        const ASTNode* statement_ = nullptr;
+        size_t depth_ = 0;
+        BlockScope* previous_ = nullptr;
+    };
+
+   private:
+    friend class HeapSamples;
+
+    static void sample(HeapSamples& owner, uint64_t bytes, std::string_view type,
+                       std::string_view class_name);
+    static void release(HeapSamples& owner);
+
+    static std::atomic<bool> enabled_;
+    static thread_local int64_t bytes_until_sample_;
+    static thread_local BlockScope* top_;
+};
+
+inline HeapSamples::~HeapSamples() {
+    if (first_) {
+        HeapProfiler::release(*this);
+    }
+}
+
+}  // namespace o2l
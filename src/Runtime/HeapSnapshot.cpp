@@ -0,0 +1,684 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HeapSnapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "EnumInstance.hpp"
+#include "ListInstance.hpp"
+#include "MapInstance.hpp"
+#include "ObjectInstance.hpp"
+#include "RecordInstance.hpp"
+#include "RecordType.hpp"
+#include "SetInstance.hpp"
+
+namespace o2l {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', '2', 'L', 'S', 'N', 'A', 'P', '\0'};
+
+#ifdef __SIZEOF_INT128__
+// Suppress pedantic warning for __int128 which is a widely supported extension
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+using LongBits = unsigned __int128;
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+using LongBits = unsigned long long;
+#endif
+
+enum class NodeKind : uint8_t { Object = 1, List, Map, Set, Record };
+
+enum class ValueTag : uint8_t {
+    Int = 1,
+    Long,
+    Float,
+    Double,
+    Text,
+    Bool,
+    Char,
+    Node,
+    Enum,
+    RecordType,
+};
+
+// Plain user objects only: native-backed subclasses keep their state outside properties_
+bool isPlainObject(const ObjectInstance& object) {
+    return typeid(object) == typeid(ObjectInstance);
+}
+
+// The top-level declaration `name` resolves to in `globals`, if it is a T
+template <typename T>
+std::shared_ptr<T> findGlobal(const Context& globals, const std::string& name) {
+    if (!globals.hasVariable(name)) {
+        return nullptr;
+    }
+    Value value = globals.getVariable(name);
+    if (auto declared = std::get_if<std::shared_ptr<T>>(&value)) {
+        return *declared;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<ObjectInstance> findTemplate(const Context& globals, const std::string& name) {
+    auto object = findGlobal<ObjectInstance>(globals, name);
+    return object && isPlainObject(*object) ? object : nullptr;
+}
+
+class Writer {
+   public:
+    explicit Writer(const Context& globals) : globals_(globals) {}
+
+    std::string run(uint64_t fingerprint) {
+        // Roots first, in name order, so the same heap always produces the same bytes
+        std::vector<std::pair<std::string, std::shared_ptr<ObjectInstance>>> roots;
+        for (const auto& name : globals_.getVariableNames()) {
+            auto object = findGlobal<ObjectInstance>(globals_, name);
+            // Skip import aliases and native modules: neither owns any heap of its own
+            if (object && isPlainObject(*object) && object->getName() == name) {
+                roots.emplace_back(name, object);
+            }
+        }
+        std::sort(roots.begin(), roots.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [name, object] : roots) {
+            nodeId(object.get(), NodeKind::Object, name);
+            objects_.push_back(object);
+        }
+
+        // Breadth-first, so nodes are written in id order and children follow their parent
+        std::string body;
+        size_t objects_seen = 0;
+        for (size_t id = 0; id < pending_.size(); ++id) {
+            // A copy: pending_ grows while this node's values are written
+            const Pending node = pending_[id];
+            putByte(body, static_cast<uint8_t>(node.kind));
+            switch (node.kind) {
+                case NodeKind::Object: {
+                    const auto& object = objects_[objects_seen++];
+                    putString(body, object->getName());
+                    const auto& properties = object->getProperties();
+                    putU32(body, properties.size());
+                    for (const auto& [name, value] : properties) {
+                        putString(body, name);
+                        putValue(body, value, node.path + "." + name);
+                    }
+                    break;
+                }
+                case NodeKind::List: {
+                    auto list = static_cast<const ListInstance*>(node.address);
+                    putString(body, list->getElementTypeName());
+                    const auto& elements = list->getElements();
+                    putU32(body, elements.size());
+                    for (size_t i = 0; i < elements.size(); ++i) {
+                        putValue(body, elements[i], node.path + "[" + std::to_string(i) + "]");
+                    }
+                    break;
+                }
+                case NodeKind::Map: {
+                    auto map = static_cast<const MapInstance*>(node.address);
+                    putString(body, map->getKeyTypeName());
+                    putString(body, map->getValueTypeName());
+                    putU32(body, map->getEntries().size());
+                    for (const auto& [key, value] : map->getEntries()) {
+                        std::string path = node.path + "[" + valueToString(key) + "]";
+                        putValue(body, key, path);
+                        putValue(body, value, path);
+                    }
+                    break;
+                }
+                case NodeKind::Set: {
+                    auto set = static_cast<const SetInstance*>(node.address);
+                    putString(body, set->getElementTypeName());
+                    putU32(body, set->getElements().size());
+                    for (const auto& element : set->getElements()) {
+                        putValue(body, element, node.path + "{" + valueToString(element) + "}");
+                    }
+                    break;
+                }
+                case NodeKind::Record: {
+                    auto record = static_cast<const RecordInstance*>(node.address);
+                    putString(body, record->getTypeName());
+                    auto fields = record->getFieldNames();
+                    std::sort(fields.begin(), fields.end());
+                    putU32(body, fields.size());
+                    for (const auto& field : fields) {
+                        putString(body, field);
+                        putValue(body, record->getFieldValue(field), node.path + "." + field);
+                    }
+                    break;
+                }
+            }
+        }
+
+        std::string out(kMagic, sizeof(kMagic));
+        putU32(out, HeapSnapshot::kVersion);
+        putU64(out, fingerprint);
+        putU32(out, pending_.size());
+        putU32(out, roots.size());
+        for (const auto& [name, object] : roots) {
+            putString(out, name);
+        }
+        out += body;
+        return out;
+    }
+
+   private:
+    struct Pending {
+        NodeKind kind;
+        const void* address;
+        std::string path;  // where the node was first reached, for error messages
+    };
+
+    uint32_t nodeId(const void* address, NodeKind kind, const std::string& path) {
+        auto [it, inserted] = ids_.emplace(address, static_cast<uint32_t>(pending_.size()));
+        if (inserted) {
+            pending_.push_back({kind, address, path});
+        }
+        return it->second;
+    }
+
+    [[noreturn]] void unsupported(const std::string& path, const std::string& what) const {
+        throw std::runtime_error("Cannot snapshot " + path + ": " + what);
+    }
+
+    void putValue(std::string& out, const Value& value, const std::string& path) {
+        if (auto v = std::get_if<Int>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Int));
+            putU64(out, static_cast<uint64_t>(*v));
+        } else if (auto v = std::get_if<Long>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Long));
+            // Always 128 bits on disk, whatever width Long has in this build
+            putU64(out, static_cast<uint64_t>(*v));
+            if constexpr (sizeof(Long) > sizeof(uint64_t)) {
+                putU64(out, static_cast<uint64_t>(*v >> 64));
+            } else {
+                putU64(out, *v < 0 ? ~0ull : 0);
+            }
+        } else if (auto v = std::get_if<Float>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Float));
+            uint32_t bits;
+            std::memcpy(&bits, v, sizeof(bits));
+            putU32(out, bits);
+        } else if (auto v = std::get_if<Double>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Double));
+            uint64_t bits;
+            std::memcpy(&bits, v, sizeof(bits));
+            putU64(out, bits);
+        } else if (auto v = std::get_if<Text>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Text));
+            putString(out, *v);
+        } else if (auto v = std::get_if<Bool>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Bool));
+            putByte(out, *v ? 1 : 0);
+        } else if (auto v = std::get_if<Char>(&value)) {
+            putByte(out, static_cast<uint8_t>(ValueTag::Char));
+            putByte(out, static_cast<uint8_t>(*v));
+        } else if (auto v = std::get_if<std::shared_ptr<ObjectInstance>>(&value)) {
+            const ObjectInstance& object = **v;
+            if (!isPlainObject(object) || !findTemplate(globals_, object.getName())) {
+                unsupported(path, "'" + object.getName() +
+                                      "' is not an instance of a top-level object");
+            }
+            bool known = ids_.count(v->get()) != 0;
+            putNode(out, nodeId(v->get(), NodeKind::Object, path));
+            if (!known) {
+                objects_.push_back(*v);
+            }
+        } else if (auto v = std::get_if<std::shared_ptr<ListInstance>>(&value)) {
+            putNode(out, nodeId(v->get(), NodeKind::List, path));
+        } else if (auto v = std::get_if<std::shared_ptr<MapInstance>>(&value)) {
+            putNode(out, nodeId(v->get(), NodeKind::Map, path));
+        } else if (auto v = std::get_if<std::shared_ptr<SetInstance>>(&value)) {
+            putNode(out, nodeId(v->get(), NodeKind::Set, path));
+        } else if (auto v = std::get_if<std::shared_ptr<RecordInstance>>(&value)) {
+            if (!findGlobal<RecordType>(globals_, (*v)->getTypeName())) {
+                unsupported(path, "record type '" + (*v)->getTypeName() + "' is not top-level");
+            }
+            putNode(out, nodeId(v->get(), NodeKind::Record, path));
+        } else if (auto v = std::get_if<std::shared_ptr<EnumInstance>>(&value)) {
+            if (findGlobal<EnumInstance>(globals_, (*v)->getEnumName()) != *v) {
+                unsupported(path, "enum '" + (*v)->getEnumName() + "' is not top-level");
+            }
+            putByte(out, static_cast<uint8_t>(ValueTag::Enum));
+            putString(out, (*v)->getEnumName());
+        } else if (auto v = std::get_if<std::shared_ptr<RecordType>>(&value)) {
+            if (findGlobal<RecordType>(globals_, (*v)->getRecordName()) != *v) {
+                unsupported(path, "record type '" + (*v)->getRecordName() + "' is not top-level");
+            }
+            putByte(out, static_cast<uint8_t>(ValueTag::RecordType));
+            putString(out, (*v)->getRecordName());
+        } else {
+            unsupported(path, "values of type " + getTypeName(value) + " cannot be stored");
+        }
+    }
+
+    void putNode(std::string& out, uint32_t id) {
+        putByte(out, static_cast<uint8_t>(ValueTag::Node));
+        putU32(out, id);
+    }
+
+    static void putByte(std::string& out, uint8_t byte) {
+        out.push_back(static_cast<char>(byte));
+    }
+    static void putU32(std::string& out, uint64_t value) {
+        if (value > UINT32_MAX) {
+            throw std::runtime_error("Cannot snapshot: heap too large");
+        }
+        for (int shift = 0; shift < 32; shift += 8) {
+            putByte(out, static_cast<uint8_t>(value >> shift));
+        }
+    }
+    static void putU64(std::string& out, uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            putByte(out, static_cast<uint8_t>(value >> shift));
+        }
+    }
+    static void putString(std::string& out, const std::string& text) {
+        putU32(out, text.size());
+        out += text;
+    }
+
+    const Context& globals_;
+    std::unordered_map<const void*, uint32_t> ids_;
+    std::vector<Pending> pending_;
+    std::vector<std::shared_ptr<ObjectInstance>> objects_;  // object nodes, in id order
+};
+
+class Reader {
+   public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    bool atEnd() const {
+        return position_ == data_.size();
+    }
+
+    const char* take(size_t size) {
+        if (data_.size() - position_ < size) {
+            throw std::runtime_error("Corrupt heap snapshot: unexpected end of data");
+        }
+        const char* bytes = data_.data() + position_;
+        position_ += size;
+        return bytes;
+    }
+    uint8_t byte() {
+        return static_cast<uint8_t>(*take(1));
+    }
+    uint32_t u32() {
+        const char* bytes = take(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+    uint64_t u64() {
+        const char* bytes = take(8);
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+    std::string string() {
+        uint32_t size = u32();
+        return std::string(take(size), size);
+    }
+
+   private:
+    std::string_view data_;
+    size_t position_ = 0;
+};
+
+// A value as stored: scalars are decoded in full, references stay as node ids and names
+struct StoredValue {
+    ValueTag tag;
+    Value scalar;
+    uint32_t node = 0;
+    std::string name;  // enum or record type
+};
+
+struct StoredNode {
+    NodeKind kind;
+    std::string type_name;   // object class, record type, element or key type
+    std::string value_type;  // maps only
+    std::vector<std::string> names;  // property or field names
+    std::vector<StoredValue> values;  // map entries alternate key, value
+};
+
+StoredValue readValue(Reader& in, uint32_t node_count) {
+    StoredValue stored;
+    stored.tag = static_cast<ValueTag>(in.byte());
+    switch (stored.tag) {
+        case ValueTag::Int:
+            stored.scalar = static_cast<Int>(in.u64());
+            break;
+        case ValueTag::Long: {
+            uint64_t low = in.u64();
+            uint64_t high = in.u64();
+            if constexpr (sizeof(Long) > sizeof(uint64_t)) {
+                auto bits = (static_cast<LongBits>(high) << 64) | low;
+                stored.scalar = static_cast<Long>(bits);
+            } else {
+                (void)high;
+                stored.scalar = static_cast<Long>(low);
+            }
+            break;
+        }
+        case ValueTag::Float: {
+            uint32_t bits = in.u32();
+            Float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            stored.scalar = value;
+            break;
+        }
+        case ValueTag::Double: {
+            uint64_t bits = in.u64();
+            Double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            stored.scalar = value;
+            break;
+        }
+        case ValueTag::Text:
+            stored.scalar = in.string();
+            break;
+        case ValueTag::Bool:
+            stored.scalar = in.byte() != 0;
+            break;
+        case ValueTag::Char:
+            stored.scalar = static_cast<Char>(in.byte());
+            break;
+        case ValueTag::Node:
+            stored.node = in.u32();
+            if (stored.node >= node_count) {
+                throw std::runtime_error("Corrupt heap snapshot: reference to missing node");
+            }
+            break;
+        case ValueTag::Enum:
+        case ValueTag::RecordType:
+            stored.name = in.string();
+            break;
+        default:
+            throw std::runtime_error("Corrupt heap snapshot: unknown value tag");
+    }
+    return stored;
+}
+
+// The live heap being rebuilt: one slot per node, allocated before any is filled so
+// references (including cycles) can be resolved to the final shared_ptrs
+struct Heap {
+    std::vector<Value> nodes;
+    std::unordered_map<std::string, std::shared_ptr<EnumInstance>> enums;
+    std::unordered_map<std::string, std::shared_ptr<RecordType>> record_types;
+
+    Value resolve(const StoredValue& stored) const {
+        switch (stored.tag) {
+            case ValueTag::Node:
+                return nodes[stored.node];
+            case ValueTag::Enum:
+                return enums.at(stored.name);
+            case ValueTag::RecordType:
+                return record_types.at(stored.name);
+            default:
+                return stored.scalar;
+        }
+    }
+};
+
+}  // namespace
+
+uint64_t HeapSnapshot::fingerprint(std::string_view data, uint64_t seed) {
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string HeapSnapshot::capture(const Context& globals, uint64_t fingerprint) {
+    return Writer(globals).run(fingerprint);
+}
+
+bool HeapSnapshot::restore(std::string_view data, uint64_t fingerprint, const Context& globals) {
+    Reader in(data);
+    if (data.size() < sizeof(kMagic) + 12 ||
+        std::memcmp(in.take(sizeof(kMagic)), kMagic, sizeof(kMagic)) != 0 ||
+        in.u32() != kVersion || in.u64() != fingerprint) {
+        return false;
+    }
+
+    // Decode everything before touching the live heap, so a bad image changes nothing
+    uint32_t node_count = in.u32();
+    uint32_t root_count = in.u32();
+    if (root_count > node_count) {
+        throw std::runtime_error("Corrupt heap snapshot: more roots than nodes");
+    }
+    std::vector<std::string> roots;
+    for (uint32_t i = 0; i < root_count; ++i) {
+        roots.push_back(in.string());
+    }
+
+    std::vector<StoredNode> stored(node_count);
+    for (auto& node : stored) {
+        node.kind = static_cast<NodeKind>(in.byte());
+        node.type_name = in.string();
+        uint32_t count;
+        switch (node.kind) {
+            case NodeKind::Object:
+            case NodeKind::Record:
+                count = in.u32();
+                for (uint32_t i = 0; i < count; ++i) {
+                    node.names.push_back(in.string());
+                    node.values.push_back(readValue(in, node_count));
+                }
+                break;
+            case NodeKind::Map:
+                node.value_type = in.string();
+                count = in.u32();
+                for (uint32_t i = 0; i < count * 2; ++i) {
+                    node.values.push_back(readValue(in, node_count));
+                }
+                break;
+            case NodeKind::List:
+            case NodeKind::Set:
+                count = in.u32();
+                for (uint32_t i = 0; i < count; ++i) {
+                    node.values.push_back(readValue(in, node_count));
+                }
+                break;
+            default:
+                throw std::runtime_error("Corrupt heap snapshot: unknown node kind");
+        }
+    }
+    if (!in.atEnd()) {
+        throw std::runtime_error("Corrupt heap snapshot: trailing data");
+    }
+
+    // Resolve every name against the declared program, then allocate the nodes
+    auto mismatch = [](const std::string& what) {
+        throw std::runtime_error("Heap snapshot does not match the program: " + what);
+    };
+    Heap heap;
+    heap.nodes.resize(node_count);
+    for (uint32_t id = 0; id < node_count; ++id) {
+        const StoredNode& node = stored[id];
+        for (const auto& value : node.values) {
+            if (value.tag == ValueTag::Enum && !heap.enums.count(value.name)) {
+                auto declared = findGlobal<EnumInstance>(globals, value.name);
+                if (!declared) {
+                    mismatch("no enum '" + value.name + "'");
+                }
+                heap.enums.emplace(value.name, declared);
+            } else if (value.tag == ValueTag::RecordType && !heap.record_types.count(value.name)) {
+                auto declared = findGlobal<RecordType>(globals, value.name);
+                if (!declared) {
+                    mismatch("no record type '" + value.name + "'");
+                }
+                heap.record_types.emplace(value.name, declared);
+            }
+        }
+
+        switch (node.kind) {
+            case NodeKind::Object: {
+                const std::string& name = id < root_count ? roots[id] : node.type_name;
+                auto declared = findTemplate(globals, name);
+                if (!declared || declared->getName() != node.type_name) {
+                    mismatch("no object '" + name + "'");
+                }
+                // Top-level objects are filled in place; others start as a copy of their class
+                heap.nodes[id] =
+                    id < root_count ? declared : std::make_shared<ObjectInstance>(*declared);
+                break;
+            }
+            case NodeKind::List:
+                heap.nodes[id] = std::make_shared<ListInstance>(node.type_name);
+                break;
+            case NodeKind::Map:
+                heap.nodes[id] = std::make_shared<MapInstance>(node.type_name, node.value_type);
+                break;
+            case NodeKind::Set:
+                heap.nodes[id] = std::make_shared<SetInstance>(node.type_name);
+                break;
+            case NodeKind::Record:
+                if (!findGlobal<RecordType>(globals, node.type_name)) {
+                    mismatch("no record type '" + node.type_name + "'");
+                }
+                heap.nodes[id] = std::make_shared<RecordInstance>(
+                    node.type_name, std::unordered_map<std::string, Value>());
+                break;
+        }
+    }
+
+    // Fill children before parents (they have higher ids), so set ordering and record
+    // contents see finished values everywhere but across a cycle
+    for (uint32_t id = node_count; id-- > 0;) {
+        const StoredNode& node = stored[id];
+        const Value& slot = heap.nodes[id];
+        switch (node.kind) {
+            case NodeKind::Object: {
+                auto& object = std::get<std::shared_ptr<ObjectInstance>>(slot);
+                for (size_t i = 0; i < node.names.size(); ++i) {
+                    object->setProperty(node.names[i], heap.resolve(node.values[i]));
+                }
+                break;
+            }
+            case NodeKind::List: {
+                auto& list = std::get<std::shared_ptr<ListInstance>>(slot);
+                for (const auto& value : node.values) {
+                    list->add(heap.resolve(value));
+                }
+                break;
+            }
+            case NodeKind::Map: {
+                auto& map = std::get<std::shared_ptr<MapInstance>>(slot);
+                for (size_t i = 0; i + 1 < node.values.size(); i += 2) {
+                    map->put(heap.resolve(node.values[i]), heap.resolve(node.values[i + 1]));
+                }
+                break;
+            }
+            case NodeKind::Set: {
+                auto& set = std::get<std::shared_ptr<SetInstance>>(slot);
+                for (const auto& value : node.values) {
+                    set->add(heap.resolve(value));
+                }
+                break;
+            }
+            case NodeKind::Record: {
+                std::unordered_map<std::string, Value> fields;
+                for (size_t i = 0; i < node.names.size(); ++i) {
+                    fields.emplace(node.names[i], heap.resolve(node.values[i]));
+                }
+                // Assigned in place: the shared_ptr may already be referenced from other nodes
+                auto& record = std::get<std::shared_ptr<RecordInstance>>(slot);
+                *record = RecordInstance(node.type_name, std::move(fields));
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void HeapSnapshot::save(const std::string& path, const std::string& data) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            throw std::runtime_error("Cannot write heap snapshot '" + path + "'");
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Cannot write heap snapshot '" + path + "'");
+    }
+}
+
+bool HeapSnapshot::load(const std::string& path, uint64_t fingerprint, const Context& globals) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped != MAP_FAILED) {
+        std::unique_ptr<void, std::function<void(void*)>> unmap(
+            mapped, [size](void* address) { ::munmap(address, size); });
+        return restore(std::string_view(static_cast<const char*>(mapped), size), fingerprint,
+                       globals);
+    }
+#endif
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return restore(data, fingerprint, globals);
+}
+
+}  // namespace o2l
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Context.hpp"
+
+namespace o2l {
+
+/**
+ * Binary image of the program's global heap, for `o2l run --snapshot`.
+ *
+ * A snapshot holds the properties of every top-level object (the program's own objects and
+ * those of imported user modules) and everything reachable from them: object instances,
+ * lists, maps, sets and records. Each of those is written once as a numbered node and
+ * referenced by number, so shared references and cycles come back as the same shape of
+ * shared_ptr graph. Enums, record types and object classes are stored by name and resolved
+ * against the freshly declared program on restore; top-level objects are restored in place,
+ * keeping any references the declaration pass already handed out.
+ *
+ * Code is not part of the image: methods close over the AST, so the program is still parsed
+ * and declared on every run. The fingerprint passed in identifies that code, and a snapshot
+ * taken for a different fingerprint is ignored.
+ */
+class HeapSnapshot {
+   public:
+    static constexpr uint32_t kVersion = 1;
+
+    // FNV-1a over `data`, continuing from `seed` so several inputs can be chained
+    static uint64_t fingerprint(std::string_view data, uint64_t seed = 14695981039346656037ull);
+
+    // Serializes the heap reachable from the top-level objects in `globals`. Throws
+    // std::runtime_error naming the offending property for values that cannot be stored
+    // (iterators, errors, native objects, FFI handles).
+    static std::string capture(const Context& globals, uint64_t fingerprint);
+
+    // Rebuilds the heap in `data` into `globals`. Returns false, leaving `globals` untouched,
+    // if `data` is not a snapshot of this version and fingerprint; throws std::runtime_error
+    // if it is but cannot be decoded or no longer matches the declared program.
+    static bool restore(std::string_view data, uint64_t fingerprint, const Context& globals);
+
+    // Writes `data` to `path` through a temporary file, so readers never see a partial image
+    static void save(const std::string& path, const std::string& data);
+    // Maps the file at `path` and restores it; false if there is no usable snapshot there
+    static bool load(const std::string& path, uint64_t fingerprint, const Context& globals);
+};
+
+}  // namespace o2l
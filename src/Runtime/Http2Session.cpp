@@ -0,0 +1,837 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Http2Session.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+
+namespace o2l {
+
+namespace http2 {
+
+void appendFrameHeader(std::string& out, size_t length, FrameType type, uint8_t flags,
+                       uint32_t stream_id) {
+    out.push_back(static_cast<char>((length >> 16) & 0xFF));
+    out.push_back(static_cast<char>((length >> 8) & 0xFF));
+    out.push_back(static_cast<char>(length & 0xFF));
+    out.push_back(static_cast<char>(type));
+    out.push_back(static_cast<char>(flags));
+    stream_id &= 0x7FFFFFFF;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((stream_id >> shift) & 0xFF));
+    }
+}
+
+}  // namespace http2
+
+namespace {
+
+using http2::FrameType;
+
+uint32_t readUint32(const uint8_t* data) {
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) |
+           uint32_t(data[3]);
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+void appendSetting(std::string& out, uint16_t id, uint32_t value) {
+    out.push_back(static_cast<char>(id >> 8));
+    out.push_back(static_cast<char>(id & 0xFF));
+    appendUint32(out, value);
+}
+
+// Hop-by-hop headers have no meaning in HTTP/2 (RFC 9113 8.2.2)
+bool isConnectionSpecific(const std::string& name) {
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+           name == "transfer-encoding" || name == "upgrade";
+}
+
+std::string toLower(const std::string& text) {
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+// HTTP2-Settings is base64url without padding (RFC 7540 3.2.1); plain base64 is tolerated
+bool base64UrlDecode(const std::string& input, std::string& out) {
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-' || c == '+') value = 62;
+        else if (c == '_' || c == '/') value = 63;
+        else if (c == '=') break;
+        else return false;
+
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+Http2Session::Http2Session(Callbacks callbacks, Limits limits)
+    : callbacks_(std::move(callbacks)),
+      limits_(limits),
+      decoder_(4096, limits.max_header_block),
+      connection_receive_window_(http2::kDefaultWindowSize) {}
+
+void Http2Session::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string out;
+    std::string settings;
+    appendSetting(settings, http2::kSettingMaxConcurrentStreams, limits_.max_concurrent_streams);
+    appendSetting(settings, http2::kSettingInitialWindowSize, limits_.initial_window_size);
+    appendSetting(settings, http2::kSettingMaxHeaderListSize,
+                  static_cast<uint32_t>(limits_.max_header_block));
+    http2::appendFrameHeader(out, settings.size(), FrameType::Settings, 0, 0);
+    out += settings;
+
+    // The connection window is not covered by SETTINGS; raise it to match
+    if (limits_.initial_window_size > http2::kDefaultWindowSize) {
+        uint32_t increment = limits_.initial_window_size - http2::kDefaultWindowSize;
+        http2::appendFrameHeader(out, 4, FrameType::WindowUpdate, 0, 0);
+        appendUint32(out, increment);
+        connection_receive_window_ += increment;
+    }
+    callbacks_.write(out);
+}
+
+bool Http2Session::startUpgrade(const std::string& settings_header, HttpServerRequest request) {
+    std::string settings;
+    if (!base64UrlDecode(settings_header, settings) || settings.size() % 6 != 0) {
+        return false;
+    }
+
+    start();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!applySettings(reinterpret_cast<const uint8_t*>(settings.data()), settings.size())) {
+        return false;
+    }
+
+    // The request that carried the upgrade is stream 1, already half-closed by the client
+    Stream& stream = streams_[1];
+    stream.request = std::move(request);
+    stream.remote_closed = true;
+    stream.head_request = stream.request.method == "HEAD";
+    stream.send_window = peer_initial_window_;
+    last_stream_id_ = 1;
+    dispatchStream(1, stream);
+    return true;
+}
+
+bool Http2Session::receive(const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_) {
+        return false;
+    }
+
+    // Parse straight from the caller's buffer unless a partial frame is carried over
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t available = size;
+    if (!in_buffer_.empty()) {
+        in_buffer_.append(data, size);
+        bytes = reinterpret_cast<const uint8_t*>(in_buffer_.data());
+        available = in_buffer_.size();
+    }
+
+    size_t offset = 0;
+    if (!preface_received_) {
+        size_t compared = std::min(available, http2::kClientPreface.size());
+        if (http2::kClientPreface.compare(0, compared,
+                                          std::string_view(reinterpret_cast<const char*>(bytes),
+                                                           compared)) != 0) {
+            closed_ = true;  // not HTTP/2; nothing sensible to answer
+            return false;
+        }
+        if (compared < http2::kClientPreface.size()) {
+            in_buffer_.assign(reinterpret_cast<const char*>(bytes), available);
+            return true;
+        }
+        preface_received_ = true;
+        offset = http2::kClientPreface.size();
+    }
+
+    while (available - offset >= http2::kFrameHeaderSize) {
+        const uint8_t* header = bytes + offset;
+        size_t length = (size_t(header[0]) << 16) | (size_t(header[1]) << 8) | header[2];
+        if (length > http2::kDefaultMaxFrameSize) {
+            in_buffer_.clear();
+            return connectionError(http2::kFrameSizeError);
+        }
+        if (available - offset < http2::kFrameHeaderSize + length) {
+            break;
+        }
+
+        auto type = static_cast<FrameType>(header[3]);
+        uint8_t flags = header[4];
+        uint32_t stream_id = readUint32(header + 5) & 0x7FFFFFFF;
+        if (!processFrame(type, flags, stream_id, header + http2::kFrameHeaderSize, length)) {
+            std::string().swap(in_buffer_);
+            return false;
+        }
+        offset += http2::kFrameHeaderSize + length;
+    }
+
+    if (bytes == reinterpret_cast<const uint8_t*>(data)) {
+        in_buffer_.assign(data + offset, size - offset);
+    } else {
+        in_buffer_.erase(0, offset);
+    }
+    if (in_buffer_.empty()) {
+        std::string().swap(in_buffer_);
+    }
+    return !closed_;
+}
+
+bool Http2Session::processFrame(FrameType type, uint8_t flags, uint32_t stream_id,
+                                const uint8_t* payload, size_t length) {
+    // A header block must be contiguous: nothing may interleave with its CONTINUATIONs
+    if (continuation_stream_ != 0 &&
+        (type != FrameType::Continuation || stream_id != continuation_stream_)) {
+        return connectionError(http2::kProtocolError);
+    }
+
+    switch (type) {
+        case FrameType::Data:
+            return onData(flags, stream_id, payload, length);
+
+        case FrameType::Headers:
+            return onHeaders(flags, stream_id, payload, length);
+
+        case FrameType::Continuation:
+            if (continuation_stream_ == 0) {
+                return connectionError(http2::kProtocolError);
+            }
+            if (header_block_.size() + length > limits_.max_header_block) {
+                return connectionError(http2::kEnhanceYourCalm);
+            }
+            header_block_.append(reinterpret_cast<const char*>(payload), length);
+            if (flags & http2::kFlagEndHeaders) {
+                continuation_stream_ = 0;
+                return onHeaderBlockComplete(stream_id, continuation_end_stream_);
+            }
+            return true;
+
+        case FrameType::Priority:
+            // Accepted and ignored; responses go out in stream order
+            if (stream_id == 0) {
+                return connectionError(http2::kProtocolError);
+            }
+            if (length != 5) {
+                writeRstStream(stream_id, http2::kFrameSizeError);
+            }
+            return true;
+
+        case FrameType::RstStream:
+            if (stream_id == 0 || stream_id > last_stream_id_) {
+                return connectionError(http2::kProtocolError);
+            }
+            if (length != 4) {
+                return connectionError(http2::kFrameSizeError);
+            }
+            streams_.erase(stream_id);
+            closeIfIdle();
+            return !closed_;
+
+        case FrameType::Settings:
+            return onSettings(flags, stream_id, payload, length);
+
+        case FrameType::PushPromise:
+            // Clients cannot push
+            return connectionError(http2::kProtocolError);
+
+        case FrameType::Ping: {
+            if (stream_id != 0) {
+                return connectionError(http2::kProtocolError);
+            }
+            if (length != 8) {
+                return connectionError(http2::kFrameSizeError);
+            }
+            if (!(flags & http2::kFlagAck)) {
+                std::string pong;
+                http2::appendFrameHeader(pong, 8, FrameType::Ping, http2::kFlagAck, 0);
+                pong.append(reinterpret_cast<const char*>(payload), 8);
+                callbacks_.write(pong);
+            }
+            return true;
+        }
+
+        case FrameType::GoAway:
+            if (stream_id != 0) {
+                return connectionError(http2::kProtocolError);
+            }
+            // Finish what is in flight, accept nothing new
+            going_away_ = true;
+            closeIfIdle();
+            return !closed_;
+
+        case FrameType::WindowUpdate:
+            return onWindowUpdate(stream_id, payload, length);
+    }
+
+    // Unknown frame types are ignored (RFC 9113 4.1)
+    return true;
+}
+
+bool Http2Session::onHeaders(uint8_t flags, uint32_t stream_id, const uint8_t* payload,
+                             size_t length) {
+    if (stream_id == 0 || (stream_id & 1) == 0) {
+        return connectionError(http2::kProtocolError);
+    }
+
+    size_t padding = 0;
+    if (flags & http2::kFlagPadded) {
+        if (length < 1) {
+            return connectionError(http2::kProtocolError);
+        }
+        padding = payload[0];
+        ++payload;
+        --length;
+    }
+    if (flags & http2::kFlagPriority) {
+        if (length < 5) {
+            return connectionError(http2::kProtocolError);
+        }
+        payload += 5;
+        length -= 5;
+    }
+    if (padding > length) {
+        return connectionError(http2::kProtocolError);
+    }
+    length -= padding;
+    if (length > limits_.max_header_block) {
+        return connectionError(http2::kEnhanceYourCalm);
+    }
+
+    header_block_.assign(reinterpret_cast<const char*>(payload), length);
+    continuation_end_stream_ = flags & http2::kFlagEndStream;
+    if (flags & http2::kFlagEndHeaders) {
+        return onHeaderBlockComplete(stream_id, continuation_end_stream_);
+    }
+    continuation_stream_ = stream_id;
+    return true;
+}
+
+bool Http2Session::onHeaderBlockComplete(uint32_t stream_id, bool end_stream) {
+    // Decode even for streams that will be refused: the HPACK state is connection-wide
+    hpack::HeaderList fields;
+    bool decoded = decoder_.decode(reinterpret_cast<const uint8_t*>(header_block_.data()),
+                                   header_block_.size(), fields);
+    std::string().swap(header_block_);
+    if (!decoded) {
+        // Decoding stopped mid-block, so the HPACK state is lost either way
+        return connectionError(decoder_.listSizeExceeded() ? http2::kEnhanceYourCalm
+                                                           : http2::kCompressionError);
+    }
+
+    auto existing = streams_.find(stream_id);
+    if (existing != streams_.end()) {
+        // Trailers: must end the stream; their fields are not passed on
+        Stream& stream = existing->second;
+        if (stream.remote_closed || !end_stream) {
+            writeRstStream(stream_id, http2::kProtocolError);
+            streams_.erase(existing);
+            return true;
+        }
+        stream.remote_closed = true;
+        if (!stream.discard_body) {
+            dispatchStream(stream_id, stream);
+        }
+        return true;
+    }
+
+    if (stream_id <= last_stream_id_) {
+        return connectionError(http2::kStreamClosed);
+    }
+    last_stream_id_ = stream_id;
+
+    if (going_away_ || streams_.size() >= limits_.max_concurrent_streams) {
+        writeRstStream(stream_id, http2::kRefusedStream);
+        return true;
+    }
+
+    Stream stream;
+    HttpServerRequest& request = stream.request;
+    std::string authority;
+    bool regular_seen = false;
+    bool malformed = false;
+    for (auto& field : fields) {
+        if (field.name.empty()) {
+            malformed = true;
+        } else if (field.name[0] == ':') {
+            // Pseudo-headers come first
+            if (regular_seen) {
+                malformed = true;
+            } else if (field.name == ":method") {
+                request.method = std::move(field.value);
+            } else if (field.name == ":path") {
+                request.path = std::move(field.value);
+            } else if (field.name == ":authority") {
+                authority = std::move(field.value);
+            } else if (field.name != ":scheme") {
+                malformed = true;
+            }
+        } else {
+            regular_seen = true;
+            if (std::any_of(field.name.begin(), field.name.end(),
+                            [](char c) { return c >= 'A' && c <= 'Z'; }) ||
+                isConnectionSpecific(field.name)) {
+                malformed = true;
+                continue;
+            }
+            auto [it, inserted] = request.headers.emplace(field.name, field.value);
+            if (!inserted) {
+                it->second += (field.name == "cookie" ? "; " : ", ") + field.value;
+            }
+        }
+    }
+    if (malformed || request.method.empty() || request.path.empty()) {
+        writeRstStream(stream_id, http2::kProtocolError);
+        return true;
+    }
+
+    if (!authority.empty() && request.headers.find("host") == request.headers.end()) {
+        request.headers["host"] = authority;
+    }
+    size_t query = request.path.find('?');
+    if (query != std::string::npos) {
+        request.query_string = request.path.substr(query + 1);
+        request.path.resize(query);
+    }
+
+    stream.head_request = request.method == "HEAD";
+    stream.send_window = peer_initial_window_;
+    stream.remote_closed = end_stream;
+    Stream& inserted = streams_.emplace(stream_id, std::move(stream)).first->second;
+    if (end_stream) {
+        dispatchStream(stream_id, inserted);
+    }
+    return true;
+}
+
+bool Http2Session::onData(uint8_t flags, uint32_t stream_id, const uint8_t* payload,
+                          size_t length) {
+    if (stream_id == 0) {
+        return connectionError(http2::kProtocolError);
+    }
+
+    // Flow control counts the whole payload, padding included
+    if (static_cast<int64_t>(length) > connection_receive_window_) {
+        return connectionError(http2::kFlowControlError);
+    }
+    connection_receive_window_ -= static_cast<int64_t>(length);
+    connection_received_unacked_ += static_cast<uint32_t>(length);
+    if (connection_received_unacked_ >= limits_.initial_window_size / 2) {
+        writeWindowUpdate(0, connection_received_unacked_);
+        connection_receive_window_ += connection_received_unacked_;
+        connection_received_unacked_ = 0;
+    }
+
+    size_t padding = 0;
+    if (flags & http2::kFlagPadded) {
+        if (length < 1) {
+            return connectionError(http2::kProtocolError);
+        }
+        padding = payload[0];
+        ++payload;
+        --length;
+    }
+    if (padding > length) {
+        return connectionError(http2::kProtocolError);
+    }
+    length -= padding;
+
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        if (stream_id > last_stream_id_) {
+            return connectionError(http2::kProtocolError);
+        }
+        writeRstStream(stream_id, http2::kStreamClosed);
+        return true;
+    }
+    Stream& stream = it->second;
+    if (stream.remote_closed) {
+        writeRstStream(stream_id, http2::kStreamClosed);
+        streams_.erase(it);
+        closeIfIdle();
+        return !closed_;
+    }
+
+    stream.received_unacked += static_cast<uint32_t>(length + padding);
+    if (stream.received_unacked > limits_.initial_window_size) {
+        writeRstStream(stream_id, http2::kFlowControlError);
+        streams_.erase(it);
+        closeIfIdle();
+        return !closed_;
+    }
+
+    bool end_stream = flags & http2::kFlagEndStream;
+    if (!stream.discard_body) {
+        if (stream.request.body.size() + length > limits_.max_request_size) {
+            // Answer now; the rest of the upload is read and dropped
+            stream.discard_body = true;
+            std::string().swap(stream.request.body);
+            stream.remote_closed = end_stream;
+            HttpServerResponse too_large;
+            too_large.status_code = 413;
+            too_large.status_message = httpStatusMessage(413);
+            too_large.body = "413 - Request Entity Too Large";
+            respondLocked(stream_id, stream, too_large);
+            return !closed_;
+        }
+        stream.request.body.append(reinterpret_cast<const char*>(payload), length);
+    }
+
+    if (end_stream) {
+        stream.remote_closed = true;
+        if (!stream.discard_body) {
+            dispatchStream(stream_id, stream);
+        }
+    } else if (stream.received_unacked >= limits_.initial_window_size / 2) {
+        writeWindowUpdate(stream_id, stream.received_unacked);
+        stream.received_unacked = 0;
+    }
+    return true;
+}
+
+bool Http2Session::onSettings(uint8_t flags, uint32_t stream_id, const uint8_t* payload,
+                              size_t length) {
+    if (stream_id != 0) {
+        return connectionError(http2::kProtocolError);
+    }
+    if (flags & http2::kFlagAck) {
+        return length == 0 || connectionError(http2::kFrameSizeError);
+    }
+    if (length % 6 != 0) {
+        return connectionError(http2::kFrameSizeError);
+    }
+    if (!applySettings(payload, length)) {
+        return false;
+    }
+
+    std::string ack;
+    http2::appendFrameHeader(ack, 0, FrameType::Settings, http2::kFlagAck, 0);
+    callbacks_.write(ack);
+
+    // A larger initial window may unblock bodies
+    flushData();
+    return true;
+}
+
+bool Http2Session::applySettings(const uint8_t* payload, size_t length) {
+    for (size_t i = 0; i + 6 <= length; i += 6) {
+        uint16_t id = static_cast<uint16_t>((payload[i] << 8) | payload[i + 1]);
+        uint32_t value = readUint32(payload + i + 2);
+
+        switch (id) {
+            case http2::kSettingHeaderTableSize:
+                encoder_.setMaxTableSize(value);
+                break;
+            case http2::kSettingEnablePush:
+                if (value > 1) {
+                    return connectionError(http2::kProtocolError);
+                }
+                break;
+            case http2::kSettingInitialWindowSize: {
+                if (value > http2::kMaxWindowSize) {
+                    return connectionError(http2::kFlowControlError);
+                }
+                // Applies retroactively to every open stream (RFC 9113 6.9.2)
+                int64_t delta = static_cast<int64_t>(value) - peer_initial_window_;
+                for (auto& entry : streams_) {
+                    entry.second.send_window += delta;
+                    if (entry.second.send_window > http2::kMaxWindowSize) {
+                        return connectionError(http2::kFlowControlError);
+                    }
+                }
+                peer_initial_window_ = value;
+                break;
+            }
+            case http2::kSettingMaxFrameSize:
+                if (value < http2::kDefaultMaxFrameSize || value > 0xFFFFFF) {
+                    return connectionError(http2::kProtocolError);
+                }
+                peer_max_frame_size_ = value;
+                break;
+            default:
+                break;  // MAX_CONCURRENT_STREAMS etc. only limit pushes, which we never make
+        }
+    }
+    return true;
+}
+
+bool Http2Session::onWindowUpdate(uint32_t stream_id, const uint8_t* payload, size_t length) {
+    if (length != 4) {
+        return connectionError(http2::kFrameSizeError);
+    }
+    uint32_t increment = readUint32(payload) & 0x7FFFFFFF;
+
+    if (stream_id == 0) {
+        if (increment == 0) {
+            return connectionError(http2::kProtocolError);
+        }
+        connection_send_window_ += increment;
+        if (connection_send_window_ > http2::kMaxWindowSize) {
+            return connectionError(http2::kFlowControlError);
+        }
+    } else {
+        auto it = streams_.find(stream_id);
+        if (it == streams_.end()) {
+            // Closed streams may still see updates in flight; idle ones may not
+            return stream_id <= last_stream_id_ || connectionError(http2::kProtocolError);
+        }
+        Stream& stream = it->second;
+        if (increment == 0 || stream.send_window + increment > http2::kMaxWindowSize) {
+            writeRstStream(stream_id,
+                           increment == 0 ? http2::kProtocolError : http2::kFlowControlError);
+            streams_.erase(it);
+            closeIfIdle();
+            return !closed_;
+        }
+        stream.send_window += increment;
+    }
+
+    flushData();
+    return !closed_;
+}
+
+void Http2Session::dispatchStream(uint32_t stream_id, Stream& stream) {
+    callbacks_.dispatch(stream_id, std::move(stream.request));
+    stream.request = HttpServerRequest();
+}
+
+void Http2Session::respond(uint32_t stream_id, const HttpServerResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(stream_id);
+    if (closed_ || it == streams_.end() || it->second.responded) {
+        return;  // reset by the client, or the connection is gone
+    }
+    respondLocked(stream_id, it->second, response);
+}
+
+void Http2Session::respondLocked(uint32_t stream_id, Stream& stream,
+                                 const HttpServerResponse& response) {
+    stream.responded = true;
+
+    hpack::HeaderList headers;
+    headers.reserve(response.headers.size() + 4);
+    headers.push_back({":status", std::to_string(response.status_code)});
+
+    bool has_length = false;
+    bool has_server = false;
+    bool has_date = false;
+    for (const auto& [name, value] : response.headers) {
+        std::string lower = toLower(name);
+        if (isConnectionSpecific(lower)) {
+            continue;
+        }
+        has_length = has_length || lower == "content-length";
+        has_server = has_server || lower == "server";
+        has_date = has_date || lower == "date";
+        headers.push_back({std::move(lower), value});
+    }
+    if (response.static_body) {
+        for (const auto& [name, value] : response.static_body->fields) {
+            if (!response.headers.count(name)) {
+                has_length = has_length || name == "Content-Length";
+                headers.push_back({toLower(name), value});
+            }
+        }
+    }
+
+    bool bodiless = response.status_code == 204 || response.status_code == 304;
+    if (!has_length && !bodiless) {
+        headers.push_back({"content-length", std::to_string(response.getBodySize())});
+    }
+    if (!has_server) {
+        headers.push_back({"server", "O2L-HTTP-Server/1.0"});
+    }
+    if (!has_date) {
+        headers.push_back({"date", httpDate(std::time(nullptr))});
+    }
+
+    bool send_body = !bodiless && !stream.head_request && response.getBodySize() > 0;
+    writeHeaders(stream_id, headers, !send_body);
+    if (!send_body) {
+        if (!stream.remote_closed) {
+            writeRstStream(stream_id, http2::kNoError);
+        }
+        streams_.erase(stream_id);
+        closeIfIdle();
+        return;
+    }
+
+    // Cached static bodies are shared, not copied
+    if (response.static_body) {
+        stream.static_body = response.static_body;
+    } else {
+        stream.pending_body = response.body;
+    }
+    stream.body_offset = 0;
+    flushData();
+}
+
+void Http2Session::flushData() {
+    std::string batch;
+    auto writeBatch = [&]() {
+        if (!batch.empty()) {
+            callbacks_.write(batch);
+            batch.clear();
+        }
+    };
+
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        Stream& stream = it->second;
+        if (!stream.responded) {
+            ++it;
+            continue;
+        }
+
+        std::string_view body = stream.body();
+        while (stream.body_offset < body.size() && connection_send_window_ > 0 &&
+               stream.send_window > 0) {
+            // Leave the rest for resume() once the socket has caught up
+            if (callbacks_.buffered && callbacks_.buffered() + batch.size() > kOutputHighWater) {
+                writeBatch();
+                return;
+            }
+            size_t remaining = body.size() - stream.body_offset;
+            size_t chunk = std::min<size_t>(
+                {remaining, peer_max_frame_size_, static_cast<size_t>(connection_send_window_),
+                 static_cast<size_t>(stream.send_window)});
+            bool last = chunk == remaining;
+            http2::appendFrameHeader(batch, chunk, FrameType::Data,
+                                     last ? http2::kFlagEndStream : 0, it->first);
+            batch.append(body.substr(stream.body_offset, chunk));
+            stream.body_offset += chunk;
+            connection_send_window_ -= static_cast<int64_t>(chunk);
+            stream.send_window -= static_cast<int64_t>(chunk);
+            if (batch.size() >= 64 * 1024) {
+                writeBatch();
+            }
+        }
+
+        if (stream.body_offset < body.size()) {
+            ++it;
+            continue;
+        }
+        // Body complete; an upload we stopped reading is cut off cleanly
+        if (!stream.remote_closed) {
+            writeBatch();
+            writeRstStream(it->first, http2::kNoError);
+        }
+        it = streams_.erase(it);
+    }
+    writeBatch();
+    closeIfIdle();
+}
+
+void Http2Session::resume() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!closed_) {
+        flushData();
+    }
+}
+
+size_t Http2Session::getOpenStreams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+void Http2Session::writeHeaders(uint32_t stream_id, const hpack::HeaderList& headers,
+                                bool end_stream) {
+    std::string block;
+    encoder_.encode(headers, block);
+
+    // Split across CONTINUATION frames if the block exceeds the peer's frame size
+    std::string out;
+    size_t offset = 0;
+    bool first = true;
+    do {
+        size_t chunk = std::min<size_t>(block.size() - offset, peer_max_frame_size_);
+        bool last = offset + chunk == block.size();
+        uint8_t flags = last ? http2::kFlagEndHeaders : 0;
+        if (first && end_stream) {
+            flags |= http2::kFlagEndStream;
+        }
+        http2::appendFrameHeader(out, chunk, first ? FrameType::Headers : FrameType::Continuation,
+                                 flags, stream_id);
+        out.append(block, offset, chunk);
+        offset += chunk;
+        first = false;
+    } while (offset < block.size());
+    callbacks_.write(out);
+}
+
+void Http2Session::writeRstStream(uint32_t stream_id, uint32_t error) {
+    std::string out;
+    http2::appendFrameHeader(out, 4, FrameType::RstStream, 0, stream_id);
+    appendUint32(out, error);
+    callbacks_.write(out);
+}
+
+void Http2Session::writeWindowUpdate(uint32_t stream_id, uint32_t increment) {
+    std::string out;
+    http2::appendFrameHeader(out, 4, FrameType::WindowUpdate, 0, stream_id);
+    appendUint32(out, increment);
+    callbacks_.write(out);
+}
+
+bool Http2Session::connectionError(uint32_t error) {
+    if (!closed_) {
+        std::string out;
+        http2::appendFrameHeader(out, 8, FrameType::GoAway, 0, 0);
+        appendUint32(out, last_stream_id_);
+        appendUint32(out, error);
+        callbacks_.write(out);
+        closed_ = true;
+        streams_.clear();
+        if (callbacks_.close) {
+            callbacks_.close();
+        }
+    }
+    return false;
+}
+
+void Http2Session::closeIfIdle() {
+    if (going_away_ && streams_.empty() && !closed_) {
+        closed_ = true;
+        if (callbacks_.close) {
+            callbacks_.close();
+        }
+    }
+}
+
+}  // namespace o2l
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "HttpHpack.hpp"
+#include "HttpServerLibrary.hpp"
+
+namespace o2l {
+
+// HTTP/2 framing constants (RFC 9113)
+namespace http2 {
+
+// Sent by every client before its first frame
+constexpr std::string_view kClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+enum class FrameType : uint8_t {
+    Data = 0x0,
+    Headers = 0x1,
+    Priority = 0x2,
+    RstStream = 0x3,
+    Settings = 0x4,
+    PushPromise = 0x5,
+    Ping = 0x6,
+    GoAway = 0x7,
+    WindowUpdate = 0x8,
+    Continuation = 0x9
+};
+
+constexpr uint8_t kFlagEndStream = 0x1;
+constexpr uint8_t kFlagAck = 0x1;
+constexpr uint8_t kFlagEndHeaders = 0x4;
+constexpr uint8_t kFlagPadded = 0x8;
+constexpr uint8_t kFlagPriority = 0x20;
+
+enum ErrorCode : uint32_t {
+    kNoError = 0x0,
+    kProtocolError = 0x1,
+    kInternalError = 0x2,
+    kFlowControlError = 0x3,
+    kStreamClosed = 0x5,
+    kFrameSizeError = 0x6,
+    kRefusedStream = 0x7,
+    kCancel = 0x8,
+    kCompressionError = 0x9,
+    kEnhanceYourCalm = 0xb
+};
+
+enum SettingId : uint16_t {
+    kSettingHeaderTableSize = 0x1,
+    kSettingEnablePush = 0x2,
+    kSettingMaxConcurrentStreams = 0x3,
+    kSettingInitialWindowSize = 0x4,
+    kSettingMaxFrameSize = 0x5,
+    kSettingMaxHeaderListSize = 0x6
+};
+
+constexpr uint32_t kDefaultWindowSize = 65535;
+constexpr uint32_t kDefaultMaxFrameSize = 16384;
+constexpr uint32_t kMaxWindowSize = 0x7FFFFFFF;
+constexpr size_t kFrameHeaderSize = 9;
+
+void appendFrameHeader(std::string& out, size_t length, FrameType type, uint8_t flags,
+                       uint32_t stream_id);
+
+}  // namespace http2
+
+/**
+ * Server side of one cleartext HTTP/2 connection.
+ *
+ * A pure protocol state machine: bytes from the socket go in through receive(), frames come
+ * out through the write callback, and each request whose stream is complete is handed to the
+ * dispatch callback. Responses may be submitted from any thread with respond(); their bodies
+ * are sent as the client's flow-control windows allow and paused while too much output is
+ * already buffered, resuming on WINDOW_UPDATE or resume().
+ */
+class Http2Session {
+   public:
+    struct Callbacks {
+        std::function<bool(std::string_view)> write;
+        std::function<void(uint32_t, HttpServerRequest&&)> dispatch;  // (stream id, request)
+        std::function<size_t()> buffered;  // bytes written but not yet taken by the socket
+        std::function<void()> close;       // flush what was written, then close
+    };
+
+    struct Limits {
+        uint32_t max_concurrent_streams = 100;
+        uint32_t initial_window_size = 1 << 20;  // receive window per stream and connection
+        size_t max_header_block = 64 * 1024;
+        size_t max_request_size = 10 * 1024 * 1024;
+    };
+
+    Http2Session(Callbacks callbacks, Limits limits);
+
+    Http2Session(const Http2Session&) = delete;
+    Http2Session& operator=(const Http2Session&) = delete;
+
+    // Send the server preface. For "Upgrade: h2c", pass the request that carried the upgrade
+    // and its HTTP2-Settings header; it becomes stream 1.
+    void start();
+    bool startUpgrade(const std::string& settings_header, HttpServerRequest request);
+
+    // Bytes from the client, starting with its connection preface. Returns false once the
+    // connection is finished (a GOAWAY has been written if it was an error).
+    bool receive(const char* data, size_t size);
+
+    // Complete a stream; ignored if the client has reset it in the meantime
+    void respond(uint32_t stream_id, const HttpServerResponse& response);
+
+    // Output was drained; continue sending bodies held back by buffering
+    void resume();
+
+    size_t getOpenStreams() const;
+
+    // Output held back once this much is waiting in the socket buffer
+    static constexpr size_t kOutputHighWater = 256 * 1024;
+
+   private:
+    struct Stream {
+        HttpServerRequest request;
+        bool remote_closed = false;  // END_STREAM received
+        bool head_request = false;
+        bool discard_body = false;   // request rejected early; further DATA is ignored
+        bool responded = false;
+        int64_t send_window = 0;
+        uint32_t received_unacked = 0;
+        std::string pending_body;    // response body not yet sent
+        std::shared_ptr<const StaticBody> static_body;  // or a shared cached one
+        size_t body_offset = 0;
+
+        std::string_view body() const {
+            return static_body ? std::string_view(static_body->data) : pending_body;
+        }
+    };
+
+    bool processFrame(http2::FrameType type, uint8_t flags, uint32_t stream_id,
+                      const uint8_t* payload, size_t length);
+    bool onHeaders(uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+    bool onHeaderBlockComplete(uint32_t stream_id, bool end_stream);
+    bool onData(uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+    bool onSettings(uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+    bool onWindowUpdate(uint32_t stream_id, const uint8_t* payload, size_t length);
+    bool applySettings(const uint8_t* payload, size_t length);
+
+    void dispatchStream(uint32_t stream_id, Stream& stream);
+    void respondLocked(uint32_t stream_id, Stream& stream, const HttpServerResponse& response);
+    void flushData();
+    void writeHeaders(uint32_t stream_id, const hpack::HeaderList& headers, bool end_stream);
+    void writeRstStream(uint32_t stream_id, uint32_t error);
+    void writeWindowUpdate(uint32_t stream_id, uint32_t increment);
+    bool connectionError(uint32_t error);
+    void closeIfIdle();
+
+    Callbacks callbacks_;
+    Limits limits_;
+
+    mutable std::mutex mutex_;
+    std::string in_buffer_;
+    bool preface_received_ = false;
+    bool going_away_ = false;
+    bool closed_ = false;
+
+    std::map<uint32_t, Stream> streams_;  // ordered, so bodies go out lowest stream first
+    uint32_t last_stream_id_ = 0;
+
+    // Header block spread over HEADERS + CONTINUATION frames
+    uint32_t continuation_stream_ = 0;
+    bool continuation_end_stream_ = false;
+    std::string header_block_;
+
+    hpack::Decoder decoder_;
+    hpack::Encoder encoder_;
+
+    // Peer settings
+    int64_t peer_initial_window_ = http2::kDefaultWindowSize;
+    uint32_t peer_max_frame_size_ = http2::kDefaultMaxFrameSize;
+    int64_t connection_send_window_ = http2::kDefaultWindowSize;
+
+    // Our receive side; replenished once half of it has been used
+    int64_t connection_receive_window_;
+    uint32_t connection_received_unacked_ = 0;
+};
+
+}  // namespace o2l
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpAccessLog.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace o2l {
+
+namespace {
+
+constexpr const char* kDefaultFormat = "[{time}] {method} {path} {status} {bytes} bytes";
+constexpr const char* kCommonFormat =
+    "{remote} - - [{time_clf}] \"{method} {path} HTTP/1.1\" {status} {bytes}";
+constexpr const char* kCombinedFormat =
+    "{remote} - - [{time_clf}] \"{method} {path} HTTP/1.1\" {status} {bytes} \"-\" "
+    "\"{user_agent}\"";
+
+// How long the drain thread sleeps between batches when nobody asks for a flush
+constexpr auto kDrainInterval = std::chrono::milliseconds(50);
+
+std::atomic<uint64_t> next_log_id{1};
+
+// Per-thread view of the logs this thread has written to
+struct ThreadSlot {
+    uint64_t log_id;
+    AccessLogRing* ring;
+    uint64_t seen;
+};
+
+thread_local std::vector<ThreadSlot> thread_slots;
+
+ThreadSlot* findThreadSlot(uint64_t log_id) {
+    for (auto& slot : thread_slots) {
+        if (slot.log_id == log_id) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void appendTime(std::time_t timestamp, const char* format, std::string& out) {
+    std::tm gmt{};
+#ifdef _WIN32
+    gmtime_s(&gmt, &timestamp);
+#else
+    gmtime_r(&timestamp, &gmt);
+#endif
+    char buffer[64];
+    size_t length = std::strftime(buffer, sizeof(buffer), format, &gmt);
+    out.append(buffer, length);
+}
+
+}  // namespace
+
+//=============================================================================
+// AccessLogRing Implementation
+//=============================================================================
+
+AccessLogRing::AccessLogRing(size_t capacity)
+    : slots_(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)), mask_(slots_.size() - 1) {}
+
+bool AccessLogRing::tryPush(AccessLogRecord&& record) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= slots_.size()) {
+        return false;
+    }
+    slots_[head & mask_] = std::move(record);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t AccessLogRing::drainInto(std::vector<AccessLogRecord>& out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t count = head - tail;
+    for (size_t i = tail; i != head; ++i) {
+        out.push_back(std::move(slots_[i & mask_]));
+    }
+    tail_.store(head, std::memory_order_release);
+    return count;
+}
+
+//=============================================================================
+// AccessLog Implementation
+//=============================================================================
+
+AccessLog::AccessLog(size_t ring_capacity)
+    : id_(next_log_id.fetch_add(1)), ring_capacity_(ring_capacity) {
+    setFormat("default");
+}
+
+AccessLog::~AccessLog() {
+    stop();
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    closeFileLocked();
+}
+
+void AccessLog::setStdoutSink() {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    closeFileLocked();
+    sink_type_ = SinkType::Stdout;
+    callback_ = nullptr;
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void AccessLog::setFileSink(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "a");
+    if (!file) {
+        throw std::runtime_error("Cannot open access log file: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    closeFileLocked();
+    sink_type_ = SinkType::File;
+    file_path_ = path;
+    file_ = file;
+    callback_ = nullptr;
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void AccessLog::setCallbackSink(BatchCallback callback) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    closeFileLocked();
+    sink_type_ = SinkType::Callback;
+    callback_ = std::move(callback);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void AccessLog::disable() {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    closeFileLocked();
+    sink_type_ = SinkType::Off;
+    callback_ = nullptr;
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+AccessLog::SinkType AccessLog::getSinkType() const {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    return sink_type_;
+}
+
+void AccessLog::closeFileLocked() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    file_path_.clear();
+}
+
+void AccessLog::setFormat(const std::string& format) {
+    std::string resolved = format;
+    if (format == "default") {
+        resolved = kDefaultFormat;
+    } else if (format == "common") {
+        resolved = kCommonFormat;
+    } else if (format == "combined") {
+        resolved = kCombinedFormat;
+    }
+
+    auto parts = compileFormat(resolved);
+
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    format_ = resolved;
+    format_parts_ = std::move(parts);
+}
+
+std::string AccessLog::getFormat() const {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    return format_;
+}
+
+void AccessLog::setSampling(int every) {
+    if (every < 1) {
+        throw std::runtime_error("Access log sampling rate must be at least 1");
+    }
+    sample_every_.store(every, std::memory_order_relaxed);
+}
+
+std::vector<AccessLog::FormatPart> AccessLog::compileFormat(const std::string& format) {
+    static const std::pair<const char*, FormatPart::Kind> kPlaceholders[] = {
+        {"time", FormatPart::Time},
+        {"time_clf", FormatPart::TimeClf},
+        {"method", FormatPart::Method},
+        {"path", FormatPart::Path},
+        {"query", FormatPart::Query},
+        {"status", FormatPart::Status},
+        {"bytes", FormatPart::Bytes},
+        {"remote", FormatPart::Remote},
+        {"user_agent", FormatPart::UserAgent},
+        {"duration_ms", FormatPart::Duration},
+    };
+
+    std::vector<FormatPart> parts;
+    std::string literal;
+    size_t pos = 0;
+    while (pos < format.size()) {
+        if (format[pos] == '{') {
+            size_t close = format.find('}', pos);
+            if (close != std::string::npos) {
+                std::string name = format.substr(pos + 1, close - pos - 1);
+                bool matched = false;
+                for (const auto& [placeholder, kind] : kPlaceholders) {
+                    if (name == placeholder) {
+                        if (!literal.empty()) {
+                            parts.push_back({FormatPart::Literal, std::move(literal)});
+                            literal.clear();
+                        }
+                        parts.push_back({kind, ""});
+                        matched = true;
+                        break;
+                    }
+                }
+                if (!matched) {
+                    throw std::runtime_error("Unknown access log placeholder: {" + name + "}");
+                }
+                pos = close + 1;
+                continue;
+            }
+        }
+        literal += format[pos++];
+    }
+    if (!literal.empty()) {
+        parts.push_back({FormatPart::Literal, std::move(literal)});
+    }
+    return parts;
+}
+
+void AccessLog::appendRecord(const std::vector<FormatPart>& parts, const AccessLogRecord& record,
+                             std::string& out) const {
+    for (const auto& part : parts) {
+        switch (part.kind) {
+            case FormatPart::Literal:
+                out += part.literal;
+                break;
+            case FormatPart::Time:
+                appendTime(record.timestamp, "%a, %d %b %Y %H:%M:%S GMT", out);
+                break;
+            case FormatPart::TimeClf:
+                appendTime(record.timestamp, "%d/%b/%Y:%H:%M:%S +0000", out);
+                break;
+            case FormatPart::Method:
+                out += record.method;
+                break;
+            case FormatPart::Path:
+                out += record.path;
+                break;
+            case FormatPart::Query:
+                out += record.query_string;
+                break;
+            case FormatPart::Status:
+                out += std::to_string(record.status);
+                break;
+            case FormatPart::Bytes:
+                out += std::to_string(record.bytes);
+                break;
+            case FormatPart::Remote:
+                out += record.remote_address.empty() ? "-" : record.remote_address;
+                break;
+            case FormatPart::UserAgent:
+                out += record.user_agent;
+                break;
+            case FormatPart::Duration: {
+                char buffer[32];
+                int length = std::snprintf(buffer, sizeof(buffer), "%.3f", record.duration_ms);
+                out.append(buffer, length > 0 ? static_cast<size_t>(length) : 0);
+                break;
+            }
+        }
+    }
+    out += '\n';
+}
+
+std::string AccessLog::formatRecord(const AccessLogRecord& record) const {
+    std::vector<FormatPart> parts;
+    {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        parts = format_parts_;
+    }
+    std::string line;
+    appendRecord(parts, record, line);
+    line.pop_back();  // drop the trailing newline
+    return line;
+}
+
+AccessLogRing& AccessLog::ringForCurrentThread() {
+    if (ThreadSlot* slot = findThreadSlot(id_)) {
+        return *slot->ring;
+    }
+
+    auto ring = std::make_unique<AccessLogRing>(ring_capacity_);
+    AccessLogRing* raw = ring.get();
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::move(ring));
+    }
+    thread_slots.push_back({id_, raw, 0});
+    return *raw;
+}
+
+void AccessLog::record(AccessLogRecord&& record) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    AccessLogRing& ring = ringForCurrentThread();
+
+    int every = sample_every_.load(std::memory_order_relaxed);
+    if (every > 1) {
+        ThreadSlot* slot = findThreadSlot(id_);
+        if (slot->seen++ % static_cast<uint64_t>(every) != 0) {
+            return;
+        }
+    }
+
+    ensureDrainThread();
+    if (!ring.tryPush(std::move(record))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        drain_cv_.notify_one();
+    }
+}
+
+void AccessLog::ensureDrainThread() {
+    if (drain_running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    if (drain_running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    stopping_ = false;
+    drain_thread_ = std::thread(&AccessLog::drainLoop, this);
+    drain_running_.store(true, std::memory_order_release);
+}
+
+void AccessLog::drainLoop() {
+    std::vector<AccessLogRecord> batch;
+    std::string buffer;
+
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    while (true) {
+        drain_cv_.wait_for(lock, kDrainInterval,
+                           [this] { return stopping_ || flush_requested_ > flush_completed_; });
+        bool stopping = stopping_;
+        uint64_t requested = flush_requested_;
+
+        lock.unlock();
+        drainOnce(batch, buffer);
+        lock.lock();
+
+        flush_completed_ = requested;
+        flushed_cv_.notify_all();
+        if (stopping) {
+            break;
+        }
+    }
+}
+
+size_t AccessLog::drainOnce(std::vector<AccessLogRecord>& batch, std::string& buffer) {
+    batch.clear();
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto& ring : rings_) {
+            ring->drainInto(batch);
+        }
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock(sink_mutex_);
+    switch (sink_type_) {
+        case SinkType::Off:
+            return 0;
+        case SinkType::Callback: {
+            BatchCallback callback = callback_;
+            lock.unlock();
+            callback(batch);
+            break;
+        }
+        case SinkType::Stdout:
+        case SinkType::File: {
+            buffer.clear();
+            for (const auto& record : batch) {
+                appendRecord(format_parts_, record, buffer);
+            }
+            if (sink_type_ == SinkType::File) {
+                std::fwrite(buffer.data(), 1, buffer.size(), file_);
+                std::fflush(file_);
+            } else {
+                lock.unlock();
+                std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                std::cout.flush();
+            }
+            break;
+        }
+    }
+
+    written_.fetch_add(batch.size(), std::memory_order_relaxed);
+    return batch.size();
+}
+
+void AccessLog::flush() {
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    if (!drain_running_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    uint64_t target = ++flush_requested_;
+    drain_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, target] { return flush_completed_ >= target; });
+}
+
+void AccessLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        if (!drain_running_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        stopping_ = true;
+    }
+    drain_cv_.notify_one();
+    drain_thread_.join();
+
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    drain_running_.store(false, std::memory_order_release);
+}
+
+}  // namespace o2l
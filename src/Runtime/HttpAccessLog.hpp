@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace o2l {
+
+// One access log line, captured on the worker thread
+struct AccessLogRecord {
+    std::time_t timestamp = 0;
+    std::string method;
+    std::string path;
+    std::string query_string;
+    std::string remote_address;
+    std::string user_agent;
+    int status = 0;
+    size_t bytes = 0;
+    double duration_ms = 0.0;
+};
+
+// Fixed-capacity single-producer/single-consumer ring of access log records
+class AccessLogRing {
+   public:
+    explicit AccessLogRing(size_t capacity);
+
+    // Producer side (owning worker thread); false when the ring is full
+    bool tryPush(AccessLogRecord&& record);
+
+    // Consumer side (drain thread); appends everything currently queued to out
+    size_t drainInto(std::vector<AccessLogRecord>& out);
+
+   private:
+    std::vector<AccessLogRecord> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};  // next slot to write
+    alignas(64) std::atomic<size_t> tail_{0};  // next slot to read
+};
+
+/**
+ * Asynchronous access log for HttpServer.
+ *
+ * Worker threads push records into their own lock-free ring; a background thread drains
+ * all rings, formats the batch into a single buffer and hands it to the sink in one write.
+ * When a ring is full the record is dropped and counted rather than blocking the request.
+ *
+ * Format placeholders: {time} {time_clf} {method} {path} {query} {status} {bytes} {remote}
+ * {user_agent} {duration_ms}. The presets "default", "common" and "combined" are accepted
+ * in place of a format string.
+ */
+class AccessLog {
+   public:
+    enum class SinkType { Off, Stdout, File, Callback };
+
+    // Receives a drained batch on the drain thread (used for O²L logger objects)
+    using BatchCallback = std::function<void(const std::vector<AccessLogRecord>&)>;
+
+    static constexpr size_t kDefaultRingCapacity = 4096;
+
+    explicit AccessLog(size_t ring_capacity = kDefaultRingCapacity);
+    ~AccessLog();
+
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    // Sink configuration; safe to call while the log is running
+    void setStdoutSink();
+    void setFileSink(const std::string& path);
+    void setCallbackSink(BatchCallback callback);
+    void disable();
+    SinkType getSinkType() const;
+
+    void setFormat(const std::string& format);
+    std::string getFormat() const;
+
+    // Keep one of every `every` records (1 = log everything)
+    void setSampling(int every);
+    int getSampling() const {
+        return sample_every_.load(std::memory_order_relaxed);
+    }
+
+    // Called on worker threads; never blocks on I/O
+    void record(AccessLogRecord&& record);
+
+    // Block until everything recorded so far has been written
+    void flush();
+
+    // Drain outstanding records and stop the background thread
+    void stop();
+
+    size_t getDroppedCount() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+    size_t getWrittenCount() const {
+        return written_.load(std::memory_order_relaxed);
+    }
+
+    // Render one record with the current format (exposed for tests)
+    std::string formatRecord(const AccessLogRecord& record) const;
+
+   private:
+    struct FormatPart {
+        enum Kind {
+            Literal,
+            Time,
+            TimeClf,
+            Method,
+            Path,
+            Query,
+            Status,
+            Bytes,
+            Remote,
+            UserAgent,
+            Duration
+        };
+        Kind kind;
+        std::string literal;
+    };
+
+    AccessLogRing& ringForCurrentThread();
+    void ensureDrainThread();
+    void drainLoop();
+    void closeFileLocked();
+    size_t drainOnce(std::vector<AccessLogRecord>& batch, std::string& buffer);
+    void appendRecord(const std::vector<FormatPart>& parts, const AccessLogRecord& record,
+                      std::string& out) const;
+    static std::vector<FormatPart> compileFormat(const std::string& format);
+
+    const uint64_t id_;
+    const size_t ring_capacity_;
+
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<AccessLogRing>> rings_;
+
+    // Sink and format state, read by the drain thread
+    mutable std::mutex sink_mutex_;
+    SinkType sink_type_ = SinkType::Stdout;
+    std::string file_path_;
+    std::FILE* file_ = nullptr;
+    BatchCallback callback_;
+    std::string format_;
+    std::vector<FormatPart> format_parts_;
+
+    std::atomic<bool> enabled_{true};
+    std::atomic<int> sample_every_{1};
+    std::atomic<size_t> dropped_{0};
+    std::atomic<size_t> written_{0};
+
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+    std::condition_variable flushed_cv_;
+    std::thread drain_thread_;
+    std::atomic<bool> drain_running_{false};
+    bool stopping_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+};
+
+}  // namespace o2l
@@ -17,6 +17,7 @@
 #include "HttpClientLibrary.hpp"
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <ctime>
@@ -28,6 +29,7 @@
 #include <sstream>
 #include <thread>
 
+#include "../Common/Exceptions.hpp"
 #include "JsonLibrary.hpp"
 #include "ListInstance.hpp"
 #include "MapInstance.hpp"
@@ -328,7 +330,7 @@ Value HttpClientLibrary::nativeGet(const std::vector<Value>& args, Context& cont
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -370,7 +372,7 @@ Value HttpClientLibrary::nativePost(const std::vector<Value>& args, Context& con
         request.headers["Content-Type"] = "application/json";
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -396,7 +398,7 @@ Value HttpClientLibrary::nativePut(const std::vector<Value>& args, Context& cont
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -418,7 +420,7 @@ Value HttpClientLibrary::nativeDelete(const std::vector<Value>& args, Context& c
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -444,7 +446,7 @@ Value HttpClientLibrary::nativePatch(const std::vector<Value>& args, Context& co
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -466,7 +468,7 @@ Value HttpClientLibrary::nativeHead(const std::vector<Value>& args, Context& con
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -488,7 +490,7 @@ Value HttpClientLibrary::nativeOptions(const std::vector<Value>& args, Context&
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -516,7 +518,7 @@ Value HttpClientLibrary::nativeRequest(const std::vector<Value>& args, Context&
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -571,7 +573,7 @@ Value HttpClientLibrary::nativeRequestWithConfig(const std::vector<Value>& args,
         }
     }
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -1124,7 +1126,7 @@ Value HttpClientLibrary::nativeUploadFile(const std::vector<Value>& args, Contex
     request.headers["Content-Type"] = "multipart/form-data; boundary=" + boundary;
     request.headers["Content-Length"] = std::to_string(request.body.length());
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
     return Value(createResponseObject(response));
 }
 
@@ -1140,7 +1142,7 @@ Value HttpClientLibrary::nativeDownloadFile(const std::vector<Value>& args, Cont
     request.method = "GET";
     request.url = url;
 
-    HttpResponse response = executeHttpRequest(request);
+    HttpResponse response = executeHttpRequest(request, context);
 
     if (response.success) {
         std::ofstream file(dest_path, std::ios::binary);
@@ -1186,6 +1188,25 @@ HttpResponse HttpClientLibrary::executeHttpRequest(const HttpRequest& request) {
     }
 }
 
+HttpResponse HttpClientLibrary::executeHttpRequest(HttpRequest request, const Context& context) {
+    const auto& token = context.getCancellationToken();
+    if (!token) {
+        return executeHttpRequest(request);
+    }
+
+    // No point starting a request whose caller can no longer use the answer
+    token->check();
+    if (token->hasDeadline()) {
+        request.deadline = std::min(request.deadline, token->getDeadline());
+    }
+
+    HttpResponse response = executeHttpRequest(request);
+
+    // Cut off by the deadline: unwind instead of handing back a timeout to ignore
+    token->check();
+    return response;
+}
+
 // Helper Methods
 
 std::string HttpClientLibrary::buildQueryString(const std::map<std::string, std::string>& params) {
@@ -1336,7 +1357,7 @@ HttpResponse HttpClientLibrary::executeHttpRequestWindows(const HttpRequest& req
     HttpResponse response;
 
     // Parse URL components
-    std::regex url_regex(R"(^(https?):\/\/([^\/]+)(?::(\d+))?(\/.*)?$)");
+    std::regex url_regex(R"(^(https?):\/\/([^\/:]+)(?::(\d+))?(\/.*)?$)");
     std::smatch matches;
 
     if (!std::regex_match(request.url, matches, url_regex)) {
@@ -1375,7 +1396,7 @@ HttpResponse HttpClientLibrary::executeHttpRequestWindows(const HttpRequest& req
     }
 
     // Set timeout
-    DWORD timeout = request.timeout_seconds * 1000;  // Convert to milliseconds
+    DWORD timeout = static_cast<DWORD>(request.getTimeout().count());
     InternetSetOptionA(hInternet, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
     InternetSetOptionA(hInternet, INTERNET_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
     InternetSetOptionA(hInternet, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
@@ -1511,7 +1532,7 @@ HttpResponse HttpClientLibrary::executeHttpRequestLinux(const HttpRequest& reque
     HttpResponse response;
 
     // Parse URL components
-    std::regex url_regex(R"(^(https?):\/\/([^\/]+)(?::(\d+))?(\/.*)?$)");
+    std::regex url_regex(R"(^(https?):\/\/([^\/:]+)(?::(\d+))?(\/.*)?$)");
     std::smatch matches;
 
     if (!std::regex_match(request.url, matches, url_regex)) {
@@ -1543,12 +1564,23 @@ HttpResponse HttpClientLibrary::executeHttpRequestLinux(const HttpRequest& reque
         return response;
     }
 
-    // Set timeout
-    struct timeval timeout;
-    timeout.tv_sec = request.timeout_seconds;
-    timeout.tv_usec = 0;
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // The timeout covers the whole exchange: each blocking call gets what is left of it
+    auto timeout_ms = request.getTimeout();
+    auto give_up_at = std::chrono::steady_clock::now() + timeout_ms;
+    auto arm_timeout = [sockfd, give_up_at]() {
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(
+            give_up_at - std::chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            return false;
+        }
+        struct timeval timeout;
+        timeout.tv_sec = static_cast<time_t>(left.count() / 1000000);
+        timeout.tv_usec = static_cast<suseconds_t>(left.count() % 1000000);
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        return true;
+    };
+    arm_timeout();
 
     // Resolve hostname
     struct hostent* server = gethostbyname(host.c_str());
@@ -1620,13 +1652,30 @@ HttpResponse HttpClientLibrary::executeHttpRequestLinux(const HttpRequest& reque
     char buffer[4096];
     ssize_t bytes_received;
 
-    while ((bytes_received = recv(sockfd, buffer, sizeof(buffer) - 1, 0)) > 0) {
+    bool timed_out = false;
+    while (true) {
+        if (!arm_timeout()) {
+            timed_out = true;
+            break;
+        }
+        bytes_received = recv(sockfd, buffer, sizeof(buffer) - 1, 0);
+        if (bytes_received <= 0) {
+            timed_out = bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
         buffer[bytes_received] = '\0';
         raw_response += buffer;
     }
 
     close(sockfd);
 
+    if (timed_out) {
+        response.success = false;
+        response.error_message =
+            "Request timed out after " + std::to_string(timeout_ms.count()) + "ms";
+        return response;
+    }
+
     if (raw_response.empty()) {
         response.success = false;
         response.error_message = "No response received from server";
@@ -1723,7 +1772,7 @@ HttpResponse HttpClientLibrary::executeHttpRequestCurl(const HttpRequest& reques
 
     // Set basic curl options
     curl_easy_setopt(curl, CURLOPT_URL, final_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(request.timeout_seconds));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(request.getTimeout().count()));
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "O2L-HTTP-Client/1.0");
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, request.follow_redirects ? 1L : 0L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, request.verify_ssl ? 1L : 0L);
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -50,8 +52,25 @@ struct HttpRequest {
     int timeout_seconds;
     bool follow_redirects;
     bool verify_ssl;
-
-    HttpRequest() : timeout_seconds(30), follow_redirects(true), verify_ssl(true) {}
+    // Deadline of the calling code (e.g. an HTTP handler); the request never waits past it
+    std::chrono::steady_clock::time_point deadline;
+
+    HttpRequest()
+        : timeout_seconds(30),
+          follow_redirects(true),
+          verify_ssl(true),
+          deadline(std::chrono::steady_clock::time_point::max()) {}
+
+    // timeout_seconds, cut down to what is left before the deadline (at least 1ms)
+    std::chrono::milliseconds getTimeout() const {
+        std::chrono::milliseconds timeout(timeout_seconds * 1000LL);
+        if (deadline != std::chrono::steady_clock::time_point::max()) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            timeout = std::max(std::min(timeout, left), std::chrono::milliseconds(1));
+        }
+        return timeout;
+    }
 };
 
 class HttpClientLibrary {
@@ -110,6 +129,9 @@ class HttpClientLibrary {
    private:
     // Core HTTP execution
     static HttpResponse executeHttpRequest(const HttpRequest& request);
+    // Within the caller's deadline: the timeout is cut to what is left of it, and a call
+    // that starts or ends past it unwinds with ExecutionCancelledError
+    static HttpResponse executeHttpRequest(HttpRequest request, const Context& context);
 
     // Helper methods
     static std::string buildQueryString(const std::map<std::string, std::string>& params);
@@ -0,0 +1,938 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpConnectionHub.hpp"
+
+#include "HttpEventStream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace o2l {
+
+//=============================================================================
+// HubConnection
+//=============================================================================
+
+bool HubConnection::send(std::string_view message, bool binary) {
+    auto owner = hub.lock();
+    if (!owner || !isOpen() || close_sent.load(std::memory_order_acquire)) {
+        return false;
+    }
+    return owner->writeFrame(
+        *this, websocket::encodeFrame(binary ? websocket::Opcode::Binary : websocket::Opcode::Text,
+                                      message));
+}
+
+bool HubConnection::write(std::string_view bytes) {
+    auto owner = hub.lock();
+    if (!owner || !isOpen() || close_sent.load(std::memory_order_acquire)) {
+        return false;
+    }
+    return owner->writeFrame(*this, bytes);
+}
+
+bool HubConnection::finish(std::string_view bytes) {
+    auto owner = hub.lock();
+    return owner && isOpen() && owner->finishResponse(*this, bytes);
+}
+
+void HubConnection::close(int code, std::string_view reason) {
+    auto owner = hub.lock();
+    if (!owner) {
+        return;
+    }
+    if (mode == Mode::WebSocket) {
+        owner->sendClose(*this, code, reason);
+        return;
+    }
+
+    // A deferred response that was never completed still owes the client an answer
+    std::string last;
+    if (mode == Mode::Deferred) {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        last = expiry_response;
+    }
+    owner->finishResponse(*this, last);
+}
+
+void HubConnection::subscribe(const std::string& topic) {
+    if (auto owner = hub.lock()) {
+        owner->subscribe(*this, topic);
+    }
+}
+
+void HubConnection::unsubscribe(const std::string& topic) {
+    if (auto owner = hub.lock()) {
+        owner->unsubscribe(*this, topic);
+    }
+}
+
+size_t HubConnection::bufferedOutput() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    return out_buffer.size();
+}
+
+//=============================================================================
+// ConnectionHub
+//=============================================================================
+
+namespace {
+
+constexpr size_t kReadBufferSize = 64 * 1024;
+constexpr size_t kMaxPendingOutput = 8 * 1024 * 1024;  // slow consumers are dropped past this
+constexpr auto kCloseHandshakeTimeout = std::chrono::seconds(5);
+constexpr auto kSweepInterval = std::chrono::seconds(1);
+constexpr std::string_view kKeepAliveComment = ": keepalive\n\n";
+
+// Release a buffer's memory, not just its contents
+void releaseBuffer(std::string& buffer) {
+    std::string().swap(buffer);
+}
+
+}  // namespace
+
+ConnectionHub::ConnectionHub() = default;
+
+ConnectionHub::~ConnectionHub() {
+    stop();
+}
+
+bool ConnectionHub::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t ConnectionHub::getConnectionCount() const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    return connections_.size();
+}
+
+size_t ConnectionHub::getConnectionCount(HubConnection::Mode mode) const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    return static_cast<size_t>(
+        std::count_if(connections_.begin(), connections_.end(),
+                      [mode](const auto& entry) { return entry.second->mode == mode; }));
+}
+
+void ConnectionHub::registerConnection(const std::shared_ptr<HubConnection>& conn) {
+    conn->id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    conn->hub = weak_from_this();
+    conn->last_seen = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections_.emplace(conn->id, conn);
+}
+
+std::shared_ptr<HubConnection> ConnectionHub::createPending(HubConnection::Mode mode) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    auto conn = std::make_shared<HubConnection>();
+    conn->mode = mode;
+    registerConnection(conn);
+    return conn;
+}
+
+void ConnectionHub::discard(const std::shared_ptr<HubConnection>& conn) {
+    if (conn) {
+        finalize(conn, websocket::kCloseAbnormal);
+    }
+}
+
+std::shared_ptr<HubConnection> ConnectionHub::findConnection(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = connections_.find(id);
+    return it != connections_.end() ? it->second : nullptr;
+}
+
+void ConnectionHub::dispatch(const std::shared_ptr<HubConnection>& conn,
+                            std::function<void()> event) {
+    {
+        std::lock_guard<std::mutex> lock(conn->events_mutex);
+        conn->events.push_back(std::move(event));
+        if (conn->events_scheduled) {
+            return;
+        }
+        conn->events_scheduled = true;
+    }
+
+    auto drain = [conn]() {
+        for (;;) {
+            std::function<void()> next;
+            {
+                std::lock_guard<std::mutex> lock(conn->events_mutex);
+                if (conn->events.empty()) {
+                    conn->events_scheduled = false;
+                    return;
+                }
+                next = std::move(conn->events.front());
+                conn->events.pop_front();
+            }
+            try {
+                next();
+            } catch (const std::exception& e) {
+                std::cerr << "WebSocket handler error: " << e.what() << std::endl;
+            }
+        }
+    };
+
+    try {
+        runner_(std::move(drain));
+    } catch (const std::exception&) {
+        // The worker pool is gone (server shutting down); drop the queued events
+        std::lock_guard<std::mutex> lock(conn->events_mutex);
+        conn->events.clear();
+        conn->events_scheduled = false;
+    }
+}
+
+void ConnectionHub::subscribe(HubConnection& conn, const std::string& topic) {
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    if (!conn.isOpen() ||
+        std::find(conn.topics.begin(), conn.topics.end(), topic) != conn.topics.end()) {
+        return;
+    }
+    conn.topics.push_back(topic);
+    topics_[topic].insert(conn.id);
+}
+
+void ConnectionHub::unsubscribe(HubConnection& conn, const std::string& topic) {
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    auto it = std::find(conn.topics.begin(), conn.topics.end(), topic);
+    if (it == conn.topics.end()) {
+        return;
+    }
+    conn.topics.erase(it);
+    auto members = topics_.find(topic);
+    if (members != topics_.end()) {
+        members->second.erase(conn.id);
+        if (members->second.empty()) {
+            topics_.erase(members);
+        }
+    }
+}
+
+size_t ConnectionHub::publish(const std::string& topic, std::string_view message, bool binary) {
+    std::vector<uint64_t> recipients;
+    {
+        std::lock_guard<std::mutex> lock(topics_mutex_);
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) {
+            return 0;
+        }
+        recipients.assign(it->second.begin(), it->second.end());
+    }
+
+    // Encode once per kind of connection, write the same bytes to every subscriber
+    std::string frame;
+    std::string event;
+    size_t delivered = 0;
+    for (uint64_t id : recipients) {
+        auto conn = findConnection(id);
+        if (!conn || conn->close_sent.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        bool written = false;
+        switch (conn->mode) {
+            case HubConnection::Mode::WebSocket:
+                if (frame.empty()) {
+                    frame = websocket::encodeFrame(
+                        binary ? websocket::Opcode::Binary : websocket::Opcode::Text, message);
+                }
+                written = writeFrame(*conn, frame);
+                break;
+            case HubConnection::Mode::EventStream:
+                if (event.empty()) {
+                    event = sse::encodeEvent({}, message);
+                }
+                written = writeFrame(*conn, event);
+                break;
+            case HubConnection::Mode::Deferred: {
+                std::function<std::string(std::string_view)> render;
+                {
+                    std::lock_guard<std::mutex> lock(conn->write_mutex);
+                    render = conn->render;
+                }
+                written = render && finishResponse(*conn, render(message));
+                break;
+            }
+            case HubConnection::Mode::Http2:
+                break;  // multiplexed connections have no topic of their own
+        }
+        if (written) {
+            ++delivered;
+        }
+    }
+    return delivered;
+}
+
+bool ConnectionHub::finishResponse(HubConnection& conn, std::string_view bytes) {
+    // close_sent doubles as "finishing" for streams: later writes are refused
+    if (conn.close_sent.exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn.write_mutex);
+        conn.close_sent_at = std::chrono::steady_clock::now();
+        conn.close_after_flush = true;
+    }
+    if (!bytes.empty() && !writeFrame(conn, bytes)) {
+        return false;
+    }
+
+    // Not attached yet: attach() flushes and closes. Still draining: handleWritable() does.
+    bool drained;
+    {
+        std::lock_guard<std::mutex> lock(conn.write_mutex);
+        drained = conn.fd >= 0 && conn.out_buffer.empty();
+    }
+    if (drained) {
+        requestClose(conn.id);
+    }
+    return true;
+}
+
+void ConnectionHub::sendClose(HubConnection& conn, int code, std::string_view reason) {
+    if (conn.close_sent.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn.write_mutex);
+        conn.close_sent_at = std::chrono::steady_clock::now();
+    }
+    writeFrame(conn, websocket::encodeCloseFrame(code, reason));
+}
+
+#ifdef __linux__
+
+bool ConnectionHub::start(TaskRunner runner) {
+    if (running_.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    poll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (poll_fd_ < 0) {
+        return false;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        ::close(poll_fd_);
+        poll_fd_ = -1;
+        return false;
+    }
+
+    // Connection ids start at 1; 0 marks the wake-up descriptor
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    epoll_ctl(poll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    runner_ = std::move(runner);
+    running_.store(true, std::memory_order_release);
+    loop_thread_ = std::thread(&ConnectionHub::loop, this);
+    return true;
+}
+
+void ConnectionHub::stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    wake();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+
+    // The loop has exited, so closing the remaining connections here cannot race with it
+    std::vector<std::shared_ptr<HubConnection>> remaining;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (const auto& entry : connections_) {
+            remaining.push_back(entry.second);
+        }
+    }
+    for (const auto& conn : remaining) {
+        if (conn->mode == HubConnection::Mode::WebSocket) {
+            sendClose(*conn, websocket::kCloseGoingAway, "Server shutting down");
+        }
+        finalize(conn, websocket::kCloseGoingAway);
+    }
+
+    ::close(wake_fd_);
+    ::close(poll_fd_);
+    wake_fd_ = -1;
+    poll_fd_ = -1;
+}
+
+std::shared_ptr<HubConnection> ConnectionHub::adopt(
+    int fd, const std::string& path, std::map<std::string, std::string> params,
+    std::shared_ptr<const WebSocketHandlers> handlers) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    auto conn = std::make_shared<HubConnection>();
+    conn->mode = HubConnection::Mode::WebSocket;
+    conn->fd = fd;
+    conn->path = path;
+    conn->params = std::move(params);
+    conn->handlers = std::move(handlers);
+    registerConnection(conn);
+
+    // Queue onOpen before the socket is polled so it always precedes the first message
+    if (conn->handlers && conn->handlers->on_open) {
+        dispatch(conn, [conn]() { conn->handlers->on_open(conn); });
+    }
+
+    if (!watch(fd, conn->id, false)) {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.erase(conn->id);
+        conn->closed.store(true, std::memory_order_release);
+        return nullptr;
+    }
+    conn->attached.store(true, std::memory_order_release);
+    return conn;
+}
+
+bool ConnectionHub::attach(const std::shared_ptr<HubConnection>& conn, int fd,
+                           std::string_view head) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(conn->write_mutex);
+    if (!conn->isOpen()) {
+        return false;
+    }
+
+    // The head goes out first, followed by whatever the handler already wrote
+    conn->fd = fd;
+    conn->out_buffer.insert(0, head);
+    bool failed = false;
+    ssize_t sent = ::send(fd, conn->out_buffer.data(), conn->out_buffer.size(), MSG_NOSIGNAL);
+    if (sent > 0) {
+        conn->out_buffer.erase(0, static_cast<size_t>(sent));
+    } else if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        failed = true;
+    }
+
+    if (!watch(fd, conn->id, !conn->out_buffer.empty())) {
+        conn->fd = -1;
+        return false;
+    }
+    conn->attached.store(true, std::memory_order_release);
+
+    bool done = failed || (conn->close_after_flush && conn->out_buffer.empty());
+    if (conn->out_buffer.empty()) {
+        releaseBuffer(conn->out_buffer);
+    }
+    lock.unlock();
+    if (done) {
+        requestClose(conn->id);
+    }
+    return true;
+}
+
+bool ConnectionHub::watch(int fd, uint64_t id, bool writable) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    epoll_event event{};
+    event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.u64 = id;
+    return epoll_ctl(poll_fd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void ConnectionHub::wake() {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+}
+
+void ConnectionHub::requestClose(uint64_t id) {
+    {
+        std::lock_guard<std::mutex> lock(close_mutex_);
+        pending_closes_.push_back(id);
+    }
+    wake();
+}
+
+void ConnectionHub::watchWritable(HubConnection& conn, bool enable) {
+    // Caller holds conn.write_mutex
+    epoll_event event{};
+    event.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.u64 = conn.id;
+    epoll_ctl(poll_fd_, EPOLL_CTL_MOD, conn.fd, &event);
+}
+
+bool ConnectionHub::writeFrame(HubConnection& conn, std::string_view frame) {
+    std::unique_lock<std::mutex> lock(conn.write_mutex);
+    if (conn.fd < 0 && !conn.isOpen()) {
+        return false;
+    }
+
+    // Preserve ordering behind bytes the kernel has not taken yet; until a pending stream is
+    // attached, everything waits here
+    if (!conn.out_buffer.empty() || conn.fd < 0) {
+        if (conn.out_buffer.size() + frame.size() > kMaxPendingOutput) {
+            lock.unlock();
+            requestClose(conn.id);
+            return false;
+        }
+        conn.out_buffer.append(frame);
+        return true;
+    }
+
+    ssize_t sent = ::send(conn.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    if (sent == static_cast<ssize_t>(frame.size())) {
+        return true;
+    }
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            lock.unlock();
+            requestClose(conn.id);
+            return false;
+        }
+        sent = 0;
+    }
+
+    conn.out_buffer.append(frame.substr(static_cast<size_t>(sent)));
+    watchWritable(conn, true);
+    return true;
+}
+
+void ConnectionHub::handleWritable(const std::shared_ptr<HubConnection>& conn) {
+    std::unique_lock<std::mutex> lock(conn->write_mutex);
+    if (conn->fd < 0 || conn->out_buffer.empty()) {
+        return;
+    }
+
+    ssize_t sent =
+        ::send(conn->fd, conn->out_buffer.data(), conn->out_buffer.size(), MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            lock.unlock();
+            finalize(conn, websocket::kCloseAbnormal);
+        }
+        return;
+    }
+
+    conn->out_buffer.erase(0, static_cast<size_t>(sent));
+    if (conn->out_buffer.empty()) {
+        releaseBuffer(conn->out_buffer);
+        watchWritable(*conn, false);
+        lock.unlock();
+        if (conn->close_after_flush) {
+            finalize(conn, websocket::kCloseNormal);
+        } else if (conn->on_drain) {
+            conn->on_drain();
+        }
+    }
+}
+
+void ConnectionHub::finalize(const std::shared_ptr<HubConnection>& conn, int code) {
+    if (conn->closed.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.erase(conn->id);
+    }
+    {
+        std::lock_guard<std::mutex> lock(topics_mutex_);
+        for (const auto& topic : conn->topics) {
+            auto members = topics_.find(topic);
+            if (members != topics_.end()) {
+                members->second.erase(conn->id);
+                if (members->second.empty()) {
+                    topics_.erase(members);
+                }
+            }
+        }
+        conn->topics.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn->write_mutex);
+        if (conn->fd >= 0) {
+            epoll_ctl(poll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+            ::close(conn->fd);
+            conn->fd = -1;
+        }
+        releaseBuffer(conn->out_buffer);
+    }
+    releaseBuffer(conn->in_buffer);
+    releaseBuffer(conn->message);
+    // The HTTP/2 callbacks own the session, which in turn refers back to the connection
+    conn->on_receive = nullptr;
+    conn->on_drain = nullptr;
+
+    if (conn->handlers && conn->handlers->on_close) {
+        dispatch(conn, [conn, code]() { conn->handlers->on_close(conn, code); });
+    }
+}
+
+bool ConnectionHub::handleFrame(const std::shared_ptr<HubConnection>& conn,
+                               websocket::Frame& frame) {
+    using websocket::Opcode;
+
+    auto protocolError = [&](int code) {
+        sendClose(*conn, code, {});
+        finalize(conn, code);
+        return false;
+    };
+
+    auto deliver = [&](std::string&& message, Opcode opcode) {
+        bool binary = opcode == Opcode::Binary;
+        if (!binary && !websocket::isValidUtf8(message)) {
+            return protocolError(websocket::kCloseInvalidPayload);
+        }
+        messages_received_.fetch_add(1, std::memory_order_relaxed);
+        if (conn->handlers && conn->handlers->on_message) {
+            dispatch(conn, [conn, message = std::move(message), binary]() {
+                conn->handlers->on_message(conn, message, binary);
+            });
+        }
+        return true;
+    };
+
+    switch (frame.opcode) {
+        case Opcode::Ping:
+            writeFrame(*conn, websocket::encodeFrame(Opcode::Pong, frame.payload));
+            return true;
+
+        case Opcode::Pong:
+            conn->ping_outstanding = false;
+            return true;
+
+        case Opcode::Close: {
+            if (frame.payload.size() == 1) {
+                return protocolError(websocket::kCloseProtocolError);
+            }
+            int code = websocket::kCloseNoStatus;
+            if (frame.payload.size() >= 2) {
+                code = (static_cast<unsigned char>(frame.payload[0]) << 8) |
+                       static_cast<unsigned char>(frame.payload[1]);
+            }
+            // Echo the close (or complete the one we started), then drop the socket
+            sendClose(*conn, code == websocket::kCloseNoStatus ? websocket::kCloseNormal : code,
+                      {});
+            finalize(conn, code);
+            return false;
+        }
+
+        case Opcode::Text:
+        case Opcode::Binary:
+            if (conn->message_opcode != Opcode::Continuation) {
+                return protocolError(websocket::kCloseProtocolError);
+            }
+            if (frame.fin) {
+                return deliver(std::move(frame.payload), frame.opcode);
+            }
+            conn->message_opcode = frame.opcode;
+            conn->message = std::move(frame.payload);
+            return true;
+
+        case Opcode::Continuation: {
+            if (conn->message_opcode == Opcode::Continuation) {
+                return protocolError(websocket::kCloseProtocolError);
+            }
+            if (conn->message.size() + frame.payload.size() >
+                max_message_size_.load(std::memory_order_relaxed)) {
+                return protocolError(websocket::kCloseMessageTooBig);
+            }
+            conn->message += frame.payload;
+            if (!frame.fin) {
+                return true;
+            }
+            Opcode opcode = conn->message_opcode;
+            conn->message_opcode = Opcode::Continuation;
+            std::string message = std::move(conn->message);
+            releaseBuffer(conn->message);
+            return deliver(std::move(message), opcode);
+        }
+    }
+    return true;
+}
+
+bool ConnectionHub::processFrames(const std::shared_ptr<HubConnection>& conn,
+                                 const char* data, size_t size, size_t& consumed) {
+    consumed = 0;
+    size_t max_payload = max_message_size_.load(std::memory_order_relaxed);
+
+    while (consumed < size) {
+        websocket::Frame frame;
+        size_t frame_size = 0;
+        switch (websocket::parseFrame(data + consumed, size - consumed, max_payload, frame,
+                                      frame_size)) {
+            case websocket::ParseStatus::Incomplete:
+                return true;
+            case websocket::ParseStatus::ProtocolError:
+                sendClose(*conn, websocket::kCloseProtocolError, {});
+                finalize(conn, websocket::kCloseProtocolError);
+                return false;
+            case websocket::ParseStatus::TooBig:
+                sendClose(*conn, websocket::kCloseMessageTooBig, {});
+                finalize(conn, websocket::kCloseMessageTooBig);
+                return false;
+            case websocket::ParseStatus::Complete:
+                consumed += frame_size;
+                if (!handleFrame(conn, frame)) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+void ConnectionHub::handleReadable(const std::shared_ptr<HubConnection>& conn) {
+    // Shared by every connection; only the loop thread reads
+    static thread_local std::vector<char> read_buffer(kReadBufferSize);
+
+    ssize_t received = ::recv(conn->fd, read_buffer.data(), read_buffer.size(), 0);
+    if (received == 0) {
+        finalize(conn, websocket::kCloseAbnormal);
+        return;
+    }
+    if (received < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            finalize(conn, websocket::kCloseAbnormal);
+        }
+        return;
+    }
+
+    if (conn->mode == HubConnection::Mode::Http2) {
+        if (conn->on_receive &&
+            !conn->on_receive(read_buffer.data(), static_cast<size_t>(received))) {
+            finishResponse(*conn, {});
+        }
+        return;
+    }
+    // Streams only write; whatever the client sends is dropped
+    if (conn->mode != HubConnection::Mode::WebSocket) {
+        return;
+    }
+
+    conn->last_seen = std::chrono::steady_clock::now();
+    conn->ping_outstanding = false;
+
+    size_t consumed = 0;
+    if (conn->in_buffer.empty()) {
+        // Common case: whole frames parsed straight out of the shared buffer
+        if (!processFrames(conn, read_buffer.data(), static_cast<size_t>(received), consumed)) {
+            return;
+        }
+        if (consumed < static_cast<size_t>(received)) {
+            conn->in_buffer.assign(read_buffer.data() + consumed,
+                                   static_cast<size_t>(received) - consumed);
+        }
+        return;
+    }
+
+    conn->in_buffer.append(read_buffer.data(), static_cast<size_t>(received));
+    if (!processFrames(conn, conn->in_buffer.data(), conn->in_buffer.size(), consumed)) {
+        return;
+    }
+    conn->in_buffer.erase(0, consumed);
+    if (conn->in_buffer.empty()) {
+        releaseBuffer(conn->in_buffer);
+    }
+}
+
+void ConnectionHub::sweep(std::chrono::steady_clock::time_point now) {
+    std::vector<std::shared_ptr<HubConnection>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        snapshot.reserve(connections_.size());
+        for (const auto& entry : connections_) {
+            snapshot.push_back(entry.second);
+        }
+    }
+
+    auto interval = std::chrono::seconds(ping_interval_seconds_.load(std::memory_order_relaxed));
+    static const std::string ping = websocket::encodeFrame(websocket::Opcode::Ping, {});
+
+    for (const auto& conn : snapshot) {
+        if (conn->close_sent.load(std::memory_order_acquire)) {
+            std::chrono::steady_clock::time_point started;
+            {
+                std::lock_guard<std::mutex> lock(conn->write_mutex);
+                started = conn->close_sent_at;
+            }
+            if (conn->attached.load(std::memory_order_acquire) &&
+                now - started >= kCloseHandshakeTimeout) {
+                finalize(conn, websocket::kCloseAbnormal);
+            }
+            continue;
+        }
+
+        if (conn->mode == HubConnection::Mode::Deferred) {
+            std::string expiry;
+            {
+                std::lock_guard<std::mutex> lock(conn->write_mutex);
+                if (now < conn->expires_at) {
+                    continue;
+                }
+                expiry = conn->expiry_response;
+            }
+            finishResponse(*conn, expiry);
+            continue;
+        }
+
+        // Nothing below applies until the handler has returned and the socket is polled;
+        // HTTP/2 connections answer their own pings
+        if (conn->mode == HubConnection::Mode::Http2 ||
+            !conn->attached.load(std::memory_order_acquire) || interval.count() <= 0 ||
+            now - conn->last_seen < interval) {
+            continue;
+        }
+
+        if (conn->mode == HubConnection::Mode::EventStream) {
+            // A comment line keeps proxies from timing the stream out
+            conn->last_seen = now;
+            writeFrame(*conn, kKeepAliveComment);
+            continue;
+        }
+        if (!conn->ping_outstanding) {
+            conn->ping_outstanding = true;
+            writeFrame(*conn, ping);
+        } else if (now - conn->last_seen >= 2 * interval) {
+            // A full interval passed without a pong
+            sendClose(*conn, websocket::kCloseGoingAway, "Ping timeout");
+            finalize(conn, websocket::kCloseAbnormal);
+        }
+    }
+}
+
+void ConnectionHub::loop() {
+    std::vector<epoll_event> events(256);
+    auto last_sweep = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_acquire)) {
+        int ready = epoll_wait(poll_fd_, events.data(), static_cast<int>(events.size()), 1000);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "Connection hub event loop error: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            uint64_t id = events[i].data.u64;
+            if (id == 0) {
+                uint64_t count;
+                [[maybe_unused]] ssize_t ignored = ::read(wake_fd_, &count, sizeof(count));
+                continue;
+            }
+
+            auto conn = findConnection(id);
+            if (!conn) {
+                continue;
+            }
+            uint32_t flags = events[i].events;
+            if (flags & EPOLLIN) {
+                handleReadable(conn);
+            } else if (flags & (EPOLLERR | EPOLLHUP)) {
+                finalize(conn, websocket::kCloseAbnormal);
+                continue;
+            }
+            if ((flags & EPOLLOUT) && conn->isOpen()) {
+                handleWritable(conn);
+            }
+        }
+
+        // Connections whose writes failed on another thread
+        std::vector<uint64_t> closes;
+        {
+            std::lock_guard<std::mutex> lock(close_mutex_);
+            closes.swap(pending_closes_);
+        }
+        for (uint64_t id : closes) {
+            if (auto conn = findConnection(id)) {
+                finalize(conn, websocket::kCloseAbnormal);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep >= kSweepInterval) {
+            last_sweep = now;
+            sweep(now);
+        }
+    }
+}
+
+#else  // !__linux__
+
+bool ConnectionHub::start(TaskRunner) {
+    return false;
+}
+
+void ConnectionHub::stop() {}
+
+std::shared_ptr<HubConnection> ConnectionHub::adopt(int, const std::string&,
+                                                    std::map<std::string, std::string>,
+                                                    std::shared_ptr<const WebSocketHandlers>) {
+    return nullptr;
+}
+
+bool ConnectionHub::attach(const std::shared_ptr<HubConnection>&, int, std::string_view) {
+    return false;
+}
+
+bool ConnectionHub::watch(int, uint64_t, bool) {
+    return false;
+}
+
+bool ConnectionHub::writeFrame(HubConnection&, std::string_view) {
+    return false;
+}
+
+void ConnectionHub::requestClose(uint64_t) {}
+void ConnectionHub::finalize(const std::shared_ptr<HubConnection>&, int) {}
+void ConnectionHub::watchWritable(HubConnection&, bool) {}
+void ConnectionHub::wake() {}
+void ConnectionHub::loop() {}
+void ConnectionHub::handleReadable(const std::shared_ptr<HubConnection>&) {}
+void ConnectionHub::handleWritable(const std::shared_ptr<HubConnection>&) {}
+bool ConnectionHub::processFrames(const std::shared_ptr<HubConnection>&, const char*, size_t,
+                                 size_t&) {
+    return false;
+}
+bool ConnectionHub::handleFrame(const std::shared_ptr<HubConnection>&, websocket::Frame&) {
+    return false;
+}
+void ConnectionHub::sweep(std::chrono::steady_clock::time_point) {}
+
+#endif  // __linux__
+
+}  // namespace o2l
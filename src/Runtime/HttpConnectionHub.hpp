@@ -0,0 +1,220 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "HttpWebSocket.hpp"
+
+namespace o2l {
+
+class ObjectInstance;
+class ConnectionHub;
+
+// A connection that outlives its request: an upgraded WebSocket, a Server-Sent Events stream,
+// a deferred (long-poll) response or an HTTP/2 connection. Idle connections hold no read
+// buffer; everything else is a handful of words, so tens of thousands of them stay cheap.
+struct HubConnection {
+    enum class Mode { WebSocket, EventStream, Deferred, Http2 };
+
+    Mode mode = Mode::WebSocket;
+    uint64_t id = 0;
+    std::string path;
+    std::map<std::string, std::string> params;
+    std::shared_ptr<const WebSocketHandlers> handlers;  // WebSocket only
+    std::weak_ptr<ConnectionHub> hub;
+
+    // Script object handed to O²L code; created on first use and reused afterwards
+    std::shared_ptr<ObjectInstance> script_object;
+
+    // Deferred only: builds the complete HTTP response for a published message, and the
+    // response sent when nothing completed the request in time. Guarded by write_mutex.
+    std::function<std::string(std::string_view)> render;
+    std::string expiry_response;
+    std::chrono::steady_clock::time_point expires_at =
+        std::chrono::steady_clock::time_point::max();
+
+    // Http2 only: bytes read from the socket (false closes the connection once flushed),
+    // and a notification that buffered output has drained. Called on the loop thread.
+    std::function<bool(const char*, size_t)> on_receive;
+    std::function<void()> on_drain;
+
+    // Safe from any thread. Writes made before the socket is attached (while the request
+    // handler is still running) are queued and sent right after the response head.
+    bool send(std::string_view message, bool binary = false);  // WebSocket message
+    bool write(std::string_view bytes);                        // raw bytes (event streams)
+    bool finish(std::string_view bytes);  // write, then close once everything is flushed
+    // WebSocket: start the closing handshake. Streams: close once output is flushed.
+    void close(int code = websocket::kCloseNormal, std::string_view reason = {});
+    void subscribe(const std::string& topic);
+    void unsubscribe(const std::string& topic);
+    size_t bufferedOutput();  // bytes waiting for the socket
+    bool isOpen() const {
+        return !closed.load(std::memory_order_acquire);
+    }
+
+    // Owned by the hub
+    int fd = -1;
+    std::mutex write_mutex;  // guards fd for writers, out_buffer and close_after_flush
+    std::string out_buffer;  // bytes the kernel would not take yet
+    std::string in_buffer;   // partial frame carried between reads (loop thread only)
+    std::string message;     // fragmented message being assembled (loop thread only)
+    websocket::Opcode message_opcode = websocket::Opcode::Continuation;  // none pending
+    std::chrono::steady_clock::time_point last_seen;
+    std::chrono::steady_clock::time_point close_sent_at;
+    bool ping_outstanding = false;
+    bool close_after_flush = false;
+    std::atomic<bool> attached{false};  // bound to its socket and polled
+    std::atomic<bool> close_sent{false};
+    std::atomic<bool> closed{false};
+    std::vector<std::string> topics;  // guarded by the hub's topic mutex
+
+    // Events run on the worker pool one at a time, in arrival order
+    std::mutex events_mutex;
+    std::deque<std::function<void()>> events;
+    bool events_scheduled = false;
+};
+
+/**
+ * Event loop for connections that outlive their request.
+ *
+ * A single thread multiplexes every connection with epoll, so an idle WebSocket or event
+ * stream costs a socket and a small struct rather than a worker thread. WebSocket reads are
+ * parsed in place from a shared buffer and only a partial frame is ever copied onto the
+ * connection. Script callbacks are handed to the server's worker pool through `TaskRunner`,
+ * serialized per connection. Idle WebSocket peers are pinged every ping interval and dropped
+ * if they miss a pong; event streams get a comment line on the same schedule.
+ */
+class ConnectionHub : public std::enable_shared_from_this<ConnectionHub> {
+   public:
+    using TaskRunner = std::function<void(std::function<void()>)>;
+
+    ConnectionHub();
+    ~ConnectionHub();
+
+    ConnectionHub(const ConnectionHub&) = delete;
+    ConnectionHub& operator=(const ConnectionHub&) = delete;
+
+    static bool isSupported();
+
+    // Start the event loop; false if the platform has no supported poller
+    bool start(TaskRunner runner);
+    // Close every connection (WebSockets with 1001) and stop the loop
+    void stop();
+    bool isRunning() const {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    // Take ownership of an upgraded WebSocket; nullptr if the hub is not running
+    std::shared_ptr<HubConnection> adopt(int fd, const std::string& path,
+                                         std::map<std::string, std::string> params,
+                                         std::shared_ptr<const WebSocketHandlers> handlers);
+
+    // Register a stream for a response whose handler is still running; it accepts writes
+    // and subscriptions straight away and is bound to its socket by attach()
+    std::shared_ptr<HubConnection> createPending(HubConnection::Mode mode);
+    // Bind a pending stream to its socket; `head` is sent ahead of anything already queued.
+    // On failure the socket is left to the caller.
+    bool attach(const std::shared_ptr<HubConnection>& conn, int fd, std::string_view head);
+    // Drop a pending stream that will never be attached
+    void discard(const std::shared_ptr<HubConnection>& conn);
+
+    // Deliver to every connection subscribed to topic: a message frame for WebSockets, a
+    // `data:` event for event streams, the response body for deferred requests. Returns the
+    // number of recipients.
+    size_t publish(const std::string& topic, std::string_view message, bool binary = false);
+
+    void setPingInterval(int seconds) {
+        ping_interval_seconds_.store(seconds, std::memory_order_relaxed);
+    }
+    int getPingInterval() const {
+        return ping_interval_seconds_.load(std::memory_order_relaxed);
+    }
+    void setMaxMessageSize(size_t bytes) {
+        max_message_size_.store(bytes, std::memory_order_relaxed);
+    }
+
+    // Open connections of every kind, and of one kind
+    size_t getConnectionCount() const;
+    size_t getConnectionCount(HubConnection::Mode mode) const;
+    size_t getMessagesReceived() const {
+        return messages_received_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    friend struct HubConnection;
+
+    void loop();
+    void handleReadable(const std::shared_ptr<HubConnection>& conn);
+    void handleWritable(const std::shared_ptr<HubConnection>& conn);
+    // Returns false if the connection was closed while processing
+    bool processFrames(const std::shared_ptr<HubConnection>& conn, const char* data, size_t size,
+                       size_t& consumed);
+    bool handleFrame(const std::shared_ptr<HubConnection>& conn, websocket::Frame& frame);
+    void sweep(std::chrono::steady_clock::time_point now);
+
+    void registerConnection(const std::shared_ptr<HubConnection>& conn);
+    bool watch(int fd, uint64_t id, bool writable);
+    bool writeFrame(HubConnection& conn, std::string_view frame);
+    bool finishResponse(HubConnection& conn, std::string_view bytes);
+    void sendClose(HubConnection& conn, int code, std::string_view reason);
+    void requestClose(uint64_t id);
+    void finalize(const std::shared_ptr<HubConnection>& conn, int code);
+    void watchWritable(HubConnection& conn, bool enable);
+    void wake();
+
+    void subscribe(HubConnection& conn, const std::string& topic);
+    void unsubscribe(HubConnection& conn, const std::string& topic);
+    void dispatch(const std::shared_ptr<HubConnection>& conn, std::function<void()> event);
+
+    std::shared_ptr<HubConnection> findConnection(uint64_t id) const;
+
+    int poll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread loop_thread_;
+    std::atomic<bool> running_{false};
+    TaskRunner runner_;
+
+    mutable std::mutex connections_mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<HubConnection>> connections_;
+    std::atomic<uint64_t> next_id_{1};
+
+    std::mutex topics_mutex_;
+    std::unordered_map<std::string, std::unordered_set<uint64_t>> topics_;
+
+    std::mutex close_mutex_;
+    std::vector<uint64_t> pending_closes_;
+
+    std::atomic<int> ping_interval_seconds_{30};
+    std::atomic<size_t> max_message_size_{16 * 1024 * 1024};
+    std::atomic<size_t> messages_received_{0};
+};
+
+}  // namespace o2l
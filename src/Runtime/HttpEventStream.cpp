@@ -0,0 +1,264 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpEventStream.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+
+#include "HttpConnectionHub.hpp"
+#include "HttpServerLibrary.hpp"
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+namespace sse {
+
+std::string encodeEvent(std::string_view event, std::string_view data) {
+    std::string encoded;
+    encoded.reserve(data.size() + event.size() + 16);
+
+    // Line breaks in the name would start a new field, so they are dropped
+    if (!event.empty()) {
+        encoded += "event: ";
+        for (char c : event) {
+            if (c != '\n' && c != '\r') encoded.push_back(c);
+        }
+        encoded.push_back('\n');
+    }
+
+    size_t start = 0;
+    for (;;) {
+        size_t end = data.find_first_of("\r\n", start);
+        encoded += "data: ";
+        encoded.append(data.substr(start, end == std::string_view::npos ? end : end - start));
+        encoded.push_back('\n');
+        if (end == std::string_view::npos) {
+            break;
+        }
+        start = end + 1;
+        if (data[end] == '\r' && start < data.size() && data[start] == '\n') {
+            ++start;  // CRLF is a single break
+        }
+    }
+    encoded.push_back('\n');
+    return encoded;
+}
+
+}  // namespace sse
+
+namespace {
+
+const std::string& requireText(const std::vector<Value>& args, size_t index, const char* error) {
+    if (args.size() <= index || !std::holds_alternative<Text>(args[index])) {
+        throw std::runtime_error(error);
+    }
+    return std::get<Text>(args[index]);
+}
+
+// Methods both stream objects share. They hold the connection weakly, so a script that keeps
+// the object after the client is gone gets false back rather than pinning the connection.
+void addCommonMethods(ObjectInstance& object, const std::weak_ptr<HubConnection>& weak,
+                      Int id) {
+    object.addMethod(
+        "subscribe",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
+            const auto& topic = requireText(args, 0, "subscribe() requires a topic string");
+            auto conn = weak.lock();
+            if (!conn || !conn->isOpen()) {
+                return Value(Bool(false));
+            }
+            conn->subscribe(topic);
+            return Value(Bool(true));
+        },
+        true);
+
+    object.addMethod(
+        "isOpen",
+        [weak](const std::vector<Value>&, Context&) -> Value {
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->isOpen()));
+        },
+        true);
+
+    object.addMethod(
+        "getId", [id](const std::vector<Value>&, Context&) -> Value { return Value(Int(id)); },
+        true);
+}
+
+// State behind a DeferredResponse: the response being assembled, rendered on completion
+struct DeferredState {
+    std::mutex mutex;
+    HttpServerResponse response;
+
+    std::string render(std::string_view body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        HttpServerResponse complete = response;
+        complete.body.assign(body);
+        return serializeHttpResponse(complete, false);
+    }
+
+    std::string renderExpired() {
+        std::lock_guard<std::mutex> lock(mutex);
+        HttpServerResponse expired = response;
+        expired.status_code = 204;
+        expired.status_message = httpStatusMessage(204);
+        expired.body.clear();
+        return serializeHttpResponse(expired, false);
+    }
+};
+
+}  // namespace
+
+std::shared_ptr<ObjectInstance> createEventStreamObject(
+    const std::shared_ptr<HubConnection>& connection) {
+    std::weak_ptr<HubConnection> weak = connection;
+    auto stream_obj = std::make_shared<ObjectInstance>("EventStream");
+
+    stream_obj->addMethod(
+        "send",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
+            // send(data) or send(event, data)
+            bool named = args.size() > 1;
+            const auto& data = requireText(args, named ? 1 : 0, "send() requires a data string");
+            std::string_view event;
+            if (named) {
+                event = requireText(args, 0, "send() event name must be a string");
+            }
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->write(sse::encodeEvent(event, data))));
+        },
+        true);
+
+    stream_obj->addMethod(
+        "unsubscribe",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
+            const auto& topic = requireText(args, 0, "unsubscribe() requires a topic string");
+            auto conn = weak.lock();
+            if (!conn || !conn->isOpen()) {
+                return Value(Bool(false));
+            }
+            conn->unsubscribe(topic);
+            return Value(Bool(true));
+        },
+        true);
+
+    stream_obj->addMethod(
+        "close",
+        [weak](const std::vector<Value>&, Context&) -> Value {
+            auto conn = weak.lock();
+            if (!conn || !conn->isOpen()) {
+                return Value(Bool(false));
+            }
+            conn->close();
+            return Value(Bool(true));
+        },
+        true);
+
+    addCommonMethods(*stream_obj, weak, static_cast<Int>(connection->id));
+    connection->script_object = stream_obj;
+    return stream_obj;
+}
+
+std::shared_ptr<ObjectInstance> createDeferredResponseObject(
+    const std::shared_ptr<HubConnection>& connection, const HttpServerResponse& base,
+    int timeout_seconds) {
+    auto state = std::make_shared<DeferredState>();
+    state->response.status_code = 200;
+    state->response.status_message = httpStatusMessage(200);
+    state->response.headers = base.headers;
+    state->response.headers.erase("Content-Length");
+
+    {
+        std::lock_guard<std::mutex> lock(connection->write_mutex);
+        connection->render = [state](std::string_view body) { return state->render(body); };
+        connection->expiry_response = state->renderExpired();
+        connection->expires_at =
+            std::chrono::steady_clock::now() + std::chrono::seconds(timeout_seconds);
+    }
+
+    std::weak_ptr<HubConnection> weak = connection;
+    auto deferred_obj = std::make_shared<ObjectInstance>("DeferredResponse");
+
+    // Header changes also apply to the 204 sent on timeout
+    auto refreshExpiry = [state](HubConnection& conn) {
+        std::string expired = state->renderExpired();
+        std::lock_guard<std::mutex> lock(conn.write_mutex);
+        conn.expiry_response = std::move(expired);
+    };
+
+    deferred_obj->addMethod(
+        "setStatus",
+        [state](const std::vector<Value>& args, Context&) -> Value {
+            if (args.empty() || !std::holds_alternative<Int>(args[0])) {
+                throw std::runtime_error("setStatus() requires a status code number");
+            }
+            int status = static_cast<int>(std::get<Int>(args[0]));
+            if (status < 200 || status >= 600) {
+                throw std::runtime_error("Invalid HTTP status code: " + std::to_string(status));
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->response.status_code = status;
+            state->response.status_message = httpStatusMessage(status);
+            return Value(Bool(true));
+        },
+        true);
+
+    deferred_obj->addMethod(
+        "setHeader",
+        [state, weak, refreshExpiry](const std::vector<Value>& args, Context&) -> Value {
+            const auto& name = requireText(args, 0, "setHeader() requires header name and value");
+            const auto& value = requireText(args, 1, "setHeader() requires header name and value");
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->response.headers[name] = value;
+            }
+            if (auto conn = weak.lock()) {
+                refreshExpiry(*conn);
+            }
+            return Value(Bool(true));
+        },
+        true);
+
+    deferred_obj->addMethod(
+        "send",
+        [state, weak](const std::vector<Value>& args, Context&) -> Value {
+            const auto& body = requireText(args, 0, "send() requires response content");
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->finish(state->render(body))));
+        },
+        true);
+
+    deferred_obj->addMethod(
+        "json",
+        [state, weak](const std::vector<Value>& args, Context&) -> Value {
+            const auto& body = requireText(args, 0, "json() requires JSON string");
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->response.headers["Content-Type"] = "application/json";
+            }
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->finish(state->render(body))));
+        },
+        true);
+
+    addCommonMethods(*deferred_obj, weak, static_cast<Int>(connection->id));
+    connection->script_object = deferred_obj;
+    return deferred_obj;
+}
+
+}  // namespace o2l
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace o2l {
+
+class ObjectInstance;
+struct HubConnection;
+struct HttpServerResponse;
+
+// Server-Sent Events wire format (text/event-stream)
+namespace sse {
+
+// Encode one event. Multi-line data becomes one `data:` line per line; an empty event name
+// leaves the client's default ("message").
+std::string encodeEvent(std::string_view event, std::string_view data);
+
+}  // namespace sse
+
+// Script object for a Server-Sent Events stream ("EventStream"): send([event,] data),
+// subscribe, unsubscribe, close, isOpen, getId
+std::shared_ptr<ObjectInstance> createEventStreamObject(
+    const std::shared_ptr<HubConnection>& connection);
+
+// Script object for a long-poll response completed later ("DeferredResponse"): setStatus,
+// setHeader, send, json, subscribe, isOpen, getId. Headers start from `base`; if nothing
+// completes it within timeout_seconds the client gets 204 No Content.
+std::shared_ptr<ObjectInstance> createDeferredResponseObject(
+    const std::shared_ptr<HubConnection>& connection, const HttpServerResponse& base,
+    int timeout_seconds);
+
+}  // namespace o2l
@@ -0,0 +1,523 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpHpack.hpp"
+
+#include <algorithm>
+
+namespace o2l {
+
+namespace hpack {
+
+namespace {
+
+struct StaticEntry {
+    std::string_view name;
+    std::string_view value;
+};
+
+// RFC 7541 Appendix A
+constexpr StaticEntry kStaticTable[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+constexpr size_t kStaticTableSize = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+// RFC 7541 Appendix B, indexed by symbol (EOS is never encoded)
+const uint32_t kHuffmanCodes[256] = {
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5,
+    0xfffffe6, 0xfffffe7, 0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9,
+    0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec, 0xfffffed, 0xfffffee,
+    0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9,
+    0xffffffa, 0xffffffb, 0x14, 0x3f8, 0x3f9, 0xffa,
+    0x1ff9, 0x15, 0xf8, 0x7fa, 0x3fa, 0x3fb,
+    0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b,
+    0x1c, 0x1d, 0x1e, 0x1f, 0x5c, 0xfb,
+    0x7ffc, 0x20, 0xffb, 0x3fc, 0x1ffa, 0x21,
+    0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e,
+    0x6f, 0x70, 0x71, 0x72, 0xfc, 0x73,
+    0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5,
+    0x25, 0x26, 0x27, 0x6, 0x74, 0x75,
+    0x28, 0x29, 0x2a, 0x7, 0x2b, 0x76,
+    0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd,
+    0x1ffd, 0xffffffc, 0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8,
+    0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9, 0x3fffd6, 0x7fffda,
+    0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1,
+    0x7fffe2, 0x7fffe3, 0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5,
+    0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef, 0x3fffda, 0x1fffdd,
+    0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf,
+    0x7fffeb, 0x7fffec, 0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2,
+    0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef, 0xfffea, 0x3fffe2,
+    0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2,
+    0x3fffe8, 0x1ffffec, 0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde,
+    0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed, 0x7fff2, 0x1fffe3,
+    0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3,
+    0x7ffffe4, 0x7ffffe5, 0xfffec, 0xfffff3, 0xfffed, 0x1fffe6,
+    0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3, 0x3fffea, 0x3fffeb,
+    0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8,
+    0x7ffffe9, 0x7ffffea, 0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed,
+    0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+};
+
+const uint8_t kHuffmanLengths[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+constexpr size_t kEntryOverhead = 32;
+constexpr size_t kMaxEncoderTableSize = 4096;
+
+size_t entrySize(std::string_view name, std::string_view value) {
+    return name.size() + value.size() + kEntryOverhead;
+}
+
+// Binary tree over the code table, built once; node 0 is the root
+struct HuffmanNode {
+    int16_t next[2] = {-1, -1};
+    int16_t symbol = -1;
+};
+
+const std::vector<HuffmanNode>& huffmanTree() {
+    static const std::vector<HuffmanNode> tree = [] {
+        std::vector<HuffmanNode> nodes(1);
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            size_t node = 0;
+            for (int bit = kHuffmanLengths[symbol] - 1; bit >= 0; --bit) {
+                int branch = (kHuffmanCodes[symbol] >> bit) & 1;
+                if (nodes[node].next[branch] < 0) {
+                    nodes[node].next[branch] = static_cast<int16_t>(nodes.size());
+                    nodes.emplace_back();
+                }
+                node = static_cast<size_t>(nodes[node].next[branch]);
+            }
+            nodes[node].symbol = static_cast<int16_t>(symbol);
+        }
+        return nodes;
+    }();
+    return tree;
+}
+
+// Values that change on nearly every response would only churn the dynamic table
+bool isNeverIndexed(std::string_view name) {
+    return name == "date" || name == "content-length" || name == "etag" ||
+           name == "last-modified" || name == "set-cookie" || name == "authorization" ||
+           name == "x-request-id" || name == "x-response-time" || name == "server-timing";
+}
+
+// Credentials must not be indexed by intermediaries either (RFC 7541 6.2.3)
+bool isSensitive(std::string_view name) {
+    return name == "set-cookie" || name == "authorization";
+}
+
+bool decodeString(const uint8_t*& data, const uint8_t* end, std::string& out) {
+    if (data >= end) {
+        return false;
+    }
+    bool huffman = *data & 0x80;
+    uint64_t length;
+    if (!decodeInteger(data, end, 7, length) || length > static_cast<uint64_t>(end - data)) {
+        return false;
+    }
+    const uint8_t* start = data;
+    data += length;
+    if (huffman) {
+        out.clear();
+        return huffmanDecode(start, static_cast<size_t>(length), out);
+    }
+    out.assign(reinterpret_cast<const char*>(start), static_cast<size_t>(length));
+    return true;
+}
+
+void encodeString(std::string_view value, std::string& out) {
+    size_t huffman_length = huffmanEncodedLength(value);
+    if (huffman_length < value.size()) {
+        encodeInteger(huffman_length, 7, 0x80, out);
+        huffmanEncode(value, out);
+    } else {
+        encodeInteger(value.size(), 7, 0x00, out);
+        out.append(value);
+    }
+}
+
+}  // namespace
+
+//=============================================================================
+// Primitives
+//=============================================================================
+
+void encodeInteger(uint64_t value, uint8_t prefix_bits, uint8_t first_byte, std::string& out) {
+    const uint64_t limit = (1u << prefix_bits) - 1;
+    if (value < limit) {
+        out.push_back(static_cast<char>(first_byte | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first_byte | limit));
+    value -= limit;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decodeInteger(const uint8_t*& data, const uint8_t* end, uint8_t prefix_bits,
+                   uint64_t& value) {
+    if (data >= end) {
+        return false;
+    }
+    const uint64_t limit = (1u << prefix_bits) - 1;
+    value = *data++ & limit;
+    if (value < limit) {
+        return true;
+    }
+    for (unsigned shift = 0; data < end && shift <= 56; shift += 7) {
+        uint8_t byte = *data++;
+        value += static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t huffmanEncodedLength(std::string_view input) {
+    size_t bits = 0;
+    for (unsigned char c : input) {
+        bits += kHuffmanLengths[c];
+    }
+    return (bits + 7) / 8;
+}
+
+void huffmanEncode(std::string_view input, std::string& out) {
+    // At most 7 + 30 bits are pending at a time; bits already emitted may overflow harmlessly
+    uint64_t bits = 0;
+    unsigned count = 0;
+    for (unsigned char c : input) {
+        bits = (bits << kHuffmanLengths[c]) | kHuffmanCodes[c];
+        count += kHuffmanLengths[c];
+        while (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    if (count > 0) {
+        // Pad with the most significant bits of EOS (all ones)
+        out.push_back(static_cast<char>((bits << (8 - count)) | (0xFFu >> count)));
+    }
+}
+
+bool huffmanDecode(const uint8_t* data, size_t size, std::string& out) {
+    const auto& tree = huffmanTree();
+    size_t node = 0;
+    unsigned depth = 0;    // bits consumed since the last symbol
+    bool all_ones = true;  // padding must be a prefix of EOS
+
+    for (size_t i = 0; i < size; ++i) {
+        for (int bit = 7; bit >= 0; --bit) {
+            int branch = (data[i] >> bit) & 1;
+            int16_t next = tree[node].next[branch];
+            if (next < 0) {
+                return false;  // EOS, which must not appear in a string
+            }
+            node = static_cast<size_t>(next);
+            ++depth;
+            all_ones = all_ones && branch;
+            if (tree[node].symbol >= 0) {
+                out.push_back(static_cast<char>(tree[node].symbol));
+                node = 0;
+                depth = 0;
+                all_ones = true;
+            }
+        }
+    }
+    return depth <= 7 && all_ones;
+}
+
+//=============================================================================
+// DynamicTable
+//=============================================================================
+
+void DynamicTable::add(std::string name, std::string value) {
+    size_t size = entrySize(name, value);
+    if (size > max_size_) {
+        // An entry larger than the table empties it and is not added
+        evict(0);
+        return;
+    }
+    evict(max_size_ - size);
+    size_ += size;
+    entries_.push_front(HeaderField{std::move(name), std::move(value)});
+}
+
+void DynamicTable::setMaxSize(size_t max_size) {
+    max_size_ = max_size;
+    evict(max_size_);
+}
+
+void DynamicTable::evict(size_t target) {
+    while (size_ > target && !entries_.empty()) {
+        size_ -= entrySize(entries_.back().name, entries_.back().value);
+        entries_.pop_back();
+    }
+}
+
+//=============================================================================
+// Decoder
+//=============================================================================
+
+Decoder::Decoder(size_t max_table_size, size_t max_list_size)
+    : table_(max_table_size), max_table_size_(max_table_size), max_list_size_(max_list_size) {}
+
+bool Decoder::lookup(uint64_t index, HeaderField& field) const {
+    if (index == 0) {
+        return false;
+    }
+    if (index <= kStaticTableSize) {
+        const StaticEntry& entry = kStaticTable[index - 1];
+        field.name.assign(entry.name);
+        field.value.assign(entry.value);
+        return true;
+    }
+    index -= kStaticTableSize + 1;
+    if (index >= table_.getCount()) {
+        return false;
+    }
+    field = table_.at(static_cast<size_t>(index));
+    return true;
+}
+
+bool Decoder::decode(const uint8_t* data, size_t size, HeaderList& headers) {
+    const uint8_t* end = data + size;
+    bool field_seen = false;
+    size_t list_size = 0;
+    list_size_exceeded_ = false;
+
+    // A few bytes can reference large dynamic table entries, so the compressed block size
+    // bounds nothing; count what the fields expand to
+    auto withinListSize = [&](const HeaderField& field) {
+        list_size += field.name.size() + field.value.size() + 32;
+        list_size_exceeded_ = list_size > max_list_size_;
+        return !list_size_exceeded_;
+    };
+
+    while (data < end) {
+        uint8_t first = *data;
+        uint64_t index;
+
+        if (first & 0x80) {
+            // Indexed header field
+            HeaderField field;
+            if (!decodeInteger(data, end, 7, index) || !lookup(index, field) ||
+                !withinListSize(field)) {
+                return false;
+            }
+            headers.push_back(std::move(field));
+            field_seen = true;
+            continue;
+        }
+
+        if ((first & 0xE0) == 0x20) {
+            // Dynamic table size update; only allowed before the first field
+            if (field_seen || !decodeInteger(data, end, 5, index) || index > max_table_size_) {
+                return false;
+            }
+            table_.setMaxSize(static_cast<size_t>(index));
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without indexing (0000) or never indexed
+        // (0001); a zero index means the name follows as a string
+        bool incremental = (first & 0xC0) == 0x40;
+        HeaderField field;
+        if (!decodeInteger(data, end, incremental ? 6 : 4, index)) {
+            return false;
+        }
+        if (index != 0) {
+            HeaderField named;
+            if (!lookup(index, named)) {
+                return false;
+            }
+            field.name = std::move(named.name);
+        } else if (!decodeString(data, end, field.name)) {
+            return false;
+        }
+        if (!decodeString(data, end, field.value) || !withinListSize(field)) {
+            return false;
+        }
+
+        if (incremental) {
+            table_.add(field.name, field.value);
+        }
+        headers.push_back(std::move(field));
+        field_seen = true;
+    }
+    return true;
+}
+
+//=============================================================================
+// Encoder
+//=============================================================================
+
+void Encoder::setMaxTableSize(size_t max_size) {
+    size_t size = std::min(max_size, kMaxEncoderTableSize);
+    if (size == table_.getMaxSize() && pending_table_size_ == SIZE_MAX) {
+        return;
+    }
+    pending_table_size_ = size;
+    smallest_table_size_ = std::min(smallest_table_size_, size);
+}
+
+void Encoder::encode(const HeaderList& headers, std::string& out) {
+    if (pending_table_size_ != SIZE_MAX) {
+        // A shrink followed by a grow between blocks must signal both (RFC 7541 4.2)
+        if (smallest_table_size_ < pending_table_size_) {
+            encodeInteger(smallest_table_size_, 5, 0x20, out);
+            table_.setMaxSize(smallest_table_size_);
+        }
+        encodeInteger(pending_table_size_, 5, 0x20, out);
+        table_.setMaxSize(pending_table_size_);
+        pending_table_size_ = SIZE_MAX;
+        smallest_table_size_ = SIZE_MAX;
+    }
+
+    for (const auto& field : headers) {
+        uint64_t name_index = 0;
+        uint64_t full_index = 0;
+        for (size_t i = 0; i < kStaticTableSize && full_index == 0; ++i) {
+            if (kStaticTable[i].name == field.name) {
+                if (name_index == 0) name_index = i + 1;
+                if (kStaticTable[i].value == field.value) full_index = i + 1;
+            }
+        }
+        for (size_t i = 0; i < table_.getCount() && full_index == 0; ++i) {
+            const HeaderField& entry = table_.at(i);
+            if (entry.name == field.name) {
+                if (name_index == 0) name_index = kStaticTableSize + 1 + i;
+                if (entry.value == field.value) full_index = kStaticTableSize + 1 + i;
+            }
+        }
+
+        if (full_index != 0) {
+            encodeInteger(full_index, 7, 0x80, out);
+            continue;
+        }
+
+        bool index = !isNeverIndexed(field.name) &&
+                     entrySize(field.name, field.value) <= table_.getMaxSize() / 2;
+        if (index) {
+            encodeInteger(name_index, 6, 0x40, out);
+        } else {
+            encodeInteger(name_index, 4, isSensitive(field.name) ? 0x10 : 0x00, out);
+        }
+        if (name_index == 0) {
+            encodeString(field.name, out);
+        }
+        encodeString(field.value, out);
+
+        if (index) {
+            table_.add(field.name, field.value);
+        }
+    }
+}
+
+}  // namespace hpack
+
+}  // namespace o2l
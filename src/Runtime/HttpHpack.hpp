@@ -0,0 +1,123 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace o2l {
+
+// HPACK header compression for HTTP/2 (RFC 7541)
+namespace hpack {
+
+struct HeaderField {
+    std::string name;
+    std::string value;
+};
+
+using HeaderList = std::vector<HeaderField>;
+
+// Entries added by header blocks, newest first; sizes count 32 bytes of overhead per entry
+class DynamicTable {
+   public:
+    explicit DynamicTable(size_t max_size = 4096) : max_size_(max_size) {}
+
+    void add(std::string name, std::string value);
+    void setMaxSize(size_t max_size);
+    size_t getMaxSize() const {
+        return max_size_;
+    }
+    size_t getSize() const {
+        return size_;
+    }
+    size_t getCount() const {
+        return entries_.size();
+    }
+    // 0-based from the newest entry
+    const HeaderField& at(size_t index) const {
+        return entries_[index];
+    }
+
+   private:
+    void evict(size_t target);
+
+    std::deque<HeaderField> entries_;
+    size_t size_ = 0;
+    size_t max_size_;
+};
+
+class Decoder {
+   public:
+    // max_table_size is the SETTINGS_HEADER_TABLE_SIZE this side advertised and
+    // max_list_size its SETTINGS_MAX_HEADER_LIST_SIZE
+    explicit Decoder(size_t max_table_size = 4096, size_t max_list_size = SIZE_MAX);
+
+    // Decode one complete header block, appending to headers. Returns false on a
+    // compression error or once the decoded list passes max_list_size (name + value + 32
+    // per field, RFC 9113 6.5.2), after which the connection must be torn down.
+    bool decode(const uint8_t* data, size_t size, HeaderList& headers);
+
+    // Whether the last failed decode() stopped at max_list_size
+    bool listSizeExceeded() const {
+        return list_size_exceeded_;
+    }
+
+    const DynamicTable& getTable() const {
+        return table_;
+    }
+
+   private:
+    bool lookup(uint64_t index, HeaderField& field) const;
+
+    DynamicTable table_;
+    size_t max_table_size_;
+    size_t max_list_size_;
+    bool list_size_exceeded_ = false;
+};
+
+class Encoder {
+   public:
+    Encoder() = default;
+
+    // The peer's SETTINGS_HEADER_TABLE_SIZE; the change is signalled in the next block
+    void setMaxTableSize(size_t max_size);
+
+    // Fields whose value rarely repeats (dates, lengths, cookies) are never added to the
+    // dynamic table; everything else is indexed so repeated responses shrink to a few bytes.
+    void encode(const HeaderList& headers, std::string& out);
+
+   private:
+    DynamicTable table_;
+    size_t pending_table_size_ = SIZE_MAX;  // SIZE_MAX: no size update to send
+    size_t smallest_table_size_ = SIZE_MAX;
+};
+
+// Primitive codecs, exposed for tests
+void encodeInteger(uint64_t value, uint8_t prefix_bits, uint8_t first_byte, std::string& out);
+bool decodeInteger(const uint8_t*& data, const uint8_t* end, uint8_t prefix_bits,
+                   uint64_t& value);
+void huffmanEncode(std::string_view input, std::string& out);
+size_t huffmanEncodedLength(std::string_view input);
+bool huffmanDecode(const uint8_t* data, size_t size, std::string& out);
+
+}  // namespace hpack
+
+}  // namespace o2l
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpMiddleware.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "HttpResponseCache.hpp"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace o2l {
+
+namespace {
+
+std::string optionOr(const MiddlewareOptions& options, const std::string& key,
+                     const std::string& fallback) {
+    auto it = options.find(key);
+    return it != options.end() ? it->second : fallback;
+}
+
+int intOption(const MiddlewareOptions& options, const std::string& key, int fallback) {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return fallback;
+    }
+    try {
+        return std::stoi(it->second);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Middleware option '" + key + "' must be an integer, got '" +
+                                 it->second + "'");
+    }
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string generateRequestId() {
+    thread_local std::mt19937_64 generator(
+        std::random_device{}() ^ std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                  static_cast<unsigned long long>(generator()),
+                  static_cast<unsigned long long>(generator()));
+    return std::string(buffer, 32);
+}
+
+bool isCompressibleType(const std::string& content_type) {
+    std::string type = toLower(content_type);
+    return type.rfind("text/", 0) == 0 || type.find("json") != std::string::npos ||
+           type.find("javascript") != std::string::npos ||
+           type.find("xml") != std::string::npos || type.find("svg") != std::string::npos;
+}
+
+bool acceptsGzip(const HttpServerRequest& request) {
+    auto it = request.headers.find("accept-encoding");
+    return it != request.headers.end() && toLower(it->second).find("gzip") != std::string::npos;
+}
+
+}  // namespace
+
+MiddlewareStage BuiltinMiddleware::create(const std::string& name,
+                                          const MiddlewareOptions& options) {
+    if (name == "cors") return cors(options);
+    if (name == "request-id") return requestId(options);
+    if (name == "timing") return timing(options);
+    if (name == "compression") return compression(options);
+    if (name == "headers") return headers(options);
+    if (name == "cache") return cache(options);
+    throw std::runtime_error(
+        "Unknown built-in middleware '" + name +
+        "'. Expected one of: cors, request-id, timing, compression, headers, cache");
+}
+
+std::vector<std::string> BuiltinMiddleware::getNames() {
+    return {"cors", "request-id", "timing", "compression", "headers", "cache"};
+}
+
+MiddlewareStage BuiltinMiddleware::cache(const MiddlewareOptions& options) {
+    return ResponseCache::stage(
+        std::make_shared<ResponseCache>(ResponseCache::parseOptions(options)));
+}
+
+MiddlewareStage BuiltinMiddleware::cors(const MiddlewareOptions& options) {
+    std::string origin = optionOr(options, "origin", "*");
+    std::string methods = optionOr(options, "methods", "GET, POST, PUT, DELETE, PATCH, OPTIONS");
+    std::string allowed_headers = optionOr(options, "headers", "Content-Type, Authorization");
+    std::string max_age = std::to_string(intOption(options, "max_age", 600));
+    bool credentials = optionOr(options, "credentials", "false") == "true";
+
+    MiddlewareStage stage;
+    stage.before = [origin, methods, allowed_headers, max_age, credentials](
+                       HttpServerRequest& request, HttpServerResponse& response) {
+        response.headers["Access-Control-Allow-Origin"] = origin;
+        if (origin != "*") {
+            response.headers["Vary"] = "Origin";
+        }
+        if (credentials) {
+            response.headers["Access-Control-Allow-Credentials"] = "true";
+        }
+
+        // Preflight requests are answered here and never reach a route
+        if (request.method == "OPTIONS" &&
+            request.headers.count("access-control-request-method")) {
+            response.status_code = 204;
+            response.status_message = httpStatusMessage(204);
+            response.headers["Access-Control-Allow-Methods"] = methods;
+            response.headers["Access-Control-Allow-Headers"] = allowed_headers;
+            response.headers["Access-Control-Max-Age"] = max_age;
+            response.body.clear();
+            return false;
+        }
+        return true;
+    };
+    return stage;
+}
+
+MiddlewareStage BuiltinMiddleware::requestId(const MiddlewareOptions& options) {
+    std::string header = optionOr(options, "header", "X-Request-Id");
+    std::string lookup = toLower(header);
+
+    MiddlewareStage stage;
+    stage.before = [header, lookup](HttpServerRequest& request, HttpServerResponse& response) {
+        auto it = request.headers.find(lookup);
+        if (it == request.headers.end() || it->second.empty()) {
+            it = request.headers.insert_or_assign(lookup, generateRequestId()).first;
+        }
+        response.headers[header] = it->second;
+        return true;
+    };
+    return stage;
+}
+
+MiddlewareStage BuiltinMiddleware::timing(const MiddlewareOptions&) {
+    MiddlewareStage stage;
+    stage.around = [](const HttpServerRequest&, HttpServerResponse& response,
+                      std::function<void()> next) {
+        auto started = std::chrono::steady_clock::now();
+        next();
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - started;
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", elapsed.count());
+        response.headers["X-Response-Time"] = std::string(buffer) + "ms";
+        response.headers["Server-Timing"] = std::string("app;dur=") + buffer;
+    };
+    return stage;
+}
+
+MiddlewareStage BuiltinMiddleware::compression(const MiddlewareOptions& options) {
+    if (!isCompressionAvailable()) {
+        throw std::runtime_error("Compression middleware requires zlib, which this build lacks");
+    }
+
+    int min_size = intOption(options, "min_size", 1024);
+    int level = intOption(options, "level", 6);
+    if (level < 1 || level > 9) {
+        throw std::runtime_error("Compression level must be between 1 and 9");
+    }
+
+    MiddlewareStage stage;
+    stage.after = [min_size, level](const HttpServerRequest& request,
+                                    HttpServerResponse& response) {
+        // Cached static files carry their own precompressed variants
+        if (response.static_body ||
+            response.body.size() < static_cast<size_t>(std::max(min_size, 0)) ||
+            response.headers.count("Content-Encoding") || !acceptsGzip(request)) {
+            return;
+        }
+        auto type = response.headers.find("Content-Type");
+        if (type == response.headers.end() || !isCompressibleType(type->second)) {
+            return;
+        }
+
+        std::string compressed;
+        if (!gzipCompress(response.body, compressed, level) ||
+            compressed.size() >= response.body.size()) {
+            return;
+        }
+
+        response.body = std::move(compressed);
+        response.headers["Content-Encoding"] = "gzip";
+        response.headers["Vary"] = "Accept-Encoding";
+        if (response.headers.count("Content-Length")) {
+            response.headers["Content-Length"] = std::to_string(response.body.size());
+        }
+    };
+    return stage;
+}
+
+MiddlewareStage BuiltinMiddleware::headers(const MiddlewareOptions& options) {
+    if (options.empty()) {
+        throw std::runtime_error("Headers middleware requires at least one header");
+    }
+
+    MiddlewareStage stage;
+    stage.before = [options](HttpServerRequest&, HttpServerResponse& response) {
+        for (const auto& [name, value] : options) {
+            response.headers[name] = value;
+        }
+        return true;
+    };
+    return stage;
+}
+
+bool BuiltinMiddleware::isCompressionAvailable() {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool BuiltinMiddleware::gzipCompress(const std::string& input, std::string& output, int level) {
+#ifdef HAVE_ZLIB
+    z_stream stream{};
+    // windowBits 15 + 16 selects the gzip wrapper
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())) + 18);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+#else
+    (void)input;
+    (void)output;
+    (void)level;
+    return false;
+#endif
+}
+
+}  // namespace o2l
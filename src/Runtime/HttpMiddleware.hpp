@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "HttpServerLibrary.hpp"
+
+namespace o2l {
+
+using MiddlewareOptions = std::map<std::string, std::string>;
+
+/**
+ * Native middleware for http.server.
+ *
+ * These run entirely in C++ as stages of the compiled middleware chain and never enter the
+ * interpreter, so common cross-cutting concerns cost nothing beyond the work they do.
+ */
+class BuiltinMiddleware {
+   public:
+    // Build a stage by name ("cors", "request-id", "timing", "compression", "headers", "cache");
+    // throws std::runtime_error for unknown names or invalid options
+    static MiddlewareStage create(const std::string& name, const MiddlewareOptions& options);
+
+    static std::vector<std::string> getNames();
+
+    // Access-Control-* headers; answers preflight OPTIONS requests with 204
+    // Options: origin, methods, headers, max_age, credentials
+    static MiddlewareStage cors(const MiddlewareOptions& options);
+
+    // Propagates an incoming request id or generates one; visible to handlers as a request
+    // header and echoed on the response. Options: header (default "X-Request-Id")
+    static MiddlewareStage requestId(const MiddlewareOptions& options);
+
+    // Adds X-Response-Time and Server-Timing headers for the rest of the chain
+    static MiddlewareStage timing(const MiddlewareOptions& options);
+
+    // gzip-encodes compressible bodies for clients that accept it
+    // Options: min_size (bytes, default 1024), level (1-9, default 6)
+    static MiddlewareStage compression(const MiddlewareOptions& options);
+
+    // Sets every option as a response header
+    static MiddlewareStage headers(const MiddlewareOptions& options);
+
+    // Serves repeated GETs from memory; see ResponseCache for the options
+    static MiddlewareStage cache(const MiddlewareOptions& options);
+
+    static bool isCompressionAvailable();
+
+    // gzip helper shared with other native response paths; returns false if unavailable
+    static bool gzipCompress(const std::string& input, std::string& output, int level = 6);
+};
+
+}  // namespace o2l
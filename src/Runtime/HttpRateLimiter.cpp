@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpRateLimiter.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+
+namespace o2l {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000;
+
+}  // namespace
+
+RateLimiter::RateLimiter(RateLimit limit, size_t max_keys)
+    : limit_(limit), epoch_(Clock::now()) {
+    if (!limit_.isEnabled()) {
+        throw std::runtime_error("Rate limit needs a positive rate and a burst of at least 1");
+    }
+    interval_ = std::max<int64_t>(1, static_cast<int64_t>(kNanosPerSecond / limit_.rate));
+    tolerance_ = static_cast<int64_t>(interval_ * (limit_.burst - 1));
+    max_keys_per_shard_ = std::max<size_t>(1, max_keys / kShardCount);
+}
+
+RateLimiter::Decision RateLimiter::take(std::atomic<int64_t>& tat, int64_t now) const {
+    int64_t current = tat.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t start = std::max(current, now);
+        int64_t debt = start - now;
+        if (debt > tolerance_) {
+            // Not enough credit: the next token arrives once the debt is back within tolerance
+            Decision decision;
+            decision.allowed = false;
+            int64_t wait = debt - tolerance_;
+            decision.retry_after = static_cast<int>((wait + kNanosPerSecond - 1) / kNanosPerSecond);
+            return decision;
+        }
+        if (tat.compare_exchange_weak(current, start + interval_, std::memory_order_relaxed)) {
+            return Decision();
+        }
+    }
+}
+
+RateLimiter::Decision RateLimiter::acquire(const std::string& key, Clock::time_point now) {
+    int64_t at = std::chrono::duration_cast<std::chrono::nanoseconds>(now - epoch_).count();
+    Shard& shard = shards_[std::hash<std::string>()(key) % kShardCount];
+
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.buckets.find(key);
+        if (it != shard.buckets.end()) {
+            return take(it->second->tat, at);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        if (shard.buckets.size() >= max_keys_per_shard_) {
+            evictIdle(shard, at);
+        }
+        if (shard.buckets.size() >= max_keys_per_shard_) {
+            // Every tracked key is still limited: newcomers share one bucket, so a client
+            // rotating through addresses gets no more than a single key would
+            lock.unlock();
+            return take(shard.overflow.tat, at);
+        }
+        it = shard.buckets.emplace(key, std::make_unique<Bucket>()).first;
+    }
+    return take(it->second->tat, at);
+}
+
+void RateLimiter::evictIdle(Shard& shard, int64_t now) {
+    for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+        if (it->second->tat.load(std::memory_order_relaxed) <= now) {
+            it = shard.buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t RateLimiter::getKeyCount() const {
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        count += shard.buckets.size();
+    }
+    return count;
+}
+
+}  // namespace o2l
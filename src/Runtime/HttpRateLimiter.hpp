@@ -0,0 +1,99 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace o2l {
+
+// Token bucket parameters: `rate` tokens per second, holding at most `burst`
+struct RateLimit {
+    double rate = 0;   // 0 disables the limit
+    double burst = 0;  // at least 1 when enabled
+
+    bool isEnabled() const {
+        return rate > 0 && burst >= 1;
+    }
+};
+
+/**
+ * Token buckets keyed by client address, route or any other string.
+ *
+ * Each bucket is a single atomic word holding its theoretical arrival time (GCRA), so taking a
+ * token is one compare-and-swap with no lock held. Keys are spread over shards whose maps are
+ * only locked exclusively to insert a new key; lookups share the lock. Buckets that have
+ * refilled completely carry no state and are dropped when a shard reaches its share of
+ * `max_keys`. If nothing can be dropped, unknown keys are charged to a bucket shared by all
+ * untracked keys of the shard, so filling the shards does not lift the limit.
+ */
+class RateLimiter {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Decision {
+        bool allowed = true;
+        int retry_after = 0;  // whole seconds until a token is available (rejections only)
+    };
+
+    explicit RateLimiter(RateLimit limit, size_t max_keys = 100000);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    Decision acquire(const std::string& key) {
+        return acquire(key, Clock::now());
+    }
+    Decision acquire(const std::string& key, Clock::time_point now);
+
+    const RateLimit& getLimit() const {
+        return limit_;
+    }
+    size_t getKeyCount() const;
+
+   private:
+    static constexpr size_t kShardCount = 64;
+
+    struct Bucket {
+        std::atomic<int64_t> tat{0};  // ns since epoch_ at which the bucket is full again
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::unique_ptr<Bucket>> buckets;
+        Bucket overflow;  // keys that found the shard full
+    };
+
+    Decision take(std::atomic<int64_t>& tat, int64_t now) const;
+    // Drops refilled buckets; caller holds the shard exclusively
+    void evictIdle(Shard& shard, int64_t now);
+
+    RateLimit limit_;
+    int64_t interval_;   // ns per token
+    int64_t tolerance_;  // ns of credit a full bucket holds beyond the next token
+    size_t max_keys_per_shard_;
+    Clock::time_point epoch_;
+    std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpRequestObject.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "../Common/Exceptions.hpp"
+#include "MapInstance.hpp"
+
+namespace o2l {
+
+namespace {
+
+std::shared_ptr<MapInstance> toMapInstance(const std::map<std::string, std::string>& entries) {
+    auto map = std::make_shared<MapInstance>();
+    for (const auto& [key, value] : entries) {
+        map->put(Text(key), Value(Text(value)));
+    }
+    return map;
+}
+
+const std::string& requireTextArgument(const std::vector<Value>& args, const char* error) {
+    if (args.empty() || !std::holds_alternative<Text>(args[0])) {
+        throw std::runtime_error(error);
+    }
+    return std::get<Text>(args[0]);
+}
+
+Value lookupOrEmpty(const std::map<std::string, std::string>& entries, const std::string& key) {
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        return Value(Text(it->second));
+    }
+    return Value(Text(""));
+}
+
+}  // namespace
+
+HttpRequestObject::HttpRequestObject(const HttpServerRequest& request)
+    : ObjectInstance("HttpRequest"), request_(&request) {}
+
+void HttpRequestObject::detach() {
+    if (owned_) {
+        return;
+    }
+    owned_ = std::make_unique<HttpServerRequest>(*request_);
+    request_ = owned_.get();
+}
+
+// Sorted by name for binary search
+const HttpRequestObject::MethodEntry* HttpRequestObject::findMethod(std::string_view name) {
+    static constexpr std::array<MethodEntry, 10> kMethods = {{
+        {"getBody", &HttpRequestObject::getBody},
+        {"getHeader", &HttpRequestObject::getHeader},
+        {"getHeaders", &HttpRequestObject::getHeaders},
+        {"getMethod", &HttpRequestObject::getMethod},
+        {"getParam", &HttpRequestObject::getParam},
+        {"getPath", &HttpRequestObject::getPath},
+        {"getQuery", &HttpRequestObject::getQuery},
+        {"getQueryParam", &HttpRequestObject::getQueryParam},
+        {"getRemoteAddress", &HttpRequestObject::getRemoteAddress},
+        {"getRemotePort", &HttpRequestObject::getRemotePort},
+    }};
+
+    auto it = std::lower_bound(kMethods.begin(), kMethods.end(), name,
+                               [](const MethodEntry& entry, std::string_view key) {
+                                   return entry.name < key;
+                               });
+    if (it != kMethods.end() && it->name == name) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+Value HttpRequestObject::callMethod(const std::string& method_name, const std::vector<Value>& args,
+                                    Context& context, bool external_call) {
+    if (const MethodEntry* entry = findMethod(method_name)) {
+        return entry->method(*this, args);
+    }
+    return ObjectInstance::callMethod(method_name, args, context, external_call);
+}
+
+bool HttpRequestObject::hasMethod(const std::string& method_name) const {
+    return findMethod(method_name) != nullptr || ObjectInstance::hasMethod(method_name);
+}
+
+bool HttpRequestObject::isMethodExternal(const std::string& method_name) const {
+    return findMethod(method_name) != nullptr || ObjectInstance::isMethodExternal(method_name);
+}
+
+std::vector<std::string> HttpRequestObject::getMethodNames() const {
+    std::vector<std::string> names = {"getBody",          "getHeader",    "getHeaders",
+                                      "getMethod",        "getParam",     "getPath",
+                                      "getQuery",         "getQueryParam", "getRemoteAddress",
+                                      "getRemotePort"};
+    for (auto& name : ObjectInstance::getMethodNames()) {
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+Value HttpRequestObject::getProperty(const std::string& property_name) const {
+    const HttpServerRequest& req = *request_;
+    if (property_name == "method") return Value(Text(req.method));
+    if (property_name == "path") return Value(Text(req.path));
+    if (property_name == "query_string") return Value(Text(req.query_string));
+    if (property_name == "body") return Value(Text(req.body));
+    if (property_name == "remote_address") return Value(Text(req.remote_address));
+    if (property_name == "remote_port") return Value(Int(req.remote_port));
+    if (property_name == "headers") return Value(headersMap());
+    if (property_name == "query_params") return Value(queryParamsMap());
+    if (property_name == "path_params") return Value(pathParamsMap());
+    return ObjectInstance::getProperty(property_name);
+}
+
+bool HttpRequestObject::hasProperty(const std::string& property_name) const {
+    static const std::array<std::string_view, 9> kProperties = {
+        "method",         "path",        "query_string", "body",       "remote_address",
+        "remote_port",    "headers",     "query_params", "path_params"};
+    return std::find(kProperties.begin(), kProperties.end(), property_name) != kProperties.end() ||
+           ObjectInstance::hasProperty(property_name);
+}
+
+std::shared_ptr<MapInstance> HttpRequestObject::headersMap() const {
+    if (!headers_) {
+        headers_ = toMapInstance(request_->headers);
+    }
+    return headers_;
+}
+
+std::shared_ptr<MapInstance> HttpRequestObject::queryParamsMap() const {
+    if (!query_params_) {
+        query_params_ = toMapInstance(request_->query_params);
+    }
+    return query_params_;
+}
+
+std::shared_ptr<MapInstance> HttpRequestObject::pathParamsMap() const {
+    if (!path_params_) {
+        path_params_ = toMapInstance(request_->path_params);
+    }
+    return path_params_;
+}
+
+Value HttpRequestObject::getMethod(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(Text(self.request_->method));
+}
+
+Value HttpRequestObject::getPath(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(Text(self.request_->path));
+}
+
+Value HttpRequestObject::getQuery(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(Text(self.request_->query_string));
+}
+
+Value HttpRequestObject::getBody(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(Text(self.request_->body));
+}
+
+Value HttpRequestObject::getHeader(const HttpRequestObject& self,
+                                   const std::vector<Value>& args) {
+    const auto& name = requireTextArgument(args, "getHeader() requires a header name");
+    return lookupOrEmpty(self.request_->headers, name);
+}
+
+Value HttpRequestObject::getHeaders(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(self.headersMap());
+}
+
+Value HttpRequestObject::getParam(const HttpRequestObject& self, const std::vector<Value>& args) {
+    const auto& name = requireTextArgument(args, "getParam() requires a parameter name");
+    return lookupOrEmpty(self.request_->path_params, name);
+}
+
+Value HttpRequestObject::getQueryParam(const HttpRequestObject& self,
+                                       const std::vector<Value>& args) {
+    const auto& name = requireTextArgument(args, "getQueryParam() requires a parameter name");
+    return lookupOrEmpty(self.request_->query_params, name);
+}
+
+Value HttpRequestObject::getRemoteAddress(const HttpRequestObject& self,
+                                          const std::vector<Value>&) {
+    return Value(Text(self.request_->remote_address));
+}
+
+Value HttpRequestObject::getRemotePort(const HttpRequestObject& self, const std::vector<Value>&) {
+    return Value(Int(self.request_->remote_port));
+}
+
+}  // namespace o2l
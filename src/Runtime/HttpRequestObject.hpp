@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HttpServerLibrary.hpp"
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+class MapInstance;
+
+/**
+ * O²L view of an incoming HTTP request.
+ *
+ * The object borrows the server's HttpServerRequest instead of copying it and answers
+ * method calls through a static dispatch table, so creating one per request costs a single
+ * allocation. The headers/query_params/path_params maps are only built when a script asks
+ * for them. If a script keeps the object after its handler returns, detach() moves it onto
+ * a private copy of the request.
+ */
+class HttpRequestObject : public ObjectInstance {
+   public:
+    explicit HttpRequestObject(const HttpServerRequest& request);
+
+    // Copy the borrowed request into owned storage (called when the handler finishes)
+    void detach();
+    bool isDetached() const {
+        return owned_ != nullptr;
+    }
+
+    const HttpServerRequest& request() const {
+        return *request_;
+    }
+
+    Value callMethod(const std::string& method_name, const std::vector<Value>& args,
+                     Context& context, bool external_call = false) override;
+    bool hasMethod(const std::string& method_name) const override;
+    bool isMethodExternal(const std::string& method_name) const override;
+    std::vector<std::string> getMethodNames() const override;
+
+    Value getProperty(const std::string& property_name) const override;
+    bool hasProperty(const std::string& property_name) const override;
+
+   private:
+    using NativeMethod = Value (*)(const HttpRequestObject&, const std::vector<Value>&);
+
+    struct MethodEntry {
+        std::string_view name;
+        NativeMethod method;
+    };
+
+    static const MethodEntry* findMethod(std::string_view name);
+
+    std::shared_ptr<MapInstance> headersMap() const;
+    std::shared_ptr<MapInstance> queryParamsMap() const;
+    std::shared_ptr<MapInstance> pathParamsMap() const;
+
+    static Value getMethod(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getPath(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getQuery(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getBody(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getHeader(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getHeaders(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getParam(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getQueryParam(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getRemoteAddress(const HttpRequestObject& self, const std::vector<Value>& args);
+    static Value getRemotePort(const HttpRequestObject& self, const std::vector<Value>& args);
+
+    const HttpServerRequest* request_;
+    std::unique_ptr<HttpServerRequest> owned_;
+
+    // Lazily materialized collections
+    mutable std::shared_ptr<MapInstance> headers_;
+    mutable std::shared_ptr<MapInstance> query_params_;
+    mutable std::shared_ptr<MapInstance> path_params_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,422 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpResponseCache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include "CancellationToken.hpp"
+#include "NumberConversion.hpp"
+
+namespace o2l {
+
+namespace {
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Lowercased, trimmed, non-empty items of a comma-separated header or option
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        std::string item = toLower(trim(list.substr(start, comma - start)));
+        if (!item.empty()) {
+            items.push_back(std::move(item));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+// Response headers keep the case the handler gave them
+const std::string* findHeader(const std::map<std::string, std::string>& headers,
+                              const std::string& lower_name) {
+    for (const auto& [name, value] : headers) {
+        if (name.size() == lower_name.size() && toLower(name) == lower_name) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+long long numberOption(const MiddlewareOptions& options, const std::string& key,
+                       long long fallback) {
+    auto it = options.find(key);
+    if (it == options.end()) {
+        return fallback;
+    }
+    if (auto value = numeric::parseInt(numeric::trim(it->second))) {
+        return *value;
+    }
+    throw std::runtime_error("Middleware option '" + key + "' must be an integer, got '" +
+                             it->second + "'");
+}
+
+bool isCacheableStatus(int status_code) {
+    switch (status_code) {
+        case 200:
+        case 203:
+        case 204:
+        case 300:
+        case 301:
+        case 308:
+        case 404:
+        case 410:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Rebuilt per response or meaningless once stored
+bool isUnstoredHeader(const std::string& lower_name) {
+    return lower_name == "connection" || lower_name == "keep-alive" ||
+           lower_name == "transfer-encoding" || lower_name == "content-length" ||
+           lower_name == "date" || lower_name == "age" || lower_name == "x-cache";
+}
+
+void addField(StaticBody& body, const std::string& name, const std::string& value) {
+    body.header_block.append(name).append(": ").append(value).append("\r\n");
+    body.fields.emplace_back(name, value);
+}
+
+}  // namespace
+
+ResponseCache::Options ResponseCache::parseOptions(const MiddlewareOptions& options) {
+    for (const auto& [key, value] : options) {
+        if (key != "ttl" && key != "max_bytes" && key != "max_entry_size" && key != "vary" &&
+            key != "wait") {
+            throw std::runtime_error("Unknown cache option '" + key +
+                                     "'. Expected one of: ttl, max_bytes, max_entry_size, vary, "
+                                     "wait");
+        }
+    }
+
+    Options parsed;
+    long long ttl = numberOption(options, "ttl", parsed.ttl.count());
+    long long max_bytes = numberOption(options, "max_bytes", parsed.max_bytes);
+    long long max_entry_size = numberOption(options, "max_entry_size", parsed.max_entry_size);
+    long long wait = numberOption(options, "wait", parsed.wait.count());
+    if (ttl < 0 || wait < 0) {
+        throw std::runtime_error("Cache options 'ttl' and 'wait' must not be negative");
+    }
+    if (max_bytes <= 0 || max_entry_size <= 0) {
+        throw std::runtime_error("Cache options 'max_bytes' and 'max_entry_size' must be positive");
+    }
+
+    parsed.ttl = std::chrono::seconds(ttl);
+    parsed.max_bytes = static_cast<size_t>(max_bytes);
+    parsed.max_entry_size = static_cast<size_t>(max_entry_size);
+    parsed.wait = std::chrono::seconds(wait);
+    auto vary = options.find("vary");
+    if (vary != options.end()) {
+        parsed.vary = splitList(vary->second);
+    }
+    return parsed;
+}
+
+ResponseCache::ResponseCache(Options options) : options_(std::move(options)) {}
+
+MiddlewareStage ResponseCache::stage(std::shared_ptr<ResponseCache> cache) {
+    MiddlewareStage stage;
+    stage.around = [cache](const HttpServerRequest& request, HttpServerResponse& response,
+                           std::function<void()> next) { cache->handle(request, response, next); };
+    return stage;
+}
+
+std::string ResponseCache::key(const HttpServerRequest& request) const {
+    std::string key = request.method + " " + request.path;
+    if (!request.query_string.empty()) {
+        key += "?" + request.query_string;
+    }
+    for (const auto& name : options_.vary) {
+        auto it = request.headers.find(name);
+        key.append("\n").append(name).append(": ");
+        if (it != request.headers.end()) {
+            key += it->second;
+        }
+    }
+    return key;
+}
+
+std::chrono::seconds ResponseCache::freshness(const HttpServerResponse& response) const {
+    const std::string* cache_control = findHeader(response.headers, "cache-control");
+    if (!cache_control) {
+        return options_.ttl;
+    }
+
+    long long max_age = -1;
+    long long shared_max_age = -1;
+    for (const auto& directive : splitList(*cache_control)) {
+        if (directive == "no-store" || directive == "no-cache" || directive == "private") {
+            return std::chrono::seconds(0);
+        }
+        size_t equals = directive.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string name = directive.substr(0, equals);
+        std::string value = trim(directive.substr(equals + 1));
+        if (!value.empty() && value.front() == '"' && value.back() == '"' && value.size() >= 2) {
+            value = value.substr(1, value.size() - 2);
+        }
+        auto seconds = numeric::parseInt(value);
+        if (!seconds) {
+            return std::chrono::seconds(0);  // a directive we cannot read: do not guess
+        }
+        if (name == "s-maxage") {
+            shared_max_age = *seconds;
+        } else if (name == "max-age") {
+            max_age = *seconds;
+        }
+    }
+
+    // s-maxage is addressed to shared caches like this one and wins over max-age
+    long long seconds = shared_max_age >= 0 ? shared_max_age : max_age;
+    return seconds >= 0 ? std::chrono::seconds(seconds) : options_.ttl;
+}
+
+void ResponseCache::handle(const HttpServerRequest& request, HttpServerResponse& response,
+                           const std::function<void()>& next) {
+    // Only anonymous GETs are shared; a client may also opt out or ask for a fresh response
+    if (request.method != "GET" || request.headers.count("authorization")) {
+        next();
+        return;
+    }
+    bool revalidate = false;
+    auto cache_control = request.headers.find("cache-control");
+    if (cache_control != request.headers.end()) {
+        auto directives = splitList(cache_control->second);
+        auto has = [&](const char* directive) {
+            return std::find(directives.begin(), directives.end(), directive) != directives.end();
+        };
+        if (has("no-store")) {
+            next();
+            return;
+        }
+        revalidate = has("no-cache") || has("max-age=0");
+    }
+
+    std::string cache_key = key(request);
+    if (!revalidate && lookup(cache_key, response)) {
+        return;
+    }
+
+    std::shared_ptr<Flight> flight;
+    bool leader = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [it, inserted] = flights_.try_emplace(cache_key);
+        if (inserted) {
+            it->second = std::make_shared<Flight>();
+        }
+        flight = it->second;
+        leader = inserted;
+    }
+
+    if (!leader) {
+        // Another request is already producing this response
+        ++coalesced_;
+        if (await(flight, request) && lookup(cache_key, response)) {
+            return;
+        }
+        // It was not cacheable, failed or took too long: produce our own
+        ++misses_;
+        next();
+        store(cache_key, response);
+        return;
+    }
+
+    ++misses_;
+    try {
+        next();
+    } catch (...) {
+        finish(cache_key, flight, false);
+        throw;
+    }
+    bool stored = false;
+    try {
+        stored = store(cache_key, response);
+    } catch (const std::exception&) {
+        // Out of memory while copying: serve the response uncached
+    }
+    finish(cache_key, flight, stored);
+    if (!findHeader(response.headers, "x-cache")) {
+        response.headers["X-Cache"] = "MISS";
+    }
+}
+
+bool ResponseCache::await(std::shared_ptr<Flight> flight, const HttpServerRequest& request) {
+    auto limit = Clock::now() + options_.wait;
+    if (request.cancellation && request.cancellation->hasDeadline()) {
+        limit = std::min(limit, request.cancellation->getDeadline());
+    }
+
+    bool stored = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        flight->done_cv.wait_until(lock, limit, [&]() { return flight->done; });
+        stored = flight->done && flight->stored;
+    }
+    // A request whose own deadline passed while waiting is answered like any other overrun
+    if (request.cancellation) {
+        request.cancellation->check();
+    }
+    return stored;
+}
+
+void ResponseCache::finish(const std::string& key, const std::shared_ptr<Flight>& flight,
+                           bool stored) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = flights_.find(key);
+    if (it != flights_.end() && it->second == flight) {
+        flights_.erase(it);
+    }
+    flight->done = true;
+    flight->stored = stored;
+    flight->done_cv.notify_all();
+}
+
+bool ResponseCache::lookup(const std::string& key, HttpServerResponse& response) {
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return false;
+        }
+        if (Clock::now() >= it->second->expires_at) {
+            erase(it->second);
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        const Entry& cached = *it->second;
+        entry.status_code = cached.status_code;
+        entry.status_message = cached.status_message;
+        entry.body = cached.body;
+        entry.stored_at = cached.stored_at;
+    }
+
+    response.status_code = entry.status_code;
+    response.status_message = entry.status_message;
+    response.body.clear();
+    response.static_body = std::move(entry.body);
+    auto age = std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - entry.stored_at);
+    response.headers["Age"] = std::to_string(age.count());
+    response.headers["X-Cache"] = "HIT";
+    ++hits_;
+    return true;
+}
+
+bool ResponseCache::store(const std::string& key, const HttpServerResponse& response) {
+    // Streams, cached files and per-user responses are never shared
+    if (response.stream || response.static_body || !isCacheableStatus(response.status_code) ||
+        response.body.size() > options_.max_entry_size ||
+        findHeader(response.headers, "set-cookie")) {
+        return false;
+    }
+    // Only variations this cache keys on can be told apart
+    if (const std::string* vary = findHeader(response.headers, "vary")) {
+        for (const auto& name : splitList(*vary)) {
+            if (std::find(options_.vary.begin(), options_.vary.end(), name) ==
+                options_.vary.end()) {
+                return false;
+            }
+        }
+    }
+    auto ttl = freshness(response);
+    if (ttl.count() <= 0) {
+        return false;
+    }
+
+    auto body = std::make_shared<StaticBody>();
+    body->data = response.body;
+    for (const auto& [name, value] : response.headers) {
+        if (!isUnstoredHeader(toLower(name))) {
+            addField(*body, name, value);
+        }
+    }
+    if (response.status_code != 204) {
+        addField(*body, "Content-Length", std::to_string(body->data.size()));
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.status_code = response.status_code;
+    entry.status_message = response.status_message;
+    entry.stored_at = Clock::now();
+    entry.expires_at = entry.stored_at + ttl;
+    entry.size = sizeof(Entry) + 2 * key.size() + body->data.size() + 2 * body->header_block.size();
+    entry.body = std::move(body);
+    if (entry.size > options_.max_bytes) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto existing = entries_.find(key);
+    if (existing != entries_.end()) {
+        erase(existing->second);
+    }
+    size_t size = entry.size;
+    lru_.push_front(std::move(entry));
+    entries_.emplace(key, lru_.begin());
+    memory_used_ += size;
+
+    // Least recently used entries go first; the new one always fits
+    while (memory_used_ > options_.max_bytes) {
+        erase(std::prev(lru_.end()));
+    }
+    return true;
+}
+
+void ResponseCache::erase(std::list<Entry>::iterator entry) {
+    memory_used_ -= entry->size;
+    entries_.erase(entry->key);
+    lru_.erase(entry);
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    entries_.clear();
+    memory_used_ = 0;
+}
+
+size_t ResponseCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+}  // namespace o2l
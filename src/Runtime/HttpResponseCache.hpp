@@ -0,0 +1,132 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "HttpMiddleware.hpp"
+#include "HttpServerLibrary.hpp"
+
+namespace o2l {
+
+/**
+ * Shared cache of GET responses, run as a middleware stage.
+ *
+ * Responses are keyed by path, query string and the configured `vary` request headers, and
+ * stored as a StaticBody with their header block already built, so a hit is a hash lookup
+ * followed by the same gathered write as a cached static file; the rest of the chain, and
+ * with it the interpreter, is skipped. Concurrent misses on one key are coalesced: the first
+ * request runs the handler while the others wait for its response. Entries live for the
+ * response's `Cache-Control` max-age (or the configured TTL) and the least recently used are
+ * evicted to stay within `max_bytes`.
+ */
+class ResponseCache {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        std::chrono::seconds ttl{5};       // for responses without Cache-Control max-age
+        size_t max_bytes = 64 * 1024 * 1024;
+        size_t max_entry_size = 1024 * 1024;  // larger bodies are never stored
+        std::vector<std::string> vary;        // lowercase request headers added to the key
+        std::chrono::seconds wait{10};        // longest a coalesced request waits for another
+    };
+
+    // Options: ttl, max_bytes, max_entry_size, vary (comma-separated), wait
+    static Options parseOptions(const MiddlewareOptions& options);
+
+    explicit ResponseCache(Options options);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // The stage serving hits and storing cacheable responses; it keeps `cache` alive
+    static MiddlewareStage stage(std::shared_ptr<ResponseCache> cache);
+
+    // Fills `response` from a fresh entry for `key`; false on a miss
+    bool lookup(const std::string& key, HttpServerResponse& response);
+    // Stores `response` under `key` if its status and headers allow it
+    bool store(const std::string& key, const HttpServerResponse& response);
+    void clear();
+
+    std::string key(const HttpServerRequest& request) const;
+    // Seconds the response may be stored for, 0 if it must not be
+    std::chrono::seconds freshness(const HttpServerResponse& response) const;
+
+    size_t getEntryCount() const;
+    size_t getMemoryUsage() const {
+        return memory_used_.load(std::memory_order_relaxed);
+    }
+    size_t getHits() const {
+        return hits_.load(std::memory_order_relaxed);
+    }
+    size_t getMisses() const {
+        return misses_.load(std::memory_order_relaxed);
+    }
+    size_t getCoalesced() const {
+        return coalesced_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    struct Entry {
+        std::string key;
+        int status_code = 200;
+        std::string status_message;
+        std::shared_ptr<const StaticBody> body;
+        Clock::time_point stored_at;
+        Clock::time_point expires_at;
+        size_t size = 0;
+    };
+
+    // A miss being filled by one request while others wait on it
+    struct Flight {
+        std::condition_variable done_cv;
+        bool done = false;
+        bool stored = false;
+    };
+
+    void handle(const HttpServerRequest& request, HttpServerResponse& response,
+                const std::function<void()>& next);
+    // Waits for the request filling `key`; true if it left an entry behind
+    bool await(std::shared_ptr<Flight> flight, const HttpServerRequest& request);
+    void finish(const std::string& key, const std::shared_ptr<Flight>& flight, bool stored);
+    // Caller holds mutex_
+    void erase(std::list<Entry>::iterator entry);
+
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+
+    std::atomic<size_t> memory_used_{0};
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> coalesced_{0};
+};
+
+}  // namespace o2l
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpResponseObject.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "HttpConnectionHub.hpp"
+#include "HttpEventStream.hpp"
+#include "MapInstance.hpp"
+
+namespace o2l {
+
+namespace {
+
+const std::string& requireTextArgument(const std::vector<Value>& args, const char* error) {
+    if (args.empty() || !std::holds_alternative<Text>(args[0])) {
+        throw std::runtime_error(error);
+    }
+    return std::get<Text>(args[0]);
+}
+
+// Register the pending hub connection that takes over the socket once the handler returns
+std::shared_ptr<HubConnection> openStream(HttpServerResponse& response, HubConnection::Mode mode,
+                                          const char* method) {
+    if (response.stream) {
+        throw std::runtime_error(std::string(method) +
+                                 ": the response is already streaming");
+    }
+    auto stream = response.hub ? response.hub->createPending(mode) : nullptr;
+    if (!stream) {
+        throw std::runtime_error(std::string(method) +
+                                 " is only available while a running server handles the request");
+    }
+    response.stream = stream;
+    response.body.clear();
+    return stream;
+}
+
+}  // namespace
+
+HttpResponseObject::HttpResponseObject(HttpServerResponse& response)
+    : ObjectInstance("HttpResponse"), response_(&response) {}
+
+void HttpResponseObject::detach() {
+    if (owned_) {
+        return;
+    }
+    owned_ = std::make_unique<HttpServerResponse>(*response_);
+    owned_->hub = nullptr;  // the request is over; nothing can be handed off any more
+    response_ = owned_.get();
+}
+
+// Sorted by name for binary search
+const HttpResponseObject::MethodEntry* HttpResponseObject::findMethod(std::string_view name) {
+    static constexpr std::array<MethodEntry, 13> kMethods = {{
+        {"defer", &HttpResponseObject::defer},
+        {"getBody", &HttpResponseObject::getBody},
+        {"getHeader", &HttpResponseObject::getHeader},
+        {"getStatus", &HttpResponseObject::getStatus},
+        {"html", &HttpResponseObject::html},
+        {"json", &HttpResponseObject::json},
+        {"redirect", &HttpResponseObject::redirect},
+        {"send", &HttpResponseObject::send},
+        {"setBody", &HttpResponseObject::setBody},
+        {"setHeader", &HttpResponseObject::setHeader},
+        {"setStatus", &HttpResponseObject::setStatus},
+        {"sse", &HttpResponseObject::sse},
+        {"text", &HttpResponseObject::text},
+    }};
+
+    auto it = std::lower_bound(kMethods.begin(), kMethods.end(), name,
+                               [](const MethodEntry& entry, std::string_view key) {
+                                   return entry.name < key;
+                               });
+    if (it != kMethods.end() && it->name == name) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+Value HttpResponseObject::callMethod(const std::string& method_name,
+                                     const std::vector<Value>& args, Context& context,
+                                     bool external_call) {
+    if (const MethodEntry* entry = findMethod(method_name)) {
+        return entry->method(*response_, args);
+    }
+    return ObjectInstance::callMethod(method_name, args, context, external_call);
+}
+
+bool HttpResponseObject::hasMethod(const std::string& method_name) const {
+    return findMethod(method_name) != nullptr || ObjectInstance::hasMethod(method_name);
+}
+
+bool HttpResponseObject::isMethodExternal(const std::string& method_name) const {
+    return findMethod(method_name) != nullptr || ObjectInstance::isMethodExternal(method_name);
+}
+
+std::vector<std::string> HttpResponseObject::getMethodNames() const {
+    std::vector<std::string> names = {"defer",     "getBody",   "getHeader", "getStatus", "html",
+                                      "json",      "redirect",  "send",      "setBody",
+                                      "setHeader", "setStatus", "sse",       "text"};
+    for (auto& name : ObjectInstance::getMethodNames()) {
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+Value HttpResponseObject::getProperty(const std::string& property_name) const {
+    const HttpServerResponse& res = *response_;
+    if (property_name == "status_code") return Value(Int(res.status_code));
+    if (property_name == "status_message") return Value(Text(res.status_message));
+    if (property_name == "body") return Value(Text(res.body));
+    if (property_name == "sent") return Value(Bool(res.sent));
+    if (property_name == "chunked") return Value(Bool(res.chunked));
+    if (property_name == "headers") {
+        auto headers_map = std::make_shared<MapInstance>();
+        for (const auto& [key, value] : res.headers) {
+            headers_map->put(Text(key), Value(Text(value)));
+        }
+        return Value(headers_map);
+    }
+    return ObjectInstance::getProperty(property_name);
+}
+
+bool HttpResponseObject::hasProperty(const std::string& property_name) const {
+    static const std::array<std::string_view, 6> kProperties = {
+        "status_code", "status_message", "body", "sent", "chunked", "headers"};
+    return std::find(kProperties.begin(), kProperties.end(), property_name) != kProperties.end() ||
+           ObjectInstance::hasProperty(property_name);
+}
+
+Value HttpResponseObject::setStatus(HttpServerResponse& response, const std::vector<Value>& args) {
+    if (args.empty() || !std::holds_alternative<Int>(args[0])) {
+        throw std::runtime_error("setStatus() requires a status code number");
+    }
+    int status = std::get<Int>(args[0]);
+    if (status < 100 || status >= 600) {
+        throw std::runtime_error("Invalid HTTP status code: " + std::to_string(status));
+    }
+    response.status_code = status;
+    response.status_message = httpStatusMessage(status);
+    return Value(Text("Status set to " + std::to_string(status)));
+}
+
+Value HttpResponseObject::setHeader(HttpServerResponse& response, const std::vector<Value>& args) {
+    if (args.size() < 2 || !std::holds_alternative<Text>(args[0]) ||
+        !std::holds_alternative<Text>(args[1])) {
+        throw std::runtime_error("setHeader() requires header name and value");
+    }
+    const std::string& header_name = std::get<Text>(args[0]);
+    response.headers[header_name] = std::get<Text>(args[1]);
+    return Value(Text("Header '" + header_name + "' set"));
+}
+
+Value HttpResponseObject::setBody(HttpServerResponse& response, const std::vector<Value>& args) {
+    response.body = requireTextArgument(args, "setBody() requires body content");
+    return Value(Text("Body set"));
+}
+
+Value HttpResponseObject::json(HttpServerResponse& response, const std::vector<Value>& args) {
+    response.body = requireTextArgument(args, "json() requires JSON string");
+    response.headers["Content-Type"] = "application/json";
+    return Value(Text("JSON response set"));
+}
+
+Value HttpResponseObject::html(HttpServerResponse& response, const std::vector<Value>& args) {
+    response.body = requireTextArgument(args, "html() requires HTML string");
+    response.headers["Content-Type"] = "text/html";
+    return Value(Text("HTML response set"));
+}
+
+Value HttpResponseObject::text(HttpServerResponse& response, const std::vector<Value>& args) {
+    response.body = requireTextArgument(args, "text() requires text string");
+    response.headers["Content-Type"] = "text/plain";
+    return Value(Text("Text response set"));
+}
+
+Value HttpResponseObject::redirect(HttpServerResponse& response, const std::vector<Value>& args) {
+    const std::string& location = requireTextArgument(args, "redirect() requires URL");
+
+    // Default to 302 Found, but allow custom status code
+    int status_code = 302;
+    if (args.size() > 1 && std::holds_alternative<Int>(args[1])) {
+        status_code = std::get<Int>(args[1]);
+    }
+
+    response.status_code = status_code;
+    response.headers["Location"] = location;
+    response.body.clear();
+    return Value(Text("Redirect to " + location));
+}
+
+Value HttpResponseObject::getStatus(HttpServerResponse& response, const std::vector<Value>&) {
+    return Value(Int(response.status_code));
+}
+
+Value HttpResponseObject::getHeader(HttpServerResponse& response, const std::vector<Value>& args) {
+    const auto& header_name = requireTextArgument(args, "getHeader() requires a header name");
+    auto it = response.headers.find(header_name);
+    if (it != response.headers.end()) {
+        return Value(Text(it->second));
+    }
+    return Value(Text(""));
+}
+
+Value HttpResponseObject::getBody(HttpServerResponse& response, const std::vector<Value>&) {
+    return Value(Text(response.body));
+}
+
+Value HttpResponseObject::send(HttpServerResponse& response, const std::vector<Value>& args) {
+    response.body = requireTextArgument(args, "send() requires response content");
+    response.sent = true;
+    return Value(Text("Response sent"));
+}
+
+Value HttpResponseObject::sse(HttpServerResponse& response, const std::vector<Value>&) {
+    auto stream = openStream(response, HubConnection::Mode::EventStream, "sse()");
+    response.headers["Content-Type"] = "text/event-stream";
+    response.headers["Cache-Control"] = "no-cache";
+    response.headers["X-Accel-Buffering"] = "no";  // keep reverse proxies from buffering
+    return Value(createEventStreamObject(stream));
+}
+
+Value HttpResponseObject::defer(HttpServerResponse& response, const std::vector<Value>& args) {
+    Int timeout = 30;
+    if (!args.empty()) {
+        if (!std::holds_alternative<Int>(args[0]) || std::get<Int>(args[0]) <= 0) {
+            throw std::runtime_error("defer() timeout must be a positive number of seconds");
+        }
+        timeout = std::get<Int>(args[0]);
+    }
+    auto stream = openStream(response, HubConnection::Mode::Deferred, "defer()");
+    return Value(createDeferredResponseObject(stream, response, static_cast<int>(timeout)));
+}
+
+}  // namespace o2l
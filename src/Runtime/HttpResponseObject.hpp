@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HttpServerLibrary.hpp"
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+/**
+ * O²L view of the response being built for a request.
+ *
+ * Writes go straight to the server's HttpServerResponse through a static dispatch table.
+ * Properties (status_code, body, headers, ...) read the live response rather than a
+ * snapshot taken when the object was created. detach() moves the object onto a private
+ * copy once the handler has returned, so a retained reference can never touch a response
+ * that has already been sent. sse() and defer() hand the connection to the server's
+ * connection hub instead, returning an object that keeps writing after the handler returns.
+ */
+class HttpResponseObject : public ObjectInstance {
+   public:
+    explicit HttpResponseObject(HttpServerResponse& response);
+
+    void detach();
+    bool isDetached() const {
+        return owned_ != nullptr;
+    }
+
+    HttpServerResponse& response() {
+        return *response_;
+    }
+
+    Value callMethod(const std::string& method_name, const std::vector<Value>& args,
+                     Context& context, bool external_call = false) override;
+    bool hasMethod(const std::string& method_name) const override;
+    bool isMethodExternal(const std::string& method_name) const override;
+    std::vector<std::string> getMethodNames() const override;
+
+    Value getProperty(const std::string& property_name) const override;
+    bool hasProperty(const std::string& property_name) const override;
+
+   private:
+    using NativeMethod = Value (*)(HttpServerResponse&, const std::vector<Value>&);
+
+    struct MethodEntry {
+        std::string_view name;
+        NativeMethod method;
+    };
+
+    static const MethodEntry* findMethod(std::string_view name);
+
+    static Value setStatus(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value setHeader(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value setBody(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value json(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value html(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value text(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value redirect(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value getStatus(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value getHeader(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value getBody(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value send(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value sse(HttpServerResponse& response, const std::vector<Value>& args);
+    static Value defer(HttpServerResponse& response, const std::vector<Value>& args);
+
+    HttpServerResponse* response_;
+    std::unique_ptr<HttpServerResponse> owned_;
+};
+
+}  // namespace o2l
@@ -17,7 +17,9 @@
 #include "HttpServerLibrary.hpp"
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <ctime>
 #include <fstream>
@@ -26,9 +28,16 @@
 #include <regex>
 #include <sstream>
 
+#include "../Common/Exceptions.hpp"
+#include "Http2Session.hpp"
+#include "HttpMiddleware.hpp"
+#include "HttpRequestObject.hpp"
+#include "HttpResponseCache.hpp"
+#include "HttpResponseObject.hpp"
 #include "JsonLibrary.hpp"
 #include "ListInstance.hpp"
 #include "MapInstance.hpp"
+#include "OutputBuffer.hpp"
 
 // Platform-specific includes
 #ifdef _WIN32
@@ -41,6 +50,7 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #ifdef __linux__
 #include <sys/epoll.h>
@@ -55,6 +65,157 @@ namespace o2l {
 std::map<std::string, std::shared_ptr<HttpServer>> HttpServerLibrary::server_registry;
 std::mutex HttpServerLibrary::registry_mutex;
 
+const char* httpStatusMessage(int status_code) {
+    switch (status_code) {
+        case 101:
+            return "Switching Protocols";
+        case 200:
+            return "OK";
+        case 201:
+            return "Created";
+        case 204:
+            return "No Content";
+        case 301:
+            return "Moved Permanently";
+        case 302:
+            return "Found";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 401:
+            return "Unauthorized";
+        case 403:
+            return "Forbidden";
+        case 404:
+            return "Not Found";
+        case 405:
+            return "Method Not Allowed";
+        case 426:
+            return "Upgrade Required";
+        case 429:
+            return "Too Many Requests";
+        case 500:
+            return "Internal Server Error";
+        case 502:
+            return "Bad Gateway";
+        case 503:
+            return "Service Unavailable";
+        case 504:
+            return "Gateway Timeout";
+        default:
+            return "Unknown";
+    }
+}
+
+std::string httpDate(std::time_t timestamp) {
+    std::tm gmt{};
+#ifdef _WIN32
+    gmtime_s(&gmt, &timestamp);
+#else
+    gmtime_r(&timestamp, &gmt);
+#endif
+    std::ostringstream ss;
+    ss << std::put_time(&gmt, "%a, %d %b %Y %H:%M:%S GMT");
+    return ss.str();
+}
+
+std::string serializeHttpHead(const HttpServerResponse& response, bool keep_alive) {
+    std::ostringstream response_stream;
+
+    // Status line
+    response_stream << "HTTP/1.1 " << response.status_code << " " << response.status_message
+                    << "\r\n";
+
+    // Headers
+    for (const auto& header : response.headers) {
+        response_stream << header.first << ": " << header.second << "\r\n";
+    }
+
+    // Cached files bring their own block; headers set by middleware take precedence
+    if (response.static_body) {
+        const StaticBody& cached = *response.static_body;
+        bool overlaps = std::any_of(cached.fields.begin(), cached.fields.end(),
+                                    [&](const auto& field) {
+                                        return response.headers.count(field.first) != 0;
+                                    });
+        if (!overlaps) {
+            response_stream << cached.header_block;
+        } else {
+            for (const auto& field : cached.fields) {
+                if (!response.headers.count(field.first)) {
+                    response_stream << field.first << ": " << field.second << "\r\n";
+                }
+            }
+        }
+    }
+
+    // Default headers (1xx responses carry no body; streamed bodies end with the connection)
+    if (response.status_code >= 200 && !response.stream && !response.static_body &&
+        response.headers.find("Content-Length") == response.headers.end()) {
+        response_stream << "Content-Length: " << response.body.size() << "\r\n";
+    }
+
+    if (response.headers.find("Connection") == response.headers.end()) {
+        response_stream << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+    }
+
+    if (response.headers.find("Server") == response.headers.end()) {
+        response_stream << "Server: O2L-HTTP-Server/1.0\r\n";
+    }
+
+    if (response.headers.find("Date") == response.headers.end()) {
+        response_stream << "Date: " << httpDate(std::time(nullptr)) << "\r\n";
+    }
+
+    // End headers
+    response_stream << "\r\n";
+    return response_stream.str();
+}
+
+std::string serializeHttpResponse(const HttpServerResponse& response, bool keep_alive) {
+    std::string data = serializeHttpHead(response, keep_alive);
+    data += response.static_body ? response.static_body->data : response.body;
+    return data;
+}
+
+namespace {
+
+// Keeps the request/response objects handed to a script handler valid after it returns.
+// The objects borrow structures that live on the connection's stack, so any reference the
+// script kept (a stored field, a captured list) is moved onto a private copy here.
+class HandlerObjectsScope {
+   public:
+    HandlerObjectsScope(std::shared_ptr<HttpRequestObject> request,
+                        std::shared_ptr<HttpResponseObject> response)
+        : request_(std::move(request)), response_(std::move(response)) {}
+
+    ~HandlerObjectsScope() {
+        if (request_.use_count() > 1) {
+            request_->detach();
+        }
+        if (response_.use_count() > 1) {
+            response_->detach();
+        }
+    }
+
+    HandlerObjectsScope(const HandlerObjectsScope&) = delete;
+    HandlerObjectsScope& operator=(const HandlerObjectsScope&) = delete;
+
+    const std::shared_ptr<HttpRequestObject>& request() const {
+        return request_;
+    }
+    const std::shared_ptr<HttpResponseObject>& response() const {
+        return response_;
+    }
+
+   private:
+    std::shared_ptr<HttpRequestObject> request_;
+    std::shared_ptr<HttpResponseObject> response_;
+};
+
+}  // namespace
+
 //=============================================================================
 // ThreadPool Implementation
 //=============================================================================
@@ -78,6 +239,8 @@ ThreadPool::ThreadPool(size_t threads) : stop(false), active_threads(0) {
                 ++active_threads;
                 task();
                 --active_threads;
+                // Lines the task printed go out when it ends, not when the buffer fills
+                OutputBuffer::flushThread();
             }
         });
     }
@@ -131,13 +294,19 @@ void ThreadPool::shutdown() {
 // Router Implementation
 //=============================================================================
 
-void Router::addRoute(const std::string& method, const std::string& pattern, RouteHandler handler) {
+void Router::addRoute(const std::string& method, const std::string& pattern, RouteHandler handler,
+                      RouteOptions options) {
     std::lock_guard<std::mutex> lock(routes_mutex);
 
     Route route;
     route.method = method;
     route.pattern = pattern;
     route.handler = handler;
+    route.options = options;
+    if (options.rate_limit.isEnabled()) {
+        // Shared by every copy of the route handed out by matchRoute()
+        route.rate_limiter = std::make_shared<RateLimiter>(options.rate_limit);
+    }
 
     // Extract parameter names from pattern (e.g., /users/:id -> "id")
     std::regex param_regex(R"(:([a-zA-Z_][a-zA-Z0-9_]*))");
@@ -202,29 +371,74 @@ bool Router::matchPattern(const std::string& pattern, const std::string& path,
 // MiddlewareChain Implementation
 //=============================================================================
 
+// Per-request walk state; next() only captures a pointer to it
+struct MiddlewareChain::Cursor {
+    const CompiledStages* stages;
+    size_t index;
+    HttpServerRequest* request;
+    HttpServerResponse* response;
+    const RouteHandler* final_handler;
+    std::function<void()> next;
+};
+
 void MiddlewareChain::use(MiddlewareFunction middleware) {
-    middlewares.push_back(middleware);
+    MiddlewareStage stage;
+    stage.around = std::move(middleware);
+    useStage(std::move(stage));
+}
+
+void MiddlewareChain::useStage(MiddlewareStage stage) {
+    std::lock_guard<std::mutex> lock(stages_mutex);
+    stages.push_back(std::move(stage));
+    compiled.store(nullptr);  // recompiled on the next request
+}
+
+void MiddlewareChain::compile() {
+    std::lock_guard<std::mutex> lock(stages_mutex);
+    compiled.store(std::make_shared<const CompiledStages>(stages));
 }
 
-void MiddlewareChain::execute(const HttpServerRequest& request, HttpServerResponse& response,
-                              RouteHandler final_handler) {
-    executeNext(0, request, response, final_handler);
+size_t MiddlewareChain::size() const {
+    std::lock_guard<std::mutex> lock(stages_mutex);
+    return stages.size();
+}
+
+void MiddlewareChain::execute(HttpServerRequest& request, HttpServerResponse& response,
+                              const RouteHandler& final_handler) {
+    std::shared_ptr<const CompiledStages> snapshot = compiled.load();
+    if (!snapshot) {
+        compile();
+        snapshot = compiled.load();
+    }
+
+    Cursor cursor{snapshot.get(), 0, &request, &response, &final_handler, nullptr};
+    cursor.next = [&cursor]() { run(cursor); };
+    run(cursor);
 }
 
-void MiddlewareChain::executeNext(size_t index, const HttpServerRequest& request,
-                                  HttpServerResponse& response, RouteHandler final_handler) {
-    if (index >= middlewares.size()) {
-        // All middleware executed, call final handler
-        if (final_handler) {
-            final_handler(request, response);
+void MiddlewareChain::run(Cursor& cursor) {
+    const CompiledStages& stages = *cursor.stages;
+    while (cursor.index < stages.size()) {
+        const MiddlewareStage& stage = stages[cursor.index++];
+        if (stage.before) {
+            if (!stage.before(*cursor.request, *cursor.response)) {
+                return;
+            }
+        } else if (stage.after) {
+            run(cursor);
+            stage.after(*cursor.request, *cursor.response);
+            return;
+        } else {
+            // The middleware decides whether the rest of the chain runs by calling next()
+            stage.around(*cursor.request, *cursor.response, cursor.next);
+            return;
         }
-        return;
     }
 
-    // Call current middleware with next() function
-    middlewares[index](request, response, [this, index, &request, &response, final_handler]() {
-        executeNext(index + 1, request, response, final_handler);
-    });
+    // All middleware executed, call final handler
+    if (*cursor.final_handler) {
+        (*cursor.final_handler)(*cursor.request, *cursor.response);
+    }
 }
 
 //=============================================================================
@@ -232,7 +446,15 @@ void MiddlewareChain::executeNext(size_t index, const HttpServerRequest& request
 //=============================================================================
 
 HttpServer::HttpServer()
-    : running(false), active_connections(0), total_requests(0), error_count(0), server_socket(-1) {
+    : running(false),
+      active_connections(0),
+      total_requests(0),
+      error_count(0),
+      timeout_count(0),
+      rate_limited_count(0),
+      rejected_connections(0),
+      server_socket(-1),
+      connection_hub(std::make_shared<ConnectionHub>()) {
 #ifdef _WIN32
     initializeWinsock();
 #endif
@@ -333,9 +555,25 @@ bool HttpServer::listen() {
     }
 #endif
 
+    // Freeze the middleware registered so far into a flat chain
+    middleware_chain.compile();
+
     // Initialize thread pool
     thread_pool = std::make_unique<ThreadPool>(config.worker_threads);
 
+    // One loop thread serves every WebSocket, event stream and deferred response
+    if (!startConnectionHub()) {
+        std::lock_guard<std::mutex> lock(websocket_mutex);
+        if (!websocket_handlers.empty()) {
+            logError("Failed to start WebSocket event loop");
+        }
+    }
+
+    // Preload and watch cached static directories before the first request
+    for (const auto& cache : getStaticCaches()) {
+        cache->start();
+    }
+
     // Start accepting connections
     running = true;
     accept_thread = std::thread(&HttpServer::acceptConnections, this);
@@ -359,6 +597,8 @@ void HttpServer::stop() {
     }
 #else
     if (server_socket >= 0) {
+        // close() alone does not wake a thread blocked in accept() on Linux
+        shutdown(server_socket, SHUT_RDWR);
         close(server_socket);
         server_socket = -1;
     }
@@ -369,12 +609,21 @@ void HttpServer::stop() {
         accept_thread.join();
     }
 
+    // Close hub connections while the pool can still run their onClose handlers
+    connection_hub->stop();
+    for (const auto& cache : getStaticCaches()) {
+        cache->stop();
+    }
+
     // Shutdown thread pool
     if (thread_pool) {
         thread_pool->shutdown();
         thread_pool.reset();
     }
 
+    // Write out whatever the workers logged before shutting down
+    access_log.stop();
+
     std::cout << "HTTP Server stopped" << std::endl;
 }
 
@@ -386,21 +635,51 @@ void HttpServer::waitForStop() {
 }
 
 void HttpServer::setCustomLogger(std::shared_ptr<ObjectInstance> logger_obj, Context* context) {
-    std::lock_guard<std::mutex> lock(logger_mutex);
-    custom_logger = logger_obj;
-    logger_context = context;
+    {
+        std::lock_guard<std::mutex> lock(logger_mutex);
+        custom_logger = logger_obj;
+        logger_context = context;
+    }
+    access_log.setCallbackSink(
+        [this](const std::vector<AccessLogRecord>& batch) { deliverToCustomLogger(batch); });
 }
 
 void HttpServer::clearCustomLogger() {
+    access_log.setStdoutSink();
     std::lock_guard<std::mutex> lock(logger_mutex);
     custom_logger = nullptr;
     logger_context = nullptr;
 }
 
-void HttpServer::static_(const std::string& url_path, const std::string& file_path) {
+void HttpServer::useResponseCache(std::shared_ptr<ResponseCache> cache) {
+    {
+        std::lock_guard<std::mutex> lock(static_mutex);
+        response_caches.push_back(cache);
+    }
+    useStage(ResponseCache::stage(std::move(cache)));
+}
+
+std::vector<std::shared_ptr<ResponseCache>> HttpServer::getResponseCaches() {
+    std::lock_guard<std::mutex> lock(static_mutex);
+    return response_caches;
+}
+
+void HttpServer::static_(const std::string& url_path, const std::string& file_path,
+                         std::optional<StaticFileCache::Options> cache_options) {
+    std::shared_ptr<StaticFileCache> cache;
+    if (cache_options) {
+        cache = std::make_shared<StaticFileCache>(file_path, *cache_options);
+        std::lock_guard<std::mutex> lock(static_mutex);
+        static_caches.push_back(cache);
+    }
+    if (cache && running) {
+        cache->start();
+    }
+
     // Add a route that serves static files
-    router.get(url_path + "/*", [this, file_path, url_path](const HttpServerRequest& request,
-                                                            HttpServerResponse& response) {
+    router.get(url_path + "/*", [this, file_path, url_path, cache](
+                                    const HttpServerRequest& request,
+                                    HttpServerResponse& response) {
         std::string requested_path = request.path;
 
         // Remove the URL prefix to get the relative file path
@@ -409,11 +688,17 @@ void HttpServer::static_(const std::string& url_path, const std::string& file_pa
             relative_path = requested_path.substr(url_path.length());
         }
 
-        // Construct full file path
+        // Cached files are answered from memory; missing or oversized ones fall through
+        if (cache && cache->serve(relative_path, request, response)) {
+            return;
+        }
+
+        // Construct full file path, never leaving the directory
         std::string full_path = file_path + relative_path;
 
         // Serve the static file
-        if (!serveStaticFile(full_path, response)) {
+        if (!StaticFileCache::isSafePath(relative_path) ||
+            !serveStaticFile(full_path, response)) {
             response.status_code = 404;
             response.status_message = "Not Found";
             response.body = "File not found";
@@ -421,6 +706,254 @@ void HttpServer::static_(const std::string& url_path, const std::string& file_pa
     });
 }
 
+std::vector<std::shared_ptr<StaticFileCache>> HttpServer::getStaticCaches() {
+    std::lock_guard<std::mutex> lock(static_mutex);
+    return static_caches;
+}
+
+void HttpServer::websocket(const std::string& pattern,
+                           std::shared_ptr<const WebSocketHandlers> handlers) {
+    std::lock_guard<std::mutex> lock(websocket_mutex);
+    if (websocket_handlers.find(pattern) == websocket_handlers.end()) {
+        websocket_router.get(pattern, RouteHandler());
+    }
+    websocket_handlers[pattern] = std::move(handlers);
+}
+
+bool HttpServer::startConnectionHub() {
+    if (!ConnectionHub::isSupported()) {
+        return false;
+    }
+    // Script callbacks run on the worker pool, never on the event loop thread
+    return connection_hub->start([this](std::function<void()> task) {
+        if (!thread_pool) {
+            throw std::runtime_error("Server is not running");
+        }
+        thread_pool->enqueue(std::move(task));
+    });
+}
+
+bool HttpServer::isWebSocketUpgrade(const HttpServerRequest& request) const {
+    if (request.method != "GET") {
+        return false;
+    }
+    auto upgrade = request.headers.find("upgrade");
+    auto connection = request.headers.find("connection");
+    if (upgrade == request.headers.end() || connection == request.headers.end()) {
+        return false;
+    }
+
+    std::string upgrade_value = upgrade->second;
+    std::string connection_value = connection->second;
+    std::transform(upgrade_value.begin(), upgrade_value.end(), upgrade_value.begin(), ::tolower);
+    std::transform(connection_value.begin(), connection_value.end(), connection_value.begin(),
+                   ::tolower);
+    return upgrade_value.find("websocket") != std::string::npos &&
+           connection_value.find("upgrade") != std::string::npos;
+}
+
+bool HttpServer::isHttp2Upgrade(const HttpServerRequest& request) const {
+    if (!config.enable_http2 || !connection_hub->isRunning()) {
+        return false;
+    }
+    auto upgrade = request.headers.find("upgrade");
+    if (upgrade == request.headers.end() ||
+        request.headers.find("http2-settings") == request.headers.end()) {
+        return false;
+    }
+
+    // "h2c" as one token of a comma-separated list
+    std::string value = upgrade->second;
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    std::istringstream tokens(value);
+    std::string token;
+    while (std::getline(tokens, token, ',')) {
+        token.erase(0, token.find_first_not_of(" \t"));
+        token.erase(token.find_last_not_of(" \t") + 1);
+        if (token == "h2c") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpServer::startHttp2(int client_socket, HttpServerRequest* upgrade,
+                            std::string_view received) {
+    if (!config.enable_http2 || !connection_hub->isRunning()) {
+        return false;
+    }
+    auto conn = connection_hub->createPending(HubConnection::Mode::Http2);
+    if (!conn) {
+        return false;
+    }
+    std::weak_ptr<HubConnection> weak_conn = conn;
+    auto session_slot = std::make_shared<std::weak_ptr<Http2Session>>();
+
+    // Streams are attributed to the peer for logging and per-client rate limits
+    std::string remote_address;
+    int remote_port = 0;
+    struct sockaddr_in peer {};
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(client_socket, (struct sockaddr*)&peer, &peer_len) == 0 &&
+        peer.sin_family == AF_INET) {
+        char address[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &peer.sin_addr, address, sizeof(address));
+        remote_address = address;
+        remote_port = ntohs(peer.sin_port);
+    }
+
+    Http2Session::Callbacks callbacks;
+    callbacks.write = [weak_conn](std::string_view bytes) {
+        auto target = weak_conn.lock();
+        return target && target->write(bytes);
+    };
+    callbacks.buffered = [weak_conn]() -> size_t {
+        auto target = weak_conn.lock();
+        return target ? target->bufferedOutput() : 0;
+    };
+    callbacks.close = [weak_conn]() {
+        if (auto target = weak_conn.lock()) {
+            target->close();
+        }
+    };
+    // Each stream runs through the same router and middleware as HTTP/1.1, on the worker pool
+    callbacks.dispatch = [this, session_slot, remote_address, remote_port](
+                             uint32_t stream_id, HttpServerRequest&& request) {
+        auto session = session_slot->lock();
+        if (!session || !thread_pool) {
+            return;
+        }
+        request.remote_address = remote_address;
+        request.remote_port = remote_port;
+        request.query_params = parseQueryString(request.query_string);
+        auto task = [this, session, stream_id, request = std::move(request)]() mutable {
+            // No hub: sse() and defer() need a connection of their own
+            HttpServerResponse response;
+            auto started = std::chrono::steady_clock::now();
+            try {
+                handleRequest(request, response);
+            } catch (const std::exception& e) {
+                logError("Error handling HTTP/2 stream: " + std::string(e.what()));
+                response = HttpServerResponse();
+                response.status_code = 500;
+                response.status_message = httpStatusMessage(500);
+                response.body = "500 - Internal Server Error";
+                ++error_count;
+            }
+            session->respond(stream_id, response);
+
+            std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - started;
+            logRequest(request, response, elapsed.count());
+            ++total_requests;
+        };
+        try {
+            thread_pool->enqueue(std::move(task));
+        } catch (const std::exception&) {
+            // Shutting down; the connection is about to be closed anyway
+        }
+    };
+
+    Http2Session::Limits limits;
+    limits.max_request_size = config.max_request_size;
+    auto session = std::make_shared<Http2Session>(std::move(callbacks), limits);
+    *session_slot = session;
+    conn->on_receive = [session](const char* data, size_t size) {
+        return session->receive(data, size);
+    };
+    conn->on_drain = [session]() { session->resume(); };
+
+    // Frames written before attach() are queued behind the head
+    std::string head;
+    if (upgrade) {
+        auto settings = upgrade->headers.find("http2-settings");
+        if (!session->startUpgrade(settings->second, *upgrade)) {
+            connection_hub->discard(conn);
+            return false;
+        }
+        HttpServerResponse switching;
+        switching.status_code = 101;
+        switching.status_message = httpStatusMessage(101);
+        switching.headers["Connection"] = "Upgrade";
+        switching.headers["Upgrade"] = "h2c";
+        head = serializeHttpResponse(switching, true);
+    } else {
+        session->start();
+        if (!session->receive(received.data(), received.size())) {
+            conn->close();
+        }
+    }
+
+    if (!connection_hub->attach(conn, client_socket, head)) {
+        connection_hub->discard(conn);
+        return false;
+    }
+    return true;
+}
+
+bool HttpServer::acceptWebSocket(int client_socket, HttpServerRequest& request,
+                                 const std::string& pattern) {
+    HttpServerResponse response;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&]() {
+        sendHttpResponse(client_socket, response);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - started;
+        logRequest(request, response, elapsed.count());
+        ++total_requests;
+    };
+
+    auto key = request.headers.find("sec-websocket-key");
+    auto version = request.headers.find("sec-websocket-version");
+    if (key == request.headers.end() || version == request.headers.end() ||
+        version->second != "13") {
+        response.status_code = 426;
+        response.status_message = httpStatusMessage(426);
+        response.headers["Sec-WebSocket-Version"] = "13";
+        response.body = "426 - WebSocket version 13 required";
+        finish();
+        return false;
+    }
+
+    std::shared_ptr<const WebSocketHandlers> handlers;
+    {
+        std::lock_guard<std::mutex> lock(websocket_mutex);
+        auto it = websocket_handlers.find(pattern);
+        if (it != websocket_handlers.end()) {
+            handlers = it->second;
+        }
+    }
+    if (!handlers || !connection_hub->isRunning()) {
+        response.status_code = 503;
+        response.status_message = httpStatusMessage(503);
+        response.body = "503 - WebSockets unavailable";
+        finish();
+        return false;
+    }
+
+    // Middleware sees the upgrade like any other request and may reject it (e.g. auth)
+    bool accepted = false;
+    middleware_chain.execute(request, response,
+                             [&accepted](const HttpServerRequest&, HttpServerResponse&) {
+                                 accepted = true;
+                             });
+    if (!accepted) {
+        finish();
+        return false;
+    }
+
+    response.status_code = 101;
+    response.status_message = httpStatusMessage(101);
+    response.headers["Upgrade"] = "websocket";
+    response.headers["Connection"] = "Upgrade";
+    response.headers["Sec-WebSocket-Accept"] = websocket::computeAcceptKey(key->second);
+    response.body.clear();
+    finish();
+
+    return connection_hub->adopt(client_socket, request.path, request.path_params, handlers) !=
+           nullptr;
+}
+
 void HttpServer::acceptConnections() {
     while (running) {
         struct sockaddr_in client_addr;
@@ -444,18 +977,58 @@ void HttpServer::acceptConnections() {
         }
 #endif
 
+        // Admission control: connections queued or in flight plus those held by the hub
+        size_t open_connections = active_connections + connection_hub->getConnectionCount();
+        if (config.max_connections > 0 &&
+            open_connections >= static_cast<size_t>(config.max_connections)) {
+            rejectConnection(client_socket);
+            continue;
+        }
+
+        char address[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &client_addr.sin_addr, address, sizeof(address));
+        std::string remote_address = address;
+        int remote_port = ntohs(client_addr.sin_port);
+
         // Handle connection in thread pool
         ++active_connections;
-        thread_pool->enqueue([this, client_socket]() {
-            this->handleConnection(client_socket);
+        auto accepted_at = std::chrono::steady_clock::now();
+        thread_pool->enqueue([this, client_socket, remote_address, remote_port, accepted_at]() {
+            this->handleConnection(client_socket, remote_address, remote_port, accepted_at);
             --active_connections;
         });
     }
 }
 
-void HttpServer::handleConnection(int client_socket) {
+void HttpServer::rejectConnection(int client_socket) {
+    static const char kResponse[] =
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 25\r\n"
+        "Retry-After: 1\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "503 - Service Unavailable";
+    // Counted first, so it is visible by the time the client sees the close
+    ++rejected_connections;
+    // Best effort on the accept thread: never wait on a client the server has no room for
+#ifdef _WIN32
+    send(client_socket, kResponse, sizeof(kResponse) - 1, 0);
+    closesocket(client_socket);
+#else
+    send(client_socket, kResponse, sizeof(kResponse) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(client_socket);
+#endif
+}
+
+void HttpServer::handleConnection(int client_socket, const std::string& remote_address,
+                                  int remote_port,
+                                  std::chrono::steady_clock::time_point accepted_at) {
     try {
         HttpServerRequest request;
+        request.received_at = accepted_at;
+        request.remote_address = remote_address;
+        request.remote_port = remote_port;
 
         // Parse HTTP request
         if (!parseHttpRequest(client_socket, request)) {
@@ -468,19 +1041,68 @@ void HttpServer::handleConnection(int client_socket) {
             return;
         }
 
+        // HTTP/2: the connection preface (prior knowledge) or an h2c upgrade
+        if (request.method == "PRI" || isHttp2Upgrade(request)) {
+            bool upgrade = request.method != "PRI";
+            if (startHttp2(client_socket, upgrade ? &request : nullptr, request.body)) {
+                return;
+            }
+            if (!upgrade) {
+#ifdef _WIN32
+                closesocket(client_socket);
+#else
+                close(client_socket);
+#endif
+                return;
+            }
+            // A rejected upgrade is answered over HTTP/1.1
+        }
+
+        // WebSocket upgrade on a registered endpoint
+        if (isWebSocketUpgrade(request)) {
+            Router::Route ws_route;
+            if (websocket_router.matchRoute("GET", request.path, ws_route, request.path_params)) {
+                // On success the socket belongs to the WebSocket hub and stays open
+                if (!acceptWebSocket(client_socket, request, ws_route.pattern)) {
+#ifdef _WIN32
+                    closesocket(client_socket);
+#else
+                    close(client_socket);
+#endif
+                }
+                return;
+            }
+        }
+
         // Create response
         HttpServerResponse response;
+        response.hub = connection_hub->isRunning() ? connection_hub.get() : nullptr;
+        auto started = std::chrono::steady_clock::now();
 
         // Handle the request
         handleRequest(request, response);
 
-        // Send response
-        sendHttpResponse(client_socket, response);
+        // A streamed response keeps the socket open on the hub; an error status wins over it
+        bool handed_off = false;
+        if (response.stream && response.status_code < 400) {
+            handed_off = handOffStream(client_socket, response);
+        } else {
+            if (response.stream) {
+                connection_hub->discard(response.stream);
+                response.stream.reset();
+            }
+            sendHttpResponse(client_socket, response);
+        }
 
         // Log the request
-        logRequest(request, response);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - started;
+        logRequest(request, response, elapsed.count());
 
         ++total_requests;
+        if (handed_off) {
+            return;
+        }
 
     } catch (const std::exception& e) {
         logError("Error handling connection: " + std::string(e.what()));
@@ -512,8 +1134,7 @@ bool HttpServer::parseHttpRequest(int client_socket, HttpServerRequest& request)
         if (bytes_received <= 0) return false;
 #endif
 
-        buffer[bytes_received] = '\0';
-        request_data += buffer;
+        request_data.append(buffer, static_cast<size_t>(bytes_received));
 
         if (request_data.find("\r\n\r\n") != std::string::npos) {
             headers_complete = true;
@@ -545,6 +1166,12 @@ bool HttpServer::parseHttpRequest(int client_socket, HttpServerRequest& request)
         return false;
     }
 
+    // HTTP/2 connection preface: everything read so far belongs to the HTTP/2 session
+    if (request.method == "PRI" && request.path == "*" && http_version == "HTTP/2.0") {
+        request.body = std::move(request_data);
+        return true;
+    }
+
     // Parse query string
     size_t query_pos = request.path.find('?');
     if (query_pos != std::string::npos) {
@@ -611,74 +1238,119 @@ bool HttpServer::parseHttpRequest(int client_socket, HttpServerRequest& request)
     return true;
 }
 
-void HttpServer::sendHttpResponse(int client_socket, const HttpServerResponse& response) {
-    std::ostringstream response_stream;
-
-    // Status line
-    response_stream << "HTTP/1.1 " << response.status_code << " " << response.status_message
-                    << "\r\n";
-
-    // Headers
-    for (const auto& header : response.headers) {
-        response_stream << header.first << ": " << header.second << "\r\n";
-    }
-
-    // Default headers
-    if (response.headers.find("Content-Length") == response.headers.end()) {
-        response_stream << "Content-Length: " << response.body.size() << "\r\n";
+bool HttpServer::handOffStream(int client_socket, HttpServerResponse& response) {
+    // Deferred responses write their whole response later; event streams send the head now
+    std::string head;
+    if (response.stream->mode == HubConnection::Mode::EventStream) {
+        response.body.clear();
+        head = serializeHttpResponse(response, true);
     }
 
-    if (response.headers.find("Connection") == response.headers.end()) {
-        response_stream << "Connection: " << (config.enable_keep_alive ? "keep-alive" : "close")
-                        << "\r\n";
-    }
-
-    if (response.headers.find("Server") == response.headers.end()) {
-        response_stream << "Server: O2L-HTTP-Server/1.0\r\n";
-    }
-
-    if (response.headers.find("Date") == response.headers.end()) {
-        response_stream << "Date: " << formatHttpDate(std::time(nullptr)) << "\r\n";
-    }
-
-    // End headers
-    response_stream << "\r\n";
-
-    // Body
-    if (!response.body.empty()) {
-        response_stream << response.body;
+    if (connection_hub->attach(response.stream, client_socket, head)) {
+        return true;
     }
+    connection_hub->discard(response.stream);
+    return false;
+}
 
-    std::string response_data = response_stream.str();
+void HttpServer::sendHttpResponse(int client_socket, const HttpServerResponse& response) {
+    std::string head = serializeHttpHead(response, config.enable_keep_alive);
+    const std::string& body = response.static_body ? response.static_body->data : response.body;
 
     // Send response
 #ifdef _WIN32
-    send(client_socket, response_data.c_str(), static_cast<int>(response_data.size()), 0);
+    send(client_socket, head.c_str(), static_cast<int>(head.size()), 0);
+    if (!body.empty()) {
+        send(client_socket, body.c_str(), static_cast<int>(body.size()), 0);
+    }
 #else
-    send(client_socket, response_data.c_str(), response_data.size(), 0);
+    // Head and body go out in one gathered write; the body is never copied
+    iovec parts[2] = {{head.data(), head.size()},
+                      {const_cast<char*>(body.data()), body.size()}};
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = body.empty() ? 1 : 2;
+#ifdef MSG_NOSIGNAL
+    constexpr int flags = MSG_NOSIGNAL;
+#else
+    constexpr int flags = 0;
+#endif
+    while (message.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(client_socket, &message, flags);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // Partial write: skip what was taken and resend the rest
+        size_t remaining = static_cast<size_t>(sent);
+        while (message.msg_iovlen > 0 && remaining >= message.msg_iov[0].iov_len) {
+            remaining -= message.msg_iov[0].iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0) {
+            auto* base = static_cast<char*>(message.msg_iov[0].iov_base);
+            message.msg_iov[0].iov_base = base + remaining;
+            message.msg_iov[0].iov_len -= remaining;
+        }
+    }
 #endif
 }
 
-void HttpServer::handleRequest(const HttpServerRequest& request, HttpServerResponse& response) {
+void HttpServer::handleRequest(HttpServerRequest& request, HttpServerResponse& response) {
+    // Replaces whatever the handler had set so far
+    auto expire = [this, &response](int status) {
+        response.status_code = status;
+        response.status_message = httpStatusMessage(status);
+        response.headers.clear();
+        response.static_body.reset();
+        response.body = std::to_string(status) + " - " + response.status_message;
+        ++timeout_count;
+    };
+
     try {
-        // Try to match a route
+        // Try to match a route; parameters are written straight into the request
         Router::Route matched_route;
-        std::map<std::string, std::string> route_params;
+        bool matched =
+            router.matchRoute(request.method, request.path, matched_route, request.path_params);
+
+        if (!admitRequest(request, matched ? &matched_route : nullptr, response)) {
+            return;
+        }
 
-        if (router.matchRoute(request.method, request.path, matched_route, route_params)) {
-            // Create request with route parameters
-            HttpServerRequest request_with_params = request;
-            request_with_params.path_params = route_params;
+        // The route's own deadline, else the server's; it counts from the request's arrival
+        auto timeout = matched && matched_route.options.timeout.count() >= 0
+                           ? matched_route.options.timeout
+                           : std::chrono::milliseconds(config.timeout_seconds * 1000LL);
+        if (timeout.count() > 0) {
+            request.cancellation = CancellationToken::withTimeout(timeout, request.received_at);
+            if (request.cancellation->isCancelled()) {
+                // Spent its whole budget queued behind other requests
+                expire(503);
+                response.headers["Retry-After"] = "1";
+                return;
+            }
+        }
 
+        if (matched) {
             // Execute middleware chain and route handler
-            middleware_chain.execute(request_with_params, response, matched_route.handler);
+            middleware_chain.execute(request, response, matched_route.handler);
         } else {
-            // No route found
-            response.status_code = 404;
-            response.status_message = "Not Found";
-            response.body = "404 - Not Found";
+            // No route found; middleware still runs (e.g. CORS preflight, request ids)
+            static const RouteHandler not_found = [](const HttpServerRequest&,
+                                                     HttpServerResponse& response) {
+                response.status_code = 404;
+                response.status_message = "Not Found";
+                response.body = "404 - Not Found";
+            };
+            middleware_chain.execute(request, response, not_found);
         }
 
+    } catch (const ExecutionCancelledError& e) {
+        logError("Request " + request.method + " " + request.path + " cancelled: " + e.what());
+        expire(504);
     } catch (const std::exception& e) {
         logError("Error handling request: " + std::string(e.what()));
         response.status_code = 500;
@@ -688,6 +1360,33 @@ void HttpServer::handleRequest(const HttpServerRequest& request, HttpServerRespo
     }
 }
 
+void HttpServer::setRateLimit(const RateLimit& limit) {
+    client_rate_limiter.store(limit.isEnabled() ? std::make_shared<RateLimiter>(limit) : nullptr);
+}
+
+bool HttpServer::admitRequest(const HttpServerRequest& request, const Router::Route* route,
+                              HttpServerResponse& response) {
+    RateLimiter::Decision decision;
+    if (auto limiter = client_rate_limiter.load()) {
+        decision = limiter->acquire(request.remote_address);
+    }
+    if (decision.allowed && route && route->rate_limiter) {
+        const std::string& key =
+            route->options.rate_limit_per_ip ? request.remote_address : route->pattern;
+        decision = route->rate_limiter->acquire(key);
+    }
+    if (decision.allowed) {
+        return true;
+    }
+
+    response.status_code = 429;
+    response.status_message = httpStatusMessage(429);
+    response.headers["Retry-After"] = std::to_string(std::max(1, decision.retry_after));
+    response.body = "429 - Too Many Requests";
+    ++rate_limited_count;
+    return false;
+}
+
 // URL decode utility function
 std::string urlDecode(const std::string& encoded) {
     std::string decoded;
@@ -740,26 +1439,7 @@ std::map<std::string, std::string> HttpServer::parseQueryString(const std::strin
 }
 
 std::string HttpServer::getMimeType(const std::string& filename) {
-    size_t dot_pos = filename.find_last_of('.');
-    if (dot_pos == std::string::npos) {
-        return "application/octet-stream";
-    }
-
-    std::string extension = filename.substr(dot_pos + 1);
-    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-
-    static const std::map<std::string, std::string> mime_types = {
-        {"html", "text/html"},        {"htm", "text/html"},
-        {"css", "text/css"},          {"js", "application/javascript"},
-        {"json", "application/json"}, {"xml", "application/xml"},
-        {"txt", "text/plain"},        {"png", "image/png"},
-        {"jpg", "image/jpeg"},        {"jpeg", "image/jpeg"},
-        {"gif", "image/gif"},         {"svg", "image/svg+xml"},
-        {"pdf", "application/pdf"},   {"zip", "application/zip"},
-        {"gz", "application/gzip"}};
-
-    auto it = mime_types.find(extension);
-    return (it != mime_types.end()) ? it->second : "application/octet-stream";
+    return StaticFileCache::mimeType(filename);
 }
 
 bool HttpServer::serveStaticFile(const std::string& file_path, HttpServerResponse& response) {
@@ -784,10 +1464,7 @@ bool HttpServer::serveStaticFile(const std::string& file_path, HttpServerRespons
 }
 
 std::string HttpServer::formatHttpDate(time_t timestamp) {
-    std::tm* gmt = std::gmtime(&timestamp);
-    std::ostringstream ss;
-    ss << std::put_time(gmt, "%a, %d %b %Y %H:%M:%S GMT");
-    return ss.str();
+    return httpDate(timestamp);
 }
 
 void HttpServer::sendErrorResponse(int client_socket, int status_code, const std::string& message) {
@@ -857,95 +1534,102 @@ void HttpServer::logError(const std::string& message) {
     logErrorNative(message);
 }
 
-void HttpServer::logRequest(const HttpServerRequest& request, const HttpServerResponse& response) {
+void HttpServer::logRequest(const HttpServerRequest& request, const HttpServerResponse& response,
+                            double duration_ms) {
+    AccessLogRecord record;
+    record.timestamp = std::time(nullptr);
+    record.method = request.method;
+    record.path = request.path;
+    record.query_string = request.query_string;
+    record.remote_address = request.remote_address;
+    auto user_agent = request.headers.find("user-agent");
+    if (user_agent != request.headers.end()) {
+        record.user_agent = user_agent->second;
+    }
+    record.status = response.status_code;
+    record.bytes = response.getBodySize();
+    record.duration_ms = duration_ms;
+
+    // Queued for the drain thread; the worker never waits on the sink
+    access_log.record(std::move(record));
+}
+
+void HttpServer::deliverToCustomLogger(const std::vector<AccessLogRecord>& batch) {
     std::lock_guard<std::mutex> lock(logger_mutex);
 
-    // Check if custom logger is available
-    if (custom_logger && logger_context) {
+    if (custom_logger && logger_context && custom_logger->hasMethod("log")) {
         try {
-            // Create log object with request details and getter methods
-            auto log_obj = std::make_shared<ObjectInstance>("LogEntry");
+            for (const auto& record : batch) {
+                // Create log object with request details and getter methods
+                auto log_obj = std::make_shared<ObjectInstance>("LogEntry");
+
+                std::string timestamp = formatHttpDate(record.timestamp);
+                log_obj->addMethod(
+                    "getTimestamp",
+                    [timestamp](const std::vector<Value>&, Context&) {
+                        return Value(Text(timestamp));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getMethod",
+                    [method = record.method](const std::vector<Value>&, Context&) {
+                        return Value(Text(method));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getPath",
+                    [path = record.path](const std::vector<Value>&, Context&) {
+                        return Value(Text(path));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getStatus",
+                    [status = record.status](const std::vector<Value>&, Context&) {
+                        return Value(Int(status));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getBytes",
+                    [bytes = record.bytes](const std::vector<Value>&, Context&) {
+                        return Value(Int(static_cast<Int>(bytes)));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getRemoteAddress",
+                    [remote_address = record.remote_address](const std::vector<Value>&,
+                                                             Context&) {
+                        return Value(Text(remote_address));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getUserAgent",
+                    [user_agent = record.user_agent](const std::vector<Value>&, Context&) {
+                        return Value(Text(user_agent));
+                    },
+                    true);
+                log_obj->addMethod(
+                    "getDurationMs",
+                    [duration = record.duration_ms](const std::vector<Value>&, Context&) {
+                        return Value(Double(duration));
+                    },
+                    true);
 
-            // Store data as properties for internal use
-            std::string timestamp = formatHttpDate(time(nullptr));
-            std::string method = request.method;
-            std::string path = request.path;
-            int status = response.status_code;
-            int bytes = (int)response.body.size();
-            std::string remote_address = request.remote_address;
-            std::string user_agent =
-                request.headers.count("User-Agent") ? request.headers.at("User-Agent") : "";
-
-            // Add getter methods for each property
-            log_obj->addMethod(
-                "getTimestamp",
-                [timestamp](const std::vector<Value>& args, Context& context) {
-                    return Value(Text(timestamp));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getMethod",
-                [method](const std::vector<Value>& args, Context& context) {
-                    return Value(Text(method));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getPath",
-                [path](const std::vector<Value>& args, Context& context) {
-                    return Value(Text(path));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getStatus",
-                [status](const std::vector<Value>& args, Context& context) {
-                    return Value(Int(status));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getBytes",
-                [bytes](const std::vector<Value>& args, Context& context) {
-                    return Value(Int(bytes));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getRemoteAddress",
-                [remote_address](const std::vector<Value>& args, Context& context) {
-                    return Value(Text(remote_address));
-                },
-                true);
-
-            log_obj->addMethod(
-                "getUserAgent",
-                [user_agent](const std::vector<Value>& args, Context& context) {
-                    return Value(Text(user_agent));
-                },
-                true);
-
-            // Call custom logger's log method
-            if (custom_logger->hasMethod("log")) {
                 std::vector<Value> args = {Value(log_obj)};
                 custom_logger->callMethod("log", args, *logger_context);
-                return;  // Custom logging successful
             }
+            return;  // Custom logging successful
         } catch (const std::exception& e) {
             // Custom logger failed, fall through to native logging
         }
     }
 
     // Native request logging
-    logRequestNative(request, response);
-}
-
-void HttpServer::logRequestNative(const HttpServerRequest& request,
-                                  const HttpServerResponse& response) {
-    std::cout << "[" << formatHttpDate(std::time(nullptr)) << "] " << request.method << " "
-              << request.path << " " << response.status_code << " " << response.body.size()
-              << " bytes" << std::endl;
+    std::string lines;
+    for (const auto& record : batch) {
+        lines += access_log.formatRecord(record);
+        lines += '\n';
+    }
+    std::cout << lines << std::flush;
 }
 
 void HttpServer::logErrorNative(const std::string& message) {
@@ -1008,6 +1692,27 @@ std::shared_ptr<ObjectInstance> HttpServerLibrary::createHttpServerObject() {
         },
         true);
 
+    server_obj->addMethod(
+        "setTimeout",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetTimeout(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "setMaxConnections",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetMaxConnections(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "setRateLimit",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetRateLimit(args, context);
+        },
+        true);
+
     // Route definition methods
     server_obj->addMethod(
         "get",
@@ -1050,6 +1755,35 @@ std::shared_ptr<ObjectInstance> HttpServerLibrary::createHttpServerObject() {
         [](const std::vector<Value>& args, Context& context) { return nativeUse(args, context); },
         true);
 
+    server_obj->addMethod(
+        "useBuiltin",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeUseBuiltin(args, context);
+        },
+        true);
+
+    // WebSocket support
+    server_obj->addMethod(
+        "websocket",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeWebSocket(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "broadcast",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeBroadcast(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "setWebSocketPing",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetWebSocketPing(args, context);
+        },
+        true);
+
     // Statistics
     server_obj->addMethod(
         "getStats",
@@ -1074,6 +1808,27 @@ std::shared_ptr<ObjectInstance> HttpServerLibrary::createHttpServerObject() {
         },
         true);
 
+    server_obj->addMethod(
+        "setAccessLog",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetAccessLog(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "setLogFormat",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetLogFormat(args, context);
+        },
+        true);
+
+    server_obj->addMethod(
+        "setLogSampling",
+        [](const std::vector<Value>& args, Context& context) {
+            return nativeSetLogSampling(args, context);
+        },
+        true);
+
     return server_obj;
 }
 
@@ -1162,15 +1917,95 @@ Value HttpServerLibrary::nativeSetHost(const std::vector<Value>& args, Context&
         throw std::runtime_error("Host must be a string");
     }
 
-    std::string host = std::get<Text>(args[1]);
-    server->setHost(host);
+    std::string host = std::get<Text>(args[1]);
+    server->setHost(host);
+
+    return Value(Text("Host set to " + host));
+}
+
+Value HttpServerLibrary::nativeSetPort(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setPort() requires server instance and port number");
+    }
+
+    // Get server from the first argument
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    // Get port from the second argument
+    if (!std::holds_alternative<Int>(args[1])) {
+        throw std::runtime_error("Port must be an integer");
+    }
+
+    int port = std::get<Int>(args[1]);
+    if (port <= 0 || port > 65535) {
+        throw std::runtime_error("Port must be between 1 and 65535");
+    }
+
+    server->setPort(port);
+
+    return Value(Text("Port set to " + std::to_string(port)));
+}
+
+Value HttpServerLibrary::nativeSetWorkerThreads(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setWorkerThreads() requires server instance and thread count");
+    }
+
+    // Get server from the first argument
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    // Get thread count from the second argument
+    if (!std::holds_alternative<Int>(args[1])) {
+        throw std::runtime_error("Worker thread count must be an integer");
+    }
+
+    int threads = std::get<Int>(args[1]);
+    if (threads <= 0 || threads > 100) {
+        throw std::runtime_error("Worker thread count must be between 1 and 100");
+    }
+
+    server->setWorkerThreads(threads);
+
+    return Value(Text("Worker threads set to " + std::to_string(threads)));
+}
+
+Value HttpServerLibrary::nativeSetTimeout(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setTimeout() requires server instance and timeout in seconds");
+    }
+
+    // Get server from the first argument
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    // Get timeout from the second argument; 0 lets handlers run without a deadline
+    if (!std::holds_alternative<Int>(args[1])) {
+        throw std::runtime_error("Timeout must be an integer number of seconds");
+    }
+
+    Int seconds = std::get<Int>(args[1]);
+    if (seconds < 0 || seconds > 86400) {
+        throw std::runtime_error("Timeout must be between 0 and 86400 seconds");
+    }
 
-    return Value(Text("Host set to " + host));
+    server->setTimeout(static_cast<int>(seconds));
+
+    return Value(Text("Request timeout set to " + std::to_string(seconds) + " seconds"));
 }
 
-Value HttpServerLibrary::nativeSetPort(const std::vector<Value>& args, Context& context) {
+Value HttpServerLibrary::nativeSetMaxConnections(const std::vector<Value>& args,
+                                                 Context& context) {
     if (args.size() < 2) {
-        throw std::runtime_error("setPort() requires server instance and port number");
+        throw std::runtime_error(
+            "setMaxConnections() requires server instance and connection count");
     }
 
     // Get server from the first argument
@@ -1179,24 +2014,25 @@ Value HttpServerLibrary::nativeSetPort(const std::vector<Value>& args, Context&
         throw std::runtime_error("Invalid server instance");
     }
 
-    // Get port from the second argument
+    // Get limit from the second argument
     if (!std::holds_alternative<Int>(args[1])) {
-        throw std::runtime_error("Port must be an integer");
+        throw std::runtime_error("Connection count must be an integer");
     }
 
-    int port = std::get<Int>(args[1]);
-    if (port <= 0 || port > 65535) {
-        throw std::runtime_error("Port must be between 1 and 65535");
+    Int max_conn = std::get<Int>(args[1]);
+    if (max_conn <= 0 || max_conn > 1000000) {
+        throw std::runtime_error("Connection count must be between 1 and 1000000");
     }
 
-    server->setPort(port);
+    server->setMaxConnections(static_cast<int>(max_conn));
 
-    return Value(Text("Port set to " + std::to_string(port)));
+    return Value(Text("Max connections set to " + std::to_string(max_conn)));
 }
 
-Value HttpServerLibrary::nativeSetWorkerThreads(const std::vector<Value>& args, Context& context) {
+Value HttpServerLibrary::nativeSetRateLimit(const std::vector<Value>& args, Context& context) {
     if (args.size() < 2) {
-        throw std::runtime_error("setWorkerThreads() requires server instance and thread count");
+        throw std::runtime_error(
+            "setRateLimit() requires server instance and requests per second");
     }
 
     // Get server from the first argument
@@ -1205,19 +2041,37 @@ Value HttpServerLibrary::nativeSetWorkerThreads(const std::vector<Value>& args,
         throw std::runtime_error("Invalid server instance");
     }
 
-    // Get thread count from the second argument
-    if (!std::holds_alternative<Int>(args[1])) {
-        throw std::runtime_error("Worker thread count must be an integer");
-    }
+    // Rate and optional burst as Int or Float; a rate of 0 removes the limit
+    auto number = [](const Value& value, const std::string& what) {
+        if (std::holds_alternative<Int>(value)) {
+            return static_cast<double>(std::get<Int>(value));
+        } else if (std::holds_alternative<Double>(value)) {
+            return static_cast<double>(std::get<Double>(value));
+        } else if (std::holds_alternative<Float>(value)) {
+            return static_cast<double>(std::get<Float>(value));
+        }
+        throw std::runtime_error(what + " must be a number");
+    };
 
-    int threads = std::get<Int>(args[1]);
-    if (threads <= 0 || threads > 100) {
-        throw std::runtime_error("Worker thread count must be between 1 and 100");
+    RateLimit limit;
+    limit.rate = number(args[1], "Rate");
+    if (!(limit.rate >= 0)) {
+        throw std::runtime_error("Rate must be a non-negative number of requests per second");
+    }
+    limit.burst = args.size() > 2 ? number(args[2], "Burst") : std::max(1.0, limit.rate);
+    if (limit.rate > 0 && !(limit.burst >= 1)) {
+        throw std::runtime_error("Burst must be at least 1");
     }
 
-    server->setWorkerThreads(threads);
+    server->setRateLimit(limit);
 
-    return Value(Text("Worker threads set to " + std::to_string(threads)));
+    if (!limit.isEnabled()) {
+        return Value(Text("Rate limit disabled"));
+    }
+    std::ostringstream message;
+    message << "Rate limit set to " << limit.rate << " requests per second per client (burst "
+            << limit.burst << ")";
+    return Value(Text(message.str()));
 }
 
 // Route definition methods
@@ -1239,20 +2093,11 @@ Value HttpServerLibrary::nativeGet(const std::vector<Value>& args, Context& cont
     }
     std::string pattern = std::get<Text>(args[1]);
 
-    RouteHandler handler;
-
-    if (args.size() == 4) {
-        // Four arguments: server, pattern, object, method_name
-        // Create route handler from object and method name
-        handler = createObjectMethodHandler(args[2], args[3], context);
-    } else {
-        // Three arguments: server, pattern, handler (string or object)
-        // Create route handler from the third argument
-        handler = createRouteHandler(args[2], context);
-    }
+    RouteOptions options;
+    RouteHandler handler = createRouteHandlerFromArgs(args, context, options);
 
     // Register the route
-    server->get(pattern, handler);
+    server->get(pattern, handler, options);
 
     return Value(Text("GET route registered for " + pattern));
 }
@@ -1275,18 +2120,11 @@ Value HttpServerLibrary::nativePost(const std::vector<Value>& args, Context& con
     }
     std::string pattern = std::get<Text>(args[1]);
 
-    RouteHandler handler;
-
-    if (args.size() == 4) {
-        // Four arguments: server, pattern, object, method_name
-        handler = createObjectMethodHandler(args[2], args[3], context);
-    } else {
-        // Three arguments: server, pattern, handler (string or object)
-        handler = createRouteHandler(args[2], context);
-    }
+    RouteOptions options;
+    RouteHandler handler = createRouteHandlerFromArgs(args, context, options);
 
     // Register the route
-    server->post(pattern, handler);
+    server->post(pattern, handler, options);
 
     return Value(Text("POST route registered for " + pattern));
 }
@@ -1309,18 +2147,11 @@ Value HttpServerLibrary::nativePut(const std::vector<Value>& args, Context& cont
     }
     std::string pattern = std::get<Text>(args[1]);
 
-    RouteHandler handler;
-
-    if (args.size() == 4) {
-        // Four arguments: server, pattern, object, method_name
-        handler = createObjectMethodHandler(args[2], args[3], context);
-    } else {
-        // Three arguments: server, pattern, handler (string or object)
-        handler = createRouteHandler(args[2], context);
-    }
+    RouteOptions options;
+    RouteHandler handler = createRouteHandlerFromArgs(args, context, options);
 
     // Register the route
-    server->put(pattern, handler);
+    server->put(pattern, handler, options);
 
     return Value(Text("PUT route registered for " + pattern));
 }
@@ -1343,18 +2174,11 @@ Value HttpServerLibrary::nativeDelete(const std::vector<Value>& args, Context& c
     }
     std::string pattern = std::get<Text>(args[1]);
 
-    RouteHandler handler;
-
-    if (args.size() == 4) {
-        // Four arguments: server, pattern, object, method_name
-        handler = createObjectMethodHandler(args[2], args[3], context);
-    } else {
-        // Three arguments: server, pattern, handler (string or object)
-        handler = createRouteHandler(args[2], context);
-    }
+    RouteOptions options;
+    RouteHandler handler = createRouteHandlerFromArgs(args, context, options);
 
     // Register the route
-    server->delete_(pattern, handler);
+    server->delete_(pattern, handler, options);
 
     return Value(Text("DELETE route registered for " + pattern));
 }
@@ -1377,18 +2201,11 @@ Value HttpServerLibrary::nativePatch(const std::vector<Value>& args, Context& co
     }
     std::string pattern = std::get<Text>(args[1]);
 
-    RouteHandler handler;
-
-    if (args.size() == 4) {
-        // Four arguments: server, pattern, object, method_name
-        handler = createObjectMethodHandler(args[2], args[3], context);
-    } else {
-        // Three arguments: server, pattern, handler (string or object)
-        handler = createRouteHandler(args[2], context);
-    }
+    RouteOptions options;
+    RouteHandler handler = createRouteHandlerFromArgs(args, context, options);
 
     // Register the route
-    server->patch(pattern, handler);
+    server->patch(pattern, handler, options);
 
     return Value(Text("PATCH route registered for " + pattern));
 }
@@ -1417,10 +2234,58 @@ Value HttpServerLibrary::nativeStatic(const std::vector<Value>& args, Context& c
     }
     std::string fs_path = std::get<Text>(args[2]);
 
+    // Optional cache settings: static(server, "/assets", "./public", {"cache": true, ...})
+    std::optional<StaticFileCache::Options> cache;
+    if (args.size() > 3) {
+        if (!std::holds_alternative<std::shared_ptr<MapInstance>>(args[3])) {
+            throw std::runtime_error("Static file options must be a Map");
+        }
+        StaticFileCache::Options options;
+        bool enabled = false;
+        auto integer = [](const std::string& name, const Value& value) -> Int {
+            if (!std::holds_alternative<Int>(value) || std::get<Int>(value) < 0) {
+                throw std::runtime_error("Static file option '" + name +
+                                         "' must be a non-negative Int");
+            }
+            return std::get<Int>(value);
+        };
+        auto boolean = [](const std::string& name, const Value& value) -> bool {
+            if (!std::holds_alternative<Bool>(value)) {
+                throw std::runtime_error("Static file option '" + name + "' must be a Bool");
+            }
+            return std::get<Bool>(value);
+        };
+        const auto& entries = std::get<std::shared_ptr<MapInstance>>(args[3])->getEntries();
+        for (const auto& [key, value] : entries) {
+            std::string name = valueToString(key);
+            if (name == "cache") {
+                enabled = boolean(name, value);
+            } else if (name == "preload") {
+                options.preload = boolean(name, value);
+            } else if (name == "compress") {
+                options.compress = boolean(name, value);
+            } else if (name == "max_file_size") {
+                options.max_file_size = static_cast<size_t>(integer(name, value));
+            } else if (name == "max_memory") {
+                options.max_memory = static_cast<size_t>(integer(name, value));
+            } else if (name == "max_age") {
+                options.max_age = static_cast<int>(integer(name, value));
+            } else {
+                throw std::runtime_error("Unknown static file option '" + name +
+                                         "'. Expected one of: cache, preload, compress, "
+                                         "max_file_size, max_memory, max_age");
+            }
+        }
+        if (enabled) {
+            cache = options;
+        }
+    }
+
     // Register static file serving route
-    server->static_(url_path, fs_path);
+    server->static_(url_path, fs_path, cache);
 
-    return Value(Text("Static file serving registered for " + url_path + " -> " + fs_path));
+    return Value(Text("Static file serving registered for " + url_path + " -> " + fs_path +
+                      (cache ? " (cached)" : "")));
 }
 
 Value HttpServerLibrary::nativeUse(const std::vector<Value>& args, Context& context) {
@@ -1444,6 +2309,107 @@ Value HttpServerLibrary::nativeUse(const std::vector<Value>& args, Context& cont
     return Value(Text("Middleware registered successfully"));
 }
 
+Value HttpServerLibrary::nativeUseBuiltin(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("useBuiltin() requires server instance and middleware name");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Text>(args[1])) {
+        throw std::runtime_error("Built-in middleware name must be a string");
+    }
+    const std::string& name = std::get<Text>(args[1]);
+
+    MiddlewareOptions options;
+    if (args.size() > 2) {
+        if (!std::holds_alternative<std::shared_ptr<MapInstance>>(args[2])) {
+            throw std::runtime_error("Built-in middleware options must be a Map");
+        }
+        const auto& entries = std::get<std::shared_ptr<MapInstance>>(args[2])->getEntries();
+        for (const auto& [key, value] : entries) {
+            options[valueToString(key)] = valueToString(value);
+        }
+    }
+
+    if (name == "cache") {
+        // Kept by the server so getStats() can report it
+        server->useResponseCache(
+            std::make_shared<ResponseCache>(ResponseCache::parseOptions(options)));
+    } else {
+        server->useStage(BuiltinMiddleware::create(name, options));
+    }
+    return Value(Text("Built-in middleware '" + name + "' registered"));
+}
+
+Value HttpServerLibrary::nativeWebSocket(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 3) {
+        throw std::runtime_error("websocket() requires server instance, path pattern, and handler");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Text>(args[1])) {
+        throw std::runtime_error("Path pattern must be a string");
+    }
+    if (!ConnectionHub::isSupported()) {
+        throw std::runtime_error("WebSockets are not supported on this platform");
+    }
+
+    std::string pattern = std::get<Text>(args[1]);
+    server->websocket(pattern, createWebSocketHandlers(args[2], context));
+
+    return Value(Text("WebSocket route registered for " + pattern));
+}
+
+Value HttpServerLibrary::nativeBroadcast(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 3) {
+        throw std::runtime_error("broadcast() requires server instance, topic, and message");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Text>(args[1]) || !std::holds_alternative<Text>(args[2])) {
+        throw std::runtime_error("Topic and message must be strings");
+    }
+
+    size_t delivered =
+        server->getConnectionHub().publish(std::get<Text>(args[1]), std::get<Text>(args[2]));
+    return Value(Int(static_cast<Int>(delivered)));
+}
+
+Value HttpServerLibrary::nativeSetWebSocketPing(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setWebSocketPing() requires server instance and interval");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Int>(args[1])) {
+        throw std::runtime_error("Ping interval must be an integer");
+    }
+
+    Int seconds = std::get<Int>(args[1]);
+    if (seconds < 0) {
+        throw std::runtime_error("Ping interval must be zero (disabled) or positive");
+    }
+
+    server->getConnectionHub().setPingInterval(static_cast<int>(seconds));
+    return Value(Text("WebSocket ping interval set to " + std::to_string(seconds) + " seconds"));
+}
+
 Value HttpServerLibrary::nativeGetStats(const std::vector<Value>& args, Context& context) {
     if (args.empty()) {
         throw std::runtime_error("getStats() requires server instance");
@@ -1463,6 +2429,11 @@ Value HttpServerLibrary::nativeGetStats(const std::vector<Value>& args, Context&
     stats->put(Text("active_connections"),
                Value(Int(static_cast<int>(server->getActiveConnections()))));
     stats->put(Text("error_count"), Value(Int(static_cast<int>(server->getErrorCount()))));
+    stats->put(Text("timeout_count"), Value(Int(static_cast<Int>(server->getTimeoutCount()))));
+    stats->put(Text("rate_limited_count"),
+               Value(Int(static_cast<Int>(server->getRateLimitedCount()))));
+    stats->put(Text("rejected_connections"),
+               Value(Int(static_cast<Int>(server->getRejectedConnections()))));
     stats->put(Text("is_running"), Value(Bool(server->isRunning())));
 
     // Add server uptime (simple implementation)
@@ -1487,6 +2458,56 @@ Value HttpServerLibrary::nativeGetStats(const std::vector<Value>& args, Context&
     }
     stats->put(Text("error_rate_percent"), Value(Float(static_cast<float>(error_rate))));
 
+    // Access log health: lines written and lines dropped because a worker's ring was full
+    stats->put(Text("access_log_written"),
+               Value(Int(static_cast<Int>(server->getAccessLog().getWrittenCount()))));
+    stats->put(Text("access_log_dropped"),
+               Value(Int(static_cast<Int>(server->getAccessLog().getDroppedCount()))));
+
+    // Connections parked on the hub, by kind
+    ConnectionHub& hub = server->getConnectionHub();
+    stats->put(Text("websocket_connections"),
+               Value(Int(static_cast<Int>(
+                   hub.getConnectionCount(HubConnection::Mode::WebSocket)))));
+    stats->put(Text("websocket_messages"),
+               Value(Int(static_cast<Int>(hub.getMessagesReceived()))));
+    stats->put(Text("event_streams"),
+               Value(Int(static_cast<Int>(
+                   hub.getConnectionCount(HubConnection::Mode::EventStream)))));
+    stats->put(Text("deferred_responses"),
+               Value(Int(static_cast<Int>(hub.getConnectionCount(HubConnection::Mode::Deferred)))));
+    stats->put(Text("http2_connections"),
+               Value(Int(static_cast<Int>(hub.getConnectionCount(HubConnection::Mode::Http2)))));
+
+    // Static file caches, summed over every cached directory
+    size_t cache_entries = 0, cache_bytes = 0, cache_hits = 0, cache_misses = 0;
+    for (const auto& cache : server->getStaticCaches()) {
+        cache_entries += cache->getEntryCount();
+        cache_bytes += cache->getMemoryUsage();
+        cache_hits += cache->getHits();
+        cache_misses += cache->getMisses();
+    }
+    stats->put(Text("static_cache_entries"), Value(Int(static_cast<Int>(cache_entries))));
+    stats->put(Text("static_cache_bytes"), Value(Int(static_cast<Int>(cache_bytes))));
+    stats->put(Text("static_cache_hits"), Value(Int(static_cast<Int>(cache_hits))));
+    stats->put(Text("static_cache_misses"), Value(Int(static_cast<Int>(cache_misses))));
+
+    size_t response_entries = 0, response_bytes = 0, response_hits = 0, response_misses = 0;
+    size_t response_coalesced = 0;
+    for (const auto& cache : server->getResponseCaches()) {
+        response_entries += cache->getEntryCount();
+        response_bytes += cache->getMemoryUsage();
+        response_hits += cache->getHits();
+        response_misses += cache->getMisses();
+        response_coalesced += cache->getCoalesced();
+    }
+    stats->put(Text("response_cache_entries"), Value(Int(static_cast<Int>(response_entries))));
+    stats->put(Text("response_cache_bytes"), Value(Int(static_cast<Int>(response_bytes))));
+    stats->put(Text("response_cache_hits"), Value(Int(static_cast<Int>(response_hits))));
+    stats->put(Text("response_cache_misses"), Value(Int(static_cast<Int>(response_misses))));
+    stats->put(Text("response_cache_coalesced"),
+               Value(Int(static_cast<Int>(response_coalesced))));
+
     return Value(stats);
 }
 
@@ -1534,6 +2555,69 @@ Value HttpServerLibrary::nativeSetLogger(const std::vector<Value>& args, Context
     return Value(Text("Custom logger set successfully"));
 }
 
+Value HttpServerLibrary::nativeSetAccessLog(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setAccessLog() requires server instance and target");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Text>(args[1])) {
+        throw std::runtime_error("Access log target must be \"stdout\", \"off\" or a file path");
+    }
+
+    std::string target = std::get<Text>(args[1]);
+    if (target == "stdout") {
+        server->clearCustomLogger();
+    } else if (target == "off") {
+        server->getAccessLog().disable();
+    } else {
+        server->getAccessLog().setFileSink(target);
+    }
+
+    return Value(Text("Access log set to " + target));
+}
+
+Value HttpServerLibrary::nativeSetLogFormat(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setLogFormat() requires server instance and format");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Text>(args[1])) {
+        throw std::runtime_error("Log format must be a string");
+    }
+
+    server->getAccessLog().setFormat(std::get<Text>(args[1]));
+    return Value(Text("Log format set"));
+}
+
+Value HttpServerLibrary::nativeSetLogSampling(const std::vector<Value>& args, Context& context) {
+    if (args.size() < 2) {
+        throw std::runtime_error("setLogSampling() requires server instance and sampling rate");
+    }
+
+    auto server = getServerFromValue(args[0]);
+    if (!server) {
+        throw std::runtime_error("Invalid server instance");
+    }
+
+    if (!std::holds_alternative<Int>(args[1])) {
+        throw std::runtime_error("Sampling rate must be an integer");
+    }
+
+    int every = std::get<Int>(args[1]);
+    server->getAccessLog().setSampling(every);
+    return Value(Text("Logging 1 of every " + std::to_string(every) + " requests"));
+}
+
 // Helper methods
 std::shared_ptr<HttpServer> HttpServerLibrary::getServerFromValue(const Value& server_value) {
     // The server_value should be an ObjectInstance with a server_id property
@@ -1568,8 +2652,10 @@ RouteHandler HttpServerLibrary::createRouteHandler(const Value& handler_value, C
                                      HttpServerResponse& response) {
         try {
             // Create request and response objects for O²L
-            auto request_obj = createRequestObject(request);
-            auto response_obj = createResponseObject(response);
+            HandlerObjectsScope objects(createRequestObject(request),
+                                        createResponseObject(response));
+            const auto& request_obj = objects.request();
+            const auto& response_obj = objects.response();
 
             // Check what type of handler we have
             if (std::holds_alternative<Text>(handler_value)) {
@@ -1637,11 +2723,12 @@ RouteHandler HttpServerLibrary::createRouteHandler(const Value& handler_value, C
                 if (!selected_method.empty()) {
                     std::vector<Value> args = {Value(request_obj), Value(response_obj)};
                     Context handler_context = context;  // Copy context for handler
+                    handler_context.setCancellationToken(request.cancellation);
                     Value result = handler_obj->callMethod(selected_method, args, handler_context);
 
                     // The handler should have modified the response object
-                    // If not, provide a default response
-                    if (response.body.empty()) {
+                    // If not, provide a default response (streams have no body here)
+                    if (response.body.empty() && !response.stream) {
                         response.status_code = 200;
                         response.headers["Content-Type"] = "application/json";
                         response.body =
@@ -1665,6 +2752,8 @@ RouteHandler HttpServerLibrary::createRouteHandler(const Value& handler_value, C
                 response.body = "{\"message\": \"Unknown handler type\"}";
             }
 
+        } catch (const ExecutionCancelledError&) {
+            throw;  // answered by the server as 504
         } catch (const std::exception& e) {
             // Error handling
             response.status_code = 500;
@@ -1674,6 +2763,76 @@ RouteHandler HttpServerLibrary::createRouteHandler(const Value& handler_value, C
     };
 }
 
+RouteHandler HttpServerLibrary::createRouteHandlerFromArgs(const std::vector<Value>& args,
+                                                           Context& context,
+                                                           RouteOptions& options) {
+    // Optional trailing options: get(server, "/report", handler, {"timeout": 2.5, "rate": 10})
+    size_t handler_args = args.size();
+    if (handler_args > 3 && std::holds_alternative<std::shared_ptr<MapInstance>>(args.back())) {
+        --handler_args;
+        // Int or Float; anything else reads as NaN and fails the range checks below
+        auto number = [](const Value& value) {
+            if (std::holds_alternative<Int>(value)) {
+                return static_cast<double>(std::get<Int>(value));
+            } else if (std::holds_alternative<Double>(value)) {
+                return static_cast<double>(std::get<Double>(value));
+            } else if (std::holds_alternative<Float>(value)) {
+                return static_cast<double>(std::get<Float>(value));
+            }
+            return std::nan("");
+        };
+        bool burst_set = false;
+        const auto& entries = std::get<std::shared_ptr<MapInstance>>(args.back())->getEntries();
+        for (const auto& [key, value] : entries) {
+            std::string name = valueToString(key);
+            if (name == "timeout") {
+                // Seconds; 0 disables the deadline for this route
+                double seconds = number(value);
+                if (!(seconds >= 0)) {
+                    throw std::runtime_error(
+                        "Route option 'timeout' must be a non-negative number");
+                }
+                options.timeout =
+                    std::chrono::milliseconds(static_cast<int64_t>(std::ceil(seconds * 1000)));
+            } else if (name == "rate") {
+                // Requests per second admitted to this route
+                options.rate_limit.rate = number(value);
+                if (!(options.rate_limit.rate > 0)) {
+                    throw std::runtime_error("Route option 'rate' must be a positive number");
+                }
+            } else if (name == "burst") {
+                options.rate_limit.burst = number(value);
+                burst_set = true;
+                if (!(options.rate_limit.burst >= 1)) {
+                    throw std::runtime_error("Route option 'burst' must be at least 1");
+                }
+            } else if (name == "per_ip") {
+                if (!std::holds_alternative<Bool>(value)) {
+                    throw std::runtime_error("Route option 'per_ip' must be a boolean");
+                }
+                options.rate_limit_per_ip = std::get<Bool>(value);
+            } else {
+                throw std::runtime_error("Unknown route option '" + name +
+                                         "'. Expected one of: timeout, rate, burst, per_ip");
+            }
+        }
+        if (!burst_set) {
+            // One second's worth of requests may arrive at once
+            options.rate_limit.burst = std::max(1.0, options.rate_limit.rate);
+        }
+        if ((burst_set || options.rate_limit_per_ip) && options.rate_limit.rate <= 0) {
+            throw std::runtime_error("Route options 'burst' and 'per_ip' require 'rate'");
+        }
+    }
+
+    if (handler_args == 4) {
+        // server, pattern, object, method_name
+        return createObjectMethodHandler(args[2], args[3], context);
+    }
+    // server, pattern, handler (string or object)
+    return createRouteHandler(args[2], context);
+}
+
 RouteHandler HttpServerLibrary::createObjectMethodHandler(const Value& object_value,
                                                           const Value& method_name_value,
                                                           Context& context) {
@@ -1698,21 +2857,24 @@ RouteHandler HttpServerLibrary::createObjectMethodHandler(const Value& object_va
                                                 HttpServerResponse& response) {
         try {
             // Create request and response objects for O²L
-            auto request_obj = createRequestObject(request);
-            auto response_obj = createResponseObject(response);
+            HandlerObjectsScope objects(createRequestObject(request),
+                                        createResponseObject(response));
+            const auto& request_obj = objects.request();
+            const auto& response_obj = objects.response();
 
             // Prepare arguments for the method call
             std::vector<Value> method_args = {Value(request_obj), Value(response_obj)};
 
-            // Create a context copy for the handler
+            // Create a context copy for the handler, bound to the request's deadline
             Context handler_context = context;
+            handler_context.setCancellationToken(request.cancellation);
 
             // Call the object method
             Value result = handler_obj->callMethod(method_name, method_args, handler_context);
 
             // The response object should have been modified by the handler
-            // If no body was set, use the return value as JSON
-            if (response.body.empty()) {
+            // If no body was set, use the return value as JSON (streams have no body here)
+            if (response.body.empty() && !response.stream) {
                 response.headers["Content-Type"] = "application/json";
 
                 if (std::holds_alternative<Text>(result)) {
@@ -1740,6 +2902,8 @@ RouteHandler HttpServerLibrary::createObjectMethodHandler(const Value& object_va
                 response.status_code = 200;
             }
 
+        } catch (const ExecutionCancelledError&) {
+            throw;  // answered by the server as 504
         } catch (const std::exception& e) {
             // Error handling
             response.status_code = 500;
@@ -1755,8 +2919,10 @@ MiddlewareFunction HttpServerLibrary::createMiddlewareFunction(const Value& midd
                                         HttpServerResponse& response, std::function<void()> next) {
         try {
             // Create request and response objects for O²L
-            auto request_obj = createRequestObject(request);
-            auto response_obj = createResponseObject(response);
+            HandlerObjectsScope objects(createRequestObject(request),
+                                        createResponseObject(response));
+            const auto& request_obj = objects.request();
+            const auto& response_obj = objects.response();
 
             // Create a next function object for O²L
             auto next_obj = std::make_shared<ObjectInstance>("NextFunction");
@@ -1777,6 +2943,7 @@ MiddlewareFunction HttpServerLibrary::createMiddlewareFunction(const Value& midd
                     std::vector<Value> args = {Value(request_obj), Value(response_obj),
                                                Value(next_obj)};
                     Context middleware_context = context;  // Copy context for middleware
+                    middleware_context.setCancellationToken(request.cancellation);
                     middleware_obj->callMethod("handle", args, middleware_context);
                 } else {
                     // If no handle method, just call next
@@ -1797,6 +2964,8 @@ MiddlewareFunction HttpServerLibrary::createMiddlewareFunction(const Value& midd
                 next();
             }
 
+        } catch (const ExecutionCancelledError&) {
+            throw;  // the deadline covers the whole chain, not just this stage
         } catch (const std::exception& e) {
             // Error in middleware - log and continue
             std::cerr << "Middleware error: " << e.what() << std::endl;
@@ -1805,346 +2974,162 @@ MiddlewareFunction HttpServerLibrary::createMiddlewareFunction(const Value& midd
     };
 }
 
-std::shared_ptr<ObjectInstance> HttpServerLibrary::createRequestObject(
-    const HttpServerRequest& request) {
-    auto request_obj = std::make_shared<ObjectInstance>("HttpRequest");
-
-    // Add basic properties
-    request_obj->setProperty("method", Value(Text(request.method)));
-    request_obj->setProperty("path", Value(Text(request.path)));
-    request_obj->setProperty("query_string", Value(Text(request.query_string)));
-    request_obj->setProperty("body", Value(Text(request.body)));
-    request_obj->setProperty("remote_address", Value(Text(request.remote_address)));
-    request_obj->setProperty("remote_port", Value(Int(request.remote_port)));
-
-    // Create headers map
-    auto headers_map = std::make_shared<MapInstance>();
-    for (const auto& [key, value] : request.headers) {
-        headers_map->put(Text(key), Value(Text(value)));
-    }
-    request_obj->setProperty("headers", Value(headers_map));
-
-    // Create query parameters map
-    auto query_params_map = std::make_shared<MapInstance>();
-    for (const auto& [key, value] : request.query_params) {
-        query_params_map->put(Text(key), Value(Text(value)));
-    }
-    request_obj->setProperty("query_params", Value(query_params_map));
-
-    // Create path parameters map
-    auto path_params_map = std::make_shared<MapInstance>();
-    for (const auto& [key, value] : request.path_params) {
-        path_params_map->put(Text(key), Value(Text(value)));
-    }
-    request_obj->setProperty("path_params", Value(path_params_map));
-
-    // Add convenience methods
-    request_obj->addMethod(
-        "getMethod",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Text(request.method));
-        },
-        true);
+std::shared_ptr<const WebSocketHandlers> HttpServerLibrary::createWebSocketHandlers(
+    const Value& handler_value, Context& context) {
+    if (!std::holds_alternative<std::shared_ptr<ObjectInstance>>(handler_value)) {
+        throw std::runtime_error("WebSocket handler must be an object");
+    }
 
-    request_obj->addMethod(
-        "getPath",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Text(request.path));
-        },
-        true);
+    auto handler_obj = std::get<std::shared_ptr<ObjectInstance>>(handler_value);
+    auto handlers = std::make_shared<WebSocketHandlers>();
 
-    request_obj->addMethod(
-        "getQuery",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Text(request.query_string));
-        },
-        true);
+    if (handler_obj->hasMethod("onOpen")) {
+        handlers->on_open = [handler_obj,
+                             &context](const std::shared_ptr<HubConnection>& connection) {
+            std::vector<Value> args = {Value(getWebSocketObject(connection))};
+            Context handler_context = context;
+            handler_obj->callMethod("onOpen", args, handler_context);
+        };
+    }
+    if (handler_obj->hasMethod("onMessage")) {
+        handlers->on_message = [handler_obj, &context](
+                                   const std::shared_ptr<HubConnection>& connection,
+                                   const std::string& message, bool) {
+            std::vector<Value> args = {Value(getWebSocketObject(connection)), Value(Text(message))};
+            Context handler_context = context;
+            handler_obj->callMethod("onMessage", args, handler_context);
+        };
+    }
+    if (handler_obj->hasMethod("onClose")) {
+        handlers->on_close = [handler_obj, &context](
+                                 const std::shared_ptr<HubConnection>& connection, int code) {
+            std::vector<Value> args = {Value(getWebSocketObject(connection)), Value(Int(code))};
+            Context handler_context = context;
+            handler_obj->callMethod("onClose", args, handler_context);
+        };
+    }
 
-    request_obj->addMethod(
-        "getBody",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Text(request.body));
-        },
-        true);
+    if (!handlers->on_open && !handlers->on_message && !handlers->on_close) {
+        throw std::runtime_error("WebSocket handler '" + handler_obj->getName() +
+                                 "' must define onOpen, onMessage or onClose");
+    }
+    return handlers;
+}
 
-    request_obj->addMethod(
-        "getHeader",
-        [request](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("getHeader() requires a header name");
-            }
-            std::string header_name = std::get<Text>(args[0]);
-            auto it = request.headers.find(header_name);
-            if (it != request.headers.end()) {
-                return Value(Text(it->second));
-            }
-            return Value(Text(""));
-        },
-        true);
+std::shared_ptr<ObjectInstance> HttpServerLibrary::getWebSocketObject(
+    const std::shared_ptr<HubConnection>& connection) {
+    // Events for one connection never run concurrently, so the lazy creation is safe
+    if (connection->script_object) {
+        return connection->script_object;
+    }
 
-    request_obj->addMethod(
-        "getParam",
-        [request](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("getParam() requires a parameter name");
-            }
-            std::string param_name = std::get<Text>(args[0]);
-            auto it = request.path_params.find(param_name);
-            if (it != request.path_params.end()) {
-                return Value(Text(it->second));
-            }
-            return Value(Text(""));
-        },
-        true);
+    // Methods hold the connection weakly: a script that keeps the object past close gets
+    // false from send() instead of keeping the connection state alive
+    std::weak_ptr<HubConnection> weak = connection;
+    Int id = static_cast<Int>(connection->id);
+    auto ws_obj = std::make_shared<ObjectInstance>("WebSocket");
 
-    request_obj->addMethod(
-        "getQueryParam",
-        [request](const std::vector<Value>& args, Context& context) {
+    ws_obj->addMethod(
+        "send",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
             if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("getQueryParam() requires a parameter name");
-            }
-            std::string param_name = std::get<Text>(args[0]);
-            auto it = request.query_params.find(param_name);
-            if (it != request.query_params.end()) {
-                return Value(Text(it->second));
+                throw std::runtime_error("send() requires a message string");
             }
-            return Value(Text(""));
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->send(std::get<Text>(args[0]))));
         },
         true);
 
-    request_obj->addMethod(
-        "getRemoteAddress",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Text(request.remote_address));
-        },
-        true);
-
-    request_obj->addMethod(
-        "getRemotePort",
-        [request](const std::vector<Value>& args, Context& context) {
-            return Value(Int(request.remote_port));
-        },
-        true);
-
-    request_obj->addMethod(
-        "getHeaders",
-        [request](const std::vector<Value>& args, Context& context) {
-            auto headers_map = std::make_shared<MapInstance>();
-            for (const auto& [key, value] : request.headers) {
-                headers_map->put(Text(key), Value(Text(value)));
-            }
-            return Value(headers_map);
-        },
-        true);
-
-    return request_obj;
-}
-
-std::shared_ptr<ObjectInstance> HttpServerLibrary::createResponseObject(
-    HttpServerResponse& response) {
-    auto response_obj = std::make_shared<ObjectInstance>("HttpResponse");
-
-    // Add basic properties
-    response_obj->setProperty("status_code", Value(Int(response.status_code)));
-    response_obj->setProperty("status_message", Value(Text(response.status_message)));
-    response_obj->setProperty("body", Value(Text(response.body)));
-    response_obj->setProperty("sent", Value(Bool(response.sent)));
-    response_obj->setProperty("chunked", Value(Bool(response.chunked)));
-
-    // Create headers map
-    auto headers_map = std::make_shared<MapInstance>();
-    for (const auto& [key, value] : response.headers) {
-        headers_map->put(Text(key), Value(Text(value)));
-    }
-    response_obj->setProperty("headers", Value(headers_map));
-
-    // Add response control methods
-    response_obj->addMethod(
-        "setStatus",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Int>(args[0])) {
-                throw std::runtime_error("setStatus() requires a status code number");
-            }
-            int status = std::get<Int>(args[0]);
-            if (status < 100 || status >= 600) {
-                throw std::runtime_error("Invalid HTTP status code: " + std::to_string(status));
+    ws_obj->addMethod(
+        "close",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
+            int code = websocket::kCloseNormal;
+            std::string reason;
+            if (!args.empty() && std::holds_alternative<Int>(args[0])) {
+                code = static_cast<int>(std::get<Int>(args[0]));
             }
-            response.status_code = status;
-
-            // Set default status message based on common codes
-            switch (status) {
-                case 200:
-                    response.status_message = "OK";
-                    break;
-                case 201:
-                    response.status_message = "Created";
-                    break;
-                case 204:
-                    response.status_message = "No Content";
-                    break;
-                case 400:
-                    response.status_message = "Bad Request";
-                    break;
-                case 401:
-                    response.status_message = "Unauthorized";
-                    break;
-                case 403:
-                    response.status_message = "Forbidden";
-                    break;
-                case 404:
-                    response.status_message = "Not Found";
-                    break;
-                case 405:
-                    response.status_message = "Method Not Allowed";
-                    break;
-                case 500:
-                    response.status_message = "Internal Server Error";
-                    break;
-                case 502:
-                    response.status_message = "Bad Gateway";
-                    break;
-                case 503:
-                    response.status_message = "Service Unavailable";
-                    break;
-                default:
-                    response.status_message = "Unknown";
-                    break;
+            if (args.size() > 1 && std::holds_alternative<Text>(args[1])) {
+                reason = std::get<Text>(args[1]);
             }
-
-            return Value(Text("Status set to " + std::to_string(status)));
-        },
-        true);
-
-    response_obj->addMethod(
-        "setHeader",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.size() < 2 || !std::holds_alternative<Text>(args[0]) ||
-                !std::holds_alternative<Text>(args[1])) {
-                throw std::runtime_error("setHeader() requires header name and value");
+            auto conn = weak.lock();
+            if (!conn || !conn->isOpen()) {
+                return Value(Bool(false));
             }
-            std::string header_name = std::get<Text>(args[0]);
-            std::string header_value = std::get<Text>(args[1]);
-            response.headers[header_name] = header_value;
-            return Value(Text("Header '" + header_name + "' set"));
+            conn->close(code, reason);
+            return Value(Bool(true));
         },
         true);
 
-    response_obj->addMethod(
-        "setBody",
-        [&response](const std::vector<Value>& args, Context& context) {
+    ws_obj->addMethod(
+        "subscribe",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
             if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("setBody() requires body content");
+                throw std::runtime_error("subscribe() requires a topic string");
             }
-            std::string body_content = std::get<Text>(args[0]);
-            response.body = body_content;
-            return Value(Text("Body set"));
-        },
-        true);
-
-    response_obj->addMethod(
-        "json",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("json() requires JSON string");
+            auto conn = weak.lock();
+            if (!conn || !conn->isOpen()) {
+                return Value(Bool(false));
             }
-            std::string json_content = std::get<Text>(args[0]);
-            response.body = json_content;
-            response.headers["Content-Type"] = "application/json";
-            return Value(Text("JSON response set"));
+            conn->subscribe(std::get<Text>(args[0]));
+            return Value(Bool(true));
         },
         true);
 
-    response_obj->addMethod(
-        "html",
-        [&response](const std::vector<Value>& args, Context& context) {
+    ws_obj->addMethod(
+        "unsubscribe",
+        [weak](const std::vector<Value>& args, Context&) -> Value {
             if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("html() requires HTML string");
+                throw std::runtime_error("unsubscribe() requires a topic string");
             }
-            std::string html_content = std::get<Text>(args[0]);
-            response.body = html_content;
-            response.headers["Content-Type"] = "text/html";
-            return Value(Text("HTML response set"));
-        },
-        true);
-
-    response_obj->addMethod(
-        "text",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("text() requires text string");
+            auto conn = weak.lock();
+            if (!conn) {
+                return Value(Bool(false));
             }
-            std::string text_content = std::get<Text>(args[0]);
-            response.body = text_content;
-            response.headers["Content-Type"] = "text/plain";
-            return Value(Text("Text response set"));
+            conn->unsubscribe(std::get<Text>(args[0]));
+            return Value(Bool(true));
         },
         true);
 
-    response_obj->addMethod(
-        "redirect",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("redirect() requires URL");
-            }
-            std::string location = std::get<Text>(args[0]);
-
-            // Default to 302 Found, but allow custom status code
-            int status_code = 302;
-            if (args.size() > 1 && std::holds_alternative<Int>(args[1])) {
-                status_code = std::get<Int>(args[1]);
-            }
-
-            response.status_code = status_code;
-            response.headers["Location"] = location;
-            response.body = "";
-            return Value(Text("Redirect to " + location));
+    ws_obj->addMethod(
+        "isOpen",
+        [weak](const std::vector<Value>&, Context&) -> Value {
+            auto conn = weak.lock();
+            return Value(Bool(conn && conn->isOpen()));
         },
         true);
 
-    // Utility methods
-    response_obj->addMethod(
-        "getStatus",
-        [&response](const std::vector<Value>& args, Context& context) {
-            return Value(Int(response.status_code));
-        },
+    ws_obj->addMethod(
+        "getId", [id](const std::vector<Value>&, Context&) -> Value { return Value(id); }, true);
+
+    std::string path = connection->path;
+    ws_obj->addMethod(
+        "getPath", [path](const std::vector<Value>&, Context&) -> Value { return Value(path); },
         true);
 
-    response_obj->addMethod(
-        "getHeader",
-        [&response](const std::vector<Value>& args, Context& context) {
+    auto params = connection->params;
+    ws_obj->addMethod(
+        "getParam",
+        [params](const std::vector<Value>& args, Context&) -> Value {
             if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("getHeader() requires a header name");
-            }
-            std::string header_name = std::get<Text>(args[0]);
-            auto it = response.headers.find(header_name);
-            if (it != response.headers.end()) {
-                return Value(Text(it->second));
+                throw std::runtime_error("getParam() requires a parameter name");
             }
-            return Value(Text(""));
+            auto it = params.find(std::get<Text>(args[0]));
+            return Value(Text(it != params.end() ? it->second : ""));
         },
         true);
 
-    response_obj->addMethod(
-        "getBody",
-        [&response](const std::vector<Value>& args, Context& context) {
-            return Value(Text(response.body));
-        },
-        true);
+    connection->script_object = ws_obj;
+    return ws_obj;
+}
 
-    response_obj->addMethod(
-        "send",
-        [&response](const std::vector<Value>& args, Context& context) {
-            if (args.empty() || !std::holds_alternative<Text>(args[0])) {
-                throw std::runtime_error("send() requires response content");
-            }
-            std::string content = std::get<Text>(args[0]);
-            response.body = content;
-            response.sent = true;
-            return Value(Text("Response sent"));
-        },
-        true);
+std::shared_ptr<HttpRequestObject> HttpServerLibrary::createRequestObject(
+    const HttpServerRequest& request) {
+    return std::make_shared<HttpRequestObject>(request);
+}
 
-    return response_obj;
+std::shared_ptr<HttpResponseObject> HttpServerLibrary::createResponseObject(
+    HttpServerResponse& response) {
+    return std::make_shared<HttpResponseObject>(response);
 }
 
-}  // namespace o2l
\ No newline at end of file
+}  // namespace o2l
@@ -17,18 +17,25 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <ctime>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "Context.hpp"
+#include "HttpAccessLog.hpp"
+#include "HttpConnectionHub.hpp"
+#include "HttpRateLimiter.hpp"
+#include "HttpStaticCache.hpp"
 #include "ObjectInstance.hpp"
 #include "Value.hpp"
 
@@ -40,6 +47,11 @@ class HttpServerResponse;
 class Router;
 class ThreadPool;
 class MiddlewareChain;
+class HttpRequestObject;
+class HttpResponseObject;
+class ConnectionHub;
+struct HubConnection;
+class ResponseCache;
 
 // HTTP Server Request structure
 struct HttpServerRequest {
@@ -53,7 +65,13 @@ struct HttpServerRequest {
     std::string remote_address;
     int remote_port;
 
-    HttpServerRequest() : remote_port(0) {}
+    // When the request arrived; its deadline counts from here, so time spent waiting for a
+    // worker is included
+    std::chrono::steady_clock::time_point received_at;
+    // Deadline of the route handler, installed on the handler's Context; null without one
+    std::shared_ptr<CancellationToken> cancellation;
+
+    HttpServerRequest() : remote_port(0), received_at(std::chrono::steady_clock::now()) {}
 };
 
 // HTTP Server Response structure
@@ -65,9 +83,34 @@ struct HttpServerResponse {
     bool sent;
     bool chunked;
 
-    HttpServerResponse() : status_code(200), status_message("OK"), sent(false), chunked(false) {}
+    // Set while a handler runs so it can hand the connection to the hub (sse(), defer());
+    // `stream` is the pending connection the socket is passed to once the handler returns
+    ConnectionHub* hub;
+    std::shared_ptr<HubConnection> stream;
+
+    // Served from a static file cache: sent instead of `body`, with its ready-made headers
+    std::shared_ptr<const StaticBody> static_body;
+
+    HttpServerResponse()
+        : status_code(200), status_message("OK"), sent(false), chunked(false), hub(nullptr) {}
+
+    size_t getBodySize() const {
+        return static_body ? static_body->data.size() : body.size();
+    }
 };
 
+// Reason phrase for an HTTP status code ("Unknown" for codes without a standard phrase)
+const char* httpStatusMessage(int status_code);
+
+// IMF-fixdate as used by the Date header, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string httpDate(std::time_t timestamp);
+
+// Status line and headers as sent on the wire. Content-Length is added unless the response
+// sets it, is informational, streams its body or comes from the static file cache.
+std::string serializeHttpHead(const HttpServerResponse& response, bool keep_alive);
+// Head followed by the body
+std::string serializeHttpResponse(const HttpServerResponse& response, bool keep_alive);
+
 // Route handler function type
 using RouteHandler = std::function<void(const HttpServerRequest&, HttpServerResponse&)>;
 
@@ -75,15 +118,28 @@ using RouteHandler = std::function<void(const HttpServerRequest&, HttpServerResp
 using MiddlewareFunction =
     std::function<void(const HttpServerRequest&, HttpServerResponse&, std::function<void()>)>;
 
+// Native middleware hooks that run without a next() continuation
+using MiddlewareBeforeHook =
+    std::function<bool(HttpServerRequest&, HttpServerResponse&)>;  // false stops the chain
+using MiddlewareAfterHook = std::function<void(const HttpServerRequest&, HttpServerResponse&)>;
+
+// One step of a middleware chain; exactly one of the members is set
+struct MiddlewareStage {
+    MiddlewareFunction around;   // wraps the rest of the chain via next()
+    MiddlewareBeforeHook before;  // runs before the rest of the chain
+    MiddlewareAfterHook after;    // runs after the rest of the chain has finished
+};
+
 // Server configuration
 struct HttpServerConfig {
     std::string host;
     int port;
     int worker_threads;
     int max_connections;
-    int timeout_seconds;
+    int timeout_seconds;  // handler deadline unless the route sets its own; 0 disables
     bool enable_keep_alive;
     bool enable_compression;
+    bool enable_http2;  // cleartext HTTP/2 by prior knowledge or "Upgrade: h2c"
     size_t max_request_size;
 
     HttpServerConfig()
@@ -94,6 +150,7 @@ struct HttpServerConfig {
           timeout_seconds(30),
           enable_keep_alive(true),
           enable_compression(true),
+          enable_http2(true),
           max_request_size(10 * 1024 * 1024) {}  // 10MB default
 };
 
@@ -124,6 +181,13 @@ class ThreadPool {
     std::atomic<size_t> active_threads;
 };
 
+// Per-route settings from the options Map accepted by route registration
+struct RouteOptions {
+    std::chrono::milliseconds timeout{-1};  // negative: the server's timeout; 0: none
+    RateLimit rate_limit;                   // requests to this route
+    bool rate_limit_per_ip = false;         // one bucket per client instead of one in total
+};
+
 // Router for handling URL pattern matching
 class Router {
    public:
@@ -132,32 +196,36 @@ class Router {
         std::string pattern;
         RouteHandler handler;
         std::vector<std::string> param_names;
+        RouteOptions options;
+        std::shared_ptr<RateLimiter> rate_limiter;  // built from options.rate_limit
     };
 
-    void addRoute(const std::string& method, const std::string& pattern, RouteHandler handler);
+    void addRoute(const std::string& method, const std::string& pattern, RouteHandler handler,
+                  RouteOptions options = {});
     bool matchRoute(const std::string& method, const std::string& path, Route& matched_route,
                     std::map<std::string, std::string>& params);
 
-    void get(const std::string& pattern, RouteHandler handler) {
-        addRoute("GET", pattern, handler);
+    void get(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("GET", pattern, handler, options);
     }
-    void post(const std::string& pattern, RouteHandler handler) {
-        addRoute("POST", pattern, handler);
+    void post(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("POST", pattern, handler, options);
     }
-    void put(const std::string& pattern, RouteHandler handler) {
-        addRoute("PUT", pattern, handler);
+    void put(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("PUT", pattern, handler, options);
     }
-    void delete_(const std::string& pattern, RouteHandler handler) {
-        addRoute("DELETE", pattern, handler);
+    void delete_(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("DELETE", pattern, handler, options);
     }
-    void patch(const std::string& pattern, RouteHandler handler) {
-        addRoute("PATCH", pattern, handler);
+    void patch(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("PATCH", pattern, handler, options);
     }
-    void head(const std::string& pattern, RouteHandler handler) {
-        addRoute("HEAD", pattern, handler);
+    void head(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        addRoute("HEAD", pattern, handler, options);
     }
-    void options(const std::string& pattern, RouteHandler handler) {
-        addRoute("OPTIONS", pattern, handler);
+    void options(const std::string& pattern, RouteHandler handler,
+                 RouteOptions route_options = {}) {
+        addRoute("OPTIONS", pattern, handler, route_options);
     }
 
    private:
@@ -170,16 +238,32 @@ class Router {
 };
 
 // Middleware chain for request processing
+//
+// Registered stages are compiled into an immutable flat array (at listen(), or lazily after a
+// later use()). A request walks that array by index with a single reusable next() callback, so
+// no closures are created per middleware per request.
 class MiddlewareChain {
    public:
     void use(MiddlewareFunction middleware);
-    void execute(const HttpServerRequest& request, HttpServerResponse& response,
-                 RouteHandler final_handler);
+    void useStage(MiddlewareStage stage);
+
+    // Freeze the registered stages into the array used by execute()
+    void compile();
+
+    void execute(HttpServerRequest& request, HttpServerResponse& response,
+                 const RouteHandler& final_handler);
+
+    size_t size() const;
 
    private:
-    std::vector<MiddlewareFunction> middlewares;
-    void executeNext(size_t index, const HttpServerRequest& request, HttpServerResponse& response,
-                     RouteHandler final_handler);
+    using CompiledStages = std::vector<MiddlewareStage>;
+    struct Cursor;
+
+    static void run(Cursor& cursor);
+
+    mutable std::mutex stages_mutex;
+    std::vector<MiddlewareStage> stages;
+    std::atomic<std::shared_ptr<const CompiledStages>> compiled;
 };
 
 // Main HTTP Server class
@@ -201,6 +285,8 @@ class HttpServer {
     void setMaxConnections(int max_conn) {
         config.max_connections = max_conn;
     }
+    // Per client address, across all routes; a disabled limit removes it
+    void setRateLimit(const RateLimit& limit);
     void setTimeout(int seconds) {
         config.timeout_seconds = seconds;
     }
@@ -215,35 +301,51 @@ class HttpServer {
     }
 
     // Routing
-    void get(const std::string& pattern, RouteHandler handler) {
-        router.get(pattern, handler);
+    void get(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.get(pattern, handler, options);
     }
-    void post(const std::string& pattern, RouteHandler handler) {
-        router.post(pattern, handler);
+    void post(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.post(pattern, handler, options);
     }
-    void put(const std::string& pattern, RouteHandler handler) {
-        router.put(pattern, handler);
+    void put(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.put(pattern, handler, options);
     }
-    void delete_(const std::string& pattern, RouteHandler handler) {
-        router.delete_(pattern, handler);
+    void delete_(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.delete_(pattern, handler, options);
     }
-    void patch(const std::string& pattern, RouteHandler handler) {
-        router.patch(pattern, handler);
+    void patch(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.patch(pattern, handler, options);
     }
-    void head(const std::string& pattern, RouteHandler handler) {
-        router.head(pattern, handler);
+    void head(const std::string& pattern, RouteHandler handler, RouteOptions options = {}) {
+        router.head(pattern, handler, options);
     }
-    void options(const std::string& pattern, RouteHandler handler) {
-        router.options(pattern, handler);
+    void options(const std::string& pattern, RouteHandler handler,
+                 RouteOptions route_options = {}) {
+        router.options(pattern, handler, route_options);
     }
 
     // Middleware
     void use(MiddlewareFunction middleware) {
         middleware_chain.use(middleware);
     }
-
-    // Static file serving
-    void static_(const std::string& url_path, const std::string& file_path);
+    void useStage(MiddlewareStage stage) {
+        middleware_chain.useStage(std::move(stage));
+    }
+    // Adds the cache's stage at this point of the chain and reports it in getStats()
+    void useResponseCache(std::shared_ptr<ResponseCache> cache);
+    std::vector<std::shared_ptr<ResponseCache>> getResponseCaches();
+
+    // Static file serving; with cache options, files are served from memory
+    void static_(const std::string& url_path, const std::string& file_path,
+                 std::optional<StaticFileCache::Options> cache = std::nullopt);
+    std::vector<std::shared_ptr<StaticFileCache>> getStaticCaches();
+
+    // WebSocket endpoints; upgraded connections are served by the connection hub
+    void websocket(const std::string& pattern, std::shared_ptr<const WebSocketHandlers> handlers);
+    // Event loop for WebSockets, event streams and deferred responses
+    ConnectionHub& getConnectionHub() {
+        return *connection_hub;
+    }
 
     // Server lifecycle
     bool listen();
@@ -256,6 +358,9 @@ class HttpServer {
     // Logging configuration
     void setCustomLogger(std::shared_ptr<ObjectInstance> logger_obj, Context* context);
     void clearCustomLogger();
+    AccessLog& getAccessLog() {
+        return access_log;
+    }
 
     // Statistics
     size_t getActiveConnections() const {
@@ -267,6 +372,15 @@ class HttpServer {
     size_t getErrorCount() const {
         return error_count;
     }
+    size_t getTimeoutCount() const {
+        return timeout_count;
+    }
+    size_t getRateLimitedCount() const {
+        return rate_limited_count;
+    }
+    size_t getRejectedConnections() const {
+        return rejected_connections;
+    }
 
    private:
     HttpServerConfig config;
@@ -279,7 +393,12 @@ class HttpServer {
     std::atomic<size_t> active_connections;
     std::atomic<size_t> total_requests;
     std::atomic<size_t> error_count;
+    std::atomic<size_t> timeout_count;  // requests answered 503/504 at their deadline
+    std::atomic<size_t> rate_limited_count;    // requests answered 429
+    std::atomic<size_t> rejected_connections;  // turned away at accept over max_connections
 
+    // Per-client rate limit; read on every request, replaced by setRateLimit()
+    std::atomic<std::shared_ptr<RateLimiter>> client_rate_limiter;
     // Socket handling
     int server_socket;
     std::thread accept_thread;
@@ -289,6 +408,18 @@ class HttpServer {
     Context* logger_context;
     std::mutex logger_mutex;
 
+    // Access log (written asynchronously by a background drain thread)
+    AccessLog access_log;
+
+    // WebSocket routes, and the event loop that owns connections outliving their request
+    Router websocket_router;
+    std::map<std::string, std::shared_ptr<const WebSocketHandlers>> websocket_handlers;
+    std::mutex websocket_mutex;
+    std::shared_ptr<ConnectionHub> connection_hub;
+    std::vector<std::shared_ptr<StaticFileCache>> static_caches;
+    std::vector<std::shared_ptr<ResponseCache>> response_caches;
+    std::mutex static_mutex;  // guards static_caches and response_caches
+
     // Platform-specific implementations
 #ifdef _WIN32
     void initializeWinsock();
@@ -297,10 +428,32 @@ class HttpServer {
 
     // Core server functionality
     void acceptConnections();
-    void handleConnection(int client_socket);
+    void handleConnection(int client_socket, const std::string& remote_address, int remote_port,
+                          std::chrono::steady_clock::time_point accepted_at);
+    // Answers 503 on a socket the server has no capacity for, without blocking, and closes it
+    void rejectConnection(int client_socket);
+    // Applies the client and route rate limits; false once `response` holds a 429
+    bool admitRequest(const HttpServerRequest& request, const Router::Route* route,
+                      HttpServerResponse& response);
     bool parseHttpRequest(int client_socket, HttpServerRequest& request);
     void sendHttpResponse(int client_socket, const HttpServerResponse& response);
-    void handleRequest(const HttpServerRequest& request, HttpServerResponse& response);
+    // Routes the request under its deadline: 503 if it expired before the handler could
+    // start, 504 if the handler was cancelled at it
+    void handleRequest(HttpServerRequest& request, HttpServerResponse& response);
+
+    // Connection hub: WebSocket upgrades and streamed responses
+    bool startConnectionHub();
+    // Hands a streamed response's socket to the hub; false if the socket is still ours
+    bool handOffStream(int client_socket, HttpServerResponse& response);
+    bool isWebSocketUpgrade(const HttpServerRequest& request) const;
+    // Completes the handshake; true if the socket now belongs to the hub
+    bool acceptWebSocket(int client_socket, HttpServerRequest& request,
+                         const std::string& pattern);
+    bool isHttp2Upgrade(const HttpServerRequest& request) const;
+    // Runs the socket as an HTTP/2 connection on the hub. With `upgrade`, that request was
+    // sent over HTTP/1.1 with "Upgrade: h2c" and becomes stream 1; otherwise `received` holds
+    // the client's connection preface. False if the socket is still ours.
+    bool startHttp2(int client_socket, HttpServerRequest* upgrade, std::string_view received);
 
     // Utility functions
     std::map<std::string, std::string> parseQueryString(const std::string& query);
@@ -311,10 +464,13 @@ class HttpServer {
     // Error handling
     void sendErrorResponse(int client_socket, int status_code, const std::string& message);
     void logError(const std::string& message);
-    void logRequest(const HttpServerRequest& request, const HttpServerResponse& response);
+    void logRequest(const HttpServerRequest& request, const HttpServerResponse& response,
+                    double duration_ms);
+
+    // Delivers a drained access log batch to the custom O²L logger (drain thread)
+    void deliverToCustomLogger(const std::vector<AccessLogRecord>& batch);
 
     // Native logging fallbacks
-    void logRequestNative(const HttpServerRequest& request, const HttpServerResponse& response);
     void logErrorNative(const std::string& message);
 };
 
@@ -335,6 +491,7 @@ class HttpServerLibrary {
     static Value nativeSetPort(const std::vector<Value>& args, Context& context);
     static Value nativeSetWorkerThreads(const std::vector<Value>& args, Context& context);
     static Value nativeSetMaxConnections(const std::vector<Value>& args, Context& context);
+    static Value nativeSetRateLimit(const std::vector<Value>& args, Context& context);
     static Value nativeSetTimeout(const std::vector<Value>& args, Context& context);
     static Value nativeSetKeepAlive(const std::vector<Value>& args, Context& context);
     static Value nativeSetCompression(const std::vector<Value>& args, Context& context);
@@ -353,6 +510,12 @@ class HttpServerLibrary {
 
     // Middleware support
     static Value nativeUse(const std::vector<Value>& args, Context& context);
+    static Value nativeUseBuiltin(const std::vector<Value>& args, Context& context);
+
+    // WebSocket support
+    static Value nativeWebSocket(const std::vector<Value>& args, Context& context);
+    static Value nativeBroadcast(const std::vector<Value>& args, Context& context);
+    static Value nativeSetWebSocketPing(const std::vector<Value>& args, Context& context);
 
     // Response utilities
     static Value nativeSetStatus(const std::vector<Value>& args, Context& context);
@@ -378,17 +541,28 @@ class HttpServerLibrary {
 
     // Logging configuration
     static Value nativeSetLogger(const std::vector<Value>& args, Context& context);
+    static Value nativeSetAccessLog(const std::vector<Value>& args, Context& context);
+    static Value nativeSetLogFormat(const std::vector<Value>& args, Context& context);
+    static Value nativeSetLogSampling(const std::vector<Value>& args, Context& context);
 
    private:
     // Helper methods
     static std::shared_ptr<HttpServer> getServerFromValue(const Value& server_value);
-    static std::shared_ptr<ObjectInstance> createRequestObject(const HttpServerRequest& request);
-    static std::shared_ptr<ObjectInstance> createResponseObject(HttpServerResponse& response);
+    static std::shared_ptr<HttpRequestObject> createRequestObject(const HttpServerRequest& request);
+    static std::shared_ptr<HttpResponseObject> createResponseObject(HttpServerResponse& response);
     static RouteHandler createRouteHandler(const Value& handler_value, Context& context);
+    // Handler from route() arguments after the pattern: (handler) or (object, method), either
+    // optionally followed by an options Map ({"timeout": seconds, "rate": per_second, ...})
+    static RouteHandler createRouteHandlerFromArgs(const std::vector<Value>& args,
+                                                   Context& context, RouteOptions& options);
     static RouteHandler createObjectMethodHandler(const Value& object_value,
                                                   const Value& method_name_value, Context& context);
     static MiddlewareFunction createMiddlewareFunction(const Value& middleware_value,
                                                        Context& context);
+    static std::shared_ptr<const WebSocketHandlers> createWebSocketHandlers(
+        const Value& handler_value, Context& context);
+    static std::shared_ptr<ObjectInstance> getWebSocketObject(
+        const std::shared_ptr<HubConnection>& connection);
 
     // Server registry for managing server instances
     static std::map<std::string, std::shared_ptr<HttpServer>> server_registry;
@@ -0,0 +1,577 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpStaticCache.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "HttpMiddleware.hpp"
+#include "HttpServerLibrary.hpp"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace o2l {
+
+namespace {
+
+constexpr int kGzipLevel = 9;   // only files that will be cached are compressed, once each
+constexpr int kZstdLevel = 19;
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+// "/css/site.css" -> "css/site.css"; false for anything that could leave the root
+bool normalizePath(const std::string& relative_path, std::string& normalized) {
+    size_t start = relative_path.find_first_not_of('/');
+    if (start == std::string::npos) {
+        return false;
+    }
+    normalized = relative_path.substr(start);
+    if (normalized.find('\\') != std::string::npos ||
+        normalized.find('\0') != std::string::npos) {
+        return false;
+    }
+
+    size_t segment_start = 0;
+    while (segment_start <= normalized.size()) {
+        size_t segment_end = normalized.find('/', segment_start);
+        if (segment_end == std::string::npos) {
+            segment_end = normalized.size();
+        }
+        std::string_view segment(normalized.data() + segment_start, segment_end - segment_start);
+        if (segment.empty() || segment == "." || segment == "..") {
+            return false;
+        }
+        segment_start = segment_end + 1;
+    }
+    return true;
+}
+
+bool isCompressible(const std::string& mime_type) {
+    return mime_type.rfind("text/", 0) == 0 || mime_type.find("json") != std::string::npos ||
+           mime_type.find("javascript") != std::string::npos ||
+           mime_type.find("xml") != std::string::npos ||
+           mime_type.find("svg") != std::string::npos || mime_type == "application/wasm";
+}
+
+uint64_t fnv1a(const std::string& data) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool zstdCompress(const std::string& input, std::string& output) {
+#ifdef HAVE_ZSTD
+    output.resize(ZSTD_compressBound(input.size()));
+    size_t written = ZSTD_compress(output.data(), output.size(), input.data(), input.size(),
+                                   kZstdLevel);
+    if (ZSTD_isError(written)) {
+        return false;
+    }
+    output.resize(written);
+    return true;
+#else
+    (void)input;
+    (void)output;
+    return false;
+#endif
+}
+
+// Whether an If-None-Match list names this ETag (weak comparison, RFC 9110 13.1.2)
+bool etagMatches(const std::string& header, const std::string& etag) {
+    std::istringstream tokens(header);
+    std::string token;
+    while (std::getline(tokens, token, ',')) {
+        token = trim(token);
+        if (token == "*") {
+            return true;
+        }
+        if (token.rfind("W/", 0) == 0) {
+            token.erase(0, 2);
+        }
+        if (token == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void addField(StaticBody& body, const char* name, const std::string& value) {
+    body.header_block.append(name).append(": ").append(value).append("\r\n");
+    body.fields.emplace_back(name, value);
+}
+
+}  // namespace
+
+size_t StaticAsset::getMemoryUsage() const {
+    size_t total = sizeof(StaticAsset) + etag.size() + last_modified.size() + mime_type.size();
+    for (const StaticBody* body : {&identity, &gzip, &zstd, &not_modified}) {
+        total += body->data.size() + 2 * body->header_block.size();
+    }
+    return total;
+}
+
+StaticFileCache::StaticFileCache(std::string root, Options options)
+    : root_(std::move(root)), options_(options) {
+    while (root_.size() > 1 && root_.back() == '/') {
+        root_.pop_back();
+    }
+}
+
+StaticFileCache::~StaticFileCache() {
+    stop();
+}
+
+bool StaticFileCache::isSafePath(const std::string& relative_path) {
+    std::string normalized;
+    return normalizePath(relative_path, normalized);
+}
+
+bool StaticFileCache::isZstdAvailable() {
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string StaticFileCache::mimeType(const std::string& path) {
+    size_t dot_pos = path.find_last_of('.');
+    if (dot_pos == std::string::npos || path.find('/', dot_pos) != std::string::npos) {
+        return "application/octet-stream";
+    }
+
+    static const std::unordered_map<std::string, std::string> mime_types = {
+        {"html", "text/html"},         {"htm", "text/html"},
+        {"css", "text/css"},           {"js", "application/javascript"},
+        {"mjs", "application/javascript"},
+        {"json", "application/json"},  {"map", "application/json"},
+        {"xml", "application/xml"},    {"txt", "text/plain"},
+        {"csv", "text/csv"},           {"md", "text/markdown"},
+        {"png", "image/png"},          {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},        {"gif", "image/gif"},
+        {"svg", "image/svg+xml"},      {"ico", "image/x-icon"},
+        {"webp", "image/webp"},        {"avif", "image/avif"},
+        {"pdf", "application/pdf"},    {"zip", "application/zip"},
+        {"gz", "application/gzip"},    {"wasm", "application/wasm"},
+        {"woff", "font/woff"},         {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},           {"otf", "font/otf"},
+        {"mp4", "video/mp4"},          {"webm", "video/webm"},
+        {"mp3", "audio/mpeg"},         {"wav", "audio/wav"}};
+
+    auto it = mime_types.find(toLower(path.substr(dot_pos + 1)));
+    return it != mime_types.end() ? it->second : "application/octet-stream";
+}
+
+StaticFileCache::Encoding StaticFileCache::negotiate(const std::string& accept_encoding,
+                                                     const StaticAsset& asset) {
+    bool zstd = false;
+    bool gzip = false;
+    std::istringstream tokens(toLower(accept_encoding));
+    std::string token;
+    while (std::getline(tokens, token, ',')) {
+        std::string coding = trim(token.substr(0, token.find(';')));
+        // An explicit q=0 means "not acceptable"
+        size_t q = token.find("q=");
+        if (q != std::string::npos && std::strtod(token.c_str() + q + 2, nullptr) <= 0.0) {
+            continue;
+        }
+        zstd = zstd || coding == "zstd" || coding == "*";
+        gzip = gzip || coding == "gzip" || coding == "x-gzip" || coding == "*";
+    }
+
+    if (zstd && !asset.zstd.data.empty()) {
+        return Encoding::Zstd;
+    }
+    if (gzip && !asset.gzip.data.empty()) {
+        return Encoding::Gzip;
+    }
+    return Encoding::Identity;
+}
+
+std::shared_ptr<const StaticAsset> StaticFileCache::load(const std::string& relative_path,
+                                                         uint64_t generation) const {
+    std::string full_path = root_ + "/" + relative_path;
+    struct stat info {};
+    if (::stat(full_path.c_str(), &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG ||
+        static_cast<size_t>(info.st_size) > options_.max_file_size) {
+        return nullptr;
+    }
+
+    auto asset = std::make_shared<StaticAsset>();
+    asset->size = static_cast<size_t>(info.st_size);
+    asset->mtime = info.st_mtime;
+    {
+        std::ifstream file(full_path, std::ios::binary);
+        if (!file.is_open()) {
+            return nullptr;
+        }
+        asset->identity.data.resize(asset->size);
+        file.read(asset->identity.data.data(), static_cast<std::streamsize>(asset->size));
+        asset->identity.data.resize(static_cast<size_t>(file.gcount()));
+        asset->size = asset->identity.data.size();
+    }
+
+    char etag[48];
+    std::snprintf(etag, sizeof(etag), "\"%zx-%016llx\"", asset->size,
+                  static_cast<unsigned long long>(fnv1a(asset->identity.data)));
+    asset->etag = etag;
+    asset->last_modified = httpDate(asset->mtime);
+    asset->mime_type = mimeType(relative_path);
+
+    // A file that will not be kept (budget spent, or changed while being read) is served
+    // once as read; compressing it would cost far more than sending it uncompressed
+    bool kept = generation_.load(std::memory_order_acquire) == generation &&
+                memory_used_.load(std::memory_order_relaxed) + asset->size <= options_.max_memory;
+    if (kept && options_.compress && asset->size > 0 && isCompressible(asset->mime_type)) {
+        std::string compressed;
+        if (BuiltinMiddleware::gzipCompress(asset->identity.data, compressed, kGzipLevel) &&
+            compressed.size() < asset->size) {
+            asset->gzip.data = std::move(compressed);
+        }
+        compressed.clear();
+        if (zstdCompress(asset->identity.data, compressed) && compressed.size() < asset->size) {
+            asset->zstd.data = std::move(compressed);
+        }
+    }
+
+    // Every header the response needs, built once
+    bool varies = !asset->gzip.data.empty() || !asset->zstd.data.empty();
+    std::string cache_control =
+        options_.max_age >= 0 ? "public, max-age=" + std::to_string(options_.max_age) : "";
+    auto validators = [&](StaticBody& body) {
+        addField(body, "ETag", asset->etag);
+        addField(body, "Last-Modified", asset->last_modified);
+        if (!cache_control.empty()) {
+            addField(body, "Cache-Control", cache_control);
+        }
+        if (varies) {
+            addField(body, "Vary", "Accept-Encoding");
+        }
+    };
+    auto describe = [&](StaticBody& body, const char* encoding) {
+        if (body.data.empty() && encoding) {
+            return;
+        }
+        addField(body, "Content-Type", asset->mime_type);
+        addField(body, "Content-Length", std::to_string(body.data.size()));
+        if (encoding) {
+            addField(body, "Content-Encoding", encoding);
+        }
+        validators(body);
+    };
+    describe(asset->identity, nullptr);
+    describe(asset->gzip, "gzip");
+    describe(asset->zstd, "zstd");
+    validators(asset->not_modified);
+    return asset;
+}
+
+std::shared_ptr<const StaticAsset> StaticFileCache::get(const std::string& relative_path) {
+    std::string key;
+    if (!normalizePath(relative_path, key)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const StaticAsset> asset;
+    {
+        std::shared_lock<std::shared_mutex> lock(entries_mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            asset = it->second;
+        }
+    }
+
+    // Without a watcher, a hit costs one stat to catch changed files
+    if (asset && !isWatching()) {
+        struct stat info {};
+        std::string full_path = root_ + "/" + key;
+        if (::stat(full_path.c_str(), &info) != 0 || info.st_mtime != asset->mtime ||
+            static_cast<size_t>(info.st_size) != asset->size) {
+            invalidate(key);
+            asset.reset();
+        }
+    }
+    if (asset) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return asset;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    asset = load(key, generation);
+    if (!asset) {
+        return nullptr;
+    }
+
+    // Keep it unless the budget is spent or the file changed while it was being read
+    size_t usage = asset->getMemoryUsage();
+    std::unique_lock<std::shared_mutex> lock(entries_mutex_);
+    if (generation_.load(std::memory_order_acquire) != generation ||
+        memory_used_.load(std::memory_order_relaxed) + usage > options_.max_memory) {
+        return asset;
+    }
+    auto [it, inserted] = entries_.emplace(key, asset);
+    if (inserted) {
+        memory_used_.fetch_add(usage, std::memory_order_relaxed);
+    }
+    return it->second;
+}
+
+bool StaticFileCache::serve(const std::string& relative_path, const HttpServerRequest& request,
+                            HttpServerResponse& response) {
+    auto asset = get(relative_path);
+    if (!asset) {
+        return false;
+    }
+
+    // Conditional requests: If-None-Match wins over If-Modified-Since
+    bool not_modified = false;
+    auto none_match = request.headers.find("if-none-match");
+    if (none_match != request.headers.end()) {
+        not_modified = etagMatches(none_match->second, asset->etag);
+    } else {
+        auto modified_since = request.headers.find("if-modified-since");
+        not_modified = modified_since != request.headers.end() &&
+                       modified_since->second == asset->last_modified;
+    }
+
+    const StaticBody* body = &asset->not_modified;
+    if (not_modified) {
+        response.status_code = 304;
+    } else {
+        auto accept = request.headers.find("accept-encoding");
+        Encoding encoding = accept != request.headers.end()
+                                ? negotiate(accept->second, *asset)
+                                : Encoding::Identity;
+        body = encoding == Encoding::Zstd   ? &asset->zstd
+               : encoding == Encoding::Gzip ? &asset->gzip
+                                            : &asset->identity;
+        response.status_code = 200;
+    }
+    response.status_message = httpStatusMessage(response.status_code);
+    response.body.clear();
+    // Shares ownership of the whole asset, so an invalidated entry lives until sent
+    response.static_body = std::shared_ptr<const StaticBody>(asset, body);
+    return true;
+}
+
+void StaticFileCache::invalidate(const std::string& relative_path) {
+    std::string key;
+    if (!normalizePath(relative_path, key)) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(entries_mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        memory_used_.fetch_sub(it->second->getMemoryUsage(), std::memory_order_relaxed);
+        entries_.erase(it);
+    }
+}
+
+void StaticFileCache::invalidatePrefix(const std::string& relative_dir) {
+    std::string prefix = relative_dir.empty() ? "" : relative_dir + "/";
+    std::unique_lock<std::shared_mutex> lock(entries_mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            memory_used_.fetch_sub(it->second->getMemoryUsage(), std::memory_order_relaxed);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t StaticFileCache::getEntryCount() const {
+    std::shared_lock<std::shared_mutex> lock(entries_mutex_);
+    return entries_.size();
+}
+
+void StaticFileCache::preload(const std::string& relative_dir) {
+    std::error_code error;
+    std::filesystem::path base(root_);
+    std::filesystem::recursive_directory_iterator it(base / relative_dir, error), end;
+    for (; !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(error)) {
+            get(std::filesystem::relative(it->path(), base, error).generic_string());
+        }
+    }
+}
+
+#ifdef __linux__
+
+void StaticFileCache::start() {
+    if (options_.preload) {
+        preload("");
+    }
+    if (isWatching()) {
+        return;
+    }
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || wake_fd_ < 0) {
+        stop();
+        return;  // falls back to checking the file on every hit
+    }
+    addWatch("");
+    if (watch_dirs_.empty()) {
+        stop();
+        return;
+    }
+
+    watching_.store(true, std::memory_order_release);
+    watch_thread_ = std::thread([this]() { watchLoop(); });
+}
+
+void StaticFileCache::stop() {
+    if (watching_.exchange(false, std::memory_order_acq_rel)) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+    }
+    if (watch_thread_.joinable()) {
+        watch_thread_.join();
+    }
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    watch_dirs_.clear();
+}
+
+void StaticFileCache::addWatch(const std::string& relative_dir) {
+    constexpr uint32_t kMask = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                               IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+    std::string path = relative_dir.empty() ? root_ : root_ + "/" + relative_dir;
+    int wd = inotify_add_watch(inotify_fd_, path.c_str(), kMask);
+    if (wd < 0) {
+        return;
+    }
+    watch_dirs_[wd] = relative_dir;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(path, error), end; !error && it != end;
+         it.increment(error)) {
+        if (it->is_directory(error) && !it->is_symlink(error)) {
+            std::string name = it->path().filename().string();
+            addWatch(relative_dir.empty() ? name : relative_dir + "/" + name);
+        }
+    }
+}
+
+void StaticFileCache::watchLoop() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+
+    while (watching_.load(std::memory_order_acquire)) {
+        if (::poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN)) {
+            continue;  // woken by stop(), or interrupted
+        }
+
+        ssize_t length;
+        while ((length = ::read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length;) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    invalidatePrefix("");  // events were lost; start over
+                    continue;
+                }
+                auto dir = watch_dirs_.find(event->wd);
+                if (dir == watch_dirs_.end()) {
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watch_dirs_.erase(dir);
+                    continue;
+                }
+                if (event->len == 0) {
+                    continue;  // the directory itself; its files get their own events
+                }
+
+                std::string name(event->name);
+                std::string path = dir->second.empty() ? name : dir->second + "/" + name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        addWatch(path);
+                    }
+                    invalidatePrefix(path);
+                    continue;
+                }
+
+                invalidate(path);
+                // Preloaded directories stay warm: reload once the writer is done
+                if (options_.preload && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                    get(path);
+                }
+            }
+        }
+    }
+}
+
+#else  // !__linux__
+
+void StaticFileCache::start() {
+    if (options_.preload) {
+        preload("");
+    }
+}
+
+void StaticFileCache::stop() {}
+void StaticFileCache::addWatch(const std::string&) {}
+void StaticFileCache::watchLoop() {}
+
+#endif
+
+}  // namespace o2l
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace o2l {
+
+struct HttpServerRequest;
+struct HttpServerResponse;
+
+// One encoding of a cached file: the bytes on the wire and the headers that describe them,
+// both as a ready-made HTTP/1.1 block and as fields for HTTP/2
+struct StaticBody {
+    std::string data;
+    std::string header_block;  // "Content-Type: ...\r\nContent-Length: ...\r\n..."
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+struct StaticAsset {
+    std::string etag;
+    std::string last_modified;
+    std::string mime_type;
+    std::time_t mtime = 0;
+    size_t size = 0;
+
+    StaticBody identity;
+    StaticBody gzip;          // empty unless smaller than identity
+    StaticBody zstd;          // empty unless built with zstd and smaller than identity
+    StaticBody not_modified;  // headers for 304 responses
+
+    size_t getMemoryUsage() const;
+};
+
+/**
+ * In-memory store for one static directory.
+ *
+ * Files are read once (at start() with `preload`, otherwise on first request) and kept with
+ * their ETag, MIME type, compressed variants and response headers already built, so a hit is
+ * a hash lookup and a single writev of the header block and body. On Linux the directory is
+ * watched with inotify and changed files are dropped from the cache; elsewhere each hit
+ * re-checks the file's size and modification time.
+ */
+class StaticFileCache {
+   public:
+    struct Options {
+        bool preload = false;
+        bool compress = true;                 // build gzip/zstd variants for text types
+        size_t max_file_size = 1024 * 1024;   // larger files are always read from disk
+        size_t max_memory = 64 * 1024 * 1024; // files beyond the budget are read from disk
+        int max_age = -1;                     // Cache-Control max-age; negative: no header
+    };
+
+    enum class Encoding { Identity, Gzip, Zstd };
+
+    StaticFileCache(std::string root, Options options);
+    ~StaticFileCache();
+
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    // Preload if configured and start watching the directory
+    void start();
+    void stop();
+
+    // Fill `response` from the cache: 200 with the best encoding the client accepts, or 304
+    // when its validators match. False if the file is missing or not cacheable.
+    bool serve(const std::string& relative_path, const HttpServerRequest& request,
+               HttpServerResponse& response);
+
+    // Cached entry, loading it on a miss; nullptr if the file is missing or not cacheable
+    std::shared_ptr<const StaticAsset> get(const std::string& relative_path);
+    void invalidate(const std::string& relative_path);
+
+    // Rejects absolute paths, empty segments and ".." so requests stay inside the root
+    static bool isSafePath(const std::string& relative_path);
+    static Encoding negotiate(const std::string& accept_encoding, const StaticAsset& asset);
+    static std::string mimeType(const std::string& path);
+    static bool isZstdAvailable();
+
+    bool isWatching() const {
+        return watching_.load(std::memory_order_acquire);
+    }
+    size_t getEntryCount() const;
+    size_t getMemoryUsage() const {
+        return memory_used_.load(std::memory_order_relaxed);
+    }
+    size_t getHits() const {
+        return hits_.load(std::memory_order_relaxed);
+    }
+    size_t getMisses() const {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // Compressed variants are only built when the asset can still be cached: within the
+    // memory budget and with no invalidation since `generation`
+    std::shared_ptr<const StaticAsset> load(const std::string& relative_path,
+                                            uint64_t generation) const;
+    void preload(const std::string& relative_dir);
+    void watchLoop();
+    void addWatch(const std::string& relative_dir);
+    void invalidatePrefix(const std::string& relative_dir);
+
+    std::string root_;
+    Options options_;
+
+    mutable std::shared_mutex entries_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const StaticAsset>> entries_;
+    std::atomic<size_t> memory_used_{0};
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<uint64_t> generation_{0};  // bumped by every invalidation
+
+    // inotify watcher (Linux)
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+    std::unordered_map<int, std::string> watch_dirs_;  // watch descriptor -> relative dir
+    std::thread watch_thread_;
+    std::atomic<bool> watching_{false};
+};
+
+}  // namespace o2l
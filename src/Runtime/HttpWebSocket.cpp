@@ -0,0 +1,315 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HttpWebSocket.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace o2l {
+
+namespace websocket {
+
+namespace {
+
+// Compact SHA-1, only used for the handshake accept key
+std::string sha1(const std::string& input) {
+    uint32_t h0 = 0x67452301, h1 = 0xEFCDAB89, h2 = 0x98BADCFE, h3 = 0x10325476, h4 = 0xC3D2E1F0;
+
+    std::string message = input;
+    uint64_t bit_length = static_cast<uint64_t>(input.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56) {
+        message.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i) {
+        message.push_back(static_cast<char>((bit_length >> (i * 8)) & 0xFF));
+    }
+
+    auto rotl = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const unsigned char*>(message.data() + chunk + i * 4);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) |
+                   uint32_t(p[3]);
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h0, b = h1, c = h2, d = h3, e = h4;
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        h0 += a;
+        h1 += b;
+        h2 += c;
+        h3 += d;
+        h4 += e;
+    }
+
+    std::string digest;
+    for (uint32_t h : {h0, h1, h2, h3, h4}) {
+        for (int i = 3; i >= 0; --i) {
+            digest.push_back(static_cast<char>((h >> (i * 8)) & 0xFF));
+        }
+    }
+    return digest;
+}
+
+std::string base64Encode(const std::string& input) {
+    static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((input.size() + 2) / 3 * 4);
+
+    for (size_t i = 0; i < input.size(); i += 3) {
+        size_t remaining = std::min<size_t>(3, input.size() - i);
+        uint32_t triple = static_cast<unsigned char>(input[i]) << 16;
+        if (remaining > 1) triple |= static_cast<unsigned char>(input[i + 1]) << 8;
+        if (remaining > 2) triple |= static_cast<unsigned char>(input[i + 2]);
+
+        encoded.push_back(chars[(triple >> 18) & 0x3F]);
+        encoded.push_back(chars[(triple >> 12) & 0x3F]);
+        encoded.push_back(remaining > 1 ? chars[(triple >> 6) & 0x3F] : '=');
+        encoded.push_back(remaining > 2 ? chars[triple & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+bool isKnownOpcode(uint8_t opcode) {
+    return opcode <= 0x2 || (opcode >= 0x8 && opcode <= 0xA);
+}
+
+}  // namespace
+
+ParseStatus parseFrame(const char* data, size_t size, size_t max_payload, Frame& frame,
+                       size_t& consumed) {
+    if (size < 2) {
+        return ParseStatus::Incomplete;
+    }
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    bool fin = bytes[0] & 0x80;
+    uint8_t opcode = bytes[0] & 0x0F;
+
+    // No extensions are negotiated, so reserved bits must be clear
+    if ((bytes[0] & 0x70) != 0 || !isKnownOpcode(opcode)) {
+        return ParseStatus::ProtocolError;
+    }
+    // Clients must mask every frame (RFC 6455 5.1)
+    if (!(bytes[1] & 0x80)) {
+        return ParseStatus::ProtocolError;
+    }
+
+    uint64_t length = bytes[1] & 0x7F;
+    size_t header = 2;
+    if (length == 126) {
+        if (size < 4) return ParseStatus::Incomplete;
+        length = (uint64_t(bytes[2]) << 8) | bytes[3];
+        header = 4;
+    } else if (length == 127) {
+        if (size < 10) return ParseStatus::Incomplete;
+        length = 0;
+        for (int i = 2; i < 10; ++i) {
+            length = (length << 8) | bytes[i];
+        }
+        if (length >> 63) {
+            return ParseStatus::ProtocolError;
+        }
+        header = 10;
+    }
+
+    bool control = opcode & 0x8;
+    if (control && (!fin || length > 125)) {
+        return ParseStatus::ProtocolError;
+    }
+    if (length > max_payload) {
+        return ParseStatus::TooBig;
+    }
+
+    header += 4;  // masking key
+    if (size < header + length) {
+        return ParseStatus::Incomplete;
+    }
+
+    frame.fin = fin;
+    frame.opcode = static_cast<Opcode>(opcode);
+    frame.payload.assign(data + header, static_cast<size_t>(length));
+    applyMask(frame.payload.data(), frame.payload.size(), bytes + header - 4);
+    consumed = header + static_cast<size_t>(length);
+    return ParseStatus::Complete;
+}
+
+std::string encodeFrame(Opcode opcode, std::string_view payload, bool fin) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>((fin ? 0x80 : 0x00) | static_cast<uint8_t>(opcode)));
+
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int i = 7; i >= 0; --i) {
+            frame.push_back(static_cast<char>((uint64_t(payload.size()) >> (i * 8)) & 0xFF));
+        }
+    }
+
+    frame.append(payload);
+    return frame;
+}
+
+std::string encodeCloseFrame(int code, std::string_view reason) {
+    std::string payload;
+    payload.push_back(static_cast<char>((code >> 8) & 0xFF));
+    payload.push_back(static_cast<char>(code & 0xFF));
+    payload.append(reason.substr(0, 123));
+    return encodeFrame(Opcode::Close, payload);
+}
+
+void applyMask(char* data, size_t size, const uint8_t mask[4]) {
+    // Every step below advances by a multiple of 4, so the key stays in phase
+    uint32_t key32;
+    std::memcpy(&key32, mask, 4);
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i key256 = _mm256_set1_epi32(static_cast<int>(key32));
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i),
+                            _mm256_xor_si256(chunk, key256));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i key128 = _mm_set1_epi32(static_cast<int>(key32));
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(chunk, key128));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t key128 = vreinterpretq_u8_u32(vdupq_n_u32(key32));
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(data + i), veorq_u8(chunk, key128));
+    }
+#endif
+
+    const uint64_t key64 = (uint64_t(key32) << 32) | key32;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        word ^= key64;
+        std::memcpy(data + i, &word, 8);
+    }
+    for (; i < size; ++i) {
+        data[i] = static_cast<char>(data[i] ^ mask[i & 3]);
+    }
+}
+
+bool isValidUtf8(std::string_view text) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    size_t i = 0;
+
+    while (i < size) {
+        // Skip ASCII runs a word at a time
+        while (i + 8 <= size) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, 8);
+            if (word & 0x8080808080808080ULL) break;
+            i += 8;
+        }
+        if (i >= size) break;
+
+        unsigned char c = bytes[i];
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+
+        size_t length;
+        uint32_t code_point;
+        if ((c & 0xE0) == 0xC0) {
+            length = 2;
+            code_point = c & 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            length = 3;
+            code_point = c & 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            length = 4;
+            code_point = c & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > size) {
+            return false;
+        }
+        for (size_t j = 1; j < length; ++j) {
+            if ((bytes[i + j] & 0xC0) != 0x80) return false;
+            code_point = (code_point << 6) | (bytes[i + j] & 0x3F);
+        }
+
+        // Reject overlong encodings, surrogates and values beyond U+10FFFF
+        static const uint32_t kMinimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code_point < kMinimum[length] || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+std::string computeAcceptKey(const std::string& client_key) {
+    static const std::string kGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    return base64Encode(sha1(client_key + kGuid));
+}
+
+}  // namespace websocket
+
+}  // namespace o2l
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace o2l {
+
+// RFC 6455 framing primitives
+namespace websocket {
+
+enum class Opcode : uint8_t {
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+// Close status codes used by the server
+constexpr int kCloseNormal = 1000;
+constexpr int kCloseGoingAway = 1001;
+constexpr int kCloseProtocolError = 1002;
+constexpr int kCloseNoStatus = 1005;
+constexpr int kCloseAbnormal = 1006;
+constexpr int kCloseInvalidPayload = 1007;
+constexpr int kCloseMessageTooBig = 1009;
+
+struct Frame {
+    bool fin = true;
+    Opcode opcode = Opcode::Text;
+    std::string payload;  // unmasked
+};
+
+enum class ParseStatus { Incomplete, Complete, ProtocolError, TooBig };
+
+// Parse one client frame from data. On Complete, `consumed` is the frame length in bytes.
+// Client frames must be masked; reserved bits and oversized control frames are rejected.
+ParseStatus parseFrame(const char* data, size_t size, size_t max_payload, Frame& frame,
+                       size_t& consumed);
+
+// Encode an unmasked server frame
+std::string encodeFrame(Opcode opcode, std::string_view payload, bool fin = true);
+std::string encodeCloseFrame(int code, std::string_view reason = {});
+
+// XOR data with the 4-byte masking key, vectorized where the target supports it
+void applyMask(char* data, size_t size, const uint8_t mask[4]);
+
+bool isValidUtf8(std::string_view text);
+
+// Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+std::string computeAcceptKey(const std::string& client_key);
+
+}  // namespace websocket
+
+struct HubConnection;
+
+// Script-facing callbacks for one WebSocket route; any of them may be empty
+struct WebSocketHandlers {
+    std::function<void(const std::shared_ptr<HubConnection>&)> on_open;
+    std::function<void(const std::shared_ptr<HubConnection>&, const std::string&, bool)>
+        on_message;  // (connection, message, is_binary)
+    std::function<void(const std::shared_ptr<HubConnection>&, int)> on_close;
+};
+
+}  // namespace o2l
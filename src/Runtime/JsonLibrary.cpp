@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <functional>
 #include <iomanip>
 #include <regex>
@@ -26,6 +27,7 @@
 #include "../Common/Exceptions.hpp"
 #include "ListInstance.hpp"
 #include "MapInstance.hpp"
+#include "NumberConversion.hpp"
 
 namespace o2l {
 
@@ -1193,19 +1195,29 @@ JsonValue JsonLibrary::parseJsonNumber(std::istringstream& stream) {
         numStr += stream.get();
     }
 
-    while (stream.peek() != EOF && (std::isdigit(stream.peek()) || stream.peek() == '.')) {
+    bool integral = true;
+    while (stream.peek() != EOF) {
+        c = static_cast<char>(stream.peek());
+        if (c == '.' || c == 'e' || c == 'E') {
+            integral = false;
+        } else if (!std::isdigit(static_cast<unsigned char>(c)) &&
+                   !((c == '+' || c == '-') && !numStr.empty() &&
+                     (numStr.back() == 'e' || numStr.back() == 'E'))) {
+            break;
+        }
         numStr += stream.get();
     }
 
-    try {
-        if (numStr.find('.') != std::string::npos) {
-            return JsonValue(std::stod(numStr));
-        } else {
-            return JsonValue(static_cast<Int>(std::stoll(numStr)));
+    // Integers too large for Int are kept as Double, as JSON numbers have no fixed range
+    if (integral) {
+        if (auto number = numeric::parseInt(numStr)) {
+            return JsonValue(*number);
         }
-    } catch (const std::exception&) {
-        throw std::runtime_error("Invalid number: " + numStr);
     }
+    if (auto number = numeric::parseDouble(numStr)) {
+        return JsonValue(*number);
+    }
+    throw std::runtime_error("Invalid number: " + numStr);
 }
 
 std::string JsonLibrary::stringifyJsonValue(const JsonValue& value, int indent) {
@@ -1214,9 +1226,11 @@ std::string JsonLibrary::stringifyJsonValue(const JsonValue& value, int indent)
     } else if (std::holds_alternative<Bool>(value)) {
         return std::get<Bool>(value) ? "true" : "false";
     } else if (std::holds_alternative<Int>(value)) {
-        return std::to_string(std::get<Int>(value));
+        return numeric::formatInt(std::get<Int>(value));
     } else if (std::holds_alternative<Double>(value)) {
-        return std::to_string(std::get<Double>(value));
+        // JSON has no infinities or NaN
+        Double number = std::get<Double>(value);
+        return std::isfinite(number) ? numeric::formatDouble(number) : "null";
     } else if (std::holds_alternative<Text>(value)) {
         return "\"" + escapeJsonString(std::get<Text>(value)) + "\"";
     } else if (std::holds_alternative<std::vector<JsonValue>>(value)) {
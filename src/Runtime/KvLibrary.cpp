@@ -0,0 +1,788 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "KvLibrary.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../Common/Exceptions.hpp"
+#include "Context.hpp"
+#include "MapInstance.hpp"
+#include "NativeTableObject.hpp"
+
+namespace o2l {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', '2', 'L', 'K', 'V', '0', '0', '1'};
+constexpr size_t kFrameHeaderSize = 8;  // payload size and CRC-32, both uint32
+constexpr size_t kEntryHeaderSize = 9;  // op, key size, value size
+constexpr size_t kDataFrameSize = 1 << 20;
+// The log is folded into the data file once it is this large and twice the live data
+constexpr size_t kMinCompactionBytes = 4 << 20;
+
+enum : uint8_t { kPut = 0, kErase = 1 };
+
+constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+uint32_t crc32(const char* data, size_t size) {
+    static constexpr std::array<uint32_t, 256> kTable = makeCrcTable();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = kTable[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putUint32(std::string& out, size_t offset, uint32_t value) {
+    std::memcpy(&out[offset], &value, sizeof(value));
+}
+
+uint32_t getUint32(const char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Frames are built in place: a header placeholder, entries, then sealFrame() fills the header
+void beginFrame(std::string& out) {
+    out.append(kFrameHeaderSize, '\0');
+}
+
+void appendEntry(std::string& out, uint8_t op, std::string_view key, std::string_view value) {
+    size_t offset = out.size();
+    out.append(kEntryHeaderSize, '\0');
+    out[offset] = static_cast<char>(op);
+    putUint32(out, offset + 1, static_cast<uint32_t>(key.size()));
+    putUint32(out, offset + 5, static_cast<uint32_t>(value.size()));
+    out.append(key);
+    out.append(value);
+}
+
+void sealFrame(std::string& out, size_t frame_start) {
+    size_t payload = frame_start + kFrameHeaderSize;
+    putUint32(out, frame_start, static_cast<uint32_t>(out.size() - payload));
+    putUint32(out, frame_start + 4, crc32(out.data() + payload, out.size() - payload));
+}
+
+std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+}
+
+void writeAll(int fd, const std::string& bytes, const std::string& path) {
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw ioError("Cannot write", path);
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+void syncFile(int fd, const std::string& path) {
+    if (::fsync(fd) != 0) {
+        throw ioError("Cannot sync", path);
+    }
+}
+
+// Applies one entry to the table, keeping the live byte count
+void applyEntry(KvStore::Table& table, size_t& live_bytes, uint8_t op, std::string_view key,
+                std::string_view value) {
+    auto it = table.find(key);
+    if (it != table.end()) {
+        live_bytes -= it->first.size() + it->second.size();
+        if (op == kErase) {
+            table.erase(it);
+            return;
+        }
+        it->second.assign(value);
+        live_bytes += key.size() + value.size();
+        return;
+    }
+    if (op == kPut) {
+        table.emplace(std::string(key), std::string(value));
+        live_bytes += key.size() + value.size();
+    }
+}
+
+}  // namespace
+
+KvStore::KvStore(const std::string& directory, bool durable)
+    : directory_(directory), durable_(durable), table_(std::make_shared<Table>()) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        throw std::runtime_error("Cannot create '" + directory_ + "': " + error.message());
+    }
+
+    // Another process appending to the same log would interleave frames, and its
+    // compaction would replace the data file under this one
+    std::string lock_path = directory_ + "/LOCK";
+    lock_fd_ = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd_ < 0) {
+        throw ioError("Cannot open", lock_path);
+    }
+    if (::flock(lock_fd_, LOCK_EX | LOCK_NB) != 0) {
+        bool held = errno == EWOULDBLOCK;
+        std::runtime_error failure =
+            held ? std::runtime_error("Key-value store '" + directory_ +
+                                      "' is already open in another process")
+                 : ioError("Cannot lock", lock_path);
+        ::close(lock_fd_);
+        lock_fd_ = -1;
+        throw failure;
+    }
+
+    std::string wal_path = directory_ + "/wal.kv";
+    try {
+        load(directory_ + "/data.kv", false);
+        load(wal_path, true);
+
+        wal_fd_ = ::open(wal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (wal_fd_ < 0) {
+            throw ioError("Cannot open", wal_path);
+        }
+        if (wal_bytes_ == 0) {
+            if (::ftruncate(wal_fd_, 0) != 0) {
+                throw ioError("Cannot truncate", wal_path);
+            }
+            writeAll(wal_fd_, std::string(kMagic, sizeof(kMagic)), wal_path);
+            wal_bytes_ = sizeof(kMagic);
+        }
+    } catch (...) {
+        // The destructor does not run for a failed constructor
+        if (wal_fd_ >= 0) {
+            ::close(wal_fd_);
+        }
+        ::close(lock_fd_);
+        throw;
+    }
+}
+
+KvStore::~KvStore() {
+    close();
+}
+
+// Reads a data or log file into the table. Frames that fail their checksum end the file: a
+// torn log tail is cut off, while a damaged data file (only ever replaced by rename) is fatal.
+void KvStore::load(const std::string& path, bool truncate_torn_tail) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() < sizeof(kMagic)) {
+        if (!truncate_torn_tail && !bytes.empty()) {
+            throw std::runtime_error("Corrupt key-value data file '" + path + "'");
+        }
+        return;
+    }
+    if (std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("'" + path + "' is not a key-value store file");
+    }
+
+    size_t offset = sizeof(kMagic);
+    while (offset < bytes.size()) {
+        const char* frame = bytes.data() + offset;
+        size_t available = bytes.size() - offset;
+        if (available < kFrameHeaderSize ||
+            getUint32(frame) > available - kFrameHeaderSize ||
+            crc32(frame + kFrameHeaderSize, getUint32(frame)) != getUint32(frame + 4)) {
+            break;
+        }
+        const char* entry = frame + kFrameHeaderSize;
+        const char* end = entry + getUint32(frame);
+        while (entry < end) {
+            size_t key_size = getUint32(entry + 1);
+            size_t value_size = getUint32(entry + 5);
+            std::string_view key(entry + kEntryHeaderSize, key_size);
+            std::string_view value(key.data() + key_size, value_size);
+            applyEntry(*table_, live_bytes_, static_cast<uint8_t>(entry[0]), key, value);
+            entry = value.data() + value_size;
+        }
+        offset += kFrameHeaderSize + getUint32(frame);
+    }
+
+    if (offset < bytes.size()) {
+        if (!truncate_torn_tail) {
+            throw std::runtime_error("Corrupt key-value data file '" + path + "'");
+        }
+        std::filesystem::resize_file(path, offset);
+    }
+    if (truncate_torn_tail) {
+        wal_bytes_ = offset;
+    }
+}
+
+std::optional<std::string> KvStore::get(std::string_view key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    auto it = table_->find(key);
+    if (it == table_->end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void KvStore::apply(const std::vector<Mutation>& mutations) {
+    if (mutations.empty()) {
+        return;
+    }
+    std::string frame;
+    beginFrame(frame);
+    for (const auto& mutation : mutations) {
+        appendEntry(frame, mutation.erase ? kErase : kPut, mutation.key, mutation.value);
+    }
+    sealFrame(frame, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    std::string wal_path = directory_ + "/wal.kv";
+    try {
+        writeAll(wal_fd_, frame, wal_path);
+        if (durable_) {
+            syncFile(wal_fd_, wal_path);
+        }
+    } catch (...) {
+        // Drop a partial frame so later appends stay readable
+        if (::ftruncate(wal_fd_, static_cast<off_t>(wal_bytes_)) != 0) {
+            // The torn frame fails its checksum on the next open
+        }
+        throw;
+    }
+    wal_bytes_ += frame.size();
+
+    // Snapshots keep the current table; give them a copy to themselves
+    if (table_.use_count() > 1) {
+        table_ = std::make_shared<Table>(*table_);
+    }
+    for (const auto& mutation : mutations) {
+        applyEntry(*table_, live_bytes_, mutation.erase ? kErase : kPut, mutation.key,
+                   mutation.value);
+    }
+
+    if (wal_bytes_ > kMinCompactionBytes && wal_bytes_ > 2 * live_bytes_) {
+        compactLocked();
+    }
+}
+
+std::shared_ptr<const KvStore::Table> KvStore::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    return table_;
+}
+
+size_t KvStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    return table_->size();
+}
+
+void KvStore::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    compactLocked();
+}
+
+// Writes the table to a new data file, renames it over the old one and then empties the log.
+// A crash in between replays the old log over the new data, which leaves the same state.
+void KvStore::compactLocked() {
+    std::string data_path = directory_ + "/data.kv";
+    std::string temp_path = data_path + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw ioError("Cannot create", temp_path);
+    }
+    try {
+        std::string buffer(kMagic, sizeof(kMagic));
+        size_t frame_start = buffer.size();
+        beginFrame(buffer);
+        for (const auto& [key, value] : *table_) {
+            appendEntry(buffer, kPut, key, value);
+            if (buffer.size() - frame_start >= kDataFrameSize) {
+                sealFrame(buffer, frame_start);
+                writeAll(fd, buffer, temp_path);
+                buffer.clear();
+                frame_start = 0;
+                beginFrame(buffer);
+            }
+        }
+        if (buffer.size() - frame_start > kFrameHeaderSize) {
+            sealFrame(buffer, frame_start);
+        } else {
+            buffer.resize(frame_start);
+        }
+        writeAll(fd, buffer, temp_path);
+        syncFile(fd, temp_path);
+    } catch (...) {
+        ::close(fd);
+        std::filesystem::remove(temp_path);
+        throw;
+    }
+    ::close(fd);
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, data_path, error);
+    if (error) {
+        throw std::runtime_error("Cannot replace '" + data_path + "': " + error.message());
+    }
+    int directory_fd = ::open(directory_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (directory_fd >= 0) {
+        ::fsync(directory_fd);
+        ::close(directory_fd);
+    }
+
+    std::string wal_path = directory_ + "/wal.kv";
+    if (::ftruncate(wal_fd_, 0) != 0) {
+        throw ioError("Cannot truncate", wal_path);
+    }
+    writeAll(wal_fd_, std::string(kMagic, sizeof(kMagic)), wal_path);
+    if (durable_) {
+        syncFile(wal_fd_, wal_path);
+    }
+    wal_bytes_ = sizeof(kMagic);
+}
+
+void KvStore::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requireOpen();
+    syncFile(wal_fd_, directory_ + "/wal.kv");
+}
+
+void KvStore::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wal_fd_ >= 0) {
+        ::fsync(wal_fd_);
+        ::close(wal_fd_);
+        wal_fd_ = -1;
+    }
+    if (lock_fd_ >= 0) {
+        ::close(lock_fd_);  // releases the flock
+        lock_fd_ = -1;
+    }
+}
+
+bool KvStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wal_fd_ >= 0;
+}
+
+void KvStore::requireOpen() const {
+    if (wal_fd_ < 0) {
+        throw std::runtime_error("Key-value store '" + directory_ + "' is closed");
+    }
+}
+
+namespace {
+
+const Text& requireText(const std::vector<Value>& args, size_t index, const char* where,
+                        const Context& context) {
+    if (args.size() <= index || !std::holds_alternative<Text>(args[index])) {
+        throw EvaluationError(std::string(where) + ": argument " + std::to_string(index + 1) +
+                                  " must be Text",
+                              context);
+    }
+    return std::get<Text>(args[index]);
+}
+
+void requireArgumentCount(const std::vector<Value>& args, size_t min, size_t max,
+                          const char* where, const Context& context) {
+    if (args.size() < min || args.size() > max) {
+        std::string expected = std::to_string(min);
+        if (max != min) {
+            expected += " to " + std::to_string(max);
+        }
+        throw EvaluationError(std::string(where) + " expects " + expected + " arguments, got " +
+                                  std::to_string(args.size()),
+                              context);
+    }
+}
+
+// Runs a store operation, reporting I/O errors and use after close as O²L errors
+template <typename Operation>
+auto guarded(const char* where, const Context& context, Operation&& operation) {
+    try {
+        return operation();
+    } catch (const std::runtime_error& e) {
+        if (dynamic_cast<const o2lException*>(&e)) {
+            throw;
+        }
+        throw EvaluationError(std::string(where) + ": " + e.what(), context);
+    }
+}
+
+Value lookup(const KvStore::Table& table, const std::vector<Value>& args, const char* where,
+             const Context& context) {
+    requireArgumentCount(args, 1, 2, where, context);
+    const Text& key = requireText(args, 0, where, context);
+    auto it = table.find(key);
+    if (it != table.end()) {
+        return Text(it->second);
+    }
+    if (args.size() == 2) {
+        return args[1];
+    }
+    throw EvaluationError(std::string(where) + ": key '" + key + "' not found", context);
+}
+
+// Entries of a table from `from`, up to `to` (exclusive) or while keys start with `prefix`
+class KvIterator : public NativeTableObject<KvIterator> {
+   public:
+    KvIterator(std::shared_ptr<const KvStore::Table> table, const std::string& from,
+               std::optional<std::string> to, std::optional<std::string> prefix)
+        : NativeTableObject("KvIterator"),
+          table_(std::move(table)),
+          current_(table_->lower_bound(from)),
+          to_(std::move(to)),
+          prefix_(std::move(prefix)) {}
+
+    static const std::array<NativeMethodEntry<KvIterator>, 2> kMethods;
+
+    static Value hasNext(KvIterator& self, const std::vector<Value>&, Context&) {
+        return Bool(self.valid());
+    }
+
+    // The next entry as a Map with "key" and "value"
+    static Value next(KvIterator& self, const std::vector<Value>&, Context& context) {
+        if (!self.valid()) {
+            throw EvaluationError("KvIterator.next(): no more entries", context);
+        }
+        auto entry = std::make_shared<MapInstance>("Text", "Text");
+        entry->put(Text("key"), Text(self.current_->first));
+        entry->put(Text("value"), Text(self.current_->second));
+        ++self.current_;
+        return entry;
+    }
+
+   private:
+    bool valid() const {
+        if (current_ == table_->end()) {
+            return false;
+        }
+        if (to_ && current_->first >= *to_) {
+            return false;
+        }
+        return !prefix_ || current_->first.compare(0, prefix_->size(), *prefix_) == 0;
+    }
+
+    std::shared_ptr<const KvStore::Table> table_;
+    KvStore::Table::const_iterator current_;
+    std::optional<std::string> to_;
+    std::optional<std::string> prefix_;
+};
+
+const std::array<NativeMethodEntry<KvIterator>, 2> KvIterator::kMethods = {{
+    {"hasNext", &KvIterator::hasNext},
+    {"next", &KvIterator::next},
+}};
+
+// scan(from, [to]) and prefix(prefix) over a table
+Value scanTable(std::shared_ptr<const KvStore::Table> table, const std::vector<Value>& args,
+                const char* where, const Context& context) {
+    requireArgumentCount(args, 1, 2, where, context);
+    std::optional<std::string> to;
+    if (args.size() == 2) {
+        to = requireText(args, 1, where, context);
+    }
+    return std::shared_ptr<ObjectInstance>(std::make_shared<KvIterator>(
+        std::move(table), requireText(args, 0, where, context), std::move(to), std::nullopt));
+}
+
+Value prefixTable(std::shared_ptr<const KvStore::Table> table, const std::vector<Value>& args,
+                  const char* where, const Context& context) {
+    requireArgumentCount(args, 1, 1, where, context);
+    const Text& prefix = requireText(args, 0, where, context);
+    return std::shared_ptr<ObjectInstance>(
+        std::make_shared<KvIterator>(std::move(table), prefix, std::nullopt, prefix));
+}
+
+// A fixed view of a store at the time it was taken
+class KvSnapshot : public NativeTableObject<KvSnapshot> {
+   public:
+    explicit KvSnapshot(std::shared_ptr<const KvStore::Table> table)
+        : NativeTableObject("KvSnapshot"), table_(std::move(table)) {}
+
+    static const std::array<NativeMethodEntry<KvSnapshot>, 5> kMethods;
+
+    static Value get(KvSnapshot& self, const std::vector<Value>& args, Context& context) {
+        return lookup(*self.table_, args, "KvSnapshot.get()", context);
+    }
+
+    static Value has(KvSnapshot& self, const std::vector<Value>& args, Context& context) {
+        requireArgumentCount(args, 1, 1, "KvSnapshot.has()", context);
+        return Bool(self.table_->count(requireText(args, 0, "KvSnapshot.has()", context)) != 0);
+    }
+
+    static Value prefix(KvSnapshot& self, const std::vector<Value>& args, Context& context) {
+        return prefixTable(self.table_, args, "KvSnapshot.prefix()", context);
+    }
+
+    static Value scan(KvSnapshot& self, const std::vector<Value>& args, Context& context) {
+        return scanTable(self.table_, args, "KvSnapshot.scan()", context);
+    }
+
+    static Value size(KvSnapshot& self, const std::vector<Value>&, Context&) {
+        return Int(self.table_->size());
+    }
+
+   private:
+    std::shared_ptr<const KvStore::Table> table_;
+};
+
+const std::array<NativeMethodEntry<KvSnapshot>, 5> KvSnapshot::kMethods = {{
+    {"get", &KvSnapshot::get},
+    {"has", &KvSnapshot::has},
+    {"prefix", &KvSnapshot::prefix},
+    {"scan", &KvSnapshot::scan},
+    {"size", &KvSnapshot::size},
+}};
+
+// Puts and deletes collected and then written to the store as one atomic frame
+class KvBatch : public NativeTableObject<KvBatch> {
+   public:
+    explicit KvBatch(std::shared_ptr<KvStore> store)
+        : NativeTableObject("KvBatch"), store_(std::move(store)) {}
+
+    static const std::array<NativeMethodEntry<KvBatch>, 5> kMethods;
+
+    static Value clear(KvBatch& self, const std::vector<Value>&, Context&) {
+        self.mutations_.clear();
+        return Bool(true);
+    }
+
+    // Applies every operation, or none of them; the batch is empty afterwards
+    static Value commit(KvBatch& self, const std::vector<Value>&, Context& context) {
+        guarded("KvBatch.commit()", context, [&]() { self.store_->apply(self.mutations_); });
+        Int count = static_cast<Int>(self.mutations_.size());
+        self.mutations_.clear();
+        return count;
+    }
+
+    static Value del(KvBatch& self, const std::vector<Value>& args, Context& context) {
+        requireArgumentCount(args, 1, 1, "KvBatch.delete()", context);
+        self.mutations_.push_back({true, requireText(args, 0, "KvBatch.delete()", context), {}});
+        return Bool(true);
+    }
+
+    static Value put(KvBatch& self, const std::vector<Value>& args, Context& context) {
+        requireArgumentCount(args, 2, 2, "KvBatch.put()", context);
+        self.mutations_.push_back({false, requireText(args, 0, "KvBatch.put()", context),
+                                   requireText(args, 1, "KvBatch.put()", context)});
+        return Bool(true);
+    }
+
+    static Value size(KvBatch& self, const std::vector<Value>&, Context&) {
+        return Int(self.mutations_.size());
+    }
+
+   private:
+    std::shared_ptr<KvStore> store_;
+    std::vector<KvStore::Mutation> mutations_;
+};
+
+const std::array<NativeMethodEntry<KvBatch>, 5> KvBatch::kMethods = {{
+    {"clear", &KvBatch::clear},
+    {"commit", &KvBatch::commit},
+    {"delete", &KvBatch::del},
+    {"put", &KvBatch::put},
+    {"size", &KvBatch::size},
+}};
+
+class KvStoreObject : public NativeTableObject<KvStoreObject> {
+   public:
+    explicit KvStoreObject(std::shared_ptr<KvStore> store)
+        : NativeTableObject("KvStore"), store_(std::move(store)) {}
+
+    static const std::array<NativeMethodEntry<KvStoreObject>, 13> kMethods;
+
+    static Value batch(KvStoreObject& self, const std::vector<Value>&, Context& context) {
+        guarded("KvStore.batch()", context, [&]() { return self.store_->size(); });
+        return std::shared_ptr<ObjectInstance>(std::make_shared<KvBatch>(self.store_));
+    }
+
+    static Value close(KvStoreObject& self, const std::vector<Value>&, Context&) {
+        self.store_->close();
+        return Bool(true);
+    }
+
+    static Value compact(KvStoreObject& self, const std::vector<Value>&, Context& context) {
+        guarded("KvStore.compact()", context, [&]() { self.store_->compact(); });
+        return Bool(true);
+    }
+
+    static Value del(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        const char* where = "KvStore.delete()";
+        requireArgumentCount(args, 1, 1, where, context);
+        const Text& key = requireText(args, 0, where, context);
+        return guarded(where, context, [&]() {
+            if (!self.store_->get(key)) {
+                return Bool(false);
+            }
+            self.store_->apply({{true, key, {}}});
+            return Bool(true);
+        });
+    }
+
+    static Value get(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        const char* where = "KvStore.get()";
+        requireArgumentCount(args, 1, 2, where, context);
+        const Text& key = requireText(args, 0, where, context);
+        auto value = guarded(where, context, [&]() { return self.store_->get(key); });
+        if (value) {
+            return Text(std::move(*value));
+        }
+        if (args.size() == 2) {
+            return args[1];
+        }
+        throw EvaluationError(std::string(where) + ": key '" + key + "' not found", context);
+    }
+
+    static Value has(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        requireArgumentCount(args, 1, 1, "KvStore.has()", context);
+        const Text& key = requireText(args, 0, "KvStore.has()", context);
+        return Bool(guarded("KvStore.has()", context,
+                            [&]() { return self.store_->get(key).has_value(); }));
+    }
+
+    static Value isOpen(KvStoreObject& self, const std::vector<Value>&, Context&) {
+        return Bool(self.store_->isOpen());
+    }
+
+    static Value prefix(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        return prefixTable(self.snapshotOf("KvStore.prefix()", context), args,
+                           "KvStore.prefix()", context);
+    }
+
+    static Value put(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        const char* where = "KvStore.put()";
+        requireArgumentCount(args, 2, 2, where, context);
+        std::vector<KvStore::Mutation> mutation = {
+            {false, requireText(args, 0, where, context), requireText(args, 1, where, context)}};
+        guarded(where, context, [&]() { self.store_->apply(mutation); });
+        return Bool(true);
+    }
+
+    static Value scan(KvStoreObject& self, const std::vector<Value>& args, Context& context) {
+        return scanTable(self.snapshotOf("KvStore.scan()", context), args, "KvStore.scan()",
+                         context);
+    }
+
+    static Value size(KvStoreObject& self, const std::vector<Value>&, Context& context) {
+        return Int(guarded("KvStore.size()", context, [&]() { return self.store_->size(); }));
+    }
+
+    static Value snapshot(KvStoreObject& self, const std::vector<Value>&, Context& context) {
+        return std::shared_ptr<ObjectInstance>(
+            std::make_shared<KvSnapshot>(self.snapshotOf("KvStore.snapshot()", context)));
+    }
+
+    static Value sync(KvStoreObject& self, const std::vector<Value>&, Context& context) {
+        guarded("KvStore.sync()", context, [&]() { self.store_->sync(); });
+        return Bool(true);
+    }
+
+   private:
+    std::shared_ptr<const KvStore::Table> snapshotOf(const char* where, const Context& context) {
+        return guarded(where, context, [&]() { return store_->snapshot(); });
+    }
+
+    std::shared_ptr<KvStore> store_;
+};
+
+const std::array<NativeMethodEntry<KvStoreObject>, 13> KvStoreObject::kMethods = {{
+    {"batch", &KvStoreObject::batch},
+    {"close", &KvStoreObject::close},
+    {"compact", &KvStoreObject::compact},
+    {"delete", &KvStoreObject::del},
+    {"get", &KvStoreObject::get},
+    {"has", &KvStoreObject::has},
+    {"isOpen", &KvStoreObject::isOpen},
+    {"prefix", &KvStoreObject::prefix},
+    {"put", &KvStoreObject::put},
+    {"scan", &KvStoreObject::scan},
+    {"size", &KvStoreObject::size},
+    {"snapshot", &KvStoreObject::snapshot},
+    {"sync", &KvStoreObject::sync},
+}};
+
+// One KvStore per directory in the process, so two open() calls never append to the same log
+std::shared_ptr<KvStore> openStore(const std::string& directory, bool durable) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<KvStore>> stores;
+
+    std::string key =
+        std::filesystem::weakly_canonical(std::filesystem::absolute(directory)).string();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto store = stores[key].lock(); store && store->isOpen()) {
+        return store;
+    }
+    auto store = std::make_shared<KvStore>(directory, durable);
+    stores[key] = store;
+    return store;
+}
+
+}  // namespace
+
+std::shared_ptr<ObjectInstance> KvLibrary::createKvObject() {
+    auto kv = std::make_shared<ObjectInstance>("kv");
+
+    // open(directory, [durable]): the store in `directory`, created if missing
+    Method open_method = [](const std::vector<Value>& args, Context& context) -> Value {
+        const char* where = "kv.open()";
+        requireArgumentCount(args, 1, 2, where, context);
+        const Text& directory = requireText(args, 0, where, context);
+        bool durable = false;
+        if (args.size() == 2) {
+            if (!std::holds_alternative<Bool>(args[1])) {
+                throw EvaluationError("kv.open(): argument 2 must be Bool", context);
+            }
+            durable = std::get<Bool>(args[1]);
+        }
+        auto store = guarded(where, context, [&]() { return openStore(directory, durable); });
+        return std::shared_ptr<ObjectInstance>(std::make_shared<KvStoreObject>(std::move(store)));
+    };
+    kv->addMethod("open", open_method, true);
+
+    return kv;
+}
+
+}  // namespace o2l
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+/**
+ * An embedded, ordered, persistent key-value store: the table lives in memory, every write
+ * is first appended to a write-ahead log as one checksummed frame, and the log is folded
+ * into a compacted data file once it outgrows the live data.
+ *
+ * A store is a directory holding data.kv, wal.kv and LOCK, on which an open store holds an
+ * exclusive flock so only one process uses it at a time. Opening it loads the data file and
+ * replays the log; a frame torn by a crash fails its checksum and is dropped with everything
+ * after it, so a batch is applied entirely or not at all. Writes reach the OS before they
+ * return; with `durable` they are also fsynced.
+ *
+ * Readers get snapshots that share the table: the first write after a snapshot was taken
+ * copies it, so snapshots and iterators see a fixed state and never block writers.
+ */
+class KvStore {
+   public:
+    using Table = std::map<std::string, std::string, std::less<>>;
+
+    struct Mutation {
+        bool erase;
+        std::string key;
+        std::string value;
+    };
+
+    // Opens or creates the store in `directory`; throws std::runtime_error on I/O errors or
+    // when another process has the store open
+    explicit KvStore(const std::string& directory, bool durable = false);
+    ~KvStore();
+
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    std::optional<std::string> get(std::string_view key) const;
+    // Logs and applies `mutations` atomically, in order
+    void apply(const std::vector<Mutation>& mutations);
+    std::shared_ptr<const Table> snapshot() const;
+    size_t size() const;
+
+    // Rewrites the data file from the table and empties the log
+    void compact();
+    void sync();
+    void close();
+    bool isOpen() const;
+
+   private:
+    void load(const std::string& path, bool truncate_torn_tail);
+    void writeFrames(int fd, const std::vector<Mutation>& mutations) const;
+    void compactLocked();
+    void requireOpen() const;
+
+    std::string directory_;
+    bool durable_;
+    int wal_fd_ = -1;
+    int lock_fd_ = -1;
+    size_t wal_bytes_ = 0;
+    size_t live_bytes_ = 0;
+    std::shared_ptr<Table> table_;
+    mutable std::mutex mutex_;
+};
+
+class KvLibrary {
+   public:
+    // Create the kv module object
+    static std::shared_ptr<ObjectInstance> createKvObject();
+};
+
+}  // namespace o2l
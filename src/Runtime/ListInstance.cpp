@@ -20,12 +20,17 @@
 #include <sstream>
 
 #include "../Common/Exceptions.hpp"
+#include "ExecutionBudget.hpp"
 
 namespace o2l {
 
-ListInstance::ListInstance(const std::string& element_type) : element_type_name_(element_type) {}
+ListInstance::ListInstance(const std::string& element_type) : element_type_name_(element_type) {
+    HeapProfiler::recordAllocation(heap_samples_, sizeof(ListInstance), "List");
+}
 
 void ListInstance::add(const Value& element) {
+    ExecutionBudget::chargeStoredValue(element);
+    HeapProfiler::recordStoredValue(heap_samples_, element, "List");
     elements_.push_back(element);
 }
 
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "HeapProfiler.hpp"
 #include "Value.hpp"
 
 namespace o2l {
@@ -28,6 +29,7 @@ class ListInstance {
    private:
     std::vector<Value> elements_;
     std::string element_type_name_;
+    HeapSamples heap_samples_;
 
    public:
     ListInstance(const std::string& element_type = "Value");
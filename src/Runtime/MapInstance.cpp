@@ -19,14 +19,21 @@
 #include <sstream>
 
 #include "../Common/Exceptions.hpp"
+#include "ExecutionBudget.hpp"
 #include "Value.hpp"
 
 namespace o2l {
 
 MapInstance::MapInstance(const std::string& key_type, const std::string& value_type)
-    : key_type_name_(key_type), value_type_name_(value_type) {}
+    : key_type_name_(key_type), value_type_name_(value_type) {
+    HeapProfiler::recordAllocation(heap_samples_, sizeof(MapInstance), "Map");
+}
 
 void MapInstance::put(const Value& key, const Value& value) {
+    ExecutionBudget::chargeStoredValue(key);
+    ExecutionBudget::chargeStoredValue(value);
+    HeapProfiler::recordStoredValue(heap_samples_, key, "Map");
+    HeapProfiler::recordStoredValue(heap_samples_, value, "Map");
     entries_[key] = value;
 }
 
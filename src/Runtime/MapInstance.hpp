@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "HeapProfiler.hpp"
 #include "Value.hpp"
 
 namespace o2l {
@@ -30,6 +31,7 @@ class MapInstance {
     std::map<Value, Value> entries_;
     std::string key_type_name_;
     std::string value_type_name_;
+    HeapSamples heap_samples_;
 
    public:
     MapInstance(const std::string& key_type = "Value", const std::string& value_type = "Value");
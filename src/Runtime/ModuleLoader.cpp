@@ -29,9 +29,11 @@
 #include "HttpClientLibrary.hpp"
 #include "HttpServerLibrary.hpp"
 #include "JsonLibrary.hpp"
+#include "KvLibrary.hpp"
 #include "MathLibrary.hpp"
 #include "ObjectInstance.hpp"
 #include "RegexpLibrary.hpp"
+#include "SqliteLibrary.hpp"
 #include "SystemLibrary.hpp"
 #include "TestLibrary.hpp"
 #include "UrlLibrary.hpp"
@@ -55,6 +57,8 @@ ModuleLoader::ModuleLoader() {
 void ModuleLoader::addSearchPath(const std::filesystem::path& path) {
     if (std::filesystem::exists(path) && std::filesystem::is_directory(path)) {
         module_search_paths_.push_back(path);
+        native_libraries_.addSearchPath(path);
+        native_libraries_.addSearchPath(path / ".o2l" / "lib" / "native");
     }
 }
 
@@ -261,6 +265,10 @@ Value ModuleLoader::loadMethod(const ImportPath& import_path, Context& context)
 }
 
 Value ModuleLoader::resolveImportRecursively(const ImportPath& import_path, Context& context) {
+    if (isNativeLibraryImport(import_path)) {
+        return loadNativeLibrary(import_path.object_name);
+    }
+
     // Check if this is a native system module first (only for system imports)
     if (!import_path.is_user_import && isNativeSystemModule(import_path)) {
         auto native_object = createNativeSystemModule(import_path.object_name);
@@ -381,6 +389,10 @@ Value ModuleLoader::resolveImportRecursively(const ImportPath& import_path, Cont
 
 std::map<std::string, Value> ModuleLoader::loadAllMethods(const ImportPath& import_path,
                                                           Context& context) {
+    if (isNativeLibraryImport(import_path)) {
+        return {{import_path.object_name, loadNativeLibrary(import_path.object_name)}};
+    }
+
     // Check if this is a native system module first
     if (isNativeSystemModule(import_path)) {
         auto native_object = createNativeSystemModule(import_path.object_name);
@@ -411,6 +423,10 @@ bool ModuleLoader::moduleExists(const ImportPath& import_path) {
     if (isNativeSystemModule(import_path)) {
         return true;
     }
+    if (isNativeLibraryImport(import_path)) {
+        return native_libraries_.isLibraryLoaded(import_path.object_name) ||
+               native_libraries_.loadLibrary(import_path.object_name);
+    }
 
     try {
         findModuleFile(import_path.package_path, import_path.object_name,
@@ -470,6 +486,17 @@ bool ModuleLoader::isNativeSystemModule(const ImportPath& import_path) {
         return true;
     }
 
+    // Check if this is a direct kv import
+    if (import_path.package_path.empty() && import_path.object_name == "kv") {
+        return true;
+    }
+
+    // Check if this is a db.sqlite import
+    if (import_path.package_path.size() == 1 && import_path.package_path[0] == "db" &&
+        import_path.object_name == "sqlite") {
+        return true;
+    }
+
     // Check if this is a direct ffi import
     if (import_path.package_path.empty() && import_path.object_name == "ffi") {
         return true;
@@ -478,6 +505,19 @@ bool ModuleLoader::isNativeSystemModule(const ImportPath& import_path) {
     return false;
 }
 
+bool ModuleLoader::isNativeLibraryImport(const ImportPath& import_path) const {
+    return !import_path.is_user_import && import_path.package_path.size() == 1 &&
+           import_path.package_path[0] == "native";
+}
+
+std::shared_ptr<ObjectInstance> ModuleLoader::loadNativeLibrary(const std::string& library_name) {
+    if (!native_libraries_.isLibraryLoaded(library_name) &&
+        !native_libraries_.loadLibrary(library_name)) {
+        throw EvaluationError("Cannot load native library '" + library_name + "'");
+    }
+    return native_libraries_.createNativeObject(library_name);
+}
+
 std::shared_ptr<ObjectInstance> ModuleLoader::createNativeSystemModule(
     const std::string& module_name) {
     if (module_name == "io") {
@@ -504,6 +544,10 @@ std::shared_ptr<ObjectInstance> ModuleLoader::createNativeSystemModule(
         return HttpClientLibrary::createHttpClientObject();
     } else if (module_name == "server") {
         return HttpServerLibrary::createHttpServerObject();
+    } else if (module_name == "kv") {
+        return KvLibrary::createKvObject();
+    } else if (module_name == "sqlite") {
+        return SqliteLibrary::createSqliteObject();
     } else if (module_name == "ffi") {
         return FFILibrary::createFFIObject();
     }
@@ -511,4 +555,12 @@ std::shared_ptr<ObjectInstance> ModuleLoader::createNativeSystemModule(
     throw EvaluationError("Unknown native module: " + module_name);
 }
 
+std::vector<std::string> ModuleLoader::getLoadedModuleFiles() const {
+    std::vector<std::string> files;
+    for (const auto& [module_key, objects] : loaded_modules_) {
+        files.push_back(module_key);
+    }
+    return files;
+}
+
 }  // namespace o2l
\ No newline at end of file
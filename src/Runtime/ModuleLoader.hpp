@@ -23,6 +23,7 @@
 
 #include "../AST/ImportNode.hpp"
 #include "Context.hpp"
+#include "DynamicLibraryManager.hpp"
 #include "Value.hpp"
 
 // Forward declaration
@@ -53,6 +54,11 @@ class ModuleLoader {
     std::shared_ptr<ObjectInstance> createNativeSystemModule(const std::string& module_name);
     bool isNativeSystemModule(const ImportPath& import_path);
 
+    // Native libraries (`import native.<name>`), found next to the search paths
+    DynamicLibraryManager native_libraries_;
+    bool isNativeLibraryImport(const ImportPath& import_path) const;
+    std::shared_ptr<ObjectInstance> loadNativeLibrary(const std::string& library_name);
+
    public:
     ModuleLoader();
 
@@ -67,6 +73,19 @@ class ModuleLoader {
 
     // Check if a module exists
     bool moduleExists(const ImportPath& import_path);
+
+    // Native libraries available to `import native.<name>`; hosts can register linked ones
+    DynamicLibraryManager& getNativeLibraries() {
+        return native_libraries_;
+    }
+
+    // Paths of the user module files loaded so far
+    std::vector<std::string> getLoadedModuleFiles() const;
+
+    // Parsed user modules loaded so far, by module key
+    const std::map<std::string, std::vector<ASTNodePtr>>& getLoadedModuleASTs() const {
+        return module_ast_storage_;
+    }
 };
 
 }  // namespace o2l
\ No newline at end of file
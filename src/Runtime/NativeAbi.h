@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Native library ABI, version 2: plain C, for extensions written in any language that can
+ * export C symbols.
+ *
+ * A library exports one function, o2l_native_library_v2(), returning a static table of its
+ * methods. O²L programs load it with `import native.<name>` (lib<name>.so / .dylib / .dll in
+ * .o2l/lib/native, next to the program or in the system library directories) and call the
+ * methods on the imported object; a call goes straight to the method's function pointer.
+ *
+ * Arguments are Int, Double (Float widened), Bool or Text values, and only live for the
+ * duration of the call. A method stores its result in *result and returns O2L_NATIVE_OK, or
+ * stores a Text message there and returns O2L_NATIVE_ERROR to raise an O²L error. Text
+ * results must stay valid until the next call into the library on the same thread (a static
+ * or thread-local buffer will do); the runtime copies them at once.
+ *
+ * O2L_NATIVE_PURE marks methods whose result depends only on their arguments and that have
+ * no side effects: calls with constant arguments are evaluated once per call site and reused.
+ * O2L_NATIVE_NOTHROW promises that a method never returns O2L_NATIVE_ERROR.
+ */
+
+#ifndef O2L_NATIVE_ABI_H
+#define O2L_NATIVE_ABI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define O2L_NATIVE_ABI_VERSION 2
+
+/* Name of the exported entry point, an o2l_native_entry */
+#define O2L_NATIVE_ENTRY_SYMBOL "o2l_native_library_v2"
+
+typedef enum {
+    O2L_NATIVE_INT,
+    O2L_NATIVE_DOUBLE,
+    O2L_NATIVE_BOOL,
+    O2L_NATIVE_TEXT
+} o2l_native_type;
+
+typedef struct {
+    const char* data; /* not necessarily NUL-terminated */
+    size_t size;
+} o2l_native_text;
+
+typedef struct {
+    o2l_native_type type;
+    union {
+        int64_t as_int;
+        double as_double;
+        int as_bool;
+        o2l_native_text as_text;
+    };
+} o2l_native_value;
+
+typedef enum { O2L_NATIVE_OK = 0, O2L_NATIVE_ERROR = 1 } o2l_native_status;
+
+typedef o2l_native_status (*o2l_native_function)(const o2l_native_value* args, size_t count,
+                                                 o2l_native_value* result);
+
+enum {
+    O2L_NATIVE_PURE = 1u << 0,
+    O2L_NATIVE_NOTHROW = 1u << 1
+};
+
+typedef struct {
+    const char* name;
+    int arity; /* number of arguments, or -1 for any */
+    o2l_native_function function;
+    unsigned flags;
+} o2l_native_method;
+
+typedef struct {
+    uint32_t abi_version; /* O2L_NATIVE_ABI_VERSION */
+    const char* name;
+    const char* version;
+    const o2l_native_method* methods;
+    size_t method_count;
+} o2l_native_library;
+
+typedef const o2l_native_library* (*o2l_native_entry)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* O2L_NATIVE_ABI_H */
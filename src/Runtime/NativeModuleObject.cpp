@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NativeModuleObject.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../Common/Exceptions.hpp"
+#include "Context.hpp"
+
+namespace o2l {
+
+NativeModule::NativeModule(const o2l_native_library& library, std::shared_ptr<void> handle)
+    : name_(library.name ? library.name : ""),
+      version_(library.version ? library.version : ""),
+      handle_(std::move(handle)) {
+    if (library.abi_version != O2L_NATIVE_ABI_VERSION) {
+        throw EvaluationError("Native library '" + name_ + "' uses ABI version " +
+                              std::to_string(library.abi_version) + ", expected " +
+                              std::to_string(O2L_NATIVE_ABI_VERSION));
+    }
+    if (name_.empty() || (library.method_count > 0 && !library.methods)) {
+        throw EvaluationError("Native library table is missing its name or methods");
+    }
+
+    methods_.reserve(library.method_count);
+    for (size_t i = 0; i < library.method_count; ++i) {
+        const o2l_native_method& method = library.methods[i];
+        if (!method.name || !method.function || method.arity < -1) {
+            throw EvaluationError("Native library '" + name_ + "' has an invalid method entry " +
+                                  std::to_string(i));
+        }
+        methods_.push_back(&method);
+    }
+    std::sort(methods_.begin(), methods_.end(),
+              [](const o2l_native_method* a, const o2l_native_method* b) {
+                  return std::strcmp(a->name, b->name) < 0;
+              });
+    for (size_t i = 1; i < methods_.size(); ++i) {
+        if (std::strcmp(methods_[i - 1]->name, methods_[i]->name) == 0) {
+            throw EvaluationError("Native library '" + name_ + "' declares method '" +
+                                  methods_[i]->name + "' twice");
+        }
+    }
+}
+
+const o2l_native_method* NativeModule::findMethod(std::string_view name) const {
+    auto it = std::lower_bound(
+        methods_.begin(), methods_.end(), name,
+        [](const o2l_native_method* method, std::string_view key) { return method->name < key; });
+    if (it != methods_.end() && (*it)->name == name) {
+        return *it;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> NativeModule::getMethodNames() const {
+    std::vector<std::string> names;
+    names.reserve(methods_.size());
+    for (const o2l_native_method* method : methods_) {
+        names.emplace_back(method->name);
+    }
+    return names;
+}
+
+NativeModuleObject::NativeModuleObject(std::shared_ptr<const NativeModule> module)
+    : ObjectInstance(module->getName()), module_(std::move(module)) {}
+
+namespace {
+
+o2l_native_value toNative(const Value& value, const std::string& method, size_t index,
+                          Context& context) {
+    o2l_native_value native{};
+    if (auto number = std::get_if<Int>(&value)) {
+        native.type = O2L_NATIVE_INT;
+        native.as_int = *number;
+    } else if (auto number = std::get_if<Double>(&value)) {
+        native.type = O2L_NATIVE_DOUBLE;
+        native.as_double = *number;
+    } else if (auto number = std::get_if<Float>(&value)) {
+        native.type = O2L_NATIVE_DOUBLE;
+        native.as_double = *number;
+    } else if (auto flag = std::get_if<Bool>(&value)) {
+        native.type = O2L_NATIVE_BOOL;
+        native.as_bool = *flag ? 1 : 0;
+    } else if (auto text = std::get_if<Text>(&value)) {
+        native.type = O2L_NATIVE_TEXT;
+        native.as_text.data = text->data();
+        native.as_text.size = text->size();
+    } else {
+        throw TypeMismatchError("Native method '" + method + "' cannot take a " +
+                                getTypeName(value) + " as argument " +
+                                std::to_string(index + 1),
+                                context.getStackTrace());
+    }
+    return native;
+}
+
+Value fromNative(const o2l_native_value& native) {
+    switch (native.type) {
+        case O2L_NATIVE_INT:
+            return Int(native.as_int);
+        case O2L_NATIVE_DOUBLE:
+            return Double(native.as_double);
+        case O2L_NATIVE_BOOL:
+            return Bool(native.as_bool != 0);
+        case O2L_NATIVE_TEXT:
+            return native.as_text.data ? Text(native.as_text.data, native.as_text.size) : Text();
+    }
+    throw EvaluationError("Native method returned a value of unknown type");
+}
+
+}  // namespace
+
+Value NativeModuleObject::invoke(const o2l_native_method& method, const std::vector<Value>& args,
+                                 Context& context) const {
+    if (method.arity >= 0 && args.size() != static_cast<size_t>(method.arity)) {
+        throw EvaluationError(getName() + "." + method.name + "() expects " +
+                                  std::to_string(method.arity) + " arguments, got " +
+                                  std::to_string(args.size()),
+                              context);
+    }
+
+    // Small argument lists stay on the stack
+    constexpr size_t kInlineArguments = 8;
+    o2l_native_value inline_arguments[kInlineArguments];
+    std::vector<o2l_native_value> spilled;
+    o2l_native_value* arguments = inline_arguments;
+    if (args.size() > kInlineArguments) {
+        spilled.resize(args.size());
+        arguments = spilled.data();
+    }
+    for (size_t i = 0; i < args.size(); ++i) {
+        arguments[i] = toNative(args[i], method.name, i, context);
+    }
+
+    o2l_native_value result{};
+    o2l_native_status status = method.function(arguments, args.size(), &result);
+    if (status != O2L_NATIVE_OK && !(method.flags & O2L_NATIVE_NOTHROW)) {
+        std::string message = result.type == O2L_NATIVE_TEXT && result.as_text.data
+                                  ? std::string(result.as_text.data, result.as_text.size)
+                                  : std::string("failed");
+        throw EvaluationError(getName() + "." + method.name + "(): " + message, context);
+    }
+    return fromNative(result);
+}
+
+Value NativeModuleObject::callMethod(const std::string& method_name, const std::vector<Value>& args,
+                                     Context& context, bool external_call) {
+    if (const o2l_native_method* method = module_->findMethod(method_name)) {
+        return invoke(*method, args, context);
+    }
+    return ObjectInstance::callMethod(method_name, args, context, external_call);
+}
+
+bool NativeModuleObject::hasMethod(const std::string& method_name) const {
+    return module_->findMethod(method_name) != nullptr || ObjectInstance::hasMethod(method_name);
+}
+
+bool NativeModuleObject::isMethodExternal(const std::string& method_name) const {
+    return module_->findMethod(method_name) != nullptr ||
+           ObjectInstance::isMethodExternal(method_name);
+}
+
+std::vector<std::string> NativeModuleObject::getMethodNames() const {
+    std::vector<std::string> names = module_->getMethodNames();
+    for (auto& name : ObjectInstance::getMethodNames()) {
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+}  // namespace o2l
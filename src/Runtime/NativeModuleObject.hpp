@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NativeAbi.h"
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+/**
+ * The method table of a native library built against the v2 C ABI (NativeAbi.h), sorted by
+ * name. Validated once when the library is registered; keeps the shared object loaded for as
+ * long as any object created from it.
+ */
+class NativeModule {
+   public:
+    // Throws EvaluationError if the table is malformed or has another ABI version
+    NativeModule(const o2l_native_library& library, std::shared_ptr<void> handle = nullptr);
+
+    const std::string& getName() const {
+        return name_;
+    }
+    const std::string& getVersion() const {
+        return version_;
+    }
+
+    const o2l_native_method* findMethod(std::string_view name) const;
+    std::vector<std::string> getMethodNames() const;
+
+   private:
+    std::string name_;
+    std::string version_;
+    std::vector<const o2l_native_method*> methods_;  // sorted by name
+    std::shared_ptr<void> handle_;                   // dlopen handle, null for linked tables
+};
+
+/**
+ * O²L object of a v2 native library. Calls are dispatched through the module's static table
+ * straight to the method's function pointer, with no per-instance closures.
+ */
+class NativeModuleObject : public ObjectInstance {
+   public:
+    explicit NativeModuleObject(std::shared_ptr<const NativeModule> module);
+
+    const NativeModule& getModule() const {
+        return *module_;
+    }
+
+    // Calls `method`, which must belong to this object's module
+    Value invoke(const o2l_native_method& method, const std::vector<Value>& args,
+                 Context& context) const;
+
+    Value callMethod(const std::string& method_name, const std::vector<Value>& args,
+                     Context& context, bool external_call = false) override;
+    bool hasMethod(const std::string& method_name) const override;
+    bool isMethodExternal(const std::string& method_name) const override;
+    std::vector<std::string> getMethodNames() const override;
+
+   private:
+    std::shared_ptr<const NativeModule> module_;
+};
+
+}  // namespace o2l
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+template <typename Self>
+struct NativeMethodEntry {
+    std::string_view name;
+    Value (*method)(Self& self, const std::vector<Value>& args, Context& context);
+};
+
+/**
+ * Base for native objects that answer calls from a static table, Self::kMethods, sorted by
+ * name: a lookup is a binary search and an object carries no per-instance method closures.
+ */
+template <typename Self>
+class NativeTableObject : public ObjectInstance {
+   public:
+    using ObjectInstance::ObjectInstance;
+
+    Value callMethod(const std::string& method_name, const std::vector<Value>& args,
+                     Context& context, bool external_call = false) override {
+        if (const auto* entry = findMethod(method_name)) {
+            return entry->method(static_cast<Self&>(*this), args, context);
+        }
+        return ObjectInstance::callMethod(method_name, args, context, external_call);
+    }
+
+    bool hasMethod(const std::string& method_name) const override {
+        return findMethod(method_name) != nullptr || ObjectInstance::hasMethod(method_name);
+    }
+
+    bool isMethodExternal(const std::string& method_name) const override {
+        return findMethod(method_name) != nullptr || ObjectInstance::isMethodExternal(method_name);
+    }
+
+    std::vector<std::string> getMethodNames() const override {
+        std::vector<std::string> names;
+        for (const auto& entry : Self::kMethods) {
+            names.emplace_back(entry.name);
+        }
+        return names;
+    }
+
+   private:
+    static const NativeMethodEntry<Self>* findMethod(std::string_view name) {
+        auto it = std::lower_bound(Self::kMethods.begin(), Self::kMethods.end(), name,
+                                   [](const NativeMethodEntry<Self>& entry, std::string_view key) {
+                                       return entry.name < key;
+                                   });
+        return it != Self::kMethods.end() && it->name == name ? &*it : nullptr;
+    }
+};
+
+}  // namespace o2l
@@ -0,0 +1,295 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NumberConversion.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+namespace o2l {
+
+namespace numeric {
+
+namespace {
+
+#ifdef __SIZEOF_INT128__
+// Suppress pedantic warning for __int128 which is a widely supported extension
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+using LongMagnitude = unsigned __int128;
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+using LongMagnitude = unsigned long long;
+#endif
+
+// Eight text bytes as a word with the first character in the lowest byte
+uint64_t loadEight(const char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    if constexpr (std::endian::native == std::endian::big) {
+        word = __builtin_bswap64(word);
+    }
+    return word;
+}
+
+// Every byte is '0'..'9': the high nibble is 3, and adding 6 does not carry out of the low one
+bool isEightDigits(uint64_t word) {
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+// The value of eight digits, combined pairwise into 2-, 4- and 8-digit lanes by multiplication
+uint64_t eightDigitsValue(uint64_t word) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    word -= 0x3030303030303030ULL;
+    word = (word * 10) + (word >> 8);
+    return (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+}
+
+// Reads the digit run starting at `p` into `value`, setting `overflow` (and no longer
+// accumulating) once it would pass `limit`. Returns the end of the run
+template <typename U>
+const char* accumulateDigits(const char* p, const char* end, U limit, U& value, bool& overflow) {
+    while (end - p >= 8) {
+        uint64_t word = loadEight(p);
+        if (!isEightDigits(word)) {
+            break;
+        }
+        U chunk = static_cast<U>(eightDigitsValue(word));
+        if (overflow || value > (limit - chunk) / 100000000) {
+            overflow = true;
+        } else {
+            value = value * 100000000 + chunk;
+        }
+        p += 8;
+    }
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        U digit = static_cast<U>(*p - '0');
+        if (overflow || value > (limit - digit) / 10) {
+            overflow = true;
+        } else {
+            value = value * 10 + digit;
+        }
+    }
+    return p;
+}
+
+template <typename S, typename U>
+std::optional<S> parseSigned(std::string_view text, size_t* consumed) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = begin;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // The signed type's range: its maximum, and one more for the magnitude of its minimum
+    const U max = static_cast<U>(~U(0)) >> 1;
+    U magnitude = 0;
+    bool overflow = false;
+    const char* digits = p;
+    p = accumulateDigits<U>(p, end, negative ? max + 1 : max, magnitude, overflow);
+    if (p == digits || overflow) {
+        return std::nullopt;
+    }
+    if (consumed) {
+        *consumed = static_cast<size_t>(p - begin);
+    }
+    // Unsigned to signed conversion is modular, so the minimum comes out right too
+    return static_cast<S>(negative ? U(0) - magnitude : magnitude);
+}
+
+template <typename F>
+std::optional<F> parseFloating(std::string_view text, size_t* consumed) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = begin;
+    // from_chars takes a leading '-' but not '+'
+    if (p < end && *p == '+') {
+        ++p;
+        if (p < end && *p == '-') {
+            return std::nullopt;
+        }
+    }
+    F value{};
+    auto [last, error] = std::from_chars(p, end, value);
+    if (error != std::errc()) {
+        return std::nullopt;
+    }
+    if (consumed) {
+        *consumed = static_cast<size_t>(last - begin);
+    }
+    return value;
+}
+
+template <typename T>
+std::optional<T> whole(std::optional<T> value, size_t consumed, std::string_view text) {
+    return value && consumed == text.size() ? value : std::nullopt;
+}
+
+// Shortest round-trip text, with ".0" so whole values still read as floating point
+template <typename F>
+void appendShortest(std::string& out, F value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+    if (std::isfinite(value) &&
+        std::none_of(buffer, result.ptr, [](char c) { return c == '.' || c == 'e'; })) {
+        out += ".0";
+    }
+}
+
+}  // namespace
+
+std::string_view trim(std::string_view text) {
+    const char* whitespace = " \t\n\r";
+    size_t first = text.find_first_not_of(whitespace);
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+}
+
+std::optional<Int> parseIntPrefix(std::string_view text, size_t* consumed) {
+    return parseSigned<Int, unsigned long long>(text, consumed);
+}
+
+std::optional<Long> parseLongPrefix(std::string_view text, size_t* consumed) {
+    return parseSigned<Long, LongMagnitude>(text, consumed);
+}
+
+std::optional<double> parseDoublePrefix(std::string_view text, size_t* consumed) {
+    return parseFloating<double>(text, consumed);
+}
+
+std::optional<float> parseFloatPrefix(std::string_view text, size_t* consumed) {
+    return parseFloating<float>(text, consumed);
+}
+
+std::optional<Int> parseInt(std::string_view text) {
+    size_t consumed = 0;
+    auto value = parseIntPrefix(text, &consumed);
+    return whole(value, consumed, text);
+}
+
+std::optional<Long> parseLong(std::string_view text) {
+    size_t consumed = 0;
+    auto value = parseLongPrefix(text, &consumed);
+    return whole(value, consumed, text);
+}
+
+std::optional<double> parseDouble(std::string_view text) {
+    size_t consumed = 0;
+    auto value = parseDoublePrefix(text, &consumed);
+    return whole(value, consumed, text);
+}
+
+void appendInt(std::string& out, Int value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendLong(std::string& out, Long value) {
+#ifdef __SIZEOF_INT128__
+    // to_chars has no 128-bit overload; write the digits backwards from the end
+    char buffer[41];
+    char* p = buffer + sizeof(buffer);
+    LongMagnitude magnitude = value < 0 ? LongMagnitude(0) - static_cast<LongMagnitude>(value)
+                                        : static_cast<LongMagnitude>(value);
+    do {
+        *--p = static_cast<char>('0' + static_cast<int>(magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    out.append(p, buffer + sizeof(buffer));
+#else
+    appendInt(out, static_cast<Int>(value));
+#endif
+}
+
+void appendDouble(std::string& out, double value) {
+    appendShortest(out, value);
+}
+
+void appendFloat(std::string& out, float value) {
+    appendShortest(out, value);
+}
+
+void appendFixed(std::string& out, double value, int precision) {
+    char buffer[64];
+    auto result =
+        std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+    if (result.ec == std::errc()) {
+        out.append(buffer, result.ptr);
+        return;
+    }
+    // Large magnitudes print every integer digit: up to 309 of them, the sign and the point
+    std::string large(312 + static_cast<size_t>(precision), '\0');
+    result = std::to_chars(large.data(), large.data() + large.size(), value,
+                           std::chars_format::fixed, precision);
+    out.append(large.data(), result.ptr);
+}
+
+std::string formatInt(Int value) {
+    std::string text;
+    appendInt(text, value);
+    return text;
+}
+
+std::string formatLong(Long value) {
+    std::string text;
+    appendLong(text, value);
+    return text;
+}
+
+std::string formatDouble(double value) {
+    std::string text;
+    appendDouble(text, value);
+    return text;
+}
+
+std::string formatFloat(float value) {
+    std::string text;
+    appendFloat(text, value);
+    return text;
+}
+
+std::string formatFixed(double value, int precision) {
+    std::string text;
+    appendFixed(text, value, precision);
+    return text;
+}
+
+}  // namespace numeric
+
+}  // namespace o2l
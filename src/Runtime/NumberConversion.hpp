@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Value.hpp"
+
+namespace o2l {
+
+/**
+ * Number parsing and formatting shared by the runtime: Text conversions, JSON, io.print and
+ * valueToString all go through here so a number reads and prints the same everywhere.
+ *
+ * Everything is built on std::from_chars/std::to_chars, so it ignores the C locale and does
+ * not allocate beyond the returned string. Floating point values print as the shortest text
+ * that reads back to the same value, with ".0" added to whole numbers so they still read as
+ * floating point. Integer digit runs are consumed eight digits at a time.
+ */
+namespace numeric {
+
+// `text` without leading and trailing spaces, tabs and line breaks
+std::string_view trim(std::string_view text);
+
+// Parse a number from the start of `text`, after an optional '+' or '-', and report how many
+// characters it used through `consumed`. Empty when no digits start the text or the value
+// is out of range. Doubles accept fractions, exponents, "inf" and "nan"
+std::optional<Int> parseIntPrefix(std::string_view text, size_t* consumed = nullptr);
+std::optional<Long> parseLongPrefix(std::string_view text, size_t* consumed = nullptr);
+std::optional<double> parseDoublePrefix(std::string_view text, size_t* consumed = nullptr);
+std::optional<float> parseFloatPrefix(std::string_view text, size_t* consumed = nullptr);
+
+// As the prefix parsers, but the whole of `text` must be the number
+std::optional<Int> parseInt(std::string_view text);
+std::optional<Long> parseLong(std::string_view text);
+std::optional<double> parseDouble(std::string_view text);
+
+// Append the number's text to `out`
+void appendInt(std::string& out, Int value);
+void appendLong(std::string& out, Long value);
+void appendDouble(std::string& out, double value);
+void appendFloat(std::string& out, float value);
+// printf("%.*f") without the locale: `precision` digits after the point
+void appendFixed(std::string& out, double value, int precision);
+
+std::string formatInt(Int value);
+std::string formatLong(Long value);
+std::string formatDouble(double value);
+std::string formatFloat(float value);
+std::string formatFixed(double value, int precision);
+
+}  // namespace numeric
+
+}  // namespace o2l
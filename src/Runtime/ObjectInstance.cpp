@@ -21,40 +21,63 @@
 
 namespace o2l {
 
-ObjectInstance::ObjectInstance(const std::string& name) : object_name_(name) {}
+namespace {
+
+// Objects start out sharing one empty table, so those without methods of their own (the
+// native request and response objects) cost no allocation
+const std::shared_ptr<ObjectInstance::MethodTable>& emptyMethodTable() {
+    static const auto table = std::make_shared<ObjectInstance::MethodTable>();
+    return table;
+}
+
+}  // namespace
+
+ObjectInstance::ObjectInstance(const std::string& name)
+    : object_name_(name), methods_(emptyMethodTable()) {
+    HeapProfiler::recordAllocation(heap_samples_, sizeof(ObjectInstance), "Object", object_name_);
+}
 
 ObjectInstance::ObjectInstance(const ObjectInstance& other)
     : object_name_(other.object_name_),
       methods_(other.methods_),
-      method_visibility_(other.method_visibility_),
-      method_signatures_(other.method_signatures_),
-      properties_(other.properties_) {}
+      properties_(other.properties_) {
+    HeapProfiler::recordAllocation(heap_samples_, sizeof(ObjectInstance), "Object", object_name_);
+}
+
+ObjectInstance::MethodTable& ObjectInstance::mutableMethods() {
+    if (methods_.use_count() > 1) {
+        methods_ = std::make_shared<MethodTable>(*methods_);
+    }
+    return *methods_;
+}
 
 void ObjectInstance::addMethod(const std::string& method_name, Method method, bool is_external) {
-    methods_[method_name] = std::move(method);
-    method_visibility_[method_name] = is_external;
+    MethodTable& table = mutableMethods();
+    table.methods[method_name] = std::move(method);
+    table.visibility[method_name] = is_external;
 }
 
 void ObjectInstance::addMethod(const std::string& method_name, Method method,
                                const std::vector<Parameter>& parameters,
                                const std::string& return_type, bool is_external) {
-    methods_[method_name] = std::move(method);
-    method_visibility_[method_name] = is_external;
-    method_signatures_[method_name] =
+    MethodTable& table = mutableMethods();
+    table.methods[method_name] = std::move(method);
+    table.visibility[method_name] = is_external;
+    table.signatures[method_name] =
         MethodSignature(method_name, parameters, return_type, is_external);
 }
 
 Value ObjectInstance::callMethod(const std::string& method_name, const std::vector<Value>& args,
                                  Context& context, bool external_call) {
-    auto it = methods_.find(method_name);
-    if (it == methods_.end()) {
+    auto it = methods_->methods.find(method_name);
+    if (it == methods_->methods.end()) {
         throw UnresolvedReferenceError("Method '" + method_name + "' not found in object '" +
                                        object_name_ + "'");
     }
 
     // Check method visibility
-    auto vis_it = method_visibility_.find(method_name);
-    bool is_external = (vis_it != method_visibility_.end()) ? vis_it->second : false;
+    auto vis_it = methods_->visibility.find(method_name);
+    bool is_external = (vis_it != methods_->visibility.end()) ? vis_it->second : false;
 
     if (external_call && !is_external) {
         throw EvaluationError("Method '" + method_name +
@@ -62,6 +85,9 @@ Value ObjectInstance::callMethod(const std::string& method_name, const std::vect
                               context);
     }
 
+    // Every call is a cancellation point, so deep or unbounded recursion stops too
+    context.checkCancellation();
+
     // Push call information for stack trace
     context.pushCall(object_name_ + "." + method_name);
 
@@ -82,14 +108,14 @@ Value ObjectInstance::callMethod(const std::string& method_name, const std::vect
 }
 
 bool ObjectInstance::hasMethod(const std::string& method_name) const {
-    return methods_.find(method_name) != methods_.end();
+    return methods_->methods.find(method_name) != methods_->methods.end();
 }
 
 std::vector<std::string> ObjectInstance::getMethodNames() const {
     std::vector<std::string> names;
-    names.reserve(methods_.size());
+    names.reserve(methods_->methods.size());
 
-    for (const auto& pair : methods_) {
+    for (const auto& pair : methods_->methods) {
         names.push_back(pair.first);
     }
 
@@ -97,8 +123,8 @@ std::vector<std::string> ObjectInstance::getMethodNames() const {
 }
 
 bool ObjectInstance::isMethodExternal(const std::string& method_name) const {
-    auto it = method_visibility_.find(method_name);
-    return (it != method_visibility_.end()) ? it->second : false;
+    auto it = methods_->visibility.find(method_name);
+    return (it != methods_->visibility.end()) ? it->second : false;
 }
 
 void ObjectInstance::setProperty(const std::string& property_name, const Value& value) {
@@ -119,12 +145,12 @@ bool ObjectInstance::hasProperty(const std::string& property_name) const {
 }
 
 bool ObjectInstance::hasMethodSignature(const std::string& method_name) const {
-    return method_signatures_.find(method_name) != method_signatures_.end();
+    return methods_->signatures.find(method_name) != methods_->signatures.end();
 }
 
 const MethodSignature* ObjectInstance::getMethodSignature(const std::string& method_name) const {
-    auto it = method_signatures_.find(method_name);
-    return (it != method_signatures_.end()) ? &it->second : nullptr;
+    auto it = methods_->signatures.find(method_name);
+    return (it != methods_->signatures.end()) ? &it->second : nullptr;
 }
 
 }  // namespace o2l
\ No newline at end of file
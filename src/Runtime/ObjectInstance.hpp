@@ -22,6 +22,7 @@
 #include <string>
 
 #include "../AST/MethodDeclarationNode.hpp"  // For Parameter struct
+#include "HeapProfiler.hpp"
 #include "Value.hpp"
 
 namespace o2l {
@@ -51,12 +52,22 @@ struct MethodSignature {
 };
 
 class ObjectInstance : public std::enable_shared_from_this<ObjectInstance> {
+   public:
+    struct MethodTable {
+        std::map<std::string, Method> methods;
+        std::map<std::string, bool> visibility;  // true = external, false = protected
+        std::map<std::string, MethodSignature> signatures;  // Method signature information
+    };
+
    private:
     std::string object_name_;
-    std::map<std::string, Method> methods_;
-    std::map<std::string, bool> method_visibility_;  // true = external, false = protected
-    std::map<std::string, MethodSignature> method_signatures_;  // Method signature information
-    std::map<std::string, Value> properties_;                   // Private properties
+    // Shared by copies of an object (instances of a class, cloned interpreters) until one of
+    // them adds a method, so copying an object never copies its method closures
+    std::shared_ptr<MethodTable> methods_;
+    std::map<std::string, Value> properties_;  // Private properties
+    HeapSamples heap_samples_;
+
+    MethodTable& mutableMethods();
 
    public:
     explicit ObjectInstance(const std::string& name);
@@ -64,6 +75,8 @@ class ObjectInstance : public std::enable_shared_from_this<ObjectInstance> {
     // Copy constructor for creating instances from class templates
     ObjectInstance(const ObjectInstance& other);
 
+    virtual ~ObjectInstance() = default;
+
     // Add a method to this object instance
     void addMethod(const std::string& method_name, Method method, bool is_external = false);
 
@@ -73,14 +86,16 @@ class ObjectInstance : public std::enable_shared_from_this<ObjectInstance> {
                    bool is_external = false);
 
     // Call a method on this object
-    Value callMethod(const std::string& method_name, const std::vector<Value>& args,
-                     Context& context, bool external_call = false);
+    // Native-backed subclasses override the lookup members below to dispatch through a
+    // static method table instead of the per-instance std::function map.
+    virtual Value callMethod(const std::string& method_name, const std::vector<Value>& args,
+                             Context& context, bool external_call = false);
 
     // Check if a method exists
-    bool hasMethod(const std::string& method_name) const;
+    virtual bool hasMethod(const std::string& method_name) const;
 
     // Check if a method is externally visible
-    bool isMethodExternal(const std::string& method_name) const;
+    virtual bool isMethodExternal(const std::string& method_name) const;
 
     // Get method signature information
     bool hasMethodSignature(const std::string& method_name) const;
@@ -92,12 +107,15 @@ class ObjectInstance : public std::enable_shared_from_this<ObjectInstance> {
     }
 
     // Get all method names (for debugging/introspection)
-    std::vector<std::string> getMethodNames() const;
+    virtual std::vector<std::string> getMethodNames() const;
 
     // Property access methods (private properties)
     void setProperty(const std::string& property_name, const Value& value);
-    Value getProperty(const std::string& property_name) const;
-    bool hasProperty(const std::string& property_name) const;
+    virtual Value getProperty(const std::string& property_name) const;
+    virtual bool hasProperty(const std::string& property_name) const;
+    const std::map<std::string, Value>& getProperties() const {
+        return properties_;
+    }
 };
 
 }  // namespace o2l
\ No newline at end of file
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OutputBuffer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace o2l {
+
+namespace {
+
+// Buffers of live threads, for flushAll(); never destroyed so late thread exits can use it
+struct Registry {
+    std::mutex mutex;
+    std::vector<OutputBuffer*> buffers;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+thread_local std::unique_ptr<OutputBuffer> thread_buffer;
+
+// Installed as the tie of std::cout and std::cerr: flushing it drains this thread's buffer
+class TieBuffer : public std::streambuf {
+   public:
+    explicit TieBuffer(bool flush_stdout) : flush_stdout_(flush_stdout) {}
+
+   protected:
+    int sync() override {
+        OutputBuffer::flushThread(flush_stdout_);
+        return 0;
+    }
+
+   private:
+    bool flush_stdout_;
+};
+
+void tieStandardStreams() {
+    // Leaked on purpose: the streams may be flushed during static destruction
+    std::cout.tie(new std::ostream(new TieBuffer(false)));
+    std::cerr.tie(new std::ostream(new TieBuffer(true)));
+    std::atexit([]() { OutputBuffer::flushAll(); });
+}
+
+}  // namespace
+
+OutputBuffer::OutputBuffer() {
+    text_.reserve(kCapacity);
+    Registry& buffers = registry();
+    std::lock_guard<std::mutex> lock(buffers.mutex);
+    buffers.buffers.push_back(this);
+}
+
+OutputBuffer::~OutputBuffer() {
+    {
+        Registry& buffers = registry();
+        std::lock_guard<std::mutex> lock(buffers.mutex);
+        buffers.buffers.erase(std::find(buffers.buffers.begin(), buffers.buffers.end(), this));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain(true);
+}
+
+OutputBuffer& OutputBuffer::local() {
+    if (!thread_buffer) {
+        static std::once_flag tied;
+        std::call_once(tied, tieStandardStreams);
+        thread_buffer.reset(new OutputBuffer());
+    }
+    return *thread_buffer;
+}
+
+void OutputBuffer::drain(bool flush_stdout) {
+    // Straight to the stream buffer: going through std::cout would re-enter its tie
+    std::streambuf* out = std::cout.rdbuf();
+    if (!text_.empty()) {
+        if (out) {
+            out->sputn(text_.data(), static_cast<std::streamsize>(text_.size()));
+        }
+        text_.clear();
+    }
+    if (flush_stdout && out) {
+        out->pubsync();
+    }
+}
+
+void OutputBuffer::flushThread(bool flush_stdout) {
+    if (OutputBuffer* buffer = thread_buffer.get()) {
+        std::lock_guard<std::mutex> lock(buffer->mutex_);
+        if (!buffer->text_.empty()) {
+            buffer->drain(false);
+        }
+    }
+    // Even with nothing pending: this replaces std::cerr's own tie to std::cout, so text
+    // written straight to std::cout must still reach stdout before a std::cerr write
+    if (flush_stdout) {
+        if (std::streambuf* out = std::cout.rdbuf()) {
+            out->pubsync();
+        }
+    }
+}
+
+void OutputBuffer::flushAll() {
+    Registry& buffers = registry();
+    std::lock_guard<std::mutex> registry_lock(buffers.mutex);
+    for (OutputBuffer* buffer : buffers.buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex_);
+        buffer->drain(false);
+    }
+    if (std::streambuf* out = std::cout.rdbuf()) {
+        out->pubsync();
+    }
+}
+
+bool OutputBuffer::isTerminal() {
+#ifdef _WIN32
+    static const bool terminal = _isatty(_fileno(stdout)) != 0;
+#else
+    static const bool terminal = isatty(fileno(stdout)) != 0;
+#endif
+    return terminal;
+}
+
+}  // namespace o2l
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace o2l {
+
+/**
+ * Per-thread buffer for program output (io.print).
+ *
+ * Text is formatted straight into the calling thread's buffer and handed to std::cout's
+ * stream buffer in large blocks: when the buffer reaches kCapacity, after every write while
+ * stdout is a terminal, when the thread ends or the process exits, and on flushThread() /
+ * flushAll(). Ordering with other output is kept by tying std::cout and std::cerr to the
+ * buffer, so anything written through them first drains the writing thread's pending text,
+ * and std::cerr also flushes stdout.
+ */
+class OutputBuffer {
+   public:
+    static constexpr size_t kCapacity = 64 * 1024;
+
+    // The calling thread's buffer, created (and the streams tied) on first use
+    static OutputBuffer& local();
+
+    // Appends through `fill(std::string&)` under the buffer's lock, then drains the buffer
+    // if it is full or stdout is a terminal. Text appended by a throwing `fill` is dropped.
+    template <typename Fill>
+    void write(Fill&& fill) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t start = text_.size();
+        try {
+            fill(text_);
+        } catch (...) {
+            text_.resize(start);
+            throw;
+        }
+        if (text_.size() >= kCapacity || isTerminal()) {
+            drain(isTerminal());
+        }
+    }
+
+    // Drains the calling thread's pending text; with `flush_stdout`, stdout is flushed too,
+    // whether or not anything was pending
+    static void flushThread(bool flush_stdout = true);
+    // Drains every thread's pending text and flushes stdout
+    static void flushAll();
+
+    static bool isTerminal();
+
+    ~OutputBuffer();
+
+   private:
+    OutputBuffer();
+
+    // Caller holds mutex_
+    void drain(bool flush_stdout);
+
+    std::mutex mutex_;
+    std::string text_;
+};
+
+}  // namespace o2l
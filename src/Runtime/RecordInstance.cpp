@@ -21,7 +21,11 @@
 namespace o2l {
 
 RecordInstance::RecordInstance(std::string type_name, std::unordered_map<std::string, Value> values)
-    : record_type_name_(std::move(type_name)), field_values_(std::move(values)) {}
+    : record_type_name_(std::move(type_name)), field_values_(std::move(values)) {
+    HeapProfiler::recordAllocation(heap_samples_,
+                                   sizeof(RecordInstance) + field_values_.size() * sizeof(Value),
+                                   "Record", record_type_name_);
+}
 
 Value RecordInstance::getFieldValue(const std::string& field_name) const {
     auto it = field_values_.find(field_name);
@@ -19,6 +19,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "HeapProfiler.hpp"
 #include "Value.hpp"
 
 namespace o2l {
@@ -27,6 +28,7 @@ class RecordInstance {
    private:
     std::string record_type_name_;
     std::unordered_map<std::string, Value> field_values_;
+    HeapSamples heap_samples_;
 
    public:
     RecordInstance(std::string type_name, std::unordered_map<std::string, Value> values);
@@ -18,11 +18,17 @@
 
 #include <sstream>
 
+#include "ExecutionBudget.hpp"
+
 namespace o2l {
 
-SetInstance::SetInstance(const std::string& element_type) : element_type_name_(element_type) {}
+SetInstance::SetInstance(const std::string& element_type) : element_type_name_(element_type) {
+    HeapProfiler::recordAllocation(heap_samples_, sizeof(SetInstance), "Set");
+}
 
 void SetInstance::add(const Value& element) {
+    ExecutionBudget::chargeStoredValue(element);
+    HeapProfiler::recordStoredValue(heap_samples_, element, "Set");
     elements_.insert(element);
 }
 
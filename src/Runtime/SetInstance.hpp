@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "HeapProfiler.hpp"
 #include "Value.hpp"
 
 namespace o2l {
@@ -36,6 +37,7 @@ class SetInstance {
    private:
     std::set<Value, ValueComparator> elements_;
     std::string element_type_name_;
+    HeapSamples heap_samples_;
 
    public:
     SetInstance(const std::string& element_type = "Value");
@@ -0,0 +1,833 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SqliteLibrary.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
+#include "../Common/Exceptions.hpp"
+#include "Context.hpp"
+#include "ListInstance.hpp"
+#include "MapInstance.hpp"
+#include "NativeTableObject.hpp"
+
+namespace o2l {
+
+#ifdef HAVE_SQLITE3
+
+namespace {
+
+constexpr size_t kDefaultStatementCacheCapacity = 64;
+
+// A connection and its cache of idle prepared statements, shared by the objects using it
+class SqliteDatabase {
+   public:
+    SqliteDatabase(const std::string& path, size_t capacity) : capacity_(capacity) {
+        int rc = sqlite3_open_v2(path.c_str(), &db_,
+                                 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI,
+                                 nullptr);
+        if (rc != SQLITE_OK) {
+            std::string message = db_ ? sqlite3_errmsg(db_) : sqlite3_errstr(rc);
+            sqlite3_close_v2(db_);
+            db_ = nullptr;
+            throw std::runtime_error(message);
+        }
+    }
+
+    ~SqliteDatabase() {
+        close();
+    }
+
+    SqliteDatabase(const SqliteDatabase&) = delete;
+    SqliteDatabase& operator=(const SqliteDatabase&) = delete;
+
+    bool isOpen() const {
+        return db_ != nullptr;
+    }
+
+    sqlite3* handle(const char* where, const Context& context) const {
+        if (!db_) {
+            throw EvaluationError(std::string(where) + ": database is closed", context);
+        }
+        return db_;
+    }
+
+    // Checks the statement for `sql` out of the cache, preparing it on a miss. Returns null if
+    // `sql` holds several statements and `allow_script` is set; throws if it is not set.
+    sqlite3_stmt* acquire(const std::string& sql, const char* where, const Context& context,
+                          bool allow_script = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = index_.find(sql);
+            if (found != index_.end()) {
+                sqlite3_stmt* statement = found->second->second;
+                idle_.erase(found->second);
+                index_.erase(found);
+                ++hits_;
+                return statement;
+            }
+            ++misses_;
+        }
+
+        sqlite3* db = handle(where, context);
+        sqlite3_stmt* statement = nullptr;
+        const char* tail = nullptr;
+        if (sqlite3_prepare_v3(db, sql.data(), static_cast<int>(sql.size()),
+                               SQLITE_PREPARE_PERSISTENT, &statement, &tail) != SQLITE_OK) {
+            throw EvaluationError(std::string(where) + ": " + sqlite3_errmsg(db), context);
+        }
+        bool more = tail && std::any_of(tail, sql.data() + sql.size(), [](char c) {
+                        return !std::isspace(static_cast<unsigned char>(c));
+                    });
+        if (!statement || more) {
+            sqlite3_finalize(statement);
+            if (more && allow_script) {
+                return nullptr;
+            }
+            throw EvaluationError(std::string(where) + ": expected a single SQL statement",
+                                  context);
+        }
+        return statement;
+    }
+
+    // Returns a statement to the cache, reset; the least recently used one is evicted when full
+    void release(const std::string& sql, sqlite3_stmt* statement) {
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!db_ || capacity_ == 0 || index_.count(sql)) {
+            sqlite3_finalize(statement);
+            return;
+        }
+        idle_.emplace_front(sql, statement);
+        index_.emplace(sql, idle_.begin());
+        if (idle_.size() > capacity_) {
+            sqlite3_finalize(idle_.back().second);
+            index_.erase(idle_.back().first);
+            idle_.pop_back();
+        }
+    }
+
+    // Statements still checked out keep the connection alive until they are finalized
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [sql, statement] : idle_) {
+            sqlite3_finalize(statement);
+        }
+        idle_.clear();
+        index_.clear();
+        if (db_) {
+            sqlite3_close_v2(db_);
+            db_ = nullptr;
+        }
+    }
+
+    std::shared_ptr<MapInstance> cacheStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto stats = std::make_shared<MapInstance>("Text", "Int");
+        stats->put(Text("cached"), Int(idle_.size()));
+        stats->put(Text("capacity"), Int(capacity_));
+        stats->put(Text("hits"), Int(hits_));
+        stats->put(Text("misses"), Int(misses_));
+        return stats;
+    }
+
+   private:
+    sqlite3* db_ = nullptr;
+    size_t capacity_;
+    std::list<std::pair<std::string, sqlite3_stmt*>> idle_;  // most recently used first
+    std::unordered_map<std::string, std::list<std::pair<std::string, sqlite3_stmt*>>::iterator>
+        index_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    std::mutex mutex_;
+};
+
+// A statement checked out of a connection's cache, returned when the lease ends
+class StatementLease {
+   public:
+    StatementLease(std::shared_ptr<SqliteDatabase> db, std::string sql, sqlite3_stmt* statement)
+        : db_(std::move(db)), sql_(std::move(sql)), statement_(statement) {}
+
+    ~StatementLease() {
+        release();
+    }
+
+    StatementLease(const StatementLease&) = delete;
+    StatementLease& operator=(const StatementLease&) = delete;
+
+    sqlite3_stmt* get() const {
+        return statement_;
+    }
+
+    void release() {
+        if (statement_) {
+            db_->release(sql_, statement_);
+            statement_ = nullptr;
+        }
+    }
+
+   private:
+    std::shared_ptr<SqliteDatabase> db_;
+    std::string sql_;
+    sqlite3_stmt* statement_;
+};
+
+EvaluationError sqliteError(const char* where, sqlite3_stmt* statement, const Context& context) {
+    return EvaluationError(std::string(where) + ": " + sqlite3_errmsg(sqlite3_db_handle(statement)),
+                           context);
+}
+
+// Steps once; true while the statement has a row
+bool stepRow(sqlite3_stmt* statement, const char* where, const Context& context) {
+    int rc = sqlite3_step(statement);
+    if (rc == SQLITE_ROW) {
+        return true;
+    }
+    if (rc == SQLITE_DONE) {
+        return false;
+    }
+    throw sqliteError(where, statement, context);
+}
+
+void bindValue(sqlite3_stmt* statement, int index, const Value& value, bool copy_text,
+               const char* where, const Context& context) {
+    int rc;
+    if (auto v = std::get_if<Int>(&value)) {
+        rc = sqlite3_bind_int64(statement, index, *v);
+    } else if (auto v = std::get_if<Long>(&value)) {
+        if (*v < std::numeric_limits<sqlite3_int64>::min() ||
+            *v > std::numeric_limits<sqlite3_int64>::max()) {
+            throw EvaluationError(std::string(where) + ": parameter " + std::to_string(index) +
+                                      " does not fit in a 64-bit integer",
+                                  context);
+        }
+        rc = sqlite3_bind_int64(statement, index, static_cast<sqlite3_int64>(*v));
+    } else if (auto v = std::get_if<Double>(&value)) {
+        rc = sqlite3_bind_double(statement, index, *v);
+    } else if (auto v = std::get_if<Float>(&value)) {
+        rc = sqlite3_bind_double(statement, index, *v);
+    } else if (auto v = std::get_if<Bool>(&value)) {
+        rc = sqlite3_bind_int(statement, index, *v ? 1 : 0);
+    } else if (auto v = std::get_if<Text>(&value)) {
+        rc = sqlite3_bind_text64(statement, index, v->data(), v->size(),
+                                 copy_text ? SQLITE_TRANSIENT : SQLITE_STATIC, SQLITE_UTF8);
+    } else if (auto v = std::get_if<Char>(&value)) {
+        rc = sqlite3_bind_text(statement, index, v, 1, SQLITE_TRANSIENT);
+    } else {
+        throw TypeMismatchError(std::string(where) + ": cannot bind a " + getTypeName(value) +
+                                    " as parameter " + std::to_string(index),
+                                context.getStackTrace());
+    }
+    if (rc != SQLITE_OK) {
+        throw sqliteError(where, statement, context);
+    }
+}
+
+// Binds args[first..], or the elements of a single List argument there, as the parameters.
+// Without `copy_text` the Text arguments must outlive the statement's use.
+void bindParameters(sqlite3_stmt* statement, const std::vector<Value>& args, size_t first,
+                    bool copy_text, const char* where, const Context& context) {
+    const Value* params = args.data() + std::min(first, args.size());
+    size_t count = args.size() > first ? args.size() - first : 0;
+    if (count == 1) {
+        if (auto list = std::get_if<std::shared_ptr<ListInstance>>(params)) {
+            params = (*list)->getElements().data();
+            count = (*list)->size();
+        }
+    }
+
+    int expected = sqlite3_bind_parameter_count(statement);
+    if (static_cast<size_t>(expected) != count) {
+        throw EvaluationError(std::string(where) + ": expected " + std::to_string(expected) +
+                                  " parameters, got " + std::to_string(count),
+                              context);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        bindValue(statement, static_cast<int>(i + 1), params[i], copy_text, where, context);
+    }
+}
+
+Value columnValue(sqlite3_stmt* statement, int column) {
+    switch (sqlite3_column_type(statement, column)) {
+        case SQLITE_INTEGER:
+            return Int(sqlite3_column_int64(statement, column));
+        case SQLITE_FLOAT:
+            return Double(sqlite3_column_double(statement, column));
+        case SQLITE_BLOB: {
+            auto data = static_cast<const char*>(sqlite3_column_blob(statement, column));
+            int size = sqlite3_column_bytes(statement, column);
+            return data ? Text(data, static_cast<size_t>(size)) : Text();
+        }
+        default: {
+            auto data = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+            int size = sqlite3_column_bytes(statement, column);
+            return data ? Text(data, static_cast<size_t>(size)) : Text();
+        }
+    }
+}
+
+// The current row as a Map of column name to value; NULL columns are left out
+std::shared_ptr<MapInstance> rowMap(sqlite3_stmt* statement) {
+    auto row = std::make_shared<MapInstance>("Text", "Value");
+    int columns = sqlite3_column_count(statement);
+    for (int i = 0; i < columns; ++i) {
+        if (sqlite3_column_type(statement, i) != SQLITE_NULL) {
+            row->put(Text(sqlite3_column_name(statement, i)), columnValue(statement, i));
+        }
+    }
+    return row;
+}
+
+std::shared_ptr<ListInstance> allRows(sqlite3_stmt* statement, const char* where,
+                                      const Context& context) {
+    auto rows = std::make_shared<ListInstance>();
+    while (stepRow(statement, where, context)) {
+        rows->add(rowMap(statement));
+    }
+    return rows;
+}
+
+const Text& requireText(const std::vector<Value>& args, size_t index, const char* where,
+                        const Context& context) {
+    if (args.size() <= index || !std::holds_alternative<Text>(args[index])) {
+        throw EvaluationError(std::string(where) + ": argument " + std::to_string(index + 1) +
+                                  " must be Text",
+                              context);
+    }
+    return std::get<Text>(args[index]);
+}
+
+Int requireInt(const std::vector<Value>& args, size_t index, const char* where,
+               const Context& context) {
+    if (args.size() <= index || !std::holds_alternative<Int>(args[index])) {
+        throw EvaluationError(std::string(where) + ": argument " + std::to_string(index + 1) +
+                                  " must be Int",
+                              context);
+    }
+    return std::get<Int>(args[index]);
+}
+
+void requireArgumentCount(const std::vector<Value>& args, size_t count, const char* where,
+                          const Context& context) {
+    if (args.size() != count) {
+        throw EvaluationError(std::string(where) + " expects " + std::to_string(count) +
+                                  " arguments, got " + std::to_string(args.size()),
+                              context);
+    }
+}
+
+// Runs a statement without parameters to completion through the cache
+void run(const std::shared_ptr<SqliteDatabase>& db, const std::string& sql, const char* where,
+         const Context& context) {
+    StatementLease lease(db, sql, db->acquire(sql, where, context));
+    while (stepRow(lease.get(), where, context)) {
+    }
+}
+
+// Rows of a query, stepped as the program asks for them
+class SqliteRows : public NativeTableObject<SqliteRows> {
+   public:
+    SqliteRows(std::shared_ptr<SqliteDatabase> db, std::string sql, sqlite3_stmt* statement)
+        : NativeTableObject("SqliteRows"), lease_(std::move(db), std::move(sql), statement) {}
+
+    static const std::array<NativeMethodEntry<SqliteRows>, 3> kMethods;
+
+    sqlite3_stmt* statement() const {
+        return lease_.get();
+    }
+
+    static Value hasNext(SqliteRows& self, const std::vector<Value>&, Context& context) {
+        return Bool(self.advance(context));
+    }
+
+    static Value next(SqliteRows& self, const std::vector<Value>&, Context& context) {
+        if (!self.advance(context)) {
+            throw EvaluationError("SqliteRows.next(): no more rows", context);
+        }
+        self.pending_ = false;
+        return rowMap(self.lease_.get());
+    }
+
+    static Value close(SqliteRows& self, const std::vector<Value>&, Context&) {
+        self.done_ = true;
+        self.pending_ = false;
+        self.lease_.release();
+        return Bool(true);
+    }
+
+   private:
+    // Steps to the next row unless one is waiting; the statement goes back once exhausted
+    bool advance(const Context& context) {
+        if (!pending_ && !done_) {
+            try {
+                pending_ = stepRow(lease_.get(), "SqliteRows.next()", context);
+            } catch (...) {
+                done_ = true;
+                lease_.release();
+                throw;
+            }
+            if (!pending_) {
+                done_ = true;
+                lease_.release();
+            }
+        }
+        return pending_;
+    }
+
+    StatementLease lease_;
+    bool pending_ = false;
+    bool done_ = false;
+};
+
+const std::array<NativeMethodEntry<SqliteRows>, 3> SqliteRows::kMethods = {{
+    {"close", &SqliteRows::close},
+    {"hasNext", &SqliteRows::hasNext},
+    {"next", &SqliteRows::next},
+}};
+
+// A prepared statement held by the program, with explicit bind and step
+class SqliteStatement : public NativeTableObject<SqliteStatement> {
+   public:
+    SqliteStatement(std::shared_ptr<SqliteDatabase> db, std::string sql, sqlite3_stmt* statement)
+        : NativeTableObject("SqliteStatement"), lease_(std::move(db), std::move(sql), statement) {}
+
+    static const std::array<NativeMethodEntry<SqliteStatement>, 13> kMethods;
+
+    static Value bind(SqliteStatement& self, const std::vector<Value>& args, Context& context) {
+        requireArgumentCount(args, 2, "SqliteStatement.bind()", context);
+        bindValue(self.statement(context), self.parameterIndex(args[0], context), args[1], true,
+                  "SqliteStatement.bind()", context);
+        return Bool(true);
+    }
+
+    static Value bindNull(SqliteStatement& self, const std::vector<Value>& args,
+                          Context& context) {
+        requireArgumentCount(args, 1, "SqliteStatement.bindNull()", context);
+        sqlite3_stmt* statement = self.statement(context);
+        if (sqlite3_bind_null(statement, self.parameterIndex(args[0], context)) != SQLITE_OK) {
+            throw sqliteError("SqliteStatement.bindNull()", statement, context);
+        }
+        return Bool(true);
+    }
+
+    static Value clearBindings(SqliteStatement& self, const std::vector<Value>&,
+                               Context& context) {
+        sqlite3_clear_bindings(self.statement(context));
+        return Bool(true);
+    }
+
+    static Value close(SqliteStatement& self, const std::vector<Value>&, Context&) {
+        self.has_row_ = false;
+        self.lease_.release();
+        return Bool(true);
+    }
+
+    static Value columnCount(SqliteStatement& self, const std::vector<Value>&,
+                             Context& context) {
+        return Int(sqlite3_column_count(self.statement(context)));
+    }
+
+    static Value columnNames(SqliteStatement& self, const std::vector<Value>&,
+                             Context& context) {
+        sqlite3_stmt* statement = self.statement(context);
+        auto names = std::make_shared<ListInstance>("Text");
+        for (int i = 0; i < sqlite3_column_count(statement); ++i) {
+            names->add(Text(sqlite3_column_name(statement, i)));
+        }
+        return names;
+    }
+
+    // Resets, binds `args` and runs to completion; the number of rows changed
+    static Value execute(SqliteStatement& self, const std::vector<Value>& args,
+                         Context& context) {
+        sqlite3_stmt* statement = self.restart(args, "SqliteStatement.execute()", context);
+        while (stepRow(statement, "SqliteStatement.execute()", context)) {
+        }
+        return Int(sqlite3_changes64(sqlite3_db_handle(statement)));
+    }
+
+    static Value get(SqliteStatement& self, const std::vector<Value>& args, Context& context) {
+        int column = self.column(args, "SqliteStatement.get()", context);
+        if (sqlite3_column_type(self.lease_.get(), column) == SQLITE_NULL) {
+            throw EvaluationError("SqliteStatement.get(): column " + std::to_string(column) +
+                                      " is NULL",
+                                  context);
+        }
+        return columnValue(self.lease_.get(), column);
+    }
+
+    static Value isNull(SqliteStatement& self, const std::vector<Value>& args, Context& context) {
+        int column = self.column(args, "SqliteStatement.isNull()", context);
+        return Bool(sqlite3_column_type(self.lease_.get(), column) == SQLITE_NULL);
+    }
+
+    static Value query(SqliteStatement& self, const std::vector<Value>& args, Context& context) {
+        sqlite3_stmt* statement = self.restart(args, "SqliteStatement.query()", context);
+        auto rows = allRows(statement, "SqliteStatement.query()", context);
+        sqlite3_reset(statement);
+        return rows;
+    }
+
+    static Value reset(SqliteStatement& self, const std::vector<Value>&, Context& context) {
+        sqlite3_reset(self.statement(context));
+        self.has_row_ = false;
+        return Bool(true);
+    }
+
+    static Value row(SqliteStatement& self, const std::vector<Value>&, Context& context) {
+        self.requireRow("SqliteStatement.row()", context);
+        return rowMap(self.lease_.get());
+    }
+
+    static Value step(SqliteStatement& self, const std::vector<Value>&, Context& context) {
+        self.has_row_ = stepRow(self.statement(context), "SqliteStatement.step()", context);
+        return Bool(self.has_row_);
+    }
+
+   private:
+    sqlite3_stmt* statement(const Context& context) const {
+        if (!lease_.get()) {
+            throw EvaluationError("SqliteStatement: statement is closed", context);
+        }
+        return lease_.get();
+    }
+
+    sqlite3_stmt* restart(const std::vector<Value>& args, const char* where,
+                          const Context& context) {
+        sqlite3_stmt* statement = this->statement(context);
+        sqlite3_reset(statement);
+        has_row_ = false;
+        bindParameters(statement, args, 0, true, where, context);
+        return statement;
+    }
+
+    // 1-based position, or a parameter name such as ":id"
+    int parameterIndex(const Value& parameter, const Context& context) const {
+        sqlite3_stmt* statement = this->statement(context);
+        int index = 0;
+        if (auto name = std::get_if<Text>(&parameter)) {
+            index = sqlite3_bind_parameter_index(statement, name->c_str());
+        } else if (auto position = std::get_if<Int>(&parameter)) {
+            index = *position >= 1 && *position <= sqlite3_bind_parameter_count(statement)
+                        ? static_cast<int>(*position)
+                        : 0;
+        }
+        if (index == 0) {
+            throw EvaluationError("SqliteStatement: unknown parameter " + valueToString(parameter),
+                                  context);
+        }
+        return index;
+    }
+
+    void requireRow(const char* where, const Context& context) const {
+        statement(context);
+        if (!has_row_) {
+            throw EvaluationError(std::string(where) + ": no current row; call step() first",
+                                  context);
+        }
+    }
+
+    int column(const std::vector<Value>& args, const char* where, const Context& context) const {
+        requireRow(where, context);
+        Int column = requireInt(args, 0, where, context);
+        if (column < 0 || column >= sqlite3_column_count(lease_.get())) {
+            throw EvaluationError(std::string(where) + ": column " + std::to_string(column) +
+                                      " out of range",
+                                  context);
+        }
+        return static_cast<int>(column);
+    }
+
+    StatementLease lease_;
+    bool has_row_ = false;
+};
+
+const std::array<NativeMethodEntry<SqliteStatement>, 13> SqliteStatement::kMethods = {{
+    {"bind", &SqliteStatement::bind},
+    {"bindNull", &SqliteStatement::bindNull},
+    {"clearBindings", &SqliteStatement::clearBindings},
+    {"close", &SqliteStatement::close},
+    {"columnCount", &SqliteStatement::columnCount},
+    {"columnNames", &SqliteStatement::columnNames},
+    {"execute", &SqliteStatement::execute},
+    {"get", &SqliteStatement::get},
+    {"isNull", &SqliteStatement::isNull},
+    {"query", &SqliteStatement::query},
+    {"reset", &SqliteStatement::reset},
+    {"row", &SqliteStatement::row},
+    {"step", &SqliteStatement::step},
+}};
+
+class SqliteConnection : public NativeTableObject<SqliteConnection> {
+   public:
+    explicit SqliteConnection(std::shared_ptr<SqliteDatabase> db)
+        : NativeTableObject("SqliteConnection"), db_(std::move(db)) {}
+
+    static const std::array<NativeMethodEntry<SqliteConnection>, 15> kMethods;
+
+    static Value begin(SqliteConnection& self, const std::vector<Value>&, Context& context) {
+        run(self.db_, "BEGIN", "SqliteConnection.begin()", context);
+        return Bool(true);
+    }
+
+    static Value cacheStats(SqliteConnection& self, const std::vector<Value>&, Context&) {
+        return self.db_->cacheStats();
+    }
+
+    static Value changes(SqliteConnection& self, const std::vector<Value>&, Context& context) {
+        return Int(sqlite3_changes64(self.db_->handle("SqliteConnection.changes()", context)));
+    }
+
+    static Value close(SqliteConnection& self, const std::vector<Value>&, Context&) {
+        self.db_->close();
+        return Bool(true);
+    }
+
+    static Value commit(SqliteConnection& self, const std::vector<Value>&, Context& context) {
+        run(self.db_, "COMMIT", "SqliteConnection.commit()", context);
+        return Bool(true);
+    }
+
+    // Runs one statement with parameters, or a script of several without; rows changed
+    static Value execute(SqliteConnection& self, const std::vector<Value>& args,
+                         Context& context) {
+        const char* where = "SqliteConnection.execute()";
+        const Text& sql = requireText(args, 0, where, context);
+        sqlite3_stmt* statement = self.db_->acquire(sql, where, context, args.size() == 1);
+        sqlite3* db = self.db_->handle(where, context);
+        if (!statement) {
+            char* error = nullptr;
+            if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+                std::string message = error ? error : sqlite3_errmsg(db);
+                sqlite3_free(error);
+                throw EvaluationError(std::string(where) + ": " + message, context);
+            }
+            return Int(sqlite3_changes64(db));
+        }
+        StatementLease lease(self.db_, sql, statement);
+        bindParameters(statement, args, 1, false, where, context);
+        while (stepRow(statement, where, context)) {
+        }
+        return Int(sqlite3_changes64(db));
+    }
+
+    // Inserts every row of a List of parameter Lists inside one savepoint, all or nothing
+    static Value insertAll(SqliteConnection& self, const std::vector<Value>& args,
+                           Context& context) {
+        const char* where = "SqliteConnection.insertAll()";
+        requireArgumentCount(args, 2, where, context);
+        const Text& sql = requireText(args, 0, where, context);
+        auto rows = std::get_if<std::shared_ptr<ListInstance>>(&args[1]);
+        if (!rows) {
+            throw EvaluationError(std::string(where) + ": argument 2 must be a List of Lists",
+                                  context);
+        }
+
+        run(self.db_, "SAVEPOINT o2l_insert_all", where, context);
+        Int inserted = 0;
+        try {
+            StatementLease lease(self.db_, sql, self.db_->acquire(sql, where, context));
+            sqlite3* db = self.db_->handle(where, context);
+            std::vector<Value> params(1);
+            for (const auto& row : (*rows)->getElements()) {
+                if (!std::holds_alternative<std::shared_ptr<ListInstance>>(row)) {
+                    throw EvaluationError(std::string(where) + ": each row must be a List",
+                                          context);
+                }
+                params[0] = row;
+                sqlite3_reset(lease.get());
+                bindParameters(lease.get(), params, 0, false, where, context);
+                while (stepRow(lease.get(), where, context)) {
+                }
+                inserted += sqlite3_changes64(db);
+            }
+        } catch (...) {
+            try {
+                run(self.db_, "ROLLBACK TO o2l_insert_all", where, context);
+                run(self.db_, "RELEASE o2l_insert_all", where, context);
+            } catch (...) {
+                // The original error is the one worth reporting
+            }
+            throw;
+        }
+        run(self.db_, "RELEASE o2l_insert_all", where, context);
+        return inserted;
+    }
+
+    static Value isOpen(SqliteConnection& self, const std::vector<Value>&, Context&) {
+        return Bool(self.db_->isOpen());
+    }
+
+    static Value lastInsertId(SqliteConnection& self, const std::vector<Value>&,
+                              Context& context) {
+        return Int(sqlite3_last_insert_rowid(
+            self.db_->handle("SqliteConnection.lastInsertId()", context)));
+    }
+
+    static Value prepare(SqliteConnection& self, const std::vector<Value>& args,
+                         Context& context) {
+        const char* where = "SqliteConnection.prepare()";
+        requireArgumentCount(args, 1, where, context);
+        const Text& sql = requireText(args, 0, where, context);
+        sqlite3_stmt* statement = self.db_->acquire(sql, where, context);
+        return std::shared_ptr<ObjectInstance>(
+            std::make_shared<SqliteStatement>(self.db_, sql, statement));
+    }
+
+    static Value query(SqliteConnection& self, const std::vector<Value>& args,
+                       Context& context) {
+        const char* where = "SqliteConnection.query()";
+        const Text& sql = requireText(args, 0, where, context);
+        StatementLease lease(self.db_, sql, self.db_->acquire(sql, where, context));
+        bindParameters(lease.get(), args, 1, false, where, context);
+        return allRows(lease.get(), where, context);
+    }
+
+    static Value rollback(SqliteConnection& self, const std::vector<Value>&, Context& context) {
+        run(self.db_, "ROLLBACK", "SqliteConnection.rollback()", context);
+        return Bool(true);
+    }
+
+    static Value rows(SqliteConnection& self, const std::vector<Value>& args, Context& context) {
+        const char* where = "SqliteConnection.rows()";
+        const Text& sql = requireText(args, 0, where, context);
+        auto rows = std::make_shared<SqliteRows>(self.db_, sql,
+                                                 self.db_->acquire(sql, where, context));
+        bindParameters(rows->statement(), args, 1, true, where, context);
+        return std::shared_ptr<ObjectInstance>(rows);
+    }
+
+    static Value setBusyTimeout(SqliteConnection& self, const std::vector<Value>& args,
+                                Context& context) {
+        const char* where = "SqliteConnection.setBusyTimeout()";
+        requireArgumentCount(args, 1, where, context);
+        Int milliseconds = requireInt(args, 0, where, context);
+        sqlite3_busy_timeout(self.db_->handle(where, context),
+                             static_cast<int>(std::clamp<Int>(milliseconds, 0, INT32_MAX)));
+        return Bool(true);
+    }
+
+    // Sets the journal mode ("wal", "delete", ...) and returns the mode now in effect
+    static Value setJournalMode(SqliteConnection& self, const std::vector<Value>& args,
+                                Context& context) {
+        const char* where = "SqliteConnection.setJournalMode()";
+        requireArgumentCount(args, 1, where, context);
+        Text mode = requireText(args, 0, where, context);
+        std::transform(mode.begin(), mode.end(), mode.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        static const std::array<std::string_view, 6> kModes = {"delete", "truncate", "persist",
+                                                               "memory", "wal",      "off"};
+        if (std::find(kModes.begin(), kModes.end(), mode) == kModes.end()) {
+            throw EvaluationError(std::string(where) + ": unknown journal mode '" + mode + "'",
+                                  context);
+        }
+        std::string sql = "PRAGMA journal_mode=" + mode;
+        StatementLease lease(self.db_, sql, self.db_->acquire(sql, where, context));
+        if (!stepRow(lease.get(), where, context)) {
+            return Text(mode);
+        }
+        return columnValue(lease.get(), 0);
+    }
+
+   private:
+    std::shared_ptr<SqliteDatabase> db_;
+};
+
+const std::array<NativeMethodEntry<SqliteConnection>, 15> SqliteConnection::kMethods = {{
+    {"begin", &SqliteConnection::begin},
+    {"cacheStats", &SqliteConnection::cacheStats},
+    {"changes", &SqliteConnection::changes},
+    {"close", &SqliteConnection::close},
+    {"commit", &SqliteConnection::commit},
+    {"execute", &SqliteConnection::execute},
+    {"insertAll", &SqliteConnection::insertAll},
+    {"isOpen", &SqliteConnection::isOpen},
+    {"lastInsertId", &SqliteConnection::lastInsertId},
+    {"prepare", &SqliteConnection::prepare},
+    {"query", &SqliteConnection::query},
+    {"rollback", &SqliteConnection::rollback},
+    {"rows", &SqliteConnection::rows},
+    {"setBusyTimeout", &SqliteConnection::setBusyTimeout},
+    {"setJournalMode", &SqliteConnection::setJournalMode},
+}};
+
+}  // namespace
+
+#endif  // HAVE_SQLITE3
+
+std::shared_ptr<ObjectInstance> SqliteLibrary::createSqliteObject() {
+    auto sqlite = std::make_shared<ObjectInstance>("sqlite");
+
+#ifdef HAVE_SQLITE3
+    // open(path, [statementCacheSize]): a connection; ":memory:" for a private in-memory database
+    sqlite->addMethod(
+        "open",
+        [](const std::vector<Value>& args, Context& context) -> Value {
+            const char* where = "sqlite.open()";
+            if (args.empty() || args.size() > 2) {
+                throw EvaluationError("sqlite.open() expects a path and an optional statement "
+                                      "cache size",
+                                      context);
+            }
+            const Text& path = requireText(args, 0, where, context);
+            size_t capacity = kDefaultStatementCacheCapacity;
+            if (args.size() == 2) {
+                capacity = static_cast<size_t>(std::max<Int>(requireInt(args, 1, where, context),
+                                                             0));
+            }
+            try {
+                return std::shared_ptr<ObjectInstance>(std::make_shared<SqliteConnection>(
+                    std::make_shared<SqliteDatabase>(path, capacity)));
+            } catch (const std::runtime_error& e) {
+                throw EvaluationError("sqlite.open(): cannot open '" + path + "': " + e.what(),
+                                      context);
+            }
+        },
+        true);
+
+    sqlite->addMethod(
+        "version",
+        [](const std::vector<Value>&, Context&) -> Value { return Text(sqlite3_libversion()); },
+        true);
+#else
+    sqlite->addMethod(
+        "open",
+        [](const std::vector<Value>&, Context& context) -> Value {
+            throw EvaluationError("db.sqlite is unavailable: O²L was built without SQLite",
+                                  context);
+        },
+        true);
+#endif
+
+    return sqlite;
+}
+
+}  // namespace o2l
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "ObjectInstance.hpp"
+
+namespace o2l {
+
+/**
+ * The db.sqlite module: SQLite connections linked into the interpreter (when built with
+ * SQLite; otherwise open() reports that the module is unavailable).
+ *
+ * Each connection keeps an LRU cache of prepared statements keyed by SQL text. A statement
+ * is checked out of the cache while a query, a row iterator or a prepared statement object
+ * uses it and goes back, reset, when that use ends, so repeated queries skip parsing and
+ * planning. Column values are returned as Int, Double or Text straight from the statement;
+ * rows are Maps from column name to value, with SQL NULL columns left out.
+ */
+class SqliteLibrary {
+   public:
+    static std::shared_ptr<ObjectInstance> createSqliteObject();
+};
+
+}  // namespace o2l
@@ -29,10 +29,13 @@
 
 #include "../Common/Exceptions.hpp"
 #include "EnumInstance.hpp"
+#include "HeapProfiler.hpp"
 #include "ListInstance.hpp"
 #include "MapInstance.hpp"
 #include "MapIterator.hpp"
 #include "MapObject.hpp"
+#include "NumberConversion.hpp"
+#include "OutputBuffer.hpp"
 #include "RecordInstance.hpp"
 #include "RecordType.hpp"
 #include "RepeatIterator.hpp"
@@ -52,9 +55,6 @@
 #include <unistd.h>
 #endif
 
-// Forward declaration of longToString from Value.cpp
-extern std::string longToString(o2l::Long value);
-
 namespace o2l {
 
 std::shared_ptr<ObjectInstance> SystemLibrary::createIOObject() {
@@ -72,6 +72,12 @@ std::shared_ptr<ObjectInstance> SystemLibrary::createIOObject() {
     };
     io_object->addMethod("input", input_method, true);  // external
 
+    // Add native flush method - writes out buffered print() output
+    Method flush_method = [](const std::vector<Value>& args, Context& ctx) -> Value {
+        return SystemLibrary::nativeFlush(args, ctx);
+    };
+    io_object->addMethod("flush", flush_method, true);  // external
+
     return io_object;
 }
 
@@ -189,6 +195,13 @@ std::shared_ptr<ObjectInstance> SystemLibrary::createOSObject() {
         },
         true);
 
+    os_object->addMethod(
+        "heapCensus",
+        [](const std::vector<Value>& args, Context& ctx) -> Value {
+            return SystemLibrary::nativeHeapCensus(args, ctx);
+        },
+        true);
+
     // Add CPU information methods
     os_object->addMethod(
         "getCPUCount",
@@ -374,7 +387,7 @@ std::shared_ptr<ObjectInstance> SystemLibrary::createFSObject() {
 
 Value SystemLibrary::nativePrint(const std::vector<Value>& args, Context& context) {
     if (args.empty()) {
-        std::cout << std::endl;
+        OutputBuffer::local().write([](std::string& out) { out += '\n'; });
         return Text("");
     }
 
@@ -383,20 +396,26 @@ Value SystemLibrary::nativePrint(const std::vector<Value>& args, Context& contex
         throw EvaluationError("print() first argument must be a Text (format string)");
     }
 
-    std::string format = std::get<Text>(args[0]);
-
-    // If only format string provided, print it directly
-    if (args.size() == 1) {
-        std::cout << format << std::endl;
-        return Text(format);
-    }
+    const std::string& format = std::get<Text>(args[0]);
 
-    // Format string with additional arguments
-    std::vector<Value> format_args(args.begin() + 1, args.end());
-    std::string formatted = formatString(format, format_args);
+    // Format straight into this thread's output buffer; the line is also the return value
+    Text printed;
+    OutputBuffer::local().write([&](std::string& out) {
+        size_t start = out.size();
+        if (args.size() == 1) {
+            out += format;
+        } else {
+            formatInto(out, format, args.data() + 1, args.size() - 1);
+        }
+        printed.assign(out, start, std::string::npos);
+        out += '\n';
+    });
+    return printed;
+}
 
-    std::cout << formatted << std::endl;
-    return Text(formatted);
+Value SystemLibrary::nativeFlush(const std::vector<Value>& args, Context& context) {
+    OutputBuffer::flushAll();
+    return Text("");
 }
 
 Value SystemLibrary::nativeInput(const std::vector<Value>& args, Context& context) {
@@ -405,9 +424,11 @@ Value SystemLibrary::nativeInput(const std::vector<Value>& args, Context& contex
         if (!std::holds_alternative<Text>(args[0])) {
             throw EvaluationError("input() argument must be a Text (prompt)");
         }
-        std::string prompt = std::get<Text>(args[0]);
-        std::cout << prompt;
+        const std::string& prompt = std::get<Text>(args[0]);
+        OutputBuffer::local().write([&](std::string& out) { out += prompt; });
     }
+    // Pending output, the prompt included, is shown before waiting for the user
+    OutputBuffer::flushAll();
 
     // Read line from stdin
     std::string input_line;
@@ -418,6 +439,12 @@ Value SystemLibrary::nativeInput(const std::vector<Value>& args, Context& contex
 
 std::string SystemLibrary::formatString(const std::string& format, const std::vector<Value>& args) {
     std::string result;
+    formatInto(result, format, args.data(), args.size());
+    return result;
+}
+
+void SystemLibrary::formatInto(std::string& result, const std::string& format, const Value* args,
+                               size_t arg_count) {
     size_t arg_index = 0;
 
     for (size_t i = 0; i < format.length(); ++i) {
@@ -429,7 +456,7 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
                 continue;
             }
 
-            if (arg_index < args.size()) {
+            if (arg_index < arg_count) {
                 std::string replacement;
                 size_t format_start = i;
                 i++;  // Move past the %
@@ -444,7 +471,8 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
                         i++;
                     }
                     if (!precision_str.empty()) {
-                        precision = std::stoi(precision_str);
+                        precision = static_cast<int>(
+                            numeric::parseInt(precision_str).value_or(6));
                     }
                 }
 
@@ -461,9 +489,9 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
                         case 'd':
                             // Integer format - works with Int and Long
                             if (std::holds_alternative<Int>(args[arg_index])) {
-                                replacement = std::to_string(std::get<Int>(args[arg_index]));
+                                replacement = numeric::formatInt(std::get<Int>(args[arg_index]));
                             } else if (std::holds_alternative<Long>(args[arg_index])) {
-                                replacement = longToString(std::get<Long>(args[arg_index]));
+                                replacement = numeric::formatLong(std::get<Long>(args[arg_index]));
                             } else {
                                 replacement = "[non-integer]";
                             }
@@ -472,11 +500,10 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
                         case 'l':
                             // Long format - specifically for Long integers
                             if (std::holds_alternative<Long>(args[arg_index])) {
-                                replacement = longToString(std::get<Long>(args[arg_index]));
+                                replacement = numeric::formatLong(std::get<Long>(args[arg_index]));
                             } else if (std::holds_alternative<Int>(args[arg_index])) {
                                 // Allow Int to be formatted as Long
-                                replacement =
-                                    longToString(static_cast<Long>(std::get<Int>(args[arg_index])));
+                                replacement = numeric::formatLong(std::get<Int>(args[arg_index]));
                             } else {
                                 replacement = "[non-long]";
                             }
@@ -486,32 +513,20 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
                             // Float format - works with Float and Double, with precision support
                             if (std::holds_alternative<Float>(args[arg_index])) {
                                 double val = static_cast<double>(std::get<Float>(args[arg_index]));
-                                if (precision >= 0) {
-                                    std::ostringstream oss;
-                                    oss << std::fixed << std::setprecision(precision) << val;
-                                    replacement = oss.str();
-                                } else {
-                                    replacement = std::to_string(val);
-                                }
+                                // printf's "%f" prints six decimals when none are given
+                                replacement =
+                                    numeric::formatFixed(val, precision >= 0 ? precision : 6);
                             } else if (std::holds_alternative<Double>(args[arg_index])) {
                                 double val = std::get<Double>(args[arg_index]);
-                                if (precision >= 0) {
-                                    std::ostringstream oss;
-                                    oss << std::fixed << std::setprecision(precision) << val;
-                                    replacement = oss.str();
-                                } else {
-                                    replacement = std::to_string(val);
-                                }
+                                // printf's "%f" prints six decimals when none are given
+                                replacement =
+                                    numeric::formatFixed(val, precision >= 0 ? precision : 6);
                             } else if (std::holds_alternative<Int>(args[arg_index])) {
                                 // Allow integers to be formatted as floats
                                 double val = static_cast<double>(std::get<Int>(args[arg_index]));
-                                if (precision >= 0) {
-                                    std::ostringstream oss;
-                                    oss << std::fixed << std::setprecision(precision) << val;
-                                    replacement = oss.str();
-                                } else {
-                                    replacement = std::to_string(val);
-                                }
+                                // printf's "%f" prints six decimals when none are given
+                                replacement =
+                                    numeric::formatFixed(val, precision >= 0 ? precision : 6);
                             } else {
                                 replacement = "[non-numeric]";
                             }
@@ -543,21 +558,19 @@ std::string SystemLibrary::formatString(const std::string& format, const std::ve
             result += format[i];
         }
     }
-
-    return result;
 }
 
 std::string SystemLibrary::valueToDisplayString(const Value& value) {
     if (std::holds_alternative<Text>(value)) {
         return std::get<Text>(value);
     } else if (std::holds_alternative<Int>(value)) {
-        return std::to_string(std::get<Int>(value));
+        return numeric::formatInt(std::get<Int>(value));
     } else if (std::holds_alternative<Long>(value)) {
-        return longToString(std::get<Long>(value));
+        return numeric::formatLong(std::get<Long>(value));
     } else if (std::holds_alternative<Float>(value)) {
-        return std::to_string(std::get<Float>(value));
+        return numeric::formatFloat(std::get<Float>(value));
     } else if (std::holds_alternative<Double>(value)) {
-        return std::to_string(std::get<Double>(value));
+        return numeric::formatDouble(std::get<Double>(value));
     } else if (std::holds_alternative<Bool>(value)) {
         return std::get<Bool>(value) ? "true" : "false";
     } else if (std::holds_alternative<Char>(value)) {
@@ -1129,7 +1142,7 @@ Value SystemLibrary::nativeGetTotalMemory(const std::vector<Value>& args, Contex
 #elif __APPLE__
         std::string mem_str = executeSystemCommand("sysctl -n hw.memsize");
         if (!mem_str.empty()) {
-            Long bytes = std::stoll(mem_str);
+            Long bytes = numeric::parseLongPrefix(numeric::trim(mem_str)).value_or(0);
             return Long(bytes / 1024);  // Convert to KB
         }
 #endif
@@ -1151,7 +1164,7 @@ Value SystemLibrary::nativeGetAvailableMemory(const std::vector<Value>& args, Co
         std::string vm_stat_output =
             executeSystemCommand("vm_stat | grep 'Pages free' | awk '{print $3}' | sed 's/\\.//'");
         if (!vm_stat_output.empty()) {
-            Long free_pages = std::stoll(vm_stat_output);
+            Long free_pages = numeric::parseLongPrefix(numeric::trim(vm_stat_output)).value_or(0);
             // Assuming 4KB page size on macOS
             return Long(free_pages * 4);
         }
@@ -1179,8 +1192,8 @@ Value SystemLibrary::nativeGetUsedMemory(const std::vector<Value>& args, Context
         std::string vm_stat_output =
             executeSystemCommand("vm_stat | grep 'Pages free' | awk '{print $3}' | sed 's/\\.//'");
         if (!total_mem.empty() && !vm_stat_output.empty()) {
-            Long total_kb = std::stoll(total_mem) / 1024;
-            Long free_pages = std::stoll(vm_stat_output);
+            Long total_kb = numeric::parseLongPrefix(numeric::trim(total_mem)).value_or(0) / 1024;
+            Long free_pages = numeric::parseLongPrefix(numeric::trim(vm_stat_output)).value_or(0);
             Long free_kb = free_pages * 4;
             return Long(total_kb - free_kb);
         }
@@ -1212,8 +1225,8 @@ Value SystemLibrary::nativeGetMemoryUsage(const std::vector<Value>& args, Contex
         std::string vm_stat_output =
             executeSystemCommand("vm_stat | grep 'Pages free' | awk '{print $3}' | sed 's/\\.//'");
         if (!total_mem.empty() && !vm_stat_output.empty()) {
-            Long total_kb = std::stoll(total_mem) / 1024;
-            Long free_pages = std::stoll(vm_stat_output);
+            Long total_kb = numeric::parseLongPrefix(numeric::trim(total_mem)).value_or(0) / 1024;
+            Long free_pages = numeric::parseLongPrefix(numeric::trim(vm_stat_output)).value_or(0);
             Long free_kb = free_pages * 4;
             Long used_kb = total_kb - free_kb;
             if (total_kb > 0) {
@@ -1228,6 +1241,30 @@ Value SystemLibrary::nativeGetMemoryUsage(const std::vector<Value>& args, Contex
     }
 }
 
+Value SystemLibrary::nativeHeapCensus(const std::vector<Value>& args, Context& context) {
+    if (args.size() != 0) {
+        throw EvaluationError("heapCensus() takes no arguments");
+    }
+
+    HeapProfiler::Census census = HeapProfiler::census(context);
+    auto rows = [](const std::vector<HeapProfiler::CensusEntry>& entries) {
+        auto list = std::make_shared<ListInstance>("Map<Text, Value>");
+        for (const auto& entry : entries) {
+            auto row = std::make_shared<MapInstance>("Text", "Value");
+            row->put(Text("type"), Text(entry.type));
+            row->put(Text("class"), Text(entry.class_name));
+            row->put(Text("count"), Int(entry.count));
+            row->put(Text("bytes"), Int(entry.bytes));
+            list->add(row);
+        }
+        return list;
+    };
+    auto result = std::make_shared<MapInstance>("Text", "List");
+    result->put(Text("types"), rows(census.by_type));
+    result->put(Text("classes"), rows(census.by_class));
+    return result;
+}
+
 // ============================================================================
 // CPU Information Methods
 // ============================================================================
@@ -1241,12 +1278,12 @@ Value SystemLibrary::nativeGetCPUCount(const std::vector<Value>& args, Context&
 #ifdef __linux__
         std::string nproc_str = executeSystemCommand("nproc");
         if (!nproc_str.empty()) {
-            return Int(std::stoi(nproc_str));
+            return numeric::parseIntPrefix(numeric::trim(nproc_str)).value_or(1);
         }
 #elif __APPLE__
         std::string cpu_count = executeSystemCommand("sysctl -n hw.ncpu");
         if (!cpu_count.empty()) {
-            return Int(std::stoi(cpu_count));
+            return numeric::parseIntPrefix(numeric::trim(cpu_count)).value_or(1);
         }
 #endif
 
@@ -1292,7 +1329,7 @@ Value SystemLibrary::nativeGetCPUUsage(const std::vector<Value>& args, Context&
         std::string cpu_usage = executeSystemCommand(
             "top -l1 -n0 | grep 'CPU usage:' | awk '{print $3}' | sed 's/%//'");
         if (!cpu_usage.empty()) {
-            return Double(std::stod(cpu_usage));
+            return Double(numeric::parseDoublePrefix(numeric::trim(cpu_usage)).value_or(0.0));
         }
         return Double(0.0);
 #else
@@ -1330,12 +1367,10 @@ Value SystemLibrary::nativeGetLoadAverage(const std::vector<Value>& args, Contex
                 token.erase(0, token.find_first_not_of(" \t"));    // trim leading spaces
                 token.erase(token.find_last_not_of(" \t\n") + 1);  // trim trailing spaces
                 if (!token.empty()) {
-                    try {
-                        double val = std::stod(token);
-                        list_instance->add(Double(val));
+                    // Invalid values are skipped
+                    if (auto val = numeric::parseDoublePrefix(token)) {
+                        list_instance->add(Double(*val));
                         count++;
-                    } catch (const std::exception&) {
-                        // Skip invalid values
                     }
                 }
             }
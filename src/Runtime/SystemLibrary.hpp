@@ -44,6 +44,9 @@ class SystemLibrary {
     // Native print function implementation
     static Value nativePrint(const std::vector<Value>& args, Context& context);
 
+    // Native flush function implementation - writes out buffered print() output
+    static Value nativeFlush(const std::vector<Value>& args, Context& context);
+
     // Native input function implementation
     static Value nativeInput(const std::vector<Value>& args, Context& context);
 
@@ -75,6 +78,7 @@ class SystemLibrary {
     static Value nativeGetAvailableMemory(const std::vector<Value>& args, Context& context);
     static Value nativeGetUsedMemory(const std::vector<Value>& args, Context& context);
     static Value nativeGetMemoryUsage(const std::vector<Value>& args, Context& context);
+    static Value nativeHeapCensus(const std::vector<Value>& args, Context& context);
 
     // Native CPU information function implementations
     static Value nativeGetCPUCount(const std::vector<Value>& args, Context& context);
@@ -114,6 +118,9 @@ class SystemLibrary {
    private:
     // Helper function for string formatting
     static std::string formatString(const std::string& format, const std::vector<Value>& args);
+    // Appends the formatted text to `result`
+    static void formatInto(std::string& result, const std::string& format, const Value* args,
+                           size_t arg_count);
 
     // Helper to convert Value to string for printing
     static std::string valueToDisplayString(const Value& value);
@@ -25,6 +25,7 @@
 
 #include "../Common/Exceptions.hpp"
 #include "ListInstance.hpp"
+#include "NumberConversion.hpp"
 
 namespace o2l {
 
@@ -731,13 +732,13 @@ Value TestLibrary::afterEach(const std::vector<Value>& args, Context& context) {
 // Helper function implementations
 std::string TestLibrary::valueToString(const Value& value) {
     if (std::holds_alternative<Int>(value)) {
-        return std::to_string(std::get<Int>(value));
+        return numeric::formatInt(std::get<Int>(value));
     } else if (std::holds_alternative<Long>(value)) {
-        return std::to_string(static_cast<long long>(std::get<Long>(value)));
+        return numeric::formatLong(std::get<Long>(value));
     } else if (std::holds_alternative<Float>(value)) {
-        return std::to_string(std::get<Float>(value));
+        return numeric::formatFloat(std::get<Float>(value));
     } else if (std::holds_alternative<Double>(value)) {
-        return std::to_string(std::get<Double>(value));
+        return numeric::formatDouble(std::get<Double>(value));
     } else if (std::holds_alternative<Bool>(value)) {
         return std::get<Bool>(value) ? "true" : "false";
     } else if (std::holds_alternative<Text>(value)) {
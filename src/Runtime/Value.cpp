@@ -26,6 +26,7 @@
 #include "MapInstance.hpp"
 #include "MapIterator.hpp"
 #include "MapObject.hpp"
+#include "NumberConversion.hpp"
 #include "ObjectInstance.hpp"
 #include "RecordInstance.hpp"
 #include "RecordType.hpp"
@@ -35,32 +36,6 @@
 #include "SetIterator.hpp"
 #include "FFI/FFITypes.hpp"
 
-// Helper function to convert Long (__int128) to string
-std::string longToString(o2l::Long value) {
-#ifdef __SIZEOF_INT128__
-    if (value == 0) return "0";
-
-    std::string result;
-    bool negative = value < 0;
-    if (negative) {
-        value = -value;
-    }
-
-    while (value > 0) {
-        result = char('0' + (value % 10)) + result;
-        value /= 10;
-    }
-
-    if (negative) {
-        result = "-" + result;
-    }
-
-    return result;
-#else
-    return std::to_string(static_cast<long long>(value));
-#endif
-}
-
 namespace o2l {
 
 std::string valueToString(const Value& value) {
@@ -69,13 +44,13 @@ std::string valueToString(const Value& value) {
             using T = std::decay_t<decltype(v)>;
 
             if constexpr (std::is_same_v<T, Int>) {
-                return std::to_string(v);
+                return numeric::formatInt(v);
             } else if constexpr (std::is_same_v<T, Long>) {
-                return longToString(v);
+                return numeric::formatLong(v);
             } else if constexpr (std::is_same_v<T, Float>) {
-                return std::to_string(v);
+                return numeric::formatFloat(v);
             } else if constexpr (std::is_same_v<T, Double>) {
-                return std::to_string(v);
+                return numeric::formatDouble(v);
             } else if constexpr (std::is_same_v<T, Text>) {
                 return v;
             } else if constexpr (std::is_same_v<T, Bool>) {
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TypeChecker.hpp"
+
+#include "AST/BinaryOpNode.hpp"
+#include "AST/BlockNode.hpp"
+#include "AST/ComparisonNode.hpp"
+#include "AST/ConstDeclarationNode.hpp"
+#include "AST/ConstructorDeclarationNode.hpp"
+#include "AST/IdentifierNode.hpp"
+#include "AST/IfStatementNode.hpp"
+#include "AST/ListLiteralNode.hpp"
+#include "AST/LiteralNode.hpp"
+#include "AST/LogicalNode.hpp"
+#include "AST/MapLiteralNode.hpp"
+#include "AST/MemberAccessNode.hpp"
+#include "AST/MethodCallNode.hpp"
+#include "AST/MethodDeclarationNode.hpp"
+#include "AST/NamespaceNode.hpp"
+#include "AST/NewExpressionNode.hpp"
+#include "AST/ObjectNode.hpp"
+#include "AST/PropertyAssignmentNode.hpp"
+#include "AST/PropertyDeclarationNode.hpp"
+#include "AST/ReturnNode.hpp"
+#include "AST/SetLiteralNode.hpp"
+#include "AST/ThisNode.hpp"
+#include "AST/ThrowNode.hpp"
+#include "AST/TryCatchFinallyNode.hpp"
+#include "AST/UnaryNode.hpp"
+#include "AST/VariableAssignmentNode.hpp"
+#include "AST/VariableDeclarationNode.hpp"
+#include "AST/WhileStatementNode.hpp"
+
+namespace o2l {
+
+namespace {
+
+StaticType literalType(const Value& value) {
+    if (std::holds_alternative<Int>(value)) return StaticType::Int;
+    if (std::holds_alternative<Long>(value)) return StaticType::Long;
+    if (std::holds_alternative<Float>(value)) return StaticType::Float;
+    if (std::holds_alternative<Double>(value)) return StaticType::Double;
+    if (std::holds_alternative<Text>(value)) return StaticType::Text;
+    if (std::holds_alternative<Bool>(value)) return StaticType::Bool;
+    if (std::holds_alternative<Char>(value)) return StaticType::Char;
+    return StaticType::Unknown;
+}
+
+// Result type of arithmetic on two numeric types, following BinaryOpNode's promotions
+StaticType arithmeticType(StaticType left, StaticType right) {
+    if (left == StaticType::Double || right == StaticType::Double) return StaticType::Double;
+    if (left == StaticType::Float || right == StaticType::Float) return StaticType::Float;
+    if (left == StaticType::Long || right == StaticType::Long) return StaticType::Long;
+    return StaticType::Int;
+}
+
+const char* binaryOperatorName(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::PLUS:
+            return "+";
+        case BinaryOperator::MINUS:
+            return "-";
+        case BinaryOperator::MULTIPLY:
+            return "*";
+        case BinaryOperator::DIVIDE:
+            return "/";
+        case BinaryOperator::MODULO:
+            return "%";
+    }
+    return "?";
+}
+
+bool isOrdering(ComparisonOperator op) {
+    return op != ComparisonOperator::EQUAL && op != ComparisonOperator::NOT_EQUAL;
+}
+
+}  // namespace
+
+void TypeChecker::addProgram(const std::vector<ASTNodePtr>& nodes) {
+    programs_.push_back(&nodes);
+    collectObjects(nodes);
+}
+
+void TypeChecker::collectObjects(const std::vector<ASTNodePtr>& nodes) {
+    for (const auto& node : nodes) {
+        if (auto namespace_node = dynamic_cast<NamespaceNode*>(node.get())) {
+            collectObjects(namespace_node->getBody());
+            continue;
+        }
+        auto object = dynamic_cast<ObjectNode*>(node.get());
+        if (!object || ambiguous_.count(object->getName())) {
+            continue;
+        }
+        // Objects declared under the same name in several modules are not checked
+        if (objects_.count(object->getName())) {
+            objects_.erase(object->getName());
+            ambiguous_.insert(object->getName());
+            continue;
+        }
+        ObjectSignature& signature = objects_[object->getName()];
+        for (const auto& method_node : object->getMethods()) {
+            if (auto method = dynamic_cast<MethodDeclarationNode*>(method_node.get())) {
+                MethodSignature& method_signature = signature.methods[method->getName()];
+                for (const auto& parameter : method->getParameters()) {
+                    method_signature.parameter_types.push_back(parameter.type);
+                }
+                method_signature.return_type = method->getReturnType();
+            }
+        }
+        for (const auto& property_node : object->getProperties()) {
+            if (auto property = dynamic_cast<PropertyDeclarationNode*>(property_node.get())) {
+                signature.properties[property->getPropertyName()] = property->getTypeName();
+            }
+        }
+        if (auto constructor =
+                dynamic_cast<ConstructorDeclarationNode*>(object->getConstructor().get())) {
+            signature.constructor_arity = constructor->getParameters().size();
+        }
+    }
+}
+
+const std::vector<TypeChecker::Diagnostic>& TypeChecker::check() {
+    for (const auto* nodes : programs_) {
+        checkDeclarations(*nodes);
+    }
+    return diagnostics_;
+}
+
+void TypeChecker::checkDeclarations(const std::vector<ASTNodePtr>& nodes) {
+    for (const auto& node : nodes) {
+        if (auto namespace_node = dynamic_cast<NamespaceNode*>(node.get())) {
+            checkDeclarations(namespace_node->getBody());
+        } else if (auto object = dynamic_cast<ObjectNode*>(node.get())) {
+            checkObject(*object);
+        }
+    }
+}
+
+void TypeChecker::checkObject(const ObjectNode& object) {
+    auto found = objects_.find(object.getName());
+    current_object_ = found != objects_.end() ? &found->second : nullptr;
+
+    if (auto constructor =
+            dynamic_cast<ConstructorDeclarationNode*>(object.getConstructor().get())) {
+        locals_.clear();
+        for (const auto& parameter : constructor->getParameters()) {
+            locals_[parameter.name] = parameter.type;
+        }
+        checkBody(constructor->getBody(), "");
+    }
+    for (const auto& method_node : object.getMethods()) {
+        if (auto method = dynamic_cast<MethodDeclarationNode*>(method_node.get())) {
+            locals_.clear();
+            for (const auto& parameter : method->getParameters()) {
+                locals_[parameter.name] = parameter.type;
+            }
+            statement_location_ = method->getSourceLocation();
+            checkBody(method->getBody(), method->getReturnType());
+        }
+    }
+    current_object_ = nullptr;
+}
+
+void TypeChecker::checkBody(const ASTNodePtr& body, const std::string& return_type) {
+    return_type_ = return_type;
+    if (body) {
+        checkStatement(body);
+    }
+}
+
+void TypeChecker::checkStatement(const ASTNodePtr& node) {
+    if (!node) {
+        return;
+    }
+    if (node->getSourceLocation().line_number > 0) {
+        statement_location_ = node->getSourceLocation();
+    }
+
+    if (auto block = dynamic_cast<BlockNode*>(node.get())) {
+        for (const auto& statement : block->getStatements()) {
+            checkStatement(statement);
+        }
+    } else if (auto declaration = dynamic_cast<VariableDeclarationNode*>(node.get())) {
+        StaticType declared = staticTypeFromName(declaration->getTypeName());
+        StaticType actual = inferExpression(declaration->getInitializer());
+        if (!isAssignableStaticType(declared, actual)) {
+            error(*node, "'" + declaration->getVariableName() + "' is declared as " +
+                             declaration->getTypeName() + " but initialized with " +
+                             staticTypeName(actual));
+        }
+        locals_[declaration->getVariableName()] = declaration->getTypeName();
+        node->setStaticType(declared);
+    } else if (auto assignment = dynamic_cast<VariableAssignmentNode*>(node.get())) {
+        StaticType actual = inferExpression(assignment->getValueExpressionPtr());
+        std::string declared_name = localType(assignment->getVariableName());
+        if (!isAssignableStaticType(staticTypeFromName(declared_name), actual)) {
+            error(*node, "Cannot assign " + std::string(staticTypeName(actual)) + " to '" +
+                             assignment->getVariableName() + "' of type " + declared_name);
+        }
+    } else if (auto constant = dynamic_cast<ConstDeclarationNode*>(node.get())) {
+        StaticType actual = inferExpression(constant->getInitializer());
+        if (!isAssignableStaticType(staticTypeFromName(constant->getTypeName()), actual)) {
+            error(*node, "Constant '" + constant->getConstName() + "' is declared as " +
+                             constant->getTypeName() + " but initialized with " +
+                             staticTypeName(actual));
+        }
+        locals_[constant->getConstName()] = constant->getTypeName();
+    } else if (auto property = dynamic_cast<PropertyAssignmentNode*>(node.get())) {
+        StaticType actual = inferExpression(property->getValueExpression());
+        if (current_object_) {
+            auto found = current_object_->properties.find(property->getPropertyName());
+            if (found != current_object_->properties.end() &&
+                !isAssignableStaticType(staticTypeFromName(found->second), actual)) {
+                error(*node, "Cannot assign " + std::string(staticTypeName(actual)) +
+                                 " to property '" + property->getPropertyName() +
+                                 "' of type " + found->second);
+            }
+        }
+    } else if (auto return_node = dynamic_cast<ReturnNode*>(node.get())) {
+        if (return_node->getExpression()) {
+            StaticType actual = inferExpression(return_node->getExpression());
+            if (!isAssignableStaticType(staticTypeFromName(return_type_), actual)) {
+                error(*node, "Method returns " + return_type_ + " but the expression is " +
+                                 staticTypeName(actual));
+            }
+        }
+    } else if (auto if_node = dynamic_cast<IfStatementNode*>(node.get())) {
+        inferExpression(if_node->getCondition());
+        checkStatement(if_node->getThenBranch());
+        checkStatement(if_node->getElseBranch());
+    } else if (auto while_node = dynamic_cast<WhileStatementNode*>(node.get())) {
+        inferExpression(while_node->getCondition());
+        checkStatement(while_node->getBody());
+    } else if (auto try_node = dynamic_cast<TryCatchFinallyNode*>(node.get())) {
+        checkStatement(try_node->getTryBlock());
+        if (!try_node->getCatchVariable().empty()) {
+            locals_[try_node->getCatchVariable()] = "";
+        }
+        checkStatement(try_node->getCatchBlock());
+        checkStatement(try_node->getFinallyBlock());
+    } else if (auto throw_node = dynamic_cast<ThrowNode*>(node.get())) {
+        inferExpression(throw_node->getExpression());
+    } else {
+        inferExpression(node);
+    }
+}
+
+StaticType TypeChecker::inferExpression(const ASTNodePtr& node) {
+    if (!node) {
+        return StaticType::Unknown;
+    }
+    StaticType type = StaticType::Unknown;
+
+    if (auto literal = dynamic_cast<LiteralNode*>(node.get())) {
+        type = literalType(literal->getValue());
+    } else if (auto identifier = dynamic_cast<IdentifierNode*>(node.get())) {
+        type = staticTypeFromName(localType(identifier->getName()));
+    } else if (auto member = dynamic_cast<MemberAccessNode*>(node.get())) {
+        inferExpression(member->getObjectExpression());
+        if (current_object_ && dynamic_cast<ThisNode*>(member->getObjectExpression().get())) {
+            auto found = current_object_->properties.find(member->getMemberName());
+            if (found != current_object_->properties.end()) {
+                type = staticTypeFromName(found->second);
+            }
+        }
+    } else if (auto binary = dynamic_cast<BinaryOpNode*>(node.get())) {
+        StaticType left = inferExpression(binary->getLeft());
+        StaticType right = inferExpression(binary->getRight());
+        if (isNumericStaticType(left) && isNumericStaticType(right)) {
+            type = arithmeticType(left, right);
+        } else if (left == StaticType::Text && right == StaticType::Text &&
+                   binary->getOperator() == BinaryOperator::PLUS) {
+            type = StaticType::Text;
+        } else if (left != StaticType::Unknown && right != StaticType::Unknown) {
+            error(*node, std::string("Operator '") + binaryOperatorName(binary->getOperator()) +
+                             "' cannot be applied to " + staticTypeName(left) + " and " +
+                             staticTypeName(right));
+        }
+    } else if (auto comparison = dynamic_cast<ComparisonNode*>(node.get())) {
+        StaticType left = inferExpression(comparison->getLeft());
+        StaticType right = inferExpression(comparison->getRight());
+        if (isOrdering(comparison->getOperator()) && left != StaticType::Unknown &&
+            right != StaticType::Unknown) {
+            // ComparisonNode orders equal primitive types (Bool aside) and Int against Float
+            bool int_and_float = (left == StaticType::Int && right == StaticType::Float) ||
+                                 (left == StaticType::Float && right == StaticType::Int);
+            bool same_ordered = left == right && left != StaticType::Bool &&
+                                left <= StaticType::Char;
+            if (!int_and_float && !same_ordered) {
+                error(*node, std::string("Cannot order ") + staticTypeName(left) + " and " +
+                                 staticTypeName(right));
+            }
+        }
+        type = StaticType::Bool;
+    } else if (auto logical = dynamic_cast<LogicalNode*>(node.get())) {
+        inferExpression(logical->getLeft());
+        inferExpression(logical->getRight());
+        type = StaticType::Bool;
+    } else if (auto unary = dynamic_cast<UnaryNode*>(node.get())) {
+        StaticType operand = inferExpression(unary->getOperand());
+        if (unary->getOperator() == UnaryOperator::NOT) {
+            type = StaticType::Bool;
+        } else if (isNumericStaticType(operand)) {
+            type = operand;
+        }
+    } else if (auto list = dynamic_cast<ListLiteralNode*>(node.get())) {
+        for (const auto& element : list->getElements()) {
+            inferExpression(element);
+        }
+        type = StaticType::List;
+    } else if (auto map = dynamic_cast<MapLiteralNode*>(node.get())) {
+        for (const auto& [key, value] : map->getEntries()) {
+            inferExpression(key);
+            inferExpression(value);
+        }
+        type = StaticType::Map;
+    } else if (auto set = dynamic_cast<SetLiteralNode*>(node.get())) {
+        for (const auto& element : set->getElements()) {
+            inferExpression(element);
+        }
+        type = StaticType::Set;
+    } else if (auto creation = dynamic_cast<NewExpressionNode*>(node.get())) {
+        for (const auto& argument : creation->getConstructorArgs()) {
+            inferExpression(argument);
+        }
+        auto found = objects_.find(creation->getObjectTypeName());
+        size_t given = creation->getConstructorArgs().size();
+        if (found != objects_.end() && given != found->second.constructor_arity) {
+            error(*node, "Constructor of '" + creation->getObjectTypeName() + "' expects " +
+                             std::to_string(found->second.constructor_arity) +
+                             " arguments, got " + std::to_string(given));
+        }
+    } else if (dynamic_cast<MethodCallNode*>(node.get())) {
+        type = inferMethodCall(*node);
+    }
+
+    node->setStaticType(type);
+    return type;
+}
+
+StaticType TypeChecker::inferMethodCall(ASTNode& node) {
+    auto& call = static_cast<MethodCallNode&>(node);
+    StaticType receiver = inferExpression(call.getObject());
+    std::vector<StaticType> arguments;
+    for (const auto& argument : call.getArguments()) {
+        arguments.push_back(inferExpression(argument));
+    }
+
+    const std::string& method = call.getMethodName();
+    if (receiver == StaticType::List || receiver == StaticType::Map ||
+        receiver == StaticType::Set) {
+        if (method == "size") {
+            return StaticType::Int;
+        }
+        if (receiver == StaticType::List && method == "get" && arguments.size() == 1 &&
+            arguments[0] != StaticType::Unknown && arguments[0] != StaticType::Int) {
+            error(node, std::string("List.get() takes an Int index, got ") +
+                            staticTypeName(arguments[0]));
+        }
+        return StaticType::Unknown;
+    }
+
+    // Calls on this, on a local typed as a declared object, or on a top-level object
+    const ObjectSignature* target = nullptr;
+    std::string target_name;
+    if (dynamic_cast<ThisNode*>(call.getObject().get())) {
+        target = current_object_;
+        target_name = "this";
+    } else if (auto identifier = dynamic_cast<IdentifierNode*>(call.getObject().get())) {
+        auto local = locals_.find(identifier->getName());
+        target_name = local != locals_.end() ? local->second : identifier->getName();
+        auto found = objects_.find(target_name);
+        if (found != objects_.end()) {
+            target = &found->second;
+        }
+    }
+    if (!target) {
+        return StaticType::Unknown;
+    }
+
+    auto found = target->methods.find(method);
+    if (found == target->methods.end()) {
+        error(node, "'" + target_name + "' has no method '" + method + "'");
+        return StaticType::Unknown;
+    }
+    checkArguments(target_name + "." + method, found->second.parameter_types,
+                   call.getArguments(), node);
+    return staticTypeFromName(found->second.return_type);
+}
+
+void TypeChecker::checkArguments(const std::string& callee,
+                                 const std::vector<std::string>& expected,
+                                 const std::vector<ASTNodePtr>& arguments, const ASTNode& call) {
+    if (arguments.size() != expected.size()) {
+        error(call, "'" + callee + "' expects " + std::to_string(expected.size()) +
+                        " arguments, got " + std::to_string(arguments.size()));
+        return;
+    }
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        StaticType actual = arguments[i]->getStaticType();
+        if (!isAssignableStaticType(staticTypeFromName(expected[i]), actual)) {
+            error(call, "Argument " + std::to_string(i + 1) + " of '" + callee + "' expects " +
+                            expected[i] + ", got " + staticTypeName(actual));
+        }
+    }
+}
+
+std::string TypeChecker::localType(const std::string& name) const {
+    auto found = locals_.find(name);
+    return found != locals_.end() ? found->second : std::string();
+}
+
+void TypeChecker::error(const ASTNode& node, const std::string& message) {
+    const SourceLocation& location = node.getSourceLocation().line_number > 0
+                                         ? node.getSourceLocation()
+                                         : statement_location_;
+    diagnostics_.push_back({location, message});
+}
+
+}  // namespace o2l
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AST/Node.hpp"
+#include "Common/SourceLocation.hpp"
+
+namespace o2l {
+
+class ObjectNode;
+
+/**
+ * Static type checker behind `o2l run --typecheck`.
+ *
+ * Validates type annotations across the main program and the user modules it imports before
+ * anything runs: declarations, assignments and returns against their declared types (with
+ * the widenings the runtime accepts), operator operands, and the arity of constructor and
+ * method calls on objects declared in the checked programs. Types the checker does not model
+ * (objects, enums, records, Optional, ...) are Unknown and never produce an error.
+ *
+ * Every expression whose type it establishes gets it recorded on the node (ASTNode::
+ * setStaticType), which arithmetic, comparisons, variable declarations and list access use
+ * to skip generic variant dispatch at runtime.
+ */
+class TypeChecker {
+   public:
+    struct Diagnostic {
+        SourceLocation location;
+        std::string message;
+    };
+
+    // Registers the objects of a program or module; call for every program before check()
+    void addProgram(const std::vector<ASTNodePtr>& nodes);
+
+    // Checks all added programs, recording types on their nodes; returns the errors found
+    const std::vector<Diagnostic>& check();
+
+   private:
+    struct MethodSignature {
+        std::vector<std::string> parameter_types;
+        std::string return_type;
+    };
+
+    struct ObjectSignature {
+        std::map<std::string, MethodSignature> methods;
+        std::map<std::string, std::string> properties;  // declared property types
+        size_t constructor_arity = 0;
+    };
+
+    void collectObjects(const std::vector<ASTNodePtr>& nodes);
+    void checkDeclarations(const std::vector<ASTNodePtr>& nodes);
+    void checkObject(const ObjectNode& object);
+    void checkBody(const ASTNodePtr& body, const std::string& return_type);
+    void checkStatement(const ASTNodePtr& node);
+    StaticType inferExpression(const ASTNodePtr& node);
+    StaticType inferMethodCall(ASTNode& node);
+    void checkArguments(const std::string& callee, const std::vector<std::string>& expected,
+                        const std::vector<ASTNodePtr>& arguments, const ASTNode& call);
+
+    // Declared type name of a local variable or parameter, empty when there is none
+    std::string localType(const std::string& name) const;
+    void error(const ASTNode& node, const std::string& message);
+
+    std::vector<const std::vector<ASTNodePtr>*> programs_;
+    std::map<std::string, ObjectSignature> objects_;
+    std::set<std::string> ambiguous_;
+    std::vector<Diagnostic> diagnostics_;
+
+    // State of the method being checked
+    const ObjectSignature* current_object_ = nullptr;
+    std::string return_type_;
+    std::map<std::string, std::string> locals_;
+    SourceLocation statement_location_;
+};
+
+}  // namespace o2l
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -21,12 +24,77 @@
 #include <vector>
 
 #include "AST/JsonSerializer.hpp"
+#include "AotCompiler.hpp"
 #include "Common/Exceptions.hpp"
 #include "Interpreter.hpp"
 #include "Lexer.hpp"
 #include "Parser.hpp"
+#include "Runtime/Coverage.hpp"
+#include "Runtime/HeapProfiler.hpp"
 #include "Runtime/Value.hpp"
 
+namespace {
+
+// Writes the --coverage report however the run ends
+class CoverageReportWriter {
+   public:
+    explicit CoverageReportWriter(std::string path) : path_(std::move(path)) {}
+    ~CoverageReportWriter() {
+        if (path_.empty()) {
+            return;
+        }
+        try {
+            o2l::Coverage::writeReport(path_);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+   private:
+    std::string path_;
+};
+
+// Samples allocations for --heap-profile and keeps the profile at `path` up to date: every
+// O2L_HEAP_PROFILE_INTERVAL seconds (30 by default, 0 for only at exit) and when the run ends
+class HeapProfileWriter {
+   public:
+    explicit HeapProfileWriter(const std::string& path) : active_(!path.empty()) {
+        if (!active_) {
+            return;
+        }
+        o2l::HeapProfiler::start(setting("O2L_HEAP_PROFILE_RATE",
+                                         o2l::HeapProfiler::kDefaultSamplingRate));
+        o2l::HeapProfiler::startPeriodicWrites(
+            path, std::chrono::seconds(setting("O2L_HEAP_PROFILE_INTERVAL", 30)));
+    }
+    ~HeapProfileWriter() {
+        if (!active_) {
+            return;
+        }
+        o2l::HeapProfiler::stop();
+        try {
+            o2l::HeapProfiler::stopPeriodicWrites();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+   private:
+    static uint64_t setting(const char* name, uint64_t fallback) {
+        const char* value = std::getenv(name);
+        if (!value || !*value) {
+            return fallback;
+        }
+        char* end = nullptr;
+        unsigned long long parsed = std::strtoull(value, &end, 10);
+        return *end == '\0' ? parsed : fallback;
+    }
+
+    bool active_;
+};
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         std::cout << "O²L Programming Language Interpreter v0.0.1\n\n";
@@ -34,6 +102,7 @@ int main(int argc, char* argv[]) {
         std::cout << "  o2l run [file.obq]       Run an O²L program (uses o2l.toml entrypoint "
                      "if no file)\n";
         std::cout << "  o2l parse <file.obq>     Parse file and output AST\n";
+        std::cout << "  o2l build <file.obq> --aot  Compile a program to a native executable\n";
         std::cout << "  o2l repl                 Start interactive REPL\n";
         std::cout << "  o2l --help               Show this help message\n";
         std::cout << "  o2l --version            Show version information\n";
@@ -50,9 +119,20 @@ int main(int argc, char* argv[]) {
         std::cout << "  run [file]     Execute an O²L source file (.obq) or use o2l.toml "
                      "entrypoint\n";
         std::cout << "  parse <file>   Parse file and output AST (for LSP/tooling)\n";
+        std::cout << "  build <file> --aot [-o out]  Compile to C++ and build an executable\n";
         std::cout << "  repl           Start interactive Read-Eval-Print Loop\n";
         std::cout << "  --debug        Enable debug output (use with run command)\n";
         std::cout << "  --allow-ffi    Enable Foreign Function Interface (FFI) support\n";
+        std::cout << "  --snapshot F   Restore the heap built by Main.setup() from F, or write it "
+                     "(use with run command)\n";
+        std::cout << "  --typecheck    Check type annotations before running "
+                     "(use with run command)\n";
+        std::cout << "  --jit=MODE     Baseline JIT for hot methods: off, on or trace "
+                     "(use with run command)\n";
+        std::cout << "  --coverage[=F] Count executed lines and write an lcov report to F "
+                     "(coverage.info; JSON if F ends in .json; use with run command)\n";
+        std::cout << "  --heap-profile[=F]  Sample allocations by O²L stack into a pprof profile "
+                     "at F (heap.pprof; use with run command)\n";
         std::cout << "  --json-output  Output in JSON format (use with parse command)\n";
         std::cout << "  --help         Show this help message\n";
         std::cout << "  --version      Show version information\n";
@@ -112,6 +192,11 @@ int main(int argc, char* argv[]) {
         std::string filename;
         bool debug_mode = false;
         bool ffi_enabled = false;
+        std::string snapshot_path;
+        std::string coverage_path;
+        std::string heap_profile_path;
+        bool type_check = false;
+        o2l::JitMode jit_mode = o2l::BaselineJit::getMode();
 
         if (argc < 3) {
             // No file specified, check for o2l.toml
@@ -184,12 +269,54 @@ int main(int argc, char* argv[]) {
                 debug_mode = true;
             } else if (std::string(argv[i]) == "--allow-ffi") {
                 ffi_enabled = true;
+            } else if (std::string(argv[i]) == "--snapshot") {
+                if (i + 1 >= argc) {
+                    std::cerr << "Error: --snapshot requires a file path\n";
+                    return 1;
+                }
+                snapshot_path = argv[++i];
+            } else if (std::string(argv[i]) == "--typecheck") {
+                type_check = true;
+            } else if (std::string(argv[i]) == "--coverage") {
+                coverage_path = "coverage.info";
+            } else if (std::string(argv[i]).rfind("--coverage=", 0) == 0) {
+                coverage_path = std::string(argv[i]).substr(11);
+                if (coverage_path.empty()) {
+                    std::cerr << "Error: --coverage= requires a file path\n";
+                    return 1;
+                }
+            } else if (std::string(argv[i]) == "--heap-profile") {
+                heap_profile_path = "heap.pprof";
+            } else if (std::string(argv[i]).rfind("--heap-profile=", 0) == 0) {
+                heap_profile_path = std::string(argv[i]).substr(15);
+                if (heap_profile_path.empty()) {
+                    std::cerr << "Error: --heap-profile= requires a file path\n";
+                    return 1;
+                }
+            } else if (std::string(argv[i]).rfind("--jit=", 0) == 0) {
+                if (!o2l::BaselineJit::parseMode(std::string(argv[i]).substr(6), jit_mode)) {
+                    std::cerr << "Error: --jit expects off, on or trace\n";
+                    return 1;
+                }
             } else {
                 // All other arguments are passed to the program
                 program_args.push_back(std::string(argv[i]));
             }
         }
 
+        if (!coverage_path.empty()) {
+#if O2L_ENABLE_COVERAGE
+            // Statements are instrumented as they are parsed, and compiled methods are not
+            // counted
+            o2l::Coverage::enable();
+            jit_mode = o2l::JitMode::Off;
+#else
+            std::cerr << "Error: Line coverage is disabled in this build. Use "
+                         "-DENABLE_LINE_COVERAGE=ON to enable.\n";
+            return 1;
+#endif
+        }
+
         // Verify file exists and has .obq extension
         if (!std::filesystem::exists(filename)) {
             std::cerr << "Error: File '" << filename << "' not found\n";
@@ -211,6 +338,9 @@ int main(int argc, char* argv[]) {
                                 std::istreambuf_iterator<char>());
         file.close();
 
+        // Written however the run ends from here on; a missing file gets no report
+        CoverageReportWriter coverage_report(coverage_path);
+
         if (debug_mode) {
             std::cout << "[DEBUG] Running file: " << filename << "\n";
             std::cout << "[DEBUG] Source code length: " << source_code.length() << " characters\n";
@@ -250,6 +380,8 @@ int main(int argc, char* argv[]) {
 
             // Interpretation
             o2l::Interpreter interpreter(filename);
+            // Declared after the interpreter, so the last profile still sees the program's heap
+            HeapProfileWriter heap_profile(heap_profile_path);
 
             // Set program arguments so they can be accessed via system.os.args
             interpreter.setProgramArguments(program_args);
@@ -257,6 +389,15 @@ int main(int argc, char* argv[]) {
             // Enable FFI if requested
             interpreter.setFFIEnabled(ffi_enabled);
 
+            if (!snapshot_path.empty()) {
+                interpreter.setSnapshot(snapshot_path, source_code);
+            }
+            interpreter.setTypeCheck(type_check);
+            interpreter.setJitMode(jit_mode);
+            if (jit_mode != o2l::JitMode::Off && !o2l::BaselineJit::isSupported()) {
+                std::cerr << "Warning: the JIT needs x86-64 Linux; running interpreted\n";
+            }
+
             // Add the source file's directory to module search paths for relative imports
             std::filesystem::path source_dir = std::filesystem::path(filename).parent_path();
             if (!source_dir.empty()) {
@@ -265,6 +406,12 @@ int main(int argc, char* argv[]) {
 
             o2l::Value result = interpreter.execute(ast_nodes);
 
+            if (debug_mode && !snapshot_path.empty()) {
+                std::cout << "[DEBUG] Heap snapshot "
+                          << (interpreter.wasSnapshotRestored() ? "restored from " : "written to ")
+                          << snapshot_path << "\n";
+            }
+
             // Check if main() returned an Int to use as exit code
             int exit_code = 0;
             if (std::holds_alternative<o2l::Int>(result)) {
@@ -407,6 +554,70 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (command == "build") {
+        std::string filename;
+        std::filesystem::path output;
+        bool aot = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--aot") {
+                aot = true;
+            } else if (arg == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            } else if (filename.empty()) {
+                filename = arg;
+            } else {
+                std::cerr << "Error: Unexpected argument '" << arg << "'\n";
+                return 1;
+            }
+        }
+        if (filename.empty() || !aot) {
+            std::cerr << "Usage: o2l build <file.obq> --aot [-o output]\n";
+            return 1;
+        }
+        if (output.empty()) {
+            output = std::filesystem::path(filename).stem();
+        }
+
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open file '" << filename << "'\n";
+            return 1;
+        }
+        std::string source_code((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+        file.close();
+
+        try {
+            o2l::Lexer lexer(source_code);
+            o2l::Parser parser(lexer.tokenizeAll(), filename);
+            auto ast_nodes = parser.parse();
+
+            o2l::AotCompiler compiler;
+            compiler.build(ast_nodes, filename, source_code, output);
+
+            size_t compiled = 0;
+            for (const auto& method : compiler.getReport()) {
+                compiled += method.compiled ? 1 : 0;
+            }
+            std::cout << "Compiled " << compiled << " of " << compiler.getReport().size()
+                      << " methods to C++: " << output.string() << "\n";
+            for (const auto& method : compiler.getReport()) {
+                if (!method.compiled) {
+                    std::cout << "  interpreted: " << method.object << "." << method.method
+                              << " (" << method.reason << ")\n";
+                }
+            }
+            return 0;
+        } catch (const o2l::o2lException& e) {
+            std::cerr << "Error: " << e.getMessage() << "\n";
+            return 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
     if (command == "repl") {
         std::cout << "O²L REPL v0.0.1\n";
         std::cout << "Type 'exit' to quit\n\n";
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unistd.h>
+
+#include "../src/AotCompiler.hpp"
+#include "../src/Lexer.hpp"
+#include "../src/Parser.hpp"
+
+using namespace o2l;
+
+namespace {
+
+const char* kProgram = R"(
+import system.io
+
+Object Calc {
+    @external method fib(n: Int): Int {
+        if (n < 2) {
+            return n
+        }
+        return (this.fib((n - 1)) + this.fib((n - 2)))
+    }
+    @external method sumTo(limit: Int): Int {
+        total: Int = 0
+        i: Int = 0
+        while ((i < limit)) {
+            i = (i + 1)
+            if (((i % 2) == 0)) {
+                continue
+            }
+            total = (total + i)
+        }
+        return total
+    }
+    @external method label(n: Int): Text {
+        prefix: Text = "n="
+        return (prefix + n.toString())
+    }
+    @external method safeDivide(a: Int, b: Int): Int {
+        result: Int = 0
+        try {
+            result = (a / b)
+        } catch (error) {
+            result = -1
+        }
+        return result
+    }
+}
+
+Object Main {
+    method main(): Int {
+        calc: Calc = new Calc()
+        io.print("fib=%d", calc.fib(20))
+        io.print("sum=%d", calc.sumTo(100))
+        io.print("%s", calc.label(7))
+        io.print("div=%d,%d", calc.safeDivide(10, 2), calc.safeDivide(1, 0))
+        return 3
+    }
+}
+)";
+
+std::vector<ASTNodePtr> parse(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer.tokenizeAll(), "calc.obq");
+    return parser.parse();
+}
+
+}  // namespace
+
+class AotTest : public ::testing::Test {};
+
+TEST_F(AotTest, GeneratesTypedFunctionsAndReportsFallbacks) {
+    AotCompiler compiler;
+    std::string code = compiler.generate(parse(kProgram), "calc.obq", kProgram);
+
+    std::map<std::string, AotCompiler::MethodReport> report;
+    for (const auto& method : compiler.getReport()) {
+        report[method.object + "." + method.method] = method;
+    }
+    EXPECT_TRUE(report["Calc.fib"].compiled);
+    EXPECT_TRUE(report["Calc.sumTo"].compiled);
+    EXPECT_TRUE(report["Calc.label"].compiled);
+    EXPECT_TRUE(report["Main.main"].compiled);
+    ASSERT_FALSE(report["Calc.safeDivide"].compiled);
+    EXPECT_NE(report["Calc.safeDivide"].reason.find("'result'"), std::string::npos);
+
+    // Typed signatures and a direct recursive call, with no dispatch
+    EXPECT_NE(code.find("Int m0_Calc_fib(Context& ctx, Int v_n)"), std::string::npos);
+    EXPECT_NE(code.find("m0_Calc_fib(ctx, (v_n - Int(1LL)))"), std::string::npos);
+    // Text + a dynamically typed call result stays a Value; the typed local does not
+    EXPECT_NE(code.find("Value m2_Calc_label(Context& ctx, Int v_n)"), std::string::npos);
+    EXPECT_NE(code.find("v_prefix = Text(\"n=\", 2);"), std::string::npos);
+    EXPECT_EQ(code.find("m3_Calc_safeDivide"), std::string::npos);
+}
+
+TEST_F(AotTest, BuildsAStandaloneExecutable) {
+    AotCompiler compiler;
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("o2l_aot_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    auto source_path = directory / "calc.obq";
+    std::ofstream(source_path) << kProgram;
+
+    try {
+        compiler.build(parse(kProgram), source_path.string(), kProgram, directory / "calc");
+    } catch (const std::runtime_error& e) {
+        if (std::string(e.what()).find("O2L_AOT_CONFIG") != std::string::npos) {
+            GTEST_SKIP() << e.what();
+        }
+        FAIL() << e.what();
+    }
+
+    std::string command = (directory / "calc").string() + " 2>&1";
+    FILE* pipe = popen(command.c_str(), "r");
+    ASSERT_NE(pipe, nullptr);
+    std::string output;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        output += buffer;
+    }
+    int status = pclose(pipe);
+    std::filesystem::remove_all(directory);
+
+    EXPECT_EQ(output, "fib=6765\nsum=2500\nn=7\ndiv=5,-1\n");
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 3);
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Embed/Engine.hpp"
+#include "../src/Embed/o2l.h"
+#include "../src/Runtime/ListInstance.hpp"
+
+using namespace o2l;
+
+namespace {
+
+const char* kRules = R"(
+    Object Counter {
+        constructor(start: Int) {
+            this.count = start
+        }
+        @external method increment(): Int {
+            this.count = this.count + 1
+            return this.count
+        }
+    }
+
+    Object Rules {
+        @external method warmUp(): Int {
+            this.counter = new Counter(100)
+            this.seen = ["warm"]
+            return 0
+        }
+        @external method record(tag: Text): Int {
+            this.seen.add(tag)
+            return this.seen.size()
+        }
+        @external method bump(): Int {
+            counter: Counter = this.counter
+            return counter.increment()
+        }
+        @external method score(base: Int, bonus: Int): Int {
+            return base * 2 + bonus
+        }
+    }
+)";
+
+const char* kTenantRules = R"(
+    Object Tenant {
+        @external method loop(n: Int): Int {
+            i: Int = 0
+            while (i < n) {
+                i = i + 1
+            }
+            return i
+        }
+        @external method forever(): Int {
+            i: Int = 0
+            while (true) {
+                i = i + 1
+            }
+            return i
+        }
+        @external method depth(n: Int): Int {
+            if (n == 0) {
+                return 0
+            }
+            return this.depth(n - 1) + 1
+        }
+        @external method hoard(n: Int): Int {
+            items: List<Text> = []
+            i: Int = 0
+            while (i < n) {
+                items.add("some tenant data")
+                i = i + 1
+            }
+            return items.size()
+        }
+        @external method guarded(): Text {
+            try {
+                while (true) {
+                }
+            } catch (error) {
+                return "swallowed"
+            }
+            return "unreachable"
+        }
+        @external method cleanup(): Int {
+            try {
+                while (true) {
+                }
+            } finally {
+                this.cleaned = 1
+            }
+            return 0
+        }
+        @external method wasCleaned(): Int {
+            return this.cleaned
+        }
+    }
+)";
+
+}  // namespace
+
+class EmbeddingTest : public ::testing::Test {};
+
+TEST_F(EmbeddingTest, LoadAndCall) {
+    Engine engine;
+    engine.load(kRules);
+    EXPECT_TRUE(engine.hasObject("Rules"));
+    EXPECT_FALSE(engine.hasObject("Main"));
+
+    Value result = engine.call("Rules", "score", {Value(Int(20)), Value(Int(2))});
+    ASSERT_TRUE(std::holds_alternative<Int>(result));
+    EXPECT_EQ(std::get<Int>(result), 42);
+
+    EXPECT_THROW(engine.call("Missing", "score"), UnresolvedReferenceError);
+    EXPECT_THROW(engine.call("Rules", "missing"), UnresolvedReferenceError);
+}
+
+TEST_F(EmbeddingTest, ClonesAreIsolated) {
+    Engine engine;
+    engine.load(kRules);
+    engine.call("Rules", "warmUp");
+
+    auto first = engine.clone();
+    auto second = engine.clone();
+    EXPECT_EQ(std::get<Int>(first->call("Rules", "record", {Value(Text("a"))})), 2);
+    EXPECT_EQ(std::get<Int>(first->call("Rules", "record", {Value(Text("b"))})), 3);
+    EXPECT_EQ(std::get<Int>(first->call("Rules", "bump")), 101);
+
+    // Neither the source nor a sibling sees a clone's changes
+    EXPECT_EQ(std::get<Int>(second->call("Rules", "record", {Value(Text("c"))})), 2);
+    EXPECT_EQ(std::get<Int>(second->call("Rules", "bump")), 101);
+    EXPECT_EQ(std::get<Int>(engine.call("Rules", "bump")), 101);
+
+    // Clones of a clone start from its state
+    auto nested = first->clone();
+    EXPECT_EQ(std::get<Int>(nested->call("Rules", "bump")), 102);
+    EXPECT_THROW(nested->load(kRules), std::runtime_error);
+}
+
+TEST_F(EmbeddingTest, CApi) {
+    o2l_interpreter* interpreter = o2l_create();
+    ASSERT_NE(interpreter, nullptr);
+    ASSERT_EQ(o2l_load_source(interpreter, kRules, "rules.obq"), O2L_OK);
+
+    o2l_value* args[] = {o2l_value_int(20), o2l_value_int(2)};
+    o2l_value* result = nullptr;
+    ASSERT_EQ(o2l_call(interpreter, "Rules", "score", args, 2, &result), O2L_OK);
+    EXPECT_EQ(o2l_value_type(result), O2L_TYPE_INT);
+    EXPECT_EQ(o2l_value_as_int(result), 42);
+    EXPECT_STREQ(o2l_value_to_string(result), "42");
+    o2l_value_free(result);
+
+    EXPECT_EQ(o2l_call(interpreter, "Rules", "score", args, 1, &result), O2L_ERROR);
+    EXPECT_NE(std::string(o2l_last_error(interpreter)).find("expects 2 arguments"),
+              std::string::npos);
+    o2l_value_free(args[0]);
+    o2l_value_free(args[1]);
+
+    ASSERT_EQ(o2l_call(interpreter, "Rules", "warmUp", nullptr, 0, nullptr), O2L_OK);
+    o2l_interpreter* isolate = o2l_clone(interpreter);
+    ASSERT_NE(isolate, nullptr);
+    o2l_value* tag = o2l_value_text("x");
+    ASSERT_EQ(o2l_call(isolate, "Rules", "record", &tag, 1, &result), O2L_OK);
+    EXPECT_EQ(o2l_value_as_int(result), 2);
+    o2l_value_free(result);
+    o2l_value_free(tag);
+    o2l_destroy(isolate);
+
+    o2l_value* list = o2l_value_list();
+    o2l_value* element = o2l_value_text("item");
+    EXPECT_EQ(o2l_value_list_append(list, element), O2L_OK);
+    EXPECT_EQ(o2l_value_list_append(element, list), O2L_ERROR);
+    EXPECT_EQ(o2l_value_list_size(list), 1u);
+    o2l_value* first = o2l_value_list_get(list, 0);
+    EXPECT_STREQ(o2l_value_as_text(first), "item");
+    EXPECT_EQ(o2l_value_list_get(list, 1), nullptr);
+    o2l_value_free(first);
+    o2l_value_free(element);
+    o2l_value_free(list);
+
+    o2l_destroy(interpreter);
+}
+
+TEST_F(EmbeddingTest, ExecutionBudget) {
+    Engine engine;
+    engine.load(kTenantRules);
+    ExecutionLimits limits;
+    limits.max_steps = 10000;
+    limits.max_call_depth = 50;
+    limits.max_allocated_bytes = 64 * 1024;
+    engine.setExecutionLimits(limits);
+
+    // Usage is reported per call: one step per loop test plus one for the call itself
+    EXPECT_EQ(std::get<Int>(engine.call("Tenant", "loop", {Value(Int(100))})), 100);
+    EXPECT_EQ(engine.lastCallUsage().steps, 102u);
+    EXPECT_EQ(engine.lastCallUsage().max_call_depth, 1u);
+    EXPECT_EQ(std::get<Int>(engine.call("Tenant", "depth", {Value(Int(10))})), 10);
+    EXPECT_EQ(engine.lastCallUsage().max_call_depth, 11u);
+
+    // Each limit aborts the call, past the program's own try/catch
+    try {
+        engine.call("Tenant", "forever");
+        FAIL() << "expected the step limit to stop the loop";
+    } catch (const ExecutionBudgetExceededError& e) {
+        EXPECT_EQ(e.getResource(), "step");
+        EXPECT_STREQ(e.what(), "Execution budget exceeded: step limit of 10000 steps");
+    }
+    EXPECT_EQ(engine.lastCallUsage().steps, 10001u);
+    EXPECT_THROW(engine.call("Tenant", "guarded"), ExecutionBudgetExceededError);
+    EXPECT_THROW(engine.call("Tenant", "cleanup"), ExecutionBudgetExceededError);
+    EXPECT_EQ(std::get<Int>(engine.call("Tenant", "wasCleaned")), 1);  // finally still ran
+    EXPECT_THROW(engine.call("Tenant", "depth", {Value(Int(100))}), ExecutionBudgetExceededError);
+    EXPECT_EQ(engine.lastCallUsage().max_call_depth, 50u);
+    EXPECT_THROW(engine.call("Tenant", "hoard", {Value(Int(5000))}),
+                 ExecutionBudgetExceededError);
+    EXPECT_GT(engine.lastCallUsage().allocated_bytes, 64u * 1024);
+
+    // A call that ran out leaves the engine usable, and clones inherit the limits
+    EXPECT_EQ(std::get<Int>(engine.call("Tenant", "depth", {Value(Int(5))})), 5);
+    auto isolate = engine.clone();
+    EXPECT_THROW(isolate->call("Tenant", "forever"), ExecutionBudgetExceededError);
+
+    limits = ExecutionLimits();
+    limits.max_wall_time = std::chrono::milliseconds(50);
+    engine.setExecutionLimits(limits);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(engine.call("Tenant", "forever"), ExecutionBudgetExceededError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_GE(engine.lastCallUsage().wall_time, std::chrono::milliseconds(50));
+
+    // The C API reports the same through o2l_last_error and o2l_last_usage
+    o2l_interpreter* interpreter = o2l_create();
+    ASSERT_EQ(o2l_load_source(interpreter, kTenantRules, "tenant.obq"), O2L_OK);
+    o2l_limits c_limits = {500, 0, 0, 0};
+    ASSERT_EQ(o2l_set_limits(interpreter, &c_limits), O2L_OK);
+    EXPECT_EQ(o2l_call(interpreter, "Tenant", "forever", nullptr, 0, nullptr), O2L_ERROR);
+    EXPECT_NE(std::string(o2l_last_error(interpreter)).find("Execution budget exceeded"),
+              std::string::npos);
+    o2l_usage usage;
+    ASSERT_EQ(o2l_last_usage(interpreter, &usage), O2L_OK);
+    EXPECT_EQ(usage.steps, 501u);
+    o2l_destroy(interpreter);
+}
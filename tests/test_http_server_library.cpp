@@ -17,11 +17,38 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <thread>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Interpreter.hpp"
+#include "../src/Lexer.hpp"
+#include "../src/Parser.hpp"
+#include "../src/Runtime/CancellationToken.hpp"
 #include "../src/Runtime/Context.hpp"
+#include "../src/Runtime/Http2Session.hpp"
+#include "../src/Runtime/HttpMiddleware.hpp"
+#include "../src/Runtime/HttpRequestObject.hpp"
+#include "../src/Runtime/HttpResponseCache.hpp"
+#include "../src/Runtime/HttpResponseObject.hpp"
 #include "../src/Runtime/HttpServerLibrary.hpp"
+#include "../src/Runtime/HttpConnectionHub.hpp"
+#include "../src/Runtime/HttpEventStream.hpp"
 #include "../src/Runtime/ListInstance.hpp"
 #include "../src/Runtime/MapInstance.hpp"
 
@@ -306,6 +333,276 @@ TEST_F(HttpServerLibraryTest, MiddlewareChainNoNext) {
     EXPECT_FALSE(final_handler_called);
 }
 
+TEST_F(HttpServerLibraryTest, MiddlewareChainHooks) {
+    MiddlewareChain chain;
+    std::string trace;
+
+    MiddlewareStage before;
+    before.before = [&trace](HttpServerRequest&, HttpServerResponse&) {
+        trace += "b";
+        return true;
+    };
+    MiddlewareStage after;
+    after.after = [&trace](const HttpServerRequest&, HttpServerResponse&) { trace += "a"; };
+
+    chain.useStage(before);
+    chain.useStage(after);
+    chain.use([&trace](const HttpServerRequest&, HttpServerResponse&, std::function<void()> next) {
+        trace += "(";
+        next();
+        trace += ")";
+    });
+    chain.compile();
+
+    auto final_handler = [&trace](const HttpServerRequest&, HttpServerResponse&) { trace += "h"; };
+
+    HttpServerRequest request;
+    HttpServerResponse response;
+    chain.execute(request, response, final_handler);
+    EXPECT_EQ(trace, "b(h)a");
+    EXPECT_EQ(chain.size(), 3u);
+
+    // Stages added after compile() are picked up on the next request
+    MiddlewareStage stop;
+    stop.before = [&trace](HttpServerRequest&, HttpServerResponse&) {
+        trace += "x";
+        return false;
+    };
+    chain.useStage(stop);
+
+    trace.clear();
+    chain.execute(request, response, final_handler);
+    EXPECT_EQ(trace, "b(x)a");
+}
+
+TEST_F(HttpServerLibraryTest, BuiltinMiddlewareCorsAndHeaders) {
+    MiddlewareChain chain;
+    chain.useStage(BuiltinMiddleware::create("cors", {{"origin", "https://example.com"}}));
+    chain.useStage(BuiltinMiddleware::create("headers", {{"X-Frame-Options", "DENY"}}));
+
+    bool handled = false;
+    auto final_handler = [&handled](const HttpServerRequest&, HttpServerResponse&) {
+        handled = true;
+    };
+
+    HttpServerRequest preflight;
+    preflight.method = "OPTIONS";
+    preflight.headers["access-control-request-method"] = "POST";
+    HttpServerResponse preflight_response;
+    chain.execute(preflight, preflight_response, final_handler);
+    EXPECT_FALSE(handled);
+    EXPECT_EQ(preflight_response.status_code, 204);
+    EXPECT_EQ(preflight_response.headers["Access-Control-Allow-Origin"], "https://example.com");
+    EXPECT_EQ(preflight_response.headers["Access-Control-Max-Age"], "600");
+    EXPECT_EQ(preflight_response.headers.count("X-Frame-Options"), 0u);
+
+    HttpServerRequest request;
+    request.method = "GET";
+    HttpServerResponse response;
+    chain.execute(request, response, final_handler);
+    EXPECT_TRUE(handled);
+    EXPECT_EQ(response.headers["Access-Control-Allow-Origin"], "https://example.com");
+    EXPECT_EQ(response.headers["X-Frame-Options"], "DENY");
+
+    EXPECT_THROW(BuiltinMiddleware::create("nope", {}), std::runtime_error);
+    EXPECT_THROW(BuiltinMiddleware::create("headers", {}), std::runtime_error);
+}
+
+TEST_F(HttpServerLibraryTest, BuiltinMiddlewareRequestIdAndTiming) {
+    MiddlewareChain chain;
+    chain.useStage(BuiltinMiddleware::create("request-id", {}));
+    chain.useStage(BuiltinMiddleware::create("timing", {}));
+
+    std::string seen_id;
+    auto final_handler = [&seen_id](const HttpServerRequest& request, HttpServerResponse&) {
+        seen_id = request.headers.at("x-request-id");
+    };
+
+    HttpServerRequest request;
+    HttpServerResponse response;
+    chain.execute(request, response, final_handler);
+    EXPECT_EQ(seen_id.size(), 32u);
+    EXPECT_EQ(response.headers["X-Request-Id"], seen_id);
+    EXPECT_NE(response.headers["X-Response-Time"].find("ms"), std::string::npos);
+    EXPECT_EQ(response.headers["Server-Timing"].rfind("app;dur=", 0), 0u);
+
+    HttpServerRequest traced;
+    traced.headers["x-request-id"] = "upstream-42";
+    HttpServerResponse traced_response;
+    chain.execute(traced, traced_response, final_handler);
+    EXPECT_EQ(seen_id, "upstream-42");
+    EXPECT_EQ(traced_response.headers["X-Request-Id"], "upstream-42");
+}
+
+#ifdef HAVE_ZLIB
+TEST_F(HttpServerLibraryTest, BuiltinMiddlewareCompression) {
+    MiddlewareChain chain;
+    chain.useStage(BuiltinMiddleware::create("compression", {{"min_size", "64"}}));
+
+    std::string body;
+    for (int i = 0; i < 100; ++i) {
+        body += "{\"item\": " + std::to_string(i) + "},";
+    }
+    auto final_handler = [&body](const HttpServerRequest&, HttpServerResponse& response) {
+        response.headers["Content-Type"] = "application/json";
+        response.body = body;
+    };
+
+    HttpServerRequest plain;
+    HttpServerResponse plain_response;
+    chain.execute(plain, plain_response, final_handler);
+    EXPECT_EQ(plain_response.body, body);
+    EXPECT_EQ(plain_response.headers.count("Content-Encoding"), 0u);
+
+    HttpServerRequest request;
+    request.headers["accept-encoding"] = "gzip, deflate";
+    HttpServerResponse response;
+    chain.execute(request, response, final_handler);
+    ASSERT_EQ(response.headers["Content-Encoding"], "gzip");
+    EXPECT_LT(response.body.size(), body.size());
+
+    std::string inflated(body.size(), '\0');
+    z_stream stream{};
+    ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(response.body.data());
+    stream.avail_in = static_cast<uInt>(response.body.size());
+    stream.next_out = reinterpret_cast<Bytef*>(inflated.data());
+    stream.avail_out = static_cast<uInt>(inflated.size());
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&stream);
+    EXPECT_EQ(inflated, body);
+}
+#endif
+
+TEST_F(HttpServerLibraryTest, BuiltinMiddlewareResponseCache) {
+    auto cache = std::make_shared<ResponseCache>(
+        ResponseCache::parseOptions({{"ttl", "30"}, {"vary", "Accept-Language"}}));
+    MiddlewareChain chain;
+    chain.useStage(ResponseCache::stage(cache));
+
+    int calls = 0;
+    std::string cache_control;
+    auto final_handler = [&](const HttpServerRequest& request, HttpServerResponse& response) {
+        ++calls;
+        response.headers["Content-Type"] = "application/json";
+        if (!cache_control.empty()) {
+            response.headers["Cache-Control"] = cache_control;
+        }
+        response.body = "{\"page\": \"" + request.query_string + "\"}";
+    };
+    auto get = [&](const std::string& query, const std::string& language = "en") {
+        HttpServerRequest request;
+        request.method = "GET";
+        request.path = "/items";
+        request.query_string = query;
+        request.headers["accept-language"] = language;
+        HttpServerResponse response;
+        chain.execute(request, response, final_handler);
+        return response;
+    };
+
+    auto miss = get("page=1");
+    EXPECT_EQ(miss.headers["X-Cache"], "MISS");
+    auto hit = get("page=1");
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(hit.headers["X-Cache"], "HIT");
+    ASSERT_TRUE(hit.static_body);
+    EXPECT_EQ(hit.static_body->data, "{\"page\": \"page=1\"}");
+    std::string wire = serializeHttpResponse(hit, false);
+    EXPECT_NE(wire.find("Content-Type: application/json\r\n"), std::string::npos);
+    EXPECT_NE(wire.find("Content-Length: 18\r\n"), std::string::npos);
+    EXPECT_NE(wire.find("Age: 0\r\n"), std::string::npos);
+
+    // Query and vary headers are part of the key
+    get("page=2");
+    get("page=1", "fr");
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(cache->getEntryCount(), 3u);
+
+    // Responses that forbid storing, and clients that ask to skip the cache, reach the handler
+    cache_control = "private, max-age=60";
+    get("page=3");
+    get("page=3");
+    EXPECT_EQ(calls, 5);
+    cache_control.clear();
+    HttpServerRequest fresh;
+    fresh.method = "GET";
+    fresh.path = "/items";
+    fresh.query_string = "page=1";
+    fresh.headers["accept-language"] = "en";
+    fresh.headers["cache-control"] = "no-cache";
+    HttpServerResponse fresh_response;
+    chain.execute(fresh, fresh_response, final_handler);
+    EXPECT_EQ(calls, 6);
+    EXPECT_EQ(cache->getHits(), 1u);
+
+    HttpServerResponse response;
+    response.headers["cache-control"] = "public, s-maxage=120, max-age=10";
+    EXPECT_EQ(cache->freshness(response), std::chrono::seconds(120));
+    response.headers["cache-control"] = "no-store";
+    EXPECT_EQ(cache->freshness(response), std::chrono::seconds(0));
+    response.headers.clear();
+    response.headers["Set-Cookie"] = "session=1";
+    EXPECT_FALSE(cache->store("cookie", response));
+    response.headers.clear();
+    response.headers["Vary"] = "Cookie";
+    EXPECT_FALSE(cache->store("vary", response));
+
+    // The memory bound evicts the least recently used entries
+    ResponseCache::Options small;
+    small.max_bytes = 4096;
+    ResponseCache bounded(small);
+    HttpServerResponse large;
+    large.body = std::string(1500, 'x');
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(bounded.store("entry-" + std::to_string(i), large));
+    }
+    EXPECT_LE(bounded.getMemoryUsage(), 4096u);
+    EXPECT_EQ(bounded.getEntryCount(), 2u);
+    HttpServerResponse out;
+    EXPECT_TRUE(bounded.lookup("entry-4", out));
+    EXPECT_FALSE(bounded.lookup("entry-0", out));
+
+    EXPECT_THROW(ResponseCache::parseOptions({{"ttl", "-1"}}), std::runtime_error);
+    EXPECT_THROW(ResponseCache::parseOptions({{"size", "1"}}), std::runtime_error);
+}
+
+TEST_F(HttpServerLibraryTest, ResponseCacheCoalescesMisses) {
+    auto cache = std::make_shared<ResponseCache>(ResponseCache::Options());
+    MiddlewareChain chain;
+    chain.useStage(ResponseCache::stage(cache));
+
+    std::atomic<int> calls{0};
+    auto slow_handler = [&calls](const HttpServerRequest&, HttpServerResponse& response) {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        response.body = "report";
+    };
+
+    // Concurrent misses on one key run the handler once; the rest get its response
+    std::vector<std::thread> clients;
+    std::vector<std::string> bodies(8);
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        clients.emplace_back([&, i]() {
+            HttpServerRequest request;
+            request.method = "GET";
+            request.path = "/report";
+            HttpServerResponse response;
+            chain.execute(request, response, slow_handler);
+            bodies[i] = response.static_body ? response.static_body->data : response.body;
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    EXPECT_EQ(calls.load(), 1);
+    for (const auto& body : bodies) {
+        EXPECT_EQ(body, "report");
+    }
+    EXPECT_EQ(cache->getMisses(), 1u);
+    EXPECT_EQ(cache->getHits() + cache->getMisses(), bodies.size());
+}
+
 //=============================================================================
 // Route Registration Tests
 //=============================================================================
@@ -399,6 +696,34 @@ TEST_F(HttpServerLibraryTest, MiddlewareRegistrationStringType) {
     EXPECT_EQ(std::get<Text>(result), "Middleware registered successfully");
 }
 
+TEST_F(HttpServerLibraryTest, BuiltinMiddlewareRegistration) {
+    createServer();
+
+    auto options = std::make_shared<MapInstance>();
+    options->put(Value(Text("origin")), Value(Text("*")));
+    options->put(Value(Text("max_age")), Value(Int(120)));
+
+    auto result =
+        callServerMethod("useBuiltin", {Value(server_obj), Value(Text("cors")), Value(options)});
+    EXPECT_EQ(std::get<Text>(result), "Built-in middleware 'cors' registered");
+    EXPECT_NO_THROW(callServerMethod("useBuiltin", {Value(server_obj), Value(Text("timing"))}));
+
+    auto cache_options = std::make_shared<MapInstance>();
+    cache_options->put(Value(Text("ttl")), Value(Int(30)));
+    cache_options->put(Value(Text("vary")), Value(Text("accept")));
+    result = callServerMethod("useBuiltin",
+                              {Value(server_obj), Value(Text("cache")), Value(cache_options)});
+    EXPECT_EQ(std::get<Text>(result), "Built-in middleware 'cache' registered");
+    auto stats = std::get<std::shared_ptr<MapInstance>>(
+        callServerMethod("getStats", {Value(server_obj)}));
+    EXPECT_EQ(std::get<Int>(stats->get(Value(Text("response_cache_entries")))), 0);
+    EXPECT_THROW(callServerMethod("useBuiltin", {Value(server_obj), Value(Text("unknown"))}),
+                 std::runtime_error);
+    EXPECT_THROW(callServerMethod("useBuiltin",
+                                  {Value(server_obj), Value(Text("cors")), Value(Int(1))}),
+                 std::runtime_error);
+}
+
 //=============================================================================
 // Enhanced Server Statistics Tests
 //=============================================================================
@@ -503,6 +828,171 @@ TEST_F(HttpServerLibraryTest, StaticFileConfiguration) {
     EXPECT_FALSE(std::get<Text>(result).empty());
 }
 
+namespace {
+
+// A scratch directory for static file tests, removed afterwards
+struct StaticDir {
+    std::filesystem::path path;
+
+    StaticDir() {
+        path = std::filesystem::temp_directory_path() /
+               ("o2l_static_" + std::to_string(std::chrono::steady_clock::now()
+                                                   .time_since_epoch()
+                                                   .count()));
+        std::filesystem::create_directories(path / "css");
+    }
+    ~StaticDir() {
+        std::error_code error;
+        std::filesystem::remove_all(path, error);
+    }
+    void write(const std::string& name, const std::string& content) const {
+        std::ofstream(path / name, std::ios::binary) << content;
+    }
+};
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, StaticCacheServesFromMemory) {
+    StaticDir dir;
+    std::string css;
+    for (int i = 0; i < 200; ++i) {
+        css += ".rule" + std::to_string(i) + " { color: red; }\n";
+    }
+    dir.write("css/site.css", css);
+    dir.write("logo.png", std::string("\x89PNG\r\n\x1a\n", 8));
+
+    StaticFileCache::Options options;
+    options.max_age = 60;
+    StaticFileCache cache(dir.path.string(), options);
+
+    HttpServerRequest request;
+    HttpServerResponse response;
+    ASSERT_TRUE(cache.serve("/css/site.css", request, response));
+    EXPECT_EQ(response.status_code, 200);
+    ASSERT_TRUE(response.static_body);
+    EXPECT_EQ(response.static_body->data, css);
+    EXPECT_EQ(response.getBodySize(), css.size());
+    EXPECT_EQ(cache.getMisses(), 1u);
+
+    std::string head = serializeHttpHead(response, false);
+    EXPECT_NE(head.find("Content-Type: text/css\r\n"), std::string::npos);
+    EXPECT_NE(head.find("Content-Length: " + std::to_string(css.size()) + "\r\n"),
+              std::string::npos);
+    EXPECT_NE(head.find("Cache-Control: public, max-age=60\r\n"), std::string::npos);
+    EXPECT_EQ(head.find("Content-Length", head.find("Content-Length") + 1), std::string::npos);
+
+    auto asset = cache.get("css/site.css");
+    ASSERT_TRUE(asset);
+    EXPECT_EQ(cache.getHits(), 1u);
+    EXPECT_EQ(cache.getEntryCount(), 1u);
+    EXPECT_EQ(asset->etag.front(), '"');
+
+    // Validators turn into 304 with no body
+    HttpServerRequest conditional;
+    conditional.headers["if-none-match"] = "\"other\", " + asset->etag;
+    HttpServerResponse not_modified;
+    ASSERT_TRUE(cache.serve("/css/site.css", conditional, not_modified));
+    EXPECT_EQ(not_modified.status_code, 304);
+    EXPECT_EQ(not_modified.getBodySize(), 0u);
+    EXPECT_EQ(serializeHttpHead(not_modified, false).find("Content-Length"), std::string::npos);
+
+    conditional.headers.clear();
+    conditional.headers["if-modified-since"] = asset->last_modified;
+    not_modified = HttpServerResponse();
+    ASSERT_TRUE(cache.serve("/css/site.css", conditional, not_modified));
+    EXPECT_EQ(not_modified.status_code, 304);
+
+#ifdef HAVE_ZLIB
+    // Compressed once at load; chosen by Accept-Encoding
+    ASSERT_FALSE(asset->gzip.data.empty());
+    EXPECT_LT(asset->gzip.data.size(), css.size());
+    HttpServerRequest gzip_request;
+    gzip_request.headers["accept-encoding"] = "br;q=1.0, gzip";
+    HttpServerResponse gzip_response;
+    ASSERT_TRUE(cache.serve("/css/site.css", gzip_request, gzip_response));
+    EXPECT_EQ(gzip_response.static_body->data, asset->gzip.data);
+    EXPECT_NE(gzip_response.static_body->header_block.find("Content-Encoding: gzip"),
+              std::string::npos);
+    EXPECT_EQ(StaticFileCache::negotiate("gzip;q=0", *asset),
+              StaticFileCache::Encoding::Identity);
+#endif
+
+    // Binary types are not compressed
+    auto png = cache.get("logo.png");
+    ASSERT_TRUE(png);
+    EXPECT_EQ(png->mime_type, "image/png");
+    EXPECT_TRUE(png->gzip.data.empty());
+
+    // Missing, oversized and escaping paths are not served from the cache
+    EXPECT_FALSE(cache.serve("/missing.css", request, response));
+    EXPECT_FALSE(cache.get("../etc/passwd"));
+    EXPECT_FALSE(StaticFileCache::isSafePath("/css/../../secret"));
+    EXPECT_FALSE(StaticFileCache::isSafePath("/css//site.css"));
+    EXPECT_TRUE(StaticFileCache::isSafePath("/css/site.css"));
+
+    StaticFileCache::Options small;
+    small.max_file_size = 16;
+    StaticFileCache limited(dir.path.string(), small);
+    EXPECT_FALSE(limited.get("css/site.css"));
+    EXPECT_TRUE(limited.get("logo.png"));
+
+    // Past the memory budget files are still served, read from disk and not compressed
+    StaticFileCache::Options full;
+    full.max_memory = css.size() / 2;
+    StaticFileCache over_budget(dir.path.string(), full);
+    auto uncached = over_budget.get("css/site.css");
+    ASSERT_TRUE(uncached);
+    EXPECT_EQ(uncached->identity.data, css);
+    EXPECT_TRUE(uncached->gzip.data.empty());
+    EXPECT_TRUE(uncached->zstd.data.empty());
+    EXPECT_EQ(over_budget.getEntryCount(), 0u);
+    EXPECT_EQ(over_budget.getMemoryUsage(), 0u);
+}
+
+TEST_F(HttpServerLibraryTest, StaticCacheInvalidation) {
+    StaticDir dir;
+    dir.write("app.js", "console.log(1);");
+
+    StaticFileCache::Options options;
+    options.preload = true;
+    StaticFileCache cache(dir.path.string(), options);
+    cache.start();
+    EXPECT_EQ(cache.getEntryCount(), 1u);
+    ASSERT_EQ(cache.get("app.js")->identity.data, "console.log(1);");
+
+    dir.write("app.js", "console.log(22);");
+#ifdef __linux__
+    // The watcher drops (and, with preload, reloads) the entry shortly after the write
+    ASSERT_TRUE(cache.isWatching());
+    std::string current;
+    for (int attempt = 0; attempt < 200 && current != "console.log(22);"; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        current = cache.get("app.js")->identity.data;
+    }
+    EXPECT_EQ(current, "console.log(22);");
+#endif
+
+    cache.invalidate("app.js");
+    EXPECT_EQ(cache.get("app.js")->identity.data, "console.log(22);");
+    cache.stop();
+    EXPECT_FALSE(cache.isWatching());
+
+    // Registered through static() with an options map
+    createServer();
+    auto map = std::make_shared<MapInstance>();
+    map->put(Value(Text("cache")), Value(Bool(true)));
+    map->put(Value(Text("max_age")), Value(Int(3600)));
+    auto result = callServerMethod("static", {Value(server_obj), Value(Text("/assets")),
+                                              Value(Text(dir.path.string())), Value(map)});
+    EXPECT_NE(std::get<Text>(result).find("(cached)"), std::string::npos);
+
+    auto bad = std::make_shared<MapInstance>();
+    bad->put(Value(Text("cache")), Value(Text("yes")));
+    EXPECT_THROW(callServerMethod("static", {Value(server_obj), Value(Text("/x")),
+                                             Value(Text(dir.path.string())), Value(bad)}),
+                 std::runtime_error);
+}
+
 //=============================================================================
 // Server Lifecycle Tests
 //=============================================================================
@@ -638,6 +1128,1204 @@ TEST_F(HttpServerLibraryTest, HttpResponseObjectMethods) {
     EXPECT_TRUE(response.sent);
 }
 
+TEST_F(HttpServerLibraryTest, HttpRequestObjectBorrowsRequest) {
+    HttpServerRequest request;
+    request.method = "POST";
+    request.path = "/users/42";
+    request.body = "{}";
+    request.headers["content-type"] = "application/json";
+    request.path_params["id"] = "42";
+    request.query_params["verbose"] = "1";
+
+    auto request_obj = std::make_shared<HttpRequestObject>(request);
+
+    EXPECT_TRUE(request_obj->hasMethod("getHeader"));
+    EXPECT_FALSE(request_obj->hasMethod("setBody"));
+    EXPECT_EQ(std::get<Text>(request_obj->callMethod("getMethod", {}, *context)), "POST");
+    EXPECT_EQ(std::get<Text>(request_obj->callMethod("getParam", {Value(Text("id"))}, *context)),
+              "42");
+    EXPECT_EQ(std::get<Text>(request_obj->callMethod("getHeader",
+                                                     {Value(Text("content-type"))}, *context)),
+              "application/json");
+    EXPECT_EQ(std::get<Text>(request_obj->callMethod("getQueryParam", {Value(Text("missing"))},
+                                                     *context)),
+              "");
+    EXPECT_THROW(request_obj->callMethod("getHeader", {}, *context), std::runtime_error);
+
+    // Properties read the borrowed request; maps are built once and then reused
+    EXPECT_EQ(std::get<Text>(request_obj->getProperty("path")), "/users/42");
+    auto headers = std::get<std::shared_ptr<MapInstance>>(request_obj->getProperty("headers"));
+    EXPECT_EQ(headers->size(), 1u);
+    EXPECT_EQ(headers, std::get<std::shared_ptr<MapInstance>>(
+                           request_obj->callMethod("getHeaders", {}, *context)));
+
+    // After detaching the object no longer depends on the original request
+    request_obj->detach();
+    EXPECT_TRUE(request_obj->isDetached());
+    request.path = "/changed";
+    EXPECT_EQ(std::get<Text>(request_obj->callMethod("getPath", {}, *context)), "/users/42");
+}
+
+TEST_F(HttpServerLibraryTest, HttpResponseObjectWritesThrough) {
+    HttpServerResponse response;
+    auto response_obj = std::make_shared<HttpResponseObject>(response);
+
+    response_obj->callMethod("setStatus", {Value(Int(404))}, *context);
+    response_obj->callMethod("json", {Value(Text("{\"error\": true}"))}, *context);
+
+    EXPECT_EQ(response.status_code, 404);
+    EXPECT_EQ(response.status_message, "Not Found");
+    EXPECT_EQ(response.headers.at("Content-Type"), "application/json");
+    EXPECT_EQ(std::get<Int>(response_obj->getProperty("status_code")), 404);
+    EXPECT_EQ(std::get<Text>(response_obj->getProperty("body")), "{\"error\": true}");
+    EXPECT_THROW(response_obj->callMethod("setStatus", {Value(Int(99))}, *context),
+                 std::runtime_error);
+
+    // Writes after detach() never reach the (already sent) response
+    response_obj->detach();
+    response_obj->callMethod("setBody", {Value(Text("late"))}, *context);
+    EXPECT_EQ(response.body, "{\"error\": true}");
+    EXPECT_EQ(std::get<Text>(response_obj->callMethod("getBody", {}, *context)), "late");
+
+    EXPECT_STREQ(httpStatusMessage(503), "Service Unavailable");
+    EXPECT_STREQ(httpStatusMessage(299), "Unknown");
+}
+
+//=============================================================================
+// Access Log Tests
+//=============================================================================
+
+namespace {
+
+AccessLogRecord makeAccessLogRecord(const std::string& path, int status) {
+    AccessLogRecord record;
+    record.timestamp = 0;  // 1970-01-01 00:00:00 UTC
+    record.method = "GET";
+    record.path = path;
+    record.remote_address = "10.0.0.1";
+    record.user_agent = "curl/8.0";
+    record.status = status;
+    record.bytes = 42;
+    record.duration_ms = 1.5;
+    return record;
+}
+
+std::vector<std::string> readLines(const std::string& path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, AccessLogRingPushAndDrain) {
+    AccessLogRing ring(2);
+    EXPECT_TRUE(ring.tryPush(makeAccessLogRecord("/a", 200)));
+    EXPECT_TRUE(ring.tryPush(makeAccessLogRecord("/b", 200)));
+    EXPECT_FALSE(ring.tryPush(makeAccessLogRecord("/c", 200)));
+
+    std::vector<AccessLogRecord> drained;
+    EXPECT_EQ(ring.drainInto(drained), 2u);
+    ASSERT_EQ(drained.size(), 2u);
+    EXPECT_EQ(drained[0].path, "/a");
+    EXPECT_EQ(drained[1].path, "/b");
+    EXPECT_TRUE(ring.tryPush(makeAccessLogRecord("/c", 200)));
+}
+
+TEST_F(HttpServerLibraryTest, AccessLogFormats) {
+    AccessLog log;
+    auto record = makeAccessLogRecord("/users", 404);
+
+    EXPECT_EQ(log.formatRecord(record), "[Thu, 01 Jan 1970 00:00:00 GMT] GET /users 404 42 bytes");
+
+    log.setFormat("combined");
+    EXPECT_EQ(log.formatRecord(record),
+              "10.0.0.1 - - [01/Jan/1970:00:00:00 +0000] \"GET /users HTTP/1.1\" 404 42 \"-\" "
+              "\"curl/8.0\"");
+
+    log.setFormat("{method} {path} took {duration_ms}ms");
+    EXPECT_EQ(log.formatRecord(record), "GET /users took 1.500ms");
+
+    EXPECT_THROW(log.setFormat("{nope}"), std::runtime_error);
+    EXPECT_THROW(log.setSampling(0), std::runtime_error);
+}
+
+TEST_F(HttpServerLibraryTest, AccessLogWritesBatchesToFile) {
+    std::string path = ::testing::TempDir() + "o2l_access_log_test.log";
+    std::remove(path.c_str());
+
+    AccessLog log;
+    log.setFileSink(path);
+    log.setFormat("{path} {status}");
+    for (int i = 0; i < 3; ++i) {
+        log.record(makeAccessLogRecord("/item/" + std::to_string(i), 200));
+    }
+    log.flush();
+
+    auto lines = readLines(path);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "/item/0 200");
+    EXPECT_EQ(lines[2], "/item/2 200");
+
+    // With sampling only every second record from this thread is kept
+    log.setSampling(2);
+    for (int i = 0; i < 4; ++i) {
+        log.record(makeAccessLogRecord("/sampled", 200));
+    }
+    log.stop();
+    EXPECT_EQ(readLines(path).size(), 5u);
+    EXPECT_EQ(log.getWrittenCount(), 5u);
+
+    std::remove(path.c_str());
+}
+
+TEST_F(HttpServerLibraryTest, AccessLogCallbackAndDrops) {
+    AccessLog log(4);
+    std::vector<std::string> delivered;
+    log.setCallbackSink([&delivered](const std::vector<AccessLogRecord>& batch) {
+        for (const auto& record : batch) {
+            delivered.push_back(record.path);
+        }
+    });
+
+    // The ring holds four records; the rest are dropped instead of blocking the caller
+    for (int i = 0; i < 10; ++i) {
+        log.record(makeAccessLogRecord("/" + std::to_string(i), 200));
+    }
+    log.flush();
+
+    EXPECT_GE(delivered.size(), 4u);
+    EXPECT_EQ(delivered.size() + log.getDroppedCount(), 10u);
+    EXPECT_EQ(delivered.front(), "/0");
+
+    log.disable();
+    log.record(makeAccessLogRecord("/ignored", 200));
+    log.flush();
+    EXPECT_EQ(delivered.size() + log.getDroppedCount(), 10u);
+}
+
+TEST_F(HttpServerLibraryTest, AccessLogConfigurationMethods) {
+    createServer();
+
+    EXPECT_TRUE(http_server_obj->hasMethod("setAccessLog"));
+    EXPECT_TRUE(http_server_obj->hasMethod("setLogFormat"));
+    EXPECT_TRUE(http_server_obj->hasMethod("setLogSampling"));
+
+    EXPECT_NO_THROW(callServerMethod("setLogFormat", {Value(server_obj), Value(Text("common"))}));
+    EXPECT_NO_THROW(callServerMethod("setLogSampling", {Value(server_obj), Value(Int(10))}));
+    EXPECT_NO_THROW(callServerMethod("setAccessLog", {Value(server_obj), Value(Text("off"))}));
+    EXPECT_NO_THROW(callServerMethod("setAccessLog", {Value(server_obj), Value(Text("stdout"))}));
+
+    EXPECT_THROW(callServerMethod("setLogFormat", {Value(server_obj), Value(Text("{bad}"))}),
+                 std::runtime_error);
+    EXPECT_THROW(callServerMethod("setLogSampling", {Value(server_obj), Value(Int(0))}),
+                 std::runtime_error);
+    EXPECT_THROW(callServerMethod("setAccessLog",
+                                  {Value(server_obj), Value(Text("/nonexistent/dir/access.log"))}),
+                 std::runtime_error);
+
+    auto stats = std::get<std::shared_ptr<MapInstance>>(
+        callServerMethod("getStats", {Value(server_obj)}));
+    EXPECT_TRUE(stats->contains(Value(Text("access_log_written"))));
+    EXPECT_TRUE(stats->contains(Value(Text("access_log_dropped"))));
+}
+
+//=============================================================================
+// WebSocket Tests
+//=============================================================================
+
+namespace {
+
+// Client frames are always masked
+std::string maskedFrame(uint8_t first_byte, const std::string& payload) {
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    std::string frame(1, static_cast<char>(first_byte));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(0x80 | payload.size()));
+    } else {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    }
+    frame.append(reinterpret_cast<const char*>(mask), 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(static_cast<char>(payload[i] ^ mask[i % 4]));
+    }
+    return frame;
+}
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, WebSocketAcceptKey) {
+    // Example handshake from RFC 6455 section 1.3
+    EXPECT_EQ(websocket::computeAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="),
+              "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST_F(HttpServerLibraryTest, WebSocketMaskMatchesScalar) {
+    const uint8_t mask[4] = {0xA1, 0x02, 0xF3, 0x44};
+    for (size_t size : {0u, 1u, 3u, 4u, 7u, 15u, 16u, 17u, 31u, 32u, 33u, 100u, 1000u}) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>(i * 31 + 7);
+        }
+        std::string expected = data;
+        for (size_t i = 0; i < size; ++i) {
+            expected[i] = static_cast<char>(expected[i] ^ mask[i % 4]);
+        }
+        websocket::applyMask(data.data(), data.size(), mask);
+        EXPECT_EQ(data, expected) << "size " << size;
+    }
+}
+
+TEST_F(HttpServerLibraryTest, WebSocketFrameParsing) {
+    using websocket::ParseStatus;
+
+    // Masked "Hello" from RFC 6455 section 5.7
+    const unsigned char hello[] = {0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f,
+                                   0x9f, 0x4d, 0x51, 0x58};
+    websocket::Frame frame;
+    size_t consumed = 0;
+    ASSERT_EQ(websocket::parseFrame(reinterpret_cast<const char*>(hello), sizeof(hello), 1024,
+                                    frame, consumed),
+              ParseStatus::Complete);
+    EXPECT_EQ(frame.payload, "Hello");
+    EXPECT_EQ(frame.opcode, websocket::Opcode::Text);
+    EXPECT_TRUE(frame.fin);
+    EXPECT_EQ(consumed, sizeof(hello));
+
+    EXPECT_EQ(websocket::parseFrame(reinterpret_cast<const char*>(hello), 6, 1024, frame, consumed),
+              ParseStatus::Incomplete);
+
+    // Unmasked client frames and oversized control frames are protocol errors
+    std::string unmasked = websocket::encodeFrame(websocket::Opcode::Text, "hi");
+    EXPECT_EQ(websocket::parseFrame(unmasked.data(), unmasked.size(), 1024, frame, consumed),
+              ParseStatus::ProtocolError);
+    std::string big_ping = maskedFrame(0x89, std::string(126, 'x'));
+    EXPECT_EQ(websocket::parseFrame(big_ping.data(), big_ping.size(), 1024, frame, consumed),
+              ParseStatus::ProtocolError);
+
+    std::string large = maskedFrame(0x82, std::string(300, 'y'));
+    EXPECT_EQ(websocket::parseFrame(large.data(), large.size(), 256, frame, consumed),
+              ParseStatus::TooBig);
+    ASSERT_EQ(websocket::parseFrame(large.data(), large.size(), 1024, frame, consumed),
+              ParseStatus::Complete);
+    EXPECT_EQ(frame.payload, std::string(300, 'y'));
+
+    std::string encoded = websocket::encodeFrame(websocket::Opcode::Text, std::string(300, 'z'));
+    EXPECT_EQ(static_cast<unsigned char>(encoded[1]), 126);
+    EXPECT_EQ(encoded.size(), 304u);
+
+    EXPECT_TRUE(websocket::isValidUtf8("plain ascii text, long enough for the word loop"));
+    EXPECT_TRUE(websocket::isValidUtf8("caf\xc3\xa9 \xe2\x82\xac"));
+    EXPECT_FALSE(websocket::isValidUtf8("\xc0\xaf"));      // overlong
+    EXPECT_FALSE(websocket::isValidUtf8("\xed\xa0\x80"));  // surrogate
+    EXPECT_FALSE(websocket::isValidUtf8("abc\xe2\x82"));    // truncated
+}
+
+#ifdef __linux__
+TEST_F(HttpServerLibraryTest, WebSocketHubRoundTrip) {
+    auto hub = std::make_shared<ConnectionHub>();
+    ASSERT_TRUE(hub->start([](std::function<void()> task) { task(); }));
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::string> received;
+    int close_code = 0;
+
+    auto handlers = std::make_shared<WebSocketHandlers>();
+    handlers->on_open = [](const std::shared_ptr<HubConnection>& conn) {
+        conn->subscribe("news");
+    };
+    handlers->on_message = [&](const std::shared_ptr<HubConnection>& conn,
+                               const std::string& message, bool) {
+        conn->send("echo:" + message);
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(message);
+        changed.notify_all();
+    };
+    handlers->on_close = [&](const std::shared_ptr<HubConnection>&, int code) {
+        std::lock_guard<std::mutex> lock(mutex);
+        close_code = code;
+        changed.notify_all();
+    };
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int client = fds[1];
+    timeval timeout{2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    ASSERT_NE(hub->adopt(fds[0], "/ws", {}, handlers), nullptr);
+    EXPECT_EQ(hub->getConnectionCount(), 1u);
+
+    auto readFrame = [client]() {
+        unsigned char header[2];
+        if (recv(client, header, 2, MSG_WAITALL) != 2) return std::string();
+        std::string payload(header[1] & 0x7F, '\0');
+        if (!payload.empty() && recv(client, payload.data(), payload.size(), MSG_WAITALL) !=
+                                    static_cast<ssize_t>(payload.size())) {
+            return std::string();
+        }
+        return std::string(1, static_cast<char>(header[0])) + payload;
+    };
+
+    // A fragmented text message is reassembled before delivery
+    std::string fragments = maskedFrame(0x01, "Hel") + maskedFrame(0x80, "lo");
+    ASSERT_EQ(send(client, fragments.data(), fragments.size(), 0),
+              static_cast<ssize_t>(fragments.size()));
+    EXPECT_EQ(readFrame(), "\x81" + std::string("echo:Hello"));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::seconds(2), [&] { return !received.empty(); });
+        ASSERT_EQ(received.size(), 1u);
+        EXPECT_EQ(received[0], "Hello");
+    }
+
+    EXPECT_EQ(hub->publish("news", "update"), 1u);
+    EXPECT_EQ(readFrame(), "\x81" + std::string("update"));
+    EXPECT_EQ(hub->publish("other", "update"), 0u);
+
+    std::string ping = maskedFrame(0x89, "hb");
+    send(client, ping.data(), ping.size(), 0);
+    EXPECT_EQ(readFrame(), "\x8a" + std::string("hb"));
+
+    std::string close_frame = maskedFrame(0x88, std::string("\x03\xe8", 2));
+    send(client, close_frame.data(), close_frame.size(), 0);
+    EXPECT_EQ(readFrame(), "\x88" + std::string("\x03\xe8", 2));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::seconds(2), [&] { return close_code != 0; });
+        EXPECT_EQ(close_code, websocket::kCloseNormal);
+    }
+    EXPECT_EQ(hub->getConnectionCount(), 0u);
+    EXPECT_EQ(hub->publish("news", "gone"), 0u);
+
+    close(client);
+    hub->stop();
+}
+#endif
+
+TEST_F(HttpServerLibraryTest, EventStreamEncoding) {
+    EXPECT_EQ(sse::encodeEvent("", "hello"), "data: hello\n\n");
+    EXPECT_EQ(sse::encodeEvent("tick", "1"), "event: tick\ndata: 1\n\n");
+    EXPECT_EQ(sse::encodeEvent("", "a\nb\r\nc"), "data: a\ndata: b\ndata: c\n\n");
+    EXPECT_EQ(sse::encodeEvent("", ""), "data: \n\n");
+    EXPECT_EQ(sse::encodeEvent("bad\nname", "x"), "event: badname\ndata: x\n\n");
+}
+
+#ifdef __linux__
+namespace {
+
+// Everything the peer sends until it closes (or the receive timeout expires)
+std::string readUntilClosed(int fd) {
+    std::string data;
+    char buffer[1024];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        data.append(buffer, static_cast<size_t>(received));
+    }
+    return data;
+}
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, EventStreamHandOff) {
+    auto hub = std::make_shared<ConnectionHub>();
+    ASSERT_TRUE(hub->start([](std::function<void()> task) { task(); }));
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int client = fds[1];
+    timeval timeout{2, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Writes made while the handler still runs wait for the response head
+    auto stream = hub->createPending(HubConnection::Mode::EventStream);
+    ASSERT_NE(stream, nullptr);
+    auto stream_obj = createEventStreamObject(stream);
+    Context context;
+    EXPECT_TRUE(std::get<Bool>(stream_obj->callMethod(
+        "send", {Value(Text("ready")), Value(Text("1"))}, context)));
+    EXPECT_TRUE(
+        std::get<Bool>(stream_obj->callMethod("subscribe", {Value(Text("ticks"))}, context)));
+    EXPECT_EQ(hub->getConnectionCount(HubConnection::Mode::EventStream), 1u);
+
+    std::string head = "HTTP/1.1 200 OK\r\n\r\n";
+    ASSERT_TRUE(hub->attach(stream, fds[0], head));
+    std::string expected = head + "event: ready\ndata: 1\n\n";
+    std::string received(expected.size(), '\0');
+    ASSERT_EQ(recv(client, received.data(), received.size(), MSG_WAITALL),
+              static_cast<ssize_t>(expected.size()));
+    EXPECT_EQ(received, expected);
+
+    // Broadcasts reach the stream as unnamed events
+    EXPECT_EQ(hub->publish("ticks", "2"), 1u);
+    EXPECT_TRUE(std::get<Bool>(stream_obj->callMethod("close", {}, context)));
+    EXPECT_EQ(readUntilClosed(client), "data: 2\n\n");
+    EXPECT_FALSE(std::get<Bool>(stream_obj->callMethod("send", {Value(Text("late"))}, context)));
+    EXPECT_EQ(hub->getConnectionCount(), 0u);
+
+    close(client);
+    hub->stop();
+}
+
+TEST_F(HttpServerLibraryTest, DeferredResponseCompletion) {
+    auto hub = std::make_shared<ConnectionHub>();
+    ASSERT_TRUE(hub->start([](std::function<void()> task) { task(); }));
+    Context context;
+
+    HttpServerResponse base;
+    base.headers["X-Request-Id"] = "abc";
+
+    // Completed by the next broadcast on its topic
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    timeval timeout{4, 0};
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    auto pending = hub->createPending(HubConnection::Mode::Deferred);
+    auto deferred = createDeferredResponseObject(pending, base, 30);
+    deferred->callMethod("setHeader", {Value(Text("Content-Type")), Value(Text("text/plain"))},
+                         context);
+    deferred->callMethod("subscribe", {Value(Text("jobs"))}, context);
+    ASSERT_TRUE(hub->attach(pending, fds[0], {}));
+    EXPECT_EQ(hub->publish("jobs", "done"), 1u);
+
+    std::string response = readUntilClosed(fds[1]);
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("X-Request-Id: abc\r\n"), std::string::npos);
+    EXPECT_NE(response.find("Content-Type: text/plain\r\n"), std::string::npos);
+    EXPECT_NE(response.find("Content-Length: 4\r\n"), std::string::npos);
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(response.substr(response.size() - 8), "\r\n\r\ndone");
+    EXPECT_FALSE(std::get<Bool>(deferred->callMethod("send", {Value(Text("again"))}, context)));
+    close(fds[1]);
+
+    // Nothing completes it: 204 once the timeout passes
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    auto idle = hub->createPending(HubConnection::Mode::Deferred);
+    createDeferredResponseObject(idle, base, 1);
+    ASSERT_TRUE(hub->attach(idle, fds[0], {}));
+    response = readUntilClosed(fds[1]);
+    EXPECT_EQ(response.rfind("HTTP/1.1 204 No Content\r\n", 0), 0u);
+    EXPECT_NE(response.find("X-Request-Id: abc\r\n"), std::string::npos);
+    EXPECT_EQ(hub->getConnectionCount(), 0u);
+    close(fds[1]);
+
+    hub->stop();
+}
+
+TEST_F(HttpServerLibraryTest, ResponseStreamMethods) {
+    Context context;
+
+    // Outside a running server there is nothing to hand the connection to
+    HttpServerResponse detached;
+    auto detached_obj = std::make_shared<HttpResponseObject>(detached);
+    EXPECT_THROW(detached_obj->callMethod("sse", {}, context), std::runtime_error);
+    EXPECT_THROW(detached_obj->callMethod("defer", {}, context), std::runtime_error);
+
+    auto hub = std::make_shared<ConnectionHub>();
+    ASSERT_TRUE(hub->start([](std::function<void()> task) { task(); }));
+
+    HttpServerResponse response;
+    response.hub = hub.get();
+    auto response_obj = std::make_shared<HttpResponseObject>(response);
+    EXPECT_TRUE(response_obj->hasMethod("sse"));
+    EXPECT_TRUE(response_obj->hasMethod("defer"));
+
+    auto stream = response_obj->callMethod("sse", {}, context);
+    auto stream_obj = std::get<std::shared_ptr<ObjectInstance>>(stream);
+    EXPECT_EQ(stream_obj->getName(), "EventStream");
+    ASSERT_NE(response.stream, nullptr);
+    EXPECT_EQ(response.headers["Content-Type"], "text/event-stream");
+    EXPECT_EQ(response.headers["Cache-Control"], "no-cache");
+    EXPECT_THROW(response_obj->callMethod("defer", {}, context), std::runtime_error);
+
+    // Streamed heads carry no Content-Length
+    std::string head = serializeHttpResponse(response, true);
+    EXPECT_EQ(head.find("Content-Length"), std::string::npos);
+    EXPECT_NE(head.find("Content-Type: text/event-stream\r\n"), std::string::npos);
+
+    HttpServerResponse long_poll;
+    long_poll.hub = hub.get();
+    HttpResponseObject long_poll_obj(long_poll);
+    EXPECT_THROW(long_poll_obj.callMethod("defer", {Value(Int(0))}, context), std::runtime_error);
+    auto deferred = std::get<std::shared_ptr<ObjectInstance>>(
+        long_poll_obj.callMethod("defer", {Value(Int(5))}, context));
+    EXPECT_EQ(deferred->getName(), "DeferredResponse");
+    EXPECT_EQ(hub->getConnectionCount(), 2u);
+
+    hub->discard(response.stream);
+    hub->discard(long_poll.stream);
+    EXPECT_EQ(hub->getConnectionCount(), 0u);
+    hub->stop();
+}
+#endif
+
+TEST_F(HttpServerLibraryTest, HpackPrimitives) {
+    // RFC 7541 C.1: 10 and 1337 with a 5-bit prefix
+    std::string out;
+    hpack::encodeInteger(10, 5, 0, out);
+    EXPECT_EQ(out, std::string("\x0a", 1));
+    out.clear();
+    hpack::encodeInteger(1337, 5, 0, out);
+    EXPECT_EQ(out, "\x1f\x9a\x0a");
+
+    const auto* data = reinterpret_cast<const uint8_t*>(out.data());
+    uint64_t value = 0;
+    ASSERT_TRUE(hpack::decodeInteger(data, data + out.size(), 5, value));
+    EXPECT_EQ(value, 1337u);
+
+    std::string encoded;
+    hpack::huffmanEncode("www.example.com", encoded);
+    EXPECT_EQ(encoded, "\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+    std::string decoded;
+    ASSERT_TRUE(hpack::huffmanDecode(reinterpret_cast<const uint8_t*>(encoded.data()),
+                                     encoded.size(), decoded));
+    EXPECT_EQ(decoded, "www.example.com");
+
+    // Padding must be a prefix of EOS (all ones)
+    const uint8_t bad_padding[] = {0xf1, 0xe3, 0x00};
+    EXPECT_FALSE(hpack::huffmanDecode(bad_padding, sizeof(bad_padding), decoded));
+}
+
+TEST_F(HttpServerLibraryTest, HpackDecodeAndRoundTrip) {
+    // RFC 7541 C.4.1: first request, Huffman-coded
+    const uint8_t block[] = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+                             0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    hpack::Decoder decoder;
+    hpack::HeaderList fields;
+    ASSERT_TRUE(decoder.decode(block, sizeof(block), fields));
+    ASSERT_EQ(fields.size(), 4u);
+    EXPECT_EQ(fields[0].name, ":method");
+    EXPECT_EQ(fields[0].value, "GET");
+    EXPECT_EQ(fields[2].value, "/");
+    EXPECT_EQ(fields[3].name, ":authority");
+    EXPECT_EQ(fields[3].value, "www.example.com");
+    EXPECT_EQ(decoder.getTable().getSize(), 57u);
+
+    // Repeated headers shrink once they are in the dynamic table
+    hpack::Encoder encoder;
+    hpack::Decoder peer;
+    hpack::HeaderList headers = {
+        {":status", "200"}, {"content-type", "application/json"}, {"x-custom", "value"}};
+    std::string first, second;
+    encoder.encode(headers, first);
+    encoder.encode(headers, second);
+    EXPECT_LT(second.size(), first.size());
+    EXPECT_EQ(second.size(), 3u);
+
+    for (const std::string* encoded_block : {&first, &second}) {
+        hpack::HeaderList round_trip;
+        ASSERT_TRUE(peer.decode(reinterpret_cast<const uint8_t*>(encoded_block->data()),
+                                encoded_block->size(), round_trip));
+        ASSERT_EQ(round_trip.size(), headers.size());
+        for (size_t i = 0; i < headers.size(); ++i) {
+            EXPECT_EQ(round_trip[i].name, headers[i].name);
+            EXPECT_EQ(round_trip[i].value, headers[i].value);
+        }
+    }
+
+    // Index beyond both tables
+    const uint8_t out_of_range[] = {0xff, 0x00};
+    EXPECT_FALSE(peer.decode(out_of_range, sizeof(out_of_range), fields));
+    EXPECT_FALSE(peer.listSizeExceeded());
+}
+
+TEST_F(HttpServerLibraryTest, HpackDecodedListSizeLimit) {
+    // One 4 KB literal indexed into the dynamic table, then one-byte references to it: the
+    // block stays small while the decoded list grows past the advertised limit
+    std::string block;
+    block += '\x40';  // literal with incremental indexing, new name
+    block += '\x01';
+    block += 'x';
+    block += '\x7f';  // 4000-byte value: 127 + 3873 in 7-bit prefix form
+    block += '\xa1';
+    block += '\x1e';
+    block += std::string(4000, 'a');
+    const size_t entry_size = 1 + 4000 + 32;
+    const size_t limit = 64 * 1024;
+    const size_t references = limit / entry_size;  // one field more than fits
+    block.append(references, '\xbe');  // index 62: the newest dynamic entry
+
+    hpack::Decoder decoder(4096, limit);
+    hpack::HeaderList fields;
+    EXPECT_FALSE(decoder.decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                                fields));
+    EXPECT_TRUE(decoder.listSizeExceeded());
+    EXPECT_LE(fields.size() * entry_size, limit);
+
+    // One reference fewer fits
+    block.resize(block.size() - 1);
+    hpack::Decoder fitting(4096, limit);
+    fields.clear();
+    EXPECT_TRUE(fitting.decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                               fields));
+    EXPECT_EQ(fields.size(), references);
+    EXPECT_FALSE(fitting.listSizeExceeded());
+}
+
+namespace {
+
+struct Http2Frame {
+    http2::FrameType type;
+    uint8_t flags;
+    uint32_t stream_id;
+    std::string payload;
+};
+
+std::vector<Http2Frame> parseFrames(const std::string& bytes) {
+    std::vector<Http2Frame> frames;
+    size_t offset = 0;
+    while (bytes.size() - offset >= http2::kFrameHeaderSize) {
+        const auto* p = reinterpret_cast<const uint8_t*>(bytes.data() + offset);
+        size_t length = (size_t(p[0]) << 16) | (size_t(p[1]) << 8) | p[2];
+        uint32_t stream_id =
+            ((uint32_t(p[5]) << 24) | (uint32_t(p[6]) << 16) | (uint32_t(p[7]) << 8) | p[8]) &
+            0x7FFFFFFF;
+        frames.push_back({static_cast<http2::FrameType>(p[3]), p[4], stream_id,
+                          bytes.substr(offset + http2::kFrameHeaderSize, length)});
+        offset += http2::kFrameHeaderSize + length;
+    }
+    return frames;
+}
+
+// A client side for driving Http2Session directly
+struct Http2Client {
+    std::string output;
+    std::vector<std::pair<uint32_t, HttpServerRequest>> requests;
+    bool closed = false;
+    hpack::Encoder encoder;
+    std::unique_ptr<Http2Session> session;
+
+    explicit Http2Client(Http2Session::Limits limits = {}) {
+        Http2Session::Callbacks callbacks;
+        callbacks.write = [this](std::string_view bytes) {
+            output.append(bytes);
+            return true;
+        };
+        callbacks.dispatch = [this](uint32_t id, HttpServerRequest&& request) {
+            requests.emplace_back(id, std::move(request));
+        };
+        callbacks.buffered = []() -> size_t { return 0; };
+        callbacks.close = [this]() { closed = true; };
+        session = std::make_unique<Http2Session>(std::move(callbacks), limits);
+        session->start();
+    }
+
+    bool send(const std::string& bytes) {
+        return session->receive(bytes.data(), bytes.size());
+    }
+
+    std::string frame(http2::FrameType type, uint8_t flags, uint32_t stream_id,
+                      const std::string& payload) {
+        std::string out;
+        http2::appendFrameHeader(out, payload.size(), type, flags, stream_id);
+        return out + payload;
+    }
+
+    std::string headers(uint32_t stream_id, const hpack::HeaderList& fields, bool end_stream) {
+        std::string block;
+        encoder.encode(fields, block);
+        return frame(http2::FrameType::Headers,
+                     http2::kFlagEndHeaders | (end_stream ? http2::kFlagEndStream : 0),
+                     stream_id, block);
+    }
+
+    std::vector<Http2Frame> take() {
+        auto frames = parseFrames(output);
+        output.clear();
+        return frames;
+    }
+};
+
+const hpack::HeaderList kGetRoot = {
+    {":method", "GET"}, {":scheme", "http"}, {":path", "/items?page=2"}, {":authority", "h"}};
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, Http2RequestResponse) {
+    Http2Client client;
+    auto server_preface = client.take();
+    ASSERT_FALSE(server_preface.empty());
+    EXPECT_EQ(server_preface[0].type, http2::FrameType::Settings);
+
+    std::string opening(http2::kClientPreface);
+    opening += client.frame(http2::FrameType::Settings, 0, 0, "");
+    opening += client.headers(1, kGetRoot, true);
+    ASSERT_TRUE(client.send(opening));
+
+    ASSERT_EQ(client.requests.size(), 1u);
+    const HttpServerRequest& request = client.requests[0].second;
+    EXPECT_EQ(request.method, "GET");
+    EXPECT_EQ(request.path, "/items");
+    EXPECT_EQ(request.query_string, "page=2");
+    EXPECT_EQ(request.headers.at("host"), "h");
+
+    HttpServerResponse response;
+    response.headers["Content-Type"] = "text/plain";
+    response.headers["Connection"] = "keep-alive";  // not allowed in HTTP/2
+    response.body = "hello";
+    client.session->respond(1, response);
+
+    auto frames = client.take();
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0].type, http2::FrameType::Settings);  // ACK
+    EXPECT_EQ(frames[0].flags, http2::kFlagAck);
+    ASSERT_EQ(frames[1].type, http2::FrameType::Headers);
+    EXPECT_EQ(frames[2].type, http2::FrameType::Data);
+    EXPECT_EQ(frames[2].flags, http2::kFlagEndStream);
+    EXPECT_EQ(frames[2].payload, "hello");
+
+    hpack::Decoder decoder;
+    hpack::HeaderList fields;
+    ASSERT_TRUE(decoder.decode(reinterpret_cast<const uint8_t*>(frames[1].payload.data()),
+                               frames[1].payload.size(), fields));
+    std::map<std::string, std::string> received;
+    for (const auto& field : fields) {
+        received[field.name] = field.value;
+    }
+    EXPECT_EQ(received[":status"], "200");
+    EXPECT_EQ(received["content-type"], "text/plain");
+    EXPECT_EQ(received["content-length"], "5");
+    EXPECT_EQ(received.count("connection"), 0u);
+    EXPECT_EQ(client.session->getOpenStreams(), 0u);
+
+    // Request body over DATA frames; PING is echoed
+    hpack::HeaderList post = kGetRoot;
+    post[0].value = "POST";
+    std::string upload = client.headers(3, post, false);
+    upload += client.frame(http2::FrameType::Data, 0, 3, "ab");
+    upload += client.frame(http2::FrameType::Data, http2::kFlagEndStream, 3, "cd");
+    upload += client.frame(http2::FrameType::Ping, 0, 0, "12345678");
+    ASSERT_TRUE(client.send(upload));
+    ASSERT_EQ(client.requests.size(), 2u);
+    EXPECT_EQ(client.requests[1].first, 3u);
+    EXPECT_EQ(client.requests[1].second.body, "abcd");
+    frames = client.take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, http2::FrameType::Ping);
+    EXPECT_EQ(frames[0].flags, http2::kFlagAck);
+}
+
+TEST_F(HttpServerLibraryTest, Http2FlowControl) {
+    Http2Client client;
+    client.take();
+
+    // The client only accepts 4 bytes per stream until it says otherwise
+    std::string opening(http2::kClientPreface);
+    opening += client.frame(http2::FrameType::Settings, 0, 0,
+                            std::string("\x00\x04\x00\x00\x00\x04", 6));
+    opening += client.headers(1, kGetRoot, true);
+    ASSERT_TRUE(client.send(opening));
+    client.take();
+
+    HttpServerResponse response;
+    response.body = "0123456789";
+    client.session->respond(1, response);
+    auto frames = client.take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[1].type, http2::FrameType::Data);
+    EXPECT_EQ(frames[1].payload, "0123");
+    EXPECT_EQ(frames[1].flags, 0);
+    EXPECT_EQ(client.session->getOpenStreams(), 1u);
+
+    ASSERT_TRUE(client.send(client.frame(http2::FrameType::WindowUpdate, 0, 1,
+                                         std::string("\x00\x00\x00\x64", 4))));
+    frames = client.take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].payload, "456789");
+    EXPECT_EQ(frames[0].flags, http2::kFlagEndStream);
+    EXPECT_EQ(client.session->getOpenStreams(), 0u);
+}
+
+TEST_F(HttpServerLibraryTest, Http2ProtocolErrors) {
+    {
+        // Past the concurrency limit new streams are refused, not queued
+        Http2Session::Limits limits;
+        limits.max_concurrent_streams = 1;
+        Http2Client client(limits);
+        client.take();
+        std::string opening(http2::kClientPreface);
+        opening += client.headers(1, kGetRoot, true);
+        opening += client.headers(3, kGetRoot, true);
+        ASSERT_TRUE(client.send(opening));
+        EXPECT_EQ(client.requests.size(), 1u);
+        auto frames = client.take();
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0].type, http2::FrameType::RstStream);
+        EXPECT_EQ(frames[0].stream_id, 3u);
+        EXPECT_EQ(frames[0].payload, std::string("\x00\x00\x00\x07", 4));
+    }
+    {
+        // Clients may not push
+        Http2Client client;
+        client.take();
+        std::string opening(http2::kClientPreface);
+        opening += client.frame(http2::FrameType::PushPromise, http2::kFlagEndHeaders, 1,
+                                std::string("\x00\x00\x00\x02", 4));
+        EXPECT_FALSE(client.send(opening));
+        EXPECT_TRUE(client.closed);
+        auto frames = client.take();
+        ASSERT_EQ(frames.size(), 1u);
+        EXPECT_EQ(frames[0].type, http2::FrameType::GoAway);
+        EXPECT_EQ(frames[0].payload.substr(4), std::string("\x00\x00\x00\x01", 4));
+    }
+    {
+        // Garbage instead of the preface is dropped without a reply
+        Http2Client client;
+        client.take();
+        EXPECT_FALSE(client.send("GET / HTTP/1.1\r\n\r\n"));
+        EXPECT_TRUE(client.output.empty());
+    }
+}
+
+TEST_F(HttpServerLibraryTest, WebSocketRegistration) {
+    createServer();
+
+    auto handler_obj = std::make_shared<ObjectInstance>("ChatHandler");
+    handler_obj->addMethod(
+        "onMessage", [](const std::vector<Value>&, Context&) -> Value { return Value(Bool(true)); });
+
+    auto result = callServerMethod("websocket",
+                                   {Value(server_obj), Value(Text("/chat")), Value(handler_obj)});
+    EXPECT_EQ(std::get<Text>(result), "WebSocket route registered for /chat");
+
+    auto empty_obj = std::make_shared<ObjectInstance>("EmptyHandler");
+    EXPECT_THROW(callServerMethod("websocket",
+                                  {Value(server_obj), Value(Text("/x")), Value(empty_obj)}),
+                 std::runtime_error);
+
+    EXPECT_NO_THROW(callServerMethod("setWebSocketPing", {Value(server_obj), Value(Int(10))}));
+    EXPECT_THROW(callServerMethod("setWebSocketPing", {Value(server_obj), Value(Int(-1))}),
+                 std::runtime_error);
+
+    auto delivered = callServerMethod(
+        "broadcast", {Value(server_obj), Value(Text("room")), Value(Text("hello"))});
+    EXPECT_EQ(std::get<Int>(delivered), 0);
+
+    auto stats = std::get<std::shared_ptr<MapInstance>>(
+        callServerMethod("getStats", {Value(server_obj)}));
+    EXPECT_TRUE(stats->contains(Value(Text("websocket_connections"))));
+}
+
+//=============================================================================
+// Request Deadline Tests
+//=============================================================================
+
+TEST_F(HttpServerLibraryTest, DeadlineCancelsScriptExecution) {
+    CancellationToken open_ended;
+    EXPECT_FALSE(open_ended.isCancelled());
+    EXPECT_EQ(open_ended.remaining(), std::chrono::milliseconds::max());
+    open_ended.cancel();
+    EXPECT_EQ(open_ended.remaining(), std::chrono::milliseconds(0));
+    try {
+        open_ended.check();
+        FAIL() << "Expected a cancelled token to throw";
+    } catch (const ExecutionCancelledError& e) {
+        EXPECT_FALSE(e.isDeadlineExceeded());
+    }
+
+    auto token = CancellationToken::withTimeout(std::chrono::milliseconds(5000));
+    EXPECT_GT(token->remaining(), std::chrono::milliseconds(4000));
+    EXPECT_NO_THROW(token->check());
+
+    // Context copies (one per handler) share the token; every method call checks it
+    Context handler_context = *context;
+    handler_context.setCancellationToken(
+        CancellationToken::withTimeout(std::chrono::milliseconds(0)));
+    EXPECT_THROW(http_server_obj->callMethod("create", {}, handler_context),
+                 ExecutionCancelledError);
+
+    // A runaway loop stops at its back-edge or the next call, and neither method call error
+    // wrapping nor O²L try/catch can swallow the deadline
+    Lexer lexer(R"(
+        Object Counter {
+            @external method next(value: Int): Int {
+                return value + 1
+            }
+        }
+        Object Main {
+            method main(): Int {
+                count: Int = 0
+                counter: Counter = new Counter()
+                try {
+                    while (true) {
+                        count = counter.next(count)
+                    }
+                } catch (error) {
+                    return -1
+                }
+                return count
+            }
+        }
+    )");
+    Parser parser(lexer.tokenizeAll());
+    auto nodes = parser.parse();
+    Interpreter interpreter;
+    interpreter.getGlobalContext().setCancellationToken(
+        CancellationToken::withTimeout(std::chrono::milliseconds(50)));
+    auto started = std::chrono::steady_clock::now();
+    try {
+        interpreter.execute(nodes);
+        FAIL() << "Expected the loop to be cancelled";
+    } catch (const ExecutionCancelledError& e) {
+        EXPECT_TRUE(e.isDeadlineExceeded());
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+}
+
+TEST_F(HttpServerLibraryTest, RouteTimeoutOptions) {
+    createServer();
+    auto options = std::make_shared<MapInstance>();
+    options->put(Value(Text("timeout")), Value(Double(0.25)));
+    auto result = callServerMethod(
+        "get", {Value(server_obj), Value(Text("/report")), Value(Text("handler")), Value(options)});
+    EXPECT_EQ(std::get<Text>(result), "GET route registered for /report");
+
+    auto bad = std::make_shared<MapInstance>();
+    bad->put(Value(Text("timeout")), Value(Int(-1)));
+    EXPECT_THROW(callServerMethod("get", {Value(server_obj), Value(Text("/bad")),
+                                          Value(Text("handler")), Value(bad)}),
+                 std::runtime_error);
+    auto unknown = std::make_shared<MapInstance>();
+    unknown->put(Value(Text("retries")), Value(Int(1)));
+    EXPECT_THROW(callServerMethod("get", {Value(server_obj), Value(Text("/bad")),
+                                          Value(Text("handler")), Value(unknown)}),
+                 std::runtime_error);
+
+    EXPECT_NO_THROW(callServerMethod("setTimeout", {Value(server_obj), Value(Int(0))}));
+    EXPECT_THROW(callServerMethod("setTimeout", {Value(server_obj), Value(Int(-5))}),
+                 std::runtime_error);
+}
+
+#ifdef __linux__
+namespace {
+
+// Sends a bodyless GET to the local server and returns everything it answers
+std::string fetch(int port, const std::string& path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string response;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+        response = readUntilClosed(fd);
+    }
+    close(fd);
+    return response;
+}
+
+}  // namespace
+
+TEST_F(HttpServerLibraryTest, RequestDeadlineResponses) {
+    const int port = 18431;
+    HttpServer server;
+    server.setPort(port);
+    server.setWorkerThreads(1);
+
+    // Spins until its deadline, cooperatively, like an interpreted loop
+    RouteOptions spin_options;
+    spin_options.timeout = std::chrono::milliseconds(300);
+    server.get(
+        "/spin",
+        [](const HttpServerRequest& request, HttpServerResponse& response) {
+            response.headers["X-Partial"] = "yes";
+            Context handler_context;
+            handler_context.setCancellationToken(request.cancellation);
+            while (true) {
+                handler_context.checkCancellation();
+            }
+        },
+        spin_options);
+    RouteOptions quick_options;
+    quick_options.timeout = std::chrono::milliseconds(100);
+    server.get(
+        "/quick",
+        [](const HttpServerRequest&, HttpServerResponse& response) { response.body = "quick"; },
+        quick_options);
+    ASSERT_TRUE(server.listen());
+
+    // The only worker is busy spinning while /quick waits past its own deadline
+    std::string spun;
+    std::thread spinner([&]() { spun = fetch(port, "/spin"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::string queued = fetch(port, "/quick");
+    spinner.join();
+
+    EXPECT_EQ(spun.rfind("HTTP/1.1 504 Gateway Timeout\r\n", 0), 0u) << spun;
+    EXPECT_EQ(spun.find("X-Partial"), std::string::npos);
+    EXPECT_EQ(queued.rfind("HTTP/1.1 503 Service Unavailable\r\n", 0), 0u) << queued;
+    EXPECT_NE(queued.find("Retry-After: 1\r\n"), std::string::npos);
+
+    // With a free worker the same route answers normally
+    std::string fresh = fetch(port, "/quick");
+    EXPECT_EQ(fresh.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << fresh;
+    EXPECT_EQ(server.getTimeoutCount(), 2u);
+
+    server.stop();
+}
+
+TEST_F(HttpServerLibraryTest, RateLimitAndAdmissionResponses) {
+    const int port = 18432;
+    HttpServer server;
+    server.setPort(port);
+    server.setWorkerThreads(2);
+    server.setMaxConnections(1);
+
+    RouteOptions limited;
+    limited.rate_limit.rate = 0.5;
+    limited.rate_limit.burst = 2;
+    server.get(
+        "/limited",
+        [](const HttpServerRequest& request, HttpServerResponse& response) {
+            response.body = request.remote_address;
+        },
+        limited);
+    ASSERT_TRUE(server.listen());
+
+    // A burst of two, then the route is out of tokens for two seconds
+    std::string first = fetch(port, "/limited");
+    EXPECT_EQ(first.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << first;
+    EXPECT_NE(first.find("127.0.0.1"), std::string::npos);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(fetch(port, "/limited").rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::string limited_response = fetch(port, "/limited");
+    EXPECT_EQ(limited_response.rfind("HTTP/1.1 429 Too Many Requests\r\n", 0), 0u)
+        << limited_response;
+    EXPECT_NE(limited_response.find("Retry-After: 2\r\n"), std::string::npos);
+    EXPECT_EQ(server.getRateLimitedCount(), 1u);
+
+    // An idle connection holds the only slot; the next one is turned away at accept
+    auto waitForActive = [&](size_t count) {
+        for (int i = 0; i < 200 && server.getActiveConnections() != count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ASSERT_EQ(server.getActiveConnections(), count);
+    };
+    waitForActive(0);
+    int holder = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(connect(holder, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    waitForActive(1);
+    // Read without sending: a request still unread when the server closes would reset the
+    // connection and could discard the 503 before it is received
+    int turned_away = socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout{5, 0};
+    setsockopt(turned_away, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ASSERT_EQ(connect(turned_away, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    std::string rejected = readUntilClosed(turned_away);
+    close(turned_away);
+    EXPECT_EQ(rejected.rfind("HTTP/1.1 503 Service Unavailable\r\n", 0), 0u) << rejected;
+    EXPECT_NE(rejected.find("Retry-After: 1\r\n"), std::string::npos);
+    EXPECT_EQ(server.getRejectedConnections(), 1u);
+    close(holder);
+
+    server.stop();
+}
+#endif
+
+TEST_F(HttpServerLibraryTest, RateLimiterBuckets) {
+    RateLimit limit;
+    limit.rate = 2;
+    limit.burst = 3;
+    RateLimiter limiter(limit);
+    auto now = RateLimiter::Clock::now();
+
+    // A full bucket admits the burst at once, then refills one token every 500ms
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(limiter.acquire("10.0.0.1", now).allowed);
+    }
+    auto denied = limiter.acquire("10.0.0.1", now);
+    EXPECT_FALSE(denied.allowed);
+    EXPECT_EQ(denied.retry_after, 1);
+    EXPECT_TRUE(limiter.acquire("10.0.0.2", now).allowed);
+
+    EXPECT_FALSE(limiter.acquire("10.0.0.1", now + std::chrono::milliseconds(400)).allowed);
+    EXPECT_TRUE(limiter.acquire("10.0.0.1", now + std::chrono::milliseconds(500)).allowed);
+    EXPECT_FALSE(limiter.acquire("10.0.0.1", now + std::chrono::milliseconds(500)).allowed);
+    EXPECT_EQ(limiter.getKeyCount(), 2u);
+
+    EXPECT_THROW(RateLimiter(RateLimit{}), std::runtime_error);
+}
+
+TEST_F(HttpServerLibraryTest, RateLimiterFullShardsStillThrottle) {
+    RateLimit limit;
+    limit.rate = 2;
+    limit.burst = 3;
+    auto now = RateLimiter::Clock::now();
+
+    // One key per shard: once a shard holds a busy key, newcomers share one overflow bucket
+    // per shard, so rotating addresses gets at most a burst per shard beyond the tracked keys
+    RateLimiter small(limit, 64);
+    int allowed = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto decision = small.acquire("client-" + std::to_string(i), now);
+        if (decision.allowed) {
+            ++allowed;
+        } else {
+            EXPECT_GE(decision.retry_after, 1);
+        }
+    }
+    EXPECT_LE(small.getKeyCount(), 64u);
+    EXPECT_GT(allowed, 0);
+    EXPECT_LE(allowed, 64 + 64 * 3);
+
+    // Once the tracked keys have refilled they are evicted and newcomers get their own buckets
+    auto later = now + std::chrono::seconds(10);
+    EXPECT_TRUE(small.acquire("client-fresh", later).allowed);
+    EXPECT_TRUE(small.acquire("client-fresh", later).allowed);
+}
+
+TEST_F(HttpServerLibraryTest, RateLimitOptions) {
+    createServer();
+    auto options = std::make_shared<MapInstance>();
+    options->put(Value(Text("rate")), Value(Int(5)));
+    options->put(Value(Text("burst")), Value(Int(10)));
+    options->put(Value(Text("per_ip")), Value(Bool(true)));
+    auto result = callServerMethod(
+        "get", {Value(server_obj), Value(Text("/search")), Value(Text("handler")), Value(options)});
+    EXPECT_EQ(std::get<Text>(result), "GET route registered for /search");
+
+    auto orphan = std::make_shared<MapInstance>();
+    orphan->put(Value(Text("burst")), Value(Int(10)));
+    EXPECT_THROW(callServerMethod("get", {Value(server_obj), Value(Text("/bad")),
+                                          Value(Text("handler")), Value(orphan)}),
+                 std::runtime_error);
+    auto zero = std::make_shared<MapInstance>();
+    zero->put(Value(Text("rate")), Value(Int(0)));
+    EXPECT_THROW(callServerMethod("get", {Value(server_obj), Value(Text("/bad")),
+                                          Value(Text("handler")), Value(zero)}),
+                 std::runtime_error);
+
+    result = callServerMethod("setRateLimit", {Value(server_obj), Value(Int(100)), Value(Int(20))});
+    EXPECT_EQ(std::get<Text>(result),
+              "Rate limit set to 100 requests per second per client (burst 20)");
+    result = callServerMethod("setRateLimit", {Value(server_obj), Value(Int(0))});
+    EXPECT_EQ(std::get<Text>(result), "Rate limit disabled");
+    EXPECT_THROW(callServerMethod("setRateLimit", {Value(server_obj), Value(Int(-1))}),
+                 std::runtime_error);
+
+    result = callServerMethod("setMaxConnections", {Value(server_obj), Value(Int(256))});
+    EXPECT_EQ(std::get<Text>(result), "Max connections set to 256");
+    EXPECT_THROW(callServerMethod("setMaxConnections", {Value(server_obj), Value(Int(0))}),
+                 std::runtime_error);
+}
+
 //=============================================================================
 // Utility Function Tests
 //=============================================================================
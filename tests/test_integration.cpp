@@ -16,12 +16,25 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
-
+#include <unistd.h>
+
+#include "AST/BlockNode.hpp"
+#include "AST/IdentifierNode.hpp"
+#include "AST/MethodDeclarationNode.hpp"
+#include "AST/ObjectNode.hpp"
+#include "AST/ReturnNode.hpp"
+#include "AST/VariableDeclarationNode.hpp"
+#include "Common/Exceptions.hpp"
 #include "Interpreter.hpp"
 #include "Lexer.hpp"
 #include "Parser.hpp"
+#include "Runtime/BaselineJit.hpp"
+#include "Runtime/Coverage.hpp"
+#include "Runtime/HeapProfiler.hpp"
 
 using namespace o2l;
 
@@ -477,4 +490,377 @@ TEST_F(IntegrationTest, ResultErrorWithErrorInstance) {
 
     EXPECT_TRUE(result.success);
     EXPECT_EQ(result.exit_code, 1);  // Successfully processed error
-}
\ No newline at end of file
+}
+// Test that --snapshot restores the heap built by Main.setup(), shared references included
+TEST_F(IntegrationTest, HeapSnapshotRestoresSetup) {
+    const std::string code = R"(
+        Record Point {
+            x: Int
+            y: Int
+        }
+
+        Object Node {
+            constructor(name: Text) {
+                this.name = name
+                this.peer = this
+            }
+            @external method getName(): Text { this.name }
+            @external method setName(name: Text): Text { this.name = name }
+            @external method getPeer(): Node { this.peer }
+            @external method setPeer(peer: Node): Node { this.peer = peer }
+        }
+
+        Object Main {
+            method setup(): Int {
+                a: Node = new Node("a")
+                b: Node = new Node("b")
+                a.setPeer(b)
+                b.setPeer(a)
+                this.nodes = [a, b, a]
+                this.origin = {"origin": Point(x=3, y=4)}
+                return 0
+            }
+
+            method main(): Int {
+                first: Node = this.nodes.get(0)
+                if (first.getName() != "a") {
+                    return 1
+                }
+                first.setName("changed")
+                last: Node = this.nodes.get(2)
+                peer: Node = first.getPeer()
+                back: Node = peer.getPeer()
+                if (last.getName() != "changed") {
+                    return 2
+                }
+                if (back.getName() != "changed") {
+                    return 3
+                }
+                point: Point = this.origin.get("origin")
+                return point.x + point.y
+            }
+        }
+    )";
+    // Unique per process: the .jit run of this test may run at the same time
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("o2l_heap_snapshot_test_" + std::to_string(::getpid()) + ".bin"))
+                           .string();
+    std::filesystem::remove(path);
+
+    auto run = [&](const std::string& source, bool& restored) {
+        Lexer lexer(source);
+        Parser parser(lexer.tokenizeAll(), "test_code.obq");
+        auto ast_nodes = parser.parse();
+        Interpreter interpreter;
+        interpreter.setSnapshot(path, source);
+        Value result = interpreter.execute(ast_nodes);
+        restored = interpreter.wasSnapshotRestored();
+        return std::get<Int>(result);
+    };
+
+    bool restored = true;
+    EXPECT_EQ(run(code, restored), 7);
+    EXPECT_FALSE(restored);
+    ASSERT_TRUE(std::filesystem::exists(path));
+
+    // main() changed a node after the snapshot was taken; the restore starts from setup's heap
+    EXPECT_EQ(run(code, restored), 7);
+    EXPECT_TRUE(restored);
+
+    // Different code invalidates the snapshot
+    EXPECT_EQ(run(code + "\n# edited\n", restored), 7);
+    EXPECT_FALSE(restored);
+
+    std::filesystem::remove(path);
+}
+
+// Test that --typecheck reports every annotation error before anything runs
+TEST_F(IntegrationTest, TypeCheckReportsErrorsBeforeRunning) {
+    const std::string code = R"(
+        Object Calc {
+            @external method add(a: Int, b: Int): Int {
+                return a + b
+            }
+            @external method label(): Text {
+                return 42
+            }
+        }
+
+        Object Main {
+            method main(): Int {
+                broken: Int = 1 / 0
+                calc: Calc = new Calc()
+                sum: Int = calc.add(1)
+                half: Text = sum * 2
+                count: Int = 0
+                count = "many"
+                return 0
+            }
+        }
+    )";
+    Lexer lexer(code);
+    Parser parser(lexer.tokenizeAll(), "test_code.obq");
+    auto ast_nodes = parser.parse();
+    Interpreter interpreter;
+    interpreter.setTypeCheck(true);
+    try {
+        interpreter.execute(ast_nodes);
+        FAIL() << "Expected type errors";
+    } catch (const TypeMismatchError& e) {
+        std::string message = e.what();
+        EXPECT_NE(message.find("4 type errors"), std::string::npos) << message;
+        EXPECT_NE(message.find("test_code.obq:7:17: Method returns Text"), std::string::npos);
+        EXPECT_NE(message.find("'Calc.add' expects 2 arguments, got 1"), std::string::npos);
+        EXPECT_NE(message.find("'half' is declared as Text but initialized with Int"),
+                  std::string::npos);
+        EXPECT_NE(message.find("Cannot assign Text to 'count' of type Int"), std::string::npos);
+    }
+}
+
+// Test that the fast paths enabled by --typecheck compute what the generic paths do
+TEST_F(IntegrationTest, TypeCheckedFastPathsMatchGenericEvaluation) {
+    const std::string code = R"(
+        Object Main {
+            method scale(value: Double, factor: Int): Double {
+                return value * factor
+            }
+
+            method main(): Int {
+                items: List<Int> = [4, 5, 6]
+                total: Int = 0
+                i: Int = 0
+                while (i < items.size()) {
+                    element: Int = items.get(i)
+                    total = total + (element % 4)
+                    i = i + 1
+                }
+                ratio: Double = 7.0 / 2.0
+                if ((ratio > 3.0) && (ratio <= 3.5)) {
+                    total = total + 100
+                }
+                if (this.scale(1.5, 2) == 3.0) {
+                    total = total + 1000
+                }
+                try {
+                    missing: Int = items.get(3)
+                    total = -1
+                } catch (error) {
+                    total = total + 10000
+                }
+                return total - (7 / 2)
+            }
+        }
+    )";
+    for (bool type_check : {false, true}) {
+        Lexer lexer(code);
+        Parser parser(lexer.tokenizeAll(), "test_code.obq");
+        auto ast_nodes = parser.parse();
+        Interpreter interpreter;
+        interpreter.setTypeCheck(type_check);
+        Value result = interpreter.execute(ast_nodes);
+        ASSERT_TRUE(std::holds_alternative<Int>(result));
+        EXPECT_EQ(std::get<Int>(result), 11100) << "type_check=" << type_check;
+    }
+}
+
+// Reads that are a variable's last use move its value; everything else still sees the value
+TEST_F(IntegrationTest, LastUseMovesKeepEveryOtherReadIntact) {
+    const std::string code = R"(
+        Object Helpers {
+            @external method size(body: Text): Int {
+                return body.length()
+            }
+            @external method relay(body: Text): Text {
+                copy: Text = body
+                return copy
+            }
+        }
+
+        Object Main {
+            method main(): Int {
+                helpers: Helpers = new Helpers()
+                body: Text = "abcdefghij"
+                relayed: Text = helpers.relay(body)
+                total: Int = helpers.size(relayed) + body.length()
+                i: Int = 0
+                last: Text = ""
+                while (i < 3) {
+                    chunk: Text = body + i.toString()
+                    last = helpers.relay(chunk)
+                    i = i + 1
+                }
+                note: Text = "none"
+                j: Int = 0
+                while (j < 2) {
+                    if (j == 0) {
+                        note = "first"
+                    }
+                    total = total + helpers.size(note)
+                    j = j + 1
+                }
+                return total + last.length() + helpers.size(body + body)
+            }
+        }
+    )";
+    Lexer lexer(code);
+    Parser parser(lexer.tokenizeAll(), "test_code.obq");
+    auto ast_nodes = parser.parse();
+
+    // relay(): `body` in the declaration and `copy` in the return are last uses
+    auto helpers = dynamic_cast<ObjectNode*>(ast_nodes[0].get());
+    ASSERT_NE(helpers, nullptr);
+    auto relay = dynamic_cast<MethodDeclarationNode*>(helpers->getMethods()[1].get());
+    ASSERT_NE(relay, nullptr);
+    const auto& statements = dynamic_cast<BlockNode*>(relay->getBody().get())->getStatements();
+    auto declaration = dynamic_cast<VariableDeclarationNode*>(statements[0].get());
+    auto returned = dynamic_cast<ReturnNode*>(statements[1].get());
+    ASSERT_NE(declaration, nullptr);
+    ASSERT_NE(returned, nullptr);
+    EXPECT_TRUE(dynamic_cast<IdentifierNode*>(declaration->getInitializer().get())->movesValue());
+    EXPECT_TRUE(dynamic_cast<IdentifierNode*>(returned->getExpression().get())->movesValue());
+
+    Interpreter interpreter;
+    Value result = interpreter.execute(ast_nodes);
+    ASSERT_TRUE(std::holds_alternative<Int>(result));
+    // 10 + 10, then 5 + 5 from the loop over `note`, 11 for `last` and 20 for the last read
+    EXPECT_EQ(std::get<Int>(result), 61);
+}
+
+TEST_F(IntegrationTest, LineCoverageCountsExecutedStatements) {
+    const std::string code = R"(
+Object Main {
+    method main(): Int {
+        total: Int = 0
+        i: Int = 0
+        while (i < 3) {
+            total = total + i
+            i = i + 1
+        }
+        if (total > 100) {
+            total = 0
+        }
+        return total
+    }
+}
+)";
+    // Counted in the interpreter only, so keep the JIT out of this run
+    JitMode jit_mode = BaselineJit::getMode();
+    BaselineJit::setMode(JitMode::Off);
+    Coverage::enable();
+    Lexer lexer(code);
+    Parser parser(lexer.tokenizeAll(), "coverage_test.obq");
+    auto ast_nodes = parser.parse();
+    Coverage::disable();  // later tests parse without counters
+    Interpreter interpreter;
+    Value result = interpreter.execute(ast_nodes);
+    BaselineJit::setMode(jit_mode);
+    EXPECT_EQ(std::get<Int>(result), 3);
+
+    std::map<int, uint64_t> counts;
+    for (const auto& line : Coverage::lineCounts()) {
+        if (line.file == "coverage_test.obq") {
+            counts[line.line] = line.count;
+        }
+    }
+    std::map<int, uint64_t> expected = {{4, 1}, {5, 1}, {6, 1}, {7, 3},
+                                        {8, 3}, {10, 1}, {11, 0}, {13, 1}};
+    EXPECT_EQ(counts, expected);
+    auto hottest = Coverage::hottestLines(1);
+    ASSERT_EQ(hottest.size(), 1u);
+    EXPECT_GE(hottest[0].count, 3u);
+
+    std::ostringstream lcov;
+    Coverage::writeLcov(lcov);
+    EXPECT_NE(lcov.str().find("SF:coverage_test.obq\nDA:4,1\nDA:5,1\nDA:6,1\nDA:7,3\nDA:8,3\n"
+                              "DA:10,1\nDA:11,0\nDA:13,1\nLF:8\nLH:7\nend_of_record\n"),
+              std::string::npos);
+    std::ostringstream json;
+    Coverage::writeJson(json);
+    EXPECT_NE(json.str().find("\"file\": \"coverage_test.obq\",\n      \"lines_found\": 8,\n"
+                              "      \"lines_hit\": 7"),
+              std::string::npos);
+}
+
+TEST_F(IntegrationTest, HeapProfileAttributesAllocationsToSites) {
+    const std::string code = R"(
+Object Store {
+    constructor() {
+        this.kept = []
+    }
+    @external method keep(n: Int): Int {
+        i: Int = 0
+        while (i < n) {
+            this.kept.add("x")
+            i = i + 1
+        }
+        return this.kept.size()
+    }
+    @external method scratch(n: Int): Int {
+        temp: List<Int> = []
+        i: Int = 0
+        while (i < n) {
+            temp.add(i)
+            i = i + 1
+        }
+        return temp.size()
+    }
+}
+
+Object Main {
+    method main(): Int {
+        this.store = new Store()
+        this.store.keep(10)
+        return this.store.scratch(5)
+    }
+}
+)";
+    HeapProfiler::start(1);  // sample every allocation
+    Lexer lexer(code);
+    Parser parser(lexer.tokenizeAll(), "heap_profile_test.obq");
+    auto ast_nodes = parser.parse();
+    Interpreter interpreter;
+    Value result = interpreter.execute(ast_nodes);
+    HeapProfiler::stop();
+    EXPECT_EQ(std::get<Int>(result), 5);
+
+    const HeapProfiler::Site* kept = nullptr;
+    const HeapProfiler::Site* scratch = nullptr;
+    auto sites = HeapProfiler::sites();
+    for (const auto& site : sites) {
+        if (site.type != "List" || site.stack.size() != 2 ||
+            site.stack[0].file != "heap_profile_test.obq") {
+            continue;
+        }
+        if (site.stack[0].function == "Store.keep" && site.stack[0].line == 9) {
+            kept = &site;
+        } else if (site.stack[0].function == "Store.scratch" && site.stack[0].line == 18) {
+            scratch = &site;
+        }
+    }
+    // Stored values stay live while the list holding them does
+    ASSERT_NE(kept, nullptr);
+    EXPECT_EQ(kept->stack[1].function, "Main.main");
+    EXPECT_EQ(kept->stack[1].line, 28);
+    EXPECT_EQ(kept->alloc_objects, 10u);
+    EXPECT_EQ(kept->alloc_bytes, 10 * (sizeof(Value) + 1));
+    EXPECT_EQ(kept->live_objects, 10u);
+    ASSERT_NE(scratch, nullptr);
+    EXPECT_EQ(scratch->alloc_objects, 5u);
+    EXPECT_EQ(scratch->live_objects, 0u);
+    EXPECT_EQ(scratch->live_bytes, 0u);
+
+    std::string profile = HeapProfiler::encodeProfile();
+    EXPECT_NE(profile.find("inuse_space"), std::string::npos);
+    EXPECT_NE(profile.find("Store.keep"), std::string::npos);
+
+    auto census = HeapProfiler::census(interpreter.getGlobalContext());
+    auto stores = std::find_if(census.by_class.begin(), census.by_class.end(),
+                               [](const auto& entry) { return entry.class_name == "Store"; });
+    ASSERT_NE(stores, census.by_class.end());
+    EXPECT_EQ(stores->type, "Object");
+    EXPECT_EQ(stores->count, 2u);  // the class and the instance Main holds
+    auto lists = std::find_if(census.by_type.begin(), census.by_type.end(),
+                              [](const auto& entry) { return entry.type == "List"; });
+    ASSERT_NE(lists, census.by_type.end());
+    EXPECT_GE(lists->count, 1u);
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Interpreter.hpp"
+#include "../src/Lexer.hpp"
+#include "../src/Parser.hpp"
+#include "../src/Runtime/BaselineJit.hpp"
+#include "../src/Runtime/CancellationToken.hpp"
+#include "../src/Runtime/ExecutionBudget.hpp"
+
+using namespace o2l;
+
+namespace {
+
+const char* kKernels = R"(
+    Object Kernels {
+        @external method fib(n: Int): Int {
+            if (n < 2) {
+                return n
+            }
+            return this.fib(n - 1) + this.fib(n - 2)
+        }
+        @external method sumMultiples(limit: Int, skipEven: Bool): Int {
+            total: Int = 0
+            i: Int = 0
+            while (true) {
+                i = i + 1
+                if (i >= limit) {
+                    break
+                }
+                if (skipEven && ((i % 2) == 0)) {
+                    continue
+                }
+                if (((i % 3) == 0) || ((i % 5) == 0)) {
+                    total = total + i
+                }
+            }
+            return total
+        }
+        @external method mixed(a: Int, b: Int): Int {
+            q: Int = a / b
+            r: Int = a % b
+            return -q * 1000 + r
+        }
+        @external method isPositive(n: Int): Bool {
+            return !(n <= 0)
+        }
+        @external method divide(a: Int, b: Int): Int {
+            return a / b
+        }
+        @external method spin(): Int {
+            i: Int = 0
+            while (i >= 0) {
+                i = i + 1
+            }
+            return i
+        }
+        @external method describe(n: Int): Text {
+            return "n=" + n.toString()
+        }
+    }
+)";
+
+}  // namespace
+
+class JitTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        saved_mode_ = BaselineJit::getMode();
+        saved_threshold_ = BaselineJit::getThreshold();
+    }
+
+    void TearDown() override {
+        BaselineJit::setMode(saved_mode_);
+        BaselineJit::setThreshold(saved_threshold_);
+    }
+
+    // Declares kKernels in `interpreter` with the given JIT mode, compiling on the first call
+    void load(Interpreter& interpreter, JitMode mode) {
+        BaselineJit::setMode(mode);
+        BaselineJit::setThreshold(1);
+        Lexer lexer(kKernels);
+        Parser parser(lexer.tokenizeAll(), "kernels.obq");
+        nodes_.push_back(parser.parse());
+        interpreter.declare(nodes_.back());
+    }
+
+    std::vector<std::vector<ASTNodePtr>> nodes_;
+    JitMode saved_mode_ = JitMode::Off;
+    uint32_t saved_threshold_ = 1;
+};
+
+TEST_F(JitTest, CompiledMethodsMatchTheInterpreter) {
+    if (!BaselineJit::isSupported()) {
+        GTEST_SKIP() << "The baseline JIT needs x86-64 Linux";
+    }
+    Interpreter interpreted;
+    load(interpreted, JitMode::Off);
+    Interpreter compiled;
+    load(compiled, JitMode::On);
+
+    std::vector<std::pair<std::string, std::vector<Value>>> calls = {
+        {"fib", {Value(Int(20))}},
+        {"sumMultiples", {Value(Int(1000)), Value(Bool(false))}},
+        {"sumMultiples", {Value(Int(1000)), Value(Bool(true))}},
+        {"mixed", {Value(Int(-17)), Value(Int(5))}},
+        {"isPositive", {Value(Int(3))}},
+        {"isPositive", {Value(Int(-3))}},
+        {"describe", {Value(Int(4))}},
+    };
+    // Twice: the first round compiles, the second runs the native code throughout
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& [method, args] : calls) {
+            Value expected = interpreted.call("Kernels", method, args);
+            Value actual = compiled.call("Kernels", method, args);
+            EXPECT_EQ(valueToString(actual), valueToString(expected)) << method;
+            EXPECT_EQ(actual.index(), expected.index()) << method;
+        }
+    }
+    EXPECT_EQ(std::get<Int>(compiled.call("Kernels", "mixed", {Value(Int(-17)), Value(Int(5))})),
+              3000 - 2);
+
+    // Arguments that fail the type guards run interpreted
+    EXPECT_THROW(compiled.call("Kernels", "mixed", {Value(Text("a")), Value(Int(1))}),
+                 o2lException);
+}
+
+TEST_F(JitTest, DeoptimizationFallsBackToTheInterpreter) {
+    if (!BaselineJit::isSupported()) {
+        GTEST_SKIP() << "The baseline JIT needs x86-64 Linux";
+    }
+    Interpreter interpreter;
+    load(interpreter, JitMode::On);
+
+    EXPECT_EQ(std::get<Int>(interpreter.call("Kernels", "divide", {Value(Int(9)), Value(Int(2))})),
+              4);
+    // Division by zero leaves the native code and the interpreter reports it as usual
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_THROW(interpreter.call("Kernels", "divide", {Value(Int(1)), Value(Int(0))}),
+                     EvaluationError);
+    }
+    EXPECT_EQ(std::get<Int>(interpreter.call("Kernels", "divide", {Value(Int(9)), Value(Int(3))})),
+              3);
+}
+
+TEST_F(JitTest, NativeLoopsHonourCancellation) {
+    if (!BaselineJit::isSupported()) {
+        GTEST_SKIP() << "The baseline JIT needs x86-64 Linux";
+    }
+    Interpreter interpreter;
+    load(interpreter, JitMode::On);
+    interpreter.getGlobalContext().setCancellationToken(
+        CancellationToken::withTimeout(std::chrono::milliseconds(50)));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(interpreter.call("Kernels", "spin", {}), ExecutionCancelledError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST_F(JitTest, NativeLoopsChargeExecutionBudget) {
+    if (!BaselineJit::isSupported()) {
+        GTEST_SKIP() << "The baseline JIT needs x86-64 Linux";
+    }
+    Interpreter interpreter;
+    load(interpreter, JitMode::On);
+    ExecutionLimits limits;
+    limits.max_steps = 1000000;
+    auto budget = std::make_shared<ExecutionBudget>(limits);
+    interpreter.getGlobalContext().setExecutionBudget(budget);
+
+    EXPECT_THROW(interpreter.call("Kernels", "spin", {}), ExecutionBudgetExceededError);
+    EXPECT_GT(budget->usage().steps, 1000000u);
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Runtime/Context.hpp"
+#include "../src/Runtime/KvLibrary.hpp"
+#include "../src/Runtime/MapInstance.hpp"
+#include "../src/Runtime/Value.hpp"
+
+using namespace o2l;
+
+class KvLibraryTest : public ::testing::Test {
+   protected:
+    Context context;
+    std::filesystem::path directory;
+
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() /
+                    ("o2l_kv_test_" + std::to_string(getpid()) + "_" +
+                     ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::shared_ptr<ObjectInstance> open() {
+        Value store = KvLibrary::createKvObject()->callMethod(
+            "open", {Value(Text(directory.string()))}, context);
+        return std::get<std::shared_ptr<ObjectInstance>>(store);
+    }
+
+    Value call(const std::shared_ptr<ObjectInstance>& object, const std::string& method,
+               const std::vector<Value>& args = {}) {
+        return object->callMethod(method, args, context);
+    }
+
+    // Keys returned by an iterator, joined with ","
+    std::string keys(const Value& iterator) {
+        auto it = std::get<std::shared_ptr<ObjectInstance>>(iterator);
+        std::string result;
+        while (std::get<Bool>(call(it, "hasNext"))) {
+            auto entry = std::get<std::shared_ptr<MapInstance>>(call(it, "next"));
+            result += (result.empty() ? "" : ",") + std::get<Text>(entry->get(Text("key")));
+        }
+        return result;
+    }
+};
+
+TEST_F(KvLibraryTest, PutGetDeleteSurviveReopening) {
+    {
+        auto store = open();
+        call(store, "put", {Text("user:1"), Text("alice")});
+        call(store, "put", {Text("user:2"), Text("bob")});
+        call(store, "put", {Text("user:1"), Text("alice v2")});
+        EXPECT_TRUE(std::get<Bool>(call(store, "delete", {Text("user:2")})));
+        EXPECT_FALSE(std::get<Bool>(call(store, "delete", {Text("user:2")})));
+        call(store, "put", {Text("binary"), Text(std::string("a\0b", 3))});
+        EXPECT_EQ(std::get<Text>(call(store, "get", {Text("user:1")})), "alice v2");
+        EXPECT_THROW(call(store, "get", {Text("user:2")}), EvaluationError);
+        EXPECT_EQ(std::get<Text>(call(store, "get", {Text("user:2"), Text("none")})), "none");
+        call(store, "close");
+        EXPECT_THROW(call(store, "put", {Text("k"), Text("v")}), EvaluationError);
+    }
+
+    auto store = open();
+    EXPECT_EQ(std::get<Int>(call(store, "size")), 2);
+    EXPECT_EQ(std::get<Text>(call(store, "get", {Text("user:1")})), "alice v2");
+    EXPECT_EQ(std::get<Text>(call(store, "get", {Text("binary")})), std::string("a\0b", 3));
+    EXPECT_FALSE(std::get<Bool>(call(store, "has", {Text("user:2")})));
+    call(store, "close");
+}
+
+TEST_F(KvLibraryTest, BatchesAreAtomicAcrossATornLog) {
+    {
+        KvStore store(directory.string());
+        store.apply({{false, "a", "1"}});
+        store.apply({{false, "b", "2"}, {false, "c", "3"}, {true, "a", ""}});
+    }
+    auto wal = directory / "wal.kv";
+    auto intact = std::filesystem::file_size(wal);
+
+    // Cut the last batch short, as a crash in the middle of the write would
+    std::filesystem::resize_file(wal, intact - 3);
+    {
+        KvStore store(directory.string());
+        EXPECT_EQ(store.get("a").value_or(""), "1");
+        EXPECT_FALSE(store.get("b").has_value());
+        EXPECT_FALSE(store.get("c").has_value());
+        // Appends after the dropped tail are readable again
+        store.apply({{false, "d", "4"}});
+    }
+    std::ofstream(wal, std::ios::binary | std::ios::app) << "garbage";
+    KvStore store(directory.string());
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.get("d").value_or(""), "4");
+}
+
+TEST_F(KvLibraryTest, OrderedIteratorsAndSnapshots) {
+    auto store = open();
+    for (const char* key : {"b:2", "a:1", "b:1", "c:1", "b:3"}) {
+        call(store, "put", {Text(key), Text("v")});
+    }
+    EXPECT_EQ(keys(call(store, "prefix", {Text("b:")})), "b:1,b:2,b:3");
+    EXPECT_EQ(keys(call(store, "scan", {Text("a:5"), Text("b:3")})), "b:1,b:2");
+    EXPECT_EQ(keys(call(store, "scan", {Text("b:3")})), "b:3,c:1");
+
+    auto snapshot = std::get<std::shared_ptr<ObjectInstance>>(call(store, "snapshot"));
+    auto batch = std::get<std::shared_ptr<ObjectInstance>>(call(store, "batch"));
+    call(batch, "put", {Text("b:4"), Text("v")});
+    call(batch, "delete", {Text("b:1")});
+    EXPECT_EQ(std::get<Int>(call(batch, "commit")), 2);
+
+    EXPECT_EQ(keys(call(store, "prefix", {Text("b:")})), "b:2,b:3,b:4");
+    EXPECT_EQ(keys(call(snapshot, "prefix", {Text("b:")})), "b:1,b:2,b:3");
+    EXPECT_EQ(std::get<Int>(call(snapshot, "size")), 5);
+    EXPECT_TRUE(std::get<Bool>(call(snapshot, "has", {Text("b:1")})));
+    call(store, "close");
+}
+
+TEST_F(KvLibraryTest, CompactionFoldsTheLogIntoTheDataFile) {
+    {
+        KvStore store(directory.string());
+        std::string value(1024, 'x');
+        for (int i = 0; i < 10000; ++i) {
+            store.apply({{false, "key" + std::to_string(i % 100), value + std::to_string(i)}});
+        }
+        // Far more was logged than is live, so the log has been compacted along the way
+        EXPECT_LT(std::filesystem::file_size(directory / "wal.kv"), 5u << 20);
+        store.apply({{true, "key0", ""}});
+        store.compact();
+        EXPECT_EQ(std::filesystem::file_size(directory / "wal.kv"), 8u);
+    }
+    KvStore store(directory.string());
+    EXPECT_EQ(store.size(), 99u);
+    EXPECT_FALSE(store.get("key0").has_value());
+    EXPECT_EQ(store.get("key1").value_or("").substr(1024), "9901");
+}
+
+TEST_F(KvLibraryTest, OpenStoreLocksOutOtherProcesses) {
+    auto store = open();
+    ASSERT_TRUE(std::filesystem::exists(directory / "LOCK"));
+
+    // A second process cannot open the store while this one has it
+    auto childOpens = [&]() {
+        pid_t child = fork();
+        if (child == 0) {
+            try {
+                KvStore other(directory.string());
+                _exit(0);
+            } catch (const std::runtime_error& e) {
+                _exit(std::string(e.what()).find("already open") != std::string::npos ? 1 : 2);
+            }
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    };
+    EXPECT_EQ(childOpens(), 1);
+
+    call(store, "close");
+    EXPECT_EQ(childOpens(), 0);
+}
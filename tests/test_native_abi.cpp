@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Embed/Engine.hpp"
+#include "../src/Runtime/NativeAbi.h"
+#include "../src/Runtime/NativeModuleObject.hpp"
+
+using namespace o2l;
+
+namespace {
+
+int g_scale_calls = 0;
+
+o2l_native_status scale(const o2l_native_value* args, size_t, o2l_native_value* result) {
+    ++g_scale_calls;
+    result->type = O2L_NATIVE_DOUBLE;
+    result->as_double = static_cast<double>(args[0].as_int) * args[1].as_double;
+    return O2L_NATIVE_OK;
+}
+
+o2l_native_status sum(const o2l_native_value* args, size_t count, o2l_native_value* result) {
+    int64_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (args[i].type != O2L_NATIVE_INT) {
+            result->type = O2L_NATIVE_TEXT;
+            const char* message = "sum() takes Int arguments";
+            result->as_text = {message, std::strlen(message)};
+            return O2L_NATIVE_ERROR;
+        }
+        total += args[i].as_int;
+    }
+    result->type = O2L_NATIVE_INT;
+    result->as_int = total;
+    return O2L_NATIVE_OK;
+}
+
+o2l_native_status shout(const o2l_native_value* args, size_t, o2l_native_value* result) {
+    thread_local std::string buffer;
+    buffer.assign(args[0].as_text.data, args[0].as_text.size);
+    buffer += "!";
+    result->type = O2L_NATIVE_TEXT;
+    result->as_text = {buffer.data(), buffer.size()};
+    return O2L_NATIVE_OK;
+}
+
+// Deliberately unsorted: the runtime sorts the table itself
+const o2l_native_method kMethods[] = {
+    {"sum", -1, sum, 0},
+    {"scale", 2, scale, O2L_NATIVE_PURE | O2L_NATIVE_NOTHROW},
+    {"shout", 1, shout, O2L_NATIVE_PURE},
+};
+
+const o2l_native_library kStats = {O2L_NATIVE_ABI_VERSION, "stats", "1.0", kMethods, 3};
+
+const char* kProgram = R"(
+    import native.stats
+
+    Object Calc {
+        @external method folded(): Double {
+            total: Double = 0.0
+            i: Int = 0
+            while (i < 100) {
+                total = total + stats.scale(3, 0.5)
+                i = i + 1
+            }
+            return total
+        }
+        @external method scaled(n: Int): Double {
+            return stats.scale(n, 2.0)
+        }
+        @external method add(a: Int, b: Int): Int {
+            return stats.sum(a, b, 10)
+        }
+        @external method greet(): Text {
+            return stats.shout("hello")
+        }
+        @external method badSum(): Int {
+            return stats.sum(1, "two")
+        }
+        @external method badArity(): Double {
+            return stats.scale(1)
+        }
+    }
+)";
+
+}  // namespace
+
+class NativeAbiTest : public ::testing::Test {};
+
+TEST_F(NativeAbiTest, ImportsARegisteredTableAndDispatchesByName) {
+    Engine engine;
+    engine.registerNativeLibrary(kStats);
+    engine.load(kProgram);
+
+    EXPECT_EQ(std::get<Int>(engine.call("Calc", "add", {Value(Int(5)), Value(Int(7))})), 22);
+    EXPECT_EQ(std::get<Text>(engine.call("Calc", "greet")), "hello!");
+    EXPECT_DOUBLE_EQ(std::get<Double>(engine.call("Calc", "scaled", {Value(Int(4))})), 8.0);
+
+    EXPECT_THROW(engine.call("Calc", "badSum"), EvaluationError);
+    try {
+        engine.call("Calc", "badArity");
+        FAIL() << "expected an arity error";
+    } catch (const EvaluationError& e) {
+        EXPECT_NE(std::string(e.what()).find("stats.scale() expects 2 arguments, got 1"),
+                  std::string::npos);
+    }
+}
+
+TEST_F(NativeAbiTest, PureCallsWithConstantArgumentsRunOnce) {
+    Engine engine;
+    engine.registerNativeLibrary(kStats);
+    engine.load(kProgram);
+
+    g_scale_calls = 0;
+    EXPECT_DOUBLE_EQ(std::get<Double>(engine.call("Calc", "folded")), 150.0);
+    EXPECT_DOUBLE_EQ(std::get<Double>(engine.call("Calc", "folded")), 150.0);
+    EXPECT_EQ(g_scale_calls, 1);
+
+    // Variable arguments are not folded
+    engine.call("Calc", "scaled", {Value(Int(1))});
+    engine.call("Calc", "scaled", {Value(Int(1))});
+    EXPECT_EQ(g_scale_calls, 3);
+}
+
+TEST_F(NativeAbiTest, RejectsMalformedTables) {
+    const o2l_native_method duplicated[] = {{"f", 0, sum, 0}, {"f", 1, sum, 0}};
+    EXPECT_THROW(NativeModule({O2L_NATIVE_ABI_VERSION, "dup", "1", duplicated, 2}),
+                 EvaluationError);
+    EXPECT_THROW(NativeModule({O2L_NATIVE_ABI_VERSION + 1, "future", "1", kMethods, 3}),
+                 EvaluationError);
+
+    NativeModule module(kStats);
+    ASSERT_NE(module.findMethod("scale"), nullptr);
+    EXPECT_EQ(module.findMethod("missing"), nullptr);
+    EXPECT_EQ(module.getMethodNames(), (std::vector<std::string>{"scale", "shout", "sum"}));
+
+    Engine engine;
+    EXPECT_THROW(engine.load("import native.nowhere_to_be_found\nObject A {}"), EvaluationError);
+}
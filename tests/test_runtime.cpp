@@ -17,15 +17,18 @@
 #include <gtest/gtest.h>
 
 #include "AST/EnumDeclarationNode.hpp"
+#include "AST/QualifiedIdentifierNode.hpp"
 #include "Common/Exceptions.hpp"
 #include "Runtime/Context.hpp"
 #include "Runtime/EnumInstance.hpp"
 #include "Runtime/ErrorInstance.hpp"
+#include "Runtime/HeapSnapshot.hpp"
 #include "Runtime/ListInstance.hpp"
 #include "Runtime/ListIterator.hpp"
 #include "Runtime/MapInstance.hpp"
 #include "Runtime/MapIterator.hpp"
 #include "Runtime/MapObject.hpp"
+#include "Runtime/NumberConversion.hpp"
 #include "Runtime/ObjectInstance.hpp"
 #include "Runtime/RepeatIterator.hpp"
 #include "Runtime/ResultInstance.hpp"
@@ -71,14 +74,45 @@ TEST_F(RuntimeTest, BasicValueTypes) {
 TEST_F(RuntimeTest, ValueToString) {
     EXPECT_EQ(valueToString(Value(Int(42))), "42");
     EXPECT_EQ(valueToString(Value(Long(123456789012345L))), "123456789012345");
-    EXPECT_EQ(valueToString(Value(Float(3.14f))), "3.140000");   // actual format
-    EXPECT_EQ(valueToString(Value(Double(2.718))), "2.718000");  // actual format
+    EXPECT_EQ(valueToString(Value(Float(3.14f))), "3.14");  // shortest round-trip text
+    EXPECT_EQ(valueToString(Value(Double(2.718))), "2.718");
+    EXPECT_EQ(valueToString(Value(Double(0.1 + 0.2))), "0.30000000000000004");
+    EXPECT_EQ(valueToString(Value(Double(42.0))), "42.0");
     EXPECT_EQ(valueToString(Value(Text("Hello"))), "Hello");
     EXPECT_EQ(valueToString(Value(Bool(true))), "true");
     EXPECT_EQ(valueToString(Value(Bool(false))), "false");
     EXPECT_EQ(valueToString(Value(Char('A'))), "A");
 }
 
+TEST_F(RuntimeTest, NumberConversion) {
+    // Integers, eight digits at a time where the run is long enough
+    EXPECT_EQ(numeric::parseInt("1234567890123"), 1234567890123LL);
+    EXPECT_EQ(numeric::parseInt("-9223372036854775808"), std::numeric_limits<Int>::min());
+    EXPECT_EQ(numeric::parseInt("9223372036854775808"), std::nullopt);
+    EXPECT_EQ(numeric::parseInt("+17"), 17);
+    EXPECT_EQ(numeric::parseInt("12abc"), std::nullopt);
+    EXPECT_EQ(numeric::parseInt("-"), std::nullopt);
+    size_t consumed = 0;
+    EXPECT_EQ(numeric::parseIntPrefix("12345678x", &consumed), 12345678);
+    EXPECT_EQ(consumed, 8u);
+    EXPECT_EQ(numeric::formatLong(*numeric::parseLong("-170141183460469231731687303715884105728")),
+              "-170141183460469231731687303715884105728");
+    EXPECT_EQ(numeric::trim(" \t 42\n"), "42");
+
+    // Doubles read and print back exactly
+    EXPECT_EQ(numeric::parseDouble("1.5e3"), 1500.0);
+    EXPECT_EQ(numeric::parseDouble("+0.25"), 0.25);
+    EXPECT_EQ(numeric::parseDouble("1e400"), std::nullopt);
+    for (double value : {0.1, 1.0 / 3.0, 6.02214076e23, -2.5e-310, 123456.789}) {
+        EXPECT_EQ(numeric::parseDouble(numeric::formatDouble(value)), value);
+    }
+    EXPECT_EQ(numeric::formatDouble(1e21), "1e+21");
+    EXPECT_EQ(numeric::formatDouble(-0.0), "-0.0");
+    EXPECT_EQ(numeric::formatFloat(0.1f), "0.1");
+    EXPECT_EQ(numeric::formatFixed(2.0 / 3.0, 2), "0.67");
+    EXPECT_EQ(numeric::formatFixed(1e300, 1).size(), 303u);
+}
+
 // Test value equality
 TEST_F(RuntimeTest, ValueEquality) {
     EXPECT_TRUE(valuesEqual(Value(Int(42)), Value(Int(42))));
@@ -204,6 +238,72 @@ TEST_F(RuntimeTest, ContextScopes) {
     EXPECT_FALSE(context.hasVariable("inner"));
 }
 
+TEST_F(RuntimeTest, ContextBorrowedAndMovedReads) {
+    Context context;
+    context.defineVariable("outer", Value(Text("kept")));
+    context.pushScope();
+    context.defineVariable("body", Value(Text(std::string(1024, 'x'))));
+
+    // Borrowed reads see assignments made after them
+    const Value& borrowed = context.lookupVariable("body");
+    context.reassignVariable("body", Value(Text("short")));
+    EXPECT_EQ(std::get<Text>(borrowed), "short");
+    EXPECT_THROW(context.lookupVariable("missing"), UnresolvedReferenceError);
+
+    // Moves come only from the innermost scope; outer variables are copied
+    EXPECT_EQ(std::get<Text>(context.takeVariable("body")), "short");
+    EXPECT_EQ(std::get<Text>(context.takeVariable("outer")), "kept");
+    context.popScope();
+    EXPECT_EQ(std::get<Text>(context.getVariable("outer")), "kept");
+
+    // A handoff is claimed once, and only for the vector it was made for
+    std::vector<Value> args{Value(Text("argument"))};
+    std::vector<Value> other{Value(Int(1))};
+    {
+        Context::ArgumentHandoff handoff(args);
+        EXPECT_EQ(Context::ArgumentHandoff::claim(other), nullptr);
+        EXPECT_EQ(Context::ArgumentHandoff::claim(args), &args);
+        EXPECT_EQ(Context::ArgumentHandoff::claim(args), nullptr);
+    }
+    EXPECT_EQ(Context::ArgumentHandoff::claim(args), nullptr);
+}
+
+TEST_F(RuntimeTest, QualifiedNamesResolveOnceUntilRebound) {
+    Context context;
+    context.defineVariable("lib.shapes.Circle", Value(Text("circle")));
+    context.defineVariable("Square", Value(Text("square")));
+    QualifiedIdentifierNode circle({"lib", "shapes", "Circle"});
+    QualifiedIdentifierNode square({"lib", "shapes", "Square"});
+    EXPECT_EQ(circle.getFullQualifiedName(), "lib.shapes.Circle");
+
+    // Resolved to the global slot, which later reads return in place
+    Value storage;
+    const Value& linked = circle.evaluateBorrowed(context, storage);
+    EXPECT_EQ(&linked, &context.lookupVariable("lib.shapes.Circle"));
+    EXPECT_EQ(std::get<Text>(circle.evaluate(context)), "circle");
+    EXPECT_EQ(std::get<Text>(square.evaluate(context)), "square");
+
+    // Redefining or shadowing a binding is seen by the next evaluation
+    context.defineVariable("lib.shapes.Circle", Value(Text("round")));
+    EXPECT_EQ(std::get<Text>(circle.evaluate(context)), "round");
+    context.defineVariable("lib.shapes.Square", Value(Text("qualified")));
+    EXPECT_EQ(std::get<Text>(square.evaluate(context)), "qualified");
+    context.pushScope();
+    context.defineVariable("lib.shapes.Circle", Value(Text("local")));
+    EXPECT_EQ(std::get<Text>(circle.evaluate(context)), "local");
+    context.popScope();
+    EXPECT_EQ(std::get<Text>(circle.evaluate(context)), "round");
+
+    // A copied context resolves against its own slots
+    Context copy(context);
+    copy.reassignVariable("lib.shapes.Circle", Value(Text("copied")));
+    EXPECT_EQ(std::get<Text>(circle.evaluate(copy)), "copied");
+    EXPECT_EQ(std::get<Text>(circle.evaluate(context)), "round");
+
+    QualifiedIdentifierNode missing({"lib", "Missing"});
+    EXPECT_THROW(missing.evaluate(context), UnresolvedReferenceError);
+}
+
 // Test ObjectInstance
 TEST_F(RuntimeTest, ObjectInstance) {
     auto object = std::make_shared<ObjectInstance>("TestObject");
@@ -1134,4 +1234,54 @@ TEST_F(RuntimeTest, ContextVariableTypesMutability) {
     context.defineVariable("bool_var", Bool(true));
     context.reassignVariable("bool_var", Bool(false));
     EXPECT_EQ(std::get<Bool>(context.getVariable("bool_var")), false);
-}
\ No newline at end of file
+}
+TEST_F(RuntimeTest, HeapSnapshotRoundTrip) {
+    auto declare = [](Context& globals) {
+        auto main = std::make_shared<ObjectInstance>("Main");
+        globals.defineVariable("Main", Value(main));
+        globals.defineVariable("Item", Value(std::make_shared<ObjectInstance>("Item")));
+        return main;
+    };
+
+    Context before;
+    auto main = declare(before);
+    auto item = std::make_shared<ObjectInstance>("Item");
+    item->setProperty("owner", Value(main));
+    auto list = std::make_shared<ListInstance>("Item");
+    list->add(Value(item));
+    list->add(Value(item));
+    auto set = std::make_shared<SetInstance>("Text");
+    set->add(Value(Text("x")));
+    main->setProperty("items", Value(list));
+    main->setProperty("tags", Value(set));
+    main->setProperty("count", Value(Long(1) << 100));
+    std::string image = HeapSnapshot::capture(before, 42);
+
+    Context after;
+    auto restored_main = declare(after);
+    EXPECT_FALSE(HeapSnapshot::restore(image, 43, after));
+    EXPECT_FALSE(restored_main->hasProperty("items"));
+    ASSERT_TRUE(HeapSnapshot::restore(image, 42, after));
+
+    auto items = std::get<std::shared_ptr<ListInstance>>(restored_main->getProperty("items"));
+    ASSERT_EQ(items->size(), 2);
+    auto first = std::get<std::shared_ptr<ObjectInstance>>(items->get(0));
+    EXPECT_EQ(first, std::get<std::shared_ptr<ObjectInstance>>(items->get(1)));
+    EXPECT_NE(first, item);
+    EXPECT_EQ(std::get<std::shared_ptr<ObjectInstance>>(first->getProperty("owner")),
+              restored_main);
+    auto tags = std::get<std::shared_ptr<SetInstance>>(restored_main->getProperty("tags"));
+    EXPECT_EQ(tags->size(), 1);
+    EXPECT_TRUE(std::get<Long>(restored_main->getProperty("count")) == (Long(1) << 100));
+
+    // Values without a stable representation are rejected with their location
+    main->setProperty("cursor", Value(std::make_shared<ListIterator>(list)));
+    try {
+        HeapSnapshot::capture(before, 42);
+        FAIL() << "Expected std::runtime_error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("Main.cursor"), std::string::npos);
+    }
+    EXPECT_THROW(HeapSnapshot::restore(image.substr(0, image.size() - 1), 42, after),
+                 std::runtime_error);
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2024 O²L Programming Language
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include "../src/Common/Exceptions.hpp"
+#include "../src/Embed/Engine.hpp"
+#include "../src/Runtime/Context.hpp"
+#include "../src/Runtime/ListInstance.hpp"
+#include "../src/Runtime/MapInstance.hpp"
+#include "../src/Runtime/SqliteLibrary.hpp"
+#include "../src/Runtime/Value.hpp"
+
+using namespace o2l;
+
+#ifdef HAVE_SQLITE3
+
+class SqliteLibraryTest : public ::testing::Test {
+   protected:
+    Context context;
+
+    std::shared_ptr<ObjectInstance> open(const std::string& path = ":memory:",
+                                         std::vector<Value> extra = {}) {
+        std::vector<Value> args = {Value(Text(path))};
+        args.insert(args.end(), extra.begin(), extra.end());
+        Value connection = SqliteLibrary::createSqliteObject()->callMethod("open", args, context);
+        return std::get<std::shared_ptr<ObjectInstance>>(connection);
+    }
+
+    Value call(const std::shared_ptr<ObjectInstance>& object, const std::string& method,
+               const std::vector<Value>& args = {}) {
+        return object->callMethod(method, args, context);
+    }
+
+    static std::shared_ptr<ListInstance> list(const Value& value) {
+        return std::get<std::shared_ptr<ListInstance>>(value);
+    }
+
+    static Value field(const Value& row, const std::string& column) {
+        return std::get<std::shared_ptr<MapInstance>>(row)->get(Text(column));
+    }
+
+    static Int statistic(const Value& stats, const std::string& name) {
+        return std::get<Int>(std::get<std::shared_ptr<MapInstance>>(stats)->get(Text(name)));
+    }
+};
+
+TEST_F(SqliteLibraryTest, ExecuteAndQueryWithTypedValues) {
+    auto db = open();
+    call(db, "execute",
+         {Text("CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, price REAL, note TEXT);"
+               "CREATE INDEX items_name ON items (name)")});
+    EXPECT_EQ(std::get<Int>(call(db, "execute", {Text("INSERT INTO items (name, price) VALUES "
+                                                      "(?, ?)"),
+                                                 Text("lamp"), Double(12.5)})),
+              1);
+    EXPECT_EQ(std::get<Int>(call(db, "lastInsertId")), 1);
+    call(db, "execute",
+         {Text("INSERT INTO items (name, price, note) VALUES (?, ?, ?)"), Text("desk"), Int(80),
+          Text("oak")});
+
+    auto rows = list(call(db, "query", {Text("SELECT * FROM items ORDER BY id")}));
+    ASSERT_EQ(rows->size(), 2u);
+    EXPECT_EQ(std::get<Int>(field(rows->get(0), "id")), 1);
+    EXPECT_EQ(std::get<Text>(field(rows->get(0), "name")), "lamp");
+    EXPECT_DOUBLE_EQ(std::get<Double>(field(rows->get(0), "price")), 12.5);
+    // NULL columns are left out of the row
+    EXPECT_FALSE(std::get<std::shared_ptr<MapInstance>>(rows->get(0))->contains(Text("note")));
+    EXPECT_EQ(std::get<Text>(field(rows->get(1), "note")), "oak");
+
+    // Parameters can also come as one List
+    auto params = std::make_shared<ListInstance>();
+    params->add(Text("desk"));
+    rows = list(call(db, "query", {Text("SELECT id FROM items WHERE name = ?"), params}));
+    ASSERT_EQ(rows->size(), 1u);
+    EXPECT_EQ(std::get<Int>(field(rows->get(0), "id")), 2);
+
+    EXPECT_THROW(call(db, "query", {Text("SELECT * FROM missing")}), EvaluationError);
+    EXPECT_THROW(call(db, "query", {Text("SELECT ?")}), EvaluationError);
+    call(db, "close");
+    EXPECT_THROW(call(db, "query", {Text("SELECT 1")}), EvaluationError);
+}
+
+TEST_F(SqliteLibraryTest, ReusesPreparedStatementsFromTheCache) {
+    auto db = open(":memory:", {Int(2)});
+    for (int i = 0; i < 3; ++i) {
+        call(db, "query", {Text("SELECT ? AS n"), Int(i)});
+    }
+    Value stats = call(db, "cacheStats");
+    EXPECT_EQ(statistic(stats, "misses"), 1);
+    EXPECT_EQ(statistic(stats, "hits"), 2);
+    EXPECT_EQ(statistic(stats, "cached"), 1);
+
+    // The least recently used statement is finalized once the cache is full
+    call(db, "query", {Text("SELECT 1")});
+    call(db, "query", {Text("SELECT 2")});
+    call(db, "query", {Text("SELECT ? AS n"), Int(0)});
+    stats = call(db, "cacheStats");
+    EXPECT_EQ(statistic(stats, "cached"), 2);
+    EXPECT_EQ(statistic(stats, "misses"), 4);
+}
+
+TEST_F(SqliteLibraryTest, RowIteratorsAndPreparedStatements) {
+    auto db = open();
+    call(db, "execute", {Text("CREATE TABLE t (k INTEGER, v TEXT)")});
+    auto rows = std::make_shared<ListInstance>();
+    for (int i = 1; i <= 3; ++i) {
+        auto row = std::make_shared<ListInstance>();
+        row->add(Int(i));
+        row->add(Text("v" + std::to_string(i)));
+        rows->add(row);
+    }
+    EXPECT_EQ(std::get<Int>(call(db, "insertAll", {Text("INSERT INTO t VALUES (?, ?)"), rows})),
+              3);
+
+    auto iterator = std::get<std::shared_ptr<ObjectInstance>>(
+        call(db, "rows", {Text("SELECT k FROM t WHERE k >= ? ORDER BY k"), Int(2)}));
+    Int total = 0;
+    while (std::get<Bool>(call(iterator, "hasNext"))) {
+        total += std::get<Int>(field(call(iterator, "next"), "k"));
+    }
+    EXPECT_EQ(total, 5);
+    EXPECT_THROW(call(iterator, "next"), EvaluationError);
+
+    auto statement = std::get<std::shared_ptr<ObjectInstance>>(
+        call(db, "prepare", {Text("SELECT v, NULL AS absent FROM t WHERE k = :k")}));
+    call(statement, "bind", {Text(":k"), Int(3)});
+    ASSERT_TRUE(std::get<Bool>(call(statement, "step")));
+    EXPECT_EQ(std::get<Text>(call(statement, "get", {Int(0)})), "v3");
+    EXPECT_TRUE(std::get<Bool>(call(statement, "isNull", {Int(1)})));
+    EXPECT_FALSE(std::get<Bool>(call(statement, "step")));
+    EXPECT_THROW(call(statement, "row"), EvaluationError);
+    EXPECT_EQ(list(call(statement, "query", {Int(1)}))->size(), 1u);
+}
+
+TEST_F(SqliteLibraryTest, InsertAllIsAllOrNothing) {
+    auto db = open();
+    call(db, "execute", {Text("CREATE TABLE t (k INTEGER UNIQUE)")});
+    auto rows = std::make_shared<ListInstance>();
+    for (int k : {1, 2, 2}) {
+        auto row = std::make_shared<ListInstance>();
+        row->add(Int(k));
+        rows->add(row);
+    }
+    EXPECT_THROW(call(db, "insertAll", {Text("INSERT INTO t VALUES (?)"), rows}),
+                 EvaluationError);
+    auto count = list(call(db, "query", {Text("SELECT count(*) AS n FROM t")}));
+    EXPECT_EQ(std::get<Int>(field(count->get(0), "n")), 0);
+
+    // Inside an explicit transaction the rows become part of it
+    call(db, "begin");
+    rows->remove(2);
+    call(db, "insertAll", {Text("INSERT INTO t VALUES (?)"), rows});
+    call(db, "rollback");
+    count = list(call(db, "query", {Text("SELECT count(*) AS n FROM t")}));
+    EXPECT_EQ(std::get<Int>(field(count->get(0), "n")), 0);
+}
+
+TEST_F(SqliteLibraryTest, JournalModeAndImport) {
+    auto path = std::filesystem::temp_directory_path() /
+                ("o2l_sqlite_test_" + std::to_string(getpid()) + ".db");
+    {
+        auto db = open(path.string());
+        EXPECT_EQ(std::get<Text>(call(db, "setJournalMode", {Text("WAL")})), "wal");
+        EXPECT_THROW(call(db, "setJournalMode", {Text("wal; DROP TABLE x")}), EvaluationError);
+        call(db, "close");
+    }
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::filesystem::remove(path.string() + suffix);
+    }
+
+    Engine engine;
+    engine.load(R"o2l(
+        import db.sqlite
+
+        Object Store {
+            @external method count(): Int {
+                db: Value = sqlite.open(":memory:")
+                db.execute("CREATE TABLE t (n INTEGER)")
+                db.execute("INSERT INTO t VALUES (?), (?)", 4, 5)
+                rows: Value = db.query("SELECT sum(n) AS total FROM t")
+                row: Map<Text, Value> = rows.get(0)
+                return row.get("total")
+            }
+        }
+    )o2l");
+    EXPECT_EQ(std::get<Int>(engine.call("Store", "count")), 9);
+}
+
+#endif  // HAVE_SQLITE3
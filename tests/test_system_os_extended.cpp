@@ -16,11 +16,14 @@
 
 #include <gtest/gtest.h>
 
+#include <iostream>
 #include <memory>
+#include <sstream>
 
 #include "../src/Common/Exceptions.hpp"
 #include "../src/Runtime/Context.hpp"
 #include "../src/Runtime/ListInstance.hpp"
+#include "../src/Runtime/OutputBuffer.hpp"
 #include "../src/Runtime/SystemLibrary.hpp"
 #include "../src/Runtime/Value.hpp"
 
@@ -257,4 +260,104 @@ TEST_F(SystemOSExtendedTest, ErrorHandling) {
 
     Value load_average = callOSMethod("getLoadAverage");
     ASSERT_TRUE(std::holds_alternative<std::shared_ptr<ListInstance>>(load_average));
-}
\ No newline at end of file
+}
+
+class SystemIOTest : public ::testing::Test {
+   protected:
+    Context context;
+
+    // Sends std::cout to `captured` until destroyed, even when an assertion returns early
+    class CoutCapture {
+       public:
+        explicit CoutCapture(std::ostringstream& captured)
+            : original_(std::cout.rdbuf(captured.rdbuf())) {}
+        ~CoutCapture() {
+            std::cout.rdbuf(original_);
+        }
+        CoutCapture(const CoutCapture&) = delete;
+        CoutCapture& operator=(const CoutCapture&) = delete;
+
+       private:
+        std::streambuf* original_;
+    };
+
+    // Stands in for stdout and stderr writing to one terminal: stderr text lands in `log`
+    // at once, stdout text only when its stream buffer is synced
+    class SharedLog : public std::streambuf {
+       public:
+        SharedLog(std::string& log, bool buffered) : log_(log), buffered_(buffered) {}
+
+       protected:
+        std::streamsize xsputn(const char* text, std::streamsize count) override {
+            (buffered_ ? pending_ : log_).append(text, static_cast<size_t>(count));
+            return count;
+        }
+        int_type overflow(int_type c) override {
+            if (c != traits_type::eof()) {
+                char ch = traits_type::to_char_type(c);
+                xsputn(&ch, 1);
+            }
+            return traits_type::not_eof(c);
+        }
+        int sync() override {
+            log_ += pending_;
+            pending_.clear();
+            return 0;
+        }
+
+       private:
+        std::string& log_;
+        bool buffered_;
+        std::string pending_;
+    };
+};
+
+// Test buffered io.print output
+TEST_F(SystemIOTest, BufferedPrint) {
+    auto io_object = SystemLibrary::createIOObject();
+    ASSERT_TRUE(io_object->hasMethod("flush"));
+
+    std::ostringstream captured;
+    CoutCapture capture(captured);
+    OutputBuffer::flushThread();
+
+    Value printed =
+        io_object->callMethod("print", {Value(Text("%s has %d items")), Value(Text("cart")),
+                                        Value(Int(3))},
+                              context);
+    ASSERT_TRUE(std::holds_alternative<Text>(printed));
+    EXPECT_EQ(std::get<Text>(printed), "cart has 3 items");
+    if (!OutputBuffer::isTerminal()) {
+        // Held in the thread's buffer until something forces it out
+        EXPECT_EQ(captured.str(), "");
+    }
+
+    // Writing through std::cout drains pending prints first, keeping their order
+    std::cout << "after\n";
+    EXPECT_EQ(captured.str(), "cart has 3 items\nafter\n");
+
+    io_object->callMethod("print", {Value(Text("%d%% done")), Value(Int(100))}, context);
+    io_object->callMethod("flush", {}, context);
+    EXPECT_EQ(captured.str(), "cart has 3 items\nafter\n100% done\n");
+}
+
+// Test that std::cerr still flushes text written straight to std::cout
+TEST_F(SystemIOTest, StderrFlushesUnflushedStdout) {
+    OutputBuffer::local();  // ties the streams; this thread has nothing pending
+    OutputBuffer::flushThread();
+
+    std::string log;
+    SharedLog out(log, true);
+    SharedLog err(log, false);
+    std::streambuf* original_out = std::cout.rdbuf(&out);
+    std::streambuf* original_err = std::cerr.rdbuf(&err);
+
+    std::cout << "progress ";  // no endl: still in stdout's buffer
+    std::cerr << "warning\n";
+    std::cout << "done\n";
+    std::cout.flush();
+
+    std::cout.rdbuf(original_out);
+    std::cerr.rdbuf(original_err);
+    EXPECT_EQ(log, "progress warning\ndone\n");
+}